@@ -0,0 +1,193 @@
+/**
+ * @file llplugin_libtest.cpp
+ * @brief Round-trip benchmark for the plugin message pipe
+ *
+ * $LicenseInfo:firstyear=2024&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2024, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+#include "linden_common.h"
+#include "lltimer.h"
+
+#include "llplugin_libtest.h"
+
+// Linden library includes
+#include "llapr.h"
+#include "llerrorcontrol.h"
+#include "llpluginprocessparent.h"
+#include "llpluginmessageclasses.h"
+#include "threadpool.h"
+#include "workqueue.h"
+
+// system libraries
+#include <iostream>
+
+// doc string provided when invoking the program with --help
+static const char USAGE[] = "\n"
+"usage:\tllplugin_libtest [options] <launcher> <plugin>\n"
+"\n"
+" Sends echo messages through the SLPlugin <launcher> to the example media\n"
+" <plugin> one at a time and reports the round-trips per second.\n"
+"\n"
+" -h, --help\n"
+"        Print this help\n"
+" -x, --xml\n"
+"        Don't offer binary framing, so every message goes as XML LLSD like it\n"
+"        would to an older plugin host.\n"
+" -n, --count <n>\n"
+"        Number of round-trips to time (default 10000).\n"
+" -s, --size <bytes>\n"
+"        Size of the string payload carried by each message (default 64).\n"
+"\n";
+
+// Give up on the plugin if it takes longer than this to load or to answer
+static const F32 PLUGIN_TIMEOUT = 30.f;
+
+class EchoOwner : public LLPluginProcessParentOwner
+{
+public:
+    EchoOwner() : mReceived(0) {}
+
+    /*virtual*/ void receivePluginMessage(const LLPluginMessage &message)
+    {
+        if (message.getClass() == LLPLUGIN_MESSAGE_CLASS_BASE && message.getName() == "echo_response")
+        {
+            ++mReceived;
+        }
+    }
+
+    S32 mReceived;
+};
+
+// Pumps the plugin and the main loop work queue, which the launch is posted back to.
+static void pump(const LLPluginProcessParent::ptr_t &plugin)
+{
+    LL::WorkQueue::getInstance("mainloop")->runPending();
+    plugin->idle();
+}
+
+int main(int argc, char** argv)
+{
+    bool binary_framing = true;
+    S32 count = 10000;
+    S32 size = 64;
+    std::vector<std::string> files;
+
+    for (int arg = 1; arg < argc; ++arg)
+    {
+        if (!strcmp(argv[arg], "--help") || !strcmp(argv[arg], "-h"))
+        {
+            std::cout << USAGE << std::endl;
+            return 0;
+        }
+        else if (!strcmp(argv[arg], "--xml") || !strcmp(argv[arg], "-x"))
+        {
+            binary_framing = false;
+        }
+        else if ((!strcmp(argv[arg], "--count") || !strcmp(argv[arg], "-n")) && arg < argc-1)
+        {
+            count = llmax(atoi(argv[++arg]), 1);
+        }
+        else if ((!strcmp(argv[arg], "--size") || !strcmp(argv[arg], "-s")) && arg < argc-1)
+        {
+            size = llmax(atoi(argv[++arg]), 0);
+        }
+        else
+        {
+            files.push_back(argv[arg]);
+        }
+    }
+    if (files.size() != 2)
+    {
+        std::cout << USAGE << std::endl;
+        return 1;
+    }
+
+    // Init whatever is necessary
+    LLError::initForApplication(".", ".");
+    ll_init_apr();
+    LL::WorkQueue mainloop("mainloop");
+    LL::ThreadPool general("General", 1);
+    general.start();
+
+    LLPluginProcessParent::setUseBinaryFraming(binary_framing);
+
+    EchoOwner owner;
+    LLPluginProcessParent::ptr_t plugin = LLPluginProcessParent::create(&owner);
+    std::string::size_type sep = files[1].find_last_of("/\\");
+    std::string plugin_dir = (sep == std::string::npos) ? "." : files[1].substr(0, sep);
+    plugin->init(files[0], plugin_dir, files[1], false);
+
+    LLTimer timer;
+    while (!plugin->isRunning() && !plugin->isDone() && timer.getElapsedTimeF32() < PLUGIN_TIMEOUT)
+    {
+        pump(plugin);
+        ms_sleep(1);
+    }
+    if (!plugin->isRunning())
+    {
+        std::cout << "Plugin failed to load: " << files[1] << std::endl;
+        LLPluginProcessParent::shutdown();
+        return 1;
+    }
+
+    // Something shaped like the media traffic the viewer sends: a few scalars and a string
+    LLSD payload = LLSD::emptyMap();
+    payload["x"] = 640;
+    payload["y"] = 480;
+    payload["modifiers"] = "shift|control";
+    payload["time"] = 12.5;
+    payload["text"] = std::string(size, 'x');
+
+    LLPluginMessage message(LLPLUGIN_MESSAGE_CLASS_BASE, "echo");
+    message.setValueLLSD("payload", payload);
+
+    // Only one message in flight at a time, so this measures latency rather than pipe throughput
+    timer.reset();
+    S32 sent = 0;
+    while (owner.mReceived < count && !plugin->isDone() && timer.getElapsedTimeF32() < PLUGIN_TIMEOUT)
+    {
+        if (sent == owner.mReceived)
+        {
+            plugin->sendMessage(message);
+            ++sent;
+        }
+        pump(plugin);
+    }
+    F64 elapsed = timer.getElapsedTimeF64();
+
+    std::cout << (binary_framing ? "binary" : "XML") << " framing: " << owner.mReceived << " round-trips in "
+              << elapsed << " s, " << (S32)(owner.mReceived / llmax(elapsed, 0.001)) << " per second" << std::endl;
+
+    // Let the plugin say goodbye
+    LLPluginProcessParent::shutdown();
+    timer.reset();
+    while (!plugin->isDone() && timer.getElapsedTimeF32() < PLUGIN_TIMEOUT)
+    {
+        pump(plugin);
+        ms_sleep(1);
+    }
+    plugin.reset();
+
+    general.close();
+    ll_cleanup_apr();
+
+    return (owner.mReceived == count) ? 0 : 1;
+}
@@ -1352,6 +1352,33 @@ LLPolyMesh* LLAvatarAppearance::getUpperBodyMesh()
     return mMeshLOD[MESH_ID_UPPER_BODY]->mMeshParts[0]->getMesh();
 }
 
+//-----------------------------------------------------------------------------
+// LLAvatarAppearance::updateVisualParams()
+//-----------------------------------------------------------------------------
+void LLAvatarAppearance::updateVisualParams()
+{
+    openMorphBatch();
+    LLCharacter::updateVisualParams();
+    closeMorphBatch();
+}
+
+void LLAvatarAppearance::openMorphBatch()
+{
+    for (polymesh_map_t::value_type& mesh_pair : mPolyMeshes)
+    {
+        LLPolyMesh* mesh = mesh_pair.second;
+        if (!mesh->isLOD() && !mesh->getMorphBatch())
+        {
+            mMorphBatch.open(mesh);
+        }
+    }
+}
+
+void LLAvatarAppearance::closeMorphBatch()
+{
+    mMorphBatch.close();
+}
+
 
 
 // virtual
@@ -98,6 +98,7 @@ class LLAvatarAppearance : public LLCharacter
     /*virtual*/ S32             getCollisionVolumeID(std::string_view name) override;
     /*virtual*/ LLPolyMesh*     getHeadMesh() override;
     /*virtual*/ LLPolyMesh*     getUpperBodyMesh() override;
+    /*virtual*/ void            updateVisualParams() override;
 
 /**                    Inherited
  **                                                                            **
@@ -269,6 +270,11 @@ class LLAvatarAppearance : public LLCharacter
     polymesh_map_t                                  mPolyMeshes;
     avatar_joint_list_t                             mMeshLOD;
 
+    // Morph targets applied between these are deferred and applied together
+    void            openMorphBatch();
+    void            closeMorphBatch();
+    LLPolyMorphBatch                                mMorphBatch;
+
     // mesh entries and backed textures
     static LLAvatarAppearanceDefines::LLAvatarAppearanceDictionary* sAvatarDictionary;
 
@@ -757,6 +757,7 @@ LLPolyMesh::LLPolyMesh(LLPolyMeshSharedData *shared_data, LLPolyMesh *reference_
     mSharedData = shared_data;
     mReferenceMesh = reference_mesh;
     mAvatarp = NULL;
+    mMorphBatch = NULL;
     mVertexData = NULL;
 
     mCurVertexCount = 0;
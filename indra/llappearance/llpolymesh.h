@@ -64,6 +64,7 @@ class LLPolyMorphTarget;
 class LLPolyMeshSharedData
 {
     friend class LLPolyMesh;
+    friend class LLPolyMeshTester;  // builds meshes without a .llm file for the unit tests
 private:
     // transform data
     LLVector3               mPosition;
@@ -321,6 +322,10 @@ class LLPolyMesh
     void setAvatar(LLAvatarAppearance* avatarp) { mAvatarp = avatarp; }
     LLAvatarAppearance* getAvatar() { return mAvatarp; }
 
+    // Morphs applied while a batch is set are deferred to it
+    void setMorphBatch(LLPolyMorphBatch* batch) { mMorphBatch = batch; }
+    LLPolyMorphBatch* getMorphBatch() const { return mMorphBatch; }
+
     std::vector<LLJointRenderData*> mJointRenderData;
 
     U32             mFaceVertexOffset;
@@ -362,6 +367,8 @@ class LLPolyMesh
 
     // Backlink only; don't make this an LLPointer.
     LLAvatarAppearance* mAvatarp;
+
+    LLPolyMorphBatch*   mMorphBatch;
 };
 
 #endif // LL_LLPOLYMESHINTERFACE_H
@@ -36,6 +36,7 @@
 #include "llendianswizzle.h"
 #include "llpolymesh.h"
 #include "llfasttimer.h"
+#include "llparallelfor.h"
 
 //#include "../tools/imdebug/imdebug.h"
 
@@ -571,74 +572,15 @@ void LLPolyMorphTarget::apply( ESex avatar_sex )
     if (delta_weight != 0.f)
     {
         llassert(!mMesh->isLOD());
-        LLVector4a *coords = mMesh->getWritableCoords();
-
-        LLVector4a *scaled_normals = mMesh->getScaledNormals();
-        LLVector4a *normals = mMesh->getWritableNormals();
-
-        LLVector4a *scaled_binormals = mMesh->getScaledBinormals();
-        LLVector4a *binormals = mMesh->getWritableBinormals();
-
-        LLVector4a *clothing_weights = mMesh->getWritableClothingWeights();
-        LLVector2 *tex_coords = mMesh->getWritableTexCoords();
-
-        F32 *maskWeightArray = (mVertMask) ? mVertMask->getMorphMaskWeights() : NULL;
-
-        for(U32 vert_index_morph = 0; vert_index_morph < mMorphData->mNumIndices; vert_index_morph++)
+        LLPolyMorphBatch* batch = mMesh->getMorphBatch();
+        if (batch)
         {
-            S32 vert_index_mesh = mMorphData->mVertexIndices[vert_index_morph];
-
-            F32 maskWeight = 1.f;
-            if (maskWeightArray)
-            {
-                maskWeight = maskWeightArray[vert_index_morph];
-            }
-
-
-            LLVector4a pos = mMorphData->mCoords[vert_index_morph];
-            pos.mul(delta_weight*maskWeight);
-            coords[vert_index_mesh].add(pos);
-
-            if (getInfo()->mIsClothingMorph && clothing_weights)
-            {
-                LLVector4a clothing_offset = mMorphData->mCoords[vert_index_morph];
-                clothing_offset.mul(delta_weight * maskWeight);
-                LLVector4a* clothing_weight = &clothing_weights[vert_index_mesh];
-                clothing_weight->add(clothing_offset);
-                clothing_weight->getF32ptr()[VW] = maskWeight;
-            }
-
-            // calculate new normals based on half angles
-            LLVector4a norm = mMorphData->mNormals[vert_index_morph];
-            norm.mul(delta_weight*maskWeight*NORMAL_SOFTEN_FACTOR);
-            scaled_normals[vert_index_mesh].add(norm);
-            norm = scaled_normals[vert_index_mesh];
-
-            // guard against degenerate input data before we create NaNs below!
-            //
-            norm.normalize3fast();
-            normals[vert_index_mesh] = norm;
-
-            // calculate new binormals
-            LLVector4a binorm = mMorphData->mBinormals[vert_index_morph];
-
-            // guard against degenerate input data before we create NaNs below!
-            //
-            if (!binorm.isFinite3() || (binorm.dot3(binorm).getF32() <= F_APPROXIMATELY_ZERO))
-            {
-                binorm.set(1,0,0,1);
-            }
-
-            binorm.mul(delta_weight*maskWeight*NORMAL_SOFTEN_FACTOR);
-            scaled_binormals[vert_index_mesh].add(binorm);
-            LLVector4a tangent;
-            tangent.setCross3(scaled_binormals[vert_index_mesh], norm);
-            LLVector4a& normalized_binormal = binormals[vert_index_mesh];
-
-            normalized_binormal.setCross3(norm, tangent);
-            normalized_binormal.normalize3fast();
-
-            tex_coords[vert_index_mesh] += mMorphData->mTexCoords[vert_index_morph] * delta_weight * maskWeight;
+            batch->queue(mMesh, this, delta_weight);
+        }
+        else
+        {
+            accumulate(delta_weight, NULL, NULL);
+            LLPolyMorphBatch::normalize(mMesh, mMorphData->mVertexIndices, mMorphData->mNumIndices);
         }
 
         // now apply volume changes
@@ -659,6 +601,76 @@ void LLPolyMorphTarget::apply( ESex avatar_sex )
     }
 }
 
+//-----------------------------------------------------------------------------
+// accumulate()
+//-----------------------------------------------------------------------------
+void LLPolyMorphTarget::accumulate(F32 delta_weight, U8* marks, std::vector<U32>* touched)
+{
+    LLVector4a *coords = mMesh->getWritableCoords();
+    LLVector4a *scaled_normals = mMesh->getScaledNormals();
+    LLVector4a *scaled_binormals = mMesh->getScaledBinormals();
+    LLVector4a *clothing_weights = getInfo()->mIsClothingMorph ? mMesh->getWritableClothingWeights() : NULL;
+    LLVector2 *tex_coords = mMesh->getWritableTexCoords();
+
+    const U32* vertex_indices = mMorphData->mVertexIndices;
+    const LLVector4a* morph_coords = mMorphData->mCoords;
+    const LLVector4a* morph_normals = mMorphData->mNormals;
+    const LLVector4a* morph_binormals = mMorphData->mBinormals;
+    const LLVector2* morph_tex_coords = mMorphData->mTexCoords;
+
+    F32 *maskWeightArray = (mVertMask) ? mVertMask->getMorphMaskWeights() : NULL;
+
+    LLVector4a default_binormal;
+    default_binormal.set(1, 0, 0, 1);
+
+    for (U32 vert_index_morph = 0; vert_index_morph < mMorphData->mNumIndices; vert_index_morph++)
+    {
+        U32 vert_index_mesh = vertex_indices[vert_index_morph];
+
+        F32 maskWeight = maskWeightArray ? maskWeightArray[vert_index_morph] : 1.f;
+        F32 weight = delta_weight * maskWeight;
+
+        LLVector4a vertex_weight;
+        vertex_weight.splat(weight);
+        LLVector4a soft_weight;
+        soft_weight.splat(weight * NORMAL_SOFTEN_FACTOR);
+
+        LLVector4a pos;
+        pos.setMul(morph_coords[vert_index_morph], vertex_weight);
+        coords[vert_index_mesh].add(pos);
+
+        if (clothing_weights)
+        {
+            LLVector4a* clothing_weight = &clothing_weights[vert_index_mesh];
+            clothing_weight->add(pos);
+            clothing_weight->getF32ptr()[VW] = maskWeight;
+        }
+
+        LLVector4a norm;
+        norm.setMul(morph_normals[vert_index_morph], soft_weight);
+        scaled_normals[vert_index_mesh].add(norm);
+
+        // guard against degenerate input data before we create NaNs when normalizing!
+        //
+        const LLVector4a* binorm = &morph_binormals[vert_index_morph];
+        if (!binorm->isFinite3() || (binorm->dot3(*binorm).getF32() <= F_APPROXIMATELY_ZERO))
+        {
+            binorm = &default_binormal;
+        }
+        LLVector4a scaled_binorm;
+        scaled_binorm.setMul(*binorm, soft_weight);
+        scaled_binormals[vert_index_mesh].add(scaled_binorm);
+
+        tex_coords[vert_index_mesh] += morph_tex_coords[vert_index_morph] * weight;
+
+        if (marks && !marks[vert_index_mesh])
+        {
+            marks[vert_index_mesh] = 1;
+            touched->push_back(vert_index_mesh);
+        }
+    }
+}
+
 //-----------------------------------------------------------------------------
 // applyMask()
 //-----------------------------------------------------------------------------
@@ -845,3 +857,142 @@ F32* LLPolyVertexMask::getMorphMaskWeights()
 
     return mWeights;
 }
+
+//-----------------------------------------------------------------------------
+// LLPolyMorphBatch()
+//-----------------------------------------------------------------------------
+LLPolyMorphBatch::LLPolyMorphBatch()
+    : mOpenCount(0)
+{
+}
+
+LLPolyMorphBatch::~LLPolyMorphBatch()
+{
+    close();
+}
+
+void LLPolyMorphBatch::open(LLPolyMesh* mesh)
+{
+    llassert(!mesh->isLOD() && !mesh->getMorphBatch());
+    if (mOpenCount == mMeshes.size())
+    {
+        mMeshes.emplace_back();
+    }
+    MeshMorphs& mesh_morphs = mMeshes[mOpenCount++];
+    mesh_morphs.mMesh = mesh;
+    mesh_morphs.mMorphs.clear();
+    mesh->setMorphBatch(this);
+}
+
+void LLPolyMorphBatch::queue(LLPolyMesh* mesh, LLPolyMorphTarget* morph, F32 delta_weight)
+{
+    for (U32 i = 0; i < mOpenCount; ++i)
+    {
+        if (mMeshes[i].mMesh == mesh)
+        {
+            mMeshes[i].mMorphs.emplace_back(morph, delta_weight);
+            return;
+        }
+    }
+    llassert(false);
+}
+
+void LLPolyMorphBatch::close()
+{
+    if (!mOpenCount)
+    {
+        return;
+    }
+
+    LL_PROFILE_ZONE_SCOPED;
+
+    U32 total_indices = 0;
+    for (U32 i = 0; i < mOpenCount; ++i)
+    {
+        mMeshes[i].mMesh->setMorphBatch(NULL);
+        for (const auto& morph : mMeshes[i].mMorphs)
+        {
+            total_indices += morph.first->mMorphData->mNumIndices;
+        }
+    }
+
+    // a single morph or two is not worth handing off
+    const U32 MIN_PARALLEL_INDICES = 4096;
+    if (total_indices >= MIN_PARALLEL_INDICES && mOpenCount > 1)
+    {
+        LL::parallel_for(mOpenCount, 1, [this](size_t begin, size_t end)
+            {
+                for (size_t i = begin; i < end; ++i)
+                {
+                    applyMorphs(mMeshes[i]);
+                }
+            });
+    }
+    else
+    {
+        for (U32 i = 0; i < mOpenCount; ++i)
+        {
+            applyMorphs(mMeshes[i]);
+        }
+    }
+    mOpenCount = 0;
+}
+
+//static
+void LLPolyMorphBatch::applyMorphs(MeshMorphs& mesh_morphs)
+{
+    if (mesh_morphs.mMorphs.empty())
+    {
+        return;
+    }
+
+    LL_PROFILE_ZONE_SCOPED;
+
+    LLPolyMesh* mesh = mesh_morphs.mMesh;
+    if (mesh_morphs.mMarks.size() < mesh->getNumVertices())
+    {
+        mesh_morphs.mMarks.resize(mesh->getNumVertices(), 0);
+    }
+
+    // the morphs go in the order they were applied, the clothing weight of a
+    // vertex keeps the mask weight of the last one
+    for (const auto& morph : mesh_morphs.mMorphs)
+    {
+        morph.first->accumulate(morph.second, mesh_morphs.mMarks.data(), &mesh_morphs.mTouched);
+    }
+    mesh_morphs.mMorphs.clear();
+
+    normalize(mesh, mesh_morphs.mTouched.data(), (U32)mesh_morphs.mTouched.size());
+
+    for (U32 vert_index_mesh : mesh_morphs.mTouched)
+    {
+        mesh_morphs.mMarks[vert_index_mesh] = 0;
+    }
+    mesh_morphs.mTouched.clear();
+}
+
+//static
+void LLPolyMorphBatch::normalize(LLPolyMesh* mesh, const U32* indices, U32 count)
+{
+    LLVector4a *scaled_normals = mesh->getScaledNormals();
+    LLVector4a *normals = mesh->getWritableNormals();
+    LLVector4a *scaled_binormals = mesh->getScaledBinormals();
+    LLVector4a *binormals = mesh->getWritableBinormals();
+
+    for (U32 i = 0; i < count; ++i)
+    {
+        U32 vert_index_mesh = indices[i];
+
+        // calculate new normals based on half angles
+        LLVector4a norm = scaled_normals[vert_index_mesh];
+        norm.normalize3fast();
+        normals[vert_index_mesh] = norm;
+
+        // calculate new binormals
+        LLVector4a tangent;
+        tangent.setCross3(scaled_binormals[vert_index_mesh], norm);
+        LLVector4a& normalized_binormal = binormals[vert_index_mesh];
+        normalized_binormal.setCross3(norm, tangent);
+        normalized_binormal.normalize3fast();
+    }
+}
@@ -147,6 +147,7 @@ class LLPolyMorphTargetInfo : public LLViewerVisualParamInfo
 class alignas(16) LLPolyMorphTarget : public LLViewerVisualParam
 {
     LL_ALIGN_NEW
+    friend class LLPolyMorphBatch;
 public:
     LLPolyMorphTarget(LLPolyMesh *poly_mesh);
     ~LLPolyMorphTarget();
@@ -175,6 +176,11 @@ class alignas(16) LLPolyMorphTarget : public LLViewerVisualParam
 
     void    applyVolumeChanges(F32 delta_weight); // SL-315 - for resetSkeleton()
 
+    // Adds delta_weight of this morph to the scaled vertex data of its mesh
+    // without renormalizing.  Mesh vertices seen for the first time are
+    // flagged in marks and appended to touched, if given.
+    void    accumulate(F32 delta_weight, U8* marks, std::vector<U32>* touched);
+
 protected:
     LLPolyMorphTarget(const LLPolyMorphTarget& pOther);
 
@@ -190,4 +196,42 @@ class alignas(16) LLPolyMorphTarget : public LLViewerVisualParam
 
 };
 
+//-----------------------------------------------------------------------------
+// LLPolyMorphBatch
+// Defers the morph targets applied to its open meshes until close(), then
+// accumulates all of them into each mesh and recomputes the normals and
+// binormals of the touched vertices once, instead of once per morph.
+// Meshes are independent, so they are processed in parallel.
+//-----------------------------------------------------------------------------
+class LLPolyMorphBatch
+{
+public:
+    LLPolyMorphBatch();
+    ~LLPolyMorphBatch();
+
+    // Queues the morphs applied to mesh until close()
+    void open(LLPolyMesh* mesh);
+    void close();
+    bool isOpen() const { return mOpenCount > 0; }
+
+    void queue(LLPolyMesh* mesh, LLPolyMorphTarget* morph, F32 delta_weight);
+
+    // Derives normals and binormals from the scaled ones for the given vertices
+    static void normalize(LLPolyMesh* mesh, const U32* indices, U32 count);
+
+private:
+    struct MeshMorphs
+    {
+        LLPolyMesh* mMesh;
+        std::vector<std::pair<LLPolyMorphTarget*, F32> > mMorphs;
+        std::vector<U8> mMarks;
+        std::vector<U32> mTouched;
+    };
+
+    static void applyMorphs(MeshMorphs& mesh_morphs);
+
+    std::vector<MeshMorphs> mMeshes;
+    U32 mOpenCount;
+};
+
 #endif // LL_LLPOLYMORPH_H
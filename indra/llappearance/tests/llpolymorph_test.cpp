@@ -0,0 +1,325 @@
+/**
+ * @file llpolymorph_test.cpp
+ * @brief Compares morphs applied through LLPolyMorphBatch with morphs applied one at a time
+ *
+ * $LicenseInfo:firstyear=2024&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2024, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#include "linden_common.h"
+
+#include "../llpolymesh.h"
+#include "../llpolymorph.h"
+#include "llformat.h"
+#include "llrand.h"
+
+#include <memory>
+
+#include "../test/lltut.h"
+
+namespace
+{
+    const U32 VERTEX_COUNT = 3000;
+    const U32 MORPH_COUNT = 40;
+    const F32 TOLERANCE = 1e-5f;
+
+    F32 random_range(F32 low, F32 high)
+    {
+        return low + ll_frand(high - low);
+    }
+
+    // Clothing morphs also move the clothing weights, so all of them are
+    // compared
+    class TestMorphInfo : public LLPolyMorphTargetInfo
+    {
+    public:
+        TestMorphInfo()
+        {
+            mSex = SEX_BOTH;
+            mMinWeight = -1.f;
+            mMaxWeight = 1.f;
+            mDefaultWeight = 0.f;
+            mIsClothingMorph = TRUE;
+        }
+    };
+
+    class TestMorph : public LLPolyMorphTarget
+    {
+    public:
+        TestMorph(LLPolyMesh* mesh, LLPolyMorphTargetInfo* info, LLPolyMorphData* data)
+            : LLPolyMorphTarget(mesh)
+        {
+            mInfo = info;
+            mMorphData = data;
+            mCurWeight = 0.f;
+            mLastWeight = 0.f;
+        }
+    };
+
+    LLPolyMorphData* random_morph_data(U32 num_vertices)
+    {
+        LLPolyMorphData* data = new LLPolyMorphData("test");
+        const U32 num_indices = 200 + ll_rand(num_vertices / 2);
+        data->mNumIndices = num_indices;
+        data->mVertexIndices = new U32[num_indices];
+        data->mCoords = (LLVector4a*)ll_aligned_malloc_16(num_indices * sizeof(LLVector4a));
+        data->mNormals = (LLVector4a*)ll_aligned_malloc_16(num_indices * sizeof(LLVector4a));
+        data->mBinormals = (LLVector4a*)ll_aligned_malloc_16(num_indices * sizeof(LLVector4a));
+        data->mTexCoords = new LLVector2[num_indices];
+        for (U32 i = 0; i < num_indices; ++i)
+        {
+            // vertices repeat within a morph and across morphs
+            data->mVertexIndices[i] = ll_rand(num_vertices);
+            data->mCoords[i].set(random_range(-1.f, 1.f), random_range(-1.f, 1.f), random_range(-1.f, 1.f), 0.f);
+            data->mNormals[i].set(random_range(-1.f, 1.f), random_range(-1.f, 1.f), random_range(-1.f, 1.f), 0.f);
+            if (i % 17 == 0)
+            {
+                // the batch skips binormals a morph doesn't move
+                data->mBinormals[i].clear();
+            }
+            else
+            {
+                data->mBinormals[i].set(random_range(-1.f, 1.f), random_range(-1.f, 1.f), random_range(-1.f, 1.f), 0.f);
+            }
+            data->mTexCoords[i].set(random_range(-1.f, 1.f), random_range(-1.f, 1.f));
+        }
+        return data;
+    }
+
+    bool close_enough(const LLVector4a& a, const LLVector4a& b, S32 components)
+    {
+        for (S32 k = 0; k < components; ++k)
+        {
+            if (fabsf(a[k] - b[k]) > TOLERANCE * (1.f + fabsf(a[k])))
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+}
+
+// A mesh with random base vertices and morphs, built in memory
+class LLPolyMeshTester
+{
+public:
+    LLPolyMeshTester(U32 num_vertices, U32 num_morphs, LLPolyMorphTargetInfo* info)
+    {
+        mSharedData.allocateVertexData(num_vertices);
+        for (U32 v = 0; v < num_vertices; ++v)
+        {
+            mSharedData.mBaseCoords[v].set(random_range(-1.f, 1.f), random_range(-1.f, 1.f), random_range(-1.f, 1.f), 1.f);
+            mSharedData.mBaseNormals[v].set(random_range(-1.f, 1.f), random_range(-1.f, 1.f), random_range(-1.f, 1.f), 0.f);
+            mSharedData.mBaseNormals[v].normalize3fast();
+            mSharedData.mBaseBinormals[v].set(random_range(-1.f, 1.f), random_range(-1.f, 1.f), random_range(-1.f, 1.f), 0.f);
+            mSharedData.mTexCoords[v].set(random_range(-1.f, 1.f), random_range(-1.f, 1.f));
+        }
+        mMesh = new LLPolyMesh(&mSharedData, NULL);
+        for (U32 m = 0; m < num_morphs; ++m)
+        {
+            mMorphData.push_back(random_morph_data(num_vertices));
+            mMorphs.push_back(new TestMorph(mMesh, info, mMorphData.back()));
+        }
+    }
+
+    // Same base vertices and morphs as other
+    LLPolyMeshTester(const LLPolyMeshTester& other, LLPolyMorphTargetInfo* info)
+    {
+        const U32 num_vertices = other.mSharedData.mNumVertices;
+        mSharedData.allocateVertexData(num_vertices);
+        for (U32 v = 0; v < num_vertices; ++v)
+        {
+            mSharedData.mBaseCoords[v] = other.mSharedData.mBaseCoords[v];
+            mSharedData.mBaseNormals[v] = other.mSharedData.mBaseNormals[v];
+            mSharedData.mBaseBinormals[v] = other.mSharedData.mBaseBinormals[v];
+            mSharedData.mTexCoords[v] = other.mSharedData.mTexCoords[v];
+        }
+        mMesh = new LLPolyMesh(&mSharedData, NULL);
+        for (LLPolyMorphData* data : other.mMorphData)
+        {
+            mMorphData.push_back(new LLPolyMorphData(*data));
+            mMorphs.push_back(new TestMorph(mMesh, info, mMorphData.back()));
+        }
+    }
+
+    ~LLPolyMeshTester()
+    {
+        for (U32 m = 0; m < mMorphs.size(); ++m)
+        {
+            delete mMorphs[m];
+            delete mMorphData[m];
+        }
+        delete mMesh;
+    }
+
+    const LLVector4a* getBaseCoords() const { return mSharedData.mBaseCoords; }
+
+    void apply()
+    {
+        for (LLPolyMorphTarget* morph : mMorphs)
+        {
+            morph->apply(SEX_FEMALE);
+        }
+    }
+
+    LLPolyMeshSharedData mSharedData;
+    LLPolyMesh* mMesh;
+    std::vector<LLPolyMorphData*> mMorphData;
+    std::vector<LLPolyMorphTarget*> mMorphs;
+};
+
+namespace tut
+{
+    struct polymorph_data
+    {
+        // Sets the same random weight on about a third of the morphs of both meshes
+        void randomWeights(LLPolyMeshTester& a, LLPolyMeshTester& b)
+        {
+            for (U32 m = 0; m < a.mMorphs.size(); ++m)
+            {
+                if (ll_rand(3) == 0)
+                {
+                    const F32 weight = random_range(-1.f, 1.f);
+                    a.mMorphs[m]->setWeight(weight);
+                    b.mMorphs[m]->setWeight(weight);
+                }
+            }
+        }
+
+        void compare(const std::string& desc, LLPolyMesh* expected, LLPolyMesh* actual)
+        {
+            const U32 num_vertices = expected->getNumVertices();
+            for (U32 v = 0; v < num_vertices; ++v)
+            {
+                ensure(llformat("%s position %u", desc.c_str(), v),
+                       close_enough(expected->getCoords()[v], actual->getCoords()[v], 3));
+                ensure(llformat("%s normal %u", desc.c_str(), v),
+                       close_enough(expected->getNormals()[v], actual->getNormals()[v], 3));
+                ensure(llformat("%s binormal %u", desc.c_str(), v),
+                       close_enough(expected->getBinormals()[v], actual->getBinormals()[v], 3));
+                ensure(llformat("%s clothing weight %u", desc.c_str(), v),
+                       close_enough(expected->getClothingWeights()[v], actual->getClothingWeights()[v], 4));
+                ensure_distance(llformat("%s tex coord %u", desc.c_str(), v),
+                                actual->getTexCoords()[v].mV[VX], expected->getTexCoords()[v].mV[VX], TOLERANCE);
+                ensure_distance(llformat("%s tex coord %u", desc.c_str(), v),
+                                actual->getTexCoords()[v].mV[VY], expected->getTexCoords()[v].mV[VY], TOLERANCE);
+            }
+        }
+
+        TestMorphInfo mInfo;
+    };
+    typedef test_group<polymorph_data> polymorph_test;
+    typedef polymorph_test::object polymorph_object;
+    tut::polymorph_test tpm("LLPolyMorph");
+
+    template<> template<>
+    void polymorph_object::test<1>()
+    {
+        set_test_name("batched morphs match morphs applied one at a time");
+
+        LLPolyMeshTester single(VERTEX_COUNT, MORPH_COUNT, &mInfo);
+        LLPolyMeshTester batched(single, &mInfo);
+        LLPolyMorphBatch batch;
+        for (S32 round = 0; round < 20; ++round)
+        {
+            randomWeights(single, batched);
+
+            single.apply();
+            batch.open(batched.mMesh);
+            batched.apply();
+            ensure("batch open", batch.isOpen());
+            batch.close();
+            ensure("batch closed", !batch.isOpen());
+
+            compare(llformat("round %d", round), single.mMesh, batched.mMesh);
+        }
+    }
+
+    template<> template<>
+    void polymorph_object::test<2>()
+    {
+        set_test_name("several meshes in one batch");
+
+        // enough morphed vertices over more than one mesh to take the
+        // parallel path
+        const S32 MESH_COUNT = 3;
+        std::vector<std::unique_ptr<LLPolyMeshTester> > single;
+        std::vector<std::unique_ptr<LLPolyMeshTester> > batched;
+        for (S32 i = 0; i < MESH_COUNT; ++i)
+        {
+            single.emplace_back(new LLPolyMeshTester(VERTEX_COUNT, MORPH_COUNT, &mInfo));
+            batched.emplace_back(new LLPolyMeshTester(*single.back(), &mInfo));
+        }
+
+        LLPolyMorphBatch batch;
+        for (S32 round = 0; round < 5; ++round)
+        {
+            for (S32 i = 0; i < MESH_COUNT; ++i)
+            {
+                randomWeights(*single[i], *batched[i]);
+                single[i]->apply();
+                batch.open(batched[i]->mMesh);
+            }
+            for (S32 i = 0; i < MESH_COUNT; ++i)
+            {
+                batched[i]->apply();
+            }
+            batch.close();
+
+            for (S32 i = 0; i < MESH_COUNT; ++i)
+            {
+                compare(llformat("round %d mesh %d", round, i), single[i]->mMesh, batched[i]->mMesh);
+            }
+        }
+    }
+
+    template<> template<>
+    void polymorph_object::test<3>()
+    {
+        set_test_name("weights set back to zero restore the base mesh");
+
+        LLPolyMeshTester single(VERTEX_COUNT, MORPH_COUNT, &mInfo);
+        LLPolyMeshTester batched(single, &mInfo);
+        LLPolyMorphBatch batch;
+        randomWeights(single, batched);
+        single.apply();
+        batch.open(batched.mMesh);
+        batched.apply();
+        batch.close();
+
+        for (U32 m = 0; m < MORPH_COUNT; ++m)
+        {
+            single.mMorphs[m]->setWeight(0.f);
+            batched.mMorphs[m]->setWeight(0.f);
+        }
+        single.apply();
+        batch.open(batched.mMesh);
+        batched.apply();
+        batch.close();
+
+        compare("reset", single.mMesh, batched.mMesh);
+        for (U32 v = 0; v < VERTEX_COUNT; ++v)
+        {
+            ensure(llformat("base position %u", v),
+                   close_enough(batched.getBaseCoords()[v], batched.mMesh->getCoords()[v], 3));
+        }
+    }
+}
@@ -128,9 +128,9 @@ U32 LLKeyframeMotion::JointMotionList::dumpDiagInfo()
 //-----------------------------------------------------------------------------
 
 //-----------------------------------------------------------------------------
-// JointMotion::update()
+// JointMotion::evaluate()
 //-----------------------------------------------------------------------------
-void LLKeyframeMotion::JointMotion::update(LLJointState* joint_state, F32 time, F32 duration)
+void LLKeyframeMotion::JointMotion::evaluate(const LLJointState* joint_state, F32 time, JointSample& sample) const
 {
     // this value being 0 is the cause of https://jira.lindenlab.com/browse/SL-22678 but I haven't
     // managed to get a stack to see how it got here. Testing for 0 here will stop the crash.
@@ -141,12 +141,40 @@ void LLKeyframeMotion::JointMotion::update(LLJointState* joint_state, F32 time,
 
     U32 usage = joint_state->getUsage();
 
+    if ((usage & LLJointState::SCALE) && mScaleCurve.mNumKeys)
+    {
+        sample.mScale = mScaleCurve.getValue(time, sample.mScaleKey);
+    }
+
+    if ((usage & LLJointState::ROT) && mRotationCurve.mNumKeys)
+    {
+        sample.mRotation = mRotationCurve.getValue(time, sample.mRotationKey);
+    }
+
+    if ((usage & LLJointState::POS) && mPositionCurve.mNumKeys)
+    {
+        sample.mPosition = mPositionCurve.getValue(time, sample.mPositionKey);
+    }
+}
+
+//-----------------------------------------------------------------------------
+// JointMotion::apply()
+//-----------------------------------------------------------------------------
+void LLKeyframeMotion::JointMotion::apply(LLJointState* joint_state, const JointSample& sample) const
+{
+    if ( joint_state == NULL )
+    {
+        return;
+    }
+
+    U32 usage = joint_state->getUsage();
+
     //-------------------------------------------------------------------------
     // update scale component of joint state
     //-------------------------------------------------------------------------
     if ((usage & LLJointState::SCALE) && mScaleCurve.mNumKeys)
     {
-        joint_state->setScale( mScaleCurve.getValue( time, duration ) );
+        joint_state->setScale( sample.mScale );
     }
 
     //-------------------------------------------------------------------------
@@ -154,7 +182,7 @@ void LLKeyframeMotion::JointMotion::update(LLJointState* joint_state, F32 time,
     //-------------------------------------------------------------------------
     if ((usage & LLJointState::ROT) && mRotationCurve.mNumKeys)
     {
-        joint_state->setRotation( mRotationCurve.getValue( time, duration ) );
+        joint_state->setRotation( sample.mRotation );
     }
 
     //-------------------------------------------------------------------------
@@ -162,7 +190,7 @@ void LLKeyframeMotion::JointMotion::update(LLJointState* joint_state, F32 time,
     //-------------------------------------------------------------------------
     if ((usage & LLJointState::POS) && mPositionCurve.mNumKeys)
     {
-        joint_state->setPosition( mPositionCurve.getValue( time, duration ) );
+        joint_state->setPosition( sample.mPosition );
     }
 }
 
@@ -185,7 +213,11 @@ LLKeyframeMotion::LLKeyframeMotion(const LLUUID &id)
         mLastSkeletonSerialNum(0),
         mLastUpdateTime(0.f),
         mLastLoopedTime(0.f),
-        mAssetStatus(ASSET_UNDEFINED)
+        mAssetStatus(ASSET_UNDEFINED),
+        mPreparedMotionList(NULL),
+        mPreparedTime(0.f),
+        mPreparedFrame(0),
+        mPrepared(false)
 {
 
 }
@@ -427,6 +459,37 @@ BOOL LLKeyframeMotion::onActivate()
     return TRUE;
 }
 
+//-----------------------------------------------------------------------------
+// LLKeyframeMotion::getLoopedTime()
+//-----------------------------------------------------------------------------
+F32 LLKeyframeMotion::getLoopedTime(F32 time) const
+{
+    if (!mJointMotionList->mLoop)
+    {
+        return time;
+    }
+
+    if (mJointMotionList->mDuration == 0.0f)
+    {
+        return 0.f;
+    }
+    else if (mStopped)
+    {
+        return llmin(mJointMotionList->mDuration, mLastLoopedTime + time - mLastUpdateTime);
+    }
+    else if (time > mJointMotionList->mLoopOutPoint)
+    {
+        if ((mJointMotionList->mLoopOutPoint - mJointMotionList->mLoopInPoint) == 0.f)
+        {
+            return mJointMotionList->mLoopOutPoint;
+        }
+        return mJointMotionList->mLoopInPoint +
+            fmod(time - mJointMotionList->mLoopOutPoint,
+            mJointMotionList->mLoopOutPoint - mJointMotionList->mLoopInPoint);
+    }
+    return time;
+}
+
 //-----------------------------------------------------------------------------
 // LLKeyframeMotion::onUpdate()
 //-----------------------------------------------------------------------------
@@ -436,39 +499,11 @@ BOOL LLKeyframeMotion::onUpdate(F32 time, U8* joint_mask)
     // llassert(time >= 0.f);       // This will fire
     time = llmax(0.f, time);
 
-    if (mJointMotionList->mLoop)
+    if (mJointMotionList->mLoop && mJointMotionList->mDuration == 0.0f)
     {
-        if (mJointMotionList->mDuration == 0.0f)
-        {
-            time = 0.f;
-            mLastLoopedTime = 0.0f;
-        }
-        else if (mStopped)
-        {
-            mLastLoopedTime = llmin(mJointMotionList->mDuration, mLastLoopedTime + time - mLastUpdateTime);
-        }
-        else if (time > mJointMotionList->mLoopOutPoint)
-        {
-            if ((mJointMotionList->mLoopOutPoint - mJointMotionList->mLoopInPoint) == 0.f)
-            {
-                mLastLoopedTime = mJointMotionList->mLoopOutPoint;
-            }
-            else
-            {
-                mLastLoopedTime = mJointMotionList->mLoopInPoint +
-                    fmod(time - mJointMotionList->mLoopOutPoint,
-                    mJointMotionList->mLoopOutPoint - mJointMotionList->mLoopInPoint);
-            }
-        }
-        else
-        {
-            mLastLoopedTime = time;
-        }
-    }
-    else
-    {
-        mLastLoopedTime = time;
+        time = 0.f;
     }
+    mLastLoopedTime = getLoopedTime(time);
 
     applyKeyframes(mLastLoopedTime);
 
@@ -479,17 +514,74 @@ BOOL LLKeyframeMotion::onUpdate(F32 time, U8* joint_mask)
     return mLastLoopedTime <= mJointMotionList->mDuration;
 }
 
+//-----------------------------------------------------------------------------
+// LLKeyframeMotion::onPrepareUpdate()
+//-----------------------------------------------------------------------------
+BOOL LLKeyframeMotion::onPrepareUpdate(F32 time)
+{
+    mPrepared = false;
+    if (!mJointMotionList || mJointMotionList->getNumJointMotions() > mJointStates.size())
+    {
+        return FALSE;
+    }
+
+    // same time as onUpdate() will compute if it gets this activeTime
+    time = llmax(0.f, time);
+    if (mJointMotionList->mLoop && mJointMotionList->mDuration == 0.0f)
+    {
+        time = 0.f;
+    }
+    mPreparedTime = getLoopedTime(time);
+    mPreparedMotionList = mJointMotionList;
+    mPreparedFrame = LLFrameTimer::getFrameCount();
+    mJointSamples.resize(mJointMotionList->getNumJointMotions());
+    return TRUE;
+}
+
+//-----------------------------------------------------------------------------
+// LLKeyframeMotion::preparePose()
+//-----------------------------------------------------------------------------
+void LLKeyframeMotion::preparePose()
+{
+    sampleKeyframes(mPreparedTime);
+    mPrepared = true;
+}
+
+//-----------------------------------------------------------------------------
+// sampleKeyframes()
+//-----------------------------------------------------------------------------
+void LLKeyframeMotion::sampleKeyframes(F32 time)
+{
+    for (U32 i = 0; i < mJointSamples.size(); i++)
+    {
+        mJointMotionList->getJointMotion(i)->evaluate(mJointStates[i], time, mJointSamples[i]);
+    }
+}
+
 //-----------------------------------------------------------------------------
 // applyKeyframes()
 //-----------------------------------------------------------------------------
 void LLKeyframeMotion::applyKeyframes(F32 time)
 {
-    llassert_always (mJointMotionList->getNumJointMotions() <= mJointStates.size());
-    for (U32 i=0; i<mJointMotionList->getNumJointMotions(); i++)
+    const U32 num_joint_motions = mJointMotionList->getNumJointMotions();
+    llassert_always (num_joint_motions <= mJointStates.size());
+
+    // use the samples preparePose() evaluated this frame if they are for
+    // the same time and keyframes
+    if (!mPrepared
+        || mPreparedTime != time
+        || mPreparedMotionList != mJointMotionList
+        || mPreparedFrame != LLFrameTimer::getFrameCount()
+        || mJointSamples.size() != num_joint_motions)
+    {
+        mJointSamples.resize(num_joint_motions);
+        sampleKeyframes(time);
+    }
+    mPrepared = false;
+
+    for (U32 i=0; i<num_joint_motions; i++)
     {
-        mJointMotionList->getJointMotion(i)->update(mJointStates[i],
-                                                      time,
-                                                      mJointMotionList->mDuration );
+        mJointMotionList->getJointMotion(i)->apply(mJointStates[i], mJointSamples[i]);
     }
 
     LLJoint::JointPriority* pose_priority = (LLJoint::JointPriority* )mCharacter->getAnimationData("Hand Pose Priority");
@@ -2064,9 +2156,9 @@ void LLKeyframeMotion::setLoopIn(F32 in_point)
             rot_curve->mLoopInKey.mTime = mJointMotionList->mLoopInPoint;
             scale_curve->mLoopInKey.mTime = mJointMotionList->mLoopInPoint;
 
-            pos_curve->mLoopInKey.mValue = pos_curve->getValue(mJointMotionList->mLoopInPoint, mJointMotionList->mDuration);
-            rot_curve->mLoopInKey.mValue = rot_curve->getValue(mJointMotionList->mLoopInPoint, mJointMotionList->mDuration);
-            scale_curve->mLoopInKey.mValue = scale_curve->getValue(mJointMotionList->mLoopInPoint, mJointMotionList->mDuration);
+            pos_curve->mLoopInKey.mValue = pos_curve->getValue(mJointMotionList->mLoopInPoint);
+            rot_curve->mLoopInKey.mValue = rot_curve->getValue(mJointMotionList->mLoopInPoint);
+            scale_curve->mLoopInKey.mValue = scale_curve->getValue(mJointMotionList->mLoopInPoint);
         }
     }
 }
@@ -2093,9 +2185,9 @@ void LLKeyframeMotion::setLoopOut(F32 out_point)
             rot_curve->mLoopOutKey.mTime = mJointMotionList->mLoopOutPoint;
             scale_curve->mLoopOutKey.mTime = mJointMotionList->mLoopOutPoint;
 
-            pos_curve->mLoopOutKey.mValue = pos_curve->getValue(mJointMotionList->mLoopOutPoint, mJointMotionList->mDuration);
-            rot_curve->mLoopOutKey.mValue = rot_curve->getValue(mJointMotionList->mLoopOutPoint, mJointMotionList->mDuration);
-            scale_curve->mLoopOutKey.mValue = scale_curve->getValue(mJointMotionList->mLoopOutPoint, mJointMotionList->mDuration);
+            pos_curve->mLoopOutKey.mValue = pos_curve->getValue(mJointMotionList->mLoopOutPoint);
+            rot_curve->mLoopOutKey.mValue = rot_curve->getValue(mJointMotionList->mLoopOutPoint);
+            scale_curve->mLoopOutKey.mValue = scale_curve->getValue(mJointMotionList->mLoopOutPoint);
         }
     }
 }
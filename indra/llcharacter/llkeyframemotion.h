@@ -163,6 +163,10 @@ class LLKeyframeMotion :
     // must return FALSE when the motion is completed.
     virtual BOOL onUpdate(F32 time, U8* joint_mask);
 
+    // evaluates the keyframes ahead of onUpdate(), see LLMotion
+    virtual BOOL onPrepareUpdate(F32 time);
+    virtual void preparePose();
+
     // called when a motion is deactivated
     virtual void onDeactivate();
 
@@ -278,6 +282,10 @@ class LLKeyframeMotion :
         F32                         mFixupDistanceRMS;
     };
 
+    F32 getLoopedTime(F32 time) const;
+
+    void sampleKeyframes(F32 time);
+
     void applyKeyframes(F32 time);
 
     void applyConstraints(F32 time, U8* joint_mask);
@@ -308,7 +316,7 @@ class LLKeyframeMotion :
             T           mValue;
         };
 
-        T interp(F32 u, Key& before, Key& after)
+        T interp(F32 u, const Key& before, const Key& after) const
         {
             switch (mInterpolationType)
             {
@@ -321,44 +329,59 @@ class LLKeyframeMotion :
             }
         }
 
-        T getValue(F32 time, F32 duration)
+        T getValue(F32 time) const
+        {
+            U32 cursor = 0;
+            return getValue(time, cursor);
+        }
+
+        // cursor is the index of the key found by the previous lookup on
+        // this curve, kept per motion instance.  From one frame to the next
+        // time rarely moves past more than one key, so checking the keys
+        // around the cursor saves the binary search.
+        T getValue(F32 time, U32& cursor) const
         {
             if (mKeys.empty())
             {
                 return T();
             }
 
-            T value;
-            typename key_map_t::iterator right = std::lower_bound(mKeys.begin(), mKeys.end(), time, [](const auto& a, const auto& b) { return a.first < b; });
-            if (right == mKeys.end())
+            // find the first key at or after time, as std::lower_bound() would
+            const U32 num_keys = (U32)mKeys.size();
+            typename key_map_t::const_iterator begin = mKeys.begin();
+            auto before_time = [](const auto& a, const auto& b) { return a.first < b; };
+            U32 right = llmin(cursor, num_keys);
+            if (right > 0 && (begin + (right - 1))->first >= time)
             {
-                // Past last key
-                --right;
-                value = right->second.mValue;
-            }
-            else if (right == mKeys.begin() || right->first == time)
-            {
-                // Before first key or exactly on a key
-                value = right->second.mValue;
+                // went back, looped or restarted
+                right = (U32)(std::lower_bound(begin, begin + right, time, before_time) - begin);
             }
-            else
+            else if (right < num_keys && (begin + right)->first < time)
             {
-                // Between two keys
-                typename key_map_t::iterator left = right; --left;
-                F32 index_before = left->first;
-                F32 index_after = right->first;
-                Key& pos_before = left->second;
-                Key& pos_after = right->second;
-                if (right == mKeys.end())
+                ++right;
+                if (right < num_keys && (begin + right)->first < time)
                 {
-                    pos_after = mLoopInKey;
-                    index_after = duration;
+                    right = (U32)(std::lower_bound(begin + right + 1, mKeys.end(), time, before_time) - begin);
                 }
+            }
+            cursor = right;
 
-                F32 u = (time - index_before) / (index_after - index_before);
-                value = interp(u, pos_before, pos_after);
+            if (right == num_keys)
+            {
+                // Past last key
+                return (begin + (num_keys - 1))->second.mValue;
+            }
+            typename key_map_t::const_iterator after = begin + right;
+            if (right == 0 || after->first == time)
+            {
+                // Before first key or exactly on a key
+                return after->second.mValue;
             }
-            return value;
+
+            // Between two keys
+            typename key_map_t::const_iterator before = after - 1;
+            F32 u = (time - before->first) / (after->first - before->first);
+            return interp(u, before->second, after->second);
         }
 
         InterpolationType   mInterpolationType = LLKeyframeMotion::IT_LINEAR;
@@ -376,6 +399,21 @@ class LLKeyframeMotion :
     typedef Curve<LLVector3> PositionCurve;
     typedef PositionCurve::Key PositionKey;
 
+    //-------------------------------------------------------------------------
+    // JointSample
+    // Per instance evaluation state of a JointMotion: the keys found by the
+    // last lookup in each curve and the values evaluated from them
+    //-------------------------------------------------------------------------
+    struct JointSample
+    {
+        LLQuaternion    mRotation;
+        LLVector3       mPosition;
+        LLVector3       mScale;
+        U32             mRotationKey = 0;
+        U32             mPositionKey = 0;
+        U32             mScaleKey = 0;
+    };
+
     //-------------------------------------------------------------------------
     // JointMotion
     //-------------------------------------------------------------------------
@@ -389,7 +427,11 @@ class LLKeyframeMotion :
         U32             mUsage;
         LLJoint::JointPriority  mPriority;
 
-        void update(LLJointState* joint_state, F32 time, F32 duration);
+        // Evaluates the curves the joint state uses at time into sample,
+        // reads nothing but the curves and the joint state usage
+        void evaluate(const LLJointState* joint_state, F32 time, JointSample& sample) const;
+        // Copies the evaluated values to the joint state
+        void apply(LLJointState* joint_state, const JointSample& sample) const;
     };
 
     //-------------------------------------------------------------------------
@@ -435,6 +477,14 @@ class LLKeyframeMotion :
     F32                             mLastLoopedTime;
     AssetStatus                     mAssetStatus;
 
+    // one per joint motion, filled ahead of onUpdate() by preparePose()
+    // when the motion controller batches the evaluation
+    std::vector<JointSample>        mJointSamples;
+    JointMotionList*                mPreparedMotionList;
+    F32                             mPreparedTime;
+    U32                             mPreparedFrame;
+    bool                            mPrepared;
+
 public:
     void setCharacter(LLCharacter* character) { mCharacter = character; }
 
@@ -156,6 +156,16 @@ class LLMotion
     // must return FALSE when the motion is completed.
     virtual BOOL onUpdate(F32 activeTime, U8* joint_mask) = 0;
 
+    // called on the main thread ahead of a batched update with the time the
+    // next onUpdate() is expected to get, returns TRUE when preparePose()
+    // has work to do for it
+    virtual BOOL onPrepareUpdate(F32 activeTime) { return FALSE; }
+
+    // called on a worker thread while the main thread waits, after
+    // onPrepareUpdate() returned TRUE.  Must only touch this motion's state,
+    // onUpdate() falls back to doing the work itself if the time differs.
+    virtual void preparePose() {}
+
     // called when a motion is deactivated
     virtual void onDeactivate() = 0;
 
@@ -36,6 +36,7 @@
 #include "lltimer.h"
 #include "llanimationstates.h"
 #include "llstl.h"
+#include "llparallelfor.h"
 
 // This is why LL_CHARACTER_MAX_ANIMATED_JOINTS needs to be a multiple of 4.
 const S32 NUM_JOINT_SIGNATURE_STRIDES = LL_CHARACTER_MAX_ANIMATED_JOINTS / 4;
@@ -129,6 +130,9 @@ LLMotionController::LLMotionController()
       mTimeStep(0.f),
       mTimeStepCount(0),
       mLastInterp(0.f),
+      mPreparedTimerElapsed(0.f),
+      mPreparedFrame(0),
+      mHasPreparedTime(false),
       mIsSelf(FALSE),
       mLastCountAfterPurge(0)
 {
@@ -817,8 +821,10 @@ void LLMotionController::updateMotions(bool force_update)
     // Currently setting mTimeStep to nonzero is disabled elsewhere.
     BOOL use_quantum = (mTimeStep != 0.f);
 
-    // Always update mPrevTimerElapsed
-    F32 cur_time = mTimer.getElapsedTimeF32();
+    // Always update mPrevTimerElapsed, from the sample prepareMotions()
+    // took this frame if any so that the prepared poses match
+    F32 cur_time = (mHasPreparedTime && mPreparedFrame == LLFrameTimer::getFrameCount()) ? mPreparedTimerElapsed : mTimer.getElapsedTimeF32();
+    mHasPreparedTime = false;
     F32 delta_time = cur_time - mPrevTimerElapsed;
     mPrevTimerElapsed = cur_time;
     mLastTime = mAnimTime;
@@ -907,6 +913,7 @@ void LLMotionController::updateMotionsMinimal()
     LL_PROFILE_ZONE_SCOPED_CATEGORY_AVATAR;
     // Always update mPrevTimerElapsed
     mPrevTimerElapsed = mTimer.getElapsedTimeF32();
+    mHasPreparedTime = false;
 
     purgeExcessMotions();
     updateLoadingMotions();
@@ -917,6 +924,60 @@ void LLMotionController::updateMotionsMinimal()
     mHasRunOnce = TRUE;
 }
 
+//-----------------------------------------------------------------------------
+// prepareMotions()
+//-----------------------------------------------------------------------------
+void LLMotionController::prepareMotions(std::vector<LLMotion*>& motions)
+{
+    LL_PROFILE_ZONE_SCOPED_CATEGORY_AVATAR;
+    // paused and quantized updates do not evaluate this frame's poses
+    if (mPaused || mTimeStep != 0.f)
+    {
+        return;
+    }
+
+    F32 cur_time = mTimer.getElapsedTimeF32();
+    mPreparedTimerElapsed = cur_time;
+    mPreparedFrame = LLFrameTimer::getFrameCount();
+    mHasPreparedTime = true;
+
+    // the animation time updateMotions() will compute from that sample
+    F32 delta_time = cur_time - mPrevTimerElapsed;
+    F32 anim_time = mAnimTime + delta_time * mTimeFactor;
+
+    for (LLMotion* motionp : mActiveMotions)
+    {
+        // motions that start later or get deactivated by this update
+        if (anim_time < motionp->mActivationTimestamp
+            || (motionp->isStopped() && anim_time > motionp->getStopTime() + motionp->getEaseOutDuration()))
+        {
+            continue;
+        }
+
+        if (motionp->onPrepareUpdate(anim_time - motionp->mActivationTimestamp))
+        {
+            motions.push_back(motionp);
+        }
+    }
+}
+
+//-----------------------------------------------------------------------------
+// preparePoses()
+//-----------------------------------------------------------------------------
+// static
+void LLMotionController::preparePoses(const std::vector<LLMotion*>& motions)
+{
+    LL_PROFILE_ZONE_SCOPED_CATEGORY_AVATAR;
+    // a few motions per batch, a motion is a couple dozen joints
+    LL::parallel_for(motions.size(), 8, [&motions](size_t begin, size_t end)
+        {
+            for (size_t i = begin; i < end; ++i)
+            {
+                motions[i]->preparePose();
+            }
+        });
+}
+
 //-----------------------------------------------------------------------------
 // activateMotionInstance()
 //-----------------------------------------------------------------------------
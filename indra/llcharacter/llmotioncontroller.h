@@ -139,6 +139,14 @@ class LLMotionController
     // minimal update (e.g. while hidden)
     void updateMotionsMinimal();
 
+    // samples the timer for this frame's updateMotions() and collects the
+    // active motions that can evaluate their pose ahead of it
+    void prepareMotions(std::vector<LLMotion*>& motions);
+
+    // runs preparePose() of the collected motions, of any number of
+    // characters, across the General thread pool and waits for them
+    static void preparePoses(const std::vector<LLMotion*>& motions);
+
     void clearBlenders() { mPoseBlender.clearBlenders(); }
 
     // flush motions
@@ -231,6 +239,12 @@ class LLMotionController
     S32                 mTimeStepCount;
     F32                 mLastInterp;
 
+    // timer sample taken by prepareMotions(), used by the next update in
+    // the same frame
+    F32                 mPreparedTimerElapsed;
+    U32                 mPreparedFrame;
+    bool                mHasPreparedTime;
+
     U8                  mJointSignature[2][LL_CHARACTER_MAX_ANIMATED_JOINTS];
 private:
     U32                 mLastCountAfterPurge; //for logging and debugging purposes
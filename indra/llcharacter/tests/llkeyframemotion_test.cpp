@@ -0,0 +1,146 @@
+/**
+ * @file llkeyframemotion_test.cpp
+ * @brief Tests for the keyframe curve lookups of LLKeyframeMotion
+ *
+ * $LicenseInfo:firstyear=2024&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2024, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#include "linden_common.h"
+
+#include "../llkeyframemotion.h"
+#include "llformat.h"
+#include "llrand.h"
+
+#include "../test/lltut.h"
+
+namespace
+{
+    typedef LLKeyframeMotion::PositionCurve Curve;
+
+    // Keys every half second from 0 to 5, each with its own value
+    void make_curve(Curve& curve, U32 num_keys)
+    {
+        for (U32 i = 0; i < num_keys; ++i)
+        {
+            F32 time = 0.5f * i;
+            curve.mKeys[time] = Curve::Key(time, LLVector3((F32)i, (F32)(i * i) * 0.25f, -(F32)i));
+        }
+        curve.mNumKeys = (S32)num_keys;
+    }
+
+    // The lookup from a cursor kept across calls must give what a lookup
+    // from scratch gives
+    void check(const Curve& curve, F32 time, U32& cursor, const std::string& what)
+    {
+        LLVector3 expected = curve.getValue(time);
+        LLVector3 value = curve.getValue(time, cursor);
+        tut::ensure_equals(llformat("%s at %f", what.c_str(), time), value, expected);
+        tut::ensure(llformat("%s cursor at %f", what.c_str(), time), cursor <= (U32)curve.mKeys.size());
+    }
+}
+
+namespace tut
+{
+    struct keyframemotion_data
+    {
+    };
+    typedef test_group<keyframemotion_data> keyframemotion_test;
+    typedef keyframemotion_test::object keyframemotion_object;
+    tut::keyframemotion_test tkm("LLKeyframeMotion");
+
+    template<> template<>
+    void keyframemotion_object::test<1>()
+    {
+        set_test_name("cursor lookup during forward playback");
+
+        Curve curve;
+        make_curve(curve, 11);
+        U32 cursor = 0;
+        for (F32 time = -0.1f; time < 5.2f; time += 1.f / 30.f)
+        {
+            check(curve, time, cursor, "frame");
+        }
+
+        // big steps skip several keys, exact key times land on them
+        cursor = 0;
+        for (U32 i = 0; i <= 10; i += 3)
+        {
+            check(curve, 0.5f * i, cursor, "on key");
+            check(curve, 0.5f * i + 0.1f, cursor, "past key");
+        }
+    }
+
+    template<> template<>
+    void keyframemotion_object::test<2>()
+    {
+        set_test_name("cursor lookup after going back and looping");
+
+        Curve curve;
+        make_curve(curve, 11);
+        U32 cursor = 0;
+
+        // loop between 1.2 and 3.7 a few times
+        for (S32 i = 0; i < 300; ++i)
+        {
+            check(curve, 1.2f + fmodf(i * 0.07f, 2.5f), cursor, "loop");
+        }
+
+        // restart from the beginning, then random jumps either way
+        check(curve, 4.9f, cursor, "before restart");
+        check(curve, 0.f, cursor, "restart");
+        for (S32 i = 0; i < 500; ++i)
+        {
+            check(curve, ll_frand(6.f) - 0.5f, cursor, "jump");
+        }
+    }
+
+    template<> template<>
+    void keyframemotion_object::test<3>()
+    {
+        set_test_name("cursor lookup past the last key and with one key");
+
+        Curve curve;
+        make_curve(curve, 11);
+        U32 cursor = 0;
+        check(curve, 2.3f, cursor, "middle");
+        check(curve, 5.f, cursor, "last key");
+        check(curve, 7.f, cursor, "past last");
+        check(curve, 100.f, cursor, "far past last");
+        ensure_equals("cursor past last", cursor, 11U);
+        check(curve, 4.8f, cursor, "back from past last");
+
+        // a stale cursor from a longer curve must not read past the keys
+        Curve single;
+        make_curve(single, 1);
+        cursor = 11;
+        check(single, 0.3f, cursor, "stale cursor");
+        for (F32 time : { -1.f, 0.f, 1.f, 0.f, -1.f })
+        {
+            check(single, time, cursor, "one key");
+            ensure_equals(llformat("one key value at %f", time), single.getValue(time, cursor), LLVector3::zero);
+        }
+
+        Curve empty;
+        cursor = 3;
+        ensure_equals("no keys", empty.getValue(1.f, cursor), LLVector3());
+    }
+}
@@ -136,6 +136,8 @@ LLApp::~LLApp()
 
     setStopped();
 
+    LLError::setAsyncLogging(false);
+
     SUBSYSTEM_CLEANUP_DBG(LLCommon);
 }
 
@@ -375,6 +377,9 @@ void LLApp::setErrorHandler(LLAppErrorHandler handler)
 // static
 void LLApp::runErrorHandler()
 {
+    // get the queued log messages out before the crash report reads the log
+    LLError::flushAsyncLogging();
+
     if (LLApp::sErrorHandler)
     {
         LLApp::sErrorHandler();
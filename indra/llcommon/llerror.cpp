@@ -31,7 +31,10 @@
 #include "llerrorcontrol.h"
 #include "llsdutil.h"
 
+#include <atomic>
 #include <cctype>
+#include <chrono>
+#include <condition_variable>
 #ifdef __GNUC__
 # include <cxxabi.h>
 #endif // __GNUC__
@@ -45,6 +48,7 @@
 #endif // !LL_WINDOWS
 #include <vector>
 #include <string_view>
+#include <thread>
 #include "string.h"
 
 #include "boost/unordered/unordered_flat_map.hpp"
@@ -571,6 +575,9 @@ namespace
         void invalidateCallSites();
 
         SettingsConfigPtr getSettingsConfig();
+        // For what recorders call: they may run on the asynchronous writer
+        // thread, which must not touch the non thread safe refcount.
+        SettingsConfig* peekSettingsConfig() { return mSettingsConfig.get(); }
 
         void resetSettingsConfig();
         LLError::SettingsStoragePtr saveAndResetSettingsConfig();
@@ -844,8 +851,7 @@ namespace LLError
 
     bool getAlwaysFlush()
     {
-        SettingsConfigPtr s = Globals::getInstance()->getSettingsConfig();
-        return s->mLogAlwaysFlush;
+        return Globals::getInstance()->peekSettingsConfig()->mLogAlwaysFlush;
     }
 
     void setEnabledLogTypesMask(U32 mask)
@@ -856,8 +862,7 @@ namespace LLError
 
     U32 getEnabledLogTypesMask()
     {
-        SettingsConfigPtr s = Globals::getInstance()->getSettingsConfig();
-        return s->mEnabledLogTypesMask;
+        return Globals::getInstance()->peekSettingsConfig()->mEnabledLogTypesMask;
     }
 
     void setFunctionLevel(const std::string& function_name, ELevel level)
@@ -947,6 +952,10 @@ namespace LLError
         {
             setAlwaysFlush(config["log-always-flush"]);
         }
+        if (config.has("log-async"))
+        {
+            setAsyncLogging(config["log-async"]);
+        }
         if (config.has("enabled-log-types-mask"))
         {
             setEnabledLogTypesMask(config["enabled-log-types-mask"].asInteger());
@@ -1227,11 +1236,13 @@ namespace
         return out.str();
     }
 
-    void writeToRecorders(const LLError::CallSite& site, const std::string& message)
+    // time, when not NULL, was taken by the thread that logged the message
+    // and is used instead of asking mTimeFunction for every recorder
+    void writeToRecorders(const LLError::CallSite& site, const std::string& message,
+                          SettingsConfig* s, const std::string* time = NULL)
     {
         LL_PROFILE_ZONE_SCOPED_CATEGORY_LOGGING
         LLError::ELevel level = site.mLevel;
-        SettingsConfigPtr s = Globals::getInstance()->getSettingsConfig();
 
         std::string escaped_message;
 
@@ -1247,7 +1258,14 @@ namespace
 
             if (r->wantsTime() && s->mTimeFunction != NULL)
             {
-                message_stream << s->mTimeFunction();
+                if (time)
+                {
+                    message_stream << *time;
+                }
+                else
+                {
+                    message_stream << s->mTimeFunction();
+                }
             }
             message_stream << " ";
 
@@ -1352,6 +1370,310 @@ namespace {
         }
         return found_level;
     }
+
+    // A message waiting for the asynchronous writer. Call sites are function
+    // statics (see lllog()), so it is safe to keep a pointer to them.
+    struct AsyncRecord
+    {
+        const LLError::CallSite* mSite = NULL;
+        std::string mTime;
+        std::string mMessage;
+    };
+
+    // Lock free single producer, single consumer ring. The producer is the
+    // thread that owns the ring, the consumer whoever holds the writer's
+    // drain mutex. Strings are swapped in and out so that the slots keep
+    // their buffers and steady state logging does not allocate.
+    class AsyncRing
+    {
+    public:
+        static constexpr size_t CAPACITY = 1024; // must be a power of two
+
+        // returns false when the ring is full, sets was_empty when the
+        // consumer may have gone to sleep on an empty ring
+        bool push(const LLError::CallSite& site, std::string& time, std::string& message, bool& was_empty)
+        {
+            size_t tail = mTail.load(std::memory_order_relaxed);
+            size_t head = mHead.load(std::memory_order_acquire);
+            if (tail - head >= CAPACITY)
+            {
+                return false;
+            }
+
+            AsyncRecord& record = mRecords[tail & (CAPACITY - 1)];
+            record.mSite = &site;
+            record.mTime.swap(time);
+            record.mMessage.swap(message);
+            mTail.store(tail + 1, std::memory_order_release);
+            was_empty = tail == head;
+            return true;
+        }
+
+        bool pop(AsyncRecord& out)
+        {
+            size_t head = mHead.load(std::memory_order_relaxed);
+            if (head == mTail.load(std::memory_order_acquire))
+            {
+                return false;
+            }
+
+            AsyncRecord& record = mRecords[head & (CAPACITY - 1)];
+            out.mSite = record.mSite;
+            out.mTime.swap(record.mTime);
+            out.mMessage.swap(record.mMessage);
+            mHead.store(head + 1, std::memory_order_release);
+            return true;
+        }
+
+        bool empty() const
+        {
+            return mHead.load(std::memory_order_acquire) == mTail.load(std::memory_order_acquire);
+        }
+
+        // set once the owning thread has exited, the writer forgets the
+        // ring after draining it
+        std::atomic<bool> mOrphaned{ false };
+
+    private:
+        AsyncRecord mRecords[CAPACITY];
+        alignas(64) std::atomic<size_t> mHead{ 0 };
+        alignas(64) std::atomic<size_t> mTail{ 0 };
+    };
+
+    typedef std::shared_ptr<AsyncRing> AsyncRingPtr;
+
+    // Background thread draining the per thread rings into the recorders.
+    // When a ring is full the caller drains the rings itself and writes its
+    // message synchronously, so nothing is lost when the writer falls behind.
+    //
+    // Lock order is LOG_MUTEX before mDrainMutex. Log::flush() drains with
+    // LOG_MUTEX held before an LL_ERRS message, so the writer only takes
+    // LOG_MUTEX (to get at the non thread safe SettingsConfigPtr refcount)
+    // while it is not draining.
+    class AsyncLogWriter
+    {
+    public:
+        static AsyncLogWriter& instance()
+        {
+            // function static for the same reason as getMutex()
+            static AsyncLogWriter sInstance;
+            return sInstance;
+        }
+
+        ~AsyncLogWriter()
+        {
+            // Too late to write anything, Globals may already be gone.
+            // LLError::setAsyncLogging(false) should have been called.
+            stop();
+        }
+
+        bool running() const { return mRunning; }
+
+        void start()
+        {
+            std::lock_guard<std::mutex> lock(mControlMutex);
+            if (mThread.joinable())
+            {
+                return;
+            }
+            mStop = false;
+            mThread = std::thread([this]() { run(); });
+            mRunning = true;
+        }
+
+        // Messages still queued are left for the caller to drain()
+        void stop()
+        {
+            std::lock_guard<std::mutex> lock(mControlMutex);
+            if (!mThread.joinable())
+            {
+                return;
+            }
+            mRunning = false;
+            mStop = true;
+            mWake.notify_one();
+            mThread.join();
+        }
+
+        // Queue message for the writer. Returns false when asynchronous
+        // logging is off and the caller must write the message itself.
+        // Call with LOG_MUTEX held.
+        bool post(const LLError::CallSite& site, std::string& message, const SettingsConfigPtr& s)
+        {
+            if (!mRunning || sIsWriterThread)
+            {
+                return false;
+            }
+
+            // the time the message was logged, not the time it was written
+            std::string time;
+            if (s->mTimeFunction != NULL)
+            {
+                time = s->mTimeFunction();
+            }
+
+            bool was_empty = false;
+            if (!getRing().push(site, time, message, was_empty))
+            {
+                // the writer can't keep up: write out this thread's backlog
+                // (and everyone else's) before the message so the order holds
+                mOverflows++;
+                drainRings(s.get(), true);
+                return false;
+            }
+            if (was_empty)
+            {
+                mWake.notify_one();
+            }
+            return true;
+        }
+
+        // Write out what is queued on every ring. With wait false gives up
+        // after a second if another thread is draining, which is what a
+        // crash handler wants. Returns the number of messages written.
+        size_t drain(SettingsConfig* s, bool wait)
+        {
+            // a recorder logging from the writer thread, which is draining
+            return sIsWriterThread ? 0 : drainRings(s, wait);
+        }
+
+        // Write out everything queued, for shutdown once the thread has
+        // stopped. Call with LOG_MUTEX held.
+        void drainAll(SettingsConfig* s)
+        {
+            while (!sIsWriterThread && pending())
+            {
+                drainRings(s, true);
+            }
+        }
+
+        U64 getOverflowCount() const { return mOverflows; }
+
+    private:
+        AsyncLogWriter() = default;
+
+        static constexpr int IDLE_WAIT_MS = 50;
+
+        size_t drainRings(SettingsConfig* s, bool wait)
+        {
+            LL_PROFILE_ZONE_SCOPED_CATEGORY_LOGGING
+            std::unique_lock<std::timed_mutex> lock(mDrainMutex, std::defer_lock);
+            if (wait)
+            {
+                lock.lock();
+            }
+            else if (!lock.try_lock_for(std::chrono::seconds(1)))
+            {
+                return 0;
+            }
+
+            std::vector<AsyncRingPtr> rings;
+            {
+                std::lock_guard<std::mutex> rings_lock(mRingsMutex);
+                mRings.erase(std::remove_if(mRings.begin(), mRings.end(), [](const AsyncRingPtr& ring)
+                    {
+                        return ring->mOrphaned && ring->empty();
+                    }), mRings.end());
+                rings = mRings;
+            }
+
+            size_t written = 0;
+            AsyncRecord record;
+            for (const AsyncRingPtr& ring : rings)
+            {
+                // at most one ring's worth, a busy thread must not starve
+                // the others or an LL_ERRS waiting to go out
+                for (size_t i = 0; i < AsyncRing::CAPACITY && ring->pop(record); ++i)
+                {
+                    writeToRecorders(*record.mSite, record.mMessage, s, &record.mTime);
+                    ++written;
+                }
+            }
+            return written;
+        }
+
+        AsyncRing& getRing()
+        {
+            struct RingHolder
+            {
+                ~RingHolder()
+                {
+                    if (mRing)
+                    {
+                        mRing->mOrphaned = true;
+                    }
+                }
+                AsyncRingPtr mRing;
+            };
+            thread_local RingHolder sHolder;
+
+            if (!sHolder.mRing)
+            {
+                sHolder.mRing = std::make_shared<AsyncRing>();
+                std::lock_guard<std::mutex> lock(mRingsMutex);
+                mRings.push_back(sHolder.mRing);
+            }
+            return *sHolder.mRing;
+        }
+
+        bool pending()
+        {
+            std::lock_guard<std::mutex> lock(mRingsMutex);
+            for (const AsyncRingPtr& ring : mRings)
+            {
+                if (!ring->empty())
+                {
+                    return true;
+                }
+            }
+            return false;
+        }
+
+        void run()
+        {
+            sIsWriterThread = true;
+            while (!mStop)
+            {
+                if (!pending())
+                {
+                    // producers only signal an empty ring going non empty,
+                    // a missed wakeup costs at most one timeout
+                    std::unique_lock<std::mutex> lock(mWakeMutex);
+                    mWake.wait_for(lock, std::chrono::milliseconds(IDLE_WAIT_MS));
+                    continue;
+                }
+
+                SettingsConfigPtr s;
+                {
+                    LLMutexLock lock(getMutex<LOG_MUTEX>());
+                    s = Globals::getInstance()->getSettingsConfig();
+                }
+                drainRings(s.get(), true);
+                {
+                    LLMutexLock lock(getMutex<LOG_MUTEX>());
+                    s = NULL;
+                }
+            }
+        }
+
+        std::mutex mControlMutex;
+        std::thread mThread;
+        std::atomic<bool> mRunning{ false };
+        std::atomic<bool> mStop{ false };
+
+        std::mutex mWakeMutex;
+        std::condition_variable mWake;
+
+        std::mutex mRingsMutex;
+        std::vector<AsyncRingPtr> mRings;
+
+        std::timed_mutex mDrainMutex;
+        std::atomic<U64> mOverflows{ 0 };
+
+        static thread_local bool sIsWriterThread;
+    };
+
+    thread_local bool AsyncLogWriter::sIsWriterThread = false;
 }
 
 namespace LLError
@@ -1443,7 +1765,18 @@ namespace LLError
             message = message_stream.str();
         }
 
-        writeToRecorders(site, message);
+        AsyncLogWriter& writer = AsyncLogWriter::instance();
+        if (site.mLevel == LEVEL_ERROR)
+        {
+            // whatever was queued before the error goes out first
+            writer.drain(s.get(), true);
+        }
+        else if (writer.post(site, message, s))
+        {
+            return;
+        }
+
+        writeToRecorders(site, message, s.get());
 
         if (site.mLevel == LEVEL_ERROR)
         {
@@ -1456,6 +1789,50 @@ namespace LLError
     }
 }
 
+namespace LLError
+{
+    void setAsyncLogging(bool async)
+    {
+        if (async)
+        {
+            AsyncLogWriter::instance().start();
+        }
+        else
+        {
+            AsyncLogWriter& writer = AsyncLogWriter::instance();
+            writer.stop();
+
+            // Unlike flushAsyncLogging() this waits for the mutex: a post()
+            // in progress finishes first, and none start once the writer
+            // has stopped, so every ring is empty when this returns.
+            LLMutexLock lock(getMutex<LOG_MUTEX>());
+            SettingsConfigPtr s = Globals::getInstance()->getSettingsConfig();
+            writer.drainAll(s.get());
+        }
+    }
+
+    bool getAsyncLogging()
+    {
+        return AsyncLogWriter::instance().running();
+    }
+
+    void flushAsyncLogging()
+    {
+        LLMutexTrylock lock(getMutex<LOG_MUTEX>(), 5);
+        if (!lock.isLocked())
+        {
+            return;
+        }
+        SettingsConfigPtr s = Globals::getInstance()->getSettingsConfig();
+        AsyncLogWriter::instance().drain(s.get(), false);
+    }
+
+    U64 getAsyncLogOverflowCount()
+    {
+        return AsyncLogWriter::instance().getOverflowCount();
+    }
+}
+
 namespace LLError
 {
     SettingsStoragePtr saveAndResetSettings()
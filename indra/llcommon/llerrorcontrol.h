@@ -76,6 +76,21 @@ namespace LLError
     LL_COMMON_API ELevel getDefaultLevel();
     LL_COMMON_API void setAlwaysFlush(bool flush);
     LL_COMMON_API bool getAlwaysFlush();
+    LL_COMMON_API void setAsyncLogging(bool async);
+        // When on, messages below LEVEL_ERROR are queued on a per thread
+        // ring and written to the recorders by a background thread, so
+        // recorders may be called from that thread. A message that finds
+        // its ring full is written synchronously, after the queued ones.
+        // Turning it off stops the thread and waits until everything still
+        // queued is written; do so before exit.
+    LL_COMMON_API bool getAsyncLogging();
+    LL_COMMON_API void flushAsyncLogging();
+        // writes out queued messages on the calling thread, for crash
+        // handlers. Gives up rather than block if another thread holds the
+        // log, so it may leave messages behind; LEVEL_ERROR messages and
+        // setAsyncLogging(false) drain fully.
+    LL_COMMON_API U64 getAsyncLogOverflowCount();
+        // how many messages found their ring full and were written synchronously
     LL_COMMON_API void setEnabledLogTypesMask(U32 mask);
     LL_COMMON_API U32 getEnabledLogTypesMask();
     LL_COMMON_API void setFunctionLevel(const std::string& function_name, LLError::ELevel);
@@ -0,0 +1,121 @@
+/**
+ * @file lllockfreequeue.h
+ * @brief Unbounded multi-producer, single-consumer queue without locks
+ *
+ * $LicenseInfo:firstyear=2024&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2024, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#ifndef LL_LLLOCKFREEQUEUE_H
+#define LL_LLLOCKFREEQUEUE_H
+
+#include <atomic>
+#include <cstddef>
+#include <utility>
+
+//
+// Any number of threads may push() without blocking one another; a
+// single consumer takes everything pushed so far with popAll().  Meant
+// for handing finished work back to the main thread, where the consumer
+// drains the whole queue once per frame anyway.
+//
+// Producers link nodes onto an atomic list head.  popAll() detaches the
+// entire list in one exchange, so there is no ABA hazard, and reverses
+// it to hand items out in push order.
+//
+template <typename T>
+class LLLockFreeQueue
+{
+public:
+    LLLockFreeQueue() = default;
+    LLLockFreeQueue(const LLLockFreeQueue&) = delete;
+    LLLockFreeQueue& operator=(const LLLockFreeQueue&) = delete;
+
+    ~LLLockFreeQueue()
+    {
+        Node* node = mHead.exchange(nullptr, std::memory_order_acquire);
+        while (node)
+        {
+            Node* next = node->mNext;
+            delete node;
+            node = next;
+        }
+    }
+
+    // Any thread.
+    void push(T value)
+    {
+        Node* node = new Node{ std::move(value), mHead.load(std::memory_order_relaxed) };
+        // count first so size() never under-reports what popAll() will see
+        mSize.fetch_add(1, std::memory_order_relaxed);
+        while (!mHead.compare_exchange_weak(node->mNext, node,
+                                            std::memory_order_release,
+                                            std::memory_order_relaxed))
+        {
+        }
+    }
+
+    // Consumer thread only.  Appends every queued item to out in push
+    // order and returns how many were appended.
+    template <typename CONTAINER>
+    size_t popAll(CONTAINER& out)
+    {
+        Node* node = mHead.exchange(nullptr, std::memory_order_acquire);
+
+        Node* ordered = nullptr;
+        while (node)
+        {
+            Node* next = node->mNext;
+            node->mNext = ordered;
+            ordered = node;
+            node = next;
+        }
+
+        size_t count = 0;
+        while (ordered)
+        {
+            out.push_back(std::move(ordered->mValue));
+            Node* next = ordered->mNext;
+            delete ordered;
+            ordered = next;
+            ++count;
+        }
+        mSize.fetch_sub(count, std::memory_order_relaxed);
+        return count;
+    }
+
+    bool empty() const { return mHead.load(std::memory_order_relaxed) == nullptr; }
+
+    // Approximate while producers are active.
+    size_t size() const { return mSize.load(std::memory_order_relaxed); }
+
+private:
+    struct Node
+    {
+        T mValue;
+        Node* mNext;
+    };
+
+    std::atomic<Node*> mHead{ nullptr };
+    std::atomic<size_t> mSize{ 0 };
+};
+
+#endif // LL_LLLOCKFREEQUEUE_H
@@ -0,0 +1,105 @@
+/**
+ * @file llparallelfor.cpp
+ * @brief Fork/join helper spreading a loop across a thread pool
+ *
+ * $LicenseInfo:firstyear=2024&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2024, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#include "linden_common.h"
+
+#include "llparallelfor.h"
+#include "threadpool.h"
+#include "workqueue.h"
+
+#include <atomic>
+#include <memory>
+#include <thread>
+
+namespace
+{
+    // Shared with the helpers: one that gets to run after the caller
+    // returned finds no batch left and never touches mFunc.
+    struct Batches
+    {
+        Batches(size_t count, size_t batch_size, const std::function<void(size_t, size_t)>& func)
+            : mCount(count),
+              mBatchSize(batch_size),
+              mBatches((count + batch_size - 1) / batch_size),
+              mFunc(func),
+              mNext(0),
+              mDone(0)
+        {
+        }
+
+        void run()
+        {
+            for (size_t batch = mNext++; batch < mBatches; batch = mNext++)
+            {
+                size_t begin = batch * mBatchSize;
+                mFunc(begin, llmin(mCount, begin + mBatchSize));
+                mDone++;
+            }
+        }
+
+        const size_t mCount;
+        const size_t mBatchSize;
+        const size_t mBatches;
+        const std::function<void(size_t, size_t)>& mFunc;
+        std::atomic<size_t> mNext;
+        std::atomic<size_t> mDone;
+    };
+}
+
+void LL::parallel_for(size_t count, size_t batch_size,
+                      const std::function<void(size_t begin, size_t end)>& func,
+                      const std::string& pool)
+{
+    if (!count)
+    {
+        return;
+    }
+
+    auto batches = std::make_shared<Batches>(count, llmax(batch_size, (size_t)1), func);
+    if (batches->mBatches > 1)
+    {
+        LL::WorkQueue::ptr_t queue = LL::WorkQueue::getInstance(pool);
+        LL::ThreadPool::ptr_t thread_pool = LL::ThreadPool::getInstance(pool);
+        if (queue && thread_pool)
+        {
+            size_t helpers = llmin(thread_pool->getWidth(), batches->mBatches - 1);
+            for (size_t i = 0; i < helpers; ++i)
+            {
+                // never block on a full queue, the caller does the rest
+                if (!queue->tryPost([batches]() { batches->run(); }))
+                {
+                    break;
+                }
+            }
+        }
+    }
+
+    batches->run();
+    while (batches->mDone < batches->mBatches)
+    {
+        std::this_thread::yield();
+    }
+}
@@ -0,0 +1,51 @@
+/**
+ * @file llparallelfor.h
+ * @brief Fork/join helper spreading a loop across a thread pool
+ *
+ * $LicenseInfo:firstyear=2024&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2024, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#ifndef LL_LLPARALLELFOR_H
+#define LL_LLPARALLELFOR_H
+
+#include <cstddef>
+#include <functional>
+#include <string>
+
+namespace LL
+{
+    /**
+     * Calls func(begin, end) over [0, count) in batches of batch_size and
+     * returns once all of them ran.  The calling thread takes batches too
+     * and helpers are posted to the named thread pool, up to its width.
+     *
+     * The caller only ever waits for batches a helper already started, so
+     * a pool busy with long tasks costs no more than running the loop
+     * inline.  That also makes it safe to call from a worker of that pool.
+     * Without the pool, everything runs on the calling thread.
+     */
+    void parallel_for(size_t count, size_t batch_size,
+                      const std::function<void(size_t begin, size_t end)>& func,
+                      const std::string& pool = "General");
+} // namespace LL
+
+#endif // LL_LLPARALLELFOR_H
@@ -35,6 +35,8 @@
 #include "llsdserialize.h"
 #include "stringize.h"
 
+#include <atomic>
+#include <cstddef>
 #include <limits>
 
 // Defend against a caller forcibly passing a negative number into an unsigned
@@ -77,6 +79,35 @@ S32 sLLSDNetObjects = 0;
 #define ALLOC_LLSD_OBJECT           { llsd::sLLSDNetObjects++;  llsd::sLLSDAllocationCount++;   }
 #define FREE_LLSD_OBJECT            { llsd::sLLSDNetObjects--;                                  }
 
+struct llsd::DocumentArena::Pool
+{
+    explicit Pool(size_t block_size);
+    ~Pool();
+
+    void* allocate(size_t size);
+
+    void acquire() { mRefs.fetch_add(1, std::memory_order_relaxed); }
+    void release()
+    {
+        // last of the scope and the nodes carved out of it
+        if (mRefs.fetch_sub(1, std::memory_order_acq_rel) == 1)
+        {
+            delete this;
+        }
+    }
+
+    static thread_local Pool* sCurrent;
+
+private:
+    void* newBlock(size_t size);
+
+    std::atomic<U32> mRefs;
+    const size_t mBlockSize;
+    std::vector<void*> mBlocks;
+    U8* mCur;
+    U8* mEnd;
+};
+
 class LLSD::Impl
     /**< This class is the abstract base class of the implementation of LLSD
          It provides the reference counting implementation, and the default
@@ -99,11 +130,33 @@ class LLSD::Impl
     bool shared() const                         { return (mUseCount > 1) && (mUseCount != STATIC_USAGE_COUNT); }
 
     U32 mUseCount;
+    llsd::DocumentArena::Pool* mPool;   ///< non-null if allocated from a DocumentArena
 
     const LLSD::map_t& map() const { static const LLSD::map_t empty; return empty; }
     const std::vector<LLSD>& array() const { static const std::vector<LLSD> empty; return empty; }
 
 public:
+    template<class T, typename... ARGS>
+    static T* create(ARGS&&... args)
+        ///< allocate a new impl, from the current DocumentArena if any
+    {
+        llsd::DocumentArena::Pool* pool = llsd::DocumentArena::Pool::sCurrent;
+        if (!pool)
+        {
+            T* impl = new T(std::forward<ARGS>(args)...);
+            ++sAllocationCount;
+            ++sOutstandingCount;
+            return impl;
+        }
+        T* impl = new (pool->allocate(sizeof(T))) T(std::forward<ARGS>(args)...);
+        static_cast<Impl*>(impl)->mPool = pool;
+        pool->acquire();
+        return impl;
+    }
+
+    static void destroy(Impl* impl);
+        ///< counterpart of create()
+
     static void reset(Impl*& var, Impl* impl);
         ///< safely set var to refer to the new impl (possibly shared)
 
@@ -381,10 +434,8 @@ namespace
 
         DataMap mData;
 
-    protected:
-        ImplMap(DataMap data) : mData(std::move(data)) { }
-
     public:
+        ImplMap(DataMap data) : mData(std::move(data)) { }
         ImplMap() = default;
 
         ImplMap& makeMap(LLSD::Impl*&) override;
@@ -424,7 +475,7 @@ namespace
         LL_PROFILE_ZONE_SCOPED_CATEGORY_LLSD;
         if (shared())
         {
-            ImplMap* i = new ImplMap(mData);
+            ImplMap* i = create<ImplMap>(mData);
             Impl::assign(var, i);
             return *i;
         }
@@ -530,10 +581,8 @@ namespace
 
         DataVector mData;
 
-    protected:
-        ImplArray(DataVector data) : mData(std::move(data)) { }
-
     public:
+        ImplArray(DataVector data) : mData(std::move(data)) { }
         ImplArray() = default;
 
         ImplArray& makeArray(Impl*&) override;
@@ -571,7 +620,7 @@ namespace
     {
         if (shared())
         {
-            ImplArray* i = new ImplArray(mData);
+            ImplArray* i = create<ImplArray>(mData);
             Impl::assign(var, i);
             return *i;
         }
@@ -674,20 +723,34 @@ namespace
 }
 
 LLSD::Impl::Impl()
-    : mUseCount(0)
+    : mUseCount(0),
+      mPool(nullptr)
 {
-    ++sAllocationCount;
-    ++sOutstandingCount;
 }
 
 LLSD::Impl::Impl(StaticAllocationMarker)
-    : mUseCount(0)
+    : mUseCount(0),
+      mPool(nullptr)
 {
 }
 
 LLSD::Impl::~Impl()
 {
-    --sOutstandingCount;
+}
+
+void LLSD::Impl::destroy(Impl* impl)
+{
+    llsd::DocumentArena::Pool* pool = impl->mPool;
+    if (pool)
+    {
+        impl->~Impl();
+        pool->release();
+    }
+    else
+    {
+        delete impl;
+        --sOutstandingCount;
+    }
 }
 
 void LLSD::Impl::reset(Impl*& var, Impl* impl)
@@ -700,7 +763,7 @@ void LLSD::Impl::reset(Impl*& var, Impl* impl)
         }
         if (var && var->mUseCount != STATIC_USAGE_COUNT && --var->mUseCount == 0)
         {
-            delete var;
+            destroy(var);
         }
         var = impl;
     }
@@ -712,7 +775,7 @@ void LLSD::Impl::move(Impl*& var, Impl*& impl)
 
     if (var && var->mUseCount != STATIC_USAGE_COUNT && --var->mUseCount == 0)
     {
-        delete var; // destroy var if usage falls to 0 and not static
+        destroy(var); // destroy var if usage falls to 0 and not static
     }
     var = impl; // Steal impl to var without incrementing use since this is a move
     impl = nullptr; // null out old-impl pointer
@@ -733,14 +796,14 @@ const LLSD::Impl& LLSD::Impl::safe(const Impl* impl)
 ImplMap& LLSD::Impl::makeMap(Impl*& var)
 {
     LL_PROFILE_ZONE_SCOPED_CATEGORY_LLSD;
-    ImplMap* im = new ImplMap;
+    ImplMap* im = create<ImplMap>();
     reset(var, im);
     return *im;
 }
 
 ImplArray& LLSD::Impl::makeArray(Impl*& var)
 {
-    ImplArray* ia = new ImplArray;
+    ImplArray* ia = create<ImplArray>();
     reset(var, ia);
     return *ia;
 }
@@ -758,42 +821,42 @@ void LLSD::Impl::assignUndefined(Impl*& var)
 
 void LLSD::Impl::assign(Impl*& var, LLSD::Boolean v)
 {
-    reset(var, new ImplBoolean(v));
+    reset(var, create<ImplBoolean>(v));
 }
 
 void LLSD::Impl::assign(Impl*& var, LLSD::Integer v)
 {
-    reset(var, new ImplInteger(v));
+    reset(var, create<ImplInteger>(v));
 }
 
 void LLSD::Impl::assign(Impl*& var, LLSD::Real v)
 {
-    reset(var, new ImplReal(v));
+    reset(var, create<ImplReal>(v));
 }
 
 void LLSD::Impl::assign(Impl*& var, LLSD::String v)
 {
-    reset(var, new ImplString(std::move(v)));
+    reset(var, create<ImplString>(std::move(v)));
 }
 
 void LLSD::Impl::assign(Impl*& var, LLSD::UUID v)
 {
-    reset(var, new ImplUUID(std::move(v)));
+    reset(var, create<ImplUUID>(std::move(v)));
 }
 
 void LLSD::Impl::assign(Impl*& var, LLSD::Date v)
 {
-    reset(var, new ImplDate(std::move(v)));
+    reset(var, create<ImplDate>(std::move(v)));
 }
 
 void LLSD::Impl::assign(Impl*& var, LLSD::URI v)
 {
-    reset(var, new ImplURI(std::move(v)));
+    reset(var, create<ImplURI>(std::move(v)));
 }
 
 void LLSD::Impl::assign(Impl*& var, LLSD::Binary v)
 {
-    reset(var, new ImplBinary(std::move(v)));
+    reset(var, create<ImplBinary>(std::move(v)));
 }
 
 
@@ -844,6 +907,69 @@ U32 LLSD::Impl::sAllocationCount = 0;
 U32 LLSD::Impl::sOutstandingCount = 0;
 
 
+thread_local llsd::DocumentArena::Pool* llsd::DocumentArena::Pool::sCurrent = nullptr;
+
+llsd::DocumentArena::Pool::Pool(size_t block_size)
+    : mRefs(1),
+      mBlockSize(block_size),
+      mCur(nullptr),
+      mEnd(nullptr)
+{
+}
+
+llsd::DocumentArena::Pool::~Pool()
+{
+    for (void* block : mBlocks)
+    {
+        ::operator delete(block);
+        --LLSD::Impl::sOutstandingCount;
+    }
+}
+
+void* llsd::DocumentArena::Pool::newBlock(size_t size)
+{
+    void* block = ::operator new(size);
+    mBlocks.push_back(block);
+    ++LLSD::Impl::sAllocationCount;
+    ++LLSD::Impl::sOutstandingCount;
+    return block;
+}
+
+void* llsd::DocumentArena::Pool::allocate(size_t size)
+{
+    constexpr size_t ALIGN = alignof(std::max_align_t);
+    size = (size + ALIGN - 1) & ~(ALIGN - 1);
+    if (size > (size_t)(mEnd - mCur))
+    {
+        if (size > mBlockSize / 4)
+        {
+            // Oversized request, give it a block of its own rather than
+            // waste the tail of the current one.
+            return newBlock(size);
+        }
+        mCur = (U8*)newBlock(mBlockSize);
+        mEnd = mCur + mBlockSize;
+    }
+    void* result = mCur;
+    mCur += size;
+    return result;
+}
+
+llsd::DocumentArena::DocumentArena(size_t block_size)
+    : mPool(new Pool(llmax(block_size, (size_t)1024))),
+      mPrevious(Pool::sCurrent)
+{
+    Pool::sCurrent = mPool;
+}
+
+llsd::DocumentArena::~DocumentArena()
+{
+    llassert(Pool::sCurrent == mPool);
+    Pool::sCurrent = mPrevious;
+    mPool->release();
+}
+
+
 
 #ifdef NAME_UNNAMED_NAMESPACE
 namespace LLSDUnnamedNamespace
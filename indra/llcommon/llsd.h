@@ -518,6 +518,47 @@ LL_COMMON_API std::ostream& operator<<(std::ostream& s, const LLSD& llsd);
 namespace llsd
 {
 
+/**
+ * @class DocumentArena
+ * @brief Scoped bump allocator for the LLSD nodes of a freshly parsed document.
+ *
+ * While a DocumentArena is alive, every LLSD value created on the same
+ * thread gets its node carved out of a few large blocks instead of its own
+ * heap allocation. This is meant to wrap a parse of a large document that
+ * is consumed and dropped, e.g.:
+ *
+ *   LLSD mdl;
+ *   {
+ *       llsd::DocumentArena arena;
+ *       LLSDSerialize::fromBinary(mdl, data, size);
+ *   }
+ *
+ * The blocks are released in one go once the arena has gone out of scope
+ * and the last node allocated from it has been destroyed, so values may
+ * safely outlive the arena object itself; any surviving node keeps its
+ * blocks alive. Modifying a shared node after the arena is gone makes the
+ * usual copy-on-write copy, which lands on the normal heap. Arenas nest,
+ * and only affect the thread that created them. Strings, binaries and the
+ * containers' own storage are still heap allocated.
+ */
+class LL_COMMON_API DocumentArena
+{
+public:
+    static const size_t DEFAULT_BLOCK_SIZE = 64 * 1024;
+
+    DocumentArena(size_t block_size = DEFAULT_BLOCK_SIZE);
+    ~DocumentArena();
+
+    DocumentArena(const DocumentArena&) = delete;
+    DocumentArena& operator=(const DocumentArena&) = delete;
+
+    struct Pool;
+
+private:
+    Pool* mPool;
+    Pool* mPrevious;
+};
+
 #ifdef LLSD_DEBUG_INFO
 /** @name Unit Testing Interface */
 //@{
@@ -526,7 +567,9 @@ namespace llsd
     /// @warn THE FOLLOWING COUNTS WILL NOT BE ACCURATE IN A MULTI-THREADED
     /// ENVIRONMENT.
     ///
-    /// These counts track LLSD::Impl (hidden) objects.
+    /// These counts track heap allocations of LLSD::Impl (hidden) objects.
+    /// Impls made under a DocumentArena are not counted individually,
+    /// instead each block of the arena counts as one allocation.
     LL_COMMON_API U32 allocationCount();    ///< how many Impls have been made
     LL_COMMON_API U32 outstandingCount();   ///< how many Impls are still alive
 
@@ -34,10 +34,6 @@
 #include <iostream>
 #include "apr_base64.h"
 
-#include <boost/iostreams/device/array.hpp>
-#include <boost/iostreams/stream.hpp>
-#include <boost/align/aligned_allocator.hpp>
-
 #if defined(LL_USESYSTEMLIBS) || defined(LL_LINUX)
 # include <zlib.h>
 #else
@@ -1278,6 +1274,474 @@ bool LLSDBinaryParser::parseString(
 }
 
 
+/**
+ * LLSDBinaryBufferParser
+ *
+ * Contiguous-buffer counterpart of LLSDBinaryParser. Bounds are checked
+ * with pointer arithmetic against the end of the buffer instead of
+ * through istream state and the max_bytes accounting, strings and
+ * binaries are copied straight out of the buffer, and containers are
+ * reserved from their encoded sizes. Results must match LLSDBinaryParser
+ * for any well formed input; see llsdserialize_test.
+ */
+namespace
+{
+class LLSDBinaryBufferParser
+{
+public:
+    LLSDBinaryBufferParser(const U8* data, size_t size)
+    :   mCur(data),
+        mEnd(data + size)
+    {
+    }
+
+    S32 doParse(LLSD& data, S32 max_depth);
+
+    const U8* getPosition() const { return mCur; }
+
+private:
+    S32 parseMap(LLSD& map, S32 max_depth);
+    S32 parseArray(LLSD& array, S32 max_depth);
+    bool parseString(std::string& value);
+    bool parseStringDelim(std::string& value, char delim);
+
+    size_t remaining() const { return mEnd - mCur; }
+
+    bool readU32(U32& value)
+    {
+        if (remaining() < sizeof(U32))
+        {
+            mCur = mEnd;
+            return false;
+        }
+        U32 value_nbo;
+        memcpy(&value_nbo, mCur, sizeof(U32));
+        mCur += sizeof(U32);
+        value = ntohl(value_nbo);
+        return true;
+    }
+
+    bool readF64(F64& value)
+    {
+        if (remaining() < sizeof(F64))
+        {
+            mCur = mEnd;
+            return false;
+        }
+        memcpy(&value, mCur, sizeof(F64));
+        mCur += sizeof(F64);
+        return true;
+    }
+
+    const U8* mCur;
+    const U8* const mEnd;
+};
+
+S32 LLSDBinaryBufferParser::doParse(LLSD& data, S32 max_depth)
+{
+    LL_PROFILE_ZONE_SCOPED_CATEGORY_LLSD
+    if (mCur >= mEnd)
+    {
+        return 0;
+    }
+    char c = (char)*mCur++;
+    if (max_depth == 0)
+    {
+        return LLSDParser::PARSE_FAILURE;
+    }
+    S32 parse_count = 1;
+    switch(c)
+    {
+    case '{':
+    {
+        S32 child_count = parseMap(data, max_depth - 1);
+        if((child_count == LLSDParser::PARSE_FAILURE) || data.isUndefined())
+        {
+            parse_count = LLSDParser::PARSE_FAILURE;
+        }
+        else
+        {
+            parse_count += child_count;
+        }
+        break;
+    }
+
+    case '[':
+    {
+        S32 child_count = parseArray(data, max_depth - 1);
+        if((child_count == LLSDParser::PARSE_FAILURE) || data.isUndefined())
+        {
+            parse_count = LLSDParser::PARSE_FAILURE;
+        }
+        else
+        {
+            parse_count += child_count;
+        }
+        break;
+    }
+
+    case '!':
+        data.clear();
+        break;
+
+    case '0':
+        data = false;
+        break;
+
+    case '1':
+        data = true;
+        break;
+
+    case 'i':
+    {
+        U32 value = 0;
+        if (readU32(value))
+        {
+            data = (S32)value;
+        }
+        else
+        {
+            parse_count = LLSDParser::PARSE_FAILURE;
+        }
+        break;
+    }
+
+    case 'r':
+    {
+        F64 real_nbo = 0.0;
+        if (readF64(real_nbo))
+        {
+            data = ll_ntohd(real_nbo);
+        }
+        else
+        {
+            parse_count = LLSDParser::PARSE_FAILURE;
+        }
+        break;
+    }
+
+    case 'u':
+    {
+        if (remaining() < UUID_BYTES)
+        {
+            mCur = mEnd;
+            parse_count = LLSDParser::PARSE_FAILURE;
+            break;
+        }
+        LLUUID id;
+        memcpy(id.mData, mCur, UUID_BYTES);
+        mCur += UUID_BYTES;
+        data = id;
+        break;
+    }
+
+    case '\'':
+    case '"':
+    {
+        std::string value;
+        if (parseStringDelim(value, c))
+        {
+            data = std::move(value);
+        }
+        else
+        {
+            parse_count = LLSDParser::PARSE_FAILURE;
+        }
+        break;
+    }
+
+    case 's':
+    {
+        std::string value;
+        if (parseString(value))
+        {
+            data = std::move(value);
+        }
+        else
+        {
+            parse_count = LLSDParser::PARSE_FAILURE;
+        }
+        break;
+    }
+
+    case 'l':
+    {
+        std::string value;
+        if (parseString(value))
+        {
+            data = LLURI(value);
+        }
+        else
+        {
+            parse_count = LLSDParser::PARSE_FAILURE;
+        }
+        break;
+    }
+
+    case 'd':
+    {
+        F64 real = 0.0;
+        if (readF64(real))
+        {
+            data = LLDate(real);
+        }
+        else
+        {
+            parse_count = LLSDParser::PARSE_FAILURE;
+        }
+        break;
+    }
+
+    case 'b':
+    {
+        U32 size_nbo = 0;
+        if (!readU32(size_nbo))
+        {
+            parse_count = LLSDParser::PARSE_FAILURE;
+            break;
+        }
+        // Like the stream parser, a negative size yields an empty binary
+        S32 size = (S32)size_nbo;
+        if (size > 0 && (size_t)size > remaining())
+        {
+            parse_count = LLSDParser::PARSE_FAILURE;
+            break;
+        }
+        LLSD::Binary value;
+        if (size > 0)
+        {
+            value.assign(mCur, mCur + size);
+            mCur += size;
+        }
+        data = std::move(value);
+        break;
+    }
+
+    default:
+        parse_count = LLSDParser::PARSE_FAILURE;
+        LL_INFOS() << "Unrecognized character while parsing: int(" << int(c)
+            << ")" << LL_ENDL;
+        break;
+    }
+    if(LLSDParser::PARSE_FAILURE == parse_count)
+    {
+        data.clear();
+    }
+    return parse_count;
+}
+
+S32 LLSDBinaryBufferParser::parseMap(LLSD& map, S32 max_depth)
+{
+    map = LLSD::emptyMap();
+    U32 size_nbo = 0;
+    if (!readU32(size_nbo) || mCur >= mEnd)
+    {
+        return LLSDParser::PARSE_FAILURE;
+    }
+    S32 size = (S32)size_nbo;
+
+    // Every entry takes at least a key byte and a value byte, so a
+    // corrupt size can not make us reserve more than the input warrants.
+    LLSD::map_t& entries = map.asMap();
+    if (size > 0)
+    {
+        entries.reserve(llmin((size_t)size, remaining() / 2));
+    }
+
+    S32 parse_count = 0;
+    S32 count = 0;
+    char c = (char)*mCur++;
+    while(c != '}' && (count < size))
+    {
+        std::string name;
+        switch(c)
+        {
+        case 'k':
+            if(!parseString(name))
+            {
+                return LLSDParser::PARSE_FAILURE;
+            }
+            break;
+        case '\'':
+        case '"':
+            if(!parseStringDelim(name, c))
+            {
+                return LLSDParser::PARSE_FAILURE;
+            }
+            break;
+        }
+        LLSD child;
+        S32 child_count = doParse(child, max_depth);
+        if(child_count > 0)
+        {
+            // There must be a value for every key, thus child_count
+            // must be greater than 0.
+            parse_count += child_count;
+            entries.emplace(std::move(name), std::move(child));
+        }
+        else
+        {
+            return LLSDParser::PARSE_FAILURE;
+        }
+        ++count;
+        if (mCur >= mEnd)
+        {
+            return LLSDParser::PARSE_FAILURE;
+        }
+        c = (char)*mCur++;
+    }
+    if((c != '}') || (count < size))
+    {
+        // Make sure it is correctly terminated and we parsed as many
+        // as were said to be there.
+        return LLSDParser::PARSE_FAILURE;
+    }
+    return parse_count;
+}
+
+S32 LLSDBinaryBufferParser::parseArray(LLSD& array, S32 max_depth)
+{
+    array = LLSD::emptyArray();
+    U32 size_nbo = 0;
+    if (!readU32(size_nbo))
+    {
+        return LLSDParser::PARSE_FAILURE;
+    }
+    S32 size = (S32)size_nbo;
+
+    // Every element takes at least one byte
+    LLSD::array_t& elements = array.asArray();
+    if (size > 0)
+    {
+        elements.reserve(llmin((size_t)size, remaining()));
+    }
+
+    S32 parse_count = 0;
+    S32 count = 0;
+    while((mCur < mEnd) && ((char)*mCur != ']') && (count < size))
+    {
+        // Parse in place rather than copying a temporary into the array
+        elements.emplace_back();
+        S32 child_count = doParse(elements.back(), max_depth);
+        if(child_count <= 0)
+        {
+            return LLSDParser::PARSE_FAILURE;
+        }
+        parse_count += child_count;
+        ++count;
+    }
+    if((mCur >= mEnd) || ((char)*mCur++ != ']') || (count < size))
+    {
+        // Make sure it is correctly terminated and we parsed as many
+        // as were said to be there.
+        return LLSDParser::PARSE_FAILURE;
+    }
+    return parse_count;
+}
+
+bool LLSDBinaryBufferParser::parseString(std::string& value)
+{
+    U32 size_nbo = 0;
+    if (!readU32(size_nbo))
+    {
+        return false;
+    }
+    S32 size = (S32)size_nbo;
+    if (size < 0 || (size_t)size > remaining())
+    {
+        return false;
+    }
+    value.assign((const char*)mCur, size);
+    mCur += size;
+    return true;
+}
+
+bool LLSDBinaryBufferParser::parseStringDelim(std::string& value, char delim)
+{
+    // Same escapes as deserialize_string_delim(), copying unescaped runs
+    // in one go.
+    value.clear();
+    while (mCur < mEnd)
+    {
+        const U8* run = mCur;
+        while (mCur < mEnd && (char)*mCur != delim && (char)*mCur != '\\')
+        {
+            ++mCur;
+        }
+        value.append((const char*)run, mCur - run);
+        if (mCur >= mEnd)
+        {
+            break;
+        }
+        if ((char)*mCur++ == delim)
+        {
+            return true;
+        }
+
+        // escape sequence
+        if (mCur >= mEnd)
+        {
+            break;
+        }
+        char next_char = (char)*mCur++;
+        switch(next_char)
+        {
+        case 'x':
+        {
+            if (remaining() < 2)
+            {
+                mCur = mEnd;
+                return false;
+            }
+            U8 byte = hex_as_nybble((char)mCur[0]) << 4;
+            byte |= hex_as_nybble((char)mCur[1]);
+            mCur += 2;
+            value.push_back((char)byte);
+            break;
+        }
+        case 'a':
+            value.push_back('\a');
+            break;
+        case 'b':
+            value.push_back('\b');
+            break;
+        case 'f':
+            value.push_back('\f');
+            break;
+        case 'n':
+            value.push_back('\n');
+            break;
+        case 'r':
+            value.push_back('\r');
+            break;
+        case 't':
+            value.push_back('\t');
+            break;
+        case 'v':
+            value.push_back('\v');
+            break;
+        default:
+            value.push_back(next_char);
+            break;
+        }
+    }
+    return false;
+}
+} // anonymous namespace
+
+// static
+S32 LLSDSerialize::fromBinary(LLSD& sd, const U8* data, size_t size, S32 max_depth, size_t* bytes_read)
+{
+    LLSDBinaryBufferParser parser(data, size);
+    S32 count = parser.doParse(sd, max_depth);
+    if (bytes_read)
+    {
+        *bytes_read = parser.getPosition() - data;
+    }
+    return count;
+}
+
+
 /**
  * LLSDFormatter
  */
@@ -2262,29 +2726,62 @@ LLUZipHelper::EZipRresult LLUZipHelper::unzip_llsd(LLSD& data, std::istream& is,
 
 LLUZipHelper::EZipRresult LLUZipHelper::unzip_llsd(LLSD& data, const U8* in, S32 size)
 {
-    U8* result = NULL;
-    llssize cur_size = 0;
-    z_stream strm;
+    std::vector<U8> result;
+    EZipRresult ret = unzip_buffer(result, in, size);
+    if (ret != ZR_OK)
+    {
+        return ret;
+    }
 
-    constexpr llssize CHUNK = (1024 * 1024) * 10;
+    //result now holds the decompressed LLSD block
+    llssize cur_size = result.size();
+    char* result_ptr = strip_deprecated_header((char*)result.data(), cur_size);
 
-    static thread_local std::vector<U8, boost::alignment::aligned_allocator<U8, 16>> out;
-    if (out.empty())
+    if (LLSDSerialize::fromBinary(data, (const U8*)result_ptr, cur_size, UNZIP_LLSD_MAX_DEPTH) <= 0)
     {
-        out.resize(CHUNK);
+        return ZR_PARSE_ERROR;
     }
+    return ZR_OK;
+}
 
+LLUZipHelper::EZipRresult LLUZipHelper::unzip_buffer(std::vector<U8>& out, const U8* in, S32 size)
+{
+    z_stream strm;
     strm.zalloc = Z_NULL;
     strm.zfree = Z_NULL;
     strm.opaque = Z_NULL;
     strm.avail_in = size;
     strm.next_in = const_cast<U8*>(in);
 
+    // Inflate straight into out, growing it as needed. Mesh and material
+    // blocks typically compress 3-5x, so start from there.
+    size_t have = 0;
+    try
+    {
+        out.resize(llmax((size_t)size * 4, (size_t)4096));
+    }
+    catch (const std::bad_alloc&)
+    {
+        return ZR_MEM_ERROR;
+    }
+
     S32 ret = inflateInit2(&strm, MAX_WBITS);
     do
     {
-        strm.avail_out = CHUNK;
-        strm.next_out = out.data();
+        if (have == out.size())
+        {
+            try
+            {
+                out.resize(out.size() * 2);
+            }
+            catch (const std::bad_alloc&)
+            {
+                inflateEnd(&strm);
+                return ZR_MEM_ERROR;
+            }
+        }
+        strm.avail_out = (uInt)llmin(out.size() - have, (size_t)U32_MAX);
+        strm.next_out = out.data() + have;
         ret = inflate(&strm, Z_NO_FLUSH);
         switch (ret)
         {
@@ -2292,41 +2789,22 @@ LLUZipHelper::EZipRresult LLUZipHelper::unzip_llsd(LLSD& data, const U8* in, S32
         case Z_DATA_ERROR:
         {
             inflateEnd(&strm);
-            free(result);
             return ZR_DATA_ERROR;
         }
         case Z_STREAM_ERROR:
         {
             inflateEnd(&strm);
-            free(result);
             return ZR_BUFFER_ERROR;
         }
 
         case Z_MEM_ERROR:
         {
             inflateEnd(&strm);
-            free(result);
             return ZR_MEM_ERROR;
         }
         }
 
-        llssize have = CHUNK-strm.avail_out;
-        if (have > 0)
-        {
-            U8* new_result = (U8*)realloc(result, cur_size + have);
-            if (new_result == NULL)
-            {
-                inflateEnd(&strm);
-                if (result)
-                {
-                    free(result);
-                }
-                return ZR_MEM_ERROR;
-            }
-            result = new_result;
-            memcpy(result + cur_size, out.data(), have);
-            cur_size += have;
-        }
+        have = strm.next_out - out.data();
 
     } while (strm.avail_out == 0 && ret != Z_STREAM_END);
 
@@ -2334,24 +2812,10 @@ LLUZipHelper::EZipRresult LLUZipHelper::unzip_llsd(LLSD& data, const U8* in, S32
 
     if (ret != Z_STREAM_END)
     {
-        free(result);
         return ZR_DATA_ERROR;
     }
 
-    //result now points to the decompressed LLSD block
-    {
-        char* result_ptr = strip_deprecated_header((char*)result, cur_size);
-
-        boost::iostreams::stream<boost::iostreams::array_source> istrm(result_ptr, cur_size);
-
-        if (!LLSDSerialize::fromBinary(data, istrm, cur_size, UNZIP_LLSD_MAX_DEPTH))
-        {
-            free(result);
-            return ZR_PARSE_ERROR;
-        }
-    }
-
-    free(result);
+    out.resize(have);
     return ZR_OK;
 }
 //This unzip function will only work with a gzip header and trailer - while the contents
@@ -847,6 +847,29 @@ class LL_COMMON_API LLSDSerialize
         (void)p->parse(str, sd, max_bytes, max_depth);
         return sd;
     }
+
+    /**
+     * @brief Parse binary LLSD straight out of a contiguous buffer.
+     *
+     * Equivalent to the stream overloads but skips the istream machinery
+     * entirely, which matters for large documents such as mesh headers
+     * and decompressed asset payloads that are already in memory.
+     * @param sd The LLSD to populate.
+     * @param data The start of the serialized document.
+     * @param size The number of readable bytes at data.
+     * @param max_depth Maximum nesting depth, -1 for unlimited.
+     * @param bytes_read If not null, set to the number of bytes consumed.
+     * @return Returns the number of LLSD objects parsed into sd, or
+     * PARSE_FAILURE (-1) on failure, in which case sd is undefined.
+     */
+    static S32 fromBinary(LLSD& sd, const U8* data, size_t size, S32 max_depth = -1,
+                          size_t* bytes_read = nullptr);
+    static LLSD fromBinary(const U8* data, size_t size, S32 max_depth = -1)
+    {
+        LLSD sd;
+        (void)fromBinary(sd, data, size, max_depth);
+        return sd;
+    }
 };
 
 class LL_COMMON_API LLUZipHelper : public LLRefCount
@@ -865,6 +888,8 @@ class LL_COMMON_API LLUZipHelper : public LLRefCount
     // return OK or reason for failure
     static EZipRresult unzip_llsd(LLSD& data, std::istream& is, S32 size);
     static EZipRresult unzip_llsd(LLSD& data, const U8* in, S32 size);
+    // inflate a zlib block into out without parsing it
+    static EZipRresult unzip_buffer(std::vector<U8>& out, const U8* in, S32 size);
 };
 
 //dirty little zip functions -- yell at davep
@@ -27,6 +27,7 @@
 
 #include <vector>
 #include <stdexcept>
+#include <thread>
 
 #include "linden_common.h"
 
@@ -34,8 +35,11 @@
 
 #include "../llerrorcontrol.h"
 #include "../llsd.h"
+#include "../llstring.h"
+#include "../lltimer.h"
 
 #include "../test/lltut.h"
+#include "../test/namedtempfile.h"
 
 enum LogFieldIndex
 {
@@ -933,6 +937,128 @@ namespace tut
     }
 }
 
+namespace
+{
+    void writeAsyncMessages(int count)
+    {
+        for (int i = 0; i < count; ++i)
+        {
+            LL_INFOS() << "async " << i << LL_ENDL;
+        }
+    }
+}
+
+namespace tut
+{
+    template<> template<>
+    void ErrorTestObject::test<19>()
+        // asynchronous logging keeps the order and flushes before an error
+    {
+        U64 overflows = LLError::getAsyncLogOverflowCount();
+        LLError::setAsyncLogging(true);
+        ensure("async logging on", LLError::getAsyncLogging());
+
+        writeAsyncMessages(10);
+        LLError::flushAsyncLogging();
+        for (int i = 0; i < 10; ++i)
+        {
+            ensure_message_field_equals(i, MSG_FIELD, llformat("async %d", i));
+        }
+        ensure_message_count(10);
+
+        writeAsyncMessages(3);
+        fatalWasCalled = false;
+        CATCH(LL_ERRS(), "fatal");
+        ensure("fatal callback called", fatalWasCalled);
+        ensure_message_field_equals(10, MSG_FIELD, "async 0");
+        ensure_message_field_equals(12, MSG_FIELD, "async 2");
+        ensure_message_field_equals(13, LEVEL_FIELD, "ERROR");
+        ensure_message_count(14);
+
+        writeAsyncMessages(5);
+        LLError::setAsyncLogging(false);
+        ensure("async logging off", !LLError::getAsyncLogging());
+        ensure_message_field_equals(18, MSG_FIELD, "async 4");
+        ensure_message_count(19);
+        ensure_equals("overflows", LLError::getAsyncLogOverflowCount(), overflows);
+    }
+
+    template<> template<>
+    void ErrorTestObject::test<20>()
+        // log calls per second from eight threads into a file
+    {
+        if (LLStringUtil::getenv("LL_BENCHMARK").empty())
+        {
+            skip("set LL_BENCHMARK to run");
+        }
+
+        const int THREADS = 8;
+        const int MESSAGES = 20000;
+        NamedTempFile file("log", "");
+        LLError::setAlwaysFlush(true);
+        LLError::logToFile(file.getName());
+
+        auto run = []()
+        {
+            LLTimer timer;
+            std::vector<std::thread> threads;
+            for (int i = 0; i < THREADS; ++i)
+            {
+                threads.emplace_back([]() { writeAsyncMessages(MESSAGES); });
+            }
+            for (std::thread& thread : threads)
+            {
+                thread.join();
+            }
+            return timer.getElapsedTimeF64();
+        };
+
+        F64 sync_secs = run();
+        clearMessages();
+
+        U64 overflows = LLError::getAsyncLogOverflowCount();
+        LLError::setAsyncLogging(true);
+        F64 async_secs = run();
+        LLError::setAsyncLogging(false);
+        overflows = LLError::getAsyncLogOverflowCount() - overflows;
+
+        // a full ring falls back to a synchronous write, nothing is lost
+        int written = 0;
+        for (int i = 0; i < countMessages(); ++i)
+        {
+            if (message(i).find(": async ") != std::string::npos)
+            {
+                ++written;
+            }
+        }
+        ensure_equals("written", written, THREADS * MESSAGES);
+
+        LLError::logToFile("");
+
+        const F64 calls = THREADS * MESSAGES;
+        std::cout << "\n" << THREADS << " threads: synchronous " << (U64)(calls / sync_secs)
+                  << " calls/s, asynchronous " << (U64)(calls / async_secs)
+                  << " calls/s, " << overflows << " written synchronously" << std::endl;
+    }
+
+    template<> template<>
+    void ErrorTestObject::test<21>()
+        // a full ring falls back to synchronous writes without losing or
+        // reordering messages, and turning async off writes out the rest
+    {
+        const int MESSAGES = 5000; // several rings' worth
+        LLError::setAsyncLogging(true);
+        writeAsyncMessages(MESSAGES);
+        LLError::setAsyncLogging(false);
+
+        ensure_message_count(MESSAGES);
+        for (int i = 0; i < MESSAGES; ++i)
+        {
+            ensure_message_field_equals(i, MSG_FIELD, llformat("async %d", i));
+        }
+    }
+}
+
 /* Tests left:
     handling of classes without LOG_CLASS
 
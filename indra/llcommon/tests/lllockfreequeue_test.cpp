@@ -0,0 +1,104 @@
+/**
+ * @file   lllockfreequeue_test.cpp
+ * @date   2024-05-14
+ * @brief  Test for lllockfreequeue.
+ *
+ * $LicenseInfo:firstyear=2024&license=viewerlgpl$
+ * Copyright (c) 2024, Linden Research, Inc.
+ * $/LicenseInfo$
+ */
+
+// Precompiled header
+#include "linden_common.h"
+// associated header
+#include "lllockfreequeue.h"
+// STL headers
+#include <memory>
+#include <vector>
+// std headers
+#include <thread>
+// external library headers
+// other Linden headers
+#include "../test/lltut.h"
+
+/*****************************************************************************
+*   TUT
+*****************************************************************************/
+namespace tut
+{
+    struct lllockfreequeue_data
+    {
+    };
+    typedef test_group<lllockfreequeue_data> lllockfreequeue_group;
+    typedef lllockfreequeue_group::object object;
+    lllockfreequeue_group lllockfreequeuegrp("lllockfreequeue");
+
+    template<> template<>
+    void object::test<1>()
+    {
+        set_test_name("push order");
+        LLLockFreeQueue<std::unique_ptr<int>> queue;
+        ensure("new queue not empty", queue.empty());
+        for (int i = 0; i < 5; ++i)
+        {
+            queue.push(std::make_unique<int>(i));
+        }
+        ensure_equals("size", queue.size(), 5);
+
+        std::vector<std::unique_ptr<int>> out;
+        ensure_equals("popped", queue.popAll(out), 5);
+        ensure("drained queue not empty", queue.empty());
+        ensure_equals("size after drain", queue.size(), 0);
+        for (int i = 0; i < 5; ++i)
+        {
+            ensure_equals("order", *out[i], i);
+        }
+        ensure_equals("pop empty", queue.popAll(out), 0);
+
+        // leftovers are destroyed with the queue
+        queue.push(std::make_unique<int>(42));
+    }
+
+    template<> template<>
+    void object::test<2>()
+    {
+        set_test_name("concurrent producers");
+        const int PRODUCERS = 4;
+        const int ITEMS = 10000;
+        LLLockFreeQueue<std::pair<int, int>> queue;
+
+        std::vector<std::thread> producers;
+        for (int p = 0; p < PRODUCERS; ++p)
+        {
+            producers.emplace_back([&queue, p]()
+                {
+                    for (int i = 0; i < ITEMS; ++i)
+                    {
+                        queue.push(std::make_pair(p, i));
+                    }
+                });
+        }
+
+        // consume while the producers are still running
+        std::vector<std::pair<int, int>> out;
+        std::vector<int> next(PRODUCERS, 0);
+        size_t total = 0;
+        while (total < size_t(PRODUCERS * ITEMS))
+        {
+            out.clear();
+            total += queue.popAll(out);
+            for (const auto& item : out)
+            {
+                // each producer's items must arrive in the order pushed
+                ensure_equals("per-producer order", item.second, next[item.first]);
+                ++next[item.first];
+            }
+        }
+
+        for (auto& thread : producers)
+        {
+            thread.join();
+        }
+        ensure("queue not empty", queue.empty());
+    }
+} // namespace tut
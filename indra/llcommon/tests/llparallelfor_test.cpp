@@ -0,0 +1,112 @@
+/**
+ * @file   llparallelfor_test.cpp
+ * @date   2024-06-03
+ * @brief  Test for llparallelfor.
+ *
+ * $LicenseInfo:firstyear=2024&license=viewerlgpl$
+ * Copyright (c) 2024, Linden Research, Inc.
+ * $/LicenseInfo$
+ */
+
+// Precompiled header
+#include "linden_common.h"
+// associated header
+#include "llparallelfor.h"
+// STL headers
+#include <atomic>
+#include <set>
+#include <vector>
+// std headers
+#include <mutex>
+#include <thread>
+// external library headers
+// other Linden headers
+#include "threadpool.h"
+#include "../test/lltut.h"
+
+/*****************************************************************************
+*   TUT
+*****************************************************************************/
+namespace tut
+{
+    struct llparallelfor_data
+    {
+        // checks every index in [0, count) is visited exactly once
+        void check(size_t count, size_t batch_size, const std::string& pool)
+        {
+            std::vector<std::atomic<int>> visits(count);
+            LL::parallel_for(count, batch_size, [&visits](size_t begin, size_t end)
+                {
+                    for (size_t i = begin; i < end; ++i)
+                    {
+                        visits[i]++;
+                    }
+                }, pool);
+            for (size_t i = 0; i < count; ++i)
+            {
+                ensure_equals("visits", visits[i].load(), 1);
+            }
+        }
+    };
+    typedef test_group<llparallelfor_data> llparallelfor_group;
+    typedef llparallelfor_group::object object;
+    llparallelfor_group llparallelforgrp("llparallelfor");
+
+    template<> template<>
+    void object::test<1>()
+    {
+        set_test_name("no pool");
+        check(0, 4, "NoSuchPool");
+        check(1, 4, "NoSuchPool");
+        check(1000, 7, "NoSuchPool");
+        check(10, 0, "NoSuchPool");
+    }
+
+    template<> template<>
+    void object::test<2>()
+    {
+        set_test_name("pool");
+        LL::ThreadPool pool("ParallelForTest", 3);
+        pool.start();
+
+        check(1, 1, "ParallelForTest");
+        check(3, 1, "ParallelForTest");
+        check(100000, 16, "ParallelForTest");
+
+        // batches run on more than one thread when they take long enough
+        std::mutex mutex;
+        std::set<std::thread::id> threads;
+        LL::parallel_for(64, 1, [&mutex, &threads](size_t, size_t)
+            {
+                std::this_thread::sleep_for(std::chrono::milliseconds(2));
+                std::lock_guard<std::mutex> lock(mutex);
+                threads.insert(std::this_thread::get_id());
+            }, "ParallelForTest");
+        ensure("helpers ran", threads.size() > 1);
+
+        pool.close();
+    }
+
+    template<> template<>
+    void object::test<3>()
+    {
+        set_test_name("busy pool");
+        LL::ThreadPool pool("ParallelForBusy", 1);
+        pool.start();
+
+        // the only worker is stuck until the loop finishes, the caller must
+        // not wait for the helper it posted
+        std::atomic<bool> release(false);
+        pool.getQueue().post([&release]()
+            {
+                while (!release)
+                {
+                    std::this_thread::yield();
+                }
+            });
+        check(1000, 10, "ParallelForBusy");
+        release = true;
+
+        pool.close();
+    }
+} // namespace tut
@@ -51,6 +51,7 @@ typedef U32 uint32_t;
 #include "llsdutil.h"
 #include "llformat.h"
 #include "llmemorystream.h"
+#include "lltimer.h"
 
 #include "../test/hexdump.h"
 #include "../test/lltut.h"
@@ -1267,6 +1268,25 @@ namespace tut
     {
     public:
         TestLLSDBinaryParsing() {}
+
+        // Every binary parse case is also run through the buffer parser,
+        // which has to agree with the stream parser on both value and count.
+        void ensureParse(
+            const std::string& msg,
+            const std::string& in,
+            const LLSD& expected_value,
+            S32 expected_count,
+            S32 depth_limit = -1)
+        {
+            TestLLSDParsing<LLSDBinaryParser>::ensureParse(
+                msg, in, expected_value, expected_count, depth_limit);
+
+            LLSD parsed_result;
+            S32 parsed_count = LLSDSerialize::fromBinary(
+                parsed_result, (const U8*)in.data(), in.size(), depth_limit);
+            ensure_equals(msg + " (buffer)", parsed_result, expected_value);
+            ensure_equals(msg + " (buffer count)", parsed_count, expected_count);
+        }
     };
 
     typedef tut::test_group<TestLLSDBinaryParsing> TestLLSDBinaryParsingGroup;
@@ -1584,12 +1604,130 @@ namespace tut
             1);
     }
 
-/*
     template<> template<>
     void TestLLSDBinaryParsingObject::test<11>()
     {
+        set_test_name("buffer parser round trip");
+
+        LLSD::Binary bin;
+        for (U8 i = 0; i < 200; ++i)
+        {
+            bin.push_back(i);
+        }
+        LLSD nested;
+        nested["uuid"] = LLUUID("3c115e51-04f4-523c-9fa6-98aff1034730");
+        nested["date"] = LLDate(1230443000.5);
+        nested["uri"] = LLURI("http://secondlife.com/");
+        nested["real"] = -0.28969181;
+        nested["int"] = -2147483647;
+        nested["binary"] = bin;
+        nested["empty"] = LLSD::emptyArray();
+        LLSD doc;
+        doc["string"] = std::string("embedded \0 and \n\t\\'\" quotes", 27);
+        doc["undef"] = LLSD();
+        doc["bools"].append(true);
+        doc["bools"].append(false);
+        doc["nested"].append(nested);
+        doc["nested"].append(nested);
+
+        std::ostringstream ostr;
+        LLSDSerialize::toBinary(doc, ostr);
+        std::string bytes = ostr.str();
+        // trailing data after the document must be left alone
+        std::string padded = bytes + "trailing";
+
+        LLSD parsed;
+        size_t bytes_read = 0;
+        S32 count = LLSDSerialize::fromBinary(
+            parsed, (const U8*)padded.data(), padded.size(), -1, &bytes_read);
+        ensure("buffer parse succeeded", count > 0);
+        ensure_equals("buffer round trip", parsed, doc);
+        ensure_equals("bytes read", bytes_read, bytes.size());
+
+        std::istringstream istr(bytes);
+        LLSD stream_parsed;
+        S32 stream_count = LLSDSerialize::fromBinary(stream_parsed, istr, bytes.size());
+        ensure_equals("same count as stream parser", count, stream_count);
+
+        // every proper prefix of the document is malformed
+        for (size_t len = 0; len < bytes.size(); len += 7)
+        {
+            LLSD truncated;
+            S32 truncated_count = LLSDSerialize::fromBinary(
+                truncated, (const U8*)bytes.data(), len);
+            ensure(STRINGIZE("truncated at " << len), truncated_count <= 0);
+            ensure(STRINGIZE("truncated at " << len << " is undefined"), truncated.isUndefined());
+        }
+
+        ensure_equals("depth limit", LLSDSerialize::fromBinary(
+            parsed, (const U8*)bytes.data(), bytes.size(), 2), LLSDParser::PARSE_FAILURE);
+    }
+
+    template<> template<>
+    void TestLLSDBinaryParsingObject::test<12>()
+    {
+        set_test_name("buffer vs stream parser throughput");
+
+        if (LLStringUtil::getenv("LL_BENCHMARK").empty())
+        {
+            skip("set LL_BENCHMARK to run");
+        }
+
+        // Roughly the shape of a large mesh header followed by an
+        // inventory fetch response: a few big binary blobs plus many
+        // small maps of short strings and UUIDs.
+        LLSD doc;
+        LLSD::Binary blob(256 * 1024);
+        for (size_t i = 0; i < blob.size(); ++i)
+        {
+            blob[i] = (U8)(i * 31);
+        }
+        for (S32 lod = 0; lod < 4; ++lod)
+        {
+            LLSD& submesh = doc["lod"][lod];
+            submesh["offset"] = lod * (S32)blob.size();
+            submesh["size"] = (S32)blob.size();
+            submesh["data"] = blob;
+        }
+        for (S32 i = 0; i < 50000; ++i)
+        {
+            LLSD item;
+            item["item_id"] = LLUUID::generateNewID();
+            item["parent_id"] = LLUUID::generateNewID();
+            item["name"] = llformat("Inventory item %d", i);
+            item["desc"] = "(No Description)";
+            item["flags"] = i;
+            item["created_at"] = LLDate((F64)(1230443000 + i));
+            doc["items"].append(item);
+        }
+
+        std::ostringstream ostr;
+        LLSDSerialize::toBinary(doc, ostr);
+        const std::string bytes = ostr.str();
+
+        const S32 ITERATIONS = 10;
+        LLTimer timer;
+        for (S32 i = 0; i < ITERATIONS; ++i)
+        {
+            std::istringstream istr(bytes);
+            LLSD parsed;
+            LLSDSerialize::fromBinary(parsed, istr, bytes.size());
+        }
+        F64 stream_secs = timer.getElapsedTimeF64();
+
+        timer.reset();
+        for (S32 i = 0; i < ITERATIONS; ++i)
+        {
+            LLSD parsed;
+            LLSDSerialize::fromBinary(parsed, (const U8*)bytes.data(), bytes.size());
+        }
+        F64 buffer_secs = timer.getElapsedTimeF64();
+
+        F64 mb = (F64)bytes.size() * ITERATIONS / (1024.0 * 1024.0);
+        LL_INFOS() << "binary LLSD parse, " << bytes.size() << " bytes: stream "
+                   << mb / llmax(stream_secs, 1e-6) << " MB/s, buffer "
+                   << mb / llmax(buffer_secs, 1e-6) << " MB/s" << LL_ENDL;
     }
-*/
 
    /**
      * @class TestLLSDCrossCompatible
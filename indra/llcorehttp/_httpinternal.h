@@ -160,9 +160,15 @@ const long HTTP_THROTTLE_RATE_DEFAULT = 0L;
 // Tuning parameters
 
 // Time worker thread sleeps after a pass through the
-// request, ready and active queues.
+// request, ready and active queues.  The sleep ends early
+// on transport activity or a request queue write.
 const int HTTP_SERVICE_LOOP_SLEEP_NORMAL_MS = 2;
 
+// Longest wait on transport activity while requests are
+// active.  Only a safety net, libcurl's own timeouts and
+// socket activity normally end the wait well before.
+const int HTTP_SERVICE_LOOP_WAIT_MAX_MS = 50;
+
 // Block allocation size (a tuning parameter) is found
 // in bufferarray.h.
 
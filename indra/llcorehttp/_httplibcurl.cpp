@@ -30,8 +30,15 @@
 #include "bufferarray.h"
 #include "_httpoprequest.h"
 #include "_httppolicy.h"
+#include "httpstats.h"
 
 #include "llhttpconstants.h"
+#include "lltimer.h"
+
+#if ! HTTP_CURL_MULTI_POLL && ! LL_WINDOWS
+#include <fcntl.h>
+#include <unistd.h>
+#endif
 
 namespace
 {
@@ -40,6 +47,16 @@ namespace
 void check_curl_multi_code(CURLMcode code);
 void check_curl_multi_code(CURLMcode code, int curl_setopt_option);
 
+// Append the sockets libcurl wants watched for a multi handle.
+// False when it has none to offer yet (resolving, connecting).
+bool append_wait_fds(CURLM * multi_handle, std::vector<curl_waitfd> & fds);
+
+#if ! HTTP_CURL_MULTI_POLL
+// Non-blocking socket pair written to by wakeup(), [0] is the read end
+bool open_wakeup_pair(curl_socket_t socks[2]);
+void close_wakeup_pair(curl_socket_t socks[2]);
+#endif
+
 // This is a template because different 'option' values require different
 // types for 'ARG'. Just pass them through unchanged (by value).
 template <typename ARG>
@@ -64,8 +81,13 @@ HttpLibcurl::HttpLibcurl(HttpService * service)
       mPolicyCount(0),
       mMultiHandles(NULL),
       mActiveHandles(NULL),
-      mDirtyPolicy(NULL)
-{}
+      mDirtyPolicy(NULL),
+      mPollHandle(NULL)
+{
+#if ! HTTP_CURL_MULTI_POLL
+    mWakeupSockets[0] = mWakeupSockets[1] = CURL_SOCKET_BAD;
+#endif
+}
 
 
 HttpLibcurl::~HttpLibcurl()
@@ -107,6 +129,19 @@ void HttpLibcurl::shutdown()
         mDirtyPolicy = NULL;
     }
 
+    {
+        LLCoreInt::HttpScopedLock lock(mPollMutex);
+
+        if (mPollHandle)
+        {
+            curl_multi_cleanup(mPollHandle);
+            mPollHandle = NULL;
+        }
+#if ! HTTP_CURL_MULTI_POLL
+        close_wakeup_pair(mWakeupSockets);
+#endif
+    }
+
     mPolicyCount = 0;
 }
 
@@ -133,6 +168,23 @@ void HttpLibcurl::start(int policy_count)
         mDirtyPolicy[policy_class] = false;
         policyUpdated(policy_class);
     }
+
+    LLCoreInt::HttpScopedLock lock(mPollMutex);
+
+    mPollHandle = curl_multi_init();
+#if ! HTTP_CURL_MULTI_POLL
+    if (mPollHandle && ! open_wakeup_pair(mWakeupSockets))
+    {
+        curl_multi_cleanup(mPollHandle);
+        mPollHandle = NULL;
+    }
+#endif
+    if (! mPollHandle)
+    {
+        // Not fatal, waitForActivity() falls back to sleeping
+        LL_WARNS(LOG_CORE) << "Failed to set up transport wait, HTTP service will poll."
+                           << LL_ENDL;
+    }
 }
 
 
@@ -141,7 +193,8 @@ void HttpLibcurl::start(int policy_count)
 //
 // If active list goes empty *and* we didn't queue any
 // requests for retry, we return a request for a hard
-// sleep otherwise ask for a normal polling interval.
+// sleep.  If anything completed we ask for another pass
+// right away, otherwise to wait on the active requests.
 HttpService::ELoopSpeed HttpLibcurl::processTransport()
 {
     LL_PROFILE_ZONE_SCOPED_CATEGORY_NETWORK;
@@ -190,7 +243,7 @@ HttpService::ELoopSpeed HttpLibcurl::processTransport()
 
                     completeRequest(mMultiHandles[policy_class], handle, result);
                     handle = NULL;                  // No longer valid on return
-                    ret = HttpService::NORMAL;      // If anything completes, we may have a free slot.
+                    ret = HttpService::IMMEDIATE;   // If anything completes, we may have a free slot.
                                                     // Turning around quickly reduces connection gap by 7-10mS.
                 }
                 else if (CURLMSG_NONE == msg->msg)
@@ -211,12 +264,99 @@ HttpService::ELoopSpeed HttpLibcurl::processTransport()
 
     if (! mActiveOps.empty())
     {
-        ret = HttpService::NORMAL;
+        ret = (std::min)(ret, HttpService::TRANSPORT_WAIT);
     }
     return ret;
 }
 
 
+void HttpLibcurl::waitForActivity(int max_wait_ms)
+{
+    LL_PROFILE_ZONE_SCOPED_CATEGORY_NETWORK;
+    if (! mPollHandle)
+    {
+        ms_sleep(HTTP_SERVICE_LOOP_SLEEP_NORMAL_MS);
+        return;
+    }
+
+    long timeout_ms(max_wait_ms);
+    mWaitFds.clear();
+    for (int policy_class(0); policy_class < mPolicyCount; ++policy_class)
+    {
+        if (! mMultiHandles[policy_class] || ! mActiveHandles[policy_class])
+        {
+            continue;
+        }
+
+        long class_timeout_ms(-1);
+        if (CURLM_OK == curl_multi_timeout(mMultiHandles[policy_class], &class_timeout_ms)
+            && class_timeout_ms >= 0)
+        {
+            timeout_ms = (std::min)(timeout_ms, class_timeout_ms);
+        }
+        if (! append_wait_fds(mMultiHandles[policy_class], mWaitFds))
+        {
+            // Nothing to wait on, come back shortly as libcurl suggests
+            timeout_ms = (std::min)(timeout_ms, long(HTTP_SERVICE_LOOP_SLEEP_NORMAL_MS));
+        }
+    }
+    if (timeout_ms <= 0)
+    {
+        return;
+    }
+
+    LL_PROFILE_ZONE_NAMED_CATEGORY_NETWORK("httppt - wait");
+#if HTTP_CURL_MULTI_POLL
+    CURLMcode code(curl_multi_poll(mPollHandle, mWaitFds.data(), (unsigned int) mWaitFds.size(),
+                                   int(timeout_ms), NULL));
+#else
+    curl_waitfd wakeup_fd = { mWakeupSockets[0], CURL_WAIT_POLLIN, 0 };
+    mWaitFds.push_back(wakeup_fd);
+    CURLMcode code(curl_multi_wait(mPollHandle, mWaitFds.data(), (unsigned int) mWaitFds.size(),
+                                   int(timeout_ms), NULL));
+
+    // Drain the wakeups, they have done their job
+    char buffer[64];
+#if LL_WINDOWS
+    while (recv(mWakeupSockets[0], buffer, sizeof(buffer), 0) > 0)
+#else
+    while (read(mWakeupSockets[0], buffer, sizeof(buffer)) > 0)
+#endif
+    {
+        ;
+    }
+#endif
+    if (CURLM_OK != code)
+    {
+        // Don't let a failing wait turn the loop into a spin
+        check_curl_multi_code(code);
+        ms_sleep(HTTP_SERVICE_LOOP_SLEEP_NORMAL_MS);
+    }
+}
+
+
+void HttpLibcurl::wakeup()
+{
+    LLCoreInt::HttpScopedLock lock(mPollMutex);
+
+    if (mPollHandle)
+    {
+#if HTTP_CURL_MULTI_POLL
+        curl_multi_wakeup(mPollHandle);
+#else
+        // A full pipe already holds a wakeup, failures are fine
+        static const char wake(1);
+#if LL_WINDOWS
+        send(mWakeupSockets[1], &wake, 1, 0);
+#else
+        ssize_t written(write(mWakeupSockets[1], &wake, 1));
+        (void) written;
+#endif
+#endif
+    }
+}
+
+
 // Caller has provided us with a ref count on op.
 void HttpLibcurl::addOp(const HttpOpRequest::ptr_t &op)
 {
@@ -409,6 +549,21 @@ bool HttpLibcurl::completeRequest(CURLM * multi_handle, CURL * handle, CURLcode
         }
     }
 
+    if (handle)
+    {
+        // Latencies are taken from the creation of the request so
+        // that time spent on the request and ready queues counts.
+        // libcurl's times start when the transfer does.
+        double first_byte(0.0), total(0.0);
+        if (CURLE_OK == curl_easy_getinfo(handle, CURLINFO_STARTTRANSFER_TIME, &first_byte)
+            && CURLE_OK == curl_easy_getinfo(handle, CURLINFO_TOTAL_TIME, &total)
+            && first_byte > 0.0)
+        {
+            const F64 total_ms(F64(totalTime() - op->mMetricCreated) / 1000.0);
+            HTTPStats::instance().recordLatency(total_ms - (total - first_byte) * 1000.0, total_ms);
+        }
+    }
+
     if (multi_handle && handle)
     {
         // Detach from multi and recycle handle
@@ -654,4 +809,145 @@ void check_curl_multi_code(CURLMcode code)
     }
 }
 
+
+bool append_wait_fds(CURLM * multi_handle, std::vector<curl_waitfd> & fds)
+{
+    fd_set read_fds, write_fds, exc_fds;
+    FD_ZERO(&read_fds);
+    FD_ZERO(&write_fds);
+    FD_ZERO(&exc_fds);
+    int max_fd(-1);
+
+    if (CURLM_OK != curl_multi_fdset(multi_handle, &read_fds, &write_fds, &exc_fds, &max_fd)
+        || max_fd < 0)
+    {
+        return false;
+    }
+
+#if LL_WINDOWS
+    // Windows fd_sets are socket arrays rather than bit masks
+    for (u_int i(0); i < read_fds.fd_count; ++i)
+    {
+        curl_waitfd fd = { read_fds.fd_array[i], CURL_WAIT_POLLIN, 0 };
+        fds.push_back(fd);
+    }
+    for (u_int i(0); i < write_fds.fd_count; ++i)
+    {
+        curl_waitfd fd = { write_fds.fd_array[i], CURL_WAIT_POLLOUT, 0 };
+        fds.push_back(fd);
+    }
+    for (u_int i(0); i < exc_fds.fd_count; ++i)
+    {
+        curl_waitfd fd = { exc_fds.fd_array[i], CURL_WAIT_POLLPRI, 0 };
+        fds.push_back(fd);
+    }
+#else
+    for (int socket(0); socket <= max_fd; ++socket)
+    {
+        short events(0);
+        if (FD_ISSET(socket, &read_fds))
+        {
+            events |= CURL_WAIT_POLLIN;
+        }
+        if (FD_ISSET(socket, &write_fds))
+        {
+            events |= CURL_WAIT_POLLOUT;
+        }
+        if (FD_ISSET(socket, &exc_fds))
+        {
+            events |= CURL_WAIT_POLLPRI;
+        }
+        if (events)
+        {
+            curl_waitfd fd = { socket, events, 0 };
+            fds.push_back(fd);
+        }
+    }
+#endif
+    return true;
+}
+
+
+#if ! HTTP_CURL_MULTI_POLL
+
+bool open_wakeup_pair(curl_socket_t socks[2])
+{
+    socks[0] = socks[1] = CURL_SOCKET_BAD;
+
+#if LL_WINDOWS
+    // No socketpair() and pipes can't be selected on, so connect
+    // two sockets over the loopback interface.
+    SOCKET listener(socket(AF_INET, SOCK_STREAM, IPPROTO_TCP));
+    if (INVALID_SOCKET == listener)
+    {
+        return false;
+    }
+
+    sockaddr_in addr = {};
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    int addr_len(sizeof(addr));
+    bool ok(0 == bind(listener, (sockaddr *) &addr, sizeof(addr))
+            && 0 == listen(listener, 1)
+            && 0 == getsockname(listener, (sockaddr *) &addr, &addr_len));
+    if (ok)
+    {
+        socks[1] = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+        ok = INVALID_SOCKET != socks[1]
+             && 0 == connect(socks[1], (sockaddr *) &addr, sizeof(addr));
+    }
+    if (ok)
+    {
+        socks[0] = accept(listener, NULL, NULL);
+        ok = INVALID_SOCKET != socks[0];
+    }
+    closesocket(listener);
+    if (! ok)
+    {
+        close_wakeup_pair(socks);
+        return false;
+    }
+
+    u_long non_blocking(1);
+    ioctlsocket(socks[0], FIONBIO, &non_blocking);
+    ioctlsocket(socks[1], FIONBIO, &non_blocking);
+
+    // Single byte writes, don't let Nagle hold them back
+    BOOL no_delay(TRUE);
+    setsockopt(socks[1], IPPROTO_TCP, TCP_NODELAY, (const char *) &no_delay, sizeof(no_delay));
+#else
+    int fds[2];
+    if (pipe(fds))
+    {
+        return false;
+    }
+    for (int i(0); i < 2; ++i)
+    {
+        fcntl(fds[i], F_SETFL, fcntl(fds[i], F_GETFL) | O_NONBLOCK);
+        fcntl(fds[i], F_SETFD, FD_CLOEXEC);
+        socks[i] = fds[i];
+    }
+#endif
+    return true;
+}
+
+
+void close_wakeup_pair(curl_socket_t socks[2])
+{
+    for (int i(0); i < 2; ++i)
+    {
+        if (CURL_SOCKET_BAD != socks[i])
+        {
+#if LL_WINDOWS
+            closesocket(socks[i]);
+#else
+            close(socks[i]);
+#endif
+            socks[i] = CURL_SOCKET_BAD;
+        }
+    }
+}
+
+#endif // ! HTTP_CURL_MULTI_POLL
+
 }  // end anonymous namespace
@@ -33,10 +33,18 @@
 #include <curl/multi.h>
 
 #include <set>
+#include <vector>
 
 #include "httprequest.h"
 #include "_httpservice.h"
 #include "_httpinternal.h"
+#include "_mutex.h"
+
+
+// libcurl 7.68 brought curl_multi_poll() and curl_multi_wakeup().  With
+// older libraries the transport waits in curl_multi_wait() on a socket
+// pair of its own to get the same wakeups.
+#define HTTP_CURL_MULTI_POLL (LIBCURL_VERSION_NUM >= 0x074400)
 
 
 namespace LLCore
@@ -50,9 +58,9 @@ class HttpHeaders;
 
 /// Implements libcurl-based transport for an HttpService instance.
 ///
-/// Threading:  Single-threaded.  Other than for construction/destruction,
-/// all methods are expected to be invoked in a single thread, typically
-/// a worker thread of some sort.
+/// Threading:  Single-threaded.  Other than for construction/destruction
+/// and wakeup(), all methods are expected to be invoked in a single thread,
+/// typically a worker thread of some sort.
 
 class HttpLibcurl
 {
@@ -75,6 +83,22 @@ class HttpLibcurl
     /// Threading:  called by worker thread.
     HttpService::ELoopSpeed processTransport();
 
+    /// Block until there is socket activity or a libcurl timeout
+    /// due on any of the active policy classes, until wakeup() is
+    /// called or until @max_wait_ms pass, whichever comes first.
+    /// Each class keeps its own multi handle (connection limits
+    /// are per class) so their sockets are gathered and waited on
+    /// together through a single, otherwise empty, multi handle.
+    ///
+    /// Threading:  called by worker thread.
+    void waitForActivity(int max_wait_ms);
+
+    /// Interrupt the current waitForActivity() call or, if there
+    /// is none, the next one.
+    ///
+    /// Threading:  callable by any thread.
+    void wakeup();
+
     /// Add request to the active list.  Caller is expected to have
     /// provided us with a reference count on the op to hold the
     /// request.  (No additional references will be added.)
@@ -213,6 +237,12 @@ class HttpLibcurl
     CURLM **            mMultiHandles;      // One handle per policy class
     int *               mActiveHandles;     // Active count per policy class
     bool *              mDirtyPolicy;       // Dirty policy update waiting for stall (per pc)
+    CURLM *             mPollHandle;        // Waited on for all classes, no easy handles
+    LLCoreInt::HttpMutex mPollMutex;        // Guards mPollHandle lifetime against wakeup()
+#if ! HTTP_CURL_MULTI_POLL
+    curl_socket_t       mWakeupSockets[2];  // Read and write ends of the wakeup pair
+#endif
+    std::vector<curl_waitfd> mWaitFds;      // Sockets of the active classes
 
 }; // end class HttpLibcurl
 
@@ -245,6 +245,7 @@ HttpService::ELoopSpeed HttpPolicy::processReadyQueue()
 
         const bool throttle_enabled(state.mOptions.mThrottleRate > 0L);
         const bool throttle_current(throttle_enabled && now < state.mThrottleEnd);
+        bool throttled(false);
 
         if (throttle_current && state.mThrottleLeft <= 0)
         {
@@ -291,6 +292,7 @@ HttpService::ELoopSpeed HttpPolicy::processReadyQueue()
                     }
                     if (--state.mThrottleLeft <= 0)
                     {
+                        throttled = true;
                         goto throttle_on;
                     }
                 }
@@ -322,6 +324,7 @@ HttpService::ELoopSpeed HttpPolicy::processReadyQueue()
                     }
                     if (--state.mThrottleLeft <= 0)
                     {
+                        throttled = true;
                         goto throttle_on;
                     }
                 }
@@ -330,11 +333,17 @@ HttpService::ELoopSpeed HttpPolicy::processReadyQueue()
 
     throttle_on:
 
-        if (! readyq.empty() || ! retryq.empty())
+        if (throttled || ! retryq.empty())
         {
-            // If anything is ready, continue looping...
+            // Retries and throttle windows are timed, keep looping...
             result = HttpService::NORMAL;
         }
+        else if (! readyq.empty())
+        {
+            // Connections are all busy, a completion will
+            // free one so wait on the transport.
+            result = (std::min)(result, HttpService::TRANSPORT_WAIT);
+        }
     } // end foreach policy_class
 
     return result;
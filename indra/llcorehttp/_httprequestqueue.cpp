@@ -83,6 +83,10 @@ HttpStatus HttpRequestQueue::addOp(const HttpRequestQueue::opPtr_t &op, bool log
         if (loggable && sMessageLogFunc != nullptr ) { sMessageLogFunc(op); }
         wake = mQueue.empty();
         mQueue.push_back(op);
+        if (wake && mWakeupFunc)
+        {
+            mWakeupFunc();
+        }
     }
     if (wake)
     {
@@ -139,8 +143,28 @@ void HttpRequestQueue::fetchAll(bool wait, OpContainer & ops)
 
 
 void HttpRequestQueue::wakeAll()
+{
+    HttpScopedLock lock(mQueueMutex);
+
+    wakeAllLocked();
+}
+
+
+void HttpRequestQueue::wakeAllLocked()
 {
     mQueueCV.notify_all();
+    if (mWakeupFunc)
+    {
+        mWakeupFunc();
+    }
+}
+
+
+void HttpRequestQueue::setWakeupFunc(std::function<void()> func)
+{
+    HttpScopedLock lock(mQueueMutex);
+
+    mWakeupFunc = std::move(func);
 }
 
 
@@ -152,10 +176,10 @@ bool HttpRequestQueue::stopQueue()
         if (!mQueueStopped)
         {
             mQueueStopped = true;
-            wakeAll();
+            wakeAllLocked();
             return true;
         }
-        wakeAll();
+        wakeAllLocked();
         return false;
     }
 }
@@ -28,6 +28,7 @@
 #define _LLCORE_HTTP_REQUEST_QUEUE_H_
 
 
+#include <functional>
 #include <vector>
 
 #include "httpcommon.h"
@@ -116,6 +117,16 @@ class HttpRequestQueue final : public LLCoreInt::RefCounted
     /// Threading:  callable by any thread.
     void wakeAll();
 
+    /// Install a function called whenever the queue goes from
+    /// empty to non-empty and on wakeAll().  Lets a consumer that
+    /// waits on something other than the queue (the service thread
+    /// waiting on libcurl) be interrupted.  Called with the queue
+    /// lock held so it must be quick and must not call back into
+    /// the queue.
+    ///
+    /// Threading:  callable by any thread.
+    void setWakeupFunc(std::function<void()> func);
+
     /// Disallow further request queuing.  Callers to @addOp will
     /// get a failure status (LLCORE, HE_SHUTTING_DOWN).  Callers
     /// to @fetchAll or @fetchOp will get requests that are on the
@@ -132,11 +143,16 @@ class HttpRequestQueue final : public LLCoreInt::RefCounted
     static HttpRequestQueue *           sInstance;
     static std::function<void(const HttpRequestQueue::opPtr_t &)> sMessageLogFunc;
 
+protected:
+    /// Wake sleepers with mQueueMutex held
+    void wakeAllLocked();
+
 protected:
     OpContainer                         mQueue;
     LLCoreInt::HttpMutex                mQueueMutex;
     LLCoreInt::HttpConditionVariable    mQueueCV;
     bool                                mQueueStopped;
+    std::function<void()>               mWakeupFunc;
 
 }; // end class HttpRequestQueue
 
@@ -105,6 +105,7 @@ HttpService::~HttpService()
 
     if (mRequestQueue)
     {
+        mRequestQueue->setWakeupFunc(nullptr);
         mRequestQueue->release();
         mRequestQueue = NULL;
     }
@@ -128,6 +129,11 @@ void HttpService::init(HttpRequestQueue * queue)
     sInstance->mRequestQueue = queue;
     sInstance->mPolicy = new HttpPolicy(sInstance);
     sInstance->mTransport = new HttpLibcurl(sInstance);
+
+    // Requests arriving while the worker waits on the transport
+    // need to interrupt the wait.
+    HttpLibcurl * transport(sInstance->mTransport);
+    queue->setWakeupFunc([transport]() { transport->wakeup(); });
     sState = INITIALIZED;
 }
 
@@ -265,7 +271,7 @@ void HttpService::shutdown()
 
 // Working thread loop-forever method.  Gives time to
 // each of the request queue, policy layer and transport
-// layer pieces and then either sleeps for a small time
+// layer pieces and then either waits on the transport
 // or waits for a request to come in.  Repeats until
 // requested to stop.
 void HttpService::threadRun(LLCoreInt::HttpThread * thread)
@@ -288,10 +294,16 @@ void HttpService::threadRun(LLCoreInt::HttpThread * thread)
             new_loop = mTransport->processTransport();
             loop = (std::min)(loop, new_loop);
 
-            // Determine whether to spin, sleep briefly or sleep for next request
-            if (REQUEST_SLEEP != loop)
+            // Determine whether to spin, wait on the transport or sleep for
+            // next request.  Transport waits end early when libcurl has
+            // socket activity or a request queue write wakes us up.
+            if (NORMAL == loop)
+            {
+                mTransport->waitForActivity(HTTP_SERVICE_LOOP_SLEEP_NORMAL_MS);
+            }
+            else if (TRANSPORT_WAIT == loop)
             {
-                ms_sleep(HTTP_SERVICE_LOOP_SLEEP_NORMAL_MS);
+                mTransport->waitForActivity(HTTP_SERVICE_LOOP_WAIT_MAX_MS);
             }
         }
         catch (const LLContinueError&)
@@ -104,7 +104,9 @@ class HttpService
     // requests.
     enum ELoopSpeed
     {
+        IMMEDIATE,              ///< run the next pass without waiting
         NORMAL,                 ///< continuous polling of request, ready, active queues
+        TRANSPORT_WAIT,         ///< can wait for transport activity or request queue write
         REQUEST_SLEEP           ///< can sleep indefinitely waiting for request queue write
     };
 
@@ -0,0 +1,515 @@
+/**
+ * @file http_loopback_bench.cpp
+ * @brief Loopback latency and throughput benchmark for core-http library
+ *
+ * $LicenseInfo:firstyear=2024&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2024, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#include <iostream>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "linden_common.h"
+
+#include "httpcommon.h"
+#include "httprequest.h"
+#include "httphandler.h"
+#include "httpresponse.h"
+#include "httpoptions.h"
+#include "httpheaders.h"
+#include "httpstats.h"
+#include "bufferarray.h"
+
+#include <curl/curl.h>
+
+#if defined(WIN32)
+#include <winsock2.h>
+#include <ws2tcpip.h>
+typedef SOCKET socket_t;
+#define close_socket(_s)            closesocket(_s)
+#else
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <unistd.h>
+typedef int socket_t;
+#define INVALID_SOCKET              (-1)
+#define close_socket(_s)            close(_s)
+#endif
+
+#include "lltimer.h"
+
+
+void init_curl();
+void term_curl();
+void usage(std::ostream & out);
+
+// Default command line settings
+static int concurrency_limit(8);
+static int highwater(32);
+static int request_count(2000);
+static int body_size(16384);
+static int server_delay(0);
+
+
+// Stand-in for an asset server.  Answers every GET on
+// 127.0.0.1 with a body of a fixed size, optionally after
+// a delay, keeping connections alive.  One thread per
+// connection, which is plenty for a few dozen of them.
+
+class LoopbackServer
+{
+public:
+    LoopbackServer();
+    ~LoopbackServer();
+
+    bool start(int body_size, int delay_ms);
+    void stop();
+
+    int getPort() const
+        {
+            return mPort;
+        }
+
+protected:
+    void acceptLoop();
+    void serve(socket_t client);
+
+protected:
+    socket_t                    mListener;
+    int                         mPort;
+    int                         mDelay;
+    std::string                 mResponse;
+    std::atomic<bool>           mStopping;
+    std::thread                 mAcceptThread;
+    std::mutex                  mClientsMutex;
+    std::vector<socket_t>       mClients;
+    std::vector<std::thread>    mClientThreads;
+};
+
+
+// Keeps the request pipeline full and counts what
+// comes back.
+
+class Bench : public LLCore::HttpHandler
+{
+public:
+    Bench();
+
+    void issue(LLCore::HttpRequest * hr, LLCore::HttpOptions::ptr_t & opt);
+
+    virtual void onCompleted(LLCore::HttpHandle handle, LLCore::HttpResponse * response);
+
+public:
+    std::string                 mUrl;
+    int                         mRemaining;
+    int                         mOutstanding;
+    int                         mSuccesses;
+    int                         mErrors;
+    long                        mByteCount;
+};
+
+
+//
+//
+//
+int main(int argc, char** argv)
+{
+    for (int arg(1); arg < argc; ++arg)
+    {
+        const std::string option(argv[arg]);
+        if ("-h" == option || "-?" == option)
+        {
+            usage(std::cout);
+            return 0;
+        }
+
+        int * target(NULL);
+        int low(0), high(0);
+        if ("-c" == option)
+        {
+            target = &concurrency_limit;
+            low = 1;
+            high = 100;
+        }
+        else if ("-H" == option)
+        {
+            target = &highwater;
+            low = 1;
+            high = 200;
+        }
+        else if ("-n" == option)
+        {
+            target = &request_count;
+            low = 1;
+            high = 10000000;
+        }
+        else if ("-s" == option)
+        {
+            target = &body_size;
+            low = 0;
+            high = 64 * 1024 * 1024;
+        }
+        else if ("-d" == option)
+        {
+            target = &server_delay;
+            low = 0;
+            high = 10000;
+        }
+
+        char * end(NULL);
+        long value(0);
+        if (target && ++arg < argc)
+        {
+            value = strtol(argv[arg], &end, 10);
+        }
+        if (! target || ! end || *end != '\0' || value < low || value > high)
+        {
+            usage(std::cerr);
+            return 1;
+        }
+        *target = int(value);
+    }
+
+    // Initialization
+    init_curl();
+
+    LoopbackServer server;
+    if (! server.start(body_size, server_delay))
+    {
+        std::cerr << "Couldn't start loopback server." << std::endl;
+        term_curl();
+        return 1;
+    }
+
+    LLCore::HttpRequest::createService();
+    LLCore::HttpRequest::setStaticPolicyOption(LLCore::HttpRequest::PO_CONNECTION_LIMIT,
+                                               LLCore::HttpRequest::DEFAULT_POLICY_ID,
+                                               concurrency_limit,
+                                               NULL);
+    LLCore::HttpRequest::setStaticPolicyOption(LLCore::HttpRequest::PO_PER_HOST_CONNECTION_LIMIT,
+                                               LLCore::HttpRequest::DEFAULT_POLICY_ID,
+                                               concurrency_limit,
+                                               NULL);
+    LLCore::HttpRequest::startThread();
+
+    LLCore::HttpRequest * hr = new LLCore::HttpRequest();
+    LLCore::HttpOptions::ptr_t opt = LLCore::HttpOptions::ptr_t(new LLCore::HttpOptions());
+    opt->setRetries(0);
+
+    Bench bench;
+    bench.mUrl = "http://127.0.0.1:" + std::to_string(server.getPort()) + "/asset";
+    bench.mRemaining = request_count;
+
+    LLCore::HTTPStats::instance().resetStats();
+
+    // Run it
+    const U64 start = totalTime().value();
+    while (bench.mRemaining || bench.mOutstanding)
+    {
+        bench.issue(hr, opt);
+        hr->update(0);
+        ms_sleep(1);
+    }
+    const U64 elapsed((std::max)(totalTime().value() - start, U64(1)));
+
+    // Report
+    const LLCore::HTTPStats & stats(LLCore::HTTPStats::instance());
+    const double seconds(double(elapsed) / 1000000.0);
+    std::cout << "Requests: " << bench.mSuccesses << "  Errors: " << bench.mErrors
+              << "  Byte count: " << bench.mByteCount
+              << "  Wall time: " << elapsed << " uS" << std::endl;
+    std::cout << "Throughput: " << double(bench.mSuccesses) / seconds << " requests/S  "
+              << double(bench.mByteCount) / (seconds * 1024.0 * 1024.0) << " MB/S" << std::endl;
+    std::cout << "Request to first byte  p50: "
+              << LLCore::HTTPStats::getLatencyPercentile(stats.getFirstByteLatency(), 0.5)
+              << " mS  p90: " << LLCore::HTTPStats::getLatencyPercentile(stats.getFirstByteLatency(), 0.9)
+              << " mS  p99: " << LLCore::HTTPStats::getLatencyPercentile(stats.getFirstByteLatency(), 0.99)
+              << " mS" << std::endl;
+    std::cout << "Request to completion  p50: "
+              << LLCore::HTTPStats::getLatencyPercentile(stats.getTotalLatency(), 0.5)
+              << " mS  p90: " << LLCore::HTTPStats::getLatencyPercentile(stats.getTotalLatency(), 0.9)
+              << " mS  p99: " << LLCore::HTTPStats::getLatencyPercentile(stats.getTotalLatency(), 0.99)
+              << " mS" << std::endl;
+
+    // Clean up
+    hr->requestStopThread(LLCore::HttpHandler::ptr_t());
+    ms_sleep(1000);
+    opt.reset();
+    delete hr;
+    LLCore::HttpRequest::destroyService();
+    server.stop();
+    term_curl();
+
+    return bench.mErrors ? 1 : 0;
+}
+
+
+void usage(std::ostream & out)
+{
+    out << "\n"
+        "usage:\thttp_loopback_bench [options]\n"
+        "\n"
+        "This is a standalone program measuring the overhead of the New Platform\n"
+        "HTTP Library itself.  It serves GET requests from a server thread on the\n"
+        "loopback interface so that network and server time mostly drop out, and\n"
+        "reports throughput along with request-to-first-byte and request-to-completion\n"
+        "latencies (log2 millisecond buckets, so percentiles are upper bounds).\n"
+        "Run it against two builds of the library to compare them.\n"
+        "\n"
+        "Options:\n"
+        "\n"
+        " -c <limit>            Maximum connection concurrency.  Range:  [1..100]\n"
+        "                       Default:  " << concurrency_limit << "\n"
+        " -H <limit>            HTTP request highwater (requests fed to llcorehttp).\n"
+        "                       Range:  [1..200]  Default:  " << highwater << "\n"
+        " -n <count>            Number of requests to issue.  Default:  " << request_count << "\n"
+        " -s <bytes>            Response body size.  Default:  " << body_size << "\n"
+        " -d <mS>               Server delay before each response.  Default:  " << server_delay << "\n"
+        " -h                    print this help\n"
+        "\n"
+        << std::endl;
+}
+
+
+namespace
+{
+    void NoOpDeletor(LLCore::HttpHandler *)
+    { /*NoOp*/ }
+}
+
+Bench::Bench()
+    : LLCore::HttpHandler(),
+      mRemaining(0),
+      mOutstanding(0),
+      mSuccesses(0),
+      mErrors(0),
+      mByteCount(0L)
+{}
+
+
+void Bench::issue(LLCore::HttpRequest * hr, LLCore::HttpOptions::ptr_t & opt)
+{
+    while (mRemaining && mOutstanding < highwater)
+    {
+        LLCore::HttpHandle handle(hr->requestGet(0, mUrl, opt, LLCore::HttpHeaders::ptr_t(),
+                                                 LLCore::HttpHandler::ptr_t(this, NoOpDeletor)));
+        if (! handle)
+        {
+            // Fatal.  Couldn't queue up something.
+            std::cerr << "Failed to queue work to HTTP Service.  Reason:  "
+                      << hr->getStatus().toString() << std::endl;
+            exit(1);
+        }
+        ++mOutstanding;
+        --mRemaining;
+    }
+}
+
+
+void Bench::onCompleted(LLCore::HttpHandle handle, LLCore::HttpResponse * response)
+{
+    if (response->getStatus())
+    {
+        LLCore::BufferArray * data(response->getBody());
+        mByteCount += data ? data->size() : 0;
+        ++mSuccesses;
+    }
+    else
+    {
+        ++mErrors;
+    }
+    --mOutstanding;
+}
+
+
+LoopbackServer::LoopbackServer()
+    : mListener(INVALID_SOCKET),
+      mPort(0),
+      mDelay(0),
+      mStopping(false)
+{}
+
+
+LoopbackServer::~LoopbackServer()
+{
+    stop();
+}
+
+
+bool LoopbackServer::start(int body_size, int delay_ms)
+{
+    mListener = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+    if (INVALID_SOCKET == mListener)
+    {
+        return false;
+    }
+
+    sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    socklen_t addr_len(sizeof(addr));
+    if (bind(mListener, (sockaddr *) &addr, sizeof(addr))
+        || listen(mListener, 128)
+        || getsockname(mListener, (sockaddr *) &addr, &addr_len))
+    {
+        close_socket(mListener);
+        mListener = INVALID_SOCKET;
+        return false;
+    }
+    mPort = ntohs(addr.sin_port);
+    mDelay = delay_ms;
+
+    mResponse = "HTTP/1.1 200 OK\r\n"
+                "Content-Type: application/octet-stream\r\n"
+                "Content-Length: " + std::to_string(body_size) + "\r\n"
+                "\r\n";
+    mResponse.append(size_t(body_size), 'x');
+
+    mAcceptThread = std::thread(&LoopbackServer::acceptLoop, this);
+    return true;
+}
+
+
+void LoopbackServer::stop()
+{
+    if (INVALID_SOCKET == mListener)
+    {
+        return;
+    }
+
+    // Closing sockets under blocked threads doesn't reliably
+    // wake them everywhere, shutting them down does.
+    mStopping = true;
+    shutdown(mListener, 2);
+    close_socket(mListener);
+    mListener = INVALID_SOCKET;
+    mAcceptThread.join();
+
+    {
+        std::lock_guard<std::mutex> lock(mClientsMutex);
+        for (socket_t client : mClients)
+        {
+            shutdown(client, 2);
+        }
+    }
+    for (std::thread & thread : mClientThreads)
+    {
+        thread.join();
+    }
+    for (socket_t client : mClients)
+    {
+        close_socket(client);
+    }
+    mClientThreads.clear();
+    mClients.clear();
+}
+
+
+void LoopbackServer::acceptLoop()
+{
+    while (! mStopping)
+    {
+        socket_t client(accept(mListener, NULL, NULL));
+        if (INVALID_SOCKET == client)
+        {
+            if (mStopping)
+            {
+                break;
+            }
+            continue;
+        }
+
+        int no_delay(1);
+        setsockopt(client, IPPROTO_TCP, TCP_NODELAY, (const char *) &no_delay, sizeof(no_delay));
+
+        std::lock_guard<std::mutex> lock(mClientsMutex);
+        mClients.push_back(client);
+        mClientThreads.push_back(std::thread(&LoopbackServer::serve, this, client));
+    }
+}
+
+
+void LoopbackServer::serve(socket_t client)
+{
+    std::string pending;
+    char buffer[4096];
+
+    while (! mStopping)
+    {
+        int got(recv(client, buffer, sizeof(buffer), 0));
+        if (got <= 0)
+        {
+            break;
+        }
+        pending.append(buffer, got);
+
+        // Answer every complete request header, pipelined or not.
+        // Bodies aren't expected, only GETs are issued.
+        size_t end;
+        while (std::string::npos != (end = pending.find("\r\n\r\n")))
+        {
+            pending.erase(0, end + 4);
+            if (mDelay)
+            {
+                ms_sleep(mDelay);
+            }
+
+            const char * out(mResponse.data());
+            size_t left(mResponse.size());
+            while (left)
+            {
+                int sent(send(client, out, int((std::min)(left, size_t(1024 * 1024))), 0));
+                if (sent <= 0)
+                {
+                    left = 0;
+                    pending.clear();
+                    break;
+                }
+                out += sent;
+                left -= sent;
+            }
+        }
+    }
+    // Socket is closed by stop() once all threads are done
+}
+
+
+void init_curl()
+{
+    curl_global_init(CURL_GLOBAL_ALL);
+}
+
+
+void term_curl()
+{
+    curl_global_cleanup();
+}
@@ -41,6 +41,8 @@ void HTTPStats::resetStats()
     mDataDown.reset();
     mDataUp.reset();
     mRequests = 0;
+    mFirstByteLatency.fill(0);
+    mTotalLatency.fill(0);
 }
 
 
@@ -59,6 +61,39 @@ void HTTPStats::recordResultCode(S32 code)
 
 namespace
 {
+    S32 latency_bucket(F64 ms)
+    {
+        S32 bucket = 0;
+        while (ms >= 1.0 && bucket < HTTPStats::LATENCY_BUCKETS - 1)
+        {
+            ms *= 0.5;
+            ++bucket;
+        }
+        return bucket;
+    }
+
+    void dump_latency(std::ostream& out, const char* name, const HTTPStats::LatencyHistogram& histogram)
+    {
+        out << name << " p50: " << HTTPStats::getLatencyPercentile(histogram, 0.5)
+            << "mS  p90: " << HTTPStats::getLatencyPercentile(histogram, 0.9)
+            << "mS  p99: " << HTTPStats::getLatencyPercentile(histogram, 0.99) << "mS" << std::endl;
+        for (S32 i = 0; i < HTTPStats::LATENCY_BUCKETS; ++i)
+        {
+            if (!histogram[i])
+            {
+                continue;
+            }
+            if (i < HTTPStats::LATENCY_BUCKETS - 1)
+            {
+                out << "  < " << (1 << i) << "mS " << histogram[i] << std::endl;
+            }
+            else
+            {
+                out << "  >= " << (1 << (i - 1)) << "mS " << histogram[i] << std::endl;
+            }
+        }
+    }
+
     std::string byte_count_converter(F32 bytes)
     {
         static const char unit_suffix[] = { 'B', 'K', 'M', 'G' };
@@ -80,6 +115,39 @@ namespace
     }
 }
 
+void HTTPStats::recordLatency(F64 first_byte_ms, F64 total_ms)
+{
+    ++mFirstByteLatency[latency_bucket(first_byte_ms)];
+    ++mTotalLatency[latency_bucket(total_ms)];
+}
+
+
+F64 HTTPStats::getLatencyPercentile(const LatencyHistogram& histogram, F64 fraction)
+{
+    U64 count = 0;
+    for (U32 samples : histogram)
+    {
+        count += samples;
+    }
+    if (!count)
+    {
+        return 0.0;
+    }
+
+    const F64 wanted = fraction * (F64)count;
+    U64 seen = 0;
+    for (S32 i = 0; i < LATENCY_BUCKETS; ++i)
+    {
+        seen += histogram[i];
+        if ((F64)seen >= wanted)
+        {
+            return (F64)(1 << i);
+        }
+    }
+    return (F64)(1 << (LATENCY_BUCKETS - 1));
+}
+
+
 void HTTPStats::dumpStats()
 {
     std::stringstream out;
@@ -97,6 +165,11 @@ void HTTPStats::dumpStats()
         out << (*it).first << " " << (*it).second << std::endl;
     }
 
+    out << std::endl;
+    out << "Latency (from request creation):" << std::endl;
+    dump_latency(out, "First byte", mFirstByteLatency);
+    dump_latency(out, "Complete", mTotalLatency);
+
     LL_WARNS("HTTPCore") << out.str() << LL_ENDL;
 }
 
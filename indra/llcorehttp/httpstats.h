@@ -33,6 +33,8 @@
 #include "llsingleton.h"
 #include "llsd.h"
 
+#include <array>
+
 namespace LLCore
 {
     class HTTPStats final : public LLSingleton<HTTPStats>
@@ -59,6 +61,23 @@ namespace LLCore
 
         void    recordResultCode(S32 code);
 
+        // Request latencies in milliseconds, log2 bucketed:  bucket 0
+        // counts those under 1mS, bucket n those in [2^(n-1), 2^n) mS
+        // and the last bucket anything slower.
+        static const S32 LATENCY_BUCKETS = 16;
+        typedef std::array<U32, LATENCY_BUCKETS> LatencyHistogram;
+
+        // Time to the first byte of the response and to completion,
+        // both counted from the creation of the request.
+        void    recordLatency(F64 first_byte_ms, F64 total_ms);
+
+        const LatencyHistogram& getFirstByteLatency() const { return mFirstByteLatency; }
+        const LatencyHistogram& getTotalLatency() const { return mTotalLatency; }
+
+        // Upper bound, in milliseconds, of the bucket holding the given
+        // fraction (0.5 for the median) of the samples.  0 if empty.
+        static F64 getLatencyPercentile(const LatencyHistogram& histogram, F64 fraction);
+
         void    dumpStats();
     private:
         StatsAccumulator mDataDown;
@@ -67,6 +86,9 @@ namespace LLCore
         S32              mRequests;
 
         std::map<S32, S32> mResutCodes;
+
+        LatencyHistogram mFirstByteLatency;
+        LatencyHistogram mTotalLatency;
     };
 
 
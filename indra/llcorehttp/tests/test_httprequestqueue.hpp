@@ -151,6 +151,50 @@ void HttpRequestqueueTestObjectType::test<4>()
     }
 }
 
+template <> template <>
+void HttpRequestqueueTestObjectType::test<5>()
+{
+    set_test_name("HttpRequestQueue wakeup function");
+
+    // create a new ref counted object with an implicit reference
+    HttpRequestQueue::init();
+
+    HttpRequestQueue * rq = HttpRequestQueue::instanceOf();
+
+    int wakeups(0);
+    rq->setWakeupFunc([&wakeups]() { ++wakeups; });
+
+    HttpOperation::ptr_t op (new HttpOpNull());
+    rq->addOp(op);      // transfer my refcount
+    ensure_equals("Wakeup when queue goes non-empty", wakeups, 1);
+
+    op.reset(new HttpOpNull());
+    rq->addOp(op);      // transfer my refcount
+    ensure_equals("No wakeup when queue was non-empty", wakeups, 1);
+
+    {
+        HttpRequestQueue::OpContainer ops;
+        rq->fetchAll(false, ops);
+        ensure("Two go in, two come out", 2 == ops.size());
+    }
+
+    op.reset(new HttpOpNull());
+    rq->addOp(op);      // transfer my refcount
+    ensure_equals("Wakeup when queue goes non-empty again", wakeups, 2);
+
+    rq->stopQueue();
+    ensure_equals("Wakeup on stop", wakeups, 3);
+
+    rq->setWakeupFunc(nullptr);
+    rq->wakeAll();
+    ensure_equals("No wakeup once cleared", wakeups, 3);
+
+    op.reset();
+
+    // release the singleton
+    HttpRequestQueue::term();
+}
+
 }  // end namespace tut
 
 
@@ -37,20 +37,93 @@
 #include <boost/filesystem.hpp>
 #include <boost/range/iterator_range.hpp>
 #include <chrono>
+#include <cstddef>
 
 #include "lldiskcache.h"
 
 const std::string DISK_CACHE_DIR_NAME = "cache";
+const std::string DISK_CACHE_JOURNAL_NAME = "index.journal";
+
+namespace
+{
+    const char JOURNAL_MAGIC[4] = { 'S', 'L', 'D', 'C' };
+    const U32 JOURNAL_VERSION = 1;
+
+    enum : U8
+    {
+        JOURNAL_ADD = 1,
+        JOURNAL_TOUCH = 2,
+        JOURNAL_REMOVE = 3
+    };
+
+    struct JournalHeader
+    {
+        char mMagic[4];
+        U32 mVersion;
+        U64 mRescanTime;
+    };
+
+    struct JournalRecord
+    {
+        U8 mOp;
+        S8 mType;
+        U16 mPad;
+        U32 mTime;
+        LLUUID mID;
+        U32 mSize;
+        U32 mCheck;
+    };
+    static_assert(sizeof(JournalHeader) == 16, "unexpected journal header padding");
+    static_assert(sizeof(JournalRecord) == 32, "unexpected journal record padding");
+
+    // FNV-1a of everything but mCheck, enough to tell a torn record
+    U32 record_check(const JournalRecord& record)
+    {
+        const U8* data = (const U8*)&record;
+        U32 hash = 2166136261u;
+        for (size_t i = 0; i < offsetof(JournalRecord, mCheck); ++i)
+        {
+            hash = (hash ^ data[i]) * 16777619u;
+        }
+        return hash;
+    }
+
+    /**
+     * Reads only move a file up the LRU in the journal after this long,
+     * to keep the journal from growing with every read. Same one hour
+     * as the "last write time" updates it replaces (see SL-14582).
+     */
+    const std::time_t TOUCH_JOURNAL_THRESHOLD = 1 * 60 * 60;
+
+    /**
+     * Walk the cache directory once in a while to index the files the
+     * journal missed
+     */
+    const std::time_t RESCAN_INTERVAL = 7 * 24 * 60 * 60;
+
+    /**
+     * The journal is rewritten when it holds more than this many
+     * records beyond twice the number of indexed files
+     */
+    const U32 JOURNAL_SLACK = 16 * 1024;
+}
 
 LLDiskCache::LLDiskCache()
 {
 }
 
+LLDiskCache::~LLDiskCache()
+{
+    LLMutexLock lock(&mIndexMutex);
+    closeJournal();
+}
+
 void LLDiskCache::init(ELLPath location, const uintmax_t max_size_bytes, const bool enable_cache_debug_info, const bool cache_version_mismatch)
 {
     mMaxSizeBytes = max_size_bytes;
     mEnableCacheDebugInfo = enable_cache_debug_info;
     mCacheDir = gDirUtilp->getExpandedFilename(location, DISK_CACHE_DIR_NAME);
+    mJournalFileName = gDirUtilp->add(mCacheDir, DISK_CACHE_JOURNAL_NAME);
 
     if (cache_version_mismatch)
     {
@@ -58,6 +131,7 @@ void LLDiskCache::init(ELLPath location, const uintmax_t max_size_bytes, const b
     }
 
     createCache();
+    loadIndex();
 }
 
 
@@ -108,12 +182,320 @@ void LLDiskCache::purge()
         LL_INFOS() << "Total dir size before purge is " << dirFileSize(mCacheDir) << LL_ENDL;
     }
 
+    auto start_time = std::chrono::high_resolution_clock::now();
+
+    bool needs_rescan;
+    {
+        LLMutexLock lock(&mIndexMutex);
+        needs_rescan = mNeedsRescan;
+    }
+    if (needs_rescan)
+    {
+        rescanIndex();
+    }
+
+    // Take the victims out of the index first, so that the files can be
+    // removed without holding the lock
+    std::vector<Entry> removed;
+    uintmax_t file_size_total = 0;
+    size_t file_count = 0;
+    {
+        LLMutexLock lock(&mIndexMutex);
+        while (mTotalSize > mMaxSizeBytes && !mLRU.empty())
+        {
+            removed.push_back(mLRU.back());
+            mPurging.insert(mLRU.back().mID);
+            appendRecord(JOURNAL_REMOVE, mLRU.back(), false);
+            eraseEntry(mLRU.back().mID);
+        }
+        file_size_total = mTotalSize;
+        file_count = mEntries.size();
+
+        // also brings back a journal dropped after a failed write
+        if (!mJournal || mJournalRecords > 2 * (U32)mEntries.size() + JOURNAL_SLACK)
+        {
+            writeSnapshot();
+        }
+        else if (mJournal && fflush(mJournal) != 0)
+        {
+            discardJournal();
+        }
+    }
+
+    LL_INFOS() << "Purging cache to a maximum of " << mMaxSizeBytes << " bytes" << LL_ENDL;
+
     boost::system::error_code ec;
+    for (const Entry& entry : removed)
+    {
+        if (!LLApp::isRunning())
+        {
+            break;
+        }
+
+        // LLFileSystem may have written the file again since it was picked.
+        // If it's back in the index it belongs to the new entry, and checking
+        // under the lock keeps it from coming back between the check and the
+        // removal.
+        const boost::filesystem::path file_path = metaDataToFilepath(entry.mID, entry.mType);
+        LLMutexLock lock(&mIndexMutex);
+        if (mEntries.find(entry.mID) != mEntries.end())
+        {
+            continue;
+        }
+        boost::filesystem::remove(file_path, ec);
+        if (ec.failed())
+        {
+            LL_WARNS() << "Failed to delete cache file " << file_path << ": " << ec.message() << LL_ENDL;
+            continue;
+        }
+    }
+
+    {
+        LLMutexLock lock(&mIndexMutex);
+        mPurging.clear();
+    }
+    if (!LLApp::isRunning())
+    {
+        return;
+    }
+
+    if (mEnableCacheDebugInfo)
+    {
+        auto end_time = std::chrono::high_resolution_clock::now();
+        auto execute_time = std::chrono::duration_cast<std::chrono::milliseconds>(end_time - start_time).count();
+
+        // Log afterward so it doesn't affect the time measurement
+        // Logging thousands of file results can take hundreds of milliseconds
+        for (const Entry& entry : removed)
+        {
+            if (!LLApp::isRunning())
+            {
+                return;
+            }
+
+            // have to do this because of LL_INFO/LL_END weirdness
+            std::ostringstream line;
+
+            line << "DELETE:  ";
+            line << entry.mAccessTime << "  ";
+            line << entry.mSize << "  ";
+            line << entry.mID;
+            line << " (" << file_size_total << "/" << mMaxSizeBytes << ")";
+            LL_INFOS() << line.str() << LL_ENDL;
+        }
+
+        LL_INFOS() << "Total dir size after purge is " << dirFileSize(mCacheDir) << LL_ENDL;
+        LL_INFOS() << "Cache purge took " << execute_time << " ms to execute, removed " << removed.size()
+                   << " files, kept " << file_count << LL_ENDL;
+    }
+}
+
+void LLDiskCache::addEntry(const LLUUID& id, LLAssetType::EType at, uintmax_t size)
+{
+    LLMutexLock lock(&mIndexMutex);
+    if (mPurging.find(id) != mPurging.end())
+    {
+        // The purge in progress picked this file before it was written again
+        // and may have removed it between the write and now. Only index what
+        // is still there.
+        boost::system::error_code ec;
+        if (!boost::filesystem::exists(metaDataToFilepath(id, at), ec))
+        {
+            return;
+        }
+    }
+    Entry entry = { id, at, size, std::time(nullptr) };
+    setEntry(entry);
+    // flushed right away, a file missing from the journal is only found
+    // again by a rescan
+    appendRecord(JOURNAL_ADD, entry, true);
+}
+
+void LLDiskCache::touchEntry(const LLUUID& id)
+{
+    LLMutexLock lock(&mIndexMutex);
+    auto iter = mEntries.find(id);
+    if (iter == mEntries.end())
+    {
+        return;
+    }
+
+    // move to the front of the LRU
+    mLRU.splice(mLRU.begin(), mLRU, iter->second);
+
+    Entry& entry = mLRU.front();
+    const std::time_t cur_time = std::time(nullptr);
+    if (cur_time - entry.mAccessTime > TOUCH_JOURNAL_THRESHOLD)
+    {
+        entry.mAccessTime = cur_time;
+        appendRecord(JOURNAL_TOUCH, entry, false);
+    }
+}
+
+void LLDiskCache::removeEntry(const LLUUID& id)
+{
+    LLMutexLock lock(&mIndexMutex);
+    auto iter = mEntries.find(id);
+    if (iter != mEntries.end())
+    {
+        appendRecord(JOURNAL_REMOVE, *iter->second, false);
+        eraseEntry(id);
+    }
+}
+
+bool LLDiskCache::hasEntry(const LLUUID& id)
+{
+    LLMutexLock lock(&mIndexMutex);
+    return mEntries.find(id) != mEntries.end();
+}
+
+size_t LLDiskCache::getEntryCount()
+{
+    LLMutexLock lock(&mIndexMutex);
+    return mEntries.size();
+}
+
+uintmax_t LLDiskCache::getTotalSize()
+{
+    LLMutexLock lock(&mIndexMutex);
+    return mTotalSize;
+}
+
+void LLDiskCache::setEntry(const Entry& entry)
+{
+    auto iter = mEntries.find(entry.mID);
+    if (iter != mEntries.end())
+    {
+        mTotalSize -= iter->second->mSize;
+        *iter->second = entry;
+        mLRU.splice(mLRU.begin(), mLRU, iter->second);
+    }
+    else
+    {
+        mLRU.push_front(entry);
+        mEntries[entry.mID] = mLRU.begin();
+    }
+    mTotalSize += entry.mSize;
+}
+
+void LLDiskCache::eraseEntry(const LLUUID& id)
+{
+    auto iter = mEntries.find(id);
+    if (iter != mEntries.end())
+    {
+        mTotalSize -= iter->second->mSize;
+        mLRU.erase(iter->second);
+        mEntries.erase(iter);
+    }
+}
+
+void LLDiskCache::clearIndex()
+{
+    mLRU.clear();
+    mEntries.clear();
+    mTotalSize = 0;
+}
+
+void LLDiskCache::loadIndex()
+{
+    LLMutexLock lock(&mIndexMutex);
+    closeJournal();
+    clearIndex();
+
     auto start_time = std::chrono::high_resolution_clock::now();
 
-    typedef std::pair<std::time_t, std::pair<uintmax_t, boost::filesystem::path>> file_info_t;
+    std::time_t rescan_time = 0;
+    if (!readJournal(rescan_time))
+    {
+        LL_INFOS() << "No valid disk cache journal, the cache will be indexed from its files" << LL_ENDL;
+        clearIndex();
+        rescan_time = 0;
+    }
+    mRescanTime = rescan_time;
+    mNeedsRescan = std::time(nullptr) - rescan_time > RESCAN_INTERVAL;
+
+    if (mEnableCacheDebugInfo)
+    {
+        auto end_time = std::chrono::high_resolution_clock::now();
+        auto execute_time = std::chrono::duration_cast<std::chrono::milliseconds>(end_time - start_time).count();
+        LL_INFOS() << "Disk cache journal loaded in " << execute_time << " ms: " << mEntries.size()
+                   << " files, " << mTotalSize << " bytes" << LL_ENDL;
+    }
+
+    if (!mReadOnly)
+    {
+        // compacts the journal and drops any torn record at its end
+        writeSnapshot();
+    }
+}
+
+bool LLDiskCache::readJournal(std::time_t& rescan_time)
+{
+    LLFILE* file = LLFile::fopen(mJournalFileName, "rb");
+    if (!file)
+    {
+        return false;
+    }
+
+    JournalHeader header;
+    bool valid = fread(&header, sizeof(header), 1, file) == 1
+                 && memcmp(header.mMagic, JOURNAL_MAGIC, sizeof(JOURNAL_MAGIC)) == 0
+                 && header.mVersion == JOURNAL_VERSION;
+    if (valid)
+    {
+        rescan_time = (std::time_t)header.mRescanTime;
+    }
+
+    JournalRecord record;
+    while (valid && fread(&record, sizeof(record), 1, file) == 1)
+    {
+        if (record.mCheck != record_check(record))
+        {
+            // a torn last record is expected after a crash, anything
+            // before it means the journal is damaged
+            valid = fgetc(file) == EOF;
+            break;
+        }
+
+        Entry entry = { record.mID, (LLAssetType::EType)record.mType, record.mSize, (std::time_t)record.mTime };
+        switch (record.mOp)
+        {
+        case JOURNAL_ADD:
+            setEntry(entry);
+            break;
+        case JOURNAL_TOUCH:
+        {
+            auto iter = mEntries.find(record.mID);
+            if (iter != mEntries.end())
+            {
+                iter->second->mAccessTime = entry.mAccessTime;
+                mLRU.splice(mLRU.begin(), mLRU, iter->second);
+            }
+            break;
+        }
+        case JOURNAL_REMOVE:
+            eraseEntry(record.mID);
+            break;
+        default:
+            valid = false;
+            break;
+        }
+    }
+
+    fclose(file);
+    return valid;
+}
+
+// Called without mIndexMutex locked, the walk can take a while
+void LLDiskCache::rescanIndex()
+{
+    auto start_time = std::chrono::high_resolution_clock::now();
+    const std::time_t scan_time = std::time(nullptr);
+
+    typedef std::pair<std::time_t, std::pair<uintmax_t, LLUUID>> file_info_t;
     std::vector<file_info_t> file_info;
 
+    boost::system::error_code ec;
 #if LL_WINDOWS
     boost::filesystem::path cache_path(ll_convert_string_to_wide(mCacheDir));
 #else
@@ -133,100 +515,174 @@ void LLDiskCache::purge()
 
                 if (boost::filesystem::is_regular_file(entry, ec) && !ec.failed())
                 {
-                    if (entry.path().string().rfind(mCacheFilenameExt) != std::string::npos)
+                    if (entry.path().extension().string() != mCacheFilenameExt)
                     {
-                        const uintmax_t file_size = boost::filesystem::file_size(entry, ec);
-                        if (ec.failed())
-                        {
-                            LL_WARNS() << "Failed to read file size for cache file " << entry.path().string() << ": " << ec.message() << LL_ENDL;
-                            continue;
-                        }
-                        const std::time_t file_time = boost::filesystem::last_write_time(entry, ec);
-                        if (ec.failed())
-                        {
-                            LL_WARNS() << "Failed to read last write time for cache file " << entry.path().string() << ": " << ec.message() << LL_ENDL;
-                            continue;
-                        }
+                        continue;
+                    }
+                    LLUUID id;
+                    if (!id.set(entry.path().stem().string(), FALSE))
+                    {
+                        continue;
+                    }
 
-                        file_info.push_back(file_info_t(file_time, { file_size, entry.path() }));
+                    const uintmax_t file_size = boost::filesystem::file_size(entry, ec);
+                    if (ec.failed())
+                    {
+                        LL_WARNS() << "Failed to read file size for cache file " << entry.path().string() << ": " << ec.message() << LL_ENDL;
+                        continue;
                     }
+                    const std::time_t file_time = boost::filesystem::last_write_time(entry, ec);
+                    if (ec.failed())
+                    {
+                        LL_WARNS() << "Failed to read last write time for cache file " << entry.path().string() << ": " << ec.message() << LL_ENDL;
+                        continue;
+                    }
+
+                    file_info.push_back(file_info_t(file_time, { file_size, id }));
                 }
             }
         }
     }
 
+    // newest first, so that older files go further down the LRU
     std::sort(file_info.begin(), file_info.end(), [](const file_info_t& x, const file_info_t& y)
     {
         return x.first > y.first;
     });
 
-    LL_INFOS() << "Purging cache to a maximum of " << mMaxSizeBytes << " bytes" << LL_ENDL;
+    LLMutexLock lock(&mIndexMutex);
 
-    // Extra accounting to track the retention of static assets
-    std::vector<bool> file_removed;
-    if (mEnableCacheDebugInfo)
+    // Forget the files that are gone, unless they were indexed while we
+    // were walking the directory
+    boost::unordered_flat_set<LLUUID> found;
+    found.reserve(file_info.size());
+    for (const file_info_t& info : file_info)
     {
-        file_removed.reserve(file_info.size());
+        found.insert(info.second.second);
     }
-
-    uintmax_t file_size_total = 0;
-    for (const file_info_t& entry : file_info)
+    for (lru_list_t::iterator iter = mLRU.begin(); iter != mLRU.end(); )
     {
-        if (!LLApp::isRunning())
+        lru_list_t::iterator cur = iter++;
+        if (cur->mAccessTime < scan_time && !found.count(cur->mID))
         {
-            return;
+            mTotalSize -= cur->mSize;
+            mEntries.erase(cur->mID);
+            mLRU.erase(cur);
         }
+    }
 
-        file_size_total += entry.second.first;
-
-        bool should_remove = file_size_total > mMaxSizeBytes;
-        if (mEnableCacheDebugInfo)
+    // and add the files the index did not know about as the least recently used
+    U32 added = 0;
+    for (const file_info_t& info : file_info)
+    {
+        const LLUUID& id = info.second.second;
+        if (mEntries.find(id) == mEntries.end())
         {
-            file_removed.push_back(should_remove);
+            mLRU.push_back({ id, LLAssetType::AT_UNKNOWN, info.second.first, info.first });
+            mEntries[id] = std::prev(mLRU.end());
+            mTotalSize += info.second.first;
+            ++added;
         }
+    }
 
-        if (should_remove)
-        {
-            boost::filesystem::remove(entry.second.second, ec);
-            if (ec.failed())
-            {
-                LL_WARNS() << "Failed to delete cache file " << entry.second.second << ": " << ec.message() << LL_ENDL;
-                continue;
-            }
-        }
+    mRescanTime = scan_time;
+    mNeedsRescan = false;
+    writeSnapshot();
+
+    auto end_time = std::chrono::high_resolution_clock::now();
+    auto execute_time = std::chrono::duration_cast<std::chrono::milliseconds>(end_time - start_time).count();
+    LL_INFOS() << "Disk cache indexed from " << file_info.size() << " files in " << execute_time
+               << " ms, " << added << " were missing from the journal" << LL_ENDL;
+}
+
+bool LLDiskCache::writeSnapshot()
+{
+    closeJournal();
+
+    std::string tmp_file_name = mJournalFileName + ".tmp";
+    LLFILE* file = LLFile::fopen(tmp_file_name, "wb");
+    if (!file)
+    {
+        LL_WARNS() << "Unable to write disk cache journal " << tmp_file_name << LL_ENDL;
+        return false;
     }
 
-    if (mEnableCacheDebugInfo)
+    JournalHeader header = {};
+    memcpy(header.mMagic, JOURNAL_MAGIC, sizeof(JOURNAL_MAGIC));
+    header.mVersion = JOURNAL_VERSION;
+    header.mRescanTime = (U64)mRescanTime;
+    bool success = fwrite(&header, sizeof(header), 1, file) == 1;
+
+    // least recently used first, so that replaying restores the order
+    JournalRecord record = {};
+    record.mOp = JOURNAL_ADD;
+    for (lru_list_t::reverse_iterator iter = mLRU.rbegin(); success && iter != mLRU.rend(); ++iter)
     {
-        auto end_time = std::chrono::high_resolution_clock::now();
-        auto execute_time = std::chrono::duration_cast<std::chrono::milliseconds>(end_time - start_time).count();
+        record.mType = (S8)iter->mType;
+        record.mTime = (U32)iter->mAccessTime;
+        record.mID = iter->mID;
+        record.mSize = (U32)iter->mSize;
+        record.mCheck = record_check(record);
+        success = fwrite(&record, sizeof(record), 1, file) == 1;
+    }
+    success = fclose(file) == 0 && success;
 
-        // Log afterward so it doesn't affect the time measurement
-        // Logging thousands of file results can take hundreds of milliseconds
-        for (size_t i = 0; i < file_info.size(); ++i)
-        {
-            if (!LLApp::isRunning())
-            {
-                return;
-            }
+    if (success)
+    {
+        LLFile::remove(mJournalFileName, ENOENT);
+        success = LLFile::rename(tmp_file_name, mJournalFileName) == 0;
+    }
+    if (!success)
+    {
+        LL_WARNS() << "Failed to write disk cache journal " << mJournalFileName << LL_ENDL;
+        LLFile::remove(tmp_file_name, ENOENT);
+        return false;
+    }
 
-            const file_info_t& entry = file_info[i];
-            const bool removed = file_removed[i];
-            const std::string action = removed ? "DELETE:" : "KEEP:";
+    mJournalRecords = (U32)mEntries.size();
+    mJournal = LLFile::fopen(mJournalFileName, "ab");
+    return mJournal != nullptr;
+}
 
-            // have to do this because of LL_INFO/LL_END weirdness
-            std::ostringstream line;
+void LLDiskCache::appendRecord(U8 op, const Entry& entry, bool flush)
+{
+    if (!mJournal)
+    {
+        return;
+    }
 
-            line << action << "  ";
-            line << entry.first << "  ";
-            line << entry.second.first << "  ";
-            line << entry.second.second;
-            line << " (" << file_size_total << "/" << mMaxSizeBytes << ")";
-            LL_INFOS() << line.str() << LL_ENDL;
-        }
+    JournalRecord record = {};
+    record.mOp = op;
+    record.mType = (S8)entry.mType;
+    record.mTime = (U32)entry.mAccessTime;
+    record.mID = entry.mID;
+    record.mSize = (U32)entry.mSize;
+    record.mCheck = record_check(record);
+    if (fwrite(&record, sizeof(record), 1, mJournal) != 1 || (flush && fflush(mJournal) != 0))
+    {
+        discardJournal();
+        return;
+    }
+    ++mJournalRecords;
+}
 
-        LL_INFOS() << "Total dir size after purge is " << dirFileSize(mCacheDir) << LL_ENDL;
-        LL_INFOS() << "Cache purge took " << execute_time << " ms to execute for " << file_info.size() << " files" << LL_ENDL;
+void LLDiskCache::discardJournal()
+{
+    // A short write leaves part of a record that replaying would misread,
+    // and the records after it would be missing anyway.  Without a journal
+    // the next start indexes the cache from its files.
+    LL_WARNS() << "Failed to append to disk cache journal " << mJournalFileName
+               << ", it is dropped until the next snapshot" << LL_ENDL;
+    closeJournal();
+    LLFile::remove(mJournalFileName, ENOENT);
+}
+
+void LLDiskCache::closeJournal()
+{
+    if (mJournal)
+    {
+        fclose(mJournal);
+        mJournal = nullptr;
     }
 }
 
@@ -292,53 +748,14 @@ const boost::filesystem::path LLDiskCache::metaDataToFilepath(const LLUUID& id,
 #endif
 }
 
-// static
-void LLDiskCache::updateFileAccessTime(const boost::filesystem::path& file_path)
+const std::string LLDiskCache::getCacheInfo()
 {
-    /**
-     * Threshold in time_t units that is used to decide if the last access time
-     * time of the file is updated or not. Added as a precaution for the concern
-     * outlined in SL-14582  about frequent writes on older SSDs reducing their
-     * lifespan. I think this is the right place for the threshold value - rather
-     * than it being a pref - do comment on that Jira if you disagree...
-     *
-     * Let's start with 1 hour in time_t units and see how that unfolds
-     */
-    static const std::time_t time_threshold = 1 * 60 * 60;
-
-    // current time
-    const std::time_t cur_time = std::time(nullptr);
-
-    boost::system::error_code ec;
-
-    // file last write time
-    const std::time_t last_write_time = boost::filesystem::last_write_time(file_path, ec);
-    if (ec.failed())
+    uintmax_t cache_used_mb;
     {
-        LL_WARNS() << "Failed to read last write time for cache file " << file_path << ": " << ec.message() << LL_ENDL;
-        return;
+        LLMutexLock lock(&mIndexMutex);
+        cache_used_mb = mTotalSize / (1024U * 1024U);
     }
 
-    // delta between cur time and last time the file was written
-    const std::time_t delta_time = cur_time - last_write_time;
-
-    // we only write the new value if the time in time_threshold has elapsed
-    // before the last one
-    if (delta_time > time_threshold)
-    {
-        boost::filesystem::last_write_time(file_path, cur_time, ec);
-    }
-
-    if (ec.failed())
-    {
-        LL_WARNS() << "Failed to update last write time for cache file " << file_path << ": " << ec.message() << LL_ENDL;
-    }
-}
-
-const std::string LLDiskCache::getCacheInfo()
-{
-    uintmax_t cache_used_mb = dirFileSize(mCacheDir) / (1024U * 1024U);
-
     uintmax_t max_in_mb = mMaxSizeBytes / (1024U * 1024U);
     F64 percent_used = ((F64)cache_used_mb / (F64)max_in_mb) * 100.0;
 
@@ -351,6 +768,11 @@ void LLDiskCache::clearCache(ELLPath location, bool recreate_cache)
     {
         std::string disk_cache_dir = gDirUtilp->getExpandedFilename(location, DISK_CACHE_DIR_NAME);
 
+        // the journal goes with the files
+        LLMutexLock lock(&mIndexMutex);
+        closeJournal();
+        clearIndex();
+
         const char* subdirs = "0123456789abcdef";
         std::string delem = gDirUtilp->getDirDelimiter();
         std::string mask = "*";
@@ -371,6 +793,13 @@ void LLDiskCache::clearCache(ELLPath location, bool recreate_cache)
         {
             createCache();
         }
+        if (!mJournalFileName.empty() && disk_cache_dir == mCacheDir)
+        {
+            // start over with an empty journal
+            mRescanTime = std::time(nullptr);
+            mNeedsRescan = false;
+            writeSnapshot();
+        }
     }
 }
 
@@ -22,12 +22,18 @@
                     that identifies the type of asset being stored.
         .asset      A file extension of .asset is used to help
                     identify this as a Viewer asset file
- * 2/ The time of last access for a file can be updated instantly
- *    for file reads and automatically as part of the file writes.
- * 3/ The purge algorithm collects a list of all files in the
- *    directory, sorts them by date of last access (write) and then
- *    deletes any files based on age until the total size of all
- *    the files is less than the maximum size specified.
+ * 2/ LLFileSystem reports every write, read and removal of a cache
+ *    file so that an in-memory index keeps the files in least
+ *    recently used order along with their size. The index is
+ *    persisted in a journal file in the cache directory: records are
+ *    appended as things change and the journal is rewritten as a
+ *    snapshot of the index when it grows too long.
+ * 3/ The purge algorithm deletes the least recently used files until
+ *    the total size of all the files is less than the maximum size
+ *    specified. The cache directory is only walked when the journal
+ *    is missing or corrupted, and once a week to pick up files the
+ *    journal does not know about (written by a second instance for
+ *    example).
  * 4/ An LLSingleton idiom is used since there will only ever be
  *    a single cache and we want to access it from numerous places.
  * 5/ Performance on my modest system seems very acceptable. For
@@ -63,11 +69,15 @@
 #define _LLDISKCACHE
 
 #include "llsingleton.h"
+#include "llmutex.h"
 #include "lluuid.h"
 #include "lldir.h"
 
+#include "boost/unordered/unordered_flat_map.hpp"
 #include "boost/unordered/unordered_flat_set.hpp"
 
+#include <list>
+
 class LLDiskCache final :
     public LLSimpleton<LLDiskCache>
 {
@@ -80,7 +90,7 @@ class LLDiskCache final :
          * the class via a call in LLAppViewer.
          */
         LLDiskCache();
-        virtual ~LLDiskCache() = default;
+        virtual ~LLDiskCache();
 public:
         void init(
             /**
@@ -114,18 +124,27 @@ class LLDiskCache final :
                                              LLAssetType::EType at);
 
         /**
-         * Update the "last write time" of a file to "now". This must be called whenever a
-         * file in the cache is read (not written) so that the last time the file was
-         * accessed is up to date (This is used in the mechanism for purging the cache)
+         * Keep the index up to date. addEntry() must be called whenever a file in
+         * the cache is written and touchEntry() whenever one is read so that the
+         * least recently used files are the ones purged. Thread safe.
+         */
+        void addEntry(const LLUUID& id, LLAssetType::EType at, uintmax_t size);
+        void touchEntry(const LLUUID& id);
+        void removeEntry(const LLUUID& id);
+
+        /**
+         * Index queries. Thread safe.
          */
-        static void updateFileAccessTime(const boost::filesystem::path& file_path);
+        bool hasEntry(const LLUUID& id);
+        size_t getEntryCount();
+        uintmax_t getTotalSize();
 
         /**
          * Purge the oldest items in the cache so that the combined size of all files
          * is no bigger than mMaxSizeBytes.
          *
          * WARNING: purge() is called by LLPurgeDiskCacheThread. As such it must
-         * NOT touch any LLDiskCache data without introducing and locking a mutex!
+         * NOT touch any LLDiskCache data without locking mIndexMutex!
          *
          * Purging the disk cache involves nontrivial work on the viewer's
          * filesystem. If called on the main thread, this causes a noticeable
@@ -168,6 +187,39 @@ class LLDiskCache final :
          */
         void createCache();
 
+        /**
+         * One file of the cache, in mLRU
+         */
+        struct Entry
+        {
+            LLUUID mID;
+            LLAssetType::EType mType;
+            uintmax_t mSize;
+            std::time_t mAccessTime;
+        };
+
+        /**
+         * Index maintenance, the functions below expect mIndexMutex to be locked
+         */
+        void setEntry(const Entry& entry);
+        void eraseEntry(const LLUUID& id);
+        void clearIndex();
+
+        /**
+         * Journal handling: loadIndex() replays the journal when the cache
+         * is initialized, rescanIndex() rebuilds the index from the files
+         * in the cache directory when the journal can not be trusted and
+         * writeSnapshot() replaces the journal with the content of the index.
+         * discardJournal() deletes a journal that could not be appended to.
+         */
+        void loadIndex();
+        bool readJournal(std::time_t& rescan_time);
+        void rescanIndex();
+        bool writeSnapshot();
+        void appendRecord(U8 op, const Entry& entry, bool flush);
+        void discardJournal();
+        void closeJournal();
+
 
     private:
         /**
@@ -202,6 +254,31 @@ class LLDiskCache final :
         bool mEnableCacheDebugInfo = false;
 
         bool mReadOnly = false;
+
+        /**
+         * The index: mLRU holds all the files in the cache, most recently used
+         * first, and mEntries maps their IDs to their place in mLRU.
+         */
+        typedef std::list<Entry> lru_list_t;
+        lru_list_t mLRU;
+        boost::unordered_flat_map<LLUUID, lru_list_t::iterator> mEntries;
+        uintmax_t mTotalSize = 0;
+        LLMutex mIndexMutex;
+
+        /**
+         * The files the purge in progress took out of the index, until it is
+         * done removing them. See addEntry().
+         */
+        boost::unordered_flat_set<LLUUID> mPurging;
+
+        /**
+         * The journal keeping the index across sessions
+         */
+        std::string mJournalFileName;
+        LLFILE* mJournal = nullptr;
+        U32 mJournalRecords = 0;
+        std::time_t mRescanTime = 0;
+        bool mNeedsRescan = false;
 };
 
 class LLPurgeDiskCacheThread : public LLThread
@@ -54,16 +54,11 @@ LLFileSystem::LLFileSystem(const LLUUID& file_id, const LLAssetType::EType file_
     // we decided to follow Henri's suggestion and move the code to update the last access time here.
     if (mode == LLFileSystem::READ)
     {
-        // update the last access time for the file if it exists - this is required
+        // move the file up the cache's LRU if it is there - this is required
         // even though we are reading and not writing because this is the
         // way the cache works - it relies on a valid "last accessed time" for
         // each file so it knows how to remove the oldest, unused files
-        boost::system::error_code ec;
-        bool exists = boost::filesystem::exists(mFilePath, ec);
-        if (exists && !ec.failed())
-        {
-            LLDiskCache::updateFileAccessTime(mFilePath);
-        }
+        LLDiskCache::getInstance()->touchEntry(file_id);
     }
 }
 
@@ -85,6 +80,7 @@ bool LLFileSystem::removeFile(const LLUUID& file_id, const LLAssetType::EType fi
     const boost::filesystem::path filename = LLDiskCache::getInstance()->metaDataToFilepath(file_id, file_type);
 
     LLFile::remove(filename, suppress_error);
+    LLDiskCache::getInstance()->removeEntry(file_id);
 
     return true;
 }
@@ -149,6 +145,7 @@ BOOL LLFileSystem::eof()
 BOOL LLFileSystem::write(const U8* buffer, S32 bytes)
 {
     BOOL success = FALSE;
+    S32 file_size = 0;
 
     if (mMode == APPEND)
     {
@@ -157,6 +154,7 @@ BOOL LLFileSystem::write(const U8* buffer, S32 bytes)
         {
             S32 bytes_written = fwrite(buffer, 1, bytes, ofs);
             mPosition = ftell(ofs);
+            file_size = mPosition;
             fclose(ofs);
             success = (bytes_written == bytes);
         }
@@ -170,6 +168,9 @@ BOOL LLFileSystem::write(const U8* buffer, S32 bytes)
             {
                 S32 bytes_written = fwrite(buffer, 1, bytes, ofs);
                 mPosition = ftell(ofs);
+                // we may have written in the middle of the file
+                fseek(ofs, 0, SEEK_END);
+                file_size = ftell(ofs);
                 fclose(ofs);
                 success = (bytes_written == bytes);
             }
@@ -181,6 +182,7 @@ BOOL LLFileSystem::write(const U8* buffer, S32 bytes)
             {
                 S32 bytes_written = fwrite(buffer, 1, bytes, ofs);
                 mPosition = ftell(ofs);
+                file_size = mPosition;
                 fclose(ofs);
                 success = (bytes_written == bytes);
             }
@@ -193,11 +195,16 @@ BOOL LLFileSystem::write(const U8* buffer, S32 bytes)
         {
             S32 bytes_written = fwrite(buffer, 1, bytes, ofs);
             mPosition = ftell(ofs);
+            file_size = mPosition;
             fclose(ofs);
             success = (bytes_written == bytes);
         }
     }
 
+    if (file_size > 0)
+    {
+        LLDiskCache::getInstance()->addEntry(mFileID, mFileType, file_size);
+    }
 
     return success;
 }
@@ -275,6 +282,17 @@ BOOL LLFileSystem::rename(const LLUUID& new_id, const LLAssetType::EType new_typ
         // break a lot of things so we go with the flow...
         //return FALSE;
         LL_WARNS() << "Failed to rename " << mFileID << " to " << new_id << " reason: "  << ec.what() << LL_ENDL;
+        // the new file was removed above
+        LLDiskCache::getInstance()->removeEntry(new_id);
+    }
+    else
+    {
+        LLDiskCache::getInstance()->removeEntry(mFileID);
+        uintmax_t file_size = boost::filesystem::file_size(new_filename, ec);
+        if (!ec.failed())
+        {
+            LLDiskCache::getInstance()->addEntry(new_id, new_type, file_size);
+        }
     }
 
     mFileID = new_id;
@@ -288,5 +306,6 @@ BOOL LLFileSystem::remove()
 {
     boost::system::error_code ec;
     boost::filesystem::remove(mFilePath, ec);
+    LLDiskCache::getInstance()->removeEntry(mFileID);
     return TRUE;
 }
@@ -0,0 +1,232 @@
+/**
+ * @file llmappedfile.cpp
+ * @brief Fixed size memory mapping of a file
+ *
+ * $LicenseInfo:firstyear=2024&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2024, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#include "linden_common.h"
+
+#include "llmappedfile.h"
+
+#if LL_WINDOWS
+#include "llwin32headerslean.h"
+#include "llstring.h"
+#else
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+LLMappedFile::LLMappedFile()
+    : mData(nullptr),
+      mSize(0),
+      mWritable(false),
+#if LL_WINDOWS
+      mFile(INVALID_HANDLE_VALUE),
+      mMapping(NULL)
+#else
+      mFile(-1)
+#endif
+{
+}
+
+LLMappedFile::~LLMappedFile()
+{
+    close();
+}
+
+#if LL_WINDOWS
+
+bool LLMappedFile::open(const std::string& filename, size_t size, bool writable)
+{
+    close();
+    if (!size)
+    {
+        return false;
+    }
+
+    std::wstring utf16filename = ll_convert_string_to_wide(filename);
+    mFile = CreateFileW(utf16filename.c_str(),
+                        writable ? GENERIC_READ | GENERIC_WRITE : GENERIC_READ,
+                        FILE_SHARE_READ | FILE_SHARE_WRITE,
+                        NULL,
+                        writable ? OPEN_ALWAYS : OPEN_EXISTING,
+                        FILE_ATTRIBUTE_NORMAL,
+                        NULL);
+    if (mFile == INVALID_HANDLE_VALUE)
+    {
+        LL_WARNS() << "Unable to open " << filename << " error: " << GetLastError() << LL_ENDL;
+        return false;
+    }
+
+    LARGE_INTEGER file_size;
+    if (!writable && (!GetFileSizeEx(mFile, &file_size) || (U64)file_size.QuadPart < size))
+    {
+        // a read only mapping can not extend the file
+        close();
+        return false;
+    }
+
+    // a writable mapping larger than the file extends it
+    U64 map_size = size;
+    mMapping = CreateFileMappingW(mFile, NULL, writable ? PAGE_READWRITE : PAGE_READONLY,
+                                  (DWORD)(map_size >> 32), (DWORD)(map_size & 0xFFFFFFFF), NULL);
+    if (!mMapping)
+    {
+        LL_WARNS() << "CreateFileMapping failed for " << filename << " error: " << GetLastError() << LL_ENDL;
+        close();
+        return false;
+    }
+
+    mData = (U8*)MapViewOfFile(mMapping, writable ? FILE_MAP_WRITE : FILE_MAP_READ, 0, 0, size);
+    if (!mData)
+    {
+        LL_WARNS() << "MapViewOfFile failed for " << filename << " error: " << GetLastError() << LL_ENDL;
+        close();
+        return false;
+    }
+
+    mFileName = filename;
+    mSize = size;
+    mWritable = writable;
+    return true;
+}
+
+void LLMappedFile::close()
+{
+    if (mData)
+    {
+        UnmapViewOfFile(mData);
+        mData = nullptr;
+    }
+    if (mMapping)
+    {
+        CloseHandle(mMapping);
+        mMapping = NULL;
+    }
+    if (mFile != INVALID_HANDLE_VALUE)
+    {
+        CloseHandle(mFile);
+        mFile = INVALID_HANDLE_VALUE;
+    }
+    mSize = 0;
+    mWritable = false;
+    mFileName.clear();
+}
+
+bool LLMappedFile::flush(bool async)
+{
+    if (!mData || !mWritable)
+    {
+        return false;
+    }
+    bool res = FlushViewOfFile(mData, mSize) != 0;
+    if (res && !async)
+    {
+        res = FlushFileBuffers(mFile) != 0;
+    }
+    return res;
+}
+
+#else // LL_WINDOWS
+
+bool LLMappedFile::open(const std::string& filename, size_t size, bool writable)
+{
+    close();
+    if (!size)
+    {
+        return false;
+    }
+
+    mFile = ::open(filename.c_str(), writable ? O_RDWR | O_CREAT : O_RDONLY, 0644);
+    if (mFile < 0)
+    {
+        LL_WARNS() << "Unable to open " << filename << " errno: " << errno << LL_ENDL;
+        return false;
+    }
+
+    struct stat st;
+    if (fstat(mFile, &st) != 0)
+    {
+        close();
+        return false;
+    }
+    if ((size_t)st.st_size < size)
+    {
+        // extending leaves a sparse file on most file systems, the
+        // blocks only get allocated once written
+        if (!writable || ftruncate(mFile, (off_t)size) != 0)
+        {
+            if (writable)
+            {
+                LL_WARNS() << "Unable to size " << filename << " to " << size << " errno: " << errno << LL_ENDL;
+            }
+            close();
+            return false;
+        }
+    }
+
+    void* data = ::mmap(NULL, size, writable ? PROT_READ | PROT_WRITE : PROT_READ, MAP_SHARED, mFile, 0);
+    if (data == MAP_FAILED)
+    {
+        LL_WARNS() << "mmap failed for " << filename << " errno: " << errno << LL_ENDL;
+        close();
+        return false;
+    }
+
+    mData = (U8*)data;
+    mFileName = filename;
+    mSize = size;
+    mWritable = writable;
+    return true;
+}
+
+void LLMappedFile::close()
+{
+    if (mData)
+    {
+        ::munmap(mData, mSize);
+        mData = nullptr;
+    }
+    if (mFile >= 0)
+    {
+        ::close(mFile);
+        mFile = -1;
+    }
+    mSize = 0;
+    mWritable = false;
+    mFileName.clear();
+}
+
+bool LLMappedFile::flush(bool async)
+{
+    if (!mData || !mWritable)
+    {
+        return false;
+    }
+    return ::msync(mData, mSize, async ? MS_ASYNC : MS_SYNC) == 0;
+}
+
+#endif // LL_WINDOWS
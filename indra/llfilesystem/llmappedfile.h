@@ -0,0 +1,73 @@
+/**
+ * @file llmappedfile.h
+ * @brief Fixed size memory mapping of a file
+ *
+ * $LicenseInfo:firstyear=2024&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2024, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#ifndef LL_LLMAPPEDFILE_H
+#define LL_LLMAPPEDFILE_H
+
+#include <string>
+
+// Maps the first getSize() bytes of a file into memory.  The mapping never
+// moves while the file is open, so pointers into getData() stay valid
+// until close().  Writes through a writable mapping reach the file when
+// the OS gets around to it, or on flush().
+class LLMappedFile
+{
+public:
+    LLMappedFile();
+    ~LLMappedFile();
+
+    LLMappedFile(const LLMappedFile&) = delete;
+    LLMappedFile& operator=(const LLMappedFile&) = delete;
+
+    // Opens filename, creating it if writable, and maps size bytes of it.
+    // A writable file shorter than size is extended with zeros.
+    bool open(const std::string& filename, size_t size, bool writable = true);
+    void close();
+
+    // Write dirty pages back to the file.  With async the call only
+    // schedules the writes.
+    bool flush(bool async = true);
+
+    bool isOpen() const                     { return mData != nullptr; }
+    bool isWritable() const                 { return mWritable; }
+    U8* getData() const                     { return mData; }
+    size_t getSize() const                  { return mSize; }
+    const std::string& getFileName() const  { return mFileName; }
+
+private:
+    std::string mFileName;
+    U8* mData;
+    size_t mSize;
+    bool mWritable;
+#if LL_WINDOWS
+    void* mFile;
+    void* mMapping;
+#else
+    int mFile;
+#endif
+};
+
+#endif // LL_LLMAPPEDFILE_H
@@ -0,0 +1,804 @@
+/**
+ * @file llslabcache.cpp
+ * @brief UUID keyed blob cache stored in a few memory mapped slab files
+ *
+ * $LicenseInfo:firstyear=2024&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2024, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#include "linden_common.h"
+
+#include "llslabcache.h"
+
+#include "lldir.h"
+#include "llformat.h"
+#include "llmemory.h"
+
+namespace
+{
+    const U32 SLAB_MAGIC = 0x42414c53;      // "SLAB"
+    const U32 SLAB_VERSION = 1;
+    const U32 SLAB_COMPACTING = 0x1;
+
+    const U32 RECORD_MAGIC = 0x44524352;    // "RCRD"
+    const U32 RECORD_DELETED = 0x1;
+    const U32 RECORD_ALIGN = 64;
+
+    const U64 EMPTY_SLOT = 0;
+    const U64 TOMBSTONE_SLOT = 1;
+
+    // Live slots always have a non zero tag, which keeps them clear of
+    // EMPTY_SLOT and TOMBSTONE_SLOT.
+    inline U32 make_tag(U64 digest)
+    {
+        return (U32)(digest >> 32) | 1;
+    }
+
+    inline U64 make_location(U32 slab, U64 offset)
+    {
+        return ((U64)slab << 24) | (offset / RECORD_ALIGN);
+    }
+
+    inline U64 make_slot(U32 tag, U64 location)
+    {
+        return ((U64)tag << 32) | location;
+    }
+
+    inline U32 slot_tag(U64 slot)           { return (U32)(slot >> 32); }
+    inline U64 slot_location(U64 slot)      { return slot & 0xFFFFFFFF; }
+    inline U32 location_slab(U64 location)  { return (U32)(location >> 24); }
+    inline U64 location_offset(U64 location) { return (location & 0xFFFFFF) * RECORD_ALIGN; }
+
+    inline size_t align_record(size_t size)
+    {
+        return (size + RECORD_ALIGN - 1) & ~(size_t)(RECORD_ALIGN - 1);
+    }
+
+    // true when stamp is more recent than since (serials may wrap)
+    inline bool more_recent(U32 stamp, U32 since)
+    {
+        return (S32)(stamp - since) > 0;
+    }
+}
+
+struct LLSlabCache::SlabHeader
+{
+    U32 mMagic;
+    U32 mVersion;
+    U64 mSlabSize;
+    U64 mUsed;          // end of the last record
+    U64 mFilledSerial;  // write serial when the slab filled up, 0 while still written to
+    U32 mFlags;
+    U32 mPad[7];
+};
+
+struct LLSlabCache::RecordHeader
+{
+    U32 mMagic;         // written last, so torn appends are never indexed
+    U32 mFlags;
+    LLUUID mID;
+    U64 mSerial;        // the newest record of an id wins when indexing
+    S32 mMeta;
+    S32 mHeadSize;
+    S32 mBodySize;
+    U32 mSize;          // whole record, aligned
+    U32 mPad[4];
+};
+
+LLSlabCache::LLSlabCache()
+    : mSlabSize(0),
+      mReadOnly(true),
+      mSlotMask(0),
+      mTombstones(0),
+      mIndexGeneration(0),
+      mWriteSlab(0),
+      mSerial(1),
+      mUsage(0),
+      mEntries(0),
+      mCompactions(0)
+{
+    static_assert(sizeof(SlabHeader) == RECORD_ALIGN, "slab header must keep records aligned");
+    static_assert(sizeof(RecordHeader) == RECORD_ALIGN, "record header must keep records aligned");
+}
+
+LLSlabCache::~LLSlabCache()
+{
+    close();
+}
+
+bool LLSlabCache::open(const std::string& dir, const std::string& prefix, U32 slab_count, size_t slab_size,
+                       U32 max_entries, bool read_only)
+{
+    close();
+
+    slab_size &= ~(size_t)(RECORD_ALIGN - 1);
+    if (!slab_count || slab_count > MAX_SLABS || slab_size > MAX_SLAB_SIZE || slab_size < 16 * RECORD_ALIGN)
+    {
+        LL_WARNS() << "Bad slab cache layout: " << slab_count << " slabs of " << slab_size << " bytes" << LL_ENDL;
+        return false;
+    }
+
+    LLMutexLock lock(&mWriteMutex);
+
+    mDir = dir;
+    mPrefix = prefix;
+    mSlabSize = slab_size;
+    mReadOnly = read_only;
+
+    for (U32 i = 0; i < slab_count; ++i)
+    {
+        std::unique_ptr<Slab> slab = std::make_unique<Slab>();
+        std::string filename = gDirUtilp->add(dir, prefix + llformat("%02u.slab", i));
+        if (!slab->mFile.open(filename, slab_size, !read_only))
+        {
+            if (!read_only || mSlabs.empty())
+            {
+                LL_WARNS() << "Unable to map slab " << filename << LL_ENDL;
+                mSlabs.clear();
+                return false;
+            }
+            // a read only cache uses whatever slabs exist
+            break;
+        }
+
+        SlabHeader* header = (SlabHeader*)slab->mFile.getData();
+        bool valid = header->mMagic == SLAB_MAGIC && header->mVersion == SLAB_VERSION &&
+                     header->mSlabSize == slab_size && header->mUsed >= sizeof(SlabHeader) &&
+                     header->mUsed <= slab_size && !(header->mFlags & SLAB_COMPACTING);
+        if (!valid && !read_only)
+        {
+            // new, resized or interrupted mid compaction: start over
+            memset(header, 0, sizeof(SlabHeader));
+            header->mMagic = SLAB_MAGIC;
+            header->mVersion = SLAB_VERSION;
+            header->mSlabSize = slab_size;
+            header->mUsed = sizeof(SlabHeader);
+        }
+        else if (!valid)
+        {
+            break;
+        }
+        mSlabs.push_back(std::move(slab));
+    }
+    if (mSlabs.empty())
+    {
+        return false;
+    }
+
+    U32 capacity = 1024;
+    while (capacity < max_entries * 2 && capacity < (1u << 30))
+    {
+        capacity <<= 1;
+    }
+    mSlots.reset(new std::atomic<U64>[capacity]());
+    mAccess.reset(new std::atomic<U32>[capacity]());
+    mSlotMask = capacity - 1;
+
+    rebuildIndex();
+
+    // keep filling the slab that was being written to
+    mWriteSlab = 0;
+    U64 best_used = 0;
+    for (U32 i = 0; i < mSlabs.size(); ++i)
+    {
+        SlabHeader* header = getSlabHeader(i);
+        if (!header->mFilledSerial && header->mUsed > best_used)
+        {
+            mWriteSlab = i;
+            best_used = header->mUsed;
+        }
+    }
+
+    LL_INFOS() << "Slab cache " << gDirUtilp->add(dir, prefix) << ": " << mSlabs.size() << " slabs, "
+               << mEntries << " entries, " << mUsage / (1024 * 1024) << " MB" << LL_ENDL;
+    return true;
+}
+
+void LLSlabCache::close()
+{
+    LLMutexLock lock(&mWriteMutex);
+    mSlabs.clear();
+    mSlots.reset();
+    mAccess.reset();
+    mSlotMask = 0;
+    mTombstones = 0;
+    mUsage = 0;
+    mEntries = 0;
+}
+
+//static
+void LLSlabCache::removeFiles(const std::string& dir, const std::string& prefix)
+{
+    gDirUtilp->deleteFilesInDir(dir, prefix + "*.slab");
+}
+
+LLSlabCache::SlabHeader* LLSlabCache::getSlabHeader(U32 slab) const
+{
+    return (SlabHeader*)mSlabs[slab]->mFile.getData();
+}
+
+LLSlabCache::RecordHeader* LLSlabCache::getRecord(U64 location) const
+{
+    return (RecordHeader*)(mSlabs[location_slab(location)]->mFile.getData() + location_offset(location));
+}
+
+//----------------------------------------------------------------------------
+// Index, mWriteMutex must be locked
+
+S32 LLSlabCache::findSlot(const LLUUID& id, U64 digest) const
+{
+    U32 tag = make_tag(digest);
+    U32 i = (U32)digest & mSlotMask;
+    for (U32 n = 0; n <= mSlotMask; ++n, i = (i + 1) & mSlotMask)
+    {
+        U64 slot = mSlots[i].load(std::memory_order_relaxed);
+        if (slot == EMPTY_SLOT)
+        {
+            break;
+        }
+        if (slot != TOMBSTONE_SLOT && slot_tag(slot) == tag && getRecord(slot_location(slot))->mID == id)
+        {
+            return i;
+        }
+    }
+    return -1;
+}
+
+S32 LLSlabCache::insertSlot(const LLUUID& id, U64 digest, U64 location)
+{
+    U32 tag = make_tag(digest);
+    S32 free_slot = -1;
+    U32 i = (U32)digest & mSlotMask;
+    for (U32 n = 0; n <= mSlotMask; ++n, i = (i + 1) & mSlotMask)
+    {
+        U64 slot = mSlots[i].load(std::memory_order_relaxed);
+        if (slot == EMPTY_SLOT)
+        {
+            if (free_slot < 0)
+            {
+                free_slot = i;
+            }
+            break;
+        }
+        if (slot == TOMBSTONE_SLOT)
+        {
+            if (free_slot < 0)
+            {
+                free_slot = i;
+            }
+        }
+        else if (slot_tag(slot) == tag && getRecord(slot_location(slot))->mID == id)
+        {
+            mSlots[i].store(make_slot(tag, location), std::memory_order_release);
+            return i;
+        }
+    }
+
+    if (free_slot >= 0)
+    {
+        if (mSlots[free_slot].load(std::memory_order_relaxed) == TOMBSTONE_SLOT)
+        {
+            --mTombstones;
+        }
+        mSlots[free_slot].store(make_slot(tag, location), std::memory_order_release);
+    }
+    return free_slot;
+}
+
+void LLSlabCache::rebuildIndex()
+{
+    // readers see the odd generation and report misses until it is done
+    U32 generation = mIndexGeneration.load(std::memory_order_relaxed);
+    mIndexGeneration.store(generation + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    for (U32 i = 0; i <= mSlotMask; ++i)
+    {
+        mSlots[i].store(EMPTY_SLOT, std::memory_order_relaxed);
+    }
+    mTombstones = 0;
+    mUsage = 0;
+    mEntries = 0;
+
+    for (U32 i = 0; i < mSlabs.size(); ++i)
+    {
+        indexSlab(i);
+    }
+
+    mIndexGeneration.store(generation + 2, std::memory_order_release);
+}
+
+void LLSlabCache::indexSlab(U32 slab)
+{
+    SlabHeader* header = getSlabHeader(slab);
+    U8* data = mSlabs[slab]->mFile.getData();
+    U64 offset = sizeof(SlabHeader);
+    while (offset < header->mUsed)
+    {
+        RecordHeader* record = (RecordHeader*)(data + offset);
+        bool valid = record->mMagic == RECORD_MAGIC &&
+                     record->mSize >= sizeof(RecordHeader) &&
+                     record->mSize % RECORD_ALIGN == 0 &&
+                     offset + record->mSize <= header->mUsed &&
+                     record->mHeadSize >= 0 && record->mBodySize >= 0 &&
+                     sizeof(RecordHeader) + (U64)record->mHeadSize + (U64)record->mBodySize <= record->mSize;
+        if (!valid)
+        {
+            // torn write at the end of the log
+            LL_WARNS() << "Truncating slab " << slab << " at " << offset << " of " << header->mUsed << LL_ENDL;
+            if (!mReadOnly)
+            {
+                header->mUsed = offset;
+            }
+            break;
+        }
+
+        if (!(record->mFlags & RECORD_DELETED) && (mEntries + mTombstones) < mSlotMask)
+        {
+            U64 location = make_location(slab, offset);
+            U64 digest = record->mID.getDigest64();
+            S32 slot = findSlot(record->mID, digest);
+            RecordHeader* older = record;
+            if (slot < 0)
+            {
+                slot = insertSlot(record->mID, digest, location);
+                older = NULL;
+                ++mEntries;
+                mUsage += record->mSize;
+            }
+            else
+            {
+                RecordHeader* existing = getRecord(slot_location(mSlots[slot].load(std::memory_order_relaxed)));
+                if (existing->mSerial < record->mSerial)
+                {
+                    mSlots[slot].store(make_slot(make_tag(digest), location), std::memory_order_release);
+                    mUsage += (S64)record->mSize - (S64)existing->mSize;
+                    older = existing;
+                }
+            }
+            if (older && !mReadOnly)
+            {
+                older->mFlags |= RECORD_DELETED;
+            }
+            if (slot >= 0 && older != record)
+            {
+                mAccess[slot].store((U32)record->mSerial, std::memory_order_relaxed);
+            }
+            if (record->mSerial >= mSerial)
+            {
+                mSerial = record->mSerial + 1;
+            }
+        }
+        offset += record->mSize;
+    }
+}
+
+//----------------------------------------------------------------------------
+// Eviction, mWriteMutex must be locked
+
+U32 LLSlabCache::pickVictim() const
+{
+    // the slab that filled up first holds the least recently written data
+    U32 victim = mWriteSlab;
+    U64 oldest = 0;
+    for (U32 i = 0; i < mSlabs.size(); ++i)
+    {
+        U64 filled = getSlabHeader(i)->mFilledSerial;
+        if (filled && (!oldest || filled < oldest))
+        {
+            victim = i;
+            oldest = filled;
+        }
+    }
+    return victim;
+}
+
+bool LLSlabCache::makeRoom(size_t size)
+{
+    SlabHeader* header = getSlabHeader(mWriteSlab);
+    if (header->mUsed + size <= mSlabSize)
+    {
+        return true;
+    }
+    header->mFilledSerial = mSerial;
+
+    for (U32 i = 0; i < mSlabs.size(); ++i)
+    {
+        header = getSlabHeader(i);
+        if (!header->mFilledSerial && header->mUsed + size <= mSlabSize)
+        {
+            mWriteSlab = i;
+            return true;
+        }
+    }
+
+    // Recycle the oldest slab.  Recently read records survive as long as
+    // they take no more than half of it, so there is always room left.
+    U32 victim = pickVictim();
+    size_t space = mSlabSize - sizeof(SlabHeader);
+    compactSlab(victim, llmin(space / 2, space - size));
+    mWriteSlab = victim;
+    return getSlabHeader(victim)->mUsed + size <= mSlabSize;
+}
+
+void LLSlabCache::compactSlab(U32 slab, size_t keep_limit)
+{
+    Slab& s = *mSlabs[slab];
+    SlabHeader* header = getSlabHeader(slab);
+    U8* data = s.mFile.getData();
+    U32 filled = (U32)header->mFilledSerial;
+
+    U32 generation = s.mGeneration.load(std::memory_order_relaxed);
+    s.mGeneration.store(generation + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    header->mFlags |= SLAB_COMPACTING;
+
+    U64 end = sizeof(SlabHeader);
+    size_t kept = 0;
+    U64 offset = sizeof(SlabHeader);
+    while (offset < header->mUsed)
+    {
+        RecordHeader* record = (RecordHeader*)(data + offset);
+        U32 size = record->mSize;
+        if (!(record->mFlags & RECORD_DELETED))
+        {
+            U64 digest = record->mID.getDigest64();
+            S32 slot = findSlot(record->mID, digest);
+            bool current = slot >= 0 &&
+                           slot_location(mSlots[slot].load(std::memory_order_relaxed)) == make_location(slab, offset);
+            if (!current)
+            {
+                record->mFlags |= RECORD_DELETED;
+                record->mMagic = 0;
+            }
+            else if (more_recent(mAccess[slot].load(std::memory_order_relaxed), filled) && kept + size <= keep_limit)
+            {
+                if (end != offset)
+                {
+                    memmove(data + end, record, size);
+                    mSlots[slot].store(make_slot(make_tag(digest), make_location(slab, end)), std::memory_order_release);
+                    if (offset >= end + size)
+                    {
+                        record->mMagic = 0;
+                    }
+                }
+                end += size;
+                kept += size;
+            }
+            else
+            {
+                dropRecord(slot, record);
+                record->mMagic = 0;
+            }
+        }
+        else
+        {
+            record->mMagic = 0;
+        }
+        offset += size;
+    }
+
+    header->mUsed = end;
+    header->mFilledSerial = 0;
+    header->mFlags &= ~SLAB_COMPACTING;
+    s.mGeneration.store(generation + 2, std::memory_order_release);
+    ++mCompactions;
+}
+
+void LLSlabCache::dropRecord(S32 slot, RecordHeader* record)
+{
+    mSlots[slot].store(TOMBSTONE_SLOT, std::memory_order_release);
+    ++mTombstones;
+    --mEntries;
+    mUsage -= record->mSize;
+    record->mFlags |= RECORD_DELETED;
+}
+
+//----------------------------------------------------------------------------
+
+bool LLSlabCache::write(const LLUUID& id, S32 meta, const U8* head, S32 head_size, const U8* body, S32 body_size)
+{
+    if (mReadOnly || head_size < 0 || body_size < 0)
+    {
+        return false;
+    }
+    size_t size = align_record(sizeof(RecordHeader) + (size_t)head_size + (size_t)body_size);
+    if (size > (mSlabSize - sizeof(SlabHeader)) / 2)
+    {
+        return false;
+    }
+
+    LLMutexLock lock(&mWriteMutex);
+    if (mSlabs.empty())
+    {
+        return false;
+    }
+
+    // keep the index at most 3/4 full
+    U32 limit = (mSlotMask + 1) / 4 * 3;
+    if (mEntries + mTombstones >= limit)
+    {
+        // more records than the index was sized for, drop the oldest
+        // slabs, then get rid of the tombstones
+        for (size_t tries = mSlabs.size(); mEntries >= limit / 2 && tries; --tries)
+        {
+            compactSlab(pickVictim(), 0);
+        }
+        rebuildIndex();
+    }
+
+    if (!makeRoom(size))
+    {
+        return false;
+    }
+
+    SlabHeader* header = getSlabHeader(mWriteSlab);
+    U64 offset = header->mUsed;
+    RecordHeader* record = (RecordHeader*)(mSlabs[mWriteSlab]->mFile.getData() + offset);
+    U64 serial = mSerial++;
+
+    // compaction clears the magic of the space it frees, but a reader
+    // holding a stale location must never see it before the record is whole
+    record->mMagic = 0;
+    std::atomic_thread_fence(std::memory_order_release);
+    record->mFlags = 0;
+    record->mID = id;
+    record->mSerial = serial;
+    record->mMeta = meta;
+    record->mHeadSize = head_size;
+    record->mBodySize = body_size;
+    record->mSize = (U32)size;
+    memset(record->mPad, 0, sizeof(record->mPad));
+    if (head_size)
+    {
+        memcpy(record + 1, head, head_size);
+    }
+    if (body_size)
+    {
+        memcpy((U8*)(record + 1) + head_size, body, body_size);
+    }
+    std::atomic_thread_fence(std::memory_order_release);
+    record->mMagic = RECORD_MAGIC;
+    header->mUsed = offset + size;
+
+    U64 digest = id.getDigest64();
+    S32 old_slot = findSlot(id, digest);
+    RecordHeader* older = old_slot >= 0 ? getRecord(slot_location(mSlots[old_slot].load(std::memory_order_relaxed))) : NULL;
+    S32 slot = insertSlot(id, digest, make_location(mWriteSlab, offset));
+    if (slot < 0)
+    {
+        record->mFlags |= RECORD_DELETED;
+        return false;
+    }
+    mAccess[slot].store((U32)serial, std::memory_order_relaxed);
+
+    // readers may still be copying the older record, it stays in place
+    // until its slab gets compacted
+    if (older)
+    {
+        older->mFlags |= RECORD_DELETED;
+        mUsage -= older->mSize;
+    }
+    else
+    {
+        ++mEntries;
+    }
+    mUsage += size;
+    return true;
+}
+
+bool LLSlabCache::remove(const LLUUID& id)
+{
+    LLMutexLock lock(&mWriteMutex);
+    if (mReadOnly || mSlabs.empty())
+    {
+        return false;
+    }
+    S32 slot = findSlot(id, id.getDigest64());
+    if (slot < 0)
+    {
+        return false;
+    }
+    dropRecord(slot, getRecord(slot_location(mSlots[slot].load(std::memory_order_relaxed))));
+    return true;
+}
+
+void LLSlabCache::clear()
+{
+    LLMutexLock lock(&mWriteMutex);
+    if (mReadOnly || mSlabs.empty())
+    {
+        return;
+    }
+
+    U32 generation = mIndexGeneration.load(std::memory_order_relaxed);
+    mIndexGeneration.store(generation + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    for (U32 i = 0; i < mSlabs.size(); ++i)
+    {
+        Slab& s = *mSlabs[i];
+        U32 slab_generation = s.mGeneration.load(std::memory_order_relaxed);
+        s.mGeneration.store(slab_generation + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+
+        SlabHeader* header = getSlabHeader(i);
+        header->mUsed = sizeof(SlabHeader);
+        header->mFilledSerial = 0;
+        header->mFlags = 0;
+
+        s.mGeneration.store(slab_generation + 2, std::memory_order_release);
+    }
+    for (U32 i = 0; i <= mSlotMask; ++i)
+    {
+        mSlots[i].store(EMPTY_SLOT, std::memory_order_relaxed);
+    }
+    mTombstones = 0;
+    mUsage = 0;
+    mEntries = 0;
+    mWriteSlab = 0;
+
+    mIndexGeneration.store(generation + 2, std::memory_order_release);
+}
+
+void LLSlabCache::flush(bool async)
+{
+    LLMutexLock lock(&mWriteMutex);
+    for (auto& slab : mSlabs)
+    {
+        slab->mFile.flush(async);
+    }
+}
+
+//----------------------------------------------------------------------------
+// Lock free reads
+
+template <typename FN>
+bool LLSlabCache::readRecord(const LLUUID& id, FN fn)
+{
+    U32 index_generation = mIndexGeneration.load(std::memory_order_acquire);
+    if ((index_generation & 1) || !mSlots)
+    {
+        return false;
+    }
+
+    U64 digest = id.getDigest64();
+    U32 tag = make_tag(digest);
+    U32 i = (U32)digest & mSlotMask;
+    for (U32 n = 0; n <= mSlotMask; ++n, i = (i + 1) & mSlotMask)
+    {
+        U64 slot = mSlots[i].load(std::memory_order_acquire);
+        if (slot == EMPTY_SLOT)
+        {
+            return false;
+        }
+        if (slot == TOMBSTONE_SLOT || slot_tag(slot) != tag)
+        {
+            continue;
+        }
+
+        U64 location = slot_location(slot);
+        U32 slab = location_slab(location);
+        if (slab >= mSlabs.size())
+        {
+            return false;
+        }
+        Slab& s = *mSlabs[slab];
+        U32 generation = s.mGeneration.load(std::memory_order_acquire);
+        if ((generation & 1) || mSlots[i].load(std::memory_order_relaxed) != slot)
+        {
+            // compacted since the slot was loaded, the record may have moved
+            return false;
+        }
+
+        // copy the header first, the record may move under us
+        const U8* data = s.mFile.getData() + location_offset(location);
+        RecordHeader record;
+        memcpy(&record, data, sizeof(RecordHeader));
+        bool found = record.mID == id;
+        bool success = found &&
+                       record.mMagic == RECORD_MAGIC &&
+                       !(record.mFlags & RECORD_DELETED) &&
+                       record.mHeadSize >= 0 && record.mBodySize >= 0 &&
+                       location_offset(location) + sizeof(RecordHeader) + (U64)record.mHeadSize + (U64)record.mBodySize <= mSlabSize &&
+                       fn(record, data + sizeof(RecordHeader));
+
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (s.mGeneration.load(std::memory_order_relaxed) != generation ||
+            mSlots[i].load(std::memory_order_relaxed) != slot ||
+            mIndexGeneration.load(std::memory_order_relaxed) != index_generation)
+        {
+            // compacted or reindexed while copying
+            return false;
+        }
+        if (found)
+        {
+            if (success)
+            {
+                mAccess[i].store((U32)mSerial.load(std::memory_order_relaxed), std::memory_order_relaxed);
+            }
+            return success;
+        }
+    }
+    return false;
+}
+
+S32 LLSlabCache::readBody(const LLUUID& id, S32 offset, S32 size, U8*& data, S32& meta)
+{
+    data = NULL;
+    S32 bytes = 0;
+    bool success = readRecord(id, [&](const RecordHeader& record, const U8* payload)
+        {
+            if (offset < 0 || offset >= record.mBodySize)
+            {
+                return false;
+            }
+            bytes = record.mBodySize - offset;
+            if (size > 0)
+            {
+                bytes = llmin(bytes, size);
+            }
+            data = (U8*)ll_aligned_malloc_16(bytes);
+            if (!data)
+            {
+                return false;
+            }
+            memcpy(data, payload + record.mHeadSize + offset, bytes);
+            meta = record.mMeta;
+            return true;
+        });
+    if (!success)
+    {
+        ll_aligned_free_16(data);
+        data = NULL;
+        bytes = 0;
+    }
+    return bytes;
+}
+
+S32 LLSlabCache::readHead(const LLUUID& id, U8* buffer, S32 buffer_size)
+{
+    S32 head_size = -1;
+    bool success = readRecord(id, [&](const RecordHeader& record, const U8* payload)
+        {
+            memcpy(buffer, payload, llmin(record.mHeadSize, buffer_size));
+            head_size = record.mHeadSize;
+            return true;
+        });
+    return success ? head_size : -1;
+}
+
+S32 LLSlabCache::getBodySize(const LLUUID& id, S32* meta)
+{
+    S32 body_size = -1;
+    S32 record_meta = 0;
+    bool success = readRecord(id, [&](const RecordHeader& record, const U8* payload)
+        {
+            body_size = record.mBodySize;
+            record_meta = record.mMeta;
+            return true;
+        });
+    if (success && meta)
+    {
+        *meta = record_meta;
+    }
+    return success ? body_size : -1;
+}
@@ -0,0 +1,155 @@
+/**
+ * @file llslabcache.h
+ * @brief UUID keyed blob cache stored in a few memory mapped slab files
+ *
+ * The cache is made of N slab files of a fixed size, each one a log of
+ * records (header, small "head" blob, larger "body" blob) appended one
+ * after the other.  An in-memory open addressing index maps each UUID to
+ * the slab and offset of its newest record and is rebuilt from the slabs
+ * on open(), so there is no separate index file to keep in sync.
+ *
+ * Eviction works slab by slab: when the write slab fills up, the slab that
+ * was filled the longest ago is compacted in place.  Records read since
+ * that slab filled up slide down to its start, the others are dropped,
+ * and the slab becomes the new write slab.
+ *
+ * Any number of threads may read without taking a lock.  Each slab has a
+ * generation counter that is odd while it is being compacted, so a reader
+ * that copied from a slab under compaction notices and reports a miss.
+ * Readers also check that the index slot they followed did not change,
+ * and compaction clears the magic of the records it frees, so a record
+ * written again into freed space is not read until it is complete.
+ * Writes, removals and compaction are serialized by a mutex.
+ *
+ * $LicenseInfo:firstyear=2024&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2024, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#ifndef LL_LLSLABCACHE_H
+#define LL_LLSLABCACHE_H
+
+#include "llmappedfile.h"
+#include "llmutex.h"
+#include "lluuid.h"
+
+#include <atomic>
+#include <memory>
+#include <vector>
+
+class LLSlabCache
+{
+public:
+    // Limits of the packed index entries
+    static const U32 MAX_SLABS = 255;
+    static const size_t MAX_SLAB_SIZE = 1024 * 1024 * 1024;
+
+    LLSlabCache();
+    ~LLSlabCache();
+
+    LLSlabCache(const LLSlabCache&) = delete;
+    LLSlabCache& operator=(const LLSlabCache&) = delete;
+
+    // Maps slab_count files named <prefix>NN.slab in dir, creating the
+    // missing ones unless read_only, and indexes their records.
+    // max_entries sizes the index.
+    bool open(const std::string& dir, const std::string& prefix, U32 slab_count, size_t slab_size,
+              U32 max_entries, bool read_only = false);
+    void close();
+    bool isOpen() const { return !mSlabs.empty(); }
+
+    // Deletes the slab files of a cache that is not open
+    static void removeFiles(const std::string& dir, const std::string& prefix);
+
+    // Stores a record for id, replacing any older one.  meta is an opaque
+    // value handed back by the reads.
+    bool write(const LLUUID& id, S32 meta, const U8* head, S32 head_size, const U8* body, S32 body_size);
+    bool remove(const LLUUID& id);
+    void clear();
+
+    // Copies size bytes of the body starting at offset (all of it if size
+    // is 0 or past the end) into a buffer from ll_aligned_malloc_16(),
+    // which the caller frees.  Returns the number of bytes copied, 0 when
+    // id is not cached.
+    S32 readBody(const LLUUID& id, S32 offset, S32 size, U8*& data, S32& meta);
+    // Copies up to buffer_size bytes of the head into buffer and returns
+    // the head size, or -1 when id is not cached.
+    S32 readHead(const LLUUID& id, U8* buffer, S32 buffer_size);
+    // Body size of the cached record, -1 when not cached
+    S32 getBodySize(const LLUUID& id, S32* meta = NULL);
+    bool has(const LLUUID& id) { return getBodySize(id) >= 0; }
+
+    // Writes dirty pages back to the slab files
+    void flush(bool async = true);
+
+    S64 getUsage() const                { return mUsage; }
+    U32 getEntries() const              { return mEntries; }
+    S64 getCapacity() const             { return (S64)mSlabs.size() * (S64)mSlabSize; }
+    U32 getCompactions() const          { return mCompactions; }
+
+private:
+    struct Slab
+    {
+        LLMappedFile mFile;
+        std::atomic<U32> mGeneration{ 0 };   // odd while being compacted
+    };
+    struct SlabHeader;
+    struct RecordHeader;
+
+    SlabHeader* getSlabHeader(U32 slab) const;
+    RecordHeader* getRecord(U64 location) const;
+
+    S32 findSlot(const LLUUID& id, U64 digest) const;
+    S32 insertSlot(const LLUUID& id, U64 digest, U64 location);
+    void rebuildIndex();
+    void indexSlab(U32 slab);
+
+    bool makeRoom(size_t size);
+    void compactSlab(U32 slab, size_t keep_limit);
+    void dropRecord(S32 slot, RecordHeader* record);
+    U32 pickVictim() const;
+
+    template <typename FN>
+    bool readRecord(const LLUUID& id, FN fn);
+
+private:
+    LLMutex mWriteMutex;
+    std::vector<std::unique_ptr<Slab> > mSlabs;
+    size_t mSlabSize;
+    bool mReadOnly;
+    std::string mDir;
+    std::string mPrefix;
+
+    // Open addressing index: (tag << 32) | (slab << 24) | (offset / RECORD_ALIGN)
+    std::unique_ptr<std::atomic<U64>[]> mSlots;
+    // Write serial at the last read of each slot, for the eviction
+    std::unique_ptr<std::atomic<U32>[]> mAccess;
+    U32 mSlotMask;
+    U32 mTombstones;
+    std::atomic<U32> mIndexGeneration;  // odd while the index is rebuilt
+
+    U32 mWriteSlab;
+    std::atomic<U64> mSerial;
+    std::atomic<S64> mUsage;
+    std::atomic<U32> mEntries;
+    U32 mCompactions;
+};
+
+#endif // LL_LLSLABCACHE_H
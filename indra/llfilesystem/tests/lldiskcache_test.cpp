@@ -0,0 +1,221 @@
+/**
+ * @file lldiskcache_test.cpp
+ * @brief Tests for the LLDiskCache index journal
+ *
+ * $LicenseInfo:firstyear=2024&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2024, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#include "linden_common.h"
+
+#include "../lldir.h"
+#include "llassettype.h"
+#include "../lldiskcache.h"
+#include "llapp.h"
+#include "llfile.h"
+#include "llformat.h"
+#include "llrand.h"
+
+#include "../test/lltut.h"
+
+#include <boost/filesystem.hpp>
+
+namespace
+{
+    const S32 FILE_COUNT = 10;
+    const uintmax_t FILE_SIZE = 1000;
+    const size_t JOURNAL_HEADER_SIZE = 16;
+    const size_t JOURNAL_RECORD_SIZE = 32;
+
+    // purge() and the rescan stop as soon as the app isn't running
+    class LLTestApp : public LLApp
+    {
+    public:
+        bool init() override { return true; }
+        bool cleanup() override { return true; }
+        bool frame() override { return true; }
+    };
+
+    LLUUID make_id(S32 i)
+    {
+        return LLUUID::generateNewID(llformat("disk cache test %d", i));
+    }
+
+    // Writes a cache file the way LLFileSystem does: the file first, then the index
+    void write_file(LLDiskCache& cache, S32 i)
+    {
+        const boost::filesystem::path path = cache.metaDataToFilepath(make_id(i), LLAssetType::AT_TEXTURE);
+        LLFILE* file = LLFile::fopen(path.string(), "wb");
+        tut::ensure("create cache file", file != NULL);
+        std::vector<U8> data(FILE_SIZE, (U8)i);
+        fwrite(data.data(), 1, data.size(), file);
+        fclose(file);
+        cache.addEntry(make_id(i), LLAssetType::AT_TEXTURE, FILE_SIZE);
+    }
+}
+
+namespace tut
+{
+    struct diskcache_data
+    {
+        diskcache_data()
+        {
+            mDir = gDirUtilp->add(gDirUtilp->getTempDir(), llformat("lldiskcache_test_%d", ll_rand(1 << 30)));
+            gDirUtilp->setCacheDir(mDir);
+            mJournal = gDirUtilp->add(gDirUtilp->getExpandedFilename(LL_PATH_CACHE, "cache"), "index.journal");
+        }
+
+        ~diskcache_data()
+        {
+            boost::system::error_code ec;
+            boost::filesystem::remove_all(mDir, ec);
+            gDirUtilp->setCacheDir("");
+        }
+
+        void init(LLDiskCache& cache, uintmax_t max_size = 1024 * 1024)
+        {
+            cache.init(LL_PATH_CACHE, max_size, false, false);
+        }
+
+        // A session that writes FILE_COUNT files and then removes the fourth
+        void writeSession()
+        {
+            LLDiskCache cache;
+            init(cache);
+            for (S32 i = 0; i < FILE_COUNT; ++i)
+            {
+                write_file(cache, i);
+            }
+            cache.removeEntry(make_id(3));
+        }
+
+        LLTestApp mApp;
+        std::string mDir;
+        std::string mJournal;
+    };
+    typedef test_group<diskcache_data> diskcache_test;
+    typedef diskcache_test::object diskcache_object;
+    tut::diskcache_test tdc("LLDiskCache");
+
+    template<> template<>
+    void diskcache_object::test<1>()
+    {
+        set_test_name("journal replay");
+
+        writeSession();
+
+        LLDiskCache cache;
+        init(cache);
+        ensure_equals("entries", cache.getEntryCount(), (size_t)FILE_COUNT - 1);
+        ensure_equals("total size", cache.getTotalSize(), (FILE_COUNT - 1) * FILE_SIZE);
+        ensure("removed entry", !cache.hasEntry(make_id(3)));
+        for (S32 i = 0; i < FILE_COUNT; ++i)
+        {
+            if (i != 3)
+            {
+                ensure(llformat("entry %d", i), cache.hasEntry(make_id(i)));
+            }
+        }
+
+        // the replayed journal is compacted to one record per file
+        ensure_equals("compacted journal", (size_t)boost::filesystem::file_size(mJournal),
+                      JOURNAL_HEADER_SIZE + (FILE_COUNT - 1) * JOURNAL_RECORD_SIZE);
+    }
+
+    template<> template<>
+    void diskcache_object::test<2>()
+    {
+        set_test_name("torn last record");
+
+        writeSession();
+
+        // a crash in the middle of appending a record
+        LLFILE* file = LLFile::fopen(mJournal, "ab");
+        ensure("open journal", file != NULL);
+        const U8 torn[13] = { 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13 };
+        fwrite(torn, 1, sizeof(torn), file);
+        fclose(file);
+
+        LLDiskCache cache;
+        init(cache);
+        ensure_equals("entries", cache.getEntryCount(), (size_t)FILE_COUNT - 1);
+        ensure("removed entry", !cache.hasEntry(make_id(3)));
+        ensure_equals("torn record dropped", (size_t)boost::filesystem::file_size(mJournal),
+                      JOURNAL_HEADER_SIZE + (FILE_COUNT - 1) * JOURNAL_RECORD_SIZE);
+    }
+
+    template<> template<>
+    void diskcache_object::test<3>()
+    {
+        set_test_name("corruption before the end falls back to a rescan");
+
+        writeSession();
+
+        // damage the first record, the ones after it are intact
+        LLFILE* file = LLFile::fopen(mJournal, "r+b");
+        ensure("open journal", file != NULL);
+        fseek(file, JOURNAL_HEADER_SIZE + 8, SEEK_SET);
+        U8 byte = 0;
+        fread(&byte, 1, 1, file);
+        byte ^= 0xff;
+        fseek(file, JOURNAL_HEADER_SIZE + 8, SEEK_SET);
+        fwrite(&byte, 1, 1, file);
+        fclose(file);
+
+        LLDiskCache cache;
+        init(cache);
+        ensure_equals("journal rejected, not half replayed", cache.getEntryCount(), (size_t)0);
+
+        // removeEntry() only forgets the file, so the rescan finds all of them
+        cache.purge();
+        ensure_equals("rescanned entries", cache.getEntryCount(), (size_t)FILE_COUNT);
+        ensure_equals("rescanned size", cache.getTotalSize(), FILE_COUNT * FILE_SIZE);
+        ensure("rescanned entry", cache.hasEntry(make_id(3)));
+    }
+
+    template<> template<>
+    void diskcache_object::test<4>()
+    {
+        set_test_name("purge removes the least recently used files");
+
+        LLDiskCache cache;
+        init(cache, FILE_SIZE * FILE_COUNT / 2);
+        for (S32 i = 0; i < FILE_COUNT; ++i)
+        {
+            write_file(cache, i);
+        }
+        cache.purge();
+
+        ensure_equals("entries", cache.getEntryCount(), (size_t)FILE_COUNT / 2);
+        for (S32 i = 0; i < FILE_COUNT; ++i)
+        {
+            bool kept = i >= FILE_COUNT / 2;
+            boost::system::error_code ec;
+            bool exists = boost::filesystem::exists(cache.metaDataToFilepath(make_id(i), LLAssetType::AT_TEXTURE), ec);
+            ensure_equals(llformat("entry %d", i), cache.hasEntry(make_id(i)), kept);
+            ensure_equals(llformat("file %d", i), exists, kept);
+        }
+
+        // a file written again after the purge is indexed as usual
+        write_file(cache, 0);
+        ensure("rewritten entry", cache.hasEntry(make_id(0)));
+    }
+}
@@ -0,0 +1,311 @@
+/**
+ * @file llslabcache_test.cpp
+ * @brief Tests for LLSlabCache
+ *
+ * $LicenseInfo:firstyear=2024&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2024, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#include "linden_common.h"
+
+#include "../lldir.h"
+#include "../llslabcache.h"
+#include "llfile.h"
+#include "llformat.h"
+#include "llmemory.h"
+
+#include "../test/lltut.h"
+
+#include <thread>
+
+namespace
+{
+    const size_t SLAB_SIZE = 1024 * 1024;
+    const U32 SLAB_COUNT = 4;
+
+    LLUUID make_id(U32 i)
+    {
+        return LLUUID::generateNewID(llformat("slab test %u", i));
+    }
+
+    S32 body_size(U32 i, S32 version)
+    {
+        return 100 + (S32)((i * 2654435761u + version) % 20000);
+    }
+
+    // Self describing records: the head holds the key and the version
+    // (also passed as meta), the body is a pattern derived from both.
+    std::vector<U8> make_body(U32 i, S32 version)
+    {
+        std::vector<U8> body(body_size(i, version));
+        for (size_t k = 0; k < body.size(); ++k)
+        {
+            body[k] = (U8)(i * 31 + version * 7 + k);
+        }
+        return body;
+    }
+
+    bool put(LLSlabCache& cache, U32 i, S32 version)
+    {
+        std::vector<U8> body = make_body(i, version);
+        U8 head[8];
+        memcpy(head, &i, 4);
+        memcpy(head + 4, &version, 4);
+        return cache.write(make_id(i), version, head, sizeof(head), body.data(), (S32)body.size());
+    }
+
+    // Returns the cached version of i, 0 if it is not cached.  Fails the
+    // test if what comes back does not match what was written.
+    S32 get(LLSlabCache& cache, U32 i)
+    {
+        U8* data = NULL;
+        S32 version = 0;
+        S32 size = cache.readBody(make_id(i), 0, 0, data, version);
+        if (!size)
+        {
+            return 0;
+        }
+        std::vector<U8> expected = make_body(i, version);
+        bool same = size == (S32)expected.size() && memcmp(data, expected.data(), size) == 0;
+        ll_aligned_free_16(data);
+        tut::ensure(llformat("body of %u", i), same);
+
+        U8 head[8];
+        if (cache.readHead(make_id(i), head, sizeof(head)) == sizeof(head))
+        {
+            // a concurrent write may have evicted it since, but a head
+            // that comes back must match
+            tut::ensure(llformat("head of %u", i), memcmp(head, &i, 4) == 0 && memcmp(head + 4, &version, 4) == 0);
+        }
+        return version;
+    }
+}
+
+namespace tut
+{
+    struct slabcache_data
+    {
+        slabcache_data()
+        {
+            mDir = gDirUtilp->add(gDirUtilp->getTempDir(), "llslabcache_test");
+            LLFile::mkdir(mDir);
+            LLSlabCache::removeFiles(mDir, "test_");
+        }
+        ~slabcache_data()
+        {
+            LLSlabCache::removeFiles(mDir, "test_");
+            LLFile::rmdir(mDir);
+        }
+
+        bool open(LLSlabCache& cache, U32 max_entries = 2000)
+        {
+            return cache.open(mDir, "test_", SLAB_COUNT, SLAB_SIZE, max_entries);
+        }
+
+        std::string mDir;
+    };
+    typedef test_group<slabcache_data> slabcache_test;
+    typedef slabcache_test::object slabcache_object;
+    tut::slabcache_test tsc("LLSlabCache");
+
+    template<> template<>
+    void slabcache_object::test<1>()
+    {
+        set_test_name("write, read, remove and reopen");
+
+        {
+            LLSlabCache cache;
+            ensure("open", open(cache));
+            for (U32 i = 0; i < 100; ++i)
+            {
+                ensure("write", put(cache, i, 1));
+            }
+            for (U32 i = 0; i < 10; ++i)
+            {
+                ensure("remove", cache.remove(make_id(i)));
+            }
+            for (U32 i = 10; i < 20; ++i)
+            {
+                ensure("rewrite", put(cache, i, 2));
+            }
+            ensure_equals("entries", cache.getEntries(), 90U);
+
+            U8* data = NULL;
+            S32 meta = 0;
+            ensure_equals("partial read", cache.readBody(make_id(50), 10, 5, data, meta), 5);
+            ensure("partial data", memcmp(data, make_body(50, 1).data() + 10, 5) == 0);
+            ll_aligned_free_16(data);
+        }
+
+        LLSlabCache cache;
+        ensure("reopen", open(cache));
+        ensure_equals("entries after reopen", cache.getEntries(), 90U);
+        for (U32 i = 0; i < 100; ++i)
+        {
+            ensure_equals(llformat("version of %u", i), get(cache, i), i < 10 ? 0 : (i < 20 ? 2 : 1));
+        }
+
+        cache.clear();
+        ensure_equals("entries after clear", cache.getEntries(), 0U);
+        ensure("cleared", !cache.has(make_id(50)));
+    }
+
+    template<> template<>
+    void slabcache_object::test<2>()
+    {
+        set_test_name("compaction keeps recently read records");
+
+        LLSlabCache cache;
+        ensure("open", open(cache));
+
+        // about ten times what fits, reading back a small hot set as we go
+        for (U32 i = 0; i < 2000; ++i)
+        {
+            ensure("write", put(cache, i, 1));
+            if (i >= 20 && i % 5 == 0)
+            {
+                for (U32 k = 0; k < 20; ++k)
+                {
+                    get(cache, k);
+                }
+            }
+        }
+        ensure("compacted", cache.getCompactions() > 0);
+        ensure("within capacity", cache.getUsage() <= cache.getCapacity());
+
+        for (U32 k = 0; k < 20; ++k)
+        {
+            ensure_equals(llformat("hot %u", k), get(cache, k), 1);
+        }
+        ensure("cold evicted", !get(cache, 100));
+        ensure("recent kept", get(cache, 1999));
+    }
+
+    template<> template<>
+    void slabcache_object::test<3>()
+    {
+        set_test_name("lock free reads during writes");
+
+        LLSlabCache cache;
+        ensure("open", open(cache));
+
+        std::atomic<bool> stop(false);
+        std::vector<std::thread> readers;
+        for (U32 t = 0; t < 4; ++t)
+        {
+            readers.emplace_back([&cache, &stop, t]()
+                {
+                    U32 i = t;
+                    while (!stop)
+                    {
+                        get(cache, i % 3000);
+                        i += 7;
+                    }
+                });
+        }
+
+        for (U32 i = 0; i < 3000; ++i)
+        {
+            put(cache, i, 1 + (i & 1));
+            if (i % 3 == 0)
+            {
+                cache.remove(make_id(i / 2));
+            }
+        }
+        stop = true;
+        for (std::thread& reader : readers)
+        {
+            reader.join();
+        }
+        ensure("compacted", cache.getCompactions() > 0);
+    }
+
+    template<> template<>
+    void slabcache_object::test<4>()
+    {
+        set_test_name("index smaller than the data");
+
+        LLSlabCache cache;
+        ensure("open", open(cache, 10));
+        for (U32 i = 0; i < 5000; ++i)
+        {
+            U8 body[100] = { 0 };
+            ensure("write", cache.write(make_id(i), 0, NULL, 0, body, sizeof(body)));
+        }
+        ensure("bounded", cache.getEntries() < 1024);
+        ensure("latest", cache.has(make_id(4999)));
+    }
+
+    template<> template<>
+    void slabcache_object::test<5>()
+    {
+        set_test_name("lock free reads during compaction and rewrites");
+
+        LLSlabCache cache;
+        ensure("open", open(cache));
+
+        // a few keys rewritten over and over while filler forces compaction,
+        // so new versions land in space freed from under the readers
+        const U32 HOT = 8;
+        std::atomic<bool> stop(false);
+        std::vector<std::thread> readers;
+        for (U32 t = 0; t < 4; ++t)
+        {
+            readers.emplace_back([&cache, &stop, t]()
+                {
+                    U32 i = t;
+                    while (!stop)
+                    {
+                        U8* data = NULL;
+                        S32 version = 0;
+                        S32 size = cache.readBody(make_id(i % HOT), 0, 0, data, version);
+                        if (size)
+                        {
+                            std::vector<U8> expected = make_body(i % HOT, version);
+                            bool same = size == (S32)expected.size() && memcmp(data, expected.data(), size) == 0;
+                            ll_aligned_free_16(data);
+                            tut::ensure(llformat("body of %u", i % HOT), same);
+                        }
+                        ++i;
+                    }
+                });
+        }
+
+        for (S32 version = 1; version < 400; ++version)
+        {
+            for (U32 k = 0; k < HOT; ++k)
+            {
+                put(cache, k, version);
+            }
+            for (U32 i = 0; i < 8; ++i)
+            {
+                put(cache, HOT + (U32)version * 8 + i, 1);
+            }
+        }
+        stop = true;
+        for (std::thread& reader : readers)
+        {
+            reader.join();
+        }
+        ensure("compacted", cache.getCompactions() > 0);
+        ensure_equals("latest", get(cache, 0), 399);
+    }
+}
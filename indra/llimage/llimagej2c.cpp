@@ -42,6 +42,14 @@ LLImageJ2CImpl* fallbackCreateLLImageJ2CImpl();
 LLImageCompressionTester* LLImageJ2C::sTesterp = NULL ;
 const std::string sTesterName("ImageCompressionTester");
 
+S32 LLImageJ2C::sLargeImageDecodeThreads = 0;
+
+//static
+void LLImageJ2C::setLargeImageDecodeThreads(S32 threads)
+{
+    sLargeImageDecodeThreads = llmax(threads, 0);
+}
+
 //static
 std::string LLImageJ2C::getEngineInfo()
 {
@@ -78,6 +78,13 @@ class LLImageJ2C final : public LLImageFormatted
 
     static std::string getEngineInfo();
 
+    // Let the engine decode images of at least LARGE_IMAGE_DECODE_AREA
+    // pixels (after discard) with this many threads of its own.  0 or 1
+    // keeps every decode on the calling thread.
+    static const S32 LARGE_IMAGE_DECODE_AREA = 2048 * 2048;
+    static void setLargeImageDecodeThreads(S32 threads);
+    static S32 getLargeImageDecodeThreads() { return sLargeImageDecodeThreads; }
+
 protected:
     friend class LLImageJ2CImpl;
     friend class LLImageJ2COJ;
@@ -99,6 +106,8 @@ class LLImageJ2C final : public LLImageFormatted
 
     // Image compression/decompression tester
     static LLImageCompressionTester* sTesterp;
+
+    static S32 sLargeImageDecodeThreads;
 };
 
 // Derive from this class to implement JPEG2000 decoding
@@ -0,0 +1,241 @@
+/**
+ * @file llimagej2c_test.cpp
+ * @brief Tests and decode throughput benchmark for LLImageJ2C
+ *
+ * $LicenseInfo:firstyear=2024&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2024, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#include "linden_common.h"
+#include "../test/lltut.h"
+
+#include "../llimage.h"
+#include "../llimagej2c.h"
+#include "llrand.h"
+#include "lltimer.h"
+
+#include <filesystem>
+
+namespace
+{
+    LLPointer<LLImageRaw> make_raw(U16 width, U16 height, S8 components)
+    {
+        // smooth gradients with some noise, so the encoder has real work
+        LLPointer<LLImageRaw> raw = new LLImageRaw(width, height, components);
+        U8* data = raw->getData();
+        for (S32 y = 0; y < height; ++y)
+        {
+            for (S32 x = 0; x < width; ++x)
+            {
+                for (S32 c = 0; c < components; ++c)
+                {
+                    *data++ = (U8)((x * (c + 1) + y * (3 - c) + ll_rand(16)) & 0xFF);
+                }
+            }
+        }
+        return raw;
+    }
+
+    LLPointer<LLImageJ2C> encode(const LLImageRaw* raw, bool reversible)
+    {
+        LLPointer<LLImageJ2C> j2c = new LLImageJ2C();
+        j2c->setReversible(reversible);
+        tut::ensure("encode", j2c->encode(raw, 0.f));
+        return j2c;
+    }
+
+    LLPointer<LLImageRaw> decode(LLImageJ2C* j2c, int* region = NULL)
+    {
+        LLPointer<LLImageRaw> raw = new LLImageRaw();
+        j2c->initDecode(*raw, 0, region);
+        tut::ensure("decode", j2c->decode(raw, 0.f));
+        return raw;
+    }
+
+    bool same_pixels(const LLImageRaw* a, const LLImageRaw* b)
+    {
+        return a->getWidth() == b->getWidth() &&
+               a->getHeight() == b->getHeight() &&
+               a->getComponents() == b->getComponents() &&
+               a->getData() && b->getData() &&
+               memcmp(a->getData(), b->getData(), a->getDataSize()) == 0;
+    }
+}
+
+namespace tut
+{
+    struct j2c_data
+    {
+        j2c_data()
+        {
+            LLImage::initClass();
+        }
+        ~j2c_data()
+        {
+            LLImage::cleanupClass();
+        }
+    };
+    typedef test_group<j2c_data> j2c_test;
+    typedef j2c_test::object j2c_object;
+    tut::j2c_test tj2c("LLImageJ2C");
+
+    template<> template<>
+    void j2c_object::test<1>()
+    {
+        set_test_name("lossless round trip");
+
+        // odd sizes exercise the partial SIMD blocks at the end of a row
+        static const U16 sizes[][2] = { { 64, 64 }, { 67, 45 }, { 13, 130 } };
+        for (S8 components = 1; components <= 4; ++components)
+        {
+            for (const auto& size : sizes)
+            {
+                LLPointer<LLImageRaw> raw = make_raw(size[0], size[1], components);
+                LLPointer<LLImageJ2C> j2c = encode(raw, true);
+                LLPointer<LLImageRaw> decoded = decode(j2c);
+                ensure(llformat("%dx%dx%d", size[0], size[1], components), same_pixels(raw, decoded));
+            }
+        }
+    }
+
+    template<> template<>
+    void j2c_object::test<2>()
+    {
+        set_test_name("region decode");
+
+        const S32 width = 200, height = 150;
+        LLPointer<LLImageRaw> raw = make_raw(width, height, 3);
+        LLPointer<LLImageJ2C> j2c = encode(raw, true);
+
+        // x0, y0, x1, y1 from the top left corner of the image
+        int region[4] = { 37, 20, 141, 99 };
+        LLPointer<LLImageRaw> part = decode(j2c, region);
+        ensure_equals("region width", (S32)part->getWidth(), region[2] - region[0]);
+        ensure_equals("region height", (S32)part->getHeight(), region[3] - region[1]);
+
+        // raw images are stored bottom row first
+        LLPointer<LLImageRaw> crop = new LLImageRaw(part->getWidth(), part->getHeight(), 3);
+        for (S32 y = 0; y < crop->getHeight(); ++y)
+        {
+            const U8* src = raw->getData() + ((height - region[3] + y) * width + region[0]) * 3;
+            memcpy(crop->getData() + y * crop->getWidth() * 3, src, crop->getWidth() * 3);
+        }
+        ensure("region pixels", same_pixels(crop, part));
+
+        // a region outside the image decodes the whole thing
+        int outside[4] = { width + 10, 0, width + 20, 10 };
+        LLPointer<LLImageRaw> full = decode(j2c, outside);
+        ensure("empty region", same_pixels(raw, full));
+    }
+
+    template<> template<>
+    void j2c_object::test<3>()
+    {
+        set_test_name("full decode after a region decode");
+
+        const S32 width = 96, height = 80;
+        LLPointer<LLImageRaw> raw = make_raw(width, height, 4);
+        LLPointer<LLImageJ2C> j2c = encode(raw, true);
+
+        int region[4] = { 8, 16, 40, 56 };
+        LLPointer<LLImageRaw> part = decode(j2c, region);
+        ensure_equals("region width", (S32)part->getWidth(), region[2] - region[0]);
+
+        // no initDecode() this time, the region must not stick to the codec
+        LLPointer<LLImageRaw> full = new LLImageRaw();
+        ensure("decode", j2c->decode(full, 0.f));
+        ensure("full pixels", same_pixels(raw, full));
+    }
+
+    template<> template<>
+    void j2c_object::test<4>()
+    {
+        set_test_name("decode throughput benchmark");
+
+        if (LLStringUtil::getenv("LL_BENCHMARK").empty())
+        {
+            skip("set LL_BENCHMARK to run");
+        }
+
+        // Point LL_J2C_CORPUS at a directory of .j2c textures, otherwise a
+        // synthetic set of lossy encoded textures is used.
+        std::vector<LLPointer<LLImageJ2C> > images;
+        std::string corpus = LLStringUtil::getenv("LL_J2C_CORPUS");
+        if (!corpus.empty())
+        {
+            for (const auto& entry : std::filesystem::directory_iterator(corpus))
+            {
+                if (entry.path().extension() != ".j2c")
+                {
+                    continue;
+                }
+                LLPointer<LLImageJ2C> j2c = new LLImageJ2C();
+                if (j2c->loadAndValidate(entry.path().string()))
+                {
+                    images.push_back(j2c);
+                }
+            }
+        }
+        if (images.empty())
+        {
+            corpus = "synthetic";
+            static const U16 sizes[] = { 256, 512, 1024, 2048 };
+            for (U16 size : sizes)
+            {
+                for (S8 components = 3; components <= 4; ++components)
+                {
+                    LLPointer<LLImageRaw> raw = make_raw(size, size, components);
+                    images.push_back(encode(raw, false));
+                }
+            }
+        }
+
+        size_t total_bytes = 0;
+        F64 total_pixels = 0.0;
+        for (LLImageJ2C* j2c : images)
+        {
+            total_bytes += j2c->getDataSize();
+            total_pixels += (F64)j2c->getWidth() * j2c->getHeight();
+        }
+
+        const S32 ITERATIONS = 3;
+        static const S32 thread_counts[] = { 0, 4 };
+        for (S32 threads : thread_counts)
+        {
+            LLImageJ2C::setLargeImageDecodeThreads(threads);
+            LLTimer timer;
+            for (S32 i = 0; i < ITERATIONS; ++i)
+            {
+                for (LLImageJ2C* j2c : images)
+                {
+                    decode(j2c);
+                }
+            }
+            F64 secs = timer.getElapsedTimeF64();
+            secs = llmax(secs, 1e-6);
+            LL_INFOS() << images.size() << " textures (" << total_bytes << " bytes, " << corpus << "), "
+                       << threads << " large image threads: "
+                       << total_pixels * ITERATIONS / secs / 1e6 << " MPix/s, "
+                       << total_bytes * ITERATIONS / secs / (1024 * 1024) << " MB/s" << LL_ENDL;
+        }
+        LLImageJ2C::setLargeImageDecodeThreads(0);
+    }
+}
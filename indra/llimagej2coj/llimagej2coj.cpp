@@ -32,6 +32,8 @@
 
 #include "lltimer.h"
 
+#include <immintrin.h>
+
 struct LLJp2StreamReader
 {
     LLJp2StreamReader(LLImageJ2C* pImage) : m_pImage(pImage), m_Position(0) { }
@@ -215,15 +217,143 @@ int ceildivpow2(int a, int b)
     return (a + (1 << b) - 1) >> b;
 }
 
+namespace
+{
+    // Low byte of 16 consecutive component samples, the same truncation
+    // the scalar (U8) assignment does.
+    inline __m128i load_u8x16(const OPJ_INT32* src)
+    {
+#if defined(__AVX2__)
+        const __m256i mask = _mm256_set1_epi32(0xFF);
+        __m256i a = _mm256_and_si256(_mm256_loadu_si256((const __m256i*)src), mask);
+        __m256i b = _mm256_and_si256(_mm256_loadu_si256((const __m256i*)(src + 8)), mask);
+        // packs works per 128 bit lane, put a0..a7 ahead of b0..b7 again
+        __m256i w = _mm256_permute4x64_epi64(_mm256_packs_epi32(a, b), 0xD8);
+        return _mm_packus_epi16(_mm256_castsi256_si128(w), _mm256_extracti128_si256(w, 1));
+#else
+        const __m128i mask = _mm_set1_epi32(0xFF);
+        __m128i a = _mm_and_si128(_mm_loadu_si128((const __m128i*)src), mask);
+        __m128i b = _mm_and_si128(_mm_loadu_si128((const __m128i*)(src + 4)), mask);
+        __m128i c = _mm_and_si128(_mm_loadu_si128((const __m128i*)(src + 8)), mask);
+        __m128i d = _mm_and_si128(_mm_loadu_si128((const __m128i*)(src + 12)), mask);
+        return _mm_packus_epi16(_mm_packs_epi32(a, b), _mm_packs_epi32(c, d));
+#endif
+    }
+
+    // Interleave one row of up to four component planes into dst.
+    template <S32 CHANNELS>
+    void interleave_row(U8* dst, const OPJ_INT32* const* src, S32 width)
+    {
+        S32 x = 0;
+        for (; x + 16 <= width; x += 16, dst += 16 * CHANNELS)
+        {
+            __m128i c0 = load_u8x16(src[0] + x);
+            if (CHANNELS == 1)
+            {
+                _mm_storeu_si128((__m128i*)dst, c0);
+            }
+            else if (CHANNELS == 2)
+            {
+                __m128i c1 = load_u8x16(src[1] + x);
+                _mm_storeu_si128((__m128i*)dst, _mm_unpacklo_epi8(c0, c1));
+                _mm_storeu_si128((__m128i*)(dst + 16), _mm_unpackhi_epi8(c0, c1));
+            }
+            else if (CHANNELS == 3)
+            {
+                __m128i c1 = load_u8x16(src[1] + x);
+                __m128i c2 = load_u8x16(src[2] + x);
+#if defined(__SSSE3__)
+                // each output block gathers its bytes from all three planes
+                const __m128i m00 = _mm_setr_epi8(0, -1, -1, 1, -1, -1, 2, -1, -1, 3, -1, -1, 4, -1, -1, 5);
+                const __m128i m01 = _mm_setr_epi8(-1, 0, -1, -1, 1, -1, -1, 2, -1, -1, 3, -1, -1, 4, -1, -1);
+                const __m128i m02 = _mm_setr_epi8(-1, -1, 0, -1, -1, 1, -1, -1, 2, -1, -1, 3, -1, -1, 4, -1);
+                const __m128i m10 = _mm_setr_epi8(-1, -1, 6, -1, -1, 7, -1, -1, 8, -1, -1, 9, -1, -1, 10, -1);
+                const __m128i m11 = _mm_setr_epi8(5, -1, -1, 6, -1, -1, 7, -1, -1, 8, -1, -1, 9, -1, -1, 10);
+                const __m128i m12 = _mm_setr_epi8(-1, 5, -1, -1, 6, -1, -1, 7, -1, -1, 8, -1, -1, 9, -1, -1);
+                const __m128i m20 = _mm_setr_epi8(-1, 11, -1, -1, 12, -1, -1, 13, -1, -1, 14, -1, -1, 15, -1, -1);
+                const __m128i m21 = _mm_setr_epi8(-1, -1, 11, -1, -1, 12, -1, -1, 13, -1, -1, 14, -1, -1, 15, -1);
+                const __m128i m22 = _mm_setr_epi8(10, -1, -1, 11, -1, -1, 12, -1, -1, 13, -1, -1, 14, -1, -1, 15);
+                _mm_storeu_si128((__m128i*)dst,
+                    _mm_or_si128(_mm_or_si128(_mm_shuffle_epi8(c0, m00), _mm_shuffle_epi8(c1, m01)), _mm_shuffle_epi8(c2, m02)));
+                _mm_storeu_si128((__m128i*)(dst + 16),
+                    _mm_or_si128(_mm_or_si128(_mm_shuffle_epi8(c0, m10), _mm_shuffle_epi8(c1, m11)), _mm_shuffle_epi8(c2, m12)));
+                _mm_storeu_si128((__m128i*)(dst + 32),
+                    _mm_or_si128(_mm_or_si128(_mm_shuffle_epi8(c0, m20), _mm_shuffle_epi8(c1, m21)), _mm_shuffle_epi8(c2, m22)));
+#else
+                alignas(16) U8 planes[3][16];
+                _mm_store_si128((__m128i*)planes[0], c0);
+                _mm_store_si128((__m128i*)planes[1], c1);
+                _mm_store_si128((__m128i*)planes[2], c2);
+                for (S32 i = 0; i < 16; ++i)
+                {
+                    dst[i * 3] = planes[0][i];
+                    dst[i * 3 + 1] = planes[1][i];
+                    dst[i * 3 + 2] = planes[2][i];
+                }
+#endif
+            }
+            else
+            {
+                __m128i c1 = load_u8x16(src[1] + x);
+                __m128i c2 = load_u8x16(src[2] + x);
+                __m128i c3 = load_u8x16(src[3] + x);
+                __m128i lo01 = _mm_unpacklo_epi8(c0, c1);
+                __m128i hi01 = _mm_unpackhi_epi8(c0, c1);
+                __m128i lo23 = _mm_unpacklo_epi8(c2, c3);
+                __m128i hi23 = _mm_unpackhi_epi8(c2, c3);
+                _mm_storeu_si128((__m128i*)dst, _mm_unpacklo_epi16(lo01, lo23));
+                _mm_storeu_si128((__m128i*)(dst + 16), _mm_unpackhi_epi16(lo01, lo23));
+                _mm_storeu_si128((__m128i*)(dst + 32), _mm_unpacklo_epi16(hi01, hi23));
+                _mm_storeu_si128((__m128i*)(dst + 48), _mm_unpackhi_epi16(hi01, hi23));
+            }
+        }
+
+        for (; x < width; ++x)
+        {
+            for (S32 c = 0; c < CHANNELS; ++c)
+            {
+                *dst++ = (U8)src[c][x];
+            }
+        }
+    }
+
+    // Copy the component planes into the interleaved raw image.  OpenJPEG
+    // stores the top row first, LLImageRaw the bottom row.
+    template <S32 CHANNELS>
+    void copy_planes_flipped(U8* dst, const OPJ_INT32* const* planes, S32 width, S32 height, S32 stride)
+    {
+        for (S32 row = 0; row < height; ++row)
+        {
+            S32 src_row = height - 1 - row;
+            const OPJ_INT32* src[CHANNELS];
+            for (S32 c = 0; c < CHANNELS; ++c)
+            {
+                src[c] = planes[c] + (size_t)src_row * stride;
+            }
+            interleave_row<CHANNELS>(dst + (size_t)row * width * CHANNELS, src, width);
+        }
+    }
+}
+
 LLImageJ2COJ::LLImageJ2COJ()
-    : LLImageJ2CImpl()
+    : LLImageJ2CImpl(),
+      mHasRegion(false)
 {
 }
 
 bool LLImageJ2COJ::initDecode(LLImageJ2C &base, LLImageRaw &raw_image, int discard_level, int* region)
 {
-    // No specific implementation for this method in the OpenJpeg case
-    return false;
+    // The discard level was already applied to base, only the region
+    // needs remembering until decodeImpl().
+    mHasRegion = region != NULL;
+    if (mHasRegion)
+    {
+        for (S32 i = 0; i < 4; ++i)
+        {
+            mRegion[i] = region[i];
+        }
+    }
+    return true;
 }
 
 bool LLImageJ2COJ::initEncode(LLImageJ2C &base, LLImageRaw &raw_image, int blocks_size, int precincts_size, int levels)
@@ -235,6 +365,10 @@ bool LLImageJ2COJ::initEncode(LLImageJ2C &base, LLImageRaw &raw_image, int block
 
 bool LLImageJ2COJ::decodeImpl(LLImageJ2C &base, LLImageRaw &raw_image, F32 decode_time, S32 first_channel, S32 max_channel_count)
 {
+    // The region only applies to the decode that follows initDecode()
+    const bool has_region = mHasRegion;
+    mHasRegion = false;
+
     /* Extract metadata */
     /* ---------------- */
     U8* c_data = base.getData();
@@ -319,6 +453,20 @@ bool LLImageJ2COJ::decodeImpl(LLImageJ2C &base, LLImageRaw &raw_image, F32 decod
 
     //opj_decoder_set_strict_mode(opj_decoder_p, OPJ_FALSE);
 
+    // Very large textures are worth OpenJPEG's own tile/code-block threads
+    // on top of the decode pool.  Silently ignored when the library was
+    // built without thread support.
+    S32 threads = LLImageJ2C::getLargeImageDecodeThreads();
+    if (threads > 1)
+    {
+        S32 discard = llmax((S32)base.getRawDiscardLevel(), 0);
+        S32 area = (base.getWidth() >> discard) * (base.getHeight() >> discard);
+        if (area >= LLImageJ2C::LARGE_IMAGE_DECODE_AREA)
+        {
+            opj_codec_set_threads(opj_decoder_p, threads);
+        }
+    }
+
     /* open a byte stream */
     LLJp2StreamReader streamReader(&base);
     opj_stream_t* opj_stream_p = opj_stream_default_create(OPJ_STREAM_READ);
@@ -329,9 +477,27 @@ bool LLImageJ2COJ::decodeImpl(LLImageJ2C &base, LLImageRaw &raw_image, F32 decod
     opj_stream_set_user_data_length(opj_stream_p, base.getDataSize());
 
     /* decode the stream and fill the image structure */
-    bool success = opj_read_header(opj_stream_p, opj_decoder_p, &image) &&
-                    opj_decode(opj_decoder_p, opj_stream_p, image) &&
-                    opj_end_decompress(opj_decoder_p, opj_stream_p);
+    bool success = opj_read_header(opj_stream_p, opj_decoder_p, &image);
+    if (success && has_region)
+    {
+        // region is x0, y0, x1, y1 in full resolution codestream pixels
+        S32 x0 = llclamp(mRegion[0], (S32)image->x0, (S32)image->x1);
+        S32 y0 = llclamp(mRegion[1], (S32)image->y0, (S32)image->y1);
+        S32 x1 = llclamp(mRegion[2], x0, (S32)image->x1);
+        S32 y1 = llclamp(mRegion[3], y0, (S32)image->y1);
+        if (x1 > x0 && y1 > y0)
+        {
+            success = opj_set_decode_area(opj_decoder_p, image, x0, y0, x1, y1);
+        }
+        else
+        {
+            LL_WARNS() << "Ignoring empty decode region " << mRegion[0] << "," << mRegion[1]
+                       << " " << mRegion[2] << "," << mRegion[3] << LL_ENDL;
+        }
+    }
+    success = success &&
+                opj_decode(opj_decoder_p, opj_stream_p, image) &&
+                opj_end_decompress(opj_decoder_p, opj_stream_p);
 
     /* close the byte stream */
     opj_stream_destroy(opj_stream_p);
@@ -374,6 +540,8 @@ bool LLImageJ2COJ::decodeImpl(LLImageJ2C &base, LLImageRaw &raw_image, F32 decod
     S32 channels = img_components - first_channel;
     if( channels > max_channel_count )
         channels = max_channel_count;
+    if (channels > MAX_IMAGE_COMPONENTS)
+        channels = MAX_IMAGE_COMPONENTS;
 
     // Component buffers are allocated in an image width by height buffer.
     // The image placed in that buffer is ceil(width/2^factor) by
@@ -384,8 +552,10 @@ bool LLImageJ2COJ::decodeImpl(LLImageJ2C &base, LLImageRaw &raw_image, F32 decod
     // factor.)
     S32 comp_width = image->comps[0].w;
     S32 f=image->comps[0].factor;
-    S32 width = ceildivpow2(image->x1 - image->x0, f);
-    S32 height = ceildivpow2(image->y1 - image->y0, f);
+    // with a decode area the reduced component may be a pixel smaller
+    // than the rounded up area
+    S32 width = llmin(ceildivpow2(image->x1 - image->x0, f), (S32)image->comps[0].w);
+    S32 height = llmin(ceildivpow2(image->y1 - image->y0, f), (S32)image->comps[0].h);
     raw_image.resize(width, height, channels);
     U8 *rawp = raw_image.getData();
     if (!rawp)
@@ -399,30 +569,59 @@ bool LLImageJ2COJ::decodeImpl(LLImageJ2C &base, LLImageRaw &raw_image, F32 decod
     // first_channel is what channel to start copying from
     // dest is what channel to copy to.  first_channel comes from the
     // argument, dest always starts writing at channel zero.
-    for (S32 comp = first_channel, dest=0; comp < first_channel + channels;
-        comp++, dest++)
+    const OPJ_INT32* planes[MAX_IMAGE_COMPONENTS];
+    for (S32 dest = 0; dest < channels; dest++)
     {
-        if (image->comps[comp].data)
+        const opj_image_comp_t& comp = image->comps[first_channel + dest];
+        if (!comp.data) // Some rare OpenJPEG versions have this bug.
+        {
+#ifdef SHOW_DEBUG
+            LL_DEBUGS("Texture") << "ERROR -> decodeImpl: failed to decode image! (NULL comp data - OpenJPEG bug)" << LL_ENDL;
+#endif
+            opj_image_destroy(image);
+            base.decodeFailed();
+            return true; // done
+        }
+        if (comp.w < (OPJ_UINT32)width || comp.h < (OPJ_UINT32)height)
+        {
+            // subsampled components are not supported
+            LL_WARNS() << "decodeImpl: component " << first_channel + dest << " is " << comp.w << "x" << comp.h
+                       << ", expected " << width << "x" << height << LL_ENDL;
+            opj_image_destroy(image);
+            base.decodeFailed();
+            return true; // done
+        }
+        planes[dest] = comp.data;
+    }
+
+    switch (channels)
+    {
+    case 1:
+        copy_planes_flipped<1>(rawp, planes, width, height, comp_width);
+        break;
+    case 2:
+        copy_planes_flipped<2>(rawp, planes, width, height, comp_width);
+        break;
+    case 3:
+        copy_planes_flipped<3>(rawp, planes, width, height, comp_width);
+        break;
+    case 4:
+        copy_planes_flipped<4>(rawp, planes, width, height, comp_width);
+        break;
+    default:
+        for (S32 dest = 0; dest < channels; dest++)
         {
             S32 offset = dest;
             for (S32 y = (height - 1); y >= 0; y--)
             {
                 for (S32 x = 0; x < width; x++)
                 {
-                    rawp[offset] = image->comps[comp].data[y*comp_width + x];
+                    rawp[offset] = planes[dest][y*comp_width + x];
                     offset += channels;
                 }
             }
         }
-        else // Some rare OpenJPEG versions have this bug.
-        {
-#ifdef SHOW_DEBUG
-            LL_DEBUGS("Texture") << "ERROR -> decodeImpl: failed to decode image! (NULL comp data - OpenJPEG bug)" << LL_ENDL;
-#endif
-            opj_image_destroy(image);
-            base.decodeFailed();
-            return true; // done
-        }
+        break;
     }
 
     /* free image data structure */
@@ -0,0 +1,476 @@
+/**
+ * @file llinventorycache.cpp
+ * @brief Binary on-disk format for the local inventory cache.
+ *
+ * $LicenseInfo:firstyear=2024&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2024, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#include "linden_common.h"
+
+#include "llinventorycache.h"
+
+#include "llfile.h"
+
+#if defined(LL_USESYSTEMLIBS) || defined(LL_LINUX)
+# include <zlib.h>
+#else
+# include "zlib/zlib.h"
+#endif
+
+#include <type_traits>
+
+namespace LLInventoryCache
+{
+
+static_assert(std::is_trivially_copyable<CategoryRecord>::value, "CategoryRecord must be trivially copyable");
+static_assert(std::is_trivially_copyable<ItemRecord>::value, "ItemRecord must be trivially copyable");
+// Records are written byte for byte; every padding byte is an explicit mPad
+// member so value-initialization leaves nothing uninitialized on disk.
+static_assert(sizeof(CategoryRecord) == 4 * sizeof(LLUUID) + 8 + sizeof(StringRef), "CategoryRecord has implicit padding");
+static_assert(sizeof(ItemRecord) == 8 * sizeof(LLUUID) + 36 + 2 * sizeof(StringRef), "ItemRecord has implicit padding");
+
+// zlib's internal buffer; the default 8KB means one syscall per 8KB
+static constexpr unsigned GZ_BUFFER_SIZE = 256 * 1024;
+
+namespace
+{
+    template<typename RECORD>
+    inline RECORD read_record(const Chunk& chunk, U32 index)
+    {
+        // Records are not guaranteed to be aligned inside the inflated buffer
+        RECORD rec;
+        memcpy(&rec, chunk.mRecords + (size_t)index * sizeof(RECORD), sizeof(RECORD));
+        return rec;
+    }
+
+    inline bool read_string(const Chunk& chunk, const StringRef& ref, std::string& out)
+    {
+        if (ref.mOffset > chunk.mPoolSize || ref.mLength > chunk.mPoolSize - ref.mOffset)
+        {
+            return false;
+        }
+        out.assign(chunk.mPool + ref.mOffset, ref.mLength);
+        return true;
+    }
+
+    gzFile open_gz(const std::string& filename, const char* mode)
+    {
+#if LL_WINDOWS
+        std::wstring utf16filename = ll_convert_string_to_wide(filename);
+        return gzopen_w(utf16filename.c_str(), mode);
+#else
+        return gzopen(filename.c_str(), mode);
+#endif
+    }
+
+    // Inventory caches deflate well, but never by more than this.  Anything
+    // claiming to beyond it is a damaged trailer, not a real size.
+    const size_t MAX_INFLATE_RATIO = 32;
+}
+
+// The gzip trailer stores the inflated size modulo 2^32, which is
+// plenty for an inventory cache and lets us inflate with one allocation.
+// It comes from disk, so it's only trusted up to MAX_INFLATE_RATIO times
+// the compressed size; the inflate loop grows the buffer past that.
+size_t getInflatedSizeHint(const std::string& filename)
+{
+    LLFILE* fp = LLFile::fopen(filename, "rb");
+    if (!fp)
+    {
+        return 0;
+    }
+    U32 isize = 0;
+    long compressed_size = 0;
+    if (fseek(fp, -4, SEEK_END) == 0)
+    {
+        U8 trailer[4];
+        if (fread(trailer, 1, 4, fp) == 4)
+        {
+            isize = trailer[0] | (trailer[1] << 8) | (trailer[2] << 16) | ((U32)trailer[3] << 24);
+            compressed_size = ftell(fp);
+        }
+    }
+    fclose(fp);
+    if (compressed_size <= 0)
+    {
+        return 0;
+    }
+    return llmin((size_t)isize, (size_t)compressed_size * MAX_INFLATE_RATIO);
+}
+
+bool unpackCategory(const Chunk& chunk, U32 index, LLInventoryCategory& cat,
+                    LLUUID& owner_id, S32& version)
+{
+    llassert(chunk.mType == CHUNK_CATEGORIES && index < chunk.mCount);
+    const CategoryRecord rec = read_record<CategoryRecord>(chunk, index);
+
+    std::string name;
+    if (!read_string(chunk, rec.mName, name))
+    {
+        return false;
+    }
+
+    cat.setUUID(rec.mUUID);
+    cat.setParent(rec.mParentUUID);
+    cat.LLInventoryObject::setThumbnailUUID(rec.mThumbnailUUID);
+    cat.setType((LLAssetType::EType)rec.mType);
+    cat.setPreferredType((LLFolderType::EType)rec.mPreferredType);
+    cat.LLInventoryObject::rename(name);
+    owner_id = rec.mOwnerID;
+    version = rec.mVersion;
+    return true;
+}
+
+bool unpackItem(const Chunk& chunk, U32 index, LLInventoryItem& item)
+{
+    llassert(chunk.mType == CHUNK_ITEMS && index < chunk.mCount);
+    const ItemRecord rec = read_record<ItemRecord>(chunk, index);
+
+    std::string name, desc;
+    if (!read_string(chunk, rec.mName, name) || !read_string(chunk, rec.mDescription, desc))
+    {
+        return false;
+    }
+
+    item.setUUID(rec.mUUID);
+    item.setParent(rec.mParentUUID);
+    item.LLInventoryObject::setThumbnailUUID(rec.mThumbnailUUID);
+    item.setAssetUUID(rec.mAssetUUID);
+    item.setType((LLAssetType::EType)rec.mType);
+    // Inventory type first, setPermissions() adjusts masks based on it
+    item.setInventoryType((LLInventoryType::EType)rec.mInventoryType);
+
+    LLPermissions perm;
+    perm.init(rec.mCreator, rec.mOwner, rec.mLastOwner, rec.mGroup);
+    perm.setMaskBase(rec.mMaskBase);
+    perm.setMaskOwner(rec.mMaskOwner);
+    perm.setMaskGroup(rec.mMaskGroup);
+    perm.setMaskEveryone(rec.mMaskEveryone);
+    perm.setMaskNext(rec.mMaskNext);
+    perm.fix();
+    item.setPermissions(perm);
+
+    item.setSaleInfo(LLSaleInfo((LLSaleInfo::EForSale)rec.mSaleType, rec.mSalePrice));
+    item.setFlags(rec.mFlags);
+    item.LLInventoryObject::rename(name);
+    item.setDescription(desc);
+    item.LLInventoryObject::setCreationDate(rec.mCreationDate);
+    return true;
+}
+
+///----------------------------------------------------------------------------
+/// Writer
+///----------------------------------------------------------------------------
+
+Writer::Writer()
+:   mFile(nullptr),
+    mFailed(false),
+    mChunkType(CHUNK_CATEGORIES),
+    mChunkCount(0)
+{
+}
+
+Writer::~Writer()
+{
+    if (mFile)
+    {
+        // Never committed; drop the partial file
+        gzclose(mFile);
+        LLFile::remove(mFilename + ".t");
+    }
+}
+
+bool Writer::open(const std::string& filename, S32 version)
+{
+    llassert(!mFile);
+    mFilename = filename;
+    mFailed = false;
+    mChunkCount = 0;
+    mRecords.clear();
+    mPool.clear();
+
+    // Level 6 compresses inventory almost as well as 9 at a third of the cost
+    mFile = open_gz(mFilename + ".t", "wb6");
+    if (!mFile)
+    {
+        return false;
+    }
+    gzbuffer(mFile, GZ_BUFFER_SIZE);
+
+    FileHeader header;
+    header.mMagic = FILE_MAGIC;
+    header.mVersion = version;
+    header.mRecordSize[0] = sizeof(CategoryRecord);
+    header.mRecordSize[1] = sizeof(ItemRecord);
+    if (gzwrite(mFile, &header, sizeof(header)) != (int)sizeof(header))
+    {
+        mFailed = true;
+    }
+    return !mFailed;
+}
+
+void Writer::beginChunk(EChunkType type)
+{
+    if (mChunkCount && (mChunkType != type || mChunkCount >= RECORDS_PER_CHUNK))
+    {
+        flushChunk();
+    }
+    mChunkType = type;
+}
+
+StringRef Writer::appendString(const std::string& str)
+{
+    StringRef ref;
+    ref.mOffset = (U32)mPool.size();
+    ref.mLength = (U32)str.size();
+    mPool.append(str);
+    return ref;
+}
+
+bool Writer::flushChunk()
+{
+    if (!mChunkCount || mFailed)
+    {
+        return !mFailed;
+    }
+
+    ChunkHeader header;
+    header.mType = mChunkType;
+    header.mCount = mChunkCount;
+    header.mPoolSize = (U32)mPool.size();
+    if (gzwrite(mFile, &header, sizeof(header)) != (int)sizeof(header)
+        || gzwrite(mFile, mRecords.data(), (unsigned)mRecords.size()) != (int)mRecords.size()
+        || (!mPool.empty() && gzwrite(mFile, mPool.data(), (unsigned)mPool.size()) != (int)mPool.size()))
+    {
+        int errnum = 0;
+        LL_WARNS("Inventory") << "Failed writing inventory cache chunk: " << gzerror(mFile, &errnum) << LL_ENDL;
+        mFailed = true;
+    }
+
+    mChunkCount = 0;
+    mRecords.clear();
+    mPool.clear();
+    return !mFailed;
+}
+
+void Writer::addCategory(const LLInventoryCategory& cat, const LLUUID& owner_id, S32 version)
+{
+    beginChunk(CHUNK_CATEGORIES);
+
+    CategoryRecord rec{};
+    rec.mUUID = cat.LLInventoryObject::getUUID();
+    rec.mParentUUID = cat.getParentUUID();
+    rec.mThumbnailUUID = cat.LLInventoryObject::getThumbnailUUID();
+    rec.mOwnerID = owner_id;
+    rec.mVersion = version;
+    rec.mType = (S8)cat.getActualType();
+    rec.mPreferredType = (S8)cat.getPreferredType();
+    rec.mName = appendString(cat.LLInventoryObject::getName());
+
+    const U8* bytes = reinterpret_cast<const U8*>(&rec);
+    mRecords.insert(mRecords.end(), bytes, bytes + sizeof(rec));
+    ++mChunkCount;
+}
+
+void Writer::addItem(const LLInventoryItem& item)
+{
+    beginChunk(CHUNK_ITEMS);
+
+    // Qualified calls throughout: derived classes resolve links in the
+    // virtual accessors and we must store this item's own data.
+    const LLPermissions& perm = item.LLInventoryItem::getPermissions();
+    const LLSaleInfo& sale_info = item.LLInventoryItem::getSaleInfo();
+
+    ItemRecord rec{};
+    rec.mUUID = item.LLInventoryObject::getUUID();
+    rec.mParentUUID = item.getParentUUID();
+    rec.mThumbnailUUID = item.LLInventoryObject::getThumbnailUUID();
+    rec.mAssetUUID = item.LLInventoryItem::getAssetUUID();
+    rec.mCreator = perm.getCreator();
+    rec.mOwner = perm.getOwner();
+    rec.mLastOwner = perm.getLastOwner();
+    rec.mGroup = perm.getGroup();
+    rec.mMaskBase = perm.getMaskBase();
+    rec.mMaskOwner = perm.getMaskOwner();
+    rec.mMaskGroup = perm.getMaskGroup();
+    rec.mMaskEveryone = perm.getMaskEveryone();
+    rec.mMaskNext = perm.getMaskNextOwner();
+    rec.mFlags = item.LLInventoryItem::getFlags();
+    rec.mSalePrice = sale_info.getSalePrice();
+    rec.mCreationDate = (S32)item.LLInventoryItem::getCreationDate();
+    rec.mType = (S8)item.getActualType();
+    rec.mInventoryType = (S8)item.LLInventoryItem::getInventoryType();
+    rec.mSaleType = (U8)sale_info.getSaleType();
+    rec.mName = appendString(item.LLInventoryObject::getName());
+    rec.mDescription = appendString(item.getActualDescription());
+
+    const U8* bytes = reinterpret_cast<const U8*>(&rec);
+    mRecords.insert(mRecords.end(), bytes, bytes + sizeof(rec));
+    ++mChunkCount;
+}
+
+bool Writer::close()
+{
+    if (!mFile)
+    {
+        return false;
+    }
+
+    flushChunk();
+    int status = gzclose(mFile);
+    mFile = nullptr;
+
+    const std::string tmpfile = mFilename + ".t";
+    if (mFailed || status != Z_OK)
+    {
+        LLFile::remove(tmpfile);
+        return false;
+    }
+#if LL_WINDOWS
+    // Rename in windows needs the dstfile to not exist.
+    LLFile::remove(mFilename, ENOENT);
+#endif
+    return LLFile::rename(tmpfile, mFilename) == 0;
+}
+
+///----------------------------------------------------------------------------
+/// Reader
+///----------------------------------------------------------------------------
+
+bool Reader::open(const std::string& filename)
+{
+    LL_PROFILE_ZONE_SCOPED;
+
+    gzFile src = open_gz(filename, "rb");
+    if (!src)
+    {
+        return false;
+    }
+    gzbuffer(src, GZ_BUFFER_SIZE);
+
+    std::vector<U8> buffer;
+    size_t size = 0;
+    size_t capacity = llmax(getInflatedSizeHint(filename), (size_t)GZ_BUFFER_SIZE);
+    bool ok = true;
+    while (true)
+    {
+        if (size == capacity)
+        {
+            capacity *= 2;
+        }
+        buffer.resize(capacity);
+        int bytes = gzread(src, buffer.data() + size, (unsigned)llmin(capacity - size, (size_t)INT_MAX));
+        if (bytes < 0)
+        {
+            int errnum = 0;
+            LL_WARNS("Inventory") << "Failed inflating " << filename << ": " << gzerror(src, &errnum) << LL_ENDL;
+            ok = false;
+            break;
+        }
+        size += bytes;
+        if (bytes == 0 || gzeof(src))
+        {
+            break;
+        }
+    }
+    gzclose(src);
+
+    if (!ok)
+    {
+        return false;
+    }
+    buffer.resize(size);
+    return parse(std::move(buffer));
+}
+
+bool Reader::parse(std::vector<U8>&& buffer)
+{
+    mBuffer = std::move(buffer);
+    mChunks.clear();
+    mVersion = 0;
+
+    const U8* cur = mBuffer.data();
+    const U8* end = cur + mBuffer.size();
+
+    FileHeader header;
+    if ((size_t)(end - cur) < sizeof(header))
+    {
+        return false;
+    }
+    memcpy(&header, cur, sizeof(header));
+    cur += sizeof(header);
+    if (header.mMagic != FILE_MAGIC)
+    {
+        return false;
+    }
+    mVersion = header.mVersion;
+    if (header.mRecordSize[0] != sizeof(CategoryRecord) || header.mRecordSize[1] != sizeof(ItemRecord))
+    {
+        // Written by a build with a different record layout
+        return false;
+    }
+
+    while (cur < end)
+    {
+        ChunkHeader chunk_header;
+        if ((size_t)(end - cur) < sizeof(chunk_header))
+        {
+            return false;
+        }
+        memcpy(&chunk_header, cur, sizeof(chunk_header));
+        cur += sizeof(chunk_header);
+
+        size_t record_size;
+        switch (chunk_header.mType)
+        {
+        case CHUNK_CATEGORIES:
+            record_size = sizeof(CategoryRecord);
+            break;
+        case CHUNK_ITEMS:
+            record_size = sizeof(ItemRecord);
+            break;
+        default:
+            return false;
+        }
+
+        const size_t records_size = record_size * chunk_header.mCount;
+        if (chunk_header.mCount > RECORDS_PER_CHUNK
+            || (size_t)(end - cur) < records_size
+            || (size_t)(end - cur) - records_size < chunk_header.mPoolSize)
+        {
+            return false;
+        }
+
+        Chunk chunk;
+        chunk.mType = (EChunkType)chunk_header.mType;
+        chunk.mCount = chunk_header.mCount;
+        chunk.mRecords = cur;
+        chunk.mPool = reinterpret_cast<const char*>(cur + records_size);
+        chunk.mPoolSize = chunk_header.mPoolSize;
+        mChunks.push_back(chunk);
+
+        cur += records_size + chunk_header.mPoolSize;
+    }
+    return true;
+}
+
+} // namespace LLInventoryCache
@@ -0,0 +1,192 @@
+/**
+ * @file llinventorycache.h
+ * @brief Binary on-disk format for the local inventory cache.
+ *
+ * $LicenseInfo:firstyear=2024&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2024, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#ifndef LL_LLINVENTORYCACHE_H
+#define LL_LLINVENTORYCACHE_H
+
+#include "llinventory.h"
+
+#include <vector>
+
+struct gzFile_s;
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// LLInventoryCache
+//
+//   The inventory cache is a gzipped stream of independent chunks, each
+//   holding up to RECORDS_PER_CHUNK fixed-width records of a single kind
+//   followed by the string pool those records point into:
+//
+//     FileHeader
+//     ChunkHeader, CategoryRecord[count], char pool[pool_size]
+//     ChunkHeader, ItemRecord[count], char pool[pool_size]
+//     ...
+//
+//   Chunks are self-contained so the writer can emit them as soon as they
+//   fill up, and the reader can hand them out to worker threads to decode
+//   without any shared state. Records are stored in host byte order; the
+//   cache is local to the machine that wrote it.
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+namespace LLInventoryCache
+{
+    constexpr U32 FILE_MAGIC = 0x43564E49; // "INVC"
+    constexpr U32 RECORDS_PER_CHUNK = 4096;
+
+    enum EChunkType : U32
+    {
+        CHUNK_CATEGORIES = 1,
+        CHUNK_ITEMS = 2
+    };
+
+    struct FileHeader
+    {
+        U32 mMagic;
+        S32 mVersion;   // caller supplied, see LLInventoryModel::sCurrentInvCacheVersion
+        U32 mRecordSize[2]; // sizeof(CategoryRecord), sizeof(ItemRecord)
+    };
+
+    struct ChunkHeader
+    {
+        U32 mType;
+        U32 mCount;
+        U32 mPoolSize;
+    };
+
+    struct StringRef
+    {
+        U32 mOffset;
+        U32 mLength;
+    };
+
+    struct CategoryRecord
+    {
+        LLUUID mUUID;
+        LLUUID mParentUUID;
+        LLUUID mThumbnailUUID;
+        LLUUID mOwnerID;
+        S32 mVersion;
+        S8 mType;
+        S8 mPreferredType;
+        U8 mPad[2];
+        StringRef mName;
+    };
+
+    struct ItemRecord
+    {
+        LLUUID mUUID;
+        LLUUID mParentUUID;
+        LLUUID mThumbnailUUID;
+        LLUUID mAssetUUID;
+        LLUUID mCreator;
+        LLUUID mOwner;
+        LLUUID mLastOwner;
+        LLUUID mGroup;
+        U32 mMaskBase;
+        U32 mMaskOwner;
+        U32 mMaskGroup;
+        U32 mMaskEveryone;
+        U32 mMaskNext;
+        U32 mFlags;
+        S32 mSalePrice;
+        S32 mCreationDate;
+        S8 mType;
+        S8 mInventoryType;
+        U8 mSaleType;
+        U8 mPad;
+        StringRef mName;
+        StringRef mDescription;
+    };
+
+    // A view of one chunk inside the buffer owned by a Reader.
+    struct Chunk
+    {
+        EChunkType mType;
+        U32 mCount;
+        const U8* mRecords;
+        const char* mPool;
+        U32 mPoolSize;
+    };
+
+    // Fills cat from record index of chunk. Returns false if the record
+    // references strings outside of the chunk pool.
+    bool unpackCategory(const Chunk& chunk, U32 index, LLInventoryCategory& cat,
+                        LLUUID& owner_id, S32& version);
+    bool unpackItem(const Chunk& chunk, U32 index, LLInventoryItem& item);
+
+    // Inflated size of a gzipped file as claimed by its trailer, but never
+    // more than a sane ratio of its compressed size.  0 if unreadable.
+    size_t getInflatedSizeHint(const std::string& filename);
+
+    class Writer
+    {
+    public:
+        Writer();
+        ~Writer();
+
+        // Writes to filename + ".t" and renames over filename on close()
+        // so a crash mid-save leaves the previous cache in place.
+        bool open(const std::string& filename, S32 version);
+        void addCategory(const LLInventoryCategory& cat, const LLUUID& owner_id, S32 version);
+        void addItem(const LLInventoryItem& item);
+        bool close();
+
+        bool isOpen() const { return mFile != nullptr; }
+
+    private:
+        void beginChunk(EChunkType type);
+        StringRef appendString(const std::string& str);
+        bool flushChunk();
+
+        std::string mFilename;
+        gzFile_s* mFile;
+        bool mFailed;
+        EChunkType mChunkType;
+        U32 mChunkCount;
+        std::vector<U8> mRecords;
+        std::string mPool;
+    };
+
+    class Reader
+    {
+    public:
+        // Inflates filename into memory and indexes its chunks. Returns
+        // false if the file is missing, truncated or not an inventory
+        // cache. getVersion() is valid whenever the header could be read.
+        bool open(const std::string& filename);
+        // Same as open() for an already decompressed buffer, mainly for tests.
+        bool parse(std::vector<U8>&& buffer);
+
+        S32 getVersion() const { return mVersion; }
+        const std::vector<Chunk>& getChunks() const { return mChunks; }
+
+    private:
+        std::vector<U8> mBuffer;
+        std::vector<Chunk> mChunks;
+        S32 mVersion = 0;
+    };
+}
+
+#endif // LL_LLINVENTORYCACHE_H
@@ -0,0 +1,319 @@
+/**
+ * @file llinventorycache_test.cpp
+ * @brief Tests and load benchmark for the binary inventory cache
+ *
+ * $LicenseInfo:firstyear=2024&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2024, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#include "linden_common.h"
+#include "llsd.h"
+#include "llrand.h"
+#include "llsdserialize.h"
+#include "lltimer.h"
+#include "llfile.h"
+#include "llsys.h"
+
+#include "../llinventorycache.h"
+#include "../test/lltut.h"
+
+#if defined(LL_USESYSTEMLIBS) || defined(LL_LINUX)
+# include <zlib.h>
+#else
+# include "zlib/zlib.h"
+#endif
+
+#include <boost/iostreams/device/array.hpp>
+#include <boost/iostreams/stream.hpp>
+
+namespace
+{
+    LLPointer<LLInventoryItem> create_cache_item(const LLUUID& parent_id, S32 index)
+    {
+        LLUUID item_id, creator_id, owner_id, group_id, asset_id;
+        item_id.generate();
+        creator_id.generate();
+        owner_id.generate();
+        asset_id.generate();
+
+        LLPermissions perm;
+        perm.init(creator_id, owner_id, owner_id, group_id);
+        perm.initMasks(PERM_ALL, PERM_ALL, PERM_NONE, PERM_COPY, PERM_MODIFY | PERM_COPY);
+
+        LLPointer<LLInventoryItem> item = new LLInventoryItem(
+            item_id,
+            parent_id,
+            perm,
+            asset_id,
+            LLAssetType::AT_OBJECT,
+            LLInventoryType::IT_OBJECT,
+            llformat("Cached Object %d", index),
+            std::string("Used for Testing"),
+            LLSaleInfo(LLSaleInfo::FS_COPY, ll_rand(1000)),
+            ll_rand(),
+            (S32)time(NULL));
+        return item;
+    }
+
+    void ensure_items_equal(const std::string& msg, const LLInventoryItem* dst, const LLInventoryItem* src)
+    {
+        tut::ensure_equals(msg + " uuid", dst->getUUID(), src->getUUID());
+        tut::ensure_equals(msg + " parent", dst->getParentUUID(), src->getParentUUID());
+        tut::ensure_equals(msg + " thumbnail", dst->getThumbnailUUID(), src->getThumbnailUUID());
+        tut::ensure_equals(msg + " name", dst->getName(), src->getName());
+        tut::ensure_equals(msg + " type", dst->getType(), src->getType());
+        tut::ensure_equals(msg + " permissions", dst->getPermissions(), src->getPermissions());
+        tut::ensure_equals(msg + " description", dst->getDescription(), src->getDescription());
+        tut::ensure_equals(msg + " sale type", dst->getSaleInfo().getSaleType(), src->getSaleInfo().getSaleType());
+        tut::ensure_equals(msg + " sale price", dst->getSaleInfo().getSalePrice(), src->getSaleInfo().getSalePrice());
+        tut::ensure_equals(msg + " asset", dst->getAssetUUID(), src->getAssetUUID());
+        tut::ensure_equals(msg + " inventory type", dst->getInventoryType(), src->getInventoryType());
+        tut::ensure_equals(msg + " flags", dst->getFlags(), src->getFlags());
+        tut::ensure_equals(msg + " creation date", dst->getCreationDate(), src->getCreationDate());
+    }
+}
+
+namespace tut
+{
+    struct inventory_cache_data
+    {
+        inventory_cache_data()
+        {
+            mFilename = llformat("llinventorycache_test_%d.inv.gz", ll_rand(1 << 30));
+        }
+
+        ~inventory_cache_data()
+        {
+            LLFile::remove(mFilename, ENOENT);
+        }
+
+        std::string mFilename;
+    };
+    typedef test_group<inventory_cache_data> inventory_cache_test;
+    typedef inventory_cache_test::object inventory_cache_object;
+    tut::inventory_cache_test invcache("LLInventoryCache");
+
+    template<> template<>
+    void inventory_cache_object::test<1>()
+    {
+        set_test_name("round trip through file");
+
+        LLUUID folder_id, owner_id, thumbnail_id;
+        folder_id.generate();
+        owner_id.generate();
+        thumbnail_id.generate();
+        LLPointer<LLInventoryCategory> cat = new LLInventoryCategory(
+            folder_id, LLUUID::null, LLFolderType::FT_OBJECT, "Objects");
+        cat->setThumbnailUUID(thumbnail_id);
+
+        // Enough items to spill over several chunks
+        std::vector<LLPointer<LLInventoryItem> > items;
+        for (S32 i = 0; i < (S32)LLInventoryCache::RECORDS_PER_CHUNK * 2 + 17; ++i)
+        {
+            items.push_back(create_cache_item(folder_id, i));
+        }
+
+        LLInventoryCache::Writer writer;
+        ensure("open for write", writer.open(mFilename, 42));
+        writer.addCategory(*cat, owner_id, 7);
+        for (const auto& item : items)
+        {
+            writer.addItem(*item);
+        }
+        ensure("close", writer.close());
+
+        LLInventoryCache::Reader reader;
+        ensure("open for read", reader.open(mFilename));
+        ensure_equals("version", reader.getVersion(), 42);
+
+        const auto& chunks = reader.getChunks();
+        ensure_equals("chunk count", chunks.size(), (size_t)4);
+        ensure_equals("first chunk type", chunks[0].mType, LLInventoryCache::CHUNK_CATEGORIES);
+
+        LLPointer<LLInventoryCategory> dst_cat = new LLInventoryCategory;
+        LLUUID dst_owner;
+        S32 dst_version = 0;
+        ensure("unpack category", LLInventoryCache::unpackCategory(chunks[0], 0, *dst_cat, dst_owner, dst_version));
+        ensure_equals("category uuid", dst_cat->getUUID(), folder_id);
+        ensure_equals("category name", dst_cat->getName(), cat->getName());
+        ensure_equals("category preferred type", dst_cat->getPreferredType(), LLFolderType::FT_OBJECT);
+        ensure_equals("category thumbnail", dst_cat->getThumbnailUUID(), thumbnail_id);
+        ensure_equals("category owner", dst_owner, owner_id);
+        ensure_equals("category version", dst_version, 7);
+
+        size_t index = 0;
+        for (size_t c = 1; c < chunks.size(); ++c)
+        {
+            ensure_equals("item chunk type", chunks[c].mType, LLInventoryCache::CHUNK_ITEMS);
+            for (U32 i = 0; i < chunks[c].mCount; ++i, ++index)
+            {
+                LLPointer<LLInventoryItem> dst = new LLInventoryItem;
+                ensure("unpack item", LLInventoryCache::unpackItem(chunks[c], i, *dst));
+                ensure_items_equal(llformat("item %d", (S32)index), dst, items[index]);
+            }
+        }
+        ensure_equals("item count", index, items.size());
+    }
+
+    template<> template<>
+    void inventory_cache_object::test<2>()
+    {
+        set_test_name("reject truncated and foreign data");
+
+        LLInventoryCache::Reader reader;
+        ensure("empty buffer", !reader.parse(std::vector<U8>()));
+
+        std::vector<U8> garbage(64, 0x5a);
+        ensure("bad magic", !reader.parse(std::move(garbage)));
+
+        LLUUID folder_id;
+        folder_id.generate();
+        LLInventoryCache::Writer writer;
+        ensure("open for write", writer.open(mFilename, 1));
+        writer.addItem(*create_cache_item(folder_id, 0));
+        ensure("close", writer.close());
+        ensure("open for read", reader.open(mFilename));
+
+        // Chop the last byte off the string pool
+        LLInventoryCache::Reader full;
+        full.open(mFilename);
+        const LLInventoryCache::Chunk& chunk = full.getChunks()[0];
+        const U8* begin = chunk.mRecords - sizeof(LLInventoryCache::ChunkHeader) - sizeof(LLInventoryCache::FileHeader);
+        std::vector<U8> truncated(begin, reinterpret_cast<const U8*>(chunk.mPool) + chunk.mPoolSize - 1);
+        ensure("truncated pool", !reader.parse(std::move(truncated)));
+        ensure_equals("version survives truncation", reader.getVersion(), 1);
+
+        // A damaged gzip trailer claiming 4GB must not be taken as the buffer size
+        LLFILE* fp = LLFile::fopen(mFilename, "r+b");
+        ensure("reopen", fp != NULL);
+        const U8 huge[4] = { 0xff, 0xff, 0xff, 0xff };
+        fseek(fp, -4, SEEK_END);
+        fwrite(huge, 1, 4, fp);
+        fclose(fp);
+        ensure("damaged trailer", !reader.open(mFilename));
+
+        // A valid trailer can claim more than the compressed size allows
+        // us to trust, zeros deflate far beyond the inventory cache ratio
+        const size_t zero_size = 4 * 1024 * 1024;
+        std::vector<U8> zeros(zero_size, 0);
+        gzFile dst = gzopen(mFilename.c_str(), "wb9");
+        ensure("gzopen", dst != NULL);
+        ensure_equals("gzwrite", gzwrite(dst, zeros.data(), (unsigned)zeros.size()), (int)zero_size);
+        gzclose(dst);
+        llstat st;
+        ensure("stat", LLFile::stat(mFilename, &st) == 0);
+        ensure("deflated past the cap", (size_t)st.st_size * 32 < zero_size);
+        ensure_equals("hint capped", LLInventoryCache::getInflatedSizeHint(mFilename), (size_t)st.st_size * 32);
+        ensure("not a cache", !reader.open(mFilename));
+    }
+
+    template<> template<>
+    void inventory_cache_object::test<3>()
+    {
+        set_test_name("load benchmark, notation LLSD vs binary chunks");
+
+        if (LLStringUtil::getenv("LL_BENCHMARK").empty())
+        {
+            skip("set LL_BENCHMARK to run");
+        }
+
+        const S32 ITEM_COUNT = 250000;
+        LLUUID folder_id;
+        folder_id.generate();
+        std::vector<LLPointer<LLInventoryItem> > items;
+        items.reserve(ITEM_COUNT);
+        for (S32 i = 0; i < ITEM_COUNT; ++i)
+        {
+            items.push_back(create_cache_item(folder_id, i));
+        }
+
+        // Legacy layout: one notation LLSD map per line, gzipped
+        const std::string legacy_file = mFilename + ".llsd";
+        {
+            llofstream out(legacy_file.c_str());
+            LLSD cache_ver;
+            cache_ver["inv_cache_version"] = 3;
+            out << LLSDOStreamer<LLSDNotationFormatter>(cache_ver) << std::endl;
+            for (const auto& item : items)
+            {
+                out << LLSDOStreamer<LLSDNotationFormatter>(item->asLLSD()) << std::endl;
+            }
+        }
+        gzip_file(legacy_file, legacy_file + ".gz");
+        LLFile::remove(legacy_file);
+
+        LLInventoryCache::Writer writer;
+        writer.open(mFilename, 4);
+        for (const auto& item : items)
+        {
+            writer.addItem(*item);
+        }
+        writer.close();
+        items.clear();
+
+        LLTimer timer;
+        {
+            gunzip_file(legacy_file + ".gz", legacy_file);
+            llifstream file(legacy_file.c_str());
+            std::string line;
+            LLPointer<LLSDParser> parser = new LLSDNotationParser();
+            while (std::getline(file, line))
+            {
+                LLSD s_item;
+                boost::iostreams::stream<boost::iostreams::array_source> iss(line.data(), line.size());
+                parser->parse(iss, s_item, line.length());
+                if (s_item.has("item_id"))
+                {
+                    LLPointer<LLInventoryItem> item = new LLInventoryItem;
+                    item->fromLLSD(s_item);
+                    items.push_back(item);
+                }
+            }
+        }
+        F64 legacy_secs = timer.getElapsedTimeF64();
+        ensure_equals("legacy item count", (S32)items.size(), ITEM_COUNT);
+        items.clear();
+        LLFile::remove(legacy_file);
+        LLFile::remove(legacy_file + ".gz");
+
+        // Single threaded here; the viewer fans the chunks out to the
+        // General thread pool.
+        timer.reset();
+        {
+            LLInventoryCache::Reader reader;
+            reader.open(mFilename);
+            for (const auto& chunk : reader.getChunks())
+            {
+                for (U32 i = 0; i < chunk.mCount; ++i)
+                {
+                    LLPointer<LLInventoryItem> item = new LLInventoryItem;
+                    LLInventoryCache::unpackItem(chunk, i, *item);
+                    items.push_back(item);
+                }
+            }
+        }
+        F64 binary_secs = timer.getElapsedTimeF64();
+        ensure_equals("binary item count", (S32)items.size(), ITEM_COUNT);
+
+        LL_INFOS() << ITEM_COUNT << " items: notation " << legacy_secs << "s, binary "
+                   << binary_secs << "s (" << legacy_secs / llmax(binary_secs, 1e-6) << "x)" << LL_ENDL;
+    }
+}
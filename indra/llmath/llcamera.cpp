@@ -291,6 +291,79 @@ S32 LLCamera::AABBInRegionFrustumNoFarClip(const LLVector4a& center, const LLVec
     return AABBInFrustumNoFarClip(center, radius, mRegionPlanes);
 }
 
+// Structure of arrays version of AABBInFrustum, four boxes per iteration.
+// Sums in the same order as LLVector4a::dot3 so results match the single
+// box test exactly.
+static void aabbs_in_frustum(const LLPlane* planes, const U8* plane_mask, U32 max_planes, U32 skip_plane,
+                             const LLVector4a* centers, const LLVector4a* radii, S32* results, U32 count)
+{
+    for (U32 first = 0; first < count; first += 4)
+    {
+        U32 n = llmin(count - first, (U32) 4);
+
+        // pad the last block with copies of its last box
+        LLQuad c[4];
+        LLQuad r[4];
+        for (U32 j = 0; j < 4; ++j)
+        {
+            U32 idx = first + llmin(j, n - 1);
+            c[j] = centers[idx];
+            r[j] = radii[idx];
+        }
+        _MM_TRANSPOSE4_PS(c[0], c[1], c[2], c[3]);
+        _MM_TRANSPOSE4_PS(r[0], r[1], r[2], r[3]);
+
+        LLQuad outside = _mm_setzero_ps();
+        LLQuad partial = _mm_setzero_ps();
+        for (U32 i = 0; i < max_planes; i++)
+        {
+            U8 mask = plane_mask[i];
+            if (i == skip_plane || mask >= LLCamera::PLANE_MASK_NUM)
+            {
+                continue;
+            }
+
+            const LLPlane& p = planes[i];
+            const LLVector4a& scale = sFrustumScaler[mask];
+            LLQuad d = _mm_sub_ps(_mm_setzero_ps(), _mm_set1_ps(p[3]));
+
+            LLQuad min_dot = _mm_setzero_ps();
+            LLQuad max_dot = _mm_setzero_ps();
+            for (U32 k = 0; k < 3; ++k)
+            {
+                LLQuad pk = _mm_set1_ps(p[k]);
+                LLQuad rscale = _mm_mul_ps(r[k], _mm_set1_ps(scale[k]));
+                LLQuad minp = _mm_mul_ps(_mm_sub_ps(c[k], rscale), pk);
+                LLQuad maxp = _mm_mul_ps(_mm_add_ps(c[k], rscale), pk);
+                min_dot = k ? _mm_add_ps(min_dot, minp) : minp;
+                max_dot = k ? _mm_add_ps(max_dot, maxp) : maxp;
+            }
+
+            outside = _mm_or_ps(outside, _mm_cmpgt_ps(min_dot, d));
+            partial = _mm_or_ps(partial, _mm_cmpgt_ps(max_dot, d));
+        }
+
+        S32 outside_bits = _mm_movemask_ps(outside);
+        S32 partial_bits = _mm_movemask_ps(partial);
+        for (U32 j = 0; j < n; ++j)
+        {
+            results[first + j] = (outside_bits & (1 << j)) ? 0 : ((partial_bits & (1 << j)) ? 1 : 2);
+        }
+    }
+}
+
+void LLCamera::AABBInFrustum(const LLVector4a* centers, const LLVector4a* radii, S32* results, U32 count, const LLPlane* planes)
+{
+    aabbs_in_frustum(planes ? planes : mAgentPlanes, mPlaneMask, llmin(mPlaneCount, (U32) AGENT_PLANE_USER_CLIP_NUM),
+                     AGENT_PLANE_USER_CLIP_NUM, centers, radii, results, count);
+}
+
+void LLCamera::AABBInFrustumNoFarClip(const LLVector4a* centers, const LLVector4a* radii, S32* results, U32 count, const LLPlane* planes)
+{
+    aabbs_in_frustum(planes ? planes : mAgentPlanes, mPlaneMask, llmin(mPlaneCount, (U32) AGENT_PLANE_USER_CLIP_NUM),
+                     AGENT_PLANE_FAR, centers, radii, results, count);
+}
+
 int LLCamera::sphereInFrustumQuick(const LLVector3 &sphere_center, const F32 radius)
 {
     LLVector3 dist = sphere_center-mFrustCenter;
@@ -202,6 +202,11 @@ class LLCamera
     S32 AABBInFrustumNoFarClip(const LLVector4a& center, const LLVector4a& radius, const LLPlane* planes = NULL);
     S32 AABBInRegionFrustumNoFarClip(const LLVector4a& center, const LLVector4a& radius);
 
+    // Batched versions of the above, test count boxes four at a time and
+    // write what the single box versions would return to results.
+    void AABBInFrustum(const LLVector4a* centers, const LLVector4a* radii, S32* results, U32 count, const LLPlane* planes = NULL);
+    void AABBInFrustumNoFarClip(const LLVector4a* centers, const LLVector4a* radii, S32* results, U32 count, const LLPlane* planes = NULL);
+
     //does a quick 'n dirty sphere-sphere check
     S32 sphereInFrustumQuick(const LLVector3 &sphere_center, const F32 radius);
 
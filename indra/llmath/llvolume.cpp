@@ -1965,6 +1965,7 @@ void LLPathParams::copyParams(const LLPathParams &params)
 }
 
 S32 LLVolume::sNumMeshPoints = 0;
+bool LLVolume::sDirectMeshDecode = true;
 
 LLVolume::LLVolume(const LLVolumeParams &params, const F32 detail, const BOOL generate_single_face, const BOOL is_unique)
     : mParams(params)
@@ -2303,40 +2304,576 @@ bool LLVolumeFace::VertexData::compareNormal(const LLVolumeFace::VertexData& rhs
     return retval;
 }
 
+// Where the quantized arrays of one face of a mesh LoD block live, either
+// inside a parsed LLSD tree or straight in the inflated asset buffer.
+struct LLMeshFaceSource
+{
+    struct Blob
+    {
+        const U8* mData = nullptr;
+        size_t mSize = 0;
+
+        void set(const LLSD::Binary& bin) { mData = bin.data(); mSize = bin.size(); }
+        bool empty() const { return mSize == 0; }
+    };
+
+    Blob mPosition;
+    Blob mNormal;
+    Blob mTexCoord0;
+    Blob mTriangleList;
+    Blob mWeights;
+#if 0 // keep this code for now in case we decide to add support for on-the-wire tangents
+    Blob mTangent;
+#endif
+    LLVector3 mPositionMin;
+    LLVector3 mPositionMax;
+    LLVector2 mTexCoordMin;
+    LLVector2 mTexCoordMax;
+    LLVector3 mNormalizedScale;
+    bool mNoGeometry = false;
+    bool mHasNormalizedScale = false;
+    bool mHasWeights = false;
+};
+
+namespace
+{
+    const S32 MESH_LOD_MAX_DEPTH = 96;
+
+    // Widen 4 U16 at a possibly unaligned address to floats
+    inline LLQuad load_u16x4(const U8* src)
+    {
+        __m128i q = _mm_loadl_epi64((const __m128i*) src);
+        return _mm_cvtepi32_ps(_mm_unpacklo_epi16(q, _mm_setzero_si128()));
+    }
+
+    // Same, for the last count (< 4) U16 of a buffer, zero filled
+    inline LLQuad load_u16_tail(const U8* src, U32 count)
+    {
+        U16 v[4] = { 0, 0, 0, 0 };
+        memcpy(v, src, count * sizeof(U16));
+        return load_u16x4((const U8*) v);
+    }
+
+    // The dequantizers below keep the operation order of the LLVector4a
+    // div/mul/add sequence they replace, so results are bit identical.
+    void dequantize_positions(LLVector4a* out, const U8* src, U32 count,
+                              const LLVector4a& min, const LLVector4a& range)
+    {
+        if (!count)
+        {
+            return;
+        }
+        const LLQuad max_u16 = _mm_set1_ps(65535.f);
+        const LLQuad xyz = _mm_castsi128_ps(_mm_set_epi32(0, -1, -1, -1));
+        U32 j = 0;
+        // every vertex but the last can read one U16 ahead and mask it off
+        for (; j < count - 1; ++j, src += 3 * sizeof(U16))
+        {
+            LLQuad v = _mm_and_ps(load_u16x4(src), xyz);
+            v = _mm_div_ps(v, max_u16);
+            v = _mm_mul_ps(v, range);
+            out[j] = _mm_add_ps(v, min);
+        }
+        LLQuad v = load_u16_tail(src, 3);
+        v = _mm_div_ps(v, max_u16);
+        v = _mm_mul_ps(v, range);
+        out[j] = _mm_add_ps(v, min);
+    }
+
+    void dequantize_normals(LLVector4a* out, const U8* src, U32 count)
+    {
+        if (!count)
+        {
+            return;
+        }
+        const LLQuad max_u16 = _mm_set1_ps(65535.f);
+        const LLQuad two = _mm_set1_ps(2.f);
+        const LLQuad one = _mm_set1_ps(1.f);
+        const LLQuad xyz = _mm_castsi128_ps(_mm_set_epi32(0, -1, -1, -1));
+        U32 j = 0;
+        for (; j < count - 1; ++j, src += 3 * sizeof(U16))
+        {
+            LLQuad v = _mm_and_ps(load_u16x4(src), xyz);
+            v = _mm_div_ps(v, max_u16);
+            v = _mm_mul_ps(v, two);
+            out[j] = _mm_sub_ps(v, one);
+        }
+        LLQuad v = load_u16_tail(src, 3);
+        v = _mm_div_ps(v, max_u16);
+        v = _mm_mul_ps(v, two);
+        out[j] = _mm_sub_ps(v, one);
+    }
+
+    // Texture coordinates are packed two vertices per LLVector4a
+    void dequantize_tex_coords(LLVector4a* out, const U8* src, U32 count,
+                               const LLVector4a& min, const LLVector4a& range)
+    {
+        const LLQuad max_u16 = _mm_set1_ps(65535.f);
+        for (U32 j = 0; j < count; j += 2, src += 4 * sizeof(U16))
+        {
+            LLQuad v = (j < count - 1) ? load_u16x4(src) : load_u16_tail(src, 2);
+            v = _mm_div_ps(v, max_u16);
+            v = _mm_mul_ps(v, range);
+            *out++ = _mm_add_ps(v, min);
+        }
+    }
+
+    // Walks a binary LLSD mesh LoD block, an array of face maps, without
+    // building an LLSD tree and notes where each face's arrays live in the
+    // buffer. Anything outside of the layout the uploader produces makes
+    // read() return false so the caller can fall back to the LLSD parser.
+    class LLMeshLODReader
+    {
+    public:
+        LLMeshLODReader(const U8* data, size_t size)
+        :   mCur(data),
+            mEnd(data + size)
+        {
+        }
+
+        bool read(std::vector<LLMeshFaceSource>& faces)
+        {
+            U32 count;
+            if (!expect('[') || !readU32(count) || count > remaining())
+            {
+                return false;
+            }
+            faces.resize(count);
+            for (LLMeshFaceSource& face : faces)
+            {
+                if (!readFace(face))
+                {
+                    return false;
+                }
+            }
+            return expect(']');
+        }
+
+    private:
+        enum
+        {
+            SEEN_POSITION = 1 << 0,
+            SEEN_NORMAL = 1 << 1,
+            SEEN_TEXCOORD0 = 1 << 2,
+            SEEN_TRIANGLE_LIST = 1 << 3,
+            SEEN_WEIGHTS = 1 << 4,
+            SEEN_POSITION_DOMAIN = 1 << 5,
+            SEEN_TEXCOORD0_DOMAIN = 1 << 6,
+            SEEN_NORMALIZED_SCALE = 1 << 7,
+            SEEN_NO_GEOMETRY = 1 << 8
+        };
+
+        size_t remaining() const { return mEnd - mCur; }
+
+        bool expect(char c)
+        {
+            if (mCur >= mEnd || (char) *mCur != c)
+            {
+                return false;
+            }
+            ++mCur;
+            return true;
+        }
+
+        bool readU32(U32& value)
+        {
+            if (remaining() < sizeof(U32))
+            {
+                return false;
+            }
+            // network byte order
+            value = ((U32) mCur[0] << 24) | ((U32) mCur[1] << 16) | ((U32) mCur[2] << 8) | (U32) mCur[3];
+            mCur += sizeof(U32);
+            return true;
+        }
+
+        bool readF64(F64& value)
+        {
+            U32 hi, lo;
+            if (remaining() < sizeof(F64) || !readU32(hi) || !readU32(lo))
+            {
+                return false;
+            }
+            U64 bits = ((U64) hi << 32) | lo;
+            memcpy(&value, &bits, sizeof(F64));
+            return true;
+        }
+
+        bool readSized(const U8*& data, U32& size)
+        {
+            if (!readU32(size) || size > remaining())
+            {
+                return false;
+            }
+            data = mCur;
+            mCur += size;
+            return true;
+        }
+
+        // Sets the bit for a known key, duplicates are left to the LLSD
+        // parser which keeps the first one.
+        bool markSeen(U32& seen, U32 bit)
+        {
+            if (seen & bit)
+            {
+                return false;
+            }
+            seen |= bit;
+            return true;
+        }
+
+        bool readFace(LLMeshFaceSource& face)
+        {
+            U32 count;
+            if (!expect('{') || !readU32(count))
+            {
+                return false;
+            }
+            U32 seen = 0;
+            for (U32 i = 0; i < count; ++i)
+            {
+                const U8* key_data;
+                U32 key_size;
+                if (!expect('k') || !readSized(key_data, key_size))
+                {
+                    return false;
+                }
+                std::string_view key((const char*) key_data, key_size);
+
+                bool ok;
+                if (key == "Position")
+                {
+                    ok = markSeen(seen, SEEN_POSITION) && readBinary(face.mPosition);
+                }
+                else if (key == "Normal")
+                {
+                    ok = markSeen(seen, SEEN_NORMAL) && readBinary(face.mNormal);
+                }
+                else if (key == "TexCoord0")
+                {
+                    ok = markSeen(seen, SEEN_TEXCOORD0) && readBinary(face.mTexCoord0);
+                }
+                else if (key == "TriangleList")
+                {
+                    ok = markSeen(seen, SEEN_TRIANGLE_LIST) && readBinary(face.mTriangleList);
+                }
+                else if (key == "Weights")
+                {
+                    face.mHasWeights = true;
+                    ok = markSeen(seen, SEEN_WEIGHTS) && readBinary(face.mWeights);
+                }
+                else if (key == "PositionDomain")
+                {
+                    ok = markSeen(seen, SEEN_POSITION_DOMAIN)
+                        && readDomain(face.mPositionMin.mV, face.mPositionMax.mV, 3);
+                }
+                else if (key == "TexCoord0Domain")
+                {
+                    ok = markSeen(seen, SEEN_TEXCOORD0_DOMAIN)
+                        && readDomain(face.mTexCoordMin.mV, face.mTexCoordMax.mV, 2);
+                }
+                else if (key == "NormalizedScale")
+                {
+                    face.mHasNormalizedScale = true;
+                    ok = markSeen(seen, SEEN_NORMALIZED_SCALE)
+                        && readReals(face.mNormalizedScale.mV, 3);
+                }
+                else if (key == "NoGeometry")
+                {
+                    face.mNoGeometry = true;
+                    ok = markSeen(seen, SEEN_NO_GEOMETRY) && skipValue(0);
+                }
+                else
+                {
+                    ok = skipValue(0);
+                }
+                if (!ok)
+                {
+                    return false;
+                }
+            }
+            return expect('}');
+        }
+
+        bool readBinary(LLMeshFaceSource::Blob& blob)
+        {
+            const U8* data;
+            U32 size;
+            if (!expect('b') || !readSized(data, size))
+            {
+                return false;
+            }
+            blob.mData = data;
+            blob.mSize = size;
+            return true;
+        }
+
+        // Reads an array of numbers into out[0..n), like LLVector3::setValue()
+        bool readReals(F32* out, S32 n)
+        {
+            U32 count;
+            if (!expect('[') || !readU32(count))
+            {
+                return false;
+            }
+            for (U32 i = 0; i < count; ++i)
+            {
+                F64 value;
+                if (expect('r'))
+                {
+                    if (!readF64(value))
+                    {
+                        return false;
+                    }
+                }
+                else if (expect('i'))
+                {
+                    U32 int_value;
+                    if (!readU32(int_value))
+                    {
+                        return false;
+                    }
+                    value = (S32) int_value;
+                }
+                else
+                {
+                    return false;
+                }
+                if ((S32) i < n)
+                {
+                    out[i] = (F32) value;
+                }
+            }
+            return expect(']');
+        }
+
+        bool readDomain(F32* min, F32* max, S32 n)
+        {
+            U32 count;
+            if (!expect('{') || !readU32(count))
+            {
+                return false;
+            }
+            U32 seen = 0;
+            for (U32 i = 0; i < count; ++i)
+            {
+                const U8* key_data;
+                U32 key_size;
+                if (!expect('k') || !readSized(key_data, key_size))
+                {
+                    return false;
+                }
+                std::string_view key((const char*) key_data, key_size);
+                bool ok;
+                if (key == "Min")
+                {
+                    ok = markSeen(seen, 1) && readReals(min, n);
+                }
+                else if (key == "Max")
+                {
+                    ok = markSeen(seen, 2) && readReals(max, n);
+                }
+                else
+                {
+                    ok = skipValue(0);
+                }
+                if (!ok)
+                {
+                    return false;
+                }
+            }
+            return expect('}');
+        }
+
+        bool skip(size_t bytes)
+        {
+            if (remaining() < bytes)
+            {
+                return false;
+            }
+            mCur += bytes;
+            return true;
+        }
+
+        bool skipValue(S32 depth)
+        {
+            if (mCur >= mEnd || depth > MESH_LOD_MAX_DEPTH)
+            {
+                return false;
+            }
+            const U8* data;
+            U32 size;
+            switch ((char) *mCur++)
+            {
+            case '!':
+            case '0':
+            case '1':
+                return true;
+            case 'i':
+                return skip(sizeof(U32));
+            case 'r':
+            case 'd':
+                return skip(sizeof(F64));
+            case 'u':
+                return skip(UUID_BYTES);
+            case 's':
+            case 'l':
+            case 'b':
+                return readSized(data, size);
+            case '[':
+                if (!readU32(size))
+                {
+                    return false;
+                }
+                for (U32 i = 0; i < size; ++i)
+                {
+                    if (!skipValue(depth + 1))
+                    {
+                        return false;
+                    }
+                }
+                return expect(']');
+            case '{':
+                if (!readU32(size))
+                {
+                    return false;
+                }
+                for (U32 i = 0, key_size; i < size; ++i)
+                {
+                    if (!expect('k') || !readSized(data, key_size) || !skipValue(depth + 1))
+                    {
+                        return false;
+                    }
+                }
+                return expect('}');
+            default:
+                // delimited strings and anything exotic
+                return false;
+            }
+        }
+
+        const U8* mCur;
+        const U8* const mEnd;
+    };
+
+    bool read_mesh_lod(const U8* data, size_t size, std::vector<LLMeshFaceSource>& faces)
+    {
+        LL_PROFILE_ZONE_SCOPED_CATEGORY_VOLUME
+        LLMeshLODReader reader(data, size);
+        return reader.read(faces);
+    }
+}
+
 bool LLVolume::unpackVolumeFaces(std::istream& is, S32 size)
 {
     LL_PROFILE_ZONE_SCOPED_CATEGORY_VOLUME
 
     //input stream is now pointing at a zlib compressed block of LLSD
     //decompress block
-    LLSD mdl;
-    U32 uzip_result = LLUZipHelper::unzip_llsd(mdl, is, size);
-    if (uzip_result != LLUZipHelper::ZR_OK)
+    std::unique_ptr<U8[]> in = std::unique_ptr<U8[]>(new(std::nothrow) U8[size]);
+    if (!in)
     {
-        LL_DEBUGS("MeshStreaming") << "Failed to unzip LLSD blob for LoD with code " << uzip_result << " , will probably fetch from sim again." << LL_ENDL;
+        LL_WARNS() << "Failed to allocate " << size << " bytes for LoD block" << LL_ENDL;
         return false;
     }
-    return unpackVolumeFacesInternal(mdl);
+    is.read((char*) in.get(), size);
+    if (is.gcount() != size)
+    {
+        LL_DEBUGS("MeshStreaming") << "Short read of LoD block, got " << is.gcount() << " of " << size
+                                   << " bytes, will probably fetch from sim again." << LL_ENDL;
+        return false;
+    }
+
+    return unpackVolumeFaces(in.get(), size);
 }
 
 bool LLVolume::unpackVolumeFaces(U8* in_data, S32 size)
 {
+    LL_PROFILE_ZONE_SCOPED_CATEGORY_VOLUME
+
     //input data is now pointing at a zlib compressed block of LLSD
-    //decompress block
-    LLSD mdl;
-    U32 uzip_result = LLUZipHelper::unzip_llsd(mdl, in_data, size);
+    //decompress block, reusing the buffer between LoDs decoded on this thread
+    static thread_local std::vector<U8> inflated;
+    U32 uzip_result = LLUZipHelper::unzip_buffer(inflated, in_data, size);
     if (uzip_result != LLUZipHelper::ZR_OK)
     {
         LL_DEBUGS("MeshStreaming") << "Failed to unzip LLSD blob for LoD with code " << uzip_result << " , will probably fetch from sim again." << LL_ENDL;
         return false;
     }
+
+    llssize data_size = inflated.size();
+    const U8* data = (const U8*) strip_deprecated_header((char*) inflated.data(), data_size);
+
+    if (sDirectMeshDecode)
+    {
+        std::vector<LLMeshFaceSource> faces;
+        if (read_mesh_lod(data, data_size, faces))
+        {
+            return unpackVolumeFacesInternal(faces);
+        }
+        LL_DEBUGS("MeshStreaming") << "Unexpected LoD block layout, falling back to LLSD" << LL_ENDL;
+    }
+
+    // the LoD block is unpacked into the volume and then dropped, so
+    // keep its thousands of nodes off the general heap
+    llsd::DocumentArena arena;
+    LLSD mdl;
+    if (LLSDSerialize::fromBinary(mdl, data, data_size, MESH_LOD_MAX_DEPTH) <= 0)
+    {
+        LL_DEBUGS("MeshStreaming") << "Failed to parse LLSD blob for LoD, will probably fetch from sim again." << LL_ENDL;
+        return false;
+    }
     return unpackVolumeFacesInternal(mdl);
 }
 
 bool LLVolume::unpackVolumeFacesInternal(const LLSD& mdl)
 {
+    std::vector<LLMeshFaceSource> faces(mdl.size());
+
+    for (size_t i = 0; i < faces.size(); ++i)
     {
-        U32 face_count = mdl.size();
+        LLMeshFaceSource& src = faces[i];
+        const LLSD& mdl_face = mdl[i];
+
+        if (mdl_face.has("NoGeometry"))
+        {
+            src.mNoGeometry = true;
+            continue;
+        }
+
+        src.mPosition.set(mdl_face["Position"].asBinary());
+        src.mNormal.set(mdl_face["Normal"].asBinary());
+        src.mTexCoord0.set(mdl_face["TexCoord0"].asBinary());
+        src.mTriangleList.set(mdl_face["TriangleList"].asBinary());
+#if 0 // keep this code for now in case we decide to add support for on-the-wire tangents
+        src.mTangent.set(mdl_face["Tangent"].asBinary());
+#endif
+
+        src.mPositionMin.setValue(mdl_face["PositionDomain"]["Min"]);
+        src.mPositionMax.setValue(mdl_face["PositionDomain"]["Max"]);
+        src.mTexCoordMin.setValue(mdl_face["TexCoord0Domain"]["Min"]);
+        src.mTexCoordMax.setValue(mdl_face["TexCoord0Domain"]["Max"]);
+
+        if (mdl_face.has("NormalizedScale"))
+        {
+            src.mHasNormalizedScale = true;
+            src.mNormalizedScale.setValue(mdl_face["NormalizedScale"]);
+        }
+
+        if (mdl_face.has("Weights"))
+        {
+            src.mHasWeights = true;
+            src.mWeights.set(mdl_face["Weights"].asBinary());
+        }
+    }
+
+    return unpackVolumeFacesInternal(faces);
+}
+
+bool LLVolume::unpackVolumeFacesInternal(const std::vector<LLMeshFaceSource>& faces)
+{
+    {
+        U32 face_count = (U32)faces.size();
 
         if (face_count == 0)
         { //no faces unpacked, treat as failed decode
@@ -2350,9 +2887,9 @@ bool LLVolume::unpackVolumeFacesInternal(const LLSD& mdl)
         {
             LLVolumeFace& face = mVolumeFaces[i];
 
-            const auto& mdl_face = mdl[i];
+            const LLMeshFaceSource& src = faces[i];
 
-            if (mdl_face.has("NoGeometry"))
+            if (src.mNoGeometry)
             { //face has no geometry, continue
                 face.resizeIndices(3);
                 face.resizeVertices(1);
@@ -2363,16 +2900,13 @@ bool LLVolume::unpackVolumeFacesInternal(const LLSD& mdl)
                 continue;
             }
 
-            const LLSD::Binary& pos = mdl_face["Position"].asBinary();
-            const LLSD::Binary& norm = mdl_face["Normal"].asBinary();
-#if 0 // keep this code for now in case we decide to add support for on-the-wire tangents
-            const LLSD::Binary& tangent = mdl_face["Tangent"].asBinary();
-#endif
-            const LLSD::Binary& tc = mdl_face["TexCoord0"].asBinary();
-            const LLSD::Binary& idx = mdl_face["TriangleList"].asBinary();
+            const LLMeshFaceSource::Blob& pos = src.mPosition;
+            const LLMeshFaceSource::Blob& norm = src.mNormal;
+            const LLMeshFaceSource::Blob& tc = src.mTexCoord0;
+            const LLMeshFaceSource::Blob& idx = src.mTriangleList;
 
             //copy out indices
-            S32 num_indices = idx.size() / 2;
+            S32 num_indices = (S32)(idx.mSize / 2);
             const S32 indices_to_discard = num_indices % 3;
             if (indices_to_discard > 0)
             {
@@ -2394,14 +2928,11 @@ bool LLVolume::unpackVolumeFacesInternal(const LLSD& mdl)
                 continue;
             }
 
-            U16* indices = (U16*) &(idx[0]);
-            for (U32 j = 0; j < num_indices; ++j)
-            {
-                face.mIndices[j] = indices[j];
-            }
+            // the source may be unaligned
+            memcpy(face.mIndices, idx.mData, num_indices * sizeof(U16));
 
             //copy out vertices
-            U32 num_verts = pos.size()/(3*2);
+            U32 num_verts = (U32)(pos.mSize / (3*2));
             face.resizeVertices(num_verts);
 
             if (num_verts > 0 && !face.mPositions)
@@ -2411,24 +2942,17 @@ bool LLVolume::unpackVolumeFacesInternal(const LLSD& mdl)
                 continue;
             }
 
-            LLVector3 minp;
-            LLVector3 maxp;
-            LLVector2 min_tc;
-            LLVector2 max_tc;
-
-            minp.setValue(mdl_face["PositionDomain"]["Min"]);
-            maxp.setValue(mdl_face["PositionDomain"]["Max"]);
             LLVector4a min_pos, max_pos;
-            min_pos.load3(minp.mV);
-            max_pos.load3(maxp.mV);
+            min_pos.load3(src.mPositionMin.mV);
+            max_pos.load3(src.mPositionMax.mV);
 
-            min_tc.setValue(mdl_face["TexCoord0Domain"]["Min"]);
-            max_tc.setValue(mdl_face["TexCoord0Domain"]["Max"]);
+            const LLVector2& min_tc = src.mTexCoordMin;
+            const LLVector2& max_tc = src.mTexCoordMax;
 
             //unpack normalized scale/translation
-            if (mdl_face.has("NormalizedScale"))
+            if (src.mHasNormalizedScale)
             {
-                face.mNormalizedScale.setValue(mdl_face["NormalizedScale"]);
+                face.mNormalizedScale = src.mNormalizedScale;
             }
             else
             {
@@ -2447,50 +2971,32 @@ bool LLVolume::unpackVolumeFacesInternal(const LLSD& mdl)
             LLVector4a* norm_out = face.mNormals;
             LLVector4a* tc_out = (LLVector4a*) face.mTexCoords;
 
-            {
-                U16* v = (U16*) &(pos[0]);
-                for (U32 j = 0; j < num_verts; ++j)
-                {
-                    pos_out->set((F32) v[0], (F32) v[1], (F32) v[2]);
-                    pos_out->div(65535.f);
-                    pos_out->mul(pos_range);
-                    pos_out->add(min_pos);
-                    pos_out++;
-                    v += 3;
-                }
+            dequantize_positions(pos_out, pos.mData, num_verts, min_pos, pos_range);
 
+            if (!norm.empty() && norm.mSize >= num_verts * 3 * sizeof(U16))
+            {
+                dequantize_normals(norm_out, norm.mData, num_verts);
             }
-
+            else
             {
                 if (!norm.empty())
                 {
-                    U16* n = (U16*) &(norm[0]);
-                    for (U32 j = 0; j < num_verts; ++j)
-                    {
-                        norm_out->set((F32) n[0], (F32) n[1], (F32) n[2]);
-                        norm_out->div(65535.f);
-                        norm_out->mul(2.f);
-                        norm_out->sub(1.f);
-                        norm_out++;
-                        n += 3;
-                    }
+                    LL_WARNS() << "Truncated normals ignored for face index: " << i << " Total: " << face_count << LL_ENDL;
                 }
-                else
+                for (U32 j = 0; j < num_verts; ++j)
                 {
-                    for (U32 j = 0; j < num_verts; ++j)
-                    {
-                        norm_out->clear();
-                        norm_out++; // or just norm_out[j].clear();
-                    }
+                    norm_out->clear();
+                    norm_out++; // or just norm_out[j].clear();
                 }
             }
 
 #if 0 // keep this code for now in case we decide to add support for on-the-wire tangents
             {
+                const LLMeshFaceSource::Blob& tangent = src.mTangent;
                 if (!tangent.empty())
                 {
                     face.allocateTangents(face.mNumVertices);
-                    U16* t = (U16*)&(tangent[0]);
+                    U16* t = (U16*)tangent.mData;
 
                     // NOTE: tangents coming from the asset may not be mikkt space, but they should always be used by the GLTF shaders to
                     // maintain compliance with the GLTF spec
@@ -2513,41 +3019,24 @@ bool LLVolume::unpackVolumeFacesInternal(const LLSD& mdl)
             }
 #endif
 
+            if (!tc.empty() && tc.mSize >= num_verts * 2 * sizeof(U16))
+            {
+                dequantize_tex_coords(tc_out, tc.mData, num_verts, min_tc4, tc_range);
+            }
+            else
             {
                 if (!tc.empty())
                 {
-                    U16* t = (U16*) &(tc[0]);
-                    for (U32 j = 0; j < num_verts; j+=2)
-                    {
-                        if (j < num_verts-1)
-                        {
-                            tc_out->set((F32) t[0], (F32) t[1], (F32) t[2], (F32) t[3]);
-                        }
-                        else
-                        {
-                            tc_out->set((F32) t[0], (F32) t[1], 0.f, 0.f);
-                        }
-
-                        t += 4;
-
-                        tc_out->div(65535.f);
-                        tc_out->mul(tc_range);
-                        tc_out->add(min_tc4);
-
-                        tc_out++;
-                    }
+                    LL_WARNS() << "Truncated texture coordinates ignored for face index: " << i << " Total: " << face_count << LL_ENDL;
                 }
-                else
+                for (U32 j = 0; j < num_verts; j += 2)
                 {
-                    for (U32 j = 0; j < num_verts; j += 2)
-                    {
-                        tc_out->clear();
-                        tc_out++;
-                    }
+                    tc_out->clear();
+                    tc_out++;
                 }
             }
 
-            if (mdl_face.has("Weights"))
+            if (src.mHasWeights)
             {
                 face.allocateWeights(num_verts);
                 if (!face.mWeights && num_verts)
@@ -2558,12 +3047,12 @@ bool LLVolume::unpackVolumeFacesInternal(const LLSD& mdl)
                     continue;
                 }
 
-                const LLSD::Binary& weights = mdl_face["Weights"].asBinary();
+                const U8* weights = src.mWeights.mData;
 
                 U32 idx = 0;
 
                 U32 cur_vertex = 0;
-                size_t weight_size = weights.size();
+                size_t weight_size = src.mWeights.mSize;
                 while (idx < weight_size && cur_vertex < num_verts)
                 {
                     const U8 END_INFLUENCES = 0xFF;
@@ -2574,7 +3063,7 @@ bool LLVolume::unpackVolumeFacesInternal(const LLSD& mdl)
                     U32 joints[4] = {0,0,0,0};
                     LLVector4 joints_with_weights(0,0,0,0);
 
-                    while (joint != END_INFLUENCES && idx < weight_size)
+                    while (joint != END_INFLUENCES && idx + 1 < weight_size)
                     {
                         U16 influence = weights[idx++];
                         influence |= ((U16) weights[idx++] << 8);
@@ -2584,7 +3073,7 @@ bool LLVolume::unpackVolumeFacesInternal(const LLSD& mdl)
                         joints[cur_influence] = joint;
                         cur_influence++;
 
-                        if (cur_influence >= 4)
+                        if (cur_influence >= 4 || idx >= weight_size)
                         {
                             joint = END_INFLUENCES;
                         }
@@ -2611,7 +3100,7 @@ bool LLVolume::unpackVolumeFacesInternal(const LLSD& mdl)
                     cur_vertex++;
                 }
 
-                if (cur_vertex != num_verts || idx != weights.size())
+                if (cur_vertex != num_verts || idx != weight_size)
                 {
                     LL_WARNS() << "Vertex weight count does not match vertex count!" << LL_ENDL;
                 }
@@ -40,6 +40,7 @@ template <class T, typename T_PTR> class LLOctreeNode;
 
 class LLVolumeFace;
 class LLVolume;
+struct LLMeshFaceSource;
 class LLVolumeTriangle;
 class LLVolumeOctree;
 
@@ -1070,6 +1071,9 @@ class LLVolume : public LLRefCount
 
     BOOL isFaceMaskValid(LLFaceID face_mask);
     static S32 sNumMeshPoints;
+    // Decode mesh LoD blocks straight out of the inflated asset instead of
+    // going through an LLSD tree. Unexpected layouts always fall back.
+    static bool sDirectMeshDecode;
 
     friend std::ostream& operator<<(std::ostream &s, const LLVolume &volume);
     friend std::ostream& operator<<(std::ostream &s, const LLVolume *volumep);      // HACK to bypass Windoze confusion over
@@ -1108,6 +1112,7 @@ class LLVolume : public LLRefCount
     bool unpackVolumeFaces(U8* in_data, S32 size);
 private:
     bool unpackVolumeFacesInternal(const LLSD& mdl);
+    bool unpackVolumeFacesInternal(const std::vector<LLMeshFaceSource>& faces);
 
 public:
     virtual void setMeshAssetLoaded(bool loaded);
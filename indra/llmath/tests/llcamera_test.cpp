@@ -0,0 +1,180 @@
+/**
+ * @file llcamera_test.cpp
+ * @brief Tests for the LLCamera frustum tests
+ *
+ * $LicenseInfo:firstyear=2024&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2024, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#include "linden_common.h"
+#include "../test/lltut.h"
+
+#include <vector>
+
+#include "llformat.h"
+#include "llrand.h"
+
+#include "../llmath.h"
+#include "../llcamera.h"
+
+namespace
+{
+    // perspective frustum looking down +x from origin, corners laid out
+    // like LLViewerCamera::calcProjection() does
+    void set_frustum(LLCamera& camera, const LLVector3& origin, F32 near_dist, F32 far_dist)
+    {
+        camera.setOrigin(origin);
+
+        const LLVector3 at(1.f, 0.f, 0.f);
+        const LLVector3 left(0.f, 1.f, 0.f);
+        const LLVector3 up(0.f, 0.f, 1.f);
+        const F32 w = near_dist * 0.75f;
+        const F32 h = near_dist * 0.5f;
+
+        LLVector3 frust[LLCamera::AGENT_FRUSTRUM_NUM];
+        frust[0] = origin + at * near_dist + left * w - up * h;
+        frust[1] = origin + at * near_dist - left * w - up * h;
+        frust[2] = origin + at * near_dist - left * w + up * h;
+        frust[3] = origin + at * near_dist + left * w + up * h;
+        for (U32 i = 0; i < 4; i++)
+        {
+            LLVector3 vec = frust[i] - origin;
+            vec.normVec();
+            frust[i + 4] = origin + vec * far_dist;
+        }
+        camera.calcAgentFrustumPlanes(frust);
+    }
+
+    void random_boxes(const LLVector3& origin, LLVector4a* centers, LLVector4a* radii, U32 count)
+    {
+        for (U32 i = 0; i < count; i++)
+        {
+            centers[i].set(origin.mV[VX] + ll_frand(120.f) - 20.f,
+                           origin.mV[VY] + ll_frand(160.f) - 80.f,
+                           origin.mV[VZ] + ll_frand(160.f) - 80.f);
+            radii[i].set(ll_frand(20.f), ll_frand(20.f), ll_frand(20.f));
+        }
+    }
+}
+
+namespace tut
+{
+    struct camera_data
+    {
+        // the batched tests must agree with the single box tests box by box
+        void check_batch(LLCamera& camera, const LLVector4a* centers, const LLVector4a* radii, U32 count)
+        {
+            std::vector<S32> results(count, -1);
+            camera.AABBInFrustum(centers, radii, results.data(), count);
+            for (U32 i = 0; i < count; i++)
+            {
+                ensure_equals(llformat("AABBInFrustum %u of %u", i, count), results[i], camera.AABBInFrustum(centers[i], radii[i]));
+            }
+
+            results.assign(count, -1);
+            camera.AABBInFrustumNoFarClip(centers, radii, results.data(), count);
+            for (U32 i = 0; i < count; i++)
+            {
+                ensure_equals(llformat("AABBInFrustumNoFarClip %u of %u", i, count), results[i], camera.AABBInFrustumNoFarClip(centers[i], radii[i]));
+            }
+        }
+    };
+    typedef test_group<camera_data> camera_test;
+    typedef camera_test::object camera_object;
+    tut::camera_test tcam("LLCamera");
+
+    template<> template<>
+    void camera_object::test<1>()
+    {
+        set_test_name("single box");
+
+        LLCamera camera;
+        LLVector3 origin(128.f, 64.f, 20.f);
+        set_frustum(camera, origin, 1.f, 100.f);
+
+        LLVector4a radius(1.f, 1.f, 1.f);
+        LLVector4a center;
+        center.load3((origin + LLVector3(50.f, 0.f, 0.f)).mV);
+        ensure_equals("inside", camera.AABBInFrustum(center, radius), 2);
+
+        center.load3((origin + LLVector3(-50.f, 0.f, 0.f)).mV);
+        ensure_equals("behind", camera.AABBInFrustum(center, radius), 0);
+
+        // the corners are 100m out, the middle of the far plane a lot less
+        center.load3((origin + LLVector3(74.f, 0.f, 0.f)).mV);
+        ensure_equals("far plane", camera.AABBInFrustum(center, radius), 1);
+        ensure_equals("far plane ignored", camera.AABBInFrustumNoFarClip(center, radius), 2);
+
+        center.load3((origin + LLVector3(200.f, 0.f, 0.f)).mV);
+        ensure_equals("beyond far plane", camera.AABBInFrustum(center, radius), 0);
+    }
+
+    template<> template<>
+    void camera_object::test<2>()
+    {
+        set_test_name("batched boxes");
+
+        LLCamera camera;
+        LLVector3 origin(128.f, 64.f, 20.f);
+        set_frustum(camera, origin, 1.f, 100.f);
+
+        const U32 COUNT = 1003;
+        std::vector<LLVector4a> centers(COUNT);
+        std::vector<LLVector4a> radii(COUNT);
+        random_boxes(origin, centers.data(), radii.data(), COUNT);
+
+        // every remainder of the four wide blocks
+        for (U32 count = 0; count <= 9; count++)
+        {
+            check_batch(camera, centers.data(), radii.data(), count);
+        }
+        check_batch(camera, centers.data(), radii.data(), COUNT);
+
+        S32 seen[3] = { 0, 0, 0 };
+        for (U32 i = 0; i < COUNT; i++)
+        {
+            seen[camera.AABBInFrustum(centers[i], radii[i])]++;
+        }
+        ensure("boxes outside", seen[0] > 0);
+        ensure("boxes crossing", seen[1] > 0);
+        ensure("boxes inside", seen[2] > 0);
+
+        // user clip plane cutting through the frustum
+        LLPlane water;
+        water.setVec(LLVector3(0.f, 0.f, origin.mV[VZ] - 10.f), LLVector3(0.f, 0.f, -1.f));
+        camera.setUserClipPlane(water);
+        check_batch(camera, centers.data(), radii.data(), COUNT);
+        camera.disableUserClipPlane();
+
+        // planes passed in
+        LLPlane planes[LLCamera::AGENT_PLANE_USER_CLIP_NUM];
+        for (U32 i = 0; i < LLCamera::AGENT_PLANE_USER_CLIP_NUM; i++)
+        {
+            planes[i] = camera.getAgentPlane(i);
+        }
+        std::vector<S32> results(COUNT);
+        camera.AABBInFrustum(centers.data(), radii.data(), results.data(), COUNT, planes);
+        for (U32 i = 0; i < COUNT; i++)
+        {
+            ensure_equals("planes", results[i], camera.AABBInFrustum(centers[i], radii[i], planes));
+        }
+    }
+}
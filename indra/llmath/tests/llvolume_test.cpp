@@ -0,0 +1,297 @@
+/**
+ * @file llvolume_test.cpp
+ * @brief Tests and decode benchmark for mesh LoD unpacking
+ *
+ * $LicenseInfo:firstyear=2024&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2024, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#include "linden_common.h"
+#include "../test/lltut.h"
+
+#include "../llmath.h"
+#include "../llvolume.h"
+#include "../v2math.h"
+#include "../v3math.h"
+#include "llfile.h"
+#include "llrand.h"
+#include "llsdserialize.h"
+#include "lltimer.h"
+
+#include <filesystem>
+
+namespace
+{
+    void put_u16(LLSD::Binary& bin, U16 value)
+    {
+        // the asset stores quantized arrays in host order
+        const U8* bytes = (const U8*) &value;
+        bin.insert(bin.end(), bytes, bytes + sizeof(U16));
+    }
+
+    LLSD make_face(S32 num_verts, S32 num_tris, bool rigged)
+    {
+        LLSD::Binary pos, norm, tc, idx, weights;
+        for (S32 i = 0; i < num_verts; ++i)
+        {
+            for (S32 k = 0; k < 3; ++k)
+            {
+                put_u16(pos, (U16) ll_rand(65536));
+                put_u16(norm, (U16) ll_rand(65536));
+            }
+            put_u16(tc, (U16) ll_rand(65536));
+            put_u16(tc, (U16) ll_rand(65536));
+
+            if (rigged)
+            {
+                S32 influences = 1 + ll_rand(4);
+                for (S32 k = 0; k < influences; ++k)
+                {
+                    weights.push_back((U8) ll_rand(100));
+                    put_u16(weights, (U16) ll_rand(65536));
+                }
+                if (influences < 4)
+                {
+                    weights.push_back(0xFF);
+                }
+            }
+        }
+        for (S32 i = 0; i < num_tris * 3; ++i)
+        {
+            put_u16(idx, (U16) ll_rand(num_verts));
+        }
+
+        LLSD face;
+        face["Position"] = pos;
+        face["Normal"] = norm;
+        face["TexCoord0"] = tc;
+        face["TriangleList"] = idx;
+        face["PositionDomain"]["Min"] = LLVector3(-0.5f, -1.f, -2.f).getValue();
+        face["PositionDomain"]["Max"] = LLVector3(0.5f, 1.f, 2.f).getValue();
+        face["TexCoord0Domain"]["Min"] = LLVector2(0.f, -1.f).getValue();
+        face["TexCoord0Domain"]["Max"] = LLVector2(1.f, 3.f).getValue();
+        face["NormalizedScale"] = LLVector3(1.f, 2.f, 4.f).getValue();
+        if (rigged)
+        {
+            face["Weights"] = weights;
+        }
+        return face;
+    }
+
+    LLPointer<LLVolume> decode(const std::string& block, bool direct, bool& success)
+    {
+        LLVolume::sDirectMeshDecode = direct;
+
+        LLVolumeParams params;
+        params.setSculptID(LLUUID::null, LL_SCULPT_TYPE_MESH);
+        LLPointer<LLVolume> volume = new LLVolume(params, 1.f);
+        success = volume->unpackVolumeFaces((U8*) block.data(), (S32) block.size());
+        LLVolume::sDirectMeshDecode = true;
+        return volume;
+    }
+
+    template <typename T>
+    void ensure_same_array(const std::string& msg, const T* a, const T* b, size_t count)
+    {
+        tut::ensure_equals(msg + " presence", a != nullptr, b != nullptr);
+        if (a && b)
+        {
+            tut::ensure(msg, memcmp(a, b, count * sizeof(T)) == 0);
+        }
+    }
+
+    void ensure_same_volume(const std::string& msg, const LLVolume* a, const LLVolume* b)
+    {
+        tut::ensure_equals(msg + " face count", a->getNumVolumeFaces(), b->getNumVolumeFaces());
+        for (S32 i = 0; i < a->getNumVolumeFaces(); ++i)
+        {
+            const LLVolumeFace& fa = a->getVolumeFace(i);
+            const LLVolumeFace& fb = b->getVolumeFace(i);
+            std::string face_msg = llformat("%s face %d", msg.c_str(), i);
+            tut::ensure_equals(face_msg + " vertices", fa.mNumVertices, fb.mNumVertices);
+            tut::ensure_equals(face_msg + " indices", fa.mNumIndices, fb.mNumIndices);
+            ensure_same_array(face_msg + " positions", fa.mPositions, fb.mPositions, fa.mNumVertices);
+            ensure_same_array(face_msg + " normals", fa.mNormals, fb.mNormals, fa.mNumVertices);
+            ensure_same_array(face_msg + " tangents", fa.mTangents, fb.mTangents, fa.mNumVertices);
+            ensure_same_array(face_msg + " texcoords", fa.mTexCoords, fb.mTexCoords, fa.mNumVertices);
+            ensure_same_array(face_msg + " weights", fa.mWeights, fb.mWeights, fa.mNumVertices);
+            ensure_same_array(face_msg + " indices", fa.mIndices, fb.mIndices, fa.mNumIndices);
+            ensure_same_array(face_msg + " extents", fa.mExtents, fb.mExtents, 2);
+            tut::ensure_equals(face_msg + " normalized scale", fa.mNormalizedScale, fb.mNormalizedScale);
+        }
+    }
+
+    // Mesh assets as fetched from the mesh CDN: a binary LLSD header
+    // followed by the LoD blocks it points at.
+    void load_corpus(const std::string& dir, std::vector<std::string>& blocks)
+    {
+        static const char* lod_names[] = { "lowest_lod", "low_lod", "medium_lod", "high_lod" };
+        for (const auto& entry : std::filesystem::directory_iterator(dir))
+        {
+            if (!entry.is_regular_file())
+            {
+                continue;
+            }
+            llifstream file(entry.path().string().c_str(), std::ios::binary);
+            std::string asset((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+
+            LLSD header;
+            size_t header_size = 0;
+            if (LLSDSerialize::fromBinary(header, (const U8*) asset.data(), asset.size(), -1, &header_size) <= 0)
+            {
+                continue;
+            }
+            for (const char* lod : lod_names)
+            {
+                size_t offset = header_size + header[lod]["offset"].asInteger();
+                size_t size = header[lod]["size"].asInteger();
+                if (size > 0 && offset + size <= asset.size())
+                {
+                    blocks.push_back(asset.substr(offset, size));
+                }
+            }
+        }
+    }
+}
+
+namespace tut
+{
+    struct volume_data
+    {
+    };
+    typedef test_group<volume_data> volume_test;
+    typedef volume_test::object volume_object;
+    tut::volume_test tv("LLVolume");
+
+    template<> template<>
+    void volume_object::test<1>()
+    {
+        set_test_name("direct LoD decode matches LLSD decode");
+
+        LLSD mdl;
+        mdl.append(make_face(100, 150, false));
+        mdl.append(make_face(33, 40, true));  // odd vertex count
+        mdl.append(make_face(1, 1, true));
+        LLSD no_geometry;
+        no_geometry["NoGeometry"] = true;
+        mdl.append(no_geometry);
+        LLSD extra = make_face(64, 64, false);
+        extra["Tangent"] = extra["Normal"];
+        extra["Comment"]["nested"].append("ignored");
+        mdl.append(extra);
+
+        std::string block = zip_llsd(mdl);
+
+        bool direct_ok = false, llsd_ok = false;
+        LLPointer<LLVolume> direct = decode(block, true, direct_ok);
+        LLPointer<LLVolume> llsd = decode(block, false, llsd_ok);
+        ensure("direct decode", direct_ok);
+        ensure("llsd decode", llsd_ok);
+        ensure_same_volume("decoders", direct, llsd);
+    }
+
+    template<> template<>
+    void volume_object::test<2>()
+    {
+        set_test_name("unexpected layouts fall back");
+
+        LLSD mdl;
+        mdl.append(make_face(10, 10, false));
+        LLSD odd = make_face(10, 10, false);
+        odd["PositionDomain"]["Min"] = "-0.5";  // not an array of reals
+        mdl.append(odd);
+
+        std::string block = zip_llsd(mdl);
+        bool direct_ok = false, llsd_ok = false;
+        LLPointer<LLVolume> direct = decode(block, true, direct_ok);
+        LLPointer<LLVolume> llsd = decode(block, false, llsd_ok);
+        ensure("direct decode", direct_ok);
+        ensure("llsd decode", llsd_ok);
+        ensure_same_volume("fallback", direct, llsd);
+
+        std::string truncated = block.substr(0, block.size() / 2);
+        decode(truncated, true, direct_ok);
+        ensure("truncated block rejected", !direct_ok);
+    }
+
+    template<> template<>
+    void volume_object::test<3>()
+    {
+        set_test_name("LoD decode benchmark");
+
+        if (LLStringUtil::getenv("LL_BENCHMARK").empty())
+        {
+            skip("set LL_BENCHMARK to run");
+        }
+
+        // Point LL_MESH_CORPUS at a directory of captured mesh assets,
+        // otherwise a synthetic corpus of similar proportions is used.
+        std::vector<std::string> blocks;
+        std::string corpus = LLStringUtil::getenv("LL_MESH_CORPUS");
+        if (!corpus.empty())
+        {
+            load_corpus(corpus, blocks);
+        }
+        if (blocks.empty())
+        {
+            corpus = "synthetic";
+            for (S32 i = 0; i < 200; ++i)
+            {
+                LLSD mdl;
+                S32 faces = 1 + ll_rand(8);
+                for (S32 f = 0; f < faces; ++f)
+                {
+                    S32 verts = 16 + ll_rand(4000);
+                    mdl.append(make_face(verts, verts, (i & 1) != 0));
+                }
+                blocks.push_back(zip_llsd(mdl));
+            }
+        }
+
+        size_t total_bytes = 0;
+        for (const std::string& block : blocks)
+        {
+            total_bytes += block.size();
+        }
+
+        const S32 ITERATIONS = 5;
+        F64 secs[2];
+        for (S32 direct = 0; direct < 2; ++direct)
+        {
+            LLTimer timer;
+            for (S32 i = 0; i < ITERATIONS; ++i)
+            {
+                for (const std::string& block : blocks)
+                {
+                    bool success;
+                    decode(block, direct != 0, success);
+                }
+            }
+            secs[direct] = timer.getElapsedTimeF64();
+        }
+
+        F64 lods = (F64) blocks.size() * ITERATIONS;
+        LL_INFOS() << blocks.size() << " LoD blocks (" << total_bytes << " bytes, " << corpus << "): "
+                   << "LLSD " << lods / llmax(secs[0], 1e-6) << " LoD/s, "
+                   << "direct " << lods / llmax(secs[1], 1e-6) << " LoD/s ("
+                   << secs[0] / llmax(secs[1], 1e-6) << "x)" << LL_ENDL;
+    }
+}
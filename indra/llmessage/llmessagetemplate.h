@@ -193,6 +193,7 @@ class LLMessageBlock
             LL_ERRS() << name << " has already been used as a variable name!" << LL_ENDL;
         }
         *varp = new LLMessageVariable(name, type, size);
+        mVariableNames.push_back((*varp)->getName());
         if (((*varp)->getType() != MVT_VARIABLE)
             &&(mTotalSize != -1))
         {
@@ -220,10 +221,31 @@ class LLMessageBlock
         return iter != mMemberVariables.end()? *iter : NULL;
     }
 
+    // Position of the variable in mMemberVariables, -1 if there is no such
+    // variable.  Names are prehashed so this compares pointers, starting at
+    // hint: readers mostly walk the variables in template order.
+    S32 getVariableIndex(const char* name, S32 hint = 0) const
+    {
+        const S32 count = (S32)mVariableNames.size();
+        for (S32 i = hint < count ? hint : 0, n = 0; n < count; ++n)
+        {
+            if (mVariableNames[i] == name)
+            {
+                return i;
+            }
+            if (++i == count)
+            {
+                i = 0;
+            }
+        }
+        return -1;
+    }
+
     friend std::ostream&     operator<<(std::ostream& s, LLMessageBlock &msg);
 
     typedef LLIndexedVector<LLMessageVariable*, const char *, 8> message_variable_map_t;
     message_variable_map_t                  mMemberVariables;
+    std::vector<const char*>                mVariableNames;     // prehashed, in mMemberVariables order
     char                                    *mName;
     EMsgBlockType                           mType;
     S32                                     mNumber;
@@ -300,6 +322,7 @@ class LLMessageTemplate
                 << "has already been used as a block name!" << LL_ENDL;
         }
         *member_blockp = blockp;
+        mBlockNames.push_back(blockp->mName);
         if ((mTotalSize != -1)
             && (blockp->mTotalSize != -1)
             && ((blockp->mType == MBT_SINGLE)
@@ -388,9 +411,25 @@ class LLMessageTemplate
         return iter != mMemberBlocks.end() ? *iter : NULL;
     }
 
+    // Position of the block in mMemberBlocks, -1 if there is no such
+    // block.  Messages have a handful of blocks with prehashed names, a
+    // scan beats the index map.
+    S32 getBlockIndex(const char* name) const
+    {
+        for (S32 i = 0, count = (S32)mBlockNames.size(); i < count; ++i)
+        {
+            if (mBlockNames[i] == name)
+            {
+                return i;
+            }
+        }
+        return -1;
+    }
+
 public:
     typedef LLIndexedVector<LLMessageBlock*, char*, 8> message_block_map_t;
     message_block_map_t                     mMemberBlocks;
+    std::vector<const char*>                mBlockNames;        // prehashed, in mMemberBlocks order
     char                                    *mName;
     EMsgFrequency                           mFrequency;
     EMsgTrust                               mTrust;
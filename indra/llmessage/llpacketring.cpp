@@ -43,6 +43,125 @@
 #include "message.h"
 #include "u64.h"
 #include "llmessagelog.h"
+#include "llthread.h"
+
+#include <atomic>
+
+namespace
+{
+    // Packets the receive thread holds for the main thread, a power of two.
+    // At NET_BUFFER_SIZE a slot that is 8 MB, enough for a second or so of
+    // a busy region.
+    const U32 RECEIVE_QUEUE_SIZE = 1024;
+    const U32 RECEIVE_BATCH_SIZE = 32;
+
+    // how often the receive thread looks up to see whether it should quit
+    const S32 RECEIVE_WAIT_MS = 50;
+}
+
+class LLPacketReceiveThread : public LLThread
+{
+public:
+    LLPacketReceiveThread(S32 socket);
+
+    // Main thread only.  Returns 0 when nothing is queued.
+    S32 popPacket(char *datap, LLHost& sender, LLHost& receiving_if);
+    U32 getQueuedCount() const;
+
+protected:
+    void run() override;
+
+private:
+    struct Slot
+    {
+        char    mData[NET_BUFFER_SIZE];
+        S32     mSize;
+        LLHost  mSender;
+        U32     mReceivingIP;
+    };
+
+    S32 mSocket;
+    std::unique_ptr<Slot[]> mSlots;
+
+    // Free running indices into mSlots.  This thread is the only one to
+    // advance mTail and the main thread the only one to advance mHead.
+    std::atomic<U32> mHead;
+    std::atomic<U32> mTail;
+};
+
+LLPacketReceiveThread::LLPacketReceiveThread(S32 socket) :
+    LLThread("PacketReceive"),
+    mSocket(socket),
+    mSlots(new Slot[RECEIVE_QUEUE_SIZE]),
+    mHead(0),
+    mTail(0)
+{
+}
+
+void LLPacketReceiveThread::run()
+{
+    char* buffers[RECEIVE_BATCH_SIZE];
+    S32 sizes[RECEIVE_BATCH_SIZE];
+    LLHost senders[RECEIVE_BATCH_SIZE];
+    U32 receiving_ips[RECEIVE_BATCH_SIZE];
+
+    while (!isQuitting())
+    {
+        const U32 tail = mTail.load(std::memory_order_relaxed);
+        const U32 room = RECEIVE_QUEUE_SIZE - (tail - mHead.load(std::memory_order_acquire));
+        if (!room)
+        {
+            // The main thread is a whole queue behind, let the socket
+            // buffer take the rest.
+            ms_sleep(1);
+            continue;
+        }
+
+        if (!wait_for_packet(mSocket, RECEIVE_WAIT_MS))
+        {
+            continue;
+        }
+
+        const S32 count = (S32)llmin(room, RECEIVE_BATCH_SIZE);
+        for (S32 i = 0; i < count; ++i)
+        {
+            buffers[i] = mSlots[(tail + i) & (RECEIVE_QUEUE_SIZE - 1)].mData;
+        }
+
+        const S32 received = receive_packets(mSocket, buffers, sizes, senders, receiving_ips, count);
+        for (S32 i = 0; i < received; ++i)
+        {
+            Slot& slot = mSlots[(tail + i) & (RECEIVE_QUEUE_SIZE - 1)];
+            slot.mSize = sizes[i];
+            slot.mSender = senders[i];
+            slot.mReceivingIP = receiving_ips[i];
+        }
+        mTail.store(tail + received, std::memory_order_release);
+    }
+}
+
+S32 LLPacketReceiveThread::popPacket(char *datap, LLHost& sender, LLHost& receiving_if)
+{
+    const U32 head = mHead.load(std::memory_order_relaxed);
+    if (head == mTail.load(std::memory_order_acquire))
+    {
+        return 0;
+    }
+
+    const Slot& slot = mSlots[head & (RECEIVE_QUEUE_SIZE - 1)];
+    memcpy(datap, slot.mData, slot.mSize); /*Flawfinder: ignore*/
+    sender = slot.mSender;
+    receiving_if = LLHost(slot.mReceivingIP, INVALID_PORT);
+    const S32 packet_size = slot.mSize;
+
+    mHead.store(head + 1, std::memory_order_release);
+    return packet_size;
+}
+
+U32 LLPacketReceiveThread::getQueuedCount() const
+{
+    return mTail.load(std::memory_order_acquire) - mHead.load(std::memory_order_relaxed);
+}
 
 ///////////////////////////////////////////////////////////
 LLPacketRing::LLPacketRing () :
@@ -63,9 +182,35 @@ LLPacketRing::LLPacketRing () :
 ///////////////////////////////////////////////////////////
 LLPacketRing::~LLPacketRing ()
 {
+    stopReceiveThread();
     cleanup();
 }
 
+///////////////////////////////////////////////////////////
+void LLPacketRing::startReceiveThread(S32 socket)
+{
+    if (!mReceiveThread)
+    {
+        mReceiveThread.reset(new LLPacketReceiveThread(socket));
+        mReceiveThread->start();
+    }
+}
+
+void LLPacketRing::stopReceiveThread()
+{
+    if (mReceiveThread)
+    {
+        // anything still queued is lost, as it would be in the socket
+        mReceiveThread->shutdown();
+        mReceiveThread.reset();
+    }
+}
+
+U32 LLPacketRing::getQueuedPacketCount() const
+{
+    return mReceiveThread ? mReceiveThread->getQueuedCount() : 0;
+}
+
 ///////////////////////////////////////////////////////////
 void LLPacketRing::cleanup ()
 {
@@ -154,6 +299,20 @@ S32 LLPacketRing::receiveFromRing (S32 socket, char *datap)
     return packet_size;
 }
 
+///////////////////////////////////////////////////////////
+S32 LLPacketRing::receiveFromSocket(S32 socket, char *datap, LLHost& sender, LLHost& receiving_if)
+{
+    if (mReceiveThread)
+    {
+        return mReceiveThread->popPacket(datap, sender, receiving_if);
+    }
+
+    S32 packet_size = receive_packet(socket, datap);
+    sender = ::get_sender();
+    receiving_if = ::get_receiving_interface();
+    return packet_size;
+}
+
 ///////////////////////////////////////////////////////////
 S32 LLPacketRing::receivePacket (S32 socket, char *datap)
 {
@@ -167,8 +326,13 @@ S32 LLPacketRing::receivePacket (S32 socket, char *datap)
         // push any current net packet (if any) onto delay ring
         while (!done)
         {
+            char buffer[NET_BUFFER_SIZE];   /* Flawfinder: ignore */
+            LLHost sender;
+            LLHost receiving_if;
+            S32 size = receiveFromSocket(socket, buffer, sender, receiving_if);
+
             LLPacketBuffer *packetp;
-            packetp = new LLPacketBuffer(socket);
+            packetp = new LLPacketBuffer(sender, buffer, llmax(size, 0), receiving_if);
 
             if (packetp->getSize())
             {
@@ -228,7 +392,7 @@ S32 LLPacketRing::receivePacket (S32 socket, char *datap)
         if (LLProxy::isSOCKSProxyEnabled())
         {
             U8 buffer[NET_BUFFER_SIZE + SOCKS_HEADER_SIZE];
-            packet_size = receive_packet(socket, static_cast<char*>(static_cast<void*>(buffer)));
+            packet_size = receiveFromSocket(socket, static_cast<char*>(static_cast<void*>(buffer)), mLastSender, mLastReceivingIF);
 
             if (packet_size > SOCKS_HEADER_SIZE)
             {
@@ -247,12 +411,9 @@ S32 LLPacketRing::receivePacket (S32 socket, char *datap)
         }
         else
         {
-            packet_size = receive_packet(socket, datap);
-            mLastSender = ::get_sender();
+            packet_size = receiveFromSocket(socket, datap, mLastSender, mLastReceivingIF);
         }
 
-        mLastReceivingIF = ::get_receiving_interface();
-
         if (packet_size)  // did we actually get a packet?
         {
             if (mDropPercentage && (ll_frand(100.f) < mDropPercentage))
@@ -28,6 +28,7 @@
 #ifndef LL_LLPACKETRING_H
 #define LL_LLPACKETRING_H
 
+#include <memory>
 #include <queue>
 
 #include "llhost.h"
@@ -55,6 +56,13 @@ class LLPacketRing
 
     BOOL sendPacket(int h_socket, char * send_buffer, S32 buf_size, const LLHost& host);
 
+    // Drains socket on a thread of its own, so packets wait here rather than
+    // overflow the socket buffer while the main thread is busy.
+    // receivePacket() takes them from that queue until the thread stops.
+    void startReceiveThread(S32 socket);
+    void stopReceiveThread();
+    U32  getQueuedPacketCount() const;
+
     inline LLHost getLastSender();
     inline LLHost getLastReceivingInterface();
 
@@ -83,8 +91,11 @@ class LLPacketRing
     LLHost mLastSender;
     LLHost mLastReceivingIF;
 
+    std::unique_ptr<class LLPacketReceiveThread> mReceiveThread;
+
 private:
     BOOL sendPacketImpl(int h_socket, const char * send_buffer, S32 buf_size, const LLHost& host);
+    S32  receiveFromSocket(S32 socket, char *datap, LLHost& sender, LLHost& receiving_if);
 };
 
 
@@ -41,16 +41,15 @@ LLTemplateMessageReader::LLTemplateMessageReader(message_template_number_map_t&
                                                  number_template_map) :
     mReceiveSize(0),
     mCurrentRMessageTemplate(nullptr),
-    mCurrentRMessageData(nullptr),
-    mMessageNumbers(number_template_map)
+    mMessageNumbers(number_template_map),
+    mDecoded(false),
+    mVariableHint(0)
 {
 }
 
 //virtual
 LLTemplateMessageReader::~LLTemplateMessageReader()
 {
-    delete mCurrentRMessageData;
-    mCurrentRMessageData = nullptr;
 }
 
 //virtual
@@ -58,8 +57,31 @@ void LLTemplateMessageReader::clearMessage()
 {
     mReceiveSize = -1;
     mCurrentRMessageTemplate = nullptr;
-    delete mCurrentRMessageData;
-    mCurrentRMessageData = nullptr;
+    mDecoded = false;
+    mBuffer.clear();
+    mBlocks.clear();
+    mVariables.clear();
+}
+
+const LLTemplateMessageReader::BlockLocation* LLTemplateMessageReader::findBlock(const char* blockname) const
+{
+    S32 index = mCurrentRMessageTemplate->getBlockIndex(blockname);
+    if (index < 0 || !mBlocks[index].mCount)
+    {
+        return nullptr;
+    }
+    return &mBlocks[index];
+}
+
+const LLTemplateMessageReader::VarLocation* LLTemplateMessageReader::findVariable(const BlockLocation& block, const char* varname, S32 blocknum)
+{
+    S32 index = block.mBlock->getVariableIndex(varname, mVariableHint);
+    if (index < 0)
+    {
+        return nullptr;
+    }
+    mVariableHint = index + 1;
+    return &mVariables[block.mFirstVar + blocknum * block.mStride + index];
 }
 
 void LLTemplateMessageReader::getData(const char *blockname, const char *varname, void *datap, S32 size, S32 blocknum, S32 max_size)
@@ -71,82 +93,60 @@ void LLTemplateMessageReader::getData(const char *blockname, const char *varname
         return;
     }
 
-    if (!mCurrentRMessageData)
+    if (!mDecoded)
     {
         LL_ERRS() << "Invalid mCurrentMessageData in getData!" << LL_ENDL;
         return;
     }
 
-    char *bnamep = (char *)blockname + blocknum; // this works because it's just a hash.  The bnamep is never derefference
-    char *vnamep = (char *)varname;
-
-    LLMsgData::msg_blk_data_map_t::const_iterator iter = mCurrentRMessageData->mMemberBlocks.find(bnamep);
-
-    if (iter == mCurrentRMessageData->mMemberBlocks.end())
+    const BlockLocation* block = findBlock(blockname);
+    if (!block || blocknum < 0 || blocknum >= block->mCount)
     {
         LL_ERRS() << "Block " << blockname << " #" << blocknum
-            << " not in message " << mCurrentRMessageData->mName << LL_ENDL;
+            << " not in message " << mCurrentRMessageTemplate->mName << LL_ENDL;
         return;
     }
 
-    LLMsgBlkData *msg_block_data = iter->second;
-    LLMsgBlkData::msg_var_data_map_t &var_data_map = msg_block_data->mMemberVarData;
-
-    if (var_data_map.find(vnamep) == var_data_map.end())
+    const VarLocation* vardata = findVariable(*block, varname, blocknum);
+    if (!vardata)
     {
-        LL_ERRS() << "Variable "<< vnamep << " not in message "
-            << mCurrentRMessageData->mName<< " block " << bnamep << LL_ENDL;
+        LL_ERRS() << "Variable "<< varname << " not in message "
+            << mCurrentRMessageTemplate->mName << " block " << blockname << LL_ENDL;
         return;
     }
 
-    LLMsgVarData& vardata = msg_block_data->mMemberVarData[vnamep];
-
-    if (size && size != vardata.getSize())
+    if (size && size != vardata->mSize)
     {
-        LL_ERRS() << "Msg " << mCurrentRMessageData->mName
-            << " variable " << vnamep
-            << " is size " << vardata.getSize()
+        LL_ERRS() << "Msg " << mCurrentRMessageTemplate->mName
+            << " variable " << varname
+            << " is size " << vardata->mSize
             << " but copying into buffer of size " << size
             << LL_ENDL;
         return;
     }
 
-
-    const S32 vardata_size = vardata.getSize();
-    if( max_size >= vardata_size )
+    S32 copy_size = vardata->mSize;
+    if (max_size < copy_size)
     {
-        switch( vardata_size )
-        {
-        case 0:
-            // This is here to prevent a memcpy from a null value which is undefined behavior.
-            break;
-        case 1:
-            *((U8*)datap) = *((U8*)vardata.getData());
-            break;
-        case 2:
-            *((U16*)datap) = *((U16*)vardata.getData());
-            break;
-        case 4:
-            *((U32*)datap) = *((U32*)vardata.getData());
-            break;
-        case 8:
-            ((U32*)datap)[0] = ((U32*)vardata.getData())[0];
-            ((U32*)datap)[1] = ((U32*)vardata.getData())[1];
-            break;
-        default:
-            memcpy(datap, vardata.getData(), vardata_size);
-            break;
-        }
-    }
-    else
-    {
-        LL_WARNS() << "Msg " << mCurrentRMessageData->mName
-            << " variable " << vnamep
-            << " is size " << vardata.getSize()
+        LL_WARNS() << "Msg " << mCurrentRMessageTemplate->mName
+            << " variable " << varname
+            << " is size " << vardata->mSize
             << " but truncated to max size of " << max_size
             << LL_ENDL;
+        copy_size = max_size;
+    }
 
-        memcpy(datap, vardata.getData(), max_size);
+    // Zero sized variables have no data to copy, and memcpy from an empty
+    // buffer is undefined behavior.
+    if (copy_size > 0)
+    {
+#if LL_BIG_ENDIAN
+        const LLMessageVariable* variable = *(block->mBlock->mMemberVariables.begin() + (mVariableHint - 1));
+        htolememcpy(datap, &mBuffer[vardata->mOffset], variable->getType(), copy_size);
+#else
+        // the data is not aligned in the packet
+        memcpy(datap, &mBuffer[vardata->mOffset], copy_size);
+#endif
     }
 }
 
@@ -159,22 +159,14 @@ S32 LLTemplateMessageReader::getNumberOfBlocks(const char *blockname)
         return -1;
     }
 
-    if (!mCurrentRMessageData)
+    if (!mDecoded)
     {
         LL_ERRS() << "Invalid mCurrentRMessageData in getData!" << LL_ENDL;
         return -1;
     }
 
-    char *bnamep = (char *)blockname;
-
-    LLMsgData::msg_blk_data_map_t::const_iterator iter = mCurrentRMessageData->mMemberBlocks.find(bnamep);
-
-    if (iter == mCurrentRMessageData->mMemberBlocks.end())
-    {
-        return 0;
-    }
-
-    return (iter->second)->mBlockNumber;
+    const BlockLocation* block = findBlock(blockname);
+    return block ? block->mCount : 0;
 }
 
 S32 LLTemplateMessageReader::getSize(const char *blockname, const char *varname)
@@ -186,43 +178,36 @@ S32 LLTemplateMessageReader::getSize(const char *blockname, const char *varname)
         return LL_MESSAGE_ERROR;
     }
 
-    if (!mCurrentRMessageData)
+    if (!mDecoded)
     {   // This is a serious error - crash
         LL_ERRS() << "Invalid mCurrentRMessageData in getData!" << LL_ENDL;
         return LL_MESSAGE_ERROR;
     }
 
-    char *bnamep = (char *)blockname;
-
-    LLMsgData::msg_blk_data_map_t::const_iterator iter = mCurrentRMessageData->mMemberBlocks.find(bnamep);
-
-    if (iter == mCurrentRMessageData->mMemberBlocks.end())
+    const BlockLocation* block = findBlock(blockname);
+    if (!block)
     {   // don't crash
-        LL_INFOS() << "Block " << bnamep << " not in message "
-            << mCurrentRMessageData->mName << LL_ENDL;
+        LL_INFOS() << "Block " << blockname << " not in message "
+            << mCurrentRMessageTemplate->mName << LL_ENDL;
         return LL_BLOCK_NOT_IN_MESSAGE;
     }
 
-    char *vnamep = (char *)varname;
-
-    LLMsgBlkData* msg_data = iter->second;
-    LLMsgVarData& vardata = msg_data->mMemberVarData[vnamep];
-
-    if (!vardata.getName())
+    const VarLocation* vardata = findVariable(*block, varname, 0);
+    if (!vardata)
     {   // don't crash
         LL_INFOS() << "Variable " << varname << " not in message "
-            << mCurrentRMessageData->mName << " block " << bnamep << LL_ENDL;
+            << mCurrentRMessageTemplate->mName << " block " << blockname << LL_ENDL;
         return LL_VARIABLE_NOT_IN_BLOCK;
     }
 
-    if (mCurrentRMessageTemplate->mMemberBlocks[bnamep]->mType != MBT_SINGLE)
+    if (block->mBlock->mType != MBT_SINGLE)
     {   // This is a serious error - crash
-        LL_ERRS() << "Block " << bnamep << " isn't type MBT_SINGLE,"
+        LL_ERRS() << "Block " << blockname << " isn't type MBT_SINGLE,"
             " use getSize with blocknum argument!" << LL_ENDL;
         return LL_MESSAGE_ERROR;
     }
 
-    return vardata.getSize();
+    return vardata->mSize;
 }
 
 S32 LLTemplateMessageReader::getSize(const char *blockname, S32 blocknum, const char *varname)
@@ -234,35 +219,29 @@ S32 LLTemplateMessageReader::getSize(const char *blockname, S32 blocknum, const
         return LL_MESSAGE_ERROR;
     }
 
-    if (!mCurrentRMessageData)
+    if (!mDecoded)
     {   // This is a serious error - crash
         LL_ERRS() << "Invalid mCurrentRMessageData in getData!" << LL_ENDL;
         return LL_MESSAGE_ERROR;
     }
 
-    char *bnamep = (char *)blockname + blocknum;
-    char *vnamep = (char *)varname;
-
-    LLMsgData::msg_blk_data_map_t::const_iterator iter = mCurrentRMessageData->mMemberBlocks.find(bnamep);
-
-    if (iter == mCurrentRMessageData->mMemberBlocks.end())
+    const BlockLocation* block = findBlock(blockname);
+    if (!block || blocknum < 0 || blocknum >= block->mCount)
     {   // don't crash
-        LL_INFOS() << "Block " << bnamep << " not in message "
-            << mCurrentRMessageData->mName << LL_ENDL;
+        LL_INFOS() << "Block " << blockname << " #" << blocknum << " not in message "
+            << mCurrentRMessageTemplate->mName << LL_ENDL;
         return LL_BLOCK_NOT_IN_MESSAGE;
     }
 
-    LLMsgBlkData* msg_data = iter->second;
-    LLMsgVarData& vardata = msg_data->mMemberVarData[vnamep];
-
-    if (!vardata.getName())
+    const VarLocation* vardata = findVariable(*block, varname, blocknum);
+    if (!vardata)
     {   // don't crash
-        LL_INFOS() << "Variable " << vnamep << " not in message "
-            <<  mCurrentRMessageData->mName << " block " << bnamep << LL_ENDL;
+        LL_INFOS() << "Variable " << varname << " not in message "
+            <<  mCurrentRMessageTemplate->mName << " block " << blockname << LL_ENDL;
         return LL_VARIABLE_NOT_IN_BLOCK;
     }
 
-    return vardata.getSize();
+    return vardata->mSize;
 }
 
 void LLTemplateMessageReader::getBinaryData(const char *blockname,
@@ -539,18 +518,22 @@ BOOL LLTemplateMessageReader::decodeData(const U8* buffer, const LLHost& sender,
 
     llassert( mReceiveSize >= 0 );
     llassert( mCurrentRMessageTemplate);
-    llassert( !mCurrentRMessageData );
-    delete mCurrentRMessageData; // just to make sure
+    llassert( !mDecoded );
+
+    // Keep a copy of the packet: the tables below point into it and the
+    // caller's buffer may not outlive the message.
+    mBuffer.assign(buffer, buffer + mReceiveSize);
+    mBlocks.clear();
+    mVariables.clear();
+    mVariableHint = 0;
 
     // The offset tells us how may bytes to skip after the end of the
     // message name.
     U8 offset = buffer[PHL_OFFSET];
     S32 decode_pos = LL_PACKET_ID_SIZE + (S32)(mCurrentRMessageTemplate->mFrequency) + offset;
+    S32 total_blocks = 0;
 
-    // create base working data set
-    mCurrentRMessageData = new LLMsgData(mCurrentRMessageTemplate->mName);
-
-    // loop through the template building the data structure as we go
+    // loop through the template locating the data as we go
     LLMessageTemplate::message_block_map_t::const_iterator iter;
     for(iter = mCurrentRMessageTemplate->mMemberBlocks.begin();
         iter != mCurrentRMessageTemplate->mMemberBlocks.end();
@@ -598,36 +581,24 @@ BOOL LLTemplateMessageReader::decodeData(const U8* buffer, const LLHost& sender,
             return FALSE;
         }
 
-        LLMsgBlkData* cur_data_block = nullptr;
+        BlockLocation block;
+        block.mBlock = mbci;
+        block.mFirstVar = (S32)mVariables.size();
+        block.mCount = repeat_number;
+        block.mStride = (S32)mbci->mMemberVariables.size();
+        mBlocks.push_back(block);
+        total_blocks += repeat_number;
 
         // now loop through the block
         for (i = 0; i < repeat_number; i++)
         {
-            if (i)
-            {
-                // build new name to prevent collisions
-                // TODO: This should really change to a vector
-                cur_data_block = new LLMsgBlkData(mbci->mName, repeat_number);
-                cur_data_block->mName = mbci->mName + i;
-            }
-            else
-            {
-                cur_data_block = new LLMsgBlkData(mbci->mName, repeat_number);
-            }
-
-            // add the block to the message
-            mCurrentRMessageData->addBlock(cur_data_block);
-
             // now read the variables
             for (LLMessageBlock::message_variable_map_t::const_iterator iter =
                      mbci->mMemberVariables.begin();
                  iter != mbci->mMemberVariables.end(); iter++)
             {
                 const LLMessageVariable& mvci = **iter;
-
-                // ok, build out the variables
-                // add variable block
-                cur_data_block->addVariable(mvci.getName(), mvci.getType());
+                VarLocation var;
 
                 // what type of variable?
                 if (mvci.getType() == MVT_VARIABLE)
@@ -668,44 +639,54 @@ BOOL LLTemplateMessageReader::decodeData(const U8* buffer, const LLHost& sender,
                     }
                     decode_pos += data_size;
 
-                    cur_data_block->addData(mvci.getName(), &buffer[decode_pos], tsize, mvci.getType());
+                    S32 available = llmax(mReceiveSize - decode_pos, 0);
+                    if (tsize > (U32)available)
+                    {
+                        // never hand out bytes past the end of the packet
+                        if (!custom)
+                        logRanOffEndOfPacket(sender, decode_pos, (S32)tsize);
+
+                        tsize = available;
+                    }
+
+                    var.mOffset = decode_pos;
+                    var.mSize = (S32)tsize;
                     decode_pos += tsize;
                 }
                 else
                 {
                     // fixed!
-                    // so, copy data pointer and set data size to fixed size
-                    if ((decode_pos + mvci.getSize()) > mReceiveSize)
+                    // so, point at the data and set data size to fixed size
+                    var.mSize = mvci.getSize();
+                    if ((decode_pos + var.mSize) > mReceiveSize)
                     {
                         if (!custom)
-                        logRanOffEndOfPacket(sender, decode_pos, mvci.getSize());
+                        logRanOffEndOfPacket(sender, decode_pos, var.mSize);
 
                         // default to 0s.
-                        U32 size = mvci.getSize();
-                        std::vector<U8> data(size, 0);
-                        cur_data_block->addData(mvci.getName(), &(data[0]),
-                                                size, mvci.getType());
+                        var.mOffset = (S32)mBuffer.size();
+                        mBuffer.resize(mBuffer.size() + var.mSize, 0);
                     }
                     else
                     {
-                        cur_data_block->addData(mvci.getName(),
-                                                &buffer[decode_pos],
-                                                mvci.getSize(),
-                                                mvci.getType());
+                        var.mOffset = decode_pos;
                     }
-                    decode_pos += mvci.getSize();
+                    decode_pos += var.mSize;
                 }
+                mVariables.push_back(var);
             }
         }
     }
 
-    if (mCurrentRMessageData->mMemberBlocks.empty()
+    if (!total_blocks
         && !mCurrentRMessageTemplate->mMemberBlocks.empty())
     {
         LL_DEBUGS() << "Empty message '" << mCurrentRMessageTemplate->mName << "' (no blocks)" << LL_ENDL;
         return FALSE;
     }
 
+    mDecoded = true;
+
     if (!custom)
     {
         static LLTimer decode_timer;
@@ -829,11 +810,36 @@ bool LLTemplateMessageReader::isUdpBanned() const
 //virtual
 void LLTemplateMessageReader::copyToBuilder(LLMessageBuilder& builder) const
 {
-    if(nullptr == mCurrentRMessageTemplate)
+    if(nullptr == mCurrentRMessageTemplate || !mDecoded)
     {
         return;
     }
-    builder.copyFromMessageData(*mCurrentRMessageData);
+
+    // The builder copies from the tree form the reader used to build, only
+    // made here on this rare path.
+    LLMsgData message_data(mCurrentRMessageTemplate->mName);
+    for (const BlockLocation& block : mBlocks)
+    {
+        const LLMessageBlock* mbci = block.mBlock;
+        for (S32 i = 0; i < block.mCount; ++i)
+        {
+            LLMsgBlkData* block_data = new LLMsgBlkData(mbci->mName, block.mCount);
+            // build new name to prevent collisions
+            block_data->mName = mbci->mName + i;
+            message_data.addBlock(block_data);
+
+            const VarLocation* var = &mVariables[block.mFirstVar + i * block.mStride];
+            for (LLMessageBlock::message_variable_map_t::const_iterator iter =
+                     mbci->mMemberVariables.begin();
+                 iter != mbci->mMemberVariables.end(); ++iter, ++var)
+            {
+                const LLMessageVariable& mvci = **iter;
+                block_data->addVariable(mvci.getName(), mvci.getType());
+                block_data->addData(mvci.getName(), &mBuffer[0] + var->mOffset, var->mSize, mvci.getType());
+            }
+        }
+    }
+    builder.copyFromMessageData(message_data);
 }
 
 LLMessageTemplate* LLTemplateMessageReader::getTemplate()
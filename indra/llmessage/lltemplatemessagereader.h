@@ -29,8 +29,10 @@
 
 #include "llmessagereader.h"
 
+#include <vector>
+
+class LLMessageBlock;
 class LLMessageTemplate;
-class LLMsgData;
 
 class LLTemplateMessageReader : public LLMessageReader
 {
@@ -109,18 +111,52 @@ class LLTemplateMessageReader : public LLMessageReader
 
 private:
 
+    struct BlockLocation;
+    struct VarLocation;
+
     void getData(const char *blockname, const char *varname, void *datap,
                  S32 size = 0, S32 blocknum = 0, S32 max_size = S32_MAX);
 
+    // Decoded block matching a prehashed name, NULL when the message has
+    // no such block or it was sent with 0 repeats.
+    const BlockLocation* findBlock(const char* blockname) const;
+    // Decoded variable of a block, NULL when the block has no such variable
+    const VarLocation* findVariable(const BlockLocation& block, const char* varname, S32 blocknum);
+
     BOOL decodeTemplate(const U8* buffer, S32 buffer_size,  // inputs
                         LLMessageTemplate** msg_template, bool custom = false); // outputs
 
     void logRanOffEndOfPacket( const LLHost& host, const S32 where, const S32 wanted );
 
+    // Where each block of the current message was found: its variables
+    // are mCount runs of mStride entries of mVariables from mFirstVar on.
+    struct BlockLocation
+    {
+        const LLMessageBlock* mBlock;
+        S32 mFirstVar;
+        S32 mCount;
+        S32 mStride;
+    };
+
+    // Where a variable was found in mBuffer
+    struct VarLocation
+    {
+        S32 mOffset;
+        S32 mSize;
+    };
+
     S32 mReceiveSize;
     LLMessageTemplate* mCurrentRMessageTemplate;
-    LLMsgData* mCurrentRMessageData;
     message_template_number_map_t& mMessageNumbers;
+
+    // The decoded message indexes a copy of the packet rather than copying
+    // each variable out of it.  The tables are cleared, not freed, between
+    // messages so steady state decoding does not allocate.
+    bool mDecoded;
+    std::vector<U8> mBuffer;
+    std::vector<BlockLocation> mBlocks;     // in template order
+    std::vector<VarLocation> mVariables;
+    S32 mVariableHint;                      // index of the last variable read + 1
 };
 
 #endif // LL_LLTEMPLATEMESSAGEREADER_H
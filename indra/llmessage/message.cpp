@@ -246,6 +246,11 @@ LLMessageSystem::LLMessageSystem(const std::string& filename, U32 port,
         mbError = TRUE;
         mErrorCode = error;
     }
+    else
+    {
+        // keep the socket drained while the main thread is busy elsewhere
+        mPacketRing.startReceiveThread(mSocket);
+    }
 //  LL_DEBUGS("Messaging") <<  << "*** port: " << mPort << LL_ENDL;
 
     //
@@ -328,6 +333,7 @@ LLMessageSystem::~LLMessageSystem()
 
     if (!mbError)
     {
+        mPacketRing.stopReceiveThread();
         end_net(mSocket);
     }
     mSocket = 0;
@@ -365,6 +371,13 @@ void LLMessageSystem::clearReceiveState()
 
 BOOL LLMessageSystem::poll(F32 seconds)
 {
+    // the receive thread takes packets off the socket as they arrive, so
+    // they may already be waiting in the ring with nothing left to poll
+    if (mPacketRing.getQueuedPacketCount())
+    {
+        return TRUE;
+    }
+
     S32 num_socks;
     apr_status_t status;
     status = apr_poll(&(mPollInfop->mPollFD), 1, &num_socks,(U64)(seconds*1000000.f));
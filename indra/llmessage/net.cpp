@@ -40,6 +40,7 @@
     #include <arpa/inet.h>
     #include <fcntl.h>
     #include <errno.h>
+    #include <poll.h>
 #endif
 
 // linden library includes
@@ -336,6 +337,40 @@ S32 receive_packet(int hSocket, char * receiveBuffer)
     return nRet;
 }
 
+S32 receive_packets(int hSocket, char * const receiveBuffers[], S32 sizes[], LLHost senders[], U32 receiving_ips[], S32 count)
+{
+    S32 received = 0;
+    while (received < count)
+    {
+        struct sockaddr_in src_addr;
+        int addr_size = sizeof(src_addr);
+        int nRet = recvfrom(hSocket, receiveBuffers[received], NET_BUFFER_SIZE, 0, (struct sockaddr*)&src_addr, &addr_size);
+        if (nRet == SOCKET_ERROR)
+        {
+            S32 err = WSAGetLastError();
+            if (err != WSAEWOULDBLOCK && err != WSAECONNRESET)
+            {
+                LL_INFOS() << "receive_packets() failed, Error: " << err << LL_ENDL;
+            }
+            break;
+        }
+        sizes[received] = nRet;
+        senders[received] = LLHost(src_addr.sin_addr.s_addr, ntohs(src_addr.sin_port));
+        receiving_ips[received] = INVALID_HOST_IP_ADDRESS;
+        ++received;
+    }
+    return received;
+}
+
+BOOL wait_for_packet(int hSocket, S32 timeout_ms)
+{
+    fd_set read_fds;
+    FD_ZERO(&read_fds);
+    FD_SET((SOCKET)hSocket, &read_fds);
+    struct timeval timeout = { timeout_ms / 1000, (timeout_ms % 1000) * 1000 };
+    return select(0, &read_fds, NULL, NULL, &timeout) > 0;
+}
+
 // Returns TRUE on success.
 BOOL send_packet(int hSocket, const char *sendBuffer, int size, U32 recipient, int nPort)
 {
@@ -598,6 +633,77 @@ int receive_packet(int hSocket, char * receiveBuffer)
     return nRet;
 }
 
+S32 receive_packets(int hSocket, char * const receiveBuffers[], S32 sizes[], LLHost senders[], U32 receiving_ips[], S32 count)
+{
+    const S32 MAX_BATCH = 64;
+    count = llmin(count, MAX_BATCH);
+
+#if LL_LINUX
+    struct mmsghdr msgs[MAX_BATCH];
+    struct iovec iovs[MAX_BATCH];
+    struct sockaddr_in src_addrs[MAX_BATCH];
+    char cmsgs[MAX_BATCH][CMSG_SPACE(sizeof(struct in_pktinfo))];
+
+    memset(msgs, 0, sizeof(msgs[0]) * count);
+    for (S32 i = 0; i < count; ++i)
+    {
+        iovs[i].iov_base = receiveBuffers[i];
+        iovs[i].iov_len = NET_BUFFER_SIZE;
+        msgs[i].msg_hdr.msg_name = &src_addrs[i];
+        msgs[i].msg_hdr.msg_namelen = sizeof(src_addrs[i]);
+        msgs[i].msg_hdr.msg_iov = &iovs[i];
+        msgs[i].msg_hdr.msg_iovlen = 1;
+        msgs[i].msg_hdr.msg_control = cmsgs[i];
+        msgs[i].msg_hdr.msg_controllen = sizeof(cmsgs[i]);
+    }
+
+    int received = recvmmsg(hSocket, msgs, count, MSG_DONTWAIT, NULL);
+    if (received < 0)
+    {
+        return 0;
+    }
+
+    for (S32 i = 0; i < received; ++i)
+    {
+        sizes[i] = msgs[i].msg_len;
+        senders[i] = LLHost(src_addrs[i].sin_addr.s_addr, ntohs(src_addrs[i].sin_port));
+        receiving_ips[i] = INVALID_HOST_IP_ADDRESS;
+        for (struct cmsghdr* cmsgptr = CMSG_FIRSTHDR(&msgs[i].msg_hdr); cmsgptr != NULL; cmsgptr = CMSG_NXTHDR(&msgs[i].msg_hdr, cmsgptr))
+        {
+            if (cmsgptr->cmsg_level == SOL_IP && cmsgptr->cmsg_type == IP_PKTINFO)
+            {
+                // same choice of address as recvfrom_destip()
+                receiving_ips[i] = ((in_pktinfo*)CMSG_DATA(cmsgptr))->ipi_spec_dst.s_addr;
+            }
+        }
+    }
+    return received;
+#else
+    S32 received = 0;
+    while (received < count)
+    {
+        struct sockaddr_in src_addr;
+        socklen_t addr_size = sizeof(src_addr);
+        int nRet = recvfrom(hSocket, receiveBuffers[received], NET_BUFFER_SIZE, 0, (struct sockaddr*)&src_addr, &addr_size);
+        if (nRet == -1)
+        {
+            break;
+        }
+        sizes[received] = nRet;
+        senders[received] = LLHost(src_addr.sin_addr.s_addr, ntohs(src_addr.sin_port));
+        receiving_ips[received] = INVALID_HOST_IP_ADDRESS;
+        ++received;
+    }
+    return received;
+#endif
+}
+
+BOOL wait_for_packet(int hSocket, S32 timeout_ms)
+{
+    struct pollfd poll_fd = { hSocket, POLLIN, 0 };
+    return poll(&poll_fd, 1, timeout_ms) > 0;
+}
+
 BOOL send_packet(int hSocket, const char * sendBuffer, int size, U32 recipient, int nPort)
 {
     int     ret;
@@ -43,6 +43,15 @@ void    end_net(S32& socket_out);
 // returns size of packet or -1 in case of error
 S32     receive_packet(int hSocket, char * receiveBuffer);
 
+// Receives up to count packets without blocking, packet i into buffers[i] of
+// NET_BUFFER_SIZE bytes, and returns how many arrived.  Senders and receiving
+// interfaces go to the arrays rather than get_sender(), so it may be called
+// off the main thread.  Linux drains them with a single recvmmsg().
+S32     receive_packets(int hSocket, char * const receiveBuffers[], S32 sizes[], LLHost senders[], U32 receiving_ips[], S32 count);
+
+// Returns TRUE once hSocket has a packet waiting, FALSE after timeout_ms.
+BOOL    wait_for_packet(int hSocket, S32 timeout_ms);
+
 BOOL    send_packet(int hSocket, const char *sendBuffer, int size, U32 recipient, int nPort);   // Returns TRUE on success.
 
 //void  get_sender(char * tmp);
@@ -43,4 +43,11 @@ void    decode_patch_group_header(LLBitPack &bitpack, LLGroupHeader *gopp);
 void    decode_patch_header(LLBitPack &bitpack, LLPatchHeader *ph, bool b_large_patch = false);
 void    decode_patch(LLBitPack &bitpack, S32 *patches);
 
+// Same as the decode functions, but they leave the current patch size and
+// word bits alone, so that several threads can decode at once.  wbits is
+// (ph->quant_wbits & 0xf) + 2 of the patch header just read.
+void    unpack_patch_group_header(LLBitPack &bitpack, LLGroupHeader *gopp);
+void    unpack_patch_header(LLBitPack &bitpack, LLPatchHeader *ph, bool b_large_patch = false);
+void    unpack_patch(LLBitPack &bitpack, S32 *patches, S32 patch_size, S32 wbits);
+
 #endif
@@ -27,6 +27,7 @@
 #ifndef LL_PATCH_DCT_H
 #define LL_PATCH_DCT_H
 
+class LLBitPack;
 class LLVector3;
 
 // Code Values
@@ -84,8 +85,36 @@ void get_patch_group_header(LLGroupHeader *gopp);
 
 // Decompression routines
 void set_group_of_patch_header(LLGroupHeader *gopp);
-void init_patch_decompressor(S32 size);
 void decompress_patch(F32 *patch, S32 *cpatch, LLPatchHeader *ph);
 void decompress_patchv(LLVector3 *v, S32 *cpatch, LLPatchHeader *ph);
 
+// Reentrant decompressor.  The dequantize, zigzag and cosine tables of 16x16
+// and 32x32 patches are built once and only read after that, everything
+// else is kept per decoder, so each thread can decode with its own.  The
+// functions above use it too.
+class LLPatchDecoder
+{
+public:
+    LLPatchDecoder();
+
+    // Takes the patch size and the stride between the output rows from the
+    // group header.  Returns false if the patch size is not 16 or 32.
+    bool setGroupHeader(const LLGroupHeader &goph);
+    S32 getPatchSize() const            { return mPatchSize; }
+
+    // Unpacks the coefficients that follow the patch header ph and writes
+    // the patch heights to patch.
+    void decodePatch(LLBitPack &bitpack, const LLPatchHeader &ph, F32 *patch) const;
+    // Same with coefficients already unpacked
+    void decompressPatch(F32 *patch, const S32 *cpatch, const LLPatchHeader &ph) const;
+
+private:
+    struct Tables;
+    static const Tables *getTables(S32 size);
+
+    const Tables *mTables;
+    S32 mPatchSize;
+    S32 mStride;
+};
+
 #endif
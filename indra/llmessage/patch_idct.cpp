@@ -30,6 +30,9 @@
 //#include "vmath.h"
 #include "v3math.h"
 #include "patch_dct.h"
+#include "patch_code.h"
+
+#include <xmmintrin.h>
 
 LLGroupHeader   *gGOPP;
 
@@ -38,53 +41,56 @@ void set_group_of_patch_header(LLGroupHeader *gopp)
     gGOPP = gopp;
 }
 
-F32 gPatchDequantizeTable[LARGE_PATCH_SIZE*LARGE_PATCH_SIZE];
-void build_patch_dequantize_table(S32 size)
+struct LLPatchDecoder::Tables
+{
+    Tables(S32 size);
+
+    // Cosines of the inverse transform, [u*size + n], with the 1/sqrt(2)
+    // of the u = 0 term folded into the first row.
+    alignas(16) F32 mICosines[LARGE_PATCH_SIZE*LARGE_PATCH_SIZE];
+    F32 mDequantize[LARGE_PATCH_SIZE*LARGE_PATCH_SIZE];
+    // Index in the zigzag ordered coefficients of each block position
+    S32 mDeCopy[LARGE_PATCH_SIZE*LARGE_PATCH_SIZE];
+    // Rows and columns of the block spanned by the first k+1 zigzag
+    // ordered coefficients
+    U8 mRows[LARGE_PATCH_SIZE*LARGE_PATCH_SIZE];
+    U8 mCols[LARGE_PATCH_SIZE*LARGE_PATCH_SIZE];
+};
+
+LLPatchDecoder::Tables::Tables(S32 size)
 {
-    S32 i, j;
+    S32 i, j, n, u;
+
     for (j = 0; j < size; j++)
     {
         for (i = 0; i < size; i++)
         {
-            gPatchDequantizeTable[j*size + i] = (1.f + 2.f*(i+j));
+            mDequantize[j*size + i] = (1.f + 2.f*(i+j));
         }
     }
-}
 
-S32 gCurrentDeSize = 0;
-
-F32 gPatchICosines[LARGE_PATCH_SIZE*LARGE_PATCH_SIZE];
-
-void setup_patch_icosines(S32 size)
-{
-    S32 n, u;
     F32 oosob = F_PI*0.5f/size;
-
     for (u = 0; u < size; u++)
     {
         for (n = 0; n < size; n++)
         {
-            gPatchICosines[u*size+n] = cosf((2.f*n+1.f)*u*oosob);
+            mICosines[u*size+n] = u ? cosf((2.f*n+1.f)*u*oosob) : OO_SQRT2;
         }
     }
-}
-
-S32 gDeCopyMatrix[LARGE_PATCH_SIZE*LARGE_PATCH_SIZE];
 
-void build_decopy_matrix(S32 size)
-{
-    S32 i, j, count;
+    S32 count = 0;
     BOOL    b_diag = FALSE;
     BOOL    b_right = TRUE;
 
     i = 0;
     j = 0;
-    count = 0;
 
     while (  (i < size)
            &&(j < size))
     {
-        gDeCopyMatrix[j*size + i] = count;
+        mDeCopy[j*size + i] = count;
+        mRows[count] = llmax((S32)(count ? mRows[count - 1] : 0), j + 1);
+        mCols[count] = llmax((S32)(count ? mCols[count - 1] : 0), i + 1);
 
         count++;
 
@@ -135,541 +141,199 @@ void build_decopy_matrix(S32 size)
     }
 }
 
-void init_patch_decompressor(S32 size)
+namespace
 {
-    if (size != gCurrentDeSize)
+    // Separable inverse DCT of a SIZE x SIZE block, in place.  Each pass
+    // scales a row of cosines (or of the block) by one coefficient and
+    // adds it to a whole output line, 4 floats at a time.  Only the first
+    // rows x cols coefficients can be non zero, so the passes stop there.
+    template <S32 SIZE>
+    void idct_patch(F32 *block, const F32 *icosines, S32 rows, S32 cols)
     {
-        gCurrentDeSize = size;
-        build_patch_dequantize_table(size);
-        setup_patch_icosines(size);
-        build_decopy_matrix(size);
-    }
-}
+        const S32 VECS = SIZE/4;
+        const S32 col_vecs = (cols + 3)/4;
+        const __m128 oosob = _mm_set1_ps(2.f/SIZE);
 
-inline void idct_line(F32 *linein, F32 *lineout, S32 line)
-{
-    S32 n;
-    F32 total;
-    F32 *pcp = gPatchICosines;
-
-#ifdef _PATCH_SIZE_16_AND_32_ONLY
-    F32 oosob = 2.f/16.f;
-    S32 line_size = line*NORMAL_PATCH_SIZE;
-    F32 *tlinein, *tpcp;
+        alignas(16) F32 temp[SIZE*SIZE];
+        __m128 acc[VECS];
 
-
-    for (n = 0; n < NORMAL_PATCH_SIZE; n++)
-    {
-        tpcp = pcp + n;
-        tlinein = linein + line_size;
-
-        total = OO_SQRT2*(*(tlinein++));
-        total += *(tlinein++)*(*(tpcp += NORMAL_PATCH_SIZE));
-        total += *(tlinein++)*(*(tpcp += NORMAL_PATCH_SIZE));
-        total += *(tlinein++)*(*(tpcp += NORMAL_PATCH_SIZE));
-
-        total += *(tlinein++)*(*(tpcp += NORMAL_PATCH_SIZE));
-        total += *(tlinein++)*(*(tpcp += NORMAL_PATCH_SIZE));
-        total += *(tlinein++)*(*(tpcp += NORMAL_PATCH_SIZE));
-        total += *(tlinein++)*(*(tpcp += NORMAL_PATCH_SIZE));
-
-        total += *(tlinein++)*(*(tpcp += NORMAL_PATCH_SIZE));
-        total += *(tlinein++)*(*(tpcp += NORMAL_PATCH_SIZE));
-        total += *(tlinein++)*(*(tpcp += NORMAL_PATCH_SIZE));
-        total += *(tlinein++)*(*(tpcp += NORMAL_PATCH_SIZE));
-
-        total += *(tlinein++)*(*(tpcp += NORMAL_PATCH_SIZE));
-        total += *(tlinein++)*(*(tpcp += NORMAL_PATCH_SIZE));
-        total += *(tlinein++)*(*(tpcp += NORMAL_PATCH_SIZE));
-        total += *(tlinein)*(*(tpcp += NORMAL_PATCH_SIZE));
-
-        *(lineout + line_size + n) = total*oosob;
-    }
-#else
-    F32 oosob = 2.f/size;
-    S32 size = gGOPP->patch_size;
-    S32 line_size = line*size;
-    S32 u;
-    for (n = 0; n < size; n++)
-    {
-        total = OO_SQRT2*linein[line_size];
-        for (u = 1; u < size; u++)
+        // columns: temp[n][c] = sum(u) block[u][c]*icosines[u][n], only
+        // the first cols columns are used by the second pass
+        for (S32 n = 0; n < SIZE; n++)
         {
-            total += linein[line_size + u]*pcp[u*size+n];
+            __m128 k = _mm_set1_ps(icosines[n]);
+            for (S32 v = 0; v < col_vecs; v++)
+            {
+                acc[v] = _mm_mul_ps(_mm_load_ps(block + v*4), k);
+            }
+            for (S32 u = 1; u < rows; u++)
+            {
+                const F32 *line = block + u*SIZE;
+                k = _mm_set1_ps(icosines[u*SIZE + n]);
+                for (S32 v = 0; v < col_vecs; v++)
+                {
+                    acc[v] = _mm_add_ps(acc[v], _mm_mul_ps(_mm_load_ps(line + v*4), k));
+                }
+            }
+            for (S32 v = 0; v < col_vecs; v++)
+            {
+                _mm_store_ps(temp + n*SIZE + v*4, acc[v]);
+            }
         }
-        lineout[line_size + n] = total*oosob;
-    }
-#endif
-}
-
-inline void idct_line_large_slow(F32 *linein, F32 *lineout, S32 line)
-{
-    S32 n;
-    F32 total;
-    F32 *pcp = gPatchICosines;
-
-    F32 oosob = 2.f/32.f;
-    S32 line_size = line*LARGE_PATCH_SIZE;
-    F32 *tlinein, *tpcp;
-
-
-    for (n = 0; n < LARGE_PATCH_SIZE; n++)
-    {
-        tpcp = pcp + n;
-        tlinein = linein + line_size;
-
-        total = OO_SQRT2*(*(tlinein++));
-        total += *(tlinein++)*(*(tpcp += LARGE_PATCH_SIZE));
-        total += *(tlinein++)*(*(tpcp += LARGE_PATCH_SIZE));
-        total += *(tlinein++)*(*(tpcp += LARGE_PATCH_SIZE));
-
-        total += *(tlinein++)*(*(tpcp += LARGE_PATCH_SIZE));
-        total += *(tlinein++)*(*(tpcp += LARGE_PATCH_SIZE));
-        total += *(tlinein++)*(*(tpcp += LARGE_PATCH_SIZE));
-        total += *(tlinein++)*(*(tpcp += LARGE_PATCH_SIZE));
-
-        total += *(tlinein++)*(*(tpcp += LARGE_PATCH_SIZE));
-        total += *(tlinein++)*(*(tpcp += LARGE_PATCH_SIZE));
-        total += *(tlinein++)*(*(tpcp += LARGE_PATCH_SIZE));
-        total += *(tlinein++)*(*(tpcp += LARGE_PATCH_SIZE));
-
-        total += *(tlinein++)*(*(tpcp += LARGE_PATCH_SIZE));
-        total += *(tlinein++)*(*(tpcp += LARGE_PATCH_SIZE));
-        total += *(tlinein++)*(*(tpcp += LARGE_PATCH_SIZE));
-        total += *(tlinein++)*(*(tpcp += LARGE_PATCH_SIZE));
-
-        total += *(tlinein++)*(*(tpcp += LARGE_PATCH_SIZE));
-        total += *(tlinein++)*(*(tpcp += LARGE_PATCH_SIZE));
-        total += *(tlinein++)*(*(tpcp += LARGE_PATCH_SIZE));
-        total += *(tlinein++)*(*(tpcp += LARGE_PATCH_SIZE));
-
-        total += *(tlinein++)*(*(tpcp += LARGE_PATCH_SIZE));
-        total += *(tlinein++)*(*(tpcp += LARGE_PATCH_SIZE));
-        total += *(tlinein++)*(*(tpcp += LARGE_PATCH_SIZE));
-        total += *(tlinein++)*(*(tpcp += LARGE_PATCH_SIZE));
-
-        total += *(tlinein++)*(*(tpcp += LARGE_PATCH_SIZE));
-        total += *(tlinein++)*(*(tpcp += LARGE_PATCH_SIZE));
-        total += *(tlinein++)*(*(tpcp += LARGE_PATCH_SIZE));
-        total += *(tlinein++)*(*(tpcp += LARGE_PATCH_SIZE));
-
-        total += *(tlinein++)*(*(tpcp += LARGE_PATCH_SIZE));
-        total += *(tlinein++)*(*(tpcp += LARGE_PATCH_SIZE));
-        total += *(tlinein++)*(*(tpcp += LARGE_PATCH_SIZE));
-        total += *(tlinein)*(*(tpcp += LARGE_PATCH_SIZE));
-
-        *(lineout + line_size + n) = total*oosob;
-    }
-}
-
-// Nota Bene: assumes that coefficients beyond 128 are 0!
-
-void idct_line_large(F32 *linein, F32 *lineout, S32 line)
-{
-    S32 n;
-    F32 total;
-    F32 *pcp = gPatchICosines;
-
-    F32 oosob = 2.f/32.f;
-    S32 line_size = line*LARGE_PATCH_SIZE;
-    F32 *tlinein, *tpcp;
-    F32 *baselinein = linein + line_size;
-    F32 *baselineout = lineout + line_size;
-
-
-    for (n = 0; n < LARGE_PATCH_SIZE; n++)
-    {
-        tpcp = pcp++;
-        tlinein = baselinein;
-
-        total = OO_SQRT2*(*(tlinein++));
-        total += *(tlinein++)*(*(tpcp += LARGE_PATCH_SIZE));
-        total += *(tlinein++)*(*(tpcp += LARGE_PATCH_SIZE));
-        total += *(tlinein++)*(*(tpcp += LARGE_PATCH_SIZE));
-
-        total += *(tlinein++)*(*(tpcp += LARGE_PATCH_SIZE));
-        total += *(tlinein++)*(*(tpcp += LARGE_PATCH_SIZE));
-        total += *(tlinein++)*(*(tpcp += LARGE_PATCH_SIZE));
-        total += *(tlinein++)*(*(tpcp += LARGE_PATCH_SIZE));
-
-        total += *(tlinein++)*(*(tpcp += LARGE_PATCH_SIZE));
-        total += *(tlinein++)*(*(tpcp += LARGE_PATCH_SIZE));
-        total += *(tlinein++)*(*(tpcp += LARGE_PATCH_SIZE));
-        total += *(tlinein++)*(*(tpcp += LARGE_PATCH_SIZE));
-
-        total += *(tlinein++)*(*(tpcp += LARGE_PATCH_SIZE));
-        total += *(tlinein++)*(*(tpcp += LARGE_PATCH_SIZE));
-        total += *(tlinein++)*(*(tpcp += LARGE_PATCH_SIZE));
-        total += *(tlinein)*(*(tpcp));
-
-        *baselineout++ = total*oosob;
-    }
-}
-
-inline void idct_column(F32 *linein, F32 *lineout, S32 column)
-{
-    S32 n;
-    F32 total;
-    F32 *pcp = gPatchICosines;
-
-#ifdef _PATCH_SIZE_16_AND_32_ONLY
-    F32 *tlinein, *tpcp;
-
-    for (n = 0; n < NORMAL_PATCH_SIZE; n++)
-    {
-        tpcp = pcp + n;
-        tlinein = linein + column;
-
-        total = OO_SQRT2*(*tlinein);
-        total += *(tlinein += NORMAL_PATCH_SIZE)*(*(tpcp += NORMAL_PATCH_SIZE));
-        total += *(tlinein += NORMAL_PATCH_SIZE)*(*(tpcp += NORMAL_PATCH_SIZE));
-        total += *(tlinein += NORMAL_PATCH_SIZE)*(*(tpcp += NORMAL_PATCH_SIZE));
-
-        total += *(tlinein += NORMAL_PATCH_SIZE)*(*(tpcp += NORMAL_PATCH_SIZE));
-        total += *(tlinein += NORMAL_PATCH_SIZE)*(*(tpcp += NORMAL_PATCH_SIZE));
-        total += *(tlinein += NORMAL_PATCH_SIZE)*(*(tpcp += NORMAL_PATCH_SIZE));
-        total += *(tlinein += NORMAL_PATCH_SIZE)*(*(tpcp += NORMAL_PATCH_SIZE));
-
-        total += *(tlinein += NORMAL_PATCH_SIZE)*(*(tpcp += NORMAL_PATCH_SIZE));
-        total += *(tlinein += NORMAL_PATCH_SIZE)*(*(tpcp += NORMAL_PATCH_SIZE));
-        total += *(tlinein += NORMAL_PATCH_SIZE)*(*(tpcp += NORMAL_PATCH_SIZE));
-        total += *(tlinein += NORMAL_PATCH_SIZE)*(*(tpcp += NORMAL_PATCH_SIZE));
-
-        total += *(tlinein += NORMAL_PATCH_SIZE)*(*(tpcp += NORMAL_PATCH_SIZE));
-        total += *(tlinein += NORMAL_PATCH_SIZE)*(*(tpcp += NORMAL_PATCH_SIZE));
-        total += *(tlinein += NORMAL_PATCH_SIZE)*(*(tpcp += NORMAL_PATCH_SIZE));
-        total += *(tlinein += NORMAL_PATCH_SIZE)*(*(tpcp += NORMAL_PATCH_SIZE));
-
-        *(lineout + (n<<4) + column) = total;
-    }
-
-#else
-    S32 size = gGOPP->patch_size;
-    S32 u;
-    S32 u_size;
 
-    for (n = 0; n < size; n++)
-    {
-        total = OO_SQRT2*linein[column];
-        for (u = 1; u < size; u++)
+        // lines: block[l][n] = sum(u) temp[l][u]*icosines[u][n]
+        for (S32 l = 0; l < SIZE; l++)
         {
-            u_size = u*size;
-            total += linein[u_size + column]*pcp[u_size+n];
+            const F32 *line = temp + l*SIZE;
+            __m128 t = _mm_set1_ps(line[0]);
+            for (S32 v = 0; v < VECS; v++)
+            {
+                acc[v] = _mm_mul_ps(t, _mm_load_ps(icosines + v*4));
+            }
+            for (S32 u = 1; u < cols; u++)
+            {
+                const F32 *k = icosines + u*SIZE;
+                t = _mm_set1_ps(line[u]);
+                for (S32 v = 0; v < VECS; v++)
+                {
+                    acc[v] = _mm_add_ps(acc[v], _mm_mul_ps(t, _mm_load_ps(k + v*4)));
+                }
+            }
+            for (S32 v = 0; v < VECS; v++)
+            {
+                _mm_store_ps(block + l*SIZE + v*4, _mm_mul_ps(acc[v], oosob));
+            }
         }
-        lineout[size*n + column] = total;
     }
-#endif
 }
 
-inline void idct_column_large_slow(F32 *linein, F32 *lineout, S32 column)
+LLPatchDecoder::LLPatchDecoder()
+:   mTables(NULL),
+    mPatchSize(0),
+    mStride(0)
 {
-    S32 n;
-    F32 total;
-    F32 *pcp = gPatchICosines;
-
-    F32 *tlinein, *tpcp;
-
-    for (n = 0; n < LARGE_PATCH_SIZE; n++)
-    {
-        tpcp = pcp + n;
-        tlinein = linein + column;
-
-        total = OO_SQRT2*(*tlinein);
-        total += *(tlinein += LARGE_PATCH_SIZE)*(*(tpcp += LARGE_PATCH_SIZE));
-        total += *(tlinein += LARGE_PATCH_SIZE)*(*(tpcp += LARGE_PATCH_SIZE));
-        total += *(tlinein += LARGE_PATCH_SIZE)*(*(tpcp += LARGE_PATCH_SIZE));
-
-        total += *(tlinein += LARGE_PATCH_SIZE)*(*(tpcp += LARGE_PATCH_SIZE));
-        total += *(tlinein += LARGE_PATCH_SIZE)*(*(tpcp += LARGE_PATCH_SIZE));
-        total += *(tlinein += LARGE_PATCH_SIZE)*(*(tpcp += LARGE_PATCH_SIZE));
-        total += *(tlinein += LARGE_PATCH_SIZE)*(*(tpcp += LARGE_PATCH_SIZE));
-
-        total += *(tlinein += LARGE_PATCH_SIZE)*(*(tpcp += LARGE_PATCH_SIZE));
-        total += *(tlinein += LARGE_PATCH_SIZE)*(*(tpcp += LARGE_PATCH_SIZE));
-        total += *(tlinein += LARGE_PATCH_SIZE)*(*(tpcp += LARGE_PATCH_SIZE));
-        total += *(tlinein += LARGE_PATCH_SIZE)*(*(tpcp += LARGE_PATCH_SIZE));
-
-        total += *(tlinein += LARGE_PATCH_SIZE)*(*(tpcp += LARGE_PATCH_SIZE));
-        total += *(tlinein += LARGE_PATCH_SIZE)*(*(tpcp += LARGE_PATCH_SIZE));
-        total += *(tlinein += LARGE_PATCH_SIZE)*(*(tpcp += LARGE_PATCH_SIZE));
-        total += *(tlinein += LARGE_PATCH_SIZE)*(*(tpcp += LARGE_PATCH_SIZE));
-
-        total += *(tlinein += LARGE_PATCH_SIZE)*(*(tpcp += LARGE_PATCH_SIZE));
-        total += *(tlinein += LARGE_PATCH_SIZE)*(*(tpcp += LARGE_PATCH_SIZE));
-        total += *(tlinein += LARGE_PATCH_SIZE)*(*(tpcp += LARGE_PATCH_SIZE));
-        total += *(tlinein += LARGE_PATCH_SIZE)*(*(tpcp += LARGE_PATCH_SIZE));
-
-        total += *(tlinein += LARGE_PATCH_SIZE)*(*(tpcp += LARGE_PATCH_SIZE));
-        total += *(tlinein += LARGE_PATCH_SIZE)*(*(tpcp += LARGE_PATCH_SIZE));
-        total += *(tlinein += LARGE_PATCH_SIZE)*(*(tpcp += LARGE_PATCH_SIZE));
-        total += *(tlinein += LARGE_PATCH_SIZE)*(*(tpcp += LARGE_PATCH_SIZE));
-
-        total += *(tlinein += LARGE_PATCH_SIZE)*(*(tpcp += LARGE_PATCH_SIZE));
-        total += *(tlinein += LARGE_PATCH_SIZE)*(*(tpcp += LARGE_PATCH_SIZE));
-        total += *(tlinein += LARGE_PATCH_SIZE)*(*(tpcp += LARGE_PATCH_SIZE));
-        total += *(tlinein += LARGE_PATCH_SIZE)*(*(tpcp += LARGE_PATCH_SIZE));
-
-        total += *(tlinein += LARGE_PATCH_SIZE)*(*(tpcp += LARGE_PATCH_SIZE));
-        total += *(tlinein += LARGE_PATCH_SIZE)*(*(tpcp += LARGE_PATCH_SIZE));
-        total += *(tlinein += LARGE_PATCH_SIZE)*(*(tpcp += LARGE_PATCH_SIZE));
-        total += *(tlinein += LARGE_PATCH_SIZE)*(*(tpcp += LARGE_PATCH_SIZE));
-
-        *(lineout + (n<<5) + column) = total;
-    }
 }
 
-// Nota Bene: assumes that coefficients beyond 128 are 0!
-
-void idct_column_large(F32 *linein, F32 *lineout, S32 column)
+// static
+const LLPatchDecoder::Tables *LLPatchDecoder::getTables(S32 size)
 {
-    S32 n, m;
-    F32 total;
-    F32 *pcp = gPatchICosines;
-
-    F32 *tlinein, *tpcp;
-    F32 *baselinein = linein + column;
-    F32 *baselineout = lineout + column;
+    // built by the first decoder that needs them, whatever the thread
+    static const Tables normal_tables(NORMAL_PATCH_SIZE);
+    static const Tables large_tables(LARGE_PATCH_SIZE);
 
-    for (n = 0; n < LARGE_PATCH_SIZE; n++)
+    if (size == NORMAL_PATCH_SIZE)
     {
-        tpcp = pcp++;
-        tlinein = baselinein;
-
-        total = OO_SQRT2*(*tlinein);
-        for (m = 1; m < NORMAL_PATCH_SIZE; m++)
-            total += *(tlinein += LARGE_PATCH_SIZE)*(*(tpcp += LARGE_PATCH_SIZE));
-
-        *(baselineout + (n<<5)) = total;
+        return &normal_tables;
     }
-}
-
-inline void idct_patch(F32 *block)
-{
-    F32 temp[LARGE_PATCH_SIZE*LARGE_PATCH_SIZE];
-
-#ifdef _PATCH_SIZE_16_AND_32_ONLY
-    idct_column(block, temp, 0);
-    idct_column(block, temp, 1);
-    idct_column(block, temp, 2);
-    idct_column(block, temp, 3);
-
-    idct_column(block, temp, 4);
-    idct_column(block, temp, 5);
-    idct_column(block, temp, 6);
-    idct_column(block, temp, 7);
-
-    idct_column(block, temp, 8);
-    idct_column(block, temp, 9);
-    idct_column(block, temp, 10);
-    idct_column(block, temp, 11);
-
-    idct_column(block, temp, 12);
-    idct_column(block, temp, 13);
-    idct_column(block, temp, 14);
-    idct_column(block, temp, 15);
-
-    idct_line(temp, block, 0);
-    idct_line(temp, block, 1);
-    idct_line(temp, block, 2);
-    idct_line(temp, block, 3);
-
-    idct_line(temp, block, 4);
-    idct_line(temp, block, 5);
-    idct_line(temp, block, 6);
-    idct_line(temp, block, 7);
-
-    idct_line(temp, block, 8);
-    idct_line(temp, block, 9);
-    idct_line(temp, block, 10);
-    idct_line(temp, block, 11);
-
-    idct_line(temp, block, 12);
-    idct_line(temp, block, 13);
-    idct_line(temp, block, 14);
-    idct_line(temp, block, 15);
-#else
-    S32 i;
-    S32 size = gGOPP->patch_size;
-    for (i = 0; i < size; i++)
-    {
-        idct_column(block, temp, i);
-    }
-    for (i = 0; i < size; i++)
+    if (size == LARGE_PATCH_SIZE)
     {
-        idct_line(temp, block, i);
+        return &large_tables;
     }
-#endif
+    return NULL;
 }
 
-inline void idct_patch_large(F32 *block)
+bool LLPatchDecoder::setGroupHeader(const LLGroupHeader &goph)
 {
-    F32 temp[LARGE_PATCH_SIZE*LARGE_PATCH_SIZE];
-
-    idct_column_large_slow(block, temp, 0);
-    idct_column_large_slow(block, temp, 1);
-    idct_column_large_slow(block, temp, 2);
-    idct_column_large_slow(block, temp, 3);
-
-    idct_column_large_slow(block, temp, 4);
-    idct_column_large_slow(block, temp, 5);
-    idct_column_large_slow(block, temp, 6);
-    idct_column_large_slow(block, temp, 7);
-
-    idct_column_large_slow(block, temp, 8);
-    idct_column_large_slow(block, temp, 9);
-    idct_column_large_slow(block, temp, 10);
-    idct_column_large_slow(block, temp, 11);
-
-    idct_column_large_slow(block, temp, 12);
-    idct_column_large_slow(block, temp, 13);
-    idct_column_large_slow(block, temp, 14);
-    idct_column_large_slow(block, temp, 15);
-
-    idct_column_large_slow(block, temp, 16);
-    idct_column_large_slow(block, temp, 17);
-    idct_column_large_slow(block, temp, 18);
-    idct_column_large_slow(block, temp, 19);
-
-    idct_column_large_slow(block, temp, 20);
-    idct_column_large_slow(block, temp, 21);
-    idct_column_large_slow(block, temp, 22);
-    idct_column_large_slow(block, temp, 23);
-
-    idct_column_large_slow(block, temp, 24);
-    idct_column_large_slow(block, temp, 25);
-    idct_column_large_slow(block, temp, 26);
-    idct_column_large_slow(block, temp, 27);
-
-    idct_column_large_slow(block, temp, 28);
-    idct_column_large_slow(block, temp, 29);
-    idct_column_large_slow(block, temp, 30);
-    idct_column_large_slow(block, temp, 31);
-
-    idct_line_large_slow(temp, block, 0);
-    idct_line_large_slow(temp, block, 1);
-    idct_line_large_slow(temp, block, 2);
-    idct_line_large_slow(temp, block, 3);
-
-    idct_line_large_slow(temp, block, 4);
-    idct_line_large_slow(temp, block, 5);
-    idct_line_large_slow(temp, block, 6);
-    idct_line_large_slow(temp, block, 7);
-
-    idct_line_large_slow(temp, block, 8);
-    idct_line_large_slow(temp, block, 9);
-    idct_line_large_slow(temp, block, 10);
-    idct_line_large_slow(temp, block, 11);
-
-    idct_line_large_slow(temp, block, 12);
-    idct_line_large_slow(temp, block, 13);
-    idct_line_large_slow(temp, block, 14);
-    idct_line_large_slow(temp, block, 15);
-
-    idct_line_large_slow(temp, block, 16);
-    idct_line_large_slow(temp, block, 17);
-    idct_line_large_slow(temp, block, 18);
-    idct_line_large_slow(temp, block, 19);
-
-    idct_line_large_slow(temp, block, 20);
-    idct_line_large_slow(temp, block, 21);
-    idct_line_large_slow(temp, block, 22);
-    idct_line_large_slow(temp, block, 23);
-
-    idct_line_large_slow(temp, block, 24);
-    idct_line_large_slow(temp, block, 25);
-    idct_line_large_slow(temp, block, 26);
-    idct_line_large_slow(temp, block, 27);
-
-    idct_line_large_slow(temp, block, 28);
-    idct_line_large_slow(temp, block, 29);
-    idct_line_large_slow(temp, block, 30);
-    idct_line_large_slow(temp, block, 31);
+    mTables = getTables(goph.patch_size);
+    mPatchSize = mTables ? goph.patch_size : 0;
+    mStride = goph.stride;
+    return mTables != NULL;
 }
 
-S32 gDitherNoise = 128;
+void LLPatchDecoder::decodePatch(LLBitPack &bitpack, const LLPatchHeader &ph, F32 *patch) const
+{
+    S32 cpatch[LARGE_PATCH_SIZE*LARGE_PATCH_SIZE];
+    unpack_patch(bitpack, cpatch, mPatchSize, (ph.quant_wbits & 0xf) + 2);
+    decompressPatch(patch, cpatch, ph);
+}
 
-void decompress_patch(F32 *patch, S32 *cpatch, LLPatchHeader *ph)
+void LLPatchDecoder::decompressPatch(F32 *patch, const S32 *cpatch, const LLPatchHeader &ph) const
 {
-    S32     i, j;
+    llassert(mTables);
 
-    F32     block[LARGE_PATCH_SIZE*LARGE_PATCH_SIZE], *tblock = block;
-    F32     *tpatch;
+    alignas(16) F32 block[LARGE_PATCH_SIZE*LARGE_PATCH_SIZE];
 
-    LLGroupHeader   *gopp = gGOPP;
-    S32     size = gopp->patch_size;
-    F32     range = ph->range;
-    S32     prequant = (ph->quant_wbits >> 4) + 2;
+    S32     size = mPatchSize;
+    F32     range = ph.range;
+    S32     prequant = (ph.quant_wbits >> 4) + 2;
     S32     quantize = 1<<prequant;
-    F32     hmin = ph->dc_offset;
-    S32     stride = gopp->stride;
+    F32     hmin = ph.dc_offset;
 
     F32     ooq = 1.f/(F32)quantize;
-    F32     *dq = gPatchDequantizeTable;
-    S32     *decopy_matrix = gDeCopyMatrix;
+    const F32   *dq = mTables->mDequantize;
+    const S32   *decopy_matrix = mTables->mDeCopy;
 
     F32     mult = ooq*range;
     F32     addval = mult*(F32)(1<<(prequant - 1))+hmin;
 
-    for (i = 0; i < size*size; i++)
+    F32     *tblock = block;
+    for (S32 i = 0; i < size*size; i++)
     {
         *(tblock++) = *(cpatch + *(decopy_matrix++))*(*dq++);
     }
 
-    if (size == 16)
+    // The high frequencies are mostly zero (the encoder ends the patch at
+    // the last non zero one), the transform skips the rows and columns
+    // past the last non zero coefficient.
+    S32 last = size*size - 1;
+    while (last > 0 && !cpatch[last])
     {
-        idct_patch(block);
+        last--;
+    }
+    S32 rows = mTables->mRows[last];
+    S32 cols = mTables->mCols[last];
+
+    if (size == NORMAL_PATCH_SIZE)
+    {
+        idct_patch<NORMAL_PATCH_SIZE>(block, mTables->mICosines, rows, cols);
     }
     else
     {
-        idct_patch_large(block);
+        idct_patch<LARGE_PATCH_SIZE>(block, mTables->mICosines, rows, cols);
     }
 
-    for (j = 0; j < size; j++)
+    const __m128 mult4 = _mm_set1_ps(mult);
+    const __m128 addval4 = _mm_set1_ps(addval);
+    for (S32 j = 0; j < size; j++)
     {
-        tpatch = patch + j*stride;
-        tblock = block + j*size;
-        for (i = 0; i < size; i++)
+        F32 *tpatch = patch + j*mStride;
+        const F32 *tblock = block + j*size;
+        for (S32 i = 0; i < size; i += 4)
         {
-            *(tpatch++) = *(tblock++)*mult+addval;
+            _mm_storeu_ps(tpatch + i, _mm_add_ps(_mm_mul_ps(_mm_load_ps(tblock + i), mult4), addval4));
         }
     }
 }
 
+void decompress_patch(F32 *patch, S32 *cpatch, LLPatchHeader *ph)
+{
+    LLPatchDecoder decoder;
+    if (decoder.setGroupHeader(*gGOPP))
+    {
+        decoder.decompressPatch(patch, cpatch, *ph);
+    }
+}
+
 
 void decompress_patchv(LLVector3 *v, S32 *cpatch, LLPatchHeader *ph)
 {
     S32     i, j;
 
-    F32         block[LARGE_PATCH_SIZE*LARGE_PATCH_SIZE], *tblock = block;
+    F32         block[LARGE_PATCH_SIZE*LARGE_PATCH_SIZE], *tblock;
     LLVector3   *tvec;
 
-    LLGroupHeader   *gopp = gGOPP;
-    S32     size = gopp->patch_size;
-    F32     range = ph->range;
-    S32     prequant = (ph->quant_wbits >> 4) + 2;
-    S32     quantize = 1<<prequant;
-    F32     hmin = ph->dc_offset;
-    S32     stride = gopp->stride;
-
-    F32     ooq = 1.f/(F32)quantize;
-    F32     *dq = gPatchDequantizeTable;
-    S32     *decopy_matrix = gDeCopyMatrix;
-
-    F32     mult = ooq*range;
-    F32     addval = mult*(F32)(1<<(prequant - 1))+hmin;
-
-//  BOOL    b_diag = FALSE;
-//  BOOL    b_right = TRUE;
+    LLGroupHeader   block_header = *gGOPP;
+    S32     size = block_header.patch_size;
+    S32     stride = block_header.stride;
 
-    for (i = 0; i < size*size; i++)
+    // decompress to a packed block, then spread it over the vectors
+    block_header.stride = size;
+    LLPatchDecoder decoder;
+    if (!decoder.setGroupHeader(block_header))
     {
-        *(tblock++) = *(cpatch + *(decopy_matrix++))*(*dq++);
+        return;
     }
-
-    if (size == 16)
-        idct_patch(block);
-    else
-        idct_patch_large(block);
+    decoder.decompressPatch(block, cpatch, *ph);
 
     for (j = 0; j < size; j++)
     {
@@ -677,8 +341,7 @@ void decompress_patchv(LLVector3 *v, S32 *cpatch, LLPatchHeader *ph)
         tblock = block + j*size;
         for (i = 0; i < size; i++)
         {
-            (*tvec++).mV[VZ] = *(tblock++)*mult+addval;
+            (*tvec++).mV[VZ] = *(tblock++);
         }
     }
 }
-
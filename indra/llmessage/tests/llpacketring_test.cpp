@@ -0,0 +1,236 @@
+/**
+ * @file llpacketring_test.cpp
+ * @brief Loopback tests for the LLPacketRing receive thread
+ *
+ * $LicenseInfo:firstyear=2024&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2024, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#include "linden_common.h"
+
+#include "../llpacketring.h"
+#include "llstring.h"
+#include "lltimer.h"
+
+#include "../test/lltut.h"
+
+#include <atomic>
+#include <thread>
+
+namespace
+{
+    const S32 PACKET_COUNT = 2000;
+    const S32 PACKET_SIZE = 1000;       // about what a busy region sends
+    const S32 PACKETS_PER_MS = 4;
+
+    // the "main thread" runs 16 ms frames and stalls for 200 ms every 10th
+    const U32 FRAME_MS = 16;
+    const U32 STALL_MS = 200;
+    const S32 STALL_EVERY = 10;
+
+    struct LoopbackStats
+    {
+        S32 mReceived = 0;
+        S32 mOutOfOrder = 0;
+        F64 mTotalLatency = 0.0;
+        F64 mMaxLatency = 0.0;
+    };
+
+    struct TimedPacket
+    {
+        U32 mSequence;
+        U64 mSentUsec;
+    };
+}
+
+namespace tut
+{
+    struct packetring_data
+    {
+        packetring_data()
+            : mReceiveSocket(-1),
+              mSendSocket(-1),
+              mReceivePort(NET_USE_OS_ASSIGNED_PORT),
+              mSendPort(NET_USE_OS_ASSIGNED_PORT)
+        {
+            mReady = !start_net(mReceiveSocket, mReceivePort)
+                && !start_net(mSendSocket, mSendPort);
+        }
+
+        ~packetring_data()
+        {
+            end_net(mSendSocket);
+            end_net(mReceiveSocket);
+        }
+
+        // Sends PACKET_COUNT stamped packets to the receive socket from a
+        // thread of their own while this one runs frames, stalls and drains
+        // ring the way LLMessageSystem::checkMessages() would.
+        LoopbackStats runLoopback(LLPacketRing& ring)
+        {
+            std::atomic<bool> sent(false);
+            std::thread sender([this, &sent]()
+            {
+                const U32 loopback = ip_string_to_u32(LOOPBACK_ADDRESS_STRING);
+                char buffer[PACKET_SIZE] = {};
+                for (S32 i = 0; i < PACKET_COUNT; ++i)
+                {
+                    TimedPacket stamp = { (U32)i, totalTime() };
+                    memcpy(buffer, &stamp, sizeof(stamp));
+                    send_packet(mSendSocket, buffer, PACKET_SIZE, loopback, mReceivePort);
+                    if (i % PACKETS_PER_MS == PACKETS_PER_MS - 1)
+                    {
+                        ms_sleep(1);
+                    }
+                }
+                sent = true;
+            });
+
+            LoopbackStats stats;
+            char buffer[NET_BUFFER_SIZE];
+            S32 next_sequence = 0;
+            LLTimer drain_timer;
+            for (S32 frame = 1; !sent || drain_timer.getElapsedTimeF32() < 1.f; ++frame)
+            {
+                if (!sent)
+                {
+                    drain_timer.reset();
+                }
+                ms_sleep(frame % STALL_EVERY ? FRAME_MS : STALL_MS);
+
+                S32 size;
+                while ((size = ring.receivePacket(mReceiveSocket, buffer)) > 0)
+                {
+                    TimedPacket stamp;
+                    memcpy(&stamp, buffer, sizeof(stamp));
+                    F64 latency = (F64)(totalTime() - stamp.mSentUsec) / 1000.0;
+                    stats.mTotalLatency += latency;
+                    stats.mMaxLatency = llmax(stats.mMaxLatency, latency);
+                    if ((S32)stamp.mSequence < next_sequence)
+                    {
+                        ++stats.mOutOfOrder;
+                    }
+                    next_sequence = (S32)stamp.mSequence + 1;
+                    ++stats.mReceived;
+                }
+            }
+
+            sender.join();
+            return stats;
+        }
+
+        void report(const char* name, const LoopbackStats& stats)
+        {
+            LL_INFOS() << name << ": " << PACKET_COUNT - stats.mReceived << " of " << PACKET_COUNT
+                       << " packets lost, latency mean " << stats.mTotalLatency / llmax(stats.mReceived, 1)
+                       << " ms max " << stats.mMaxLatency << " ms" << LL_ENDL;
+        }
+
+        S32 mReceiveSocket;
+        S32 mSendSocket;
+        S32 mReceivePort;
+        S32 mSendPort;
+        bool mReady;
+    };
+
+    typedef test_group<packetring_data> packetring_test;
+    typedef packetring_test::object packetring_object;
+    tut::packetring_test packetring_testcase("LLPacketRing");
+
+    template<> template<>
+    void packetring_object::test<1>()
+    {
+        set_test_name("receive thread drains the socket in order");
+        ensure("sockets", mReady);
+
+        LLPacketRing ring;
+        ring.startReceiveThread(mReceiveSocket);
+
+        // few enough packets that the socket buffer alone would hold them,
+        // nothing here depends on how fast either side runs
+        const S32 count = 100;
+        const U32 loopback = ip_string_to_u32(LOOPBACK_ADDRESS_STRING);
+        char buffer[NET_BUFFER_SIZE] = {};
+        for (S32 i = 0; i < count; ++i)
+        {
+            TimedPacket stamp = { (U32)i, 0 };
+            memcpy(buffer, &stamp, sizeof(stamp));
+            send_packet(mSendSocket, buffer, PACKET_SIZE, loopback, mReceivePort);
+        }
+
+        // wait for the receive thread to queue them, without reading
+        LLTimer timer;
+        while (ring.getQueuedPacketCount() < (U32)count && timer.getElapsedTimeF32() < 10.f)
+        {
+            ms_sleep(1);
+        }
+        const S32 queued = (S32)ring.getQueuedPacketCount();
+        ensure("queued some", queued > 0);
+
+        S32 received = 0;
+        S32 next_sequence = 0;
+        S32 bytes = 0;
+        S32 size;
+        while ((size = ring.receivePacket(mReceiveSocket, buffer)) > 0)
+        {
+            TimedPacket stamp;
+            memcpy(&stamp, buffer, sizeof(stamp));
+            ensure("in order", (S32)stamp.mSequence >= next_sequence);
+            next_sequence = (S32)stamp.mSequence + 1;
+            bytes += size;
+            ++received;
+        }
+        ring.stopReceiveThread();
+
+        // the thread may have queued more while we read, never less
+        ensure("received what was queued", received >= queued);
+        ensure("received no more than sent", received <= count);
+        ensure_equals("bytes", bytes, received * PACKET_SIZE);
+    }
+
+    template<> template<>
+    void packetring_object::test<2>()
+    {
+        set_test_name("main thread stalls, receive thread vs main thread benchmark");
+
+        if (LLStringUtil::getenv("LL_BENCHMARK").empty())
+        {
+            skip("set LL_BENCHMARK to run");
+        }
+        ensure("sockets", mReady);
+
+        // Whatever outgrows the socket buffer during a stall is lost without
+        // the receive thread, how much depends on the platform and the load,
+        // so this only reports.
+        {
+            LLPacketRing ring;
+            ring.startReceiveThread(mReceiveSocket);
+            LoopbackStats stats = runLoopback(ring);
+            ring.stopReceiveThread();
+            report("Receive thread", stats);
+        }
+        {
+            LLPacketRing ring;
+            LoopbackStats stats = runLoopback(ring);
+            report("Main thread", stats);
+        }
+    }
+}
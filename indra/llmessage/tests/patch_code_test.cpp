@@ -0,0 +1,516 @@
+/**
+ * @file patch_code_test.cpp
+ * @brief Tests for the terrain patch coder and LLPatchDecoder
+ *
+ * $LicenseInfo:firstyear=2024&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2024, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#include "linden_common.h"
+
+#include "../patch_code.h"
+#include "../patch_dct.h"
+#include "llbitpack.h"
+#include "llformat.h"
+#include "llmath.h"
+#include "llstring.h"
+#include "lltimer.h"
+
+#include "../test/lltut.h"
+
+#include <thread>
+
+namespace
+{
+    const S32 PATCHES_PER_EDGE = 16;
+    const S32 GRIDS_PER_EDGE = PATCHES_PER_EDGE*NORMAL_PATCH_SIZE;
+
+    // Hills with some ripples on top, in meters
+    F32 terrain_height(S32 x, S32 y)
+    {
+        return 22.f + 15.f*sinf(x*0.05f)*cosf(y*0.07f) + 0.4f*sinf(x*0.9f + y*0.4f);
+    }
+
+    // Encodes the patches of a 256x256 region the way the simulator does,
+    // into one LayerData blob.
+    std::vector<U8> encode_region(const std::vector<F32> &heights)
+    {
+        std::vector<U8> buffer(256*1024);
+        LLBitPack bitpack(buffer.data(), (U32)buffer.size());
+
+        init_patch_compressor(NORMAL_PATCH_SIZE, GRIDS_PER_EDGE, 'L');
+        init_patch_coding(bitpack);
+        LLGroupHeader goph;
+        get_patch_group_header(&goph);
+        code_patch_group_header(bitpack, &goph);
+
+        S32 cpatch[LARGE_PATCH_SIZE*LARGE_PATCH_SIZE];
+        for (S32 j = 0; j < PATCHES_PER_EDGE; j++)
+        {
+            for (S32 i = 0; i < PATCHES_PER_EDGE; i++)
+            {
+                F32 *patch = const_cast<F32*>(&heights[j*NORMAL_PATCH_SIZE*GRIDS_PER_EDGE + i*NORMAL_PATCH_SIZE]);
+                LLPatchHeader ph;
+                F32 zmax, zmin;
+                prescan_patch(patch, &ph, zmax, zmin);
+                compress_patch(patch, cpatch, &ph, 10);
+                ph.patchids = (i << 5) | j;
+                code_patch_header(bitpack, &ph, cpatch);
+                code_patch(bitpack, cpatch, 0);
+            }
+        }
+        code_end_of_data(bitpack);
+        buffer.resize(bitpack.flushBitPack());
+        return buffer;
+    }
+
+    std::vector<F32> make_heights()
+    {
+        std::vector<F32> heights(GRIDS_PER_EDGE*GRIDS_PER_EDGE);
+        for (S32 y = 0; y < GRIDS_PER_EDGE; y++)
+        {
+            for (S32 x = 0; x < GRIDS_PER_EDGE; x++)
+            {
+                heights[y*GRIDS_PER_EDGE + x] = terrain_height(x, y);
+            }
+        }
+        return heights;
+    }
+
+    // Decodes a blob from encode_region() with its own decoder, returns
+    // the number of patches.
+    S32 decode_region(std::vector<U8> &data, std::vector<F32> &heights)
+    {
+        heights.assign(GRIDS_PER_EDGE*GRIDS_PER_EDGE, 0.f);
+        LLBitPack bitpack(data.data(), (U32)data.size());
+        LLGroupHeader goph;
+        unpack_patch_group_header(bitpack, &goph);
+        goph.stride = GRIDS_PER_EDGE;
+        LLPatchDecoder decoder;
+        if (!decoder.setGroupHeader(goph))
+        {
+            return 0;
+        }
+
+        S32 count = 0;
+        LLPatchHeader ph;
+        while (1)
+        {
+            unpack_patch_header(bitpack, &ph);
+            if (ph.quant_wbits == END_OF_PATCHES)
+            {
+                break;
+            }
+            S32 i = ph.patchids >> 5;
+            S32 j = ph.patchids & 0x1F;
+            decoder.decodePatch(bitpack, ph, &heights[j*NORMAL_PATCH_SIZE*GRIDS_PER_EDGE + i*NORMAL_PATCH_SIZE]);
+            count++;
+        }
+        return count;
+    }
+
+    // The decoder as it was before LLPatchDecoder, tables in globals
+    // and scalar transforms, kept here to check the new one against.
+    struct OldDecoder
+    {
+        S32 mSize;
+        F32 mDequantize[LARGE_PATCH_SIZE*LARGE_PATCH_SIZE];
+        F32 mICosines[LARGE_PATCH_SIZE*LARGE_PATCH_SIZE];
+        S32 mDeCopy[LARGE_PATCH_SIZE*LARGE_PATCH_SIZE];
+
+        OldDecoder(S32 size)
+        :   mSize(size)
+        {
+            S32 i, j, n, u;
+            for (j = 0; j < size; j++)
+            {
+                for (i = 0; i < size; i++)
+                {
+                    mDequantize[j*size + i] = (1.f + 2.f*(i+j));
+                }
+            }
+
+            F32 oosob = F_PI*0.5f/size;
+            for (u = 0; u < size; u++)
+            {
+                for (n = 0; n < size; n++)
+                {
+                    mICosines[u*size+n] = cosf((2.f*n+1.f)*u*oosob);
+                }
+            }
+
+            S32 count = 0;
+            BOOL    b_diag = FALSE;
+            BOOL    b_right = TRUE;
+            i = 0;
+            j = 0;
+            while (  (i < size)
+                   &&(j < size))
+            {
+                mDeCopy[j*size + i] = count;
+                count++;
+                if (!b_diag)
+                {
+                    if (b_right)
+                    {
+                        if (i < size - 1)
+                            i++;
+                        else
+                            j++;
+                        b_right = FALSE;
+                        b_diag = TRUE;
+                    }
+                    else
+                    {
+                        if (j < size - 1)
+                            j++;
+                        else
+                            i++;
+                        b_right = TRUE;
+                        b_diag = TRUE;
+                    }
+                }
+                else
+                {
+                    if (b_right)
+                    {
+                        i++;
+                        j--;
+                        if (  (i == size - 1)
+                            ||(j == 0))
+                        {
+                            b_diag = FALSE;
+                        }
+                    }
+                    else
+                    {
+                        i--;
+                        j++;
+                        if (  (i == 0)
+                            ||(j == size - 1))
+                        {
+                            b_diag = FALSE;
+                        }
+                    }
+                }
+            }
+        }
+
+        void idct_column(const F32 *linein, F32 *lineout, S32 column) const
+        {
+            for (S32 n = 0; n < mSize; n++)
+            {
+                F32 total = OO_SQRT2*linein[column];
+                for (S32 u = 1; u < mSize; u++)
+                {
+                    total += linein[u*mSize + column]*mICosines[u*mSize + n];
+                }
+                lineout[n*mSize + column] = total;
+            }
+        }
+
+        void idct_line(const F32 *linein, F32 *lineout, S32 line) const
+        {
+            F32 oosob = 2.f/mSize;
+            S32 line_size = line*mSize;
+            for (S32 n = 0; n < mSize; n++)
+            {
+                F32 total = OO_SQRT2*linein[line_size];
+                for (S32 u = 1; u < mSize; u++)
+                {
+                    total += linein[line_size + u]*mICosines[u*mSize + n];
+                }
+                lineout[line_size + n] = total*oosob;
+            }
+        }
+
+        void decompress_patch(F32 *patch, const S32 *cpatch, const LLPatchHeader &ph, S32 stride) const
+        {
+            F32 block[LARGE_PATCH_SIZE*LARGE_PATCH_SIZE];
+            F32 temp[LARGE_PATCH_SIZE*LARGE_PATCH_SIZE];
+
+            S32 prequant = (ph.quant_wbits >> 4) + 2;
+            S32 quantize = 1<<prequant;
+            F32 ooq = 1.f/(F32)quantize;
+            F32 mult = ooq*ph.range;
+            F32 addval = mult*(F32)(1<<(prequant - 1))+ph.dc_offset;
+
+            for (S32 i = 0; i < mSize*mSize; i++)
+            {
+                block[i] = cpatch[mDeCopy[i]]*mDequantize[i];
+            }
+            for (S32 i = 0; i < mSize; i++)
+            {
+                idct_column(block, temp, i);
+            }
+            for (S32 i = 0; i < mSize; i++)
+            {
+                idct_line(temp, block, i);
+            }
+            for (S32 j = 0; j < mSize; j++)
+            {
+                for (S32 i = 0; i < mSize; i++)
+                {
+                    patch[j*stride + i] = block[j*mSize + i]*mult+addval;
+                }
+            }
+        }
+    };
+
+    // Textbook inverse DCT with the scaling of the patch coder
+    void reference_idct(const F32 *coefficients, F64 *out, S32 size)
+    {
+        for (S32 y = 0; y < size; y++)
+        {
+            for (S32 x = 0; x < size; x++)
+            {
+                F64 total = 0.0;
+                for (S32 v = 0; v < size; v++)
+                {
+                    F64 cv = v ? cos((2.0*y + 1.0)*v*F_PI/(2.0*size)) : OO_SQRT2;
+                    for (S32 u = 0; u < size; u++)
+                    {
+                        F64 cu = u ? cos((2.0*x + 1.0)*u*F_PI/(2.0*size)) : OO_SQRT2;
+                        total += coefficients[v*size + u]*cu*cv;
+                    }
+                }
+                out[y*size + x] = total*2.0/size;
+            }
+        }
+    }
+}
+
+namespace tut
+{
+    struct patch_code_data
+    {
+    };
+    typedef test_group<patch_code_data> patch_code_test;
+    typedef patch_code_test::object patch_code_object;
+    tut::patch_code_test tpc("patch_code");
+
+    template<> template<>
+    void patch_code_object::test<1>()
+    {
+        set_test_name("round trip through the coder");
+
+        std::vector<F32> heights = make_heights();
+        std::vector<U8> data = encode_region(heights);
+
+        std::vector<F32> decoded;
+        ensure_equals("patches", decode_region(data, decoded), PATCHES_PER_EDGE*PATCHES_PER_EDGE);
+        F32 max_error = 0.f;
+        for (size_t k = 0; k < heights.size(); k++)
+        {
+            max_error = llmax(max_error, fabsf(decoded[k] - heights[k]));
+        }
+        ensure("close to the source heights, error " + llformat("%f", max_error), max_error < 0.5f);
+
+        // and the same heights as the old decoder, up to float rounding
+        // (the compiler may fuse the old scalar multiply adds)
+        std::vector<F32> old(GRIDS_PER_EDGE*GRIDS_PER_EDGE, 0.f);
+        LLBitPack bitpack(data.data(), (U32)data.size());
+        LLGroupHeader goph;
+        unpack_patch_group_header(bitpack, &goph);
+        OldDecoder old_decoder(goph.patch_size);
+        S32 cpatch[LARGE_PATCH_SIZE*LARGE_PATCH_SIZE];
+        LLPatchHeader ph;
+        while (1)
+        {
+            unpack_patch_header(bitpack, &ph);
+            if (ph.quant_wbits == END_OF_PATCHES)
+            {
+                break;
+            }
+            unpack_patch(bitpack, cpatch, goph.patch_size, (ph.quant_wbits & 0xf) + 2);
+            S32 i = ph.patchids >> 5;
+            S32 j = ph.patchids & 0x1F;
+            old_decoder.decompress_patch(&old[j*NORMAL_PATCH_SIZE*GRIDS_PER_EDGE + i*NORMAL_PATCH_SIZE], cpatch, ph, GRIDS_PER_EDGE);
+        }
+        F32 max_diff = 0.f;
+        for (size_t k = 0; k < old.size(); k++)
+        {
+            max_diff = llmax(max_diff, fabsf(decoded[k] - old[k]));
+        }
+        ensure("same as the old decoder, difference " + llformat("%g", max_diff), max_diff < 1.e-4f);
+    }
+
+    template<> template<>
+    void patch_code_object::test<2>()
+    {
+        set_test_name("inverse transform of both patch sizes");
+
+        static const S32 sizes[] = { NORMAL_PATCH_SIZE, LARGE_PATCH_SIZE };
+        for (S32 size : sizes)
+        {
+            // the coefficients in zigzag order, dense first then sparse
+            for (S32 nonzero : { size*size, 12 })
+            {
+                S32 cpatch[LARGE_PATCH_SIZE*LARGE_PATCH_SIZE] = { 0 };
+                U32 seed = 12345;
+                for (S32 k = 0; k < nonzero; k++)
+                {
+                    seed = seed*1103515245 + 12345;
+                    cpatch[k] = (S32)((seed >> 16) % 201) - 100;
+                }
+
+                LLGroupHeader goph;
+                goph.patch_size = size;
+                goph.stride = size;
+                LLPatchDecoder decoder;
+                ensure("patch size", decoder.setGroupHeader(goph));
+
+                LLPatchHeader ph;
+                ph.dc_offset = 10.f;
+                ph.range = 64;
+                ph.quant_wbits = (8 << 4) | 8;      // prequant 10
+                F32 patch[LARGE_PATCH_SIZE*LARGE_PATCH_SIZE];
+                decoder.decompressPatch(patch, cpatch, ph);
+
+                // what the decoder should compute: dequantize, unzigzag,
+                // transform, then rescale to the header's range
+                S32 prequant = (ph.quant_wbits >> 4) + 2;
+                F32 mult = ph.range/(F32)(1 << prequant);
+                F32 addval = mult*(F32)(1 << (prequant - 1)) + ph.dc_offset;
+                std::vector<F32> block(size*size);
+                S32 i = 0, j = 0, count = 0;
+                bool right = true;
+                while (count < size*size)
+                {
+                    block[j*size + i] = cpatch[count++]*(1.f + 2.f*(i + j));
+                    // zigzag walk over the anti diagonals
+                    if (right)
+                    {
+                        if (j == 0 && i < size - 1) { i++; right = false; }
+                        else if (i == size - 1) { j++; right = false; }
+                        else { i++; j--; }
+                    }
+                    else
+                    {
+                        if (i == 0 && j < size - 1) { j++; right = true; }
+                        else if (j == size - 1) { i++; right = true; }
+                        else { i--; j++; }
+                    }
+                }
+                std::vector<F64> expected(size*size);
+                reference_idct(block.data(), expected.data(), size);
+
+                F64 max_error = 0.0;
+                for (S32 k = 0; k < size*size; k++)
+                {
+                    max_error = llmax(max_error, fabs(patch[k] - (expected[k]*mult + addval)));
+                }
+                ensure(llformat("size %d, %d coefficients, error %f", size, nonzero, max_error), max_error < 0.01);
+            }
+        }
+
+        LLGroupHeader goph;
+        goph.patch_size = 24;
+        goph.stride = 24;
+        LLPatchDecoder decoder;
+        ensure("unsupported patch size", !decoder.setGroupHeader(goph));
+    }
+
+    template<> template<>
+    void patch_code_object::test<3>()
+    {
+        set_test_name("decoders on several threads");
+
+        std::vector<F32> heights = make_heights();
+        std::vector<U8> data = encode_region(heights);
+        std::vector<F32> expected;
+        decode_region(data, expected);
+
+        const S32 THREADS = 4;
+        std::vector<std::vector<F32> > results(THREADS);
+        std::vector<std::thread> threads;
+        for (S32 t = 0; t < THREADS; t++)
+        {
+            threads.emplace_back([&data, &results, t]()
+                {
+                    // each thread decodes from its own copy of the packet
+                    std::vector<U8> packet(data);
+                    for (S32 pass = 0; pass < 20; pass++)
+                    {
+                        decode_region(packet, results[t]);
+                    }
+                });
+        }
+        for (std::thread &thread : threads)
+        {
+            thread.join();
+        }
+        for (S32 t = 0; t < THREADS; t++)
+        {
+            ensure(llformat("thread %d", t), results[t] == expected);
+        }
+    }
+
+    template<> template<>
+    void patch_code_object::test<4>()
+    {
+        set_test_name("decode throughput");
+        if (LLStringUtil::getenv("LL_BENCHMARK").empty())
+        {
+            skip("set LL_BENCHMARK to run");
+        }
+
+        // a region crossing with a 4x4 draw distance brings in about
+        // this many patches at once
+        const S32 REGIONS = 16;
+        std::vector<F32> heights = make_heights();
+        std::vector<U8> data = encode_region(heights);
+        std::vector<F32> decoded;
+
+        LLTimer timer;
+        for (S32 r = 0; r < REGIONS; r++)
+        {
+            decode_region(data, decoded);
+        }
+        F32 single = timer.getElapsedTimeF32();
+
+        const S32 THREADS = 4;
+        timer.reset();
+        std::vector<std::thread> threads;
+        for (S32 t = 0; t < THREADS; t++)
+        {
+            threads.emplace_back([&data, t]()
+                {
+                    std::vector<U8> packet(data);
+                    std::vector<F32> out;
+                    for (S32 r = t; r < REGIONS; r += THREADS)
+                    {
+                        decode_region(packet, out);
+                    }
+                });
+        }
+        for (std::thread &thread : threads)
+        {
+            thread.join();
+        }
+        F32 threaded = timer.getElapsedTimeF32();
+
+        S32 patches = REGIONS*PATCHES_PER_EDGE*PATCHES_PER_EDGE;
+        LL_INFOS() << "Decoded " << patches << " patches in " << single*1000.f << " ms, "
+                   << threaded*1000.f << " ms on " << THREADS << " threads ("
+                   << data.size() << " bytes per region)" << LL_ENDL;
+    }
+}
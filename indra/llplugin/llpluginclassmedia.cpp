@@ -99,6 +99,9 @@ void LLPluginClassMedia::reset()
     mRequestedTextureCoordsOpenGL = false;
     mTextureSharedMemorySize = 0;
     mTextureSharedMemoryName.clear();
+    mRequestedFrameRing = false;
+    mFrameRing.detach();
+    mFrameSequence = 0;
     mDefaultMediaWidth = 0;
     mDefaultMediaHeight = 0;
     mNaturalMediaWidth = 0;
@@ -207,13 +210,17 @@ void LLPluginClassMedia::idle(void)
 
 
         // Size change has been requested but not initiated yet.
-        size_t newsize = mRequestedTextureWidth * mRequestedTextureHeight * mRequestedTextureDepth;
+        size_t framesize = mRequestedTextureWidth * mRequestedTextureHeight * mRequestedTextureDepth;
 
         // Add an extra line for padding, just in case.
-        newsize += mRequestedTextureWidth * mRequestedTextureDepth;
+        framesize += mRequestedTextureWidth * mRequestedTextureDepth;
+
+        // Plugins that can draw into a ring of frames get one, so we never copy out a frame while it's being drawn.
+        size_t newsize = mRequestedFrameRing ? LLPluginFrameRing::getSegmentSize(framesize) : framesize;
 
         if(newsize != mTextureSharedMemorySize)
         {
+            mFrameRing.detach();
             if(!mTextureSharedMemoryName.empty())
             {
                 // Tell the plugin to remove the old memory segment
@@ -231,6 +238,11 @@ void LLPluginClassMedia::idle(void)
                 if (addr)
                 {
                     memset( addr, 0x00, newsize );
+
+                    if (mRequestedFrameRing)
+                    {
+                        mFrameRing.create(addr, newsize, framesize);
+                    }
                 }
                 else
                 {
@@ -418,6 +430,54 @@ void LLPluginClassMedia::resetDirty(void)
     mDirtyRect = LLRect::null;
 }
 
+unsigned char* LLPluginClassMedia::lockFrame(std::vector<LLRect> &rects)
+{
+    rects.clear();
+
+    LLRect dirty_rect;
+    if (!getDirty(&dirty_rect))
+    {
+        return NULL;
+    }
+    resetDirty();
+
+    if (!mFrameRing.isAttached())
+    {
+        // The plugin draws straight into the one frame we have.
+        rects.push_back(dirty_rect);
+        return getBitsData();
+    }
+
+    U32 sequence = 0;
+    S32 index = mFrameRing.lockNewestFrame(sequence);
+    if (index < 0)
+    {
+        return NULL;
+    }
+
+    if (sequence == mFrameSequence)
+    {
+        // Already have this one -- the updated message was for a frame we picked up early.
+        mFrameRing.unlockFrame();
+        return NULL;
+    }
+
+    if (!mFrameRing.getChangedRects(mFrameSequence, sequence, rects))
+    {
+        // We've fallen too far behind to know what changed, take the lot.  Only the media part of the texture
+        // is ever drawn.
+        rects.push_back(LLRect(0, getHeight(), getWidth(), 0));
+    }
+    mFrameSequence = sequence;
+
+    return mFrameRing.getFrame(index);
+}
+
+void LLPluginClassMedia::unlockFrame(void)
+{
+    mFrameRing.unlockFrame();
+}
+
 std::string LLPluginClassMedia::translateModifiers(MASK modifiers)
 {
     std::string result;
@@ -1047,6 +1107,9 @@ void LLPluginClassMedia::receivePluginMessage(const LLPluginMessage &message)
             mAllowDownsample = message.getValueBoolean("allow_downsample");
             mPadding = message.getValueS32("padding");
 
+            // Optional, plugins that don't know about frame rings draw into a single frame.
+            mRequestedFrameRing = message.getValueBoolean("frame_ring");
+
             setSizeInternal();
 
             mTextureParamsReceived = true;
@@ -1199,6 +1262,9 @@ void LLPluginClassMedia::receivePluginMessage(const LLPluginMessage &message)
             // This invalidates any existing dirty rect.
             resetDirty();
 
+            // The plugin started its frame ring over, so the next frame gets copied in full.
+            mFrameSequence = 0;
+
             // TODO: should we verify that the plugin sent back the right values?
             // Two size changes in a row may cause them to not match, due to queueing, etc.
 
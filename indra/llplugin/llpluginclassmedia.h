@@ -31,6 +31,7 @@
 
 #include "llgltypes.h"
 #include "llpluginprocessparent.h"
+#include "llpluginframering.h"
 #include "llrect.h"
 #include "llpluginclassmediaowner.h"
 #include <queue>
@@ -99,6 +100,12 @@ class LLPluginClassMedia final : public LLPluginProcessParentOwner
     bool getDirty(LLRect *dirty_rect = NULL);
     void resetDirty(void);
 
+    // Returns the newest frame with changes and fills in the rects that changed since the last one returned,
+    // or NULL if there's nothing new.  If the plugin draws into a frame ring, the frame stays locked against
+    // the plugin drawing into it until unlockFrame() is called, which is safe to do from another thread.
+    unsigned char* lockFrame(std::vector<LLRect> &rects);
+    void unlockFrame(void);
+
     typedef enum
     {
         MOUSE_EVENT_DOWN,
@@ -371,10 +378,14 @@ class LLPluginClassMedia final : public LLPluginProcessParentOwner
     LLGLenum    mRequestedTextureType;
     bool        mRequestedTextureSwapBytes;
     bool        mRequestedTextureCoordsOpenGL;
+    bool        mRequestedFrameRing;        // the plugin can draw into a ring of frames
 
     std::string mTextureSharedMemoryName;
     size_t      mTextureSharedMemorySize;
 
+    LLPluginFrameRing mFrameRing;
+    U32         mFrameSequence;             // sequence of the last frame returned by lockFrame(), 0 for none
+
     // True to scale requested media up to the full size of the texture (i.e. next power of two)
     bool        mAutoScaleMedia;
 
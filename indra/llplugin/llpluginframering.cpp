@@ -0,0 +1,393 @@
+/**
+ * @file llpluginframering.cpp
+ * @brief A ring of media frames laid out in one shared memory segment.
+ *
+ * @cond
+ * $LicenseInfo:firstyear=2024&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2024, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ * @endcond
+ */
+
+#include "linden_common.h"
+
+#include "llpluginframering.h"
+
+#include <atomic>
+
+static const U32 FRAME_RING_MAGIC = 0x52464c4c;    // "LLFR"
+static const size_t FRAME_ALIGNMENT = 64;
+// How many frames' dirty rects are kept for the viewer to catch up with
+static const U32 HISTORY_SIZE = 16;
+// More changed rects than this get uploaded as their bounding rect instead
+static const size_t MAX_CHANGED_RECTS = 4;
+
+static_assert(std::atomic<U32>::is_always_lock_free, "frame ring needs lock free atomics to work across processes");
+
+// Lives at the start of the segment, followed by the frames.  Both processes map it, so it holds nothing but plain data and atomics.
+struct LLPluginFrameRingHeader
+{
+    struct History
+    {
+        std::atomic<U32> mSequence;     // 0 while the rect is being written
+        std::atomic<S32> mLeft;
+        std::atomic<S32> mTop;
+        std::atomic<S32> mRight;
+        std::atomic<S32> mBottom;
+    };
+
+    U32 mMagic;
+    S32 mFrameCount;
+    U64 mFrameSize;
+    std::atomic<S32> mNewest;       // newest complete frame, or -1
+    std::atomic<S32> mReading;      // frame the viewer is copying out of, or -1
+    std::atomic<U32> mSequence[LLPluginFrameRing::MAX_FRAME_COUNT];    // 0 while the plugin is drawing into that frame
+    History mHistory[HISTORY_SIZE]; // the rect each recent frame redrew, by sequence
+};
+
+static size_t align_frame(size_t size)
+{
+    return (size + FRAME_ALIGNMENT - 1) & ~(FRAME_ALIGNMENT - 1);
+}
+
+static bool rects_touch(const LLRect &a, const LLRect &b)
+{
+    return a.mLeft <= b.mRight && b.mLeft <= a.mRight && a.mBottom <= b.mTop && b.mBottom <= a.mTop;
+}
+
+static void copy_rect(unsigned char *dst, const unsigned char *src, const LLRect &rect, S32 width, S32 depth)
+{
+    if (rect.isEmpty() || !rect.isValid())
+    {
+        return;
+    }
+
+    size_t row_bytes = (size_t)width * depth;
+    size_t offset = (size_t)rect.mLeft * depth;
+    size_t bytes = (size_t)rect.getWidth() * depth;
+    for (S32 y = rect.mBottom; y < rect.mTop; ++y)
+    {
+        memcpy(dst + y * row_bytes + offset, src + y * row_bytes + offset, bytes);
+    }
+}
+
+LLPluginFrameRing::LLPluginFrameRing() :
+    mHeader(NULL),
+    mFrames(NULL),
+    mFrameStride(0),
+    mNextSequence(1)
+{
+    memset(mFrameSequence, 0, sizeof(mFrameSequence));
+}
+
+// static
+size_t LLPluginFrameRing::getSegmentSize(size_t frame_size, S32 frame_count)
+{
+    return align_frame(sizeof(LLPluginFrameRingHeader)) + align_frame(frame_size) * frame_count;
+}
+
+bool LLPluginFrameRing::create(void *segment, size_t segment_size, size_t frame_size, S32 frame_count)
+{
+    detach();
+
+    if (!segment || frame_count < DEFAULT_FRAME_COUNT || frame_count > MAX_FRAME_COUNT
+        || segment_size < getSegmentSize(frame_size, frame_count))
+    {
+        LL_WARNS("Plugin") << "Can't fit " << frame_count << " frames of " << frame_size << " bytes in " << segment_size << LL_ENDL;
+        return false;
+    }
+
+    LLPluginFrameRingHeader *header = new (segment) LLPluginFrameRingHeader;
+    header->mMagic = FRAME_RING_MAGIC;
+    header->mFrameCount = frame_count;
+    header->mFrameSize = frame_size;
+    header->mNewest = -1;
+    header->mReading = -1;
+    for (S32 i = 0; i < MAX_FRAME_COUNT; ++i)
+    {
+        header->mSequence[i] = 0;
+    }
+    for (U32 i = 0; i < HISTORY_SIZE; ++i)
+    {
+        header->mHistory[i].mSequence = 0;
+    }
+
+    mHeader = header;
+    mFrames = (unsigned char*)segment + align_frame(sizeof(LLPluginFrameRingHeader));
+    mFrameStride = align_frame(frame_size);
+
+    return true;
+}
+
+bool LLPluginFrameRing::attach(void *segment, size_t segment_size)
+{
+    detach();
+
+    LLPluginFrameRingHeader *header = (LLPluginFrameRingHeader*)segment;
+    if (!header || segment_size < sizeof(LLPluginFrameRingHeader) || header->mMagic != FRAME_RING_MAGIC)
+    {
+        return false;
+    }
+
+    if (header->mFrameCount < DEFAULT_FRAME_COUNT || header->mFrameCount > MAX_FRAME_COUNT
+        || segment_size < getSegmentSize(header->mFrameSize, header->mFrameCount))
+    {
+        LL_WARNS("Plugin") << "Ignoring frame ring that doesn't fit its segment" << LL_ENDL;
+        return false;
+    }
+
+    mHeader = header;
+    mFrames = (unsigned char*)segment + align_frame(sizeof(LLPluginFrameRingHeader));
+    mFrameStride = align_frame(header->mFrameSize);
+
+    // Frames drawn before a size change are the wrong size, so start over.
+    mHeader->mNewest = -1;
+    for (U32 i = 0; i < HISTORY_SIZE; ++i)
+    {
+        mHeader->mHistory[i].mSequence = 0;
+    }
+    mNextSequence = 1;
+    memset(mFrameSequence, 0, sizeof(mFrameSequence));
+
+    return true;
+}
+
+void LLPluginFrameRing::detach(void)
+{
+    mHeader = NULL;
+    mFrames = NULL;
+    mFrameStride = 0;
+}
+
+unsigned char *LLPluginFrameRing::getFrame(S32 index) const
+{
+    if (!mHeader || index < 0 || index >= mHeader->mFrameCount)
+    {
+        return NULL;
+    }
+
+    return mFrames + mFrameStride * index;
+}
+
+S32 LLPluginFrameRing::beginFrame(void)
+{
+    if (!mHeader)
+    {
+        return -1;
+    }
+
+    while (true)
+    {
+        S32 newest = mHeader->mNewest;
+        S32 reading = mHeader->mReading;
+
+        // Reuse the oldest frame the viewer can't be using.  With three or more there's always one.
+        S32 index = -1;
+        for (S32 i = 0; i < mHeader->mFrameCount; ++i)
+        {
+            if (i != newest && i != reading && (index < 0 || mFrameSequence[i] < mFrameSequence[index]))
+            {
+                index = i;
+            }
+        }
+
+        // Mark it as being drawn, then make sure the viewer didn't lock it in the meantime.
+        U32 sequence = mHeader->mSequence[index].exchange(0);
+        if (mHeader->mReading != index)
+        {
+            return index;
+        }
+        mHeader->mSequence[index] = sequence;
+    }
+}
+
+S32 LLPluginFrameRing::endFrame(S32 index, const LLRect &dirty_rect, S32 width, S32 height, S32 depth)
+{
+    if (!mHeader || index < 0 || index >= mHeader->mFrameCount)
+    {
+        return index;
+    }
+
+    // Plugins tend to have top and bottom the other way around, so don't rely on either.
+    LLRect frame_rect(0, height, width, 0);
+    LLRect drawn(llmin(dirty_rect.mLeft, dirty_rect.mRight), llmax(dirty_rect.mTop, dirty_rect.mBottom),
+                 llmax(dirty_rect.mLeft, dirty_rect.mRight), llmin(dirty_rect.mTop, dirty_rect.mBottom));
+    drawn.intersectWith(frame_rect);
+
+    U32 sequence = mNextSequence++;
+    if (!mNextSequence)
+    {
+        mNextSequence = 1;
+    }
+
+    // This frame held an older frame, so bring everything earlier frames changed outside of what was just drawn
+    // up to date from the previous frame.
+    S32 previous = mHeader->mNewest;
+    if (previous >= 0 && previous != index)
+    {
+        LLRect stale;
+        U32 held = mFrameSequence[index];
+        U32 previous_sequence = mFrameSequence[previous];
+        if (!held || previous_sequence - held >= HISTORY_SIZE)
+        {
+            stale = frame_rect;
+        }
+        else
+        {
+            for (U32 s = held + 1; s != previous_sequence + 1; ++s)
+            {
+                const LLPluginFrameRingHeader::History &history = mHeader->mHistory[s % HISTORY_SIZE];
+                LLRect changed(history.mLeft, history.mTop, history.mRight, history.mBottom);
+                if (stale.isEmpty())
+                {
+                    stale = changed;
+                }
+                else if (changed.notEmpty())
+                {
+                    stale.unionWith(changed);
+                }
+            }
+            stale.intersectWith(frame_rect);
+        }
+
+        unsigned char *dst = getFrame(index);
+        const unsigned char *src = getFrame(previous);
+        LLRect overlap(drawn);
+        overlap.intersectWith(stale);
+        if (overlap.isEmpty())
+        {
+            copy_rect(dst, src, stale, width, depth);
+        }
+        else
+        {
+            copy_rect(dst, src, LLRect(stale.mLeft, overlap.mBottom, stale.mRight, stale.mBottom), width, depth);
+            copy_rect(dst, src, LLRect(stale.mLeft, stale.mTop, stale.mRight, overlap.mTop), width, depth);
+            copy_rect(dst, src, LLRect(stale.mLeft, overlap.mTop, overlap.mLeft, overlap.mBottom), width, depth);
+            copy_rect(dst, src, LLRect(overlap.mRight, overlap.mTop, stale.mRight, overlap.mBottom), width, depth);
+        }
+    }
+
+    LLPluginFrameRingHeader::History &history = mHeader->mHistory[sequence % HISTORY_SIZE];
+    history.mSequence = 0;
+    history.mLeft = drawn.mLeft;
+    history.mTop = drawn.mTop;
+    history.mRight = drawn.mRight;
+    history.mBottom = drawn.mBottom;
+    history.mSequence = sequence;
+
+    mFrameSequence[index] = sequence;
+    mHeader->mSequence[index] = sequence;
+    mHeader->mNewest = index;
+
+    return beginFrame();
+}
+
+S32 LLPluginFrameRing::lockNewestFrame(U32 &sequence)
+{
+    if (!mHeader)
+    {
+        return -1;
+    }
+
+    // The plugin never starts drawing into the newest frame, but it may have moved on between reading mNewest and
+    // locking it.  If so, the frame shows up as being drawn and we go again.
+    for (S32 tries = 0; tries < MAX_FRAME_COUNT; ++tries)
+    {
+        S32 newest = mHeader->mNewest;
+        if (newest < 0)
+        {
+            break;
+        }
+
+        mHeader->mReading = newest;
+        sequence = mHeader->mSequence[newest];
+        if (sequence)
+        {
+            return newest;
+        }
+    }
+
+    mHeader->mReading = -1;
+    return -1;
+}
+
+void LLPluginFrameRing::unlockFrame(void)
+{
+    if (mHeader)
+    {
+        mHeader->mReading = -1;
+    }
+}
+
+bool LLPluginFrameRing::getChangedRects(U32 since_sequence, U32 sequence, std::vector<LLRect> &rects) const
+{
+    rects.clear();
+    if (!mHeader || !since_sequence || sequence - since_sequence > HISTORY_SIZE)
+    {
+        return false;
+    }
+
+    for (U32 s = since_sequence + 1; s != sequence + 1; ++s)
+    {
+        // The plugin may be reusing this slot for a newer frame, in which case the history we want is gone.
+        const LLPluginFrameRingHeader::History &history = mHeader->mHistory[s % HISTORY_SIZE];
+        U32 before = history.mSequence;
+        LLRect changed(history.mLeft, history.mTop, history.mRight, history.mBottom);
+        U32 after = history.mSequence;
+        if (before != s || after != s)
+        {
+            rects.clear();
+            return false;
+        }
+
+        if (changed.isEmpty())
+        {
+            continue;
+        }
+
+        // Merge anything this touches, so overlapping updates are only uploaded once
+        for (size_t i = 0; i < rects.size(); )
+        {
+            if (rects_touch(rects[i], changed))
+            {
+                changed.unionWith(rects[i]);
+                rects.erase(rects.begin() + i);
+                i = 0;
+            }
+            else
+            {
+                ++i;
+            }
+        }
+        rects.push_back(changed);
+    }
+
+    if (rects.size() > MAX_CHANGED_RECTS)
+    {
+        LLRect bounds = rects[0];
+        for (size_t i = 1; i < rects.size(); ++i)
+        {
+            bounds.unionWith(rects[i]);
+        }
+        rects.assign(1, bounds);
+    }
+
+    return true;
+}
@@ -0,0 +1,92 @@
+/**
+ * @file llpluginframering.h
+ * @brief A ring of media frames laid out in one shared memory segment.
+ *
+ * @cond
+ * $LicenseInfo:firstyear=2024&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2024, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ * @endcond
+ */
+
+#ifndef LL_LLPLUGINFRAMERING_H
+#define LL_LLPLUGINFRAMERING_H
+
+#include "llrect.h"
+
+struct LLPluginFrameRingHeader;
+
+/**
+ * @brief LLPluginFrameRing lets a media plugin draw frames while the viewer copies out an earlier one.
+ *
+ * The viewer lays the ring out in the media texture segment (create()), the plugin finds it there (attach()).
+ * The plugin always draws into a buffer that is neither the newest complete frame nor the one the viewer is
+ * reading, so the viewer never sees a half drawn frame. Each frame is stamped with a sequence number and the
+ * rect the plugin redrew, so the viewer can copy just what changed since the last frame it took.
+ *
+ * Frames are laid out like the single frame segment: rows of width * depth bytes.
+ */
+class LLPluginFrameRing
+{
+    LOG_CLASS(LLPluginFrameRing);
+public:
+    // Three frames is enough for the plugin to always have one to draw into.
+    static const S32 DEFAULT_FRAME_COUNT = 3;
+    static const S32 MAX_FRAME_COUNT = 4;
+
+    LLPluginFrameRing();
+
+    // Returns the segment size needed for frame_count frames of frame_size bytes.
+    static size_t getSegmentSize(size_t frame_size, S32 frame_count = DEFAULT_FRAME_COUNT);
+
+    // Viewer side: lays out a ring in a segment of at least getSegmentSize() bytes.
+    bool create(void *segment, size_t segment_size, size_t frame_size, S32 frame_count = DEFAULT_FRAME_COUNT);
+    // Plugin side: finds the ring the viewer laid out. Returns false for a plain single frame segment.
+    bool attach(void *segment, size_t segment_size);
+    void detach(void);
+    bool isAttached(void) const { return (mHeader != NULL); };
+
+    unsigned char *getFrame(S32 index) const;
+
+    // Plugin side: returns the buffer to draw the next frame into.
+    S32 beginFrame(void);
+    // Plugin side: publishes the frame drawn into index, which must redraw everything inside dirty_rect.
+    // Copies what changed in earlier frames outside dirty_rect over from the previous frame first.
+    // Returns the buffer to draw the next frame into.
+    S32 endFrame(S32 index, const LLRect &dirty_rect, S32 width, S32 height, S32 depth);
+
+    // Viewer side: locks the newest complete frame for reading and returns its index, or -1 if there isn't one yet.
+    S32 lockNewestFrame(U32 &sequence);
+    void unlockFrame(void);
+    // Viewer side: fills rects with what changed after frame since_sequence up to and including frame sequence.
+    // Returns false if that history is gone, in which case the whole frame should be taken.
+    bool getChangedRects(U32 since_sequence, U32 sequence, std::vector<LLRect> &rects) const;
+
+private:
+    LLPluginFrameRingHeader *mHeader;
+    unsigned char *mFrames;
+    size_t mFrameStride;
+
+    // plugin side bookkeeping
+    U32 mNextSequence;
+    U32 mFrameSequence[MAX_FRAME_COUNT];    // the sequence each buffer held when the plugin last published it
+};
+
+#endif // LL_LLPLUGINFRAMERING_H
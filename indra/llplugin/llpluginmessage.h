@@ -88,11 +88,17 @@ class LLPluginMessage
     // Flatten the message into a string
     std::string generate(void) const;
 
+    // Flatten the message into binary LLSD, for peers that negotiated binary framing
+    std::string generateBinary(void) const;
+
     // Parse an incoming message into component parts
     // (this clears out all existing state before starting the parse)
     // Returns -1 on failure, otherwise returns the number of key/value pairs in the message.
     int parse(const std::string &message);
 
+    // Same as parse(), but for binary LLSD read straight out of the caller's buffer.
+    int parseBinary(const char *data, size_t size);
+
 
 private:
 
@@ -29,15 +29,28 @@
 #include "linden_common.h"
 
 #include "llpluginmessagepipe.h"
+#include "llpluginmessage.h"
 #include "llbufferstream.h"
+#include "llsdserialize.h"
 
 #include "llapr.h"
 
 static const char MESSAGE_DELIMITER = '\0';
 
+// Binary frames are a marker byte and a big-endian payload length followed by binary LLSD.
+// XML messages always start with '<', so the two can share one stream.
+static const char BINARY_FRAME_MARKER = '\x01';
+static const size_t BINARY_FRAME_HEADER_SIZE = 5;
+// Plugin messages are small, anything past this is a corrupt stream rather than a message to wait for.
+static const size_t MAX_BINARY_FRAME_SIZE = 16 * 1024 * 1024;
+
+// Consumed input is only erased once this much has built up, rather than once per message.
+static const std::string::size_type INPUT_COMPACT_SIZE = 64 * 1024;
+
 LLPluginMessagePipeOwner::LLPluginMessagePipeOwner() :
     mMessagePipe(NULL),
-    mSocketError(APR_SUCCESS)
+    mSocketError(APR_SUCCESS),
+    mBinaryFraming(false)
 {
 }
 
@@ -54,6 +67,13 @@ apr_status_t LLPluginMessagePipeOwner::socketError(apr_status_t error)
     return error;
 };
 
+// virtual
+void LLPluginMessagePipeOwner::receiveMessageParsed(const LLPluginMessage &message)
+{
+    // Owners that don't know about binary framing get the message the old way.
+    receiveMessageRaw(message.generate());
+}
+
 //virtual
 void LLPluginMessagePipeOwner::setMessagePipe(LLPluginMessagePipe *read_pipe)
 {
@@ -82,6 +102,27 @@ bool LLPluginMessagePipeOwner::writeMessageRaw(const std::string &message)
     return result;
 }
 
+bool LLPluginMessagePipeOwner::writeMessage(const LLPluginMessage &message)
+{
+    if(!mBinaryFraming)
+    {
+        return writeMessageRaw(message.generate());
+    }
+
+    bool result = true;
+    if(mMessagePipe != NULL)
+    {
+        result = mMessagePipe->addBinaryMessage(message.generateBinary());
+    }
+    else
+    {
+        LL_WARNS("Plugin") << "dropping message: " << message.getClass() << " " << message.getName() << LL_ENDL;
+        result = false;
+    }
+
+    return result;
+}
+
 void LLPluginMessagePipeOwner::killMessagePipe(void)
 {
     if(mMessagePipe != NULL)
@@ -93,6 +134,7 @@ void LLPluginMessagePipeOwner::killMessagePipe(void)
 
 LLPluginMessagePipe::LLPluginMessagePipe(LLPluginMessagePipeOwner *owner, LLSocket::ptr_t socket):
     mInputMutex(),
+    mInputStartIndex(0),
     mOutputMutex(),
     mOutputStartIndex(0),
     mOwner(owner),
@@ -127,6 +169,39 @@ bool LLPluginMessagePipe::addMessage(const std::string &message)
     return true;
 }
 
+bool LLPluginMessagePipe::addBinaryMessage(const std::string &message)
+{
+    // queue the message for later output
+    LLMutexLock lock(&mOutputMutex);
+
+    // If we're starting to use up too much memory, clear
+    if (mOutputStartIndex > 1024 * 1024)
+    {
+        mOutput = mOutput.substr(mOutputStartIndex);
+        mOutputStartIndex = 0;
+    }
+
+    if (message.size() > MAX_BINARY_FRAME_SIZE)
+    {
+        LL_WARNS("Plugin") << "dropping binary message of " << message.size() << " bytes" << LL_ENDL;
+        return false;
+    }
+
+    U32 size = (U32)message.size();
+    char header[BINARY_FRAME_HEADER_SIZE] =
+    {
+        BINARY_FRAME_MARKER,
+        (char)(size >> 24),
+        (char)(size >> 16),
+        (char)(size >> 8),
+        (char)size
+    };
+    mOutput.append(header, BINARY_FRAME_HEADER_SIZE);
+    mOutput += message;
+
+    return true;
+}
+
 void LLPluginMessagePipe::clearOwner(void)
 {
     // The owner is done with this pipe.  The next call to process_impl should send any remaining data and exit.
@@ -177,9 +252,11 @@ bool LLPluginMessagePipe::pumpOutput()
 
         LLMutexLock lock(&mOutputMutex);
 
-        const char * output_data = &(mOutput.data()[mOutputStartIndex]);
-        if(*output_data != '\0')
+        // Binary frames can contain nulls, so go by what's left rather than looking for one.
+        if(mOutputStartIndex < mOutput.size())
         {
+            const char * output_data = &(mOutput.data()[mOutputStartIndex]);
+
             // write any outgoing messages
             in_size = (apr_size_t) (mOutput.size() - mOutputStartIndex);
             out_size = in_size;
@@ -364,37 +441,103 @@ bool LLPluginMessagePipe::pumpInput(F64 timeout)
                 }
             }
 
-            processInput();
+            if (!processInput())
+            {
+                result = false;
+            }
         }
     }
 
     return result;
 }
 
-void LLPluginMessagePipe::processInput(void)
+bool LLPluginMessagePipe::processInput(void)
 {
-    // Look for input delimiter(s) in the input buffer.
-    int delim;
+    bool result = true;
+
+    // Look for complete messages in the input buffer.
     mInputMutex.lock();
-    while((delim = mInput.find(MESSAGE_DELIMITER)) != std::string::npos)
+    while(mInputStartIndex < mInput.size())
     {
-        // Let the owner process this message
-        if (mOwner)
+        if (!mOwner)
+        {
+            LL_WARNS("Plugin") << "!mOwner" << LL_ENDL;
+            break;
+        }
+
+        // Step past each message before calling out to the owner.
+        // It's now possible for this function to get called recursively (in the case where the plugin makes a blocking request)
+        // and this guarantees that the messages will get dequeued correctly.
+        const char *start = mInput.data() + mInputStartIndex;
+        std::string::size_type available = mInput.size() - mInputStartIndex;
+        if (*start == BINARY_FRAME_MARKER)
         {
-            // Pull the message out of the input buffer before calling receiveMessageRaw.
-            // It's now possible for this function to get called recursively (in the case where the plugin makes a blocking request)
-            // and this guarantees that the messages will get dequeued correctly.
-            std::string message(mInput, 0, delim);
-            mInput.erase(0, delim + 1);
+            if (available < BINARY_FRAME_HEADER_SIZE)
+            {
+                break;
+            }
+
+            const U8 *header = (const U8*)start;
+            size_t size = ((size_t)header[1] << 24) | ((size_t)header[2] << 16) | ((size_t)header[3] << 8) | (size_t)header[4];
+            if (size > MAX_BINARY_FRAME_SIZE)
+            {
+                // There's no finding the next message after a bad length, so give up on the stream.
+                LL_WARNS("Plugin") << "binary message of " << size << " bytes is over the limit, closing the pipe" << LL_ENDL;
+                mInput.clear();
+                mInputStartIndex = 0;
+                mInputMutex.unlock();
+                mOwner->socketError(APR_EGENERAL);
+                result = false;
+                mInputMutex.lock();
+                break;
+            }
+            if (available - BINARY_FRAME_HEADER_SIZE < size)
+            {
+                break;
+            }
+
+            // Parse straight out of the input buffer, which can't move while we hold the lock.
+            LLPluginMessage message;
+            bool parsed = (message.parseBinary(start + BINARY_FRAME_HEADER_SIZE, size) != LLSDParser::PARSE_FAILURE);
+            mInputStartIndex += BINARY_FRAME_HEADER_SIZE + size;
             mInputMutex.unlock();
-            mOwner->receiveMessageRaw(message);
+            if (parsed)
+            {
+                mOwner->receiveMessageParsed(message);
+            }
+            else
+            {
+                LL_WARNS("Plugin") << "dropping unparseable binary message of " << size << " bytes" << LL_ENDL;
+            }
             mInputMutex.lock();
         }
         else
         {
-            LL_WARNS("Plugin") << "!mOwner" << LL_ENDL;
+            std::string::size_type delim = mInput.find(MESSAGE_DELIMITER, mInputStartIndex);
+            if (delim == std::string::npos)
+            {
+                break;
+            }
+
+            std::string message(mInput, mInputStartIndex, delim - mInputStartIndex);
+            mInputStartIndex = delim + 1;
+            mInputMutex.unlock();
+            mOwner->receiveMessageRaw(message);
+            mInputMutex.lock();
         }
     }
+
+    if (mInputStartIndex >= mInput.size())
+    {
+        mInput.clear();
+        mInputStartIndex = 0;
+    }
+    else if (mInputStartIndex > INPUT_COMPACT_SIZE)
+    {
+        mInput.erase(0, mInputStartIndex);
+        mInputStartIndex = 0;
+    }
     mInputMutex.unlock();
-}
 
+    return result;
+}
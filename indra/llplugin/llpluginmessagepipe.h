@@ -34,6 +34,7 @@
 #include "llmutex.h"
 
 class LLPluginMessagePipe;
+class LLPluginMessage;
 
 // Inherit from this to be able to receive messages from the LLPluginMessagePipe
 class LLPluginMessagePipeOwner
@@ -45,6 +46,8 @@ class LLPluginMessagePipeOwner
 
     // called with incoming messages
     virtual void receiveMessageRaw(const std::string &message) = 0;
+    // called with incoming binary-framed messages, which the pipe parses straight out of its input buffer
+    virtual void receiveMessageParsed(const LLPluginMessage &message);
     // called when the socket has an error
     virtual apr_status_t socketError(apr_status_t error);
 
@@ -56,11 +59,18 @@ class LLPluginMessagePipeOwner
     bool canSendMessage(void);
     // call this to send a message over the pipe
     bool writeMessageRaw(const std::string &message);
+    // call this to send a message over the pipe, using binary framing if it has been negotiated
+    bool writeMessage(const LLPluginMessage &message);
     // call this to close the pipe
     void killMessagePipe(void);
 
+    // Only switch this on once the other end has said it can read binary frames.
+    void setBinaryFraming(bool binary) { mBinaryFraming = binary; };
+    bool getBinaryFraming(void) const { return mBinaryFraming; };
+
     LLPluginMessagePipe *mMessagePipe;
     apr_status_t mSocketError;
+    bool mBinaryFraming;
 };
 
 class LLPluginMessagePipe
@@ -71,6 +81,7 @@ class LLPluginMessagePipe
     virtual ~LLPluginMessagePipe();
 
     bool addMessage(const std::string &message);
+    bool addBinaryMessage(const std::string &message);
     void clearOwner(void);
 
     bool pump(F64 timeout = 0.0f);
@@ -78,13 +89,15 @@ class LLPluginMessagePipe
     bool pumpInput(F64 timeout = 0.0f);
 
 protected:
-    void processInput(void);
+    // returns false if the input can't be framed and the pipe should close
+    bool processInput(void);
 
     // used internally by pump()
     void setSocketTimeout(apr_interval_time_t timeout_usec);
 
     LLMutex mInputMutex;
     std::string mInput;
+    std::string::size_type mInputStartIndex;
     LLMutex mOutputMutex;
     std::string mOutput;
     std::string::size_type mOutputStartIndex;
@@ -137,9 +137,14 @@ void LLPluginProcessChild::idle(void)
             break;
 
         case STATE_CONNECTED:
-            sendMessageToParent(LLPluginMessage(LLPLUGIN_MESSAGE_CLASS_INTERNAL, "hello"));
+        {
+            // Let the parent know we can read binary frames.  It will only switch to them if it can too.
+            LLPluginMessage message(LLPLUGIN_MESSAGE_CLASS_INTERNAL, "hello");
+            message.setValueBoolean("binary_framing", true);
+            sendMessageToParent(message);
             setState(STATE_PLUGIN_LOADING);
             break;
+        }
 
         case STATE_PLUGIN_LOADING:
             if (!mPluginFile.empty())
@@ -337,13 +342,11 @@ void LLPluginProcessChild::sendMessageToPlugin(const LLPluginMessage &message)
 
 void LLPluginProcessChild::sendMessageToParent(const LLPluginMessage &message)
 {
-    std::string buffer = message.generate();
-
 #ifdef SHOW_DEBUG
-    LL_DEBUGS("Plugin") << "Sending to parent: " << buffer << LL_ENDL;
+    LL_DEBUGS("Plugin") << "Sending to parent: " << message.generate() << LL_ENDL;
 #endif
 
-    writeMessageRaw(buffer);
+    writeMessage(message);
 }
 
 void LLPluginProcessChild::receiveMessageRaw(const std::string &message)
@@ -357,6 +360,19 @@ void LLPluginProcessChild::receiveMessageRaw(const std::string &message)
     LLPluginMessage parsed;
     parsed.parse(message);
 
+    receiveMessageFromParent(parsed, message);
+}
+
+/* virtual */
+void LLPluginProcessChild::receiveMessageParsed(const LLPluginMessage &message)
+{
+    // Incoming binary-framed message from the TCP Socket, already decoded.
+    // The plugin itself still speaks XML, so it gets regenerated on the way through.
+    receiveMessageFromParent(message, LLStringUtil::null);
+}
+
+void LLPluginProcessChild::receiveMessageFromParent(const LLPluginMessage &parsed, const std::string &message)
+{
     if (mBlockingRequest)
     {
         // We're blocking the plugin waiting for a response.
@@ -369,7 +385,7 @@ void LLPluginProcessChild::receiveMessageRaw(const std::string &message)
         else
         {
             // Still waiting.  Queue this message and don't process it yet.
-            mMessageQueue.push(message);
+            mMessageQueue.push(parsed);
             return;
         }
     }
@@ -389,6 +405,9 @@ void LLPluginProcessChild::receiveMessageRaw(const std::string &message)
             {
                 mPluginFile = parsed.getValue("file");
                 mPluginDir = parsed.getValue("dir");
+
+                // Everything we send from here on can use binary framing, if the parent asked for it.
+                setBinaryFraming(parsed.hasValue("binary_framing") && parsed.getValueBoolean("binary_framing"));
             }
             else if (message_name == "shutdown_plugin")
             {
@@ -479,11 +498,18 @@ void LLPluginProcessChild::receiveMessageRaw(const std::string &message)
 
     if (passMessage && mInstance != NULL)
     {
-        LLTimer elapsed;
+        if (message.empty())
+        {
+            sendMessageToPlugin(parsed);
+        }
+        else
+        {
+            LLTimer elapsed;
 
-        mInstance->sendMessage(message);
+            mInstance->sendMessage(message);
 
-        mCPUElapsed += elapsed.getElapsedTimeF64();
+            mCPUElapsed += elapsed.getElapsedTimeF64();
+        }
     }
 }
 
@@ -505,12 +531,12 @@ void LLPluginProcessChild::receivePluginMessage(const std::string &message)
 
     // FIXME: how should we handle queueing here?
 
+    // Decode this message
+    LLPluginMessage parsed;
+    parsed.parse(message);
+
     // Intercept certain base messages (responses to ones sent by this class)
     {
-        // Decode this message
-        LLPluginMessage parsed;
-        parsed.parse(message);
-
         if (parsed.hasValue("blocking_request"))
         {
             mBlockingRequest = true;
@@ -578,7 +604,14 @@ void LLPluginProcessChild::receivePluginMessage(const std::string &message)
 #ifdef SHOW_DEBUG
         LL_DEBUGS("Plugin") << "Passing through to parent: " << message << LL_ENDL;
 #endif
-        writeMessageRaw(message);
+        if (getBinaryFraming())
+        {
+            writeMessage(parsed);
+        }
+        else
+        {
+            writeMessageRaw(message);
+        }
     }
 
     while (mBlockingRequest)
@@ -610,7 +643,7 @@ void LLPluginProcessChild::deliverQueuedMessages()
     {
         while (!mMessageQueue.empty())
         {
-            receiveMessageRaw(mMessageQueue.front());
+            receiveMessageFromParent(mMessageQueue.front(), LLStringUtil::null);
             mMessageQueue.pop();
         }
     }
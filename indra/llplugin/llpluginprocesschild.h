@@ -65,6 +65,7 @@ class LLPluginProcessChild: public LLPluginMessagePipeOwner, public LLPluginInst
 
     // Inherited from LLPluginMessagePipeOwner
     /* virtual */ void receiveMessageRaw(const std::string &message);
+    /* virtual */ void receiveMessageParsed(const LLPluginMessage &message);
 
     // Inherited from LLPluginInstanceMessageListener
     /* virtual */ void receivePluginMessage(const std::string &message);
@@ -106,9 +107,11 @@ class LLPluginProcessChild: public LLPluginMessagePipeOwner, public LLPluginInst
     F64     mCPUElapsed;
     bool    mBlockingRequest;
     bool    mBlockingResponseReceived;
-    std::queue<std::string> mMessageQueue;
+    std::queue<LLPluginMessage> mMessageQueue;
     LLTimer mWaitGoodbye;
     void deliverQueuedMessages();
+    // message is the raw XML to hand to the plugin, or empty if parsed has to be regenerated for it.
+    void receiveMessageFromParent(const LLPluginMessage &parsed, const std::string &message);
 
 };
 
@@ -41,6 +41,7 @@
 #include "llapr.h"
 
 bool LLPluginProcessParent::sUseReadThread = false;
+bool LLPluginProcessParent::sUseBinaryFraming = true;
 apr_pollset_t *LLPluginProcessParent::sPollSet = NULL;
 bool LLPluginProcessParent::sPollsetNeedsRebuild = false;
 LLMutex *LLPluginProcessParent::sInstancesMutex = nullptr;
@@ -95,6 +96,7 @@ LLPluginProcessParent::LLPluginProcessParent(LLPluginProcessParentOwner *owner):
     mDebug = false;
     mBlocked = false;
     mPolledInput = false;
+    mPeerBinaryFraming = false;
     mPollFD.client_data = NULL;
 
     mPluginLaunchTimeout = 60.0f;
@@ -630,9 +632,16 @@ void LLPluginProcessParent::idle(void)
                     LLPluginMessage message(LLPLUGIN_MESSAGE_CLASS_INTERNAL, "load_plugin_alchemy");
                     message.setValue("file", mPluginFile);
                     message.setValue("dir", mPluginDir);
+                    if (mPeerBinaryFraming)
+                    {
+                        message.setValueBoolean("binary_framing", true);
+                    }
                     sendMessage(message);
                 }
 
+                // This is the last message the plugin host has to read as XML.
+                setBinaryFraming(mPeerBinaryFraming);
+
                 setState(STATE_LOADING);
                 break;
             }
@@ -779,11 +788,10 @@ void LLPluginProcessParent::sendMessage(const LLPluginMessage &message)
         mHeartbeat.setTimerExpirySec(mPluginLockupTimeout);
     }
 
-    std::string buffer = message.generate();
 #ifdef SHOW_DEBUG
-    LL_DEBUGS("Plugin") << "Sending: " << buffer << LL_ENDL;
+    LL_DEBUGS("Plugin") << "Sending: " << message.generate() << LL_ENDL;
 #endif
-    writeMessageRaw(buffer);
+    writeMessage(message);
 
     // Try to send message immediately.
     if(mMessagePipe)
@@ -1052,21 +1060,26 @@ void LLPluginProcessParent::receiveMessageRaw(const std::string &message)
     LLPluginMessage parsed;
     if(LLSDParser::PARSE_FAILURE != parsed.parse(message))
     {
-        if(parsed.hasValue("blocking_request"))
-        {
-            mBlocked = true;
-        }
+        receiveMessageParsed(parsed);
+    }
+}
 
-        if(mPolledInput)
-        {
-            // This is being called on the polling thread -- only do minimal processing/queueing.
-            receiveMessageEarly(parsed);
-        }
-        else
-        {
-            // This is not being called on the polling thread -- do full message processing at this time.
-            receiveMessage(parsed);
-        }
+void LLPluginProcessParent::receiveMessageParsed(const LLPluginMessage &message)
+{
+    if(message.hasValue("blocking_request"))
+    {
+        mBlocked = true;
+    }
+
+    if(mPolledInput)
+    {
+        // This is being called on the polling thread -- only do minimal processing/queueing.
+        receiveMessageEarly(message);
+    }
+    else
+    {
+        // This is not being called on the polling thread -- do full message processing at this time.
+        receiveMessage(message);
     }
 }
 
@@ -1109,6 +1122,11 @@ void LLPluginProcessParent::receiveMessage(const LLPluginMessage &message)
         {
             if(mState == STATE_CONNECTED)
             {
+                // Older plugin hosts don't offer binary framing and keep getting XML.
+                mPeerBinaryFraming = sUseBinaryFraming
+                    && message.hasValue("binary_framing")
+                    && message.getValueBoolean("binary_framing");
+
                 // Plugin host has launched.  Tell it which plugin to load.
                 setState(STATE_HELLO);
             }
@@ -99,6 +99,7 @@ class LLPluginProcessParent final : public LLPluginMessagePipeOwner
 
     // Inherited from LLPluginMessagePipeOwner
     /*virtual*/ void receiveMessageRaw(const std::string &message);
+    /*virtual*/ void receiveMessageParsed(const LLPluginMessage &message);
     /*virtual*/ void receiveMessageEarly(const LLPluginMessage &message);
     /*virtual*/ void setMessagePipe(LLPluginMessagePipe *message_pipe) ;
 
@@ -128,6 +129,9 @@ class LLPluginProcessParent final : public LLPluginMessagePipeOwner
     static bool canPollThreadRun() { return (sPollSet || sPollsetNeedsRebuild || sUseReadThread); };
     static void setUseReadThread(bool use_read_thread);
     static bool getUseReadThread() { return sUseReadThread; };
+    // Binary framing is only used with plugin hosts that offer it in their hello message.
+    static void setUseBinaryFraming(bool use_binary_framing) { sUseBinaryFraming = use_binary_framing; };
+    static bool getUseBinaryFraming() { return sUseBinaryFraming; };
 
     static void shutdown();
 private:
@@ -189,6 +193,7 @@ class LLPluginProcessParent final : public LLPluginMessagePipeOwner
     bool mDebug;
     bool mBlocked;
     bool mPolledInput;
+    bool mPeerBinaryFraming;       // the plugin host said it can read binary frames
 
     LLProcessPtr mDebugger;
 
@@ -196,6 +201,7 @@ class LLPluginProcessParent final : public LLPluginMessagePipeOwner
     F32 mPluginLockupTimeout;       // If we don't receive a heartbeat in this many seconds, we declare the plugin locked up.
 
     static bool sUseReadThread;
+    static bool sUseBinaryFraming;
     apr_pollfd_t mPollFD;
     static apr_pollset_t *sPollSet;
     static bool sPollsetNeedsRebuild;
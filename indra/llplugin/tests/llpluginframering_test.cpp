@@ -0,0 +1,309 @@
+/**
+ * @file llpluginframering_test.cpp
+ * @brief Tests the frame ring a media plugin and the viewer share
+ *
+ * $LicenseInfo:firstyear=2024&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2024, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#include "linden_common.h"
+
+#include "../llpluginframering.h"
+#include "llformat.h"
+#include "llrand.h"
+
+#include "../test/lltut.h"
+
+#include <map>
+
+namespace
+{
+    const S32 WIDTH = 37;
+    const S32 HEIGHT = 23;
+    const S32 DEPTH = 4;
+    const size_t FRAME_SIZE = WIDTH * HEIGHT * DEPTH;
+    // matches the history the ring keeps
+    const U32 HISTORY_SIZE = 16;
+
+    typedef std::vector<U8> image_t;
+
+    // A dirty rect the way plugins hand them over: either way up and not
+    // always inside the frame
+    LLRect random_dirty_rect()
+    {
+        S32 x0 = ll_rand(WIDTH + 10) - 5;
+        S32 x1 = ll_rand(WIDTH + 10) - 5;
+        S32 y0 = ll_rand(HEIGHT + 10) - 5;
+        S32 y1 = ll_rand(HEIGHT + 10) - 5;
+        if (ll_rand(8) == 0)
+        {
+            // a full redraw
+            return LLRect(0, HEIGHT, WIDTH, 0);
+        }
+        return LLRect(x0, y0, x1, y1);
+    }
+
+    // A few pixels somewhere, so a frame that misses one update stays wrong
+    LLRect small_dirty_rect()
+    {
+        S32 x = ll_rand(WIDTH - 2);
+        S32 y = ll_rand(HEIGHT - 2);
+        return LLRect(x, y + 1 + ll_rand(2), x + 1 + ll_rand(2), y);
+    }
+
+    LLRect clip(const LLRect& dirty_rect)
+    {
+        LLRect drawn(llmin(dirty_rect.mLeft, dirty_rect.mRight), llmax(dirty_rect.mTop, dirty_rect.mBottom),
+                     llmax(dirty_rect.mLeft, dirty_rect.mRight), llmin(dirty_rect.mTop, dirty_rect.mBottom));
+        drawn.intersectWith(LLRect(0, HEIGHT, WIDTH, 0));
+        return drawn;
+    }
+
+    // Draws frame sequence into rect of both the plugin's buffer and the reference image
+    void draw(U8* frame, image_t& reference, const LLRect& rect, U32 sequence)
+    {
+        for (S32 y = rect.mBottom; y < rect.mTop; ++y)
+        {
+            for (S32 x = rect.mLeft; x < rect.mRight; ++x)
+            {
+                for (S32 c = 0; c < DEPTH; ++c)
+                {
+                    size_t offset = ((size_t)y * WIDTH + x) * DEPTH + c;
+                    frame[offset] = reference[offset] = (U8)(sequence * 31 + x * 7 + y * 3 + c);
+                }
+            }
+        }
+    }
+
+    void copy(image_t& dst, const U8* src, const LLRect& rect)
+    {
+        for (S32 y = rect.mBottom; y < rect.mTop; ++y)
+        {
+            size_t offset = ((size_t)y * WIDTH + rect.mLeft) * DEPTH;
+            memcpy(&dst[offset], src + offset, (size_t)rect.getWidth() * DEPTH);
+        }
+    }
+
+    bool same(const U8* frame, const image_t& reference)
+    {
+        return memcmp(frame, reference.data(), FRAME_SIZE) == 0;
+    }
+}
+
+namespace tut
+{
+    struct pluginframering_data
+    {
+        pluginframering_data()
+            : mSegment(LLPluginFrameRing::getSegmentSize(FRAME_SIZE)),
+              mReference(FRAME_SIZE, 0),
+              mSequence(0)
+        {
+            ensure("create", mViewer.create(mSegment.data(), mSegment.size(), FRAME_SIZE));
+            ensure("attach", mPlugin.attach(mSegment.data(), mSegment.size()));
+            mIndex = mPlugin.beginFrame();
+        }
+
+        // Plugin side: draws and publishes the next frame, returns the buffer it went into
+        S32 drawFrame(const LLRect& dirty_rect)
+        {
+            S32 index = mIndex;
+            ++mSequence;
+            draw(mPlugin.getFrame(index), mReference, clip(dirty_rect), mSequence);
+            mIndex = mPlugin.endFrame(index, dirty_rect, WIDTH, HEIGHT, DEPTH);
+            mReferences[mSequence] = mReference;
+            if (mSequence > HISTORY_SIZE * 4)
+            {
+                mReferences.erase(mReferences.begin(), mReferences.lower_bound(mSequence - HISTORY_SIZE * 4));
+            }
+            return index;
+        }
+
+        std::vector<U8> mSegment;
+        LLPluginFrameRing mViewer;
+        LLPluginFrameRing mPlugin;
+        S32 mIndex;
+        image_t mReference;
+        std::map<U32, image_t> mReferences;     // what each recent frame should look like
+        U32 mSequence;
+    };
+    typedef test_group<pluginframering_data> pluginframering_test;
+    typedef pluginframering_test::object pluginframering_object;
+    tut::pluginframering_test tpfr("LLPluginFrameRing");
+
+    template<> template<>
+    void pluginframering_object::test<1>()
+    {
+        set_test_name("beginFrame never hands out the newest frame or the one being read");
+
+        S32 newest = -1;
+        S32 reading = -1;
+        for (S32 frame = 0; frame < 2000; ++frame)
+        {
+            // the viewer locks and unlocks between frames, sometimes for a long time
+            if (reading >= 0 && ll_rand(4) == 0)
+            {
+                mViewer.unlockFrame();
+                reading = -1;
+            }
+            else if (reading < 0 && ll_rand(3) == 0)
+            {
+                U32 sequence = 0;
+                reading = mViewer.lockNewestFrame(sequence);
+                ensure_equals("locked the newest", reading, newest);
+                if (reading >= 0)
+                {
+                    ensure_equals("newest sequence", sequence, mSequence);
+                }
+            }
+
+            ensure(llformat("frame %d drawn into a buffer", frame), mIndex >= 0);
+            ensure(llformat("frame %d drawn into the newest", frame), mIndex != newest);
+            ensure(llformat("frame %d drawn into the one being read", frame), mIndex != reading);
+            newest = drawFrame(random_dirty_rect());
+            ensure(llformat("next after frame %d is the newest", frame), mIndex != newest);
+            ensure(llformat("next after frame %d is being read", frame), mIndex != reading);
+        }
+    }
+
+    template<> template<>
+    void pluginframering_object::test<2>()
+    {
+        set_test_name("endFrame brings stale parts of a buffer up to date");
+
+        // Each buffer only gets the dirty rect redrawn, so everything else
+        // has to come from the frames in between.  Holding a lock on one
+        // buffer for long leaves it further behind than the history goes.
+        S32 reading = -1;
+        S32 hold = 0;
+        for (S32 frame = 0; frame < 2000; ++frame)
+        {
+            if (reading >= 0 && --hold <= 0)
+            {
+                mViewer.unlockFrame();
+                reading = -1;
+            }
+            else if (reading < 0 && ll_rand(4) == 0)
+            {
+                U32 sequence = 0;
+                reading = mViewer.lockNewestFrame(sequence);
+                hold = ll_rand(4) == 0 ? HISTORY_SIZE + ll_rand(8) : 1 + ll_rand(3);
+            }
+
+            // small updates while the lock is held, so what the history lost shows
+            S32 index = drawFrame(reading >= 0 ? small_dirty_rect() : random_dirty_rect());
+            ensure(llformat("frame %d complete", frame), same(mPlugin.getFrame(index), mReference));
+        }
+    }
+
+    template<> template<>
+    void pluginframering_object::test<3>()
+    {
+        set_test_name("changed rects bring the viewer's copy up to date");
+
+        // The viewer keeps its own copy, like the media texture, and only
+        // copies what changed since the last frame it took.
+        image_t texture(FRAME_SIZE, 0);
+        U32 taken = 0;
+        U32 updates = 0;
+        for (S32 frame = 0; frame < 3000; ++frame)
+        {
+            // now and then the viewer falls further behind than the history
+            S32 skip = ll_rand(10) == 0 ? ll_rand(HISTORY_SIZE * 2) : ll_rand(3);
+            for (S32 i = 0; i < skip; ++i)
+            {
+                drawFrame(random_dirty_rect());
+            }
+
+            U32 sequence = 0;
+            S32 index = mViewer.lockNewestFrame(sequence);
+            if (index < 0)
+            {
+                continue;
+            }
+
+            std::vector<LLRect> rects;
+            bool changed = mViewer.getChangedRects(taken, sequence, rects);
+            ensure_equals(llformat("history for %u after %u", sequence, taken), changed,
+                          taken != 0 && sequence - taken <= HISTORY_SIZE);
+            if (changed)
+            {
+                for (const LLRect& rect : rects)
+                {
+                    ensure(llformat("rect inside the frame after %u", sequence),
+                           rect.mLeft >= 0 && rect.mBottom >= 0 && rect.mRight <= WIDTH && rect.mTop <= HEIGHT);
+                    copy(texture, mViewer.getFrame(index), rect);
+                }
+                ++updates;
+            }
+            else
+            {
+                copy(texture, mViewer.getFrame(index), LLRect(0, HEIGHT, WIDTH, 0));
+            }
+            mViewer.unlockFrame();
+            taken = sequence;
+
+            ensure(llformat("frame %u taken", sequence), mReferences[sequence] == texture);
+        }
+        ensure("partial updates", updates > 0);
+    }
+
+    template<> template<>
+    void pluginframering_object::test<4>()
+    {
+        set_test_name("changed rects around the end of the history");
+
+        for (U32 i = 0; i < HISTORY_SIZE * 3 + 5; ++i)
+        {
+            drawFrame(LLRect(i % WIDTH, 1, i % WIDTH + 1, 0));
+        }
+
+        std::vector<LLRect> rects;
+        ensure("nothing taken yet", !mViewer.getChangedRects(0, mSequence, rects));
+        ensure("nothing new", mViewer.getChangedRects(mSequence, mSequence, rects) && rects.empty());
+        ensure("whole history", mViewer.getChangedRects(mSequence - HISTORY_SIZE, mSequence, rects));
+        ensure("past the history", !mViewer.getChangedRects(mSequence - HISTORY_SIZE - 1, mSequence, rects));
+        ensure("gone history leaves no rects", rects.empty());
+
+        // the newest frame's history slot is taken over by the next one
+        U32 old_sequence = mSequence;
+        for (U32 i = 0; i < HISTORY_SIZE; ++i)
+        {
+            drawFrame(LLRect(0, 1, 1, 0));
+        }
+        ensure("overwritten", !mViewer.getChangedRects(old_sequence - 1, old_sequence, rects));
+
+        // two adjoining pixels merge, more rects than are worth uploading
+        // one by one become their bounds
+        drawFrame(LLRect(0, 1, 1, 0));
+        drawFrame(LLRect(1, 1, 2, 0));
+        ensure("merged", mViewer.getChangedRects(mSequence - 2, mSequence, rects));
+        ensure_equals("merged count", rects.size(), (size_t)1);
+        ensure("merged rect", rects[0] == LLRect(0, 1, 2, 0));
+        for (S32 i = 0; i < 6; ++i)
+        {
+            drawFrame(LLRect(i * 5, 10, i * 5 + 2, 8));
+        }
+        ensure("bounds", mViewer.getChangedRects(mSequence - 6, mSequence, rects));
+        ensure_equals("bounds count", rects.size(), (size_t)1);
+        ensure("bounds rect", rects[0] == LLRect(0, 10, 27, 8));
+    }
+}
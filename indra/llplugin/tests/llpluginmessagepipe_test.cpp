@@ -0,0 +1,251 @@
+/**
+ * @file llpluginmessagepipe_test.cpp
+ * @brief Tests the framing of messages read from a plugin pipe
+ *
+ * $LicenseInfo:firstyear=2024&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2024, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#include "linden_common.h"
+
+#include "../llpluginmessage.h"
+#include "../llpluginmessagepipe.h"
+#include "llformat.h"
+
+#include "../test/lltut.h"
+
+namespace
+{
+    // Records what the pipe hands over, as "class name index"
+    class TestOwner : public LLPluginMessagePipeOwner
+    {
+    public:
+        void receiveMessageRaw(const std::string &message) override
+        {
+            LLPluginMessage parsed;
+            if (parsed.parse(message) >= 0)
+            {
+                record("xml", parsed);
+            }
+            else
+            {
+                mReceived.push_back("bad xml");
+            }
+        }
+
+        void receiveMessageParsed(const LLPluginMessage &message) override
+        {
+            record("binary", message);
+        }
+
+        apr_status_t socketError(apr_status_t error) override
+        {
+            mErrors.push_back(error);
+            return LLPluginMessagePipeOwner::socketError(error);
+        }
+
+        void record(const std::string& framing, const LLPluginMessage& message)
+        {
+            mReceived.push_back(llformat("%s %s %s %d", framing.c_str(), message.getClass().c_str(),
+                                         message.getName().c_str(), message.getValueS32("index")));
+        }
+
+        std::vector<std::string> mReceived;
+        std::vector<apr_status_t> mErrors;
+    };
+
+    // A pipe without a socket: input is fed in by hand, output is only collected
+    class TestPipe : public LLPluginMessagePipe
+    {
+    public:
+        TestPipe(LLPluginMessagePipeOwner* owner)
+            : LLPluginMessagePipe(owner, LLSocket::ptr_t())
+        {
+        }
+
+        bool feed(const std::string& bytes)
+        {
+            {
+                LLMutexLock lock(&mInputMutex);
+                mInput.append(bytes);
+            }
+            return processInput();
+        }
+
+        std::string takeOutput()
+        {
+            LLMutexLock lock(&mOutputMutex);
+            std::string output(mOutput, mOutputStartIndex);
+            mOutput.clear();
+            mOutputStartIndex = 0;
+            return output;
+        }
+    };
+
+    LLPluginMessage make_message(const std::string& name, S32 index)
+    {
+        LLPluginMessage message("test", name);
+        message.setValueS32("index", index);
+        message.setValue("padding", std::string(index * 7, 'x'));
+        return message;
+    }
+}
+
+namespace tut
+{
+    struct pluginmessagepipe_data
+    {
+        pluginmessagepipe_data()
+            : mPipe(&mOwner)
+        {
+        }
+
+        // Frames messages the way the writing end does, alternating XML and binary
+        std::string mixedStream(S32 count)
+        {
+            for (S32 i = 0; i < count; ++i)
+            {
+                LLPluginMessage message = make_message(i % 2 ? "binary" : "xml", i);
+                if (i % 2)
+                {
+                    mPipe.addBinaryMessage(message.generateBinary());
+                }
+                else
+                {
+                    mPipe.addMessage(message.generate());
+                }
+            }
+            return mPipe.takeOutput();
+        }
+
+        void ensureMixed(const std::string& desc, const TestOwner& owner, S32 count)
+        {
+            ensure_equals(desc + " count", owner.mReceived.size(), (size_t)count);
+            for (S32 i = 0; i < count; ++i)
+            {
+                const char* framing = i % 2 ? "binary" : "xml";
+                ensure_equals(llformat("%s message %d", desc.c_str(), i), owner.mReceived[i],
+                              llformat("%s test %s %d", framing, framing, i));
+            }
+            ensure(desc + " no errors", owner.mErrors.empty());
+        }
+
+        TestOwner mOwner;
+        TestPipe mPipe;
+    };
+    typedef test_group<pluginmessagepipe_data> pluginmessagepipe_test;
+    typedef pluginmessagepipe_test::object pluginmessagepipe_object;
+    tut::pluginmessagepipe_test tpmp("LLPluginMessagePipe");
+
+    template<> template<>
+    void pluginmessagepipe_object::test<1>()
+    {
+        set_test_name("XML and binary frames in one stream");
+
+        const S32 COUNT = 10;
+        ensure("framed", mPipe.feed(mixedStream(COUNT)));
+        ensureMixed("whole stream", mOwner, COUNT);
+    }
+
+    template<> template<>
+    void pluginmessagepipe_object::test<2>()
+    {
+        set_test_name("frames split across reads");
+
+        const S32 COUNT = 4;
+        const std::string stream = mixedStream(COUNT);
+
+        // every split point, including inside the binary header and the length
+        for (size_t split = 1; split < stream.size(); ++split)
+        {
+            TestOwner owner;
+            TestPipe pipe(&owner);
+            ensure("first part", pipe.feed(stream.substr(0, split)));
+            ensure("second part", pipe.feed(stream.substr(split)));
+            ensureMixed(llformat("split at %u", (U32)split), owner, COUNT);
+        }
+
+        // and a byte at a time
+        TestOwner owner;
+        TestPipe pipe(&owner);
+        for (size_t i = 0; i < stream.size(); ++i)
+        {
+            ensure("byte", pipe.feed(stream.substr(i, 1)));
+        }
+        ensureMixed("byte at a time", owner, COUNT);
+    }
+
+    template<> template<>
+    void pluginmessagepipe_object::test<3>()
+    {
+        set_test_name("header shorter than 5 bytes");
+
+        mPipe.addBinaryMessage(make_message("binary", 1).generateBinary());
+        const std::string frame = mPipe.takeOutput();
+
+        for (size_t length = 1; length < 5; ++length)
+        {
+            TestOwner owner;
+            TestPipe pipe(&owner);
+            ensure("short header", pipe.feed(frame.substr(0, length)));
+            ensure(llformat("nothing from %u header bytes", (U32)length), owner.mReceived.empty());
+            ensure("rest", pipe.feed(frame.substr(length)));
+            ensure_equals(llformat("message after %u header bytes", (U32)length), owner.mReceived.size(), (size_t)1);
+            ensure_equals("message", owner.mReceived[0], std::string("binary test binary 1"));
+        }
+    }
+
+    template<> template<>
+    void pluginmessagepipe_object::test<4>()
+    {
+        set_test_name("unparseable binary body");
+
+        // the frame is dropped, the stream goes on after it
+        mPipe.addBinaryMessage(std::string("\xff\xfe not binary LLSD"));
+        mPipe.addMessage(make_message("xml", 2).generate());
+        mPipe.addBinaryMessage(make_message("binary", 3).generateBinary());
+        ensure("framed", mPipe.feed(mPipe.takeOutput()));
+
+        ensure_equals("count", mOwner.mReceived.size(), (size_t)2);
+        ensure_equals("after bad frame", mOwner.mReceived[0], std::string("xml test xml 2"));
+        ensure_equals("binary after bad frame", mOwner.mReceived[1], std::string("binary test binary 3"));
+        ensure("no errors", mOwner.mErrors.empty());
+    }
+
+    template<> template<>
+    void pluginmessagepipe_object::test<5>()
+    {
+        set_test_name("length over the limit");
+
+        // a length that would have the pipe buffer 4 GB before it saw the end
+        mPipe.addMessage(make_message("xml", 0).generate());
+        std::string stream = mPipe.takeOutput();
+        stream += std::string("\x01\xff\xff\xff\xf0", 5);
+        ensure("rejected", !mPipe.feed(stream));
+        ensure_equals("message before it", mOwner.mReceived.size(), (size_t)1);
+        ensure_equals("error", mOwner.mErrors.size(), (size_t)1);
+        ensure_equals("error status", mOwner.mErrors[0], (apr_status_t)APR_EGENERAL);
+
+        // and the writing end won't produce one
+        ensure("too big to send", !mPipe.addBinaryMessage(std::string(16 * 1024 * 1024 + 1, 'x')));
+        ensure("nothing queued", mPipe.takeOutput().empty());
+    }
+}
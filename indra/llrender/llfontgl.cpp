@@ -44,6 +44,8 @@
 
 // Third party library includes
 #include <boost/tokenizer.hpp>
+#include <algorithm>
+#include <unordered_map>
 
 #if LL_WINDOWS
 #include <Shlobj.h>
@@ -73,11 +75,280 @@ const F32 DROP_SHADOW_SOFT_STRENGTH = 0.3f;
 
 const U32 GLYPH_VERTICES = 6;
 
+namespace
+{
+    // Runs longer than this are measured glyph by glyph every time; they are
+    // rarely measured twice and would only push the short ones out
+    const S32 MAX_CACHED_RUN = 256;
+
+    // each generation of the run cache holds this many runs before the
+    // older generation is dropped
+    const size_t RUN_CACHE_GENERATION = 2048;
+
+    // Measurements of one run of text in one face, in unscaled pixels.  Width
+    // runs hold what getWidthF32() needs, break runs what maxDrawableChars()
+    // needs; the text of a break run includes the character following it,
+    // which decides whether a trailing punctuation mark ends a word.
+    struct FontRun
+    {
+        const LLFontFreetype* mFont;
+        bool mBreaks;
+        LLWString mText;
+
+        F32 mWidth;                     // rounded advance of the whole run
+        F32 mPadding;                   // width of the last glyph past its advance
+
+        std::vector<F32> mFit;          // width needed to draw through each character, never decreasing
+        std::vector<S32> mWordStart;    // start of the last word as of each character
+        S32 mMissingGlyph;              // first character without a glyph, or the run length
+    };
+
+    typedef std::unordered_map<U64, FontRun> font_run_map_t;
+
+    // Shared by every LLFontGL, so the same text measured in the same face
+    // through a different font object, or by a different widget, is a hit.
+    // Fonts are only measured on the main thread, like LLFontFreetype's
+    // glyph map.
+    font_run_map_t sFontRuns;
+    font_run_map_t sOldFontRuns;
+
+    U64 hash_run(const LLFontFreetype* font, bool breaks, const llwchar* wchars, S32 length)
+    {
+        // FNV-1a
+        U64 hash = 14695981039346656037ULL;
+        hash = (hash ^ (U64)(uintptr_t)font) * 1099511628211ULL;
+        hash = (hash ^ (U64)breaks) * 1099511628211ULL;
+        for (S32 i = 0; i < length; ++i)
+        {
+            hash = (hash ^ (U64)wchars[i]) * 1099511628211ULL;
+        }
+        return hash;
+    }
+
+    bool run_matches(const FontRun& run, const LLFontFreetype* font, bool breaks, const llwchar* wchars, S32 length)
+    {
+        return run.mFont == font
+            && run.mBreaks == breaks
+            && run.mText.size() == (size_t)length
+            && std::equal(wchars, wchars + length, run.mText.begin());
+    }
+
+    // Returns the number of characters of wchars before its terminator or
+    // max_chars, or -1 if that is more than MAX_CACHED_RUN
+    S32 run_length(const llwchar* wchars, S32 max_chars)
+    {
+        S32 limit = llmin(max_chars, MAX_CACHED_RUN);
+        S32 i = 0;
+        while (i < limit && wchars[i])
+        {
+            ++i;
+        }
+        return (i == max_chars || !wchars[i]) ? i : -1;
+    }
+
+    // Tracks the start of the last word across character i, as maxDrawableChars()
+    // does to break lines on word boundaries
+    void track_word(const llwchar* wchars, S32 i, BOOL& in_word, S32& start_of_last_word)
+    {
+        llwchar wch = wchars[i];
+        if (in_word)
+        {
+            if (iswspace(wch))
+            {
+                if(wch !=(0x00A0))
+                {
+                    in_word = FALSE;
+                }
+            }
+            if (iswindividual(wch))
+            {
+                if (iswpunct(wchars[i+1]))
+                {
+                    in_word=TRUE;
+                }
+                else
+                {
+                    in_word=FALSE;
+                    start_of_last_word = i;
+                }
+            }
+        }
+        else
+        {
+            start_of_last_word = i;
+            if (!iswspace(wch)||!iswindividual(wch))
+            {
+                in_word = TRUE;
+            }
+        }
+    }
+
+    // Rounded advance of up to max_chars characters of wchars from begin_offset,
+    // and how far the last glyph reaches past it
+    void measure_width(const LLFontFreetype* font, const llwchar* wchars, S32 begin_offset, S32 max_chars, F32& width, F32& padding)
+    {
+        const S32 LAST_CHARACTER = LLFontFreetype::LAST_CHAR_FULL;
+
+        F32 cur_x = 0;
+        const S32 max_index = begin_offset + max_chars;
+
+        const LLFontGlyphInfo* next_glyph = NULL;
+
+        F32 width_padding = 0.f;
+        for (S32 i = begin_offset; i < max_index && wchars[i] != 0; i++)
+        {
+            llwchar wch = wchars[i];
+
+            const LLFontGlyphInfo* fgi = next_glyph;
+            next_glyph = NULL;
+            if(!fgi)
+            {
+                fgi = font->getGlyphInfo(wch, EFontGlyphType::Unspecified);
+            }
+
+            F32 advance = font->getXAdvance(fgi);
+
+            // for the last character we want to measure the greater of its width and xadvance values
+            // so keep track of the difference between these values for the each character we measure
+            // so we can fix things up at the end
+            width_padding = llmax(0.f,                                          // always use positive padding amount
+                width_padding - advance,                        // previous padding left over after advance of current character
+                (F32)(fgi->mWidth + fgi->mXBearing) - advance); // difference between width of this character and advance to next character
+
+            cur_x += advance;
+            llwchar next_char = wchars[i+1];
+
+            if (((i + 1) < begin_offset + max_chars)
+                && next_char
+                && (next_char < LAST_CHARACTER))
+            {
+                // Kern this puppy.
+                next_glyph = font->getGlyphInfo(next_char, EFontGlyphType::Unspecified);
+                cur_x += font->getXKerning(fgi, next_glyph);
+            }
+            // Round after kerning.
+            cur_x = (F32)ll_round(cur_x);
+        }
+
+        width = cur_x;
+        padding = width_padding;
+    }
+
+    // Fills in the break run of the first length characters of wchars
+    void measure_breaks(const LLFontFreetype* font, const llwchar* wchars, S32 length, FontRun& run)
+    {
+        run.mFit.reserve(length);
+        run.mWordStart.reserve(length);
+        run.mMissingGlyph = length;
+
+        F32 cur_x = 0;
+        F32 fit = 0.f;
+        S32 start_of_last_word = 0;
+        BOOL in_word = FALSE;
+        F32 width_padding = 0.f;
+
+        LLFontGlyphInfo* next_glyph = NULL;
+
+        for (S32 i = 0; i < length; i++)
+        {
+            track_word(wchars, i, in_word, start_of_last_word);
+
+            LLFontGlyphInfo* fgi = next_glyph;
+            next_glyph = NULL;
+            if(!fgi)
+            {
+                fgi = font->getGlyphInfo(wchars[i], EFontGlyphType::Unspecified);
+
+                if (NULL == fgi)
+                {
+                    run.mMissingGlyph = i;
+                    break;
+                }
+            }
+
+            width_padding = llmax(  0.f,
+                                    width_padding - fgi->mXAdvance,
+                                    (F32)(fgi->mWidth + fgi->mXBearing) - fgi->mXAdvance);
+
+            cur_x += fgi->mXAdvance;
+
+            fit = llmax(fit, cur_x + width_padding);
+            run.mFit.push_back(fit);
+            run.mWordStart.push_back(start_of_last_word);
+
+            if ((i+1) < length)
+            {
+                next_glyph = font->getGlyphInfo(wchars[i+1], EFontGlyphType::Unspecified);
+                cur_x += font->getXKerning(fgi, next_glyph);
+            }
+
+            cur_x = (F32)ll_round(cur_x);
+        }
+    }
+
+    // Returns the cached run of the first length characters of wchars,
+    // measuring it first if need be
+    const FontRun& get_run(const LLFontFreetype* font, bool breaks, const llwchar* wchars, S32 length)
+    {
+        LL_PROFILE_ZONE_SCOPED_CATEGORY_UI
+        U64 hash = hash_run(font, breaks, wchars, length);
+
+        font_run_map_t::iterator iter = sFontRuns.find(hash);
+        if (iter != sFontRuns.end() && run_matches(iter->second, font, breaks, wchars, length))
+        {
+            return iter->second;
+        }
+
+        if (iter == sFontRuns.end())
+        {
+            font_run_map_t::iterator old_iter = sOldFontRuns.find(hash);
+            if (old_iter != sOldFontRuns.end() && run_matches(old_iter->second, font, breaks, wchars, length))
+            {
+                // still in use, keep it through the next generation
+                return sFontRuns.insert(sOldFontRuns.extract(old_iter)).position->second;
+            }
+        }
+
+        if (iter == sFontRuns.end() && sFontRuns.size() >= RUN_CACHE_GENERATION)
+        {
+            sOldFontRuns.swap(sFontRuns);
+            sFontRuns.clear();
+        }
+
+        // replaces a run with the same hash
+        FontRun& run = sFontRuns[hash];
+        run.mFont = font;
+        run.mBreaks = breaks;
+        run.mText.assign(wchars, length);
+        run.mFit.clear();
+        run.mWordStart.clear();
+        if (breaks)
+        {
+            // the last character only decides the word break before it
+            measure_breaks(font, wchars, length - 1, run);
+        }
+        else
+        {
+            measure_width(font, wchars, 0, length, run.mWidth, run.mPadding);
+        }
+        return run;
+    }
+}
+
 void LLFontGL::reset()
 {
+    // glyph metrics may change with the resolution
+    flushRunCache();
     mFontFreetype->reset(sVertDPI, sHorizDPI);
 }
 
+//static
+void LLFontGL::flushRunCache()
+{
+    sFontRuns.clear();
+    sOldFontRuns.clear();
+}
+
 void LLFontGL::destroyGL()
 {
     mFontFreetype->destroyGL();
@@ -500,50 +771,19 @@ F32 LLFontGL::getWidthF32(const std::string& utf8text, S32 begin_offset, S32 max
 
 F32 LLFontGL::getWidthF32(const llwchar* wchars, S32 begin_offset, S32 max_chars, bool no_padding) const
 {
-    const S32 LAST_CHARACTER = LLFontFreetype::LAST_CHAR_FULL;
-
     F32 cur_x = 0;
-    const S32 max_index = begin_offset + max_chars;
-
-    const LLFontGlyphInfo* next_glyph = NULL;
-
     F32 width_padding = 0.f;
-    for (S32 i = begin_offset; i < max_index && wchars[i] != 0; i++)
-    {
-        llwchar wch = wchars[i];
-
-        const LLFontGlyphInfo* fgi = next_glyph;
-        next_glyph = NULL;
-        if(!fgi)
-        {
-            fgi = mFontFreetype->getGlyphInfo(wch, EFontGlyphType::Unspecified);
-        }
-
-        F32 advance = mFontFreetype->getXAdvance(fgi);
-
-        if (!no_padding)
-        {
-            // for the last character we want to measure the greater of its width and xadvance values
-            // so keep track of the difference between these values for the each character we measure
-            // so we can fix things up at the end
-            width_padding = llmax(0.f,                                          // always use positive padding amount
-                width_padding - advance,                        // previous padding left over after advance of current character
-                (F32)(fgi->mWidth + fgi->mXBearing) - advance); // difference between width of this character and advance to next character
-        }
 
-        cur_x += advance;
-        llwchar next_char = wchars[i+1];
-
-        if (((i + 1) < begin_offset + max_chars)
-            && next_char
-            && (next_char < LAST_CHARACTER))
-        {
-            // Kern this puppy.
-            next_glyph = mFontFreetype->getGlyphInfo(next_char, EFontGlyphType::Unspecified);
-            cur_x += mFontFreetype->getXKerning(fgi, next_glyph);
-        }
-        // Round after kerning.
-        cur_x = (F32)ll_round(cur_x);
+    S32 length = run_length(wchars + begin_offset, max_chars);
+    if (length >= 0)
+    {
+        const FontRun& run = get_run(mFontFreetype, false, wchars + begin_offset, length);
+        cur_x = run.mWidth;
+        width_padding = run.mPadding;
+    }
+    else
+    {
+        measure_width(mFontFreetype, wchars, begin_offset, max_chars, cur_x, width_padding);
     }
 
     if (!no_padding)
@@ -586,85 +826,75 @@ S32 LLFontGL::maxDrawableChars(const llwchar* wchars, F32 max_pixels, S32 max_ch
     F32 scaled_max_pixels = max_pixels * sScaleX;
     F32 width_padding = 0.f;
 
-    LLFontGlyphInfo* next_glyph = NULL;
-
     S32 i;
-    for (i=0; (i < max_chars); i++)
+    S32 length = run_length(wchars, max_chars);
+    if (length >= 0)
     {
-        llwchar wch = wchars[i];
-
-        if(wch == 0)
+        // the character following the run decides whether its last one ends a word
+        const FontRun& run = get_run(mFontFreetype, true, wchars, length + 1);
+        i = (S32)(std::upper_bound(run.mFit.begin(), run.mFit.end(), scaled_max_pixels) - run.mFit.begin());
+        if (i < (S32)run.mFit.size())
         {
-            // Null terminator.  We're done.
-            break;
+            clip = TRUE;
+            start_of_last_word = run.mWordStart[i];
         }
+        else if (run.mMissingGlyph < length)
+        {
+            return 0;
+        }
+    }
+    else
+    {
+        LLFontGlyphInfo* next_glyph = NULL;
 
-        if (in_word)
+        for (i=0; (i < max_chars); i++)
         {
-            if (iswspace(wch))
+            llwchar wch = wchars[i];
+
+            if(wch == 0)
             {
-                if(wch !=(0x00A0))
-                {
-                    in_word = FALSE;
-                }
+                // Null terminator.  We're done.
+                break;
             }
-            if (iswindividual(wch))
+
+            track_word(wchars, i, in_word, start_of_last_word);
+
+            LLFontGlyphInfo* fgi = next_glyph;
+            next_glyph = NULL;
+            if(!fgi)
             {
-                if (iswpunct(wchars[i+1]))
-                {
-                    in_word=TRUE;
-                }
-                else
+                fgi = mFontFreetype->getGlyphInfo(wch, EFontGlyphType::Unspecified);
+
+                if (NULL == fgi)
                 {
-                    in_word=FALSE;
-                    start_of_last_word = i;
+                    return 0;
                 }
             }
-        }
-        else
-        {
-            start_of_last_word = i;
-            if (!iswspace(wch)||!iswindividual(wch))
-            {
-                in_word = TRUE;
-            }
-        }
 
-        LLFontGlyphInfo* fgi = next_glyph;
-        next_glyph = NULL;
-        if(!fgi)
-        {
-            fgi = mFontFreetype->getGlyphInfo(wch, EFontGlyphType::Unspecified);
+            // account for glyphs that run beyond the starting point for the next glyphs
+            width_padding = llmax(  0.f,                                                    // always use positive padding amount
+                                    width_padding - fgi->mXAdvance,                         // previous padding left over after advance of current character
+                                    (F32)(fgi->mWidth + fgi->mXBearing) - fgi->mXAdvance);  // difference between width of this character and advance to next character
 
-            if (NULL == fgi)
+            cur_x += fgi->mXAdvance;
+
+            // clip if current character runs past scaled_max_pixels (using width_padding)
+            if (scaled_max_pixels < cur_x + width_padding)
             {
-                return 0;
+                clip = TRUE;
+                break;
             }
-        }
-
-        // account for glyphs that run beyond the starting point for the next glyphs
-        width_padding = llmax(  0.f,                                                    // always use positive padding amount
-                                width_padding - fgi->mXAdvance,                         // previous padding left over after advance of current character
-                                (F32)(fgi->mWidth + fgi->mXBearing) - fgi->mXAdvance);  // difference between width of this character and advance to next character
 
-        cur_x += fgi->mXAdvance;
+            if (((i+1) < max_chars) && wchars[i+1])
+            {
+                // Kern this puppy.
+                next_glyph = mFontFreetype->getGlyphInfo(wchars[i+1], EFontGlyphType::Unspecified);
+                cur_x += mFontFreetype->getXKerning(fgi, next_glyph);
+            }
 
-        // clip if current character runs past scaled_max_pixels (using width_padding)
-        if (scaled_max_pixels < cur_x + width_padding)
-        {
-            clip = TRUE;
-            break;
+            // Round after kerning.
+            cur_x = (F32)ll_round(cur_x);
         }
-
-        if (((i+1) < max_chars) && wchars[i+1])
-        {
-            // Kern this puppy.
-            next_glyph = mFontFreetype->getGlyphInfo(wchars[i+1], EFontGlyphType::Unspecified);
-            cur_x += mFontFreetype->getXKerning(fgi, next_glyph);
-        }
-
-        // Round after kerning.
-        cur_x = (F32)ll_round(cur_x);
     }
 
     if( clip )
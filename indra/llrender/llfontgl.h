@@ -179,6 +179,10 @@ class LLFontGL
     static void destroyDefaultFonts();
     static void destroyAllGL();
 
+    // Drops the measurements getWidthF32() and maxDrawableChars() keep of
+    // runs of text, for when glyph metrics change or fonts go away
+    static void flushRunCache();
+
     // Takes a string with potentially several flags, i.e. "NORMAL|BOLD|ITALIC"
     static U8 getStyleFromString(const std::string &style);
     static std::string getStringFromStyle(U8 style);
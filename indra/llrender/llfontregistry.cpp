@@ -600,6 +600,7 @@ void LLFontRegistry::reset()
 
 void LLFontRegistry::clear()
 {
+    LLFontGL::flushRunCache();
     for (font_reg_map_t::iterator it = mFontMap.begin();
          it != mFontMap.end();
          ++it)
@@ -3603,7 +3603,7 @@ bool LLFloater::initFloaterXML(LLXMLNodePtr node, LLView *parent, const std::str
 
         uifactory_inst.pushFileName(xml_filename);
 
-        if (!LLUICtrlFactory::getLayeredXMLNode(xml_filename, referenced_xml))
+        if (!LLUICtrlFactory::getLayeredXMLNode(xml_filename, referenced_xml, LLDir::CURRENT_SKIN, true))
         {
             LL_WARNS() << "Couldn't parse panel from: " << xml_filename << LL_ENDL;
 
@@ -3728,7 +3728,7 @@ bool LLFloater::buildFromFile(const std::string& filename)
     LL_PROFILE_ZONE_SCOPED;
     LLXMLNodePtr root;
 
-    if (!LLUICtrlFactory::getLayeredXMLNode(filename, root))
+    if (!LLUICtrlFactory::getLayeredXMLNode(filename, root, LLDir::CURRENT_SKIN, true))
     {
         LL_WARNS() << "Couldn't find (or parse) floater from: " << filename << LL_ENDL;
         return false;
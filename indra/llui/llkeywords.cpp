@@ -28,6 +28,7 @@
 
 #include <iostream>
 #include <fstream>
+#include <algorithm>
 
 #include "llkeywords.h"
 #include "llsdserialize.h"
@@ -68,8 +69,27 @@ inline bool LLKeywordToken::isTail(const llwchar* s) const
     return res;
 }
 
+namespace
+{
+    // FNV-1a over the characters of a word, for the word table
+    inline U32 hash_word(const llwchar* word, S32 length)
+    {
+        U32 hash = 2166136261u;
+        for (S32 i = 0; i < length; i++)
+        {
+            hash = (hash ^ (U32)word[i]) * 16777619u;
+        }
+        return hash;
+    }
+}
+
 LLKeywords::LLKeywords()
-:   mLoaded(false)
+:   mLoaded(false),
+    mWordTableMask(0),
+    mMinWordLength(S32_MAX),
+    mMaxWordLength(0),
+    mTokenStyleFont(NULL),
+    mLastLength(-1)
 {
 }
 
@@ -309,9 +329,89 @@ void LLKeywords::processTokens()
             }
         }
     }
+    buildWordTable();
+    mTokenStyles.clear();
+    clearSegmentState();
     LL_INFOS("SyntaxLSL") << "Finished processing tokens." << LL_ENDL;
 }
 
+// Lay the word tokens out in a table kept at most half full, so a lookup is a hash
+// of the word and usually a single compare.
+void LLKeywords::buildWordTable()
+{
+    size_t size = 16;
+    while (size < mWordTokenMap.size() * 2)
+    {
+        size <<= 1;
+    }
+    WordSlot empty_slot = { NULL, 0, NULL };
+    mWordTable.assign(size, empty_slot);
+    mWordTableMask = (U32)size - 1;
+    mMinWordLength = S32_MAX;
+    mMaxWordLength = 0;
+
+    for (const auto& word_pair : mWordTokenMap)
+    {
+        LLKeywordToken* token = word_pair.second;
+        const LLWString& word = token->getToken();
+        S32 length = (S32)word.size();
+
+        U32 slot = hash_word(word.data(), length) & mWordTableMask;
+        while (mWordTable[slot].mToken)
+        {
+            slot = (slot + 1) & mWordTableMask;
+        }
+        WordSlot& entry = mWordTable[slot];
+        entry.mData = word.data();
+        entry.mLength = length;
+        entry.mToken = token;
+
+        mMinWordLength = llmin(mMinWordLength, length);
+        mMaxWordLength = llmax(mMaxWordLength, length);
+    }
+}
+
+LLKeywordToken* LLKeywords::findWordToken(const llwchar* word, S32 length) const
+{
+    if (length < mMinWordLength || length > mMaxWordLength)
+    {
+        return NULL;
+    }
+
+    for (U32 slot = hash_word(word, length) & mWordTableMask; mWordTable[slot].mToken; slot = (slot + 1) & mWordTableMask)
+    {
+        const WordSlot& entry = mWordTable[slot];
+        if (entry.mLength == length && !memcmp(entry.mData, word, length * sizeof(llwchar)))
+        {
+            return entry.mToken;
+        }
+    }
+    return NULL;
+}
+
+LLStyleConstSP LLKeywords::getTokenStyle(const LLKeywordToken* token, LLStyleConstSP style)
+{
+    const LLFontGL* font = style->getFont();
+    if (font != mTokenStyleFont)
+    {
+        mTokenStyles.clear();
+        mTokenStyleFont = font;
+    }
+
+    LLStyleConstSP& token_style = mTokenStyles[token];
+    if (token_style.isNull())
+    {
+        token_style = new LLStyle(LLStyle::Params().font(font).color(token->getColor()));
+    }
+    return token_style;
+}
+
+void LLKeywords::clearSegmentState()
+{
+    mLineStates.clear();
+    mLastLength = -1;
+}
+
 void LLKeywords::processTokensGroup(const LLSD& tokens, std::string_view group)
 {
     LLColor4 color;
@@ -536,27 +636,215 @@ void LLKeywords::findSegments(std::vector<LLTextSegmentPtr>* seg_list, const LLW
 {
     LL_RECORD_BLOCK_TIME(FTM_SYNTAX_COLORING);
     seg_list->clear();
+    mLineStates.clear();
+    mLastLength = wtext.size();
 
     if( wtext.empty() )
     {
         return;
     }
 
+    line_state_vec_t line_states;
+    scanSegments(*seg_list, wtext, editor, style, 0, NULL, S32_MAX, 0, line_states);
+    mLineStates.swap(line_states);
+}
+
+void LLKeywords::findSegments(std::vector<LLTextSegmentPtr>* seg_list, const LLWString& wtext, LLTextEditor& editor, LLStyleConstSP style, S32& start, S32& end)
+{
+    if (mLastLength < 0)
+    {
+        findSegments(seg_list, wtext, editor, style);
+        start = 0;
+        end = wtext.size() + 1;
+        return;
+    }
+
+    LL_RECORD_BLOCK_TIME(FTM_SYNTAX_COLORING);
+    seg_list->clear();
+
+    S32 length = wtext.size();
+    S32 delta = length - mLastLength;
+    start = llclamp(start, 0, length);
+    end = llclamp(end, start, length);
+
+    // pick up at the last line starting before the change, in the state it starts in
+    auto before_pos = [](const LineState& state, S32 pos) { return state.mPos < pos; };
+    line_state_vec_t::iterator line_iter = std::lower_bound(mLineStates.begin(), mLineStates.end(), start, before_pos);
+    S32 window_start = 0;
+    LLKeywordToken* open_delimiter = NULL;
+    if (line_iter != mLineStates.begin())
+    {
+        --line_iter;
+        window_start = line_iter->mPos;
+        open_delimiter = line_iter->mDelimiter;
+    }
+    line_state_vec_t line_states(mLineStates.begin(), line_iter);
+
+    S32 window_end = length + 1;
+    if (length > 0)
+    {
+        window_end = scanSegments(*seg_list, wtext, editor, style, window_start, open_delimiter, end, delta, line_states);
+    }
+
+    if (window_end <= length)
+    {
+        // lines after the window start as they did, just shifted
+        line_iter = std::lower_bound(mLineStates.begin(), mLineStates.end(), window_end - delta, before_pos);
+        for (; line_iter != mLineStates.end(); ++line_iter)
+        {
+            LineState state = { line_iter->mPos + delta, line_iter->mDelimiter };
+            line_states.push_back(state);
+        }
+    }
+
+    mLineStates.swap(line_states);
+    mLastLength = length;
+    start = window_start;
+    end = window_end;
+}
+
+// Tokenize from start, which is 0 or the '\n' ending a line, to the end of the text
+// or to the first line at or after resync_from that starts in the same state it did
+// in the last pass; returns where it stopped. Line states are added to line_states.
+S32 LLKeywords::scanSegments(std::vector<LLTextSegmentPtr>& seg_list, const LLWString& wtext, LLTextEditor& editor, LLStyleConstSP style,
+                             S32 start, LLKeywordToken* open_delimiter, S32 resync_from, S32 delta, line_state_vec_t& line_states)
+{
     S32 text_len = wtext.size() + 1;
 
-    seg_list->push_back( new LLNormalTextSegment( style, 0, text_len, editor ) );
+    seg_list.push_back( new LLNormalTextSegment( style, start, text_len, editor ) );
 
     const llwchar* base = wtext.c_str();
-    const llwchar* cur = base;
+    const llwchar* cur = base + start;
+
+    line_state_vec_t::const_iterator old_iter = mLineStates.begin();
+    auto resync = [&](S32 pos, LLKeywordToken* delimiter)
+    {
+        if (pos >= resync_from)
+        {
+            S32 old_pos = pos - delta;
+            while (old_iter != mLineStates.end() && old_iter->mPos < old_pos)
+            {
+                ++old_iter;
+            }
+            if (old_iter != mLineStates.end() && old_iter->mPos == old_pos && old_iter->mDelimiter == delimiter)
+            {
+                return true;
+            }
+        }
+        LineState state = { pos, delimiter };
+        line_states.push_back(state);
+        return false;
+    };
+
+    auto stop = [&](S32 pos)
+    {
+        // cut the default segment trailing the window off where it stops, along
+        // with the empty piece a delimited run leaves when it stops on a blank line
+        while (!seg_list.empty() && seg_list.back()->getStart() >= pos)
+        {
+            seg_list.pop_back();
+        }
+        if (!seg_list.empty() && seg_list.back()->getEnd() > pos)
+        {
+            seg_list.back()->setEnd(pos);
+        }
+        return pos;
+    };
+
+    // cur is just past the head of the delimiter, or on the '\n' of a line that
+    // starts inside it; returns true if the window ends inside the delimited run
+    auto scan_delimited = [&](LLKeywordToken* cur_delimiter, S32 seg_start)
+    {
+        S32 seg_end = 0;
+
+        LLKeywordToken::ETokenType type = cur_delimiter->getType();
+        if( type == LLKeywordToken::TT_TWO_SIDED_DELIMITER || type == LLKeywordToken::TT_DOUBLE_QUOTATION_MARKS )
+        {
+            while( *cur && !cur_delimiter->isTail(cur))
+            {
+                if (*cur == '\n' && resync(cur - base, cur_delimiter))
+                {
+                    insertSegments(wtext, seg_list, cur_delimiter, text_len, seg_start, cur - base, style, editor);
+                    return true;
+                }
+
+                // Check for an escape sequence.
+                if (type == LLKeywordToken::TT_DOUBLE_QUOTATION_MARKS && *cur == '\\')
+                {
+                    // Count the number of backslashes.
+                    S32 num_backslashes = 0;
+                    while (*cur == '\\')
+                    {
+                        num_backslashes++;
+                        cur++;
+                    }
+                    // If the next character is the end delimiter?
+                    if (cur_delimiter->isTail(cur))
+                    {
+                        // If there was an odd number of backslashes, then this delimiter
+                        // does not end the sequence.
+                        if (num_backslashes % 2 == 1)
+                        {
+                            cur++;
+                        }
+                        else
+                        {
+                            // This is an end delimiter.
+                            break;
+                        }
+                    }
+                }
+                else
+                {
+                    cur++;
+                }
+            }
+
+            if( *cur )
+            {
+                seg_end = (cur - base) + cur_delimiter->getLengthTail();
+                cur += cur_delimiter->getLengthHead();
+            }
+            else
+            {
+                // eof
+                seg_end = cur - base;
+            }
+        }
+        else
+        {
+            llassert( cur_delimiter->getType() == LLKeywordToken::TT_ONE_SIDED_DELIMITER );
+            // Left side is the delimiter.  Right side is eol or eof.
+            while( *cur && ('\n' != *cur) )
+            {
+                cur++;
+            }
+            seg_end = cur - base;
+        }
+
+        insertSegments(wtext, seg_list, cur_delimiter, text_len, seg_start, seg_end, style, editor);
+        return false;
+    };
+
+    if (open_delimiter && scan_delimited(open_delimiter, start))
+    {
+        return stop(cur - base);
+    }
+
     while( *cur )
     {
         if( *cur == '\n' || cur == base )
         {
             if( *cur == '\n' )
             {
+                if (resync(cur - base, NULL))
+                {
+                    return stop(cur - base);
+                }
+
                 LLTextSegmentPtr text_segment = new LLLineBreakTextSegment(style, cur-base);
                 text_segment->setToken( 0 );
-                insertSegment( *seg_list, text_segment, text_len, style, editor);
+                insertSegment( seg_list, text_segment, text_len, style, editor);
                 cur++;
                 if( !*cur || *cur == '\n' )
                 {
@@ -594,7 +882,7 @@ void LLKeywords::findSegments(std::vector<LLTextSegmentPtr>* seg_list, const LLW
                         S32 seg_end = cur - base;
 
                         //create segments from seg_start to seg_end
-                        insertSegments(wtext, *seg_list,cur_token, text_len, seg_start, seg_end, style, editor);
+                        insertSegments(wtext, seg_list, cur_token, text_len, seg_start, seg_end, style, editor);
                         line_done = TRUE; // to break out of second loop.
                         break;
                     }
@@ -617,7 +905,6 @@ void LLKeywords::findSegments(std::vector<LLTextSegmentPtr>* seg_list, const LLW
         {
             // Check against delimiters
             {
-                S32 seg_start = 0;
                 LLKeywordToken* cur_delimiter = NULL;
                 for (token_list_t::iterator iter = mDelimiterTokenList.begin();
                      iter != mDelimiterTokenList.end(); ++iter)
@@ -632,84 +919,13 @@ void LLKeywords::findSegments(std::vector<LLTextSegmentPtr>* seg_list, const LLW
 
                 if( cur_delimiter )
                 {
-                    S32 between_delimiters = 0;
-                    S32 seg_end = 0;
-
-                    seg_start = cur - base;
+                    S32 seg_start = cur - base;
                     cur += cur_delimiter->getLengthHead();
 
-                    LLKeywordToken::ETokenType type = cur_delimiter->getType();
-                    if( type == LLKeywordToken::TT_TWO_SIDED_DELIMITER || type == LLKeywordToken::TT_DOUBLE_QUOTATION_MARKS )
-                    {
-                        while( *cur && !cur_delimiter->isTail(cur))
-                        {
-                            // Check for an escape sequence.
-                            if (type == LLKeywordToken::TT_DOUBLE_QUOTATION_MARKS && *cur == '\\')
-                            {
-                                // Count the number of backslashes.
-                                S32 num_backslashes = 0;
-                                while (*cur == '\\')
-                                {
-                                    num_backslashes++;
-                                    between_delimiters++;
-                                    cur++;
-                                }
-                                // If the next character is the end delimiter?
-                                if (cur_delimiter->isTail(cur))
-                                {
-                                    // If there was an odd number of backslashes, then this delimiter
-                                    // does not end the sequence.
-                                    if (num_backslashes % 2 == 1)
-                                    {
-                                        between_delimiters++;
-                                        cur++;
-                                    }
-                                    else
-                                    {
-                                        // This is an end delimiter.
-                                        break;
-                                    }
-                                }
-                            }
-                            else
-                            {
-                                between_delimiters++;
-                                cur++;
-                            }
-                        }
-
-                        if( *cur )
-                        {
-                            cur += cur_delimiter->getLengthHead();
-                            seg_end = seg_start + between_delimiters + cur_delimiter->getLengthHead() + cur_delimiter->getLengthTail();
-                        }
-                        else
-                        {
-                            // eof
-                            seg_end = seg_start + between_delimiters + cur_delimiter->getLengthHead();
-                        }
-                    }
-                    else
+                    if (scan_delimited(cur_delimiter, seg_start))
                     {
-                        llassert( cur_delimiter->getType() == LLKeywordToken::TT_ONE_SIDED_DELIMITER );
-                        // Left side is the delimiter.  Right side is eol or eof.
-                        while( *cur && ('\n' != *cur) )
-                        {
-                            between_delimiters++;
-                            cur++;
-                        }
-                        seg_end = seg_start + between_delimiters + cur_delimiter->getLengthHead();
+                        return stop(cur - base);
                     }
-
-                    insertSegments(wtext, *seg_list,cur_delimiter, text_len, seg_start, seg_end, style, editor);
-                    /*
-                    LLStyleSP seg_style = getDefaultStyle(editor);
-                    seg_style->setColor(defaultColor);
-                    LLTextSegmentPtr text_segment = new LLNormalTextSegment( seg_style, seg_start, seg_end, editor );
-
-                    text_segment->setToken( cur_delimiter );
-                    insertSegment( seg_list, text_segment, text_len, defaultColor, editor);
-                    */
                     // Note: we don't increment cur, since the end of one delimited seg may be immediately
                     // followed by the start of another one.
                     continue;
@@ -728,17 +944,13 @@ void LLKeywords::findSegments(std::vector<LLTextSegmentPtr>* seg_list, const LLW
                 S32 seg_len = p - cur;
                 if( seg_len > 0 )
                 {
-                    WStringMapIndex word( cur, seg_len );
-                    word_token_map_t::iterator map_iter = mWordTokenMap.find(word);
-                    if( map_iter != mWordTokenMap.end() )
+                    LLKeywordToken* cur_token = findWordToken(cur, seg_len);
+                    if( cur_token )
                     {
-                        LLKeywordToken* cur_token = map_iter->second;
                         S32 seg_start = cur - base;
                         S32 seg_end = seg_start + seg_len;
 
-                        // LL_INFOS("SyntaxLSL") << "Seg: [" << word.c_str() << "]" << LL_ENDL;
-
-                        insertSegments(wtext, *seg_list,cur_token, text_len, seg_start, seg_end, style, editor);
+                        insertSegments(wtext, seg_list, cur_token, text_len, seg_start, seg_end, style, editor);
                     }
                     cur += seg_len;
                     continue;
@@ -751,16 +963,22 @@ void LLKeywords::findSegments(std::vector<LLTextSegmentPtr>* seg_list, const LLW
             }
         }
     }
+
+    return text_len;
 }
 
 void LLKeywords::insertSegments(const LLWString& wtext, std::vector<LLTextSegmentPtr>& seg_list, LLKeywordToken* cur_token, S32 text_len, S32 seg_start, S32 seg_end, LLStyleConstSP style, LLTextEditor& editor )
 {
-    std::string::size_type pos = wtext.find('\n',seg_start);
+    // only look for line breaks inside the segment, not up to the end of its line
+    const llwchar* base = wtext.c_str();
+    const llwchar* end = base + seg_end;
+    const llwchar* line_break = std::find(base + seg_start, end, '\n');
 
-    LLStyleConstSP cur_token_style = new LLStyle(LLStyle::Params().font(style->getFont()).color(cur_token->getColor()));
+    LLStyleConstSP cur_token_style = getTokenStyle(cur_token, style);
 
-    while (pos!=-1 && pos < (std::string::size_type)seg_end)
+    while (line_break != end)
     {
+        S32 pos = line_break - base;
         if (pos!=seg_start)
         {
             LLTextSegmentPtr text_segment = new LLNormalTextSegment(cur_token_style, seg_start, pos, editor);
@@ -773,7 +991,7 @@ void LLKeywords::insertSegments(const LLWString& wtext, std::vector<LLTextSegmen
         insertSegment( seg_list, text_segment, text_len, style, editor);
 
         seg_start = pos+1;
-        pos = wtext.find('\n',seg_start);
+        line_break = std::find(base + seg_start, end, '\n');
     }
 
     LLTextSegmentPtr text_segment = new LLNormalTextSegment(cur_token_style, seg_start, seg_end, editor);
@@ -36,8 +36,10 @@
 #include <map>
 #include <list>
 #include <deque>
+#include <vector>
 #include "llpointer.h"
 
+class LLFontGL;
 class LLStyle;
 typedef LLPointer<LLStyle> LLStyleSP;
 class LLTextSegment;
@@ -121,6 +123,20 @@ class LLKeywords
                              const LLWString& text,
                              class LLTextEditor& editor,
                              LLStyleConstSP style);
+    // Re-tokenizes only the lines around [start, end), the text changed since the last
+    // pass, resuming from the comment or string state saved at the line before it and
+    // stopping at the first later line that starts in the same state as last time.
+    // On return seg_list covers just [start, end) and segments outside it are still
+    // valid once shifted by the change in length. Falls back to a full pass when
+    // there is no previous one.
+    void        findSegments(std::vector<LLTextSegmentPtr> *seg_list,
+                             const LLWString& text,
+                             class LLTextEditor& editor,
+                             LLStyleConstSP style,
+                             S32& start,
+                             S32& end);
+    // forget the previous pass, so the next incremental one covers everything
+    void        clearSegmentState();
     void        initialize(LLSD SyntaxXML);
     void        processTokens();
 
@@ -190,6 +206,29 @@ class LLKeywords
 
     void insertSegment(std::vector<LLTextSegmentPtr>& seg_list, LLTextSegmentPtr new_segment, S32 text_len, LLStyleConstSP style, LLTextEditor& editor );
 
+    // Where a line starts, and which comment or string (if any) is still open there.
+    // Only lines that begin with the tokenizer inside a delimited run are recorded
+    // with a delimiter, every other line start is recorded with NULL.
+    struct LineState
+    {
+        S32             mPos;       // offset of the '\n' ending the previous line
+        LLKeywordToken* mDelimiter;
+    };
+    typedef std::vector<LineState> line_state_vec_t;
+
+    S32         scanSegments(std::vector<LLTextSegmentPtr>& seg_list,
+                             const LLWString& wtext,
+                             LLTextEditor& editor,
+                             LLStyleConstSP style,
+                             S32 start,
+                             LLKeywordToken* open_delimiter,
+                             S32 resync_from,
+                             S32 delta,
+                             line_state_vec_t& line_states);
+    LLKeywordToken* findWordToken(const llwchar* word, S32 length) const;
+    void        buildWordTable();
+    LLStyleConstSP getTokenStyle(const LLKeywordToken* token, LLStyleConstSP style);
+
     bool        mLoaded;
     LLSD        mSyntax;
     word_token_map_t mWordTokenMap;
@@ -197,6 +236,27 @@ class LLKeywords
     token_list_t mLineTokenList;
     token_list_t mDelimiterTokenList;
 
+    // Open addressed copy of mWordTokenMap that findSegments() looks words up in
+    // without building a map index or walking the tree.
+    struct WordSlot
+    {
+        const llwchar*  mData;
+        S32             mLength;
+        LLKeywordToken* mToken;
+    };
+    std::vector<WordSlot> mWordTable;
+    U32         mWordTableMask;
+    S32         mMinWordLength;
+    S32         mMaxWordLength;
+
+    // one style per token instead of one per segment
+    std::map<const LLKeywordToken*, LLStyleConstSP> mTokenStyles;
+    const LLFontGL* mTokenStyleFont;
+
+    // state of the last pass, for incremental ones
+    line_state_vec_t mLineStates;
+    S32         mLastLength;
+
     typedef  std::map<std::string, std::string, std::less<>> element_attributes_t;
     typedef element_attributes_t::const_iterator attribute_iterator_t;
     element_attributes_t mAttributes;
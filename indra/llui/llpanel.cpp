@@ -539,7 +539,7 @@ BOOL LLPanel::initPanelXML(LLXMLNodePtr node, LLView *parent, LLXMLNodePtr outpu
             uictrl_factory.pushFileName(xml_filename);
 
             LL_RECORD_BLOCK_TIME(FTM_EXTERNAL_PANEL_LOAD);
-            if (!LLUICtrlFactory::getLayeredXMLNode(xml_filename, referenced_xml))
+            if (!LLUICtrlFactory::getLayeredXMLNode(xml_filename, referenced_xml, LLDir::CURRENT_SKIN, true))
             {
                 LL_WARNS() << "Couldn't parse panel from: " << xml_filename << LL_ENDL;
 
@@ -809,7 +809,7 @@ BOOL LLPanel::buildFromFile(const std::string& filename, const LLPanel::Params&
     BOOL didPost = FALSE;
     LLXMLNodePtr root;
 
-    if (!LLUICtrlFactory::getLayeredXMLNode(filename, root))
+    if (!LLUICtrlFactory::getLayeredXMLNode(filename, root, LLDir::CURRENT_SKIN, true))
     {
         LL_WARNS() << "Couldn't parse panel from: " << filename << LL_ENDL;
         return didPost;
@@ -216,6 +216,9 @@ LLTextBase::LLTextBase(const LLTextBase::Params &p)
     mTextSelectedColor(p.text_selected_color),
     mSelectedBGColor(p.bg_selected_color),
     mReflowIndex(S32_MAX),
+    mReflowEnd(0),
+    mReflowDelta(0),
+    mReflowWidth(-1.f),
     mCursorPos( 0 ),
     mScrollNeeded(FALSE),
     mDesiredXPixel(-1),
@@ -992,7 +995,7 @@ S32 LLTextBase::insertStringNoUndo(S32 pos, const LLWString &wstr, LLTextBase::s
     }
 
     onValueChange(pos, pos + insert_len);
-    needsReflow(pos);
+    needsPartialReflow(pos, pos + insert_len, insert_len);
 
     return insert_len;
 }
@@ -1052,7 +1055,7 @@ S32 LLTextBase::removeStringNoUndo(S32 pos, S32 length)
     createDefaultSegment();
 
     onValueChange(pos, pos);
-    needsReflow(pos);
+    needsPartialReflow(pos, pos, -length);
 
     return -length; // This will be wrong if someone calls removeStringNoUndo with an excessive length
 }
@@ -1068,7 +1071,7 @@ S32 LLTextBase::overwriteCharNoUndo(S32 pos, llwchar wc)
     getViewModel()->getEditableDisplay()[pos] = wc;
 
     onValueChange(pos, pos + 1);
-    needsReflow(pos);
+    needsPartialReflow(pos, pos + 1, 0);
 
     return 1;
 }
@@ -1164,7 +1167,7 @@ void LLTextBase::insertSegment(LLTextSegmentPtr segment_to_insert)
     }
 
     // layout potentially changed
-    needsReflow(reflow_start_index);
+    needsPartialReflow(reflow_start_index, segment_to_insert->getEnd(), 0);
 }
 
 //virtual
@@ -1719,6 +1722,13 @@ void LLTextBase::reflow()
         S32 start_index = mReflowIndex;
         mReflowIndex = S32_MAX;
 
+        // text past resync_end was only moved by resync_delta, so its paragraphs
+        // keep their lines as long as they are broken at the same width
+        S32 resync_end = mReflowEnd;
+        S32 resync_delta = mReflowDelta;
+        mReflowEnd = 0;
+        mReflowDelta = 0;
+
         // shrink document to minimum size (visible portion of text widget)
         // to force inlined widgets with follows set to shrink
         if (mWordWrap)
@@ -1735,17 +1745,36 @@ void LLTextBase::reflow()
         F32 remaining_pixels = text_available_width;
         S32 line_count = 0;
 
+        const F32 wrap_width = getWordWrap() ? text_available_width : F32_MAX;
+        if (wrap_width != mReflowWidth)
+        {
+            // every line was broken at the old width
+            start_index = 0;
+            resync_end = S32_MAX;
+        }
+        mReflowWidth = wrap_width;
+
         // find and erase line info structs starting at start_index and going to end of document
+        line_list_t old_lines;
         if (!mLineInfoList.empty())
         {
             // find first element whose end comes after start_index
             line_list_t::iterator iter = std::upper_bound(mLineInfoList.begin(), mLineInfoList.end(), start_index, line_end_compare());
+            // an edit can make the first word of its line short enough to wrap back onto the line before
+            if (iter != mLineInfoList.end() && iter != mLineInfoList.begin())
+            {
+                --iter;
+            }
             if (iter != mLineInfoList.end())
             {
                 line_start_index = iter->mDocIndexStart;
                 line_count = iter->mLineNum;
                 cur_top = iter->mRect.mTop;
                 getSegmentAndOffset(iter->mDocIndexStart, &seg_iter, &seg_offset);
+                if (resync_end < S32_MAX)
+                {
+                    old_lines.assign(iter, mLineInfoList.end());
+                }
                 mLineInfoList.erase(iter, mLineInfoList.end());
             }
         }
@@ -1836,6 +1865,33 @@ void LLTextBase::reflow()
             if (force_newline)
             {
                 line_count++;
+
+                // a paragraph past the change lays out as it did, and so does the rest of the document
+                if (line_start_index > resync_end
+                    && seg_iter != mSegments.end()
+                    && seg_offset == 0
+                    && (*seg_iter)->getStart() == line_start_index
+                    && getWText()[line_start_index - 1] == '\n')
+                {
+                    S32 old_start_index = line_start_index - resync_delta;
+                    line_list_t::iterator old_iter = std::lower_bound(old_lines.begin(), old_lines.end(), old_start_index,
+                        [](const line_info& line, S32 index) { return line.mDocIndexStart < index; });
+                    if (old_iter != old_lines.end() && old_iter->mDocIndexStart == old_start_index)
+                    {
+                        S32 line_shift = line_count - old_iter->mLineNum;
+                        S32 top_shift = cur_top - old_iter->mRect.mTop;
+                        for (; old_iter != old_lines.end(); ++old_iter)
+                        {
+                            line_info line = *old_iter;
+                            line.mDocIndexStart += resync_delta;
+                            line.mDocIndexEnd += resync_delta;
+                            line.mRect.translate(0, top_shift);
+                            line.mLineNum += line_shift;
+                            mLineInfoList.push_back(line);
+                        }
+                        break;
+                    }
+                }
             }
         }
 
@@ -2459,6 +2515,23 @@ void LLTextBase::needsReflow(S32 index)
     LL_DEBUGS() << "reflow on object " << (void*)this << " index = " << mReflowIndex << ", new index = " << index << LL_ENDL;
 #endif
     mReflowIndex = llmin(mReflowIndex, index);
+    mReflowEnd = S32_MAX;
+
+// [SL:KB] - Patch: Control-TextHighlight | Checked: 2013-12-30 (Catznip-3.6)
+    mHighlightsDirty = true;
+// [/SL:KB]
+}
+
+void LLTextBase::needsPartialReflow(S32 start, S32 end, S32 delta)
+{
+    // [start, end) replaced end - delta - start characters; carry the end of
+    // what changed before over to the new text
+    if (mReflowEnd != S32_MAX)
+    {
+        mReflowEnd = (mReflowEnd >= end - delta) ? mReflowEnd + delta : end;
+    }
+    mReflowDelta += delta;
+    mReflowIndex = llmin(mReflowIndex, start);
 
 // [SL:KB] - Patch: Control-TextHighlight | Checked: 2013-12-30 (Catznip-3.6)
     mHighlightsDirty = true;
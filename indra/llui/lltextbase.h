@@ -459,6 +459,9 @@ class LLTextBase
 
     // force reflow of text
     void                    needsReflow(S32 index = 0);
+    // reflow only [start, end) after an edit that moved the text following it by delta characters;
+    // paragraphs past the edit keep their lines
+    void                    needsPartialReflow(S32 start, S32 end, S32 delta);
 
     S32                     getLength() const { return getWText().length(); }
     S32                     getLineCount() const { return mLineInfoList.size(); }
@@ -798,6 +801,9 @@ class LLTextBase
 
     // transient state
     S32                         mReflowIndex;       // index at which to start reflow.  S32_MAX indicates no reflow needed.
+    S32                         mReflowEnd;         // end of the text changed since the last reflow.  S32_MAX if the rest of the document needs it too.
+    S32                         mReflowDelta;       // change in length since the last reflow
+    F32                         mReflowWidth;       // width the current lines were broken at
     bool                        mScrollNeeded;      // need to change scroll region because of change to cursor position
     S32                         mScrollIndex;       // index of first character to keep visible in scroll region
 
@@ -211,6 +211,7 @@ LLUI::~LLUI()
 {
     sWindow = nullptr;
     sRootView = nullptr;
+    LLXMLNode::clearLayeredXMLCache();
 }
 
 void LLUI::setPopupFuncs(const add_popup_t& add_popup, const remove_popup_t& remove_popup,  const clear_popups_t& clear_popups)
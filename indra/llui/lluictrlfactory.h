@@ -156,7 +156,7 @@ class LLUICtrlFactory final : public LLSingleton<LLUICtrlFactory>
         {
             LLXMLNodePtr root_node;
 
-            if (!LLUICtrlFactory::getLayeredXMLNode(filename, root_node))
+            if (!LLUICtrlFactory::getLayeredXMLNode(filename, root_node, LLDir::CURRENT_SKIN, true))
             {
                 LL_WARNS() << "Couldn't parse XUI from path: " << instance().getCurFileName() << ", from filename: " << filename << LL_ENDL;
                 goto fail;
@@ -191,8 +191,11 @@ class LLUICtrlFactory final : public LLSingleton<LLUICtrlFactory>
 
     static void createChildren(LLView* viewp, LLXMLNodePtr node, const widget_registry_t&, LLXMLNodePtr output_node = NULL);
 
+    // use_cache keeps the resolved layers in memory, for files that are
+    // built over and over such as floaters and panels
     static bool getLayeredXMLNode(const std::string &filename, LLXMLNodePtr& root,
-                                  LLDir::ESkinConstraint constraint=LLDir::CURRENT_SKIN);
+                                  LLDir::ESkinConstraint constraint=LLDir::CURRENT_SKIN,
+                                  bool use_cache = false);
 
 private:
     //NOTE: both friend declarations are necessary to keep both gcc and msvc happy
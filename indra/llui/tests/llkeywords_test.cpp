@@ -0,0 +1,439 @@
+/**
+ * @file llkeywords_test.cpp
+ * @brief Compares incremental keyword highlighting with a full pass
+ *
+ * $LicenseInfo:firstyear=2024&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2024, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#include "linden_common.h"
+
+#include "../llkeywords.h"
+#include "../lltextbase.h"
+#include "../lluicolortable.h"
+#include "llrand.h"
+
+#include "lltut.h"
+
+// link seams
+
+LLUIColor::LLUIColor()
+    : mColorPtr(NULL)
+{}
+
+LLUIColor::LLUIColor(const LLColor4& color)
+    : mColorPtr(NULL), mColor(color)
+{}
+
+const LLColor4& LLUIColor::get() const
+{
+    return mColor;
+}
+
+LLUIColor::operator const LLColor4&() const
+{
+    return mColor;
+}
+
+LLStyle::Params::Params()
+{
+}
+
+LLStyle::LLStyle(const LLStyle::Params& p)
+:   mColor(p.color),
+    mFont(p.font)
+{}
+
+const LLFontGL* LLStyle::getFont() const
+{
+    return mFont;
+}
+
+LLUIImagePtr LLStyle::getImage() const
+{
+    return LLUIImagePtr();
+}
+
+LLUIColor LLUIColorTable::getColor(std::string_view name, const LLColor4& default_color) const
+{
+    return LLUIColor(default_color);
+}
+
+namespace LLInitParam
+{
+    ParamValue<LLUIColor>::ParamValue(const LLUIColor& color)
+    :   super_t(color)
+    {}
+
+    void ParamValue<LLUIColor>::updateValueFromBlock()
+    {}
+
+    void ParamValue<LLUIColor>::updateBlockFromValue(bool)
+    {}
+
+    bool ParamCompare<const LLFontGL*, false>::equals(const LLFontGL* a, const LLFontGL* b)
+    {
+        return false;
+    }
+
+    ParamValue<const LLFontGL*>::ParamValue(const LLFontGL* fontp)
+    :   super_t(fontp)
+    {}
+
+    void ParamValue<const LLFontGL*>::updateValueFromBlock()
+    {}
+
+    void ParamValue<const LLFontGL*>::updateBlockFromValue(bool)
+    {}
+
+    void TypeValues<LLFontGL::ShadowType>::declareValues()
+    {}
+
+    void ParamValue<LLUIImage*>::updateValueFromBlock()
+    {}
+
+    void ParamValue<LLUIImage*>::updateBlockFromValue(bool)
+    {}
+
+    bool ParamCompare<LLUIImage*, false>::equals(LLUIImage* const &a, LLUIImage* const &b)
+    {
+        return false;
+    }
+
+    bool ParamCompare<LLUIColor, false>::equals(const LLUIColor &a, const LLUIColor &b)
+    {
+        return false;
+    }
+}
+
+// The segments only remember their range and token here, nothing is drawn
+BOOL LLMouseHandler::handleAnyMouseClick(S32 x, S32 y, MASK mask, EMouseClickType clicktype, BOOL down) { return FALSE; }
+
+bool LLTextSegment::getDimensionsF32(S32 first_char, S32 num_chars, F32& width, S32& height) const { width = 0; height = 0; return false; }
+S32 LLTextSegment::getOffset(S32 segment_local_x_coord, S32 start_offset, S32 num_chars, bool round) const { return 0; }
+S32 LLTextSegment::getNumChars(S32 num_pixels, S32 segment_offset, S32 line_offset, S32 max_chars, S32 line_ind) const { return 0; }
+void LLTextSegment::updateLayout(const LLTextBase& editor) {}
+F32 LLTextSegment::draw(S32 start, S32 end, S32 selection_start, S32 selection_end, const LLRectf& draw_rect) { return draw_rect.mLeft; }
+bool LLTextSegment::canEdit() const { return false; }
+void LLTextSegment::unlinkFromDocument(LLTextBase*) {}
+void LLTextSegment::linkToDocument(LLTextBase*) {}
+const LLColor4& LLTextSegment::getColor() const { return LLColor4::white; }
+LLStyleConstSP LLTextSegment::getStyle() const { return LLStyleConstSP(); }
+void LLTextSegment::setStyle(LLStyleConstSP style) {}
+void LLTextSegment::setToken(LLKeywordToken* token) {}
+LLKeywordToken* LLTextSegment::getToken() const { return NULL; }
+void LLTextSegment::setToolTip(const std::string& tooltip) {}
+void LLTextSegment::dump() const {}
+BOOL LLTextSegment::handleMouseDown(S32 x, S32 y, MASK mask) { return FALSE; }
+BOOL LLTextSegment::handleMouseUp(S32 x, S32 y, MASK mask) { return FALSE; }
+BOOL LLTextSegment::handleMiddleMouseDown(S32 x, S32 y, MASK mask) { return FALSE; }
+BOOL LLTextSegment::handleMiddleMouseUp(S32 x, S32 y, MASK mask) { return FALSE; }
+BOOL LLTextSegment::handleRightMouseDown(S32 x, S32 y, MASK mask) { return FALSE; }
+BOOL LLTextSegment::handleRightMouseUp(S32 x, S32 y, MASK mask) { return FALSE; }
+BOOL LLTextSegment::handleDoubleClick(S32 x, S32 y, MASK mask) { return FALSE; }
+BOOL LLTextSegment::handleHover(S32 x, S32 y, MASK mask) { return FALSE; }
+BOOL LLTextSegment::handleScrollWheel(S32 x, S32 y, S32 clicks) { return FALSE; }
+BOOL LLTextSegment::handleScrollHWheel(S32 x, S32 y, S32 clicks) { return FALSE; }
+BOOL LLTextSegment::handleToolTip(S32 x, S32 y, MASK mask) { return FALSE; }
+const std::string& LLTextSegment::getName() const { return LLStringUtil::null; }
+void LLTextSegment::onMouseCaptureLost() {}
+void LLTextSegment::screenPointToLocal(S32 screen_x, S32 screen_y, S32* local_x, S32* local_y) const {}
+void LLTextSegment::localPointToScreen(S32 local_x, S32 local_y, S32* screen_x, S32* screen_y) const {}
+BOOL LLTextSegment::hasMouseCapture() { return FALSE; }
+
+LLNormalTextSegment::LLNormalTextSegment(LLStyleConstSP style, S32 start, S32 end, LLTextBase& editor)
+:   LLTextSegment(start, end),
+    mStyle(style),
+    mToken(NULL),
+    mEditor(editor)
+{}
+
+LLNormalTextSegment::LLNormalTextSegment(const LLColor4& color, S32 start, S32 end, LLTextBase& editor, BOOL is_visible)
+:   LLTextSegment(start, end),
+    mToken(NULL),
+    mEditor(editor)
+{}
+
+LLNormalTextSegment::~LLNormalTextSegment() {}
+bool LLNormalTextSegment::getDimensionsF32(S32 first_char, S32 num_chars, F32& width, S32& height) const { width = 0; height = 0; return false; }
+S32 LLNormalTextSegment::getOffset(S32 segment_local_x_coord, S32 start_offset, S32 num_chars, bool round) const { return 0; }
+S32 LLNormalTextSegment::getNumChars(S32 num_pixels, S32 segment_offset, S32 line_offset, S32 max_chars, S32 line_ind) const { return 0; }
+F32 LLNormalTextSegment::draw(S32 start, S32 end, S32 selection_start, S32 selection_end, const LLRectf& draw_rect) { return draw_rect.mLeft; }
+BOOL LLNormalTextSegment::getToolTip(std::string& msg) const { return FALSE; }
+void LLNormalTextSegment::setToolTip(const std::string& tooltip) {}
+void LLNormalTextSegment::dump() const {}
+BOOL LLNormalTextSegment::handleHover(S32 x, S32 y, MASK mask) { return FALSE; }
+BOOL LLNormalTextSegment::handleRightMouseDown(S32 x, S32 y, MASK mask) { return FALSE; }
+BOOL LLNormalTextSegment::handleMouseDown(S32 x, S32 y, MASK mask) { return FALSE; }
+BOOL LLNormalTextSegment::handleMouseUp(S32 x, S32 y, MASK mask) { return FALSE; }
+BOOL LLNormalTextSegment::handleToolTip(S32 x, S32 y, MASK mask) { return FALSE; }
+const LLWString& LLNormalTextSegment::getWText() const { static LLWString empty; return empty; }
+const S32 LLNormalTextSegment::getLength() const { return 0; }
+F32 LLNormalTextSegment::drawClippedSegment(S32 seg_start, S32 seg_end, S32 selection_start, S32 selection_end, LLRectf rect) { return rect.mLeft; }
+
+LLLineBreakTextSegment::LLLineBreakTextSegment(LLStyleConstSP style, S32 pos)
+:   LLTextSegment(pos, pos + 1)
+{}
+
+bool LLLineBreakTextSegment::getDimensionsF32(S32 first_char, S32 num_chars, F32& width, S32& height) const { width = 0; height = 0; return true; }
+S32 LLLineBreakTextSegment::getNumChars(S32 num_pixels, S32 segment_offset, S32 line_offset, S32 max_chars, S32 line_ind) const { return 1; }
+F32 LLLineBreakTextSegment::draw(S32 start, S32 end, S32 selection_start, S32 selection_end, const LLRectf& draw_rect) { return draw_rect.mLeft; }
+
+namespace
+{
+    // buildWordTable() is what processTokens() ends with, without the syntax file
+    class TestKeywords : public LLKeywords
+    {
+    public:
+        TestKeywords()
+        {
+            addToken(LLKeywordToken::TT_LABEL, "@", LLColor4::red, "label");
+            addToken(LLKeywordToken::TT_ONE_SIDED_DELIMITER, "//", LLColor4::green, "comment");
+            addToken(LLKeywordToken::TT_TWO_SIDED_DELIMITER, "/*", LLColor4::green, "comment", "*/");
+            addToken(LLKeywordToken::TT_DOUBLE_QUOTATION_MARKS, "\"", LLColor4::blue, "string", "\"");
+            const char* words[] = { "default", "state", "integer", "llSay", "if", "else", "#define", "#include",
+                                    "string", "key", "PI", "TRUE", "_x" };
+            for (const char* word : words)
+            {
+                addToken(LLKeywordToken::TT_FUNCTION, word, LLColor4::yellow, "function");
+            }
+            buildWordTable();
+        }
+    };
+
+    // What a segment covers and how it is colored
+    struct SegmentInfo
+    {
+        S32 mStart;
+        S32 mEnd;
+        bool mLineBreak;
+        std::string mToken;
+
+        bool operator==(const SegmentInfo& other) const
+        {
+            return mStart == other.mStart && mEnd == other.mEnd && mLineBreak == other.mLineBreak && mToken == other.mToken;
+        }
+    };
+    typedef std::vector<SegmentInfo> segment_info_vec_t;
+
+    segment_info_vec_t describe(const std::vector<LLTextSegmentPtr>& segments)
+    {
+        segment_info_vec_t infos;
+        for (const LLTextSegmentPtr& segment : segments)
+        {
+            SegmentInfo info;
+            info.mStart = segment->getStart();
+            info.mEnd = segment->getEnd();
+            info.mLineBreak = dynamic_cast<LLLineBreakTextSegment*>(segment.get()) != NULL;
+            info.mToken = segment->getToken() ? wstring_to_utf8str(segment->getToken()->getToken()) : std::string("-");
+            infos.push_back(info);
+        }
+        return infos;
+    }
+
+    std::string dump(const segment_info_vec_t& infos)
+    {
+        std::ostringstream out;
+        for (const SegmentInfo& info : infos)
+        {
+            out << " [" << info.mStart << "," << info.mEnd << (info.mLineBreak ? " br" : "") << " " << info.mToken << "]";
+        }
+        return out.str();
+    }
+
+    // Bits of LSL that open and close comments and strings, break lines and make words
+    const char* PIECES[] = { "default", "state", "integer", "llSay", " ", "\n", "\n", "\n", "/*", "*/", "\"", "\\",
+                             "//", "x", "if", "#define", "  ", "\t", "(", ")", ";", "PI", "_x", "key", "a1", "\"\\\"\"" };
+
+    LLWString random_piece()
+    {
+        return utf8str_to_wstring(PIECES[ll_rand(LL_ARRAY_SIZE(PIECES))]);
+    }
+}
+
+namespace tut
+{
+    struct keywords_data
+    {
+        keywords_data()
+        :   mStyle(new LLStyle())
+        {}
+
+        LLStyleConstSP mStyle;
+        // never touched, the segment link seams only keep the reference
+        LLTextEditor& editor() { return *reinterpret_cast<LLTextEditor*>(mEditorStorage); }
+        alignas(16) char mEditorStorage[16];
+    };
+    typedef test_group<keywords_data> keywords_test;
+    typedef keywords_test::object keywords_object;
+    tut::keywords_test tk("LLKeywords");
+
+    template<> template<>
+    void keywords_object::test<1>()
+    {
+        set_test_name("full pass tokens");
+
+        TestKeywords keywords;
+        std::vector<LLTextSegmentPtr> segments;
+        keywords.findSegments(&segments, utf8str_to_wstring("llSay(PI); // hi\nx"), editor(), mStyle);
+        segment_info_vec_t infos = describe(segments);
+
+        segment_info_vec_t expected = {
+            { 0, 5, false, "llSay" },
+            { 5, 6, false, "-" },
+            { 6, 8, false, "PI" },
+            { 8, 11, false, "-" },
+            { 11, 16, false, "//" },
+            { 16, 17, true, "-" },
+            { 17, 19, false, "-" },
+        };
+        ensure_equals("segments" + dump(infos), infos.size(), expected.size());
+        ensure("segments" + dump(infos), infos == expected);
+    }
+
+    template<> template<>
+    void keywords_object::test<2>()
+    {
+        set_test_name("incremental passes match a full pass");
+
+        // As LLScriptEditor does it: a few edits between passes grow one changed
+        // range, then the incremental pass's window replaces the segments it
+        // overlaps and the ones after it move by the change in length.
+        TestKeywords incremental;
+        TestKeywords full;
+        S32 windowed = 0;
+        for (S32 doc = 0; doc < 100; ++doc)
+        {
+            LLWString text;
+            for (S32 i = ll_rand(200); i > 0; --i)
+            {
+                text += random_piece();
+            }
+            std::vector<LLTextSegmentPtr> segments;
+            incremental.findSegments(&segments, text, editor(), mStyle);
+            segment_info_vec_t current = describe(segments);
+
+            for (S32 round = 0; round < 40; ++round)
+            {
+                S32 changed_start = S32_MAX;
+                S32 changed_end = 0;
+                S32 changed_length = text.size();
+                const S32 old_length = text.size();
+                for (S32 edits = 1 + ll_rand(3); edits > 0; --edits)
+                {
+                    S32 pos = ll_rand(text.size() + 1);
+                    S32 start = pos;
+                    S32 end = pos;
+                    if (text.empty() || ll_rand(2))
+                    {
+                        LLWString piece = random_piece();
+                        text.insert(pos, piece);
+                        end = pos + piece.size();
+                    }
+                    else
+                    {
+                        text.erase(pos, llmin(ll_rand(6), (S32)text.size() - pos));
+                    }
+
+                    // LLScriptEditor::onValueChange()
+                    S32 delta = (S32)text.size() - changed_length;
+                    changed_length = text.size();
+                    changed_end = (changed_end > start) ? llmax(changed_end + delta, end) : end;
+                    changed_start = llmin(changed_start, start);
+                }
+
+                S32 start = changed_start;
+                S32 end = changed_end;
+                std::vector<LLTextSegmentPtr> window;
+                incremental.findSegments(&window, text, editor(), mStyle, start, end);
+
+                segment_info_vec_t spliced;
+                bool whole_text = start == 0 && end > (S32)text.size();
+                if (!whole_text)
+                {
+                    S32 delta = (S32)text.size() - old_length;
+                    for (const SegmentInfo& info : current)
+                    {
+                        if (info.mEnd <= start)
+                        {
+                            spliced.push_back(info);
+                        }
+                    }
+                    segment_info_vec_t window_infos = describe(window);
+                    spliced.insert(spliced.end(), window_infos.begin(), window_infos.end());
+                    for (const SegmentInfo& info : current)
+                    {
+                        if (info.mStart >= end - delta)
+                        {
+                            SegmentInfo shifted = info;
+                            shifted.mStart += delta;
+                            shifted.mEnd += delta;
+                            spliced.push_back(shifted);
+                        }
+                    }
+                    ++windowed;
+                }
+                else
+                {
+                    spliced = describe(window);
+                }
+
+                full.findSegments(&segments, text, editor(), mStyle);
+                segment_info_vec_t expected = describe(segments);
+                if (!(spliced == expected))
+                {
+                    fail(llformat("doc %d round %d, window [%d, %d) in \"%s\"\n expected", doc, round, start, end,
+                                  wstring_to_utf8str(text).c_str()) + dump(expected) + "\n got" + dump(spliced));
+                }
+                current = expected;
+            }
+        }
+
+        // the point is to not redo the whole text every time
+        ensure("some passes were partial", windowed > 0);
+    }
+
+    template<> template<>
+    void keywords_object::test<3>()
+    {
+        set_test_name("opening a comment recolors to the end");
+
+        TestKeywords keywords;
+        LLWString text = utf8str_to_wstring("integer x;\nkey k;\nstring s;\n");
+        std::vector<LLTextSegmentPtr> segments;
+        keywords.findSegments(&segments, text, editor(), mStyle);
+
+        text.insert(0, utf8str_to_wstring("/*"));
+        S32 start = 0;
+        S32 end = 2;
+        keywords.findSegments(&segments, text, editor(), mStyle, start, end);
+        ensure_equals("window start", start, 0);
+        ensure("window runs to the end", end > (S32)text.size());
+
+        // an edit inside a line only redoes that line
+        text.insert(13, utf8str_to_wstring("x"));
+        start = 13;
+        end = 14;
+        keywords.findSegments(&segments, text, editor(), mStyle, start, end);
+        ensure_equals("second window start", start, 12);
+        ensure_equals("second window end", end, 20);
+    }
+}
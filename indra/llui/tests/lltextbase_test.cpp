@@ -0,0 +1,380 @@
+/**
+ * @file lltextbase_test.cpp
+ * @brief Tests that reflowing only what an edit touched lays text out as a full reflow does
+ *
+ * $LicenseInfo:firstyear=2024&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2024, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#include "linden_common.h"
+
+#include "../lltextbase.h"
+#include "llfontfreetype.h"
+#include "llfontgl.h"
+#include "llformat.h"
+#include "llrand.h"
+
+#include "lltut.h"
+
+namespace
+{
+    const S32 LINE_HEIGHT = 12;
+
+    // Every character has its own width, so where lines break depends on
+    // exactly which text is on them
+    S32 char_width(llwchar wc)
+    {
+        return (wc == ' ') ? 4 : 3 + wc % 5;
+    }
+
+    // Plain text measured without a font, wrapped the way LLNormalTextSegment
+    // wraps: at the last space that fits, or anywhere at the start of a line.
+    class TestSegment : public LLTextSegment
+    {
+    public:
+        TestSegment(LLStyleConstSP style, S32 start, S32 end, const LLTextBase& editor)
+        :   LLTextSegment(start, end),
+            mStyle(style),
+            mEditor(editor)
+        {}
+
+        /*virtual*/ bool getDimensionsF32(S32 first_char, S32 num_chars, F32& width, S32& height) const
+        {
+            const LLWString& text = mEditor.getWText();
+            S32 end = llmin(mStart + first_char + num_chars, (S32)text.length());
+            width = 0.f;
+            for (S32 i = mStart + first_char; i < end; ++i)
+            {
+                width += (F32)char_width(text[i]);
+            }
+            height = (num_chars > 0) ? LINE_HEIGHT : 0;
+            return false;
+        }
+
+        /*virtual*/ S32 getNumChars(S32 num_pixels, S32 segment_offset, S32 line_offset, S32 max_chars, S32 line_ind) const
+        {
+            const LLWString& text = mEditor.getWText();
+            S32 start = mStart + segment_offset;
+            max_chars = llmin(max_chars, llmin(mEnd, (S32)text.length()) - start);
+
+            S32 width = 0;
+            S32 fits = 0;
+            S32 word_end = 0;
+            for (; fits < max_chars && width + char_width(text[start + fits]) <= num_pixels; ++fits)
+            {
+                width += char_width(text[start + fits]);
+                if (text[start + fits] == ' ')
+                {
+                    word_end = fits + 1;
+                }
+            }
+
+            S32 num_chars = fits;
+            if (fits < max_chars && (word_end > 0 || line_offset > 0))
+            {
+                num_chars = word_end;
+            }
+            if (num_chars == 0 && line_offset == 0 && max_chars > 0)
+            {
+                num_chars = 1;
+            }
+
+            // take the end of the document along with the last run
+            if (start + num_chars < mEnd && start + num_chars >= (S32)text.length())
+            {
+                ++num_chars;
+            }
+            return num_chars;
+        }
+
+        /*virtual*/ bool canEdit() const { return true; }
+        // the text splitting this segment copies the style to the remainder
+        /*virtual*/ LLStyleConstSP getStyle() const { return mStyle; }
+
+    private:
+        LLStyleConstSP mStyle;
+        const LLTextBase& mEditor;
+    };
+
+    // A newline, as LLLineBreakTextSegment lays it out
+    class TestLineBreak : public LLTextSegment
+    {
+    public:
+        TestLineBreak(S32 pos)
+        :   LLTextSegment(pos, pos + 1)
+        {}
+
+        /*virtual*/ bool getDimensionsF32(S32 first_char, S32 num_chars, F32& width, S32& height) const
+        {
+            width = 0.f;
+            height = LINE_HEIGHT;
+            return true;
+        }
+
+        /*virtual*/ S32 getNumChars(S32 num_pixels, S32 segment_offset, S32 line_offset, S32 max_chars, S32 line_ind) const
+        {
+            return 1;
+        }
+    };
+
+    class TestText : public LLTextBase
+    {
+    public:
+        typedef LLTextBase::line_list_t line_list_t;
+
+        TestText(const LLTextBase::Params& p)
+        :   LLTextBase(p)
+        {
+            replaceDefaultSegments();
+        }
+
+        // Edits the way LLTextEditor does, with a line break segment for each newline
+        void insert(S32 pos, const std::string& utf8)
+        {
+            LLWString wstr = utf8str_to_wstring(utf8);
+            for (size_t i = 0; i < wstr.size(); ++i)
+            {
+                segment_vec_t segments;
+                if (wstr[i] == '\n')
+                {
+                    segments.push_back(new TestLineBreak(pos));
+                }
+                insertStringNoUndo(pos, LLWString(1, wstr[i]), &segments);
+                replaceDefaultSegments();
+                ++pos;
+            }
+        }
+
+        void remove(S32 pos, S32 length)
+        {
+            removeStringNoUndo(pos, length);
+            replaceDefaultSegments();
+        }
+
+        void layOut(bool full)
+        {
+            if (full)
+            {
+                needsReflow(0);
+            }
+            reflow();
+        }
+
+        const line_list_t& getLines() const { return mLineInfoList; }
+
+    private:
+        // Splitting a segment and emptying the document both leave behind
+        // LLNormalTextSegments, which would need a real font to measure
+        void replaceDefaultSegments()
+        {
+            bool replaced = true;
+            while (replaced)
+            {
+                replaced = false;
+                for (segment_set_t::iterator it = mSegments.begin(); it != mSegments.end(); ++it)
+                {
+                    if (dynamic_cast<LLNormalTextSegment*>(it->get()))
+                    {
+                        insertSegment(new TestSegment((*it)->getStyle(), (*it)->getStart(), (*it)->getEnd(), *this));
+                        replaced = true;
+                        break;
+                    }
+                }
+            }
+        }
+    };
+
+    std::string random_text(S32 length)
+    {
+        static const char chars[] = "abcdefghijklmnopqrstuvwxyz     \n";
+        std::string text;
+        for (S32 i = 0; i < length; ++i)
+        {
+            text += chars[ll_rand(sizeof(chars) - 1)];
+        }
+        return text;
+    }
+}
+
+namespace tut
+{
+    struct textbase_data
+    {
+        textbase_data()
+        {
+            // The segments measure themselves, but the text still wants a font
+            // to exist.  Without any font files it has no glyphs and no height.
+            LLFontManager::initClass();
+            LLFontGL::initClass(std::vector<std::string>(), 96.f, 1.f, 1.f, "", false);
+            mFont.loadFace("no_such_font.ttf", 10.f, 96.f, 96.f, false, 0);
+
+            LLTextBase::Params p;
+            p.name = "text";
+            p.rect = LLRect(0, 200, 120, 0);
+            p.font = &mFont;
+            p.wrap = true;
+            p.allow_scroll = false;
+            p.max_text_length = S32_MAX;
+            // deleting a view wants the rest of the UI up, so these stay until exit
+            mPartial = new TestText(p);
+            mFull = new TestText(p);
+        }
+
+        void insert(S32 pos, const std::string& text)
+        {
+            mPartial->insert(pos, text);
+            mFull->insert(pos, text);
+        }
+
+        void remove(S32 pos, S32 length)
+        {
+            mPartial->remove(pos, length);
+            mFull->remove(pos, length);
+        }
+
+        void reshape(S32 width)
+        {
+            mPartial->reshape(width, 200);
+            mFull->reshape(width, 200);
+        }
+
+        // turning wrapping on or off changes the wrap width without asking for a reflow
+        void toggleWordWrap()
+        {
+            mPartial->setWordWrap(!mPartial->getWordWrap());
+            mFull->setWordWrap(!mFull->getWordWrap());
+        }
+
+        // lays both documents out, one from the edits and one from scratch, and compares the lines
+        void ensureSameLayout(const std::string& msg)
+        {
+            mPartial->layOut(false);
+            mFull->layOut(true);
+
+            const TestText::line_list_t& partial = mPartial->getLines();
+            const TestText::line_list_t& full = mFull->getLines();
+            ensure_equals(msg + " line count", partial.size(), full.size());
+            for (size_t i = 0; i < full.size(); ++i)
+            {
+                std::string line = llformat("%s line %d", msg.c_str(), (S32)i);
+                ensure_equals(line + " start", partial[i].mDocIndexStart, full[i].mDocIndexStart);
+                ensure_equals(line + " end", partial[i].mDocIndexEnd, full[i].mDocIndexEnd);
+                ensure_equals(line + " number", partial[i].mLineNum, full[i].mLineNum);
+                ensure(line + " rect", partial[i].mRect == full[i].mRect);
+            }
+        }
+
+        S32 randomPos()
+        {
+            return ll_rand(mPartial->getLength() + 1);
+        }
+
+        LLFontGL mFont;
+        TestText* mPartial;
+        TestText* mFull;
+    };
+    typedef test_group<textbase_data> textbase_test;
+    typedef textbase_test::object textbase_object;
+    tut::textbase_test ttb("LLTextBase");
+
+    template<> template<>
+    void textbase_object::test<1>()
+    {
+        set_test_name("inserts");
+
+        insert(0, random_text(400));
+        ensureSameLayout("initial");
+        for (S32 i = 0; i < 300; ++i)
+        {
+            insert(randomPos(), random_text(1 + ll_rand(ll_rand(4) ? 3 : 40)));
+            ensureSameLayout(llformat("insert %d", i));
+        }
+    }
+
+    template<> template<>
+    void textbase_object::test<2>()
+    {
+        set_test_name("removes");
+
+        insert(0, random_text(2000));
+        ensureSameLayout("initial");
+        for (S32 i = 0; i < 300 && mPartial->getLength() > 0; ++i)
+        {
+            S32 pos = ll_rand(mPartial->getLength());
+            remove(pos, llmin(1 + ll_rand(ll_rand(4) ? 3 : 40), mPartial->getLength() - pos));
+            ensureSameLayout(llformat("remove %d", i));
+        }
+    }
+
+    template<> template<>
+    void textbase_object::test<3>()
+    {
+        set_test_name("several edits before a reflow");
+
+        insert(0, random_text(600));
+        ensureSameLayout("initial");
+        for (S32 i = 0; i < 200; ++i)
+        {
+            for (S32 edits = 1 + ll_rand(5); edits > 0; --edits)
+            {
+                if (ll_rand(2) && mPartial->getLength() > 0)
+                {
+                    S32 pos = ll_rand(mPartial->getLength());
+                    remove(pos, llmin(1 + ll_rand(10), mPartial->getLength() - pos));
+                }
+                else
+                {
+                    insert(randomPos(), random_text(1 + ll_rand(10)));
+                }
+            }
+            ensureSameLayout(llformat("edits %d", i));
+        }
+    }
+
+    template<> template<>
+    void textbase_object::test<4>()
+    {
+        set_test_name("wrap width changes");
+
+        insert(0, random_text(600));
+        ensureSameLayout("initial");
+        for (S32 i = 0; i < 200; ++i)
+        {
+            // lines broken at the old width must not be reused at the new one,
+            // whether or not what changed the width asked for a reflow itself
+            switch (ll_rand(3))
+            {
+            case 0:
+                reshape(40 + ll_rand(160));
+                break;
+            case 1:
+                insert(randomPos(), random_text(1 + ll_rand(10)));
+                reshape(40 + ll_rand(160));
+                break;
+            default:
+                toggleWordWrap();
+                insert(randomPos(), random_text(1 + ll_rand(10)));
+                break;
+            }
+            ensureSameLayout(llformat("width %d", i));
+        }
+    }
+}
@@ -29,6 +29,7 @@
 
 #include <iostream>
 #include <map>
+#include <mutex>
 
 #include "llxmlnode.h"
 
@@ -125,7 +126,7 @@ LLXMLNode::LLXMLNode(const LLXMLNode& rhs) :
     mPrecision(rhs.mPrecision),
     mType(rhs.mType),
     mEncoding(rhs.mEncoding),
-    mLineNumber(0),
+    mLineNumber(rhs.mLineNumber),
     mParser(NULL),
     mParent(NULL),
     mChildren(NULL),
@@ -138,15 +139,15 @@ LLXMLNode::LLXMLNode(const LLXMLNode& rhs) :
 {
 }
 
-// returns a new copy of this node and all its children
+// returns a new copy of this node and all its children, in document order
 LLXMLNodePtr LLXMLNode::deepCopy()
 {
     LLXMLNodePtr newnode = LLXMLNodePtr(new LLXMLNode(*this));
     if (mChildren.notNull())
     {
-        for (auto& map_pair : mChildren->map)
+        for (LLXMLNodePtr child = mChildren->head; child.notNull(); child = child->mNext)
         {
-            LLXMLNodePtr temp_ptr_for_gcc(map_pair.second->deepCopy());
+            LLXMLNodePtr temp_ptr_for_gcc(child->deepCopy());
             newnode->addChild(temp_ptr_for_gcc);
         }
     }
@@ -820,59 +821,150 @@ BOOL LLXMLNode::isFullyDefault()
     return FALSE;
 }
 
-// static
-bool LLXMLNode::getLayeredXMLNode(LLXMLNodePtr& root,
-                                  const std::vector<std::string>& paths)
+namespace
 {
-    if (paths.empty()) return false;
-
-    std::string const& filename = paths.front();
-    if (filename.empty())
+    bool parse_layered_xml(LLXMLNodePtr& root, const std::vector<std::string>& paths)
     {
-        return false;
+        if (paths.empty()) return false;
+
+        std::string const& filename = paths.front();
+        if (filename.empty())
+        {
+            return false;
+        }
+
+        if (!LLXMLNode::parseFile(filename, root, NULL))
+        {
+            LL_WARNS() << "Problem reading UI description file: " << filename << " " << errno << LL_ENDL;
+            return false;
+        }
+
+        LLXMLNodePtr updateRoot;
+
+        std::vector<std::string>::const_iterator itor;
+
+        // We've already dealt with the first item, skip that one
+        for (itor = paths.begin() + 1; itor != paths.end(); ++itor)
+        {
+            std::string layer_filename = *itor;
+            if(layer_filename.empty() || layer_filename == filename)
+            {
+                // no localized version of this file, that's ok, keep looking
+                continue;
+            }
+
+            if (!LLXMLNode::parseFile(layer_filename, updateRoot, NULL))
+            {
+                LL_WARNS() << "Problem reading localized UI description file: " << layer_filename << LL_ENDL;
+                return false;
+            }
+
+            std::string nodeName;
+            std::string updateName;
+
+            updateRoot->getAttributeString("name", updateName);
+            root->getAttributeString("name", nodeName);
+
+            if (updateName == nodeName)
+            {
+                LLXMLNode::updateNode(root, updateRoot);
+            }
+        }
+
+        return true;
     }
 
-    if (!LLXMLNode::parseFile(filename, root, NULL))
+    // Layered trees built by getLayeredXMLNode() with use_cache, keyed by the
+    // layer files, which already tell the skin and the language apart.
+    // The cached trees are never handed out, callers get their own copy.
+    struct LayeredXMLEntry
     {
-        LL_WARNS() << "Problem reading UI description file: " << filename << " " << errno << LL_ENDL;
-        return false;
-    }
+        LLXMLNodePtr mRoot;
+        std::vector<S64> mStamps;
+    };
 
-    LLXMLNodePtr updateRoot;
+    struct LayeredXMLCache
+    {
+        std::mutex mMutex;
+        std::map<std::vector<std::string>, LayeredXMLEntry> mEntries;
+    };
 
-    std::vector<std::string>::const_iterator itor;
+    LayeredXMLCache& layered_xml_cache()
+    {
+        static LayeredXMLCache sCache;
+        return sCache;
+    }
 
-    // We've already dealt with the first item, skip that one
-    for (itor = paths.begin() + 1; itor != paths.end(); ++itor)
+    // modification time and size of every layer, so that edited skin files
+    // are picked up
+    std::vector<S64> stamp_layers(const std::vector<std::string>& paths)
     {
-        std::string layer_filename = *itor;
-        if(layer_filename.empty() || layer_filename == filename)
+        std::vector<S64> stamps;
+        stamps.reserve(paths.size() * 2);
+        for (const std::string& path : paths)
         {
-            // no localized version of this file, that's ok, keep looking
-            continue;
+            llstat stat_data;
+            if (path.empty() || LLFile::stat(path, &stat_data) != 0)
+            {
+                stamps.push_back(-1);
+                stamps.push_back(-1);
+            }
+            else
+            {
+                stamps.push_back((S64)stat_data.st_mtime);
+                stamps.push_back((S64)stat_data.st_size);
+            }
         }
+        return stamps;
+    }
+}
+
+// static
+bool LLXMLNode::getLayeredXMLNode(LLXMLNodePtr& root,
+                                  const std::vector<std::string>& paths,
+                                  bool use_cache)
+{
+    if (!use_cache)
+    {
+        return parse_layered_xml(root, paths);
+    }
 
-        if (!LLXMLNode::parseFile(layer_filename, updateRoot, NULL))
+    LayeredXMLCache& cache = layered_xml_cache();
+    std::vector<S64> stamps = stamp_layers(paths);
+    LLXMLNodePtr layered;
+    {
+        std::lock_guard<std::mutex> lock(cache.mMutex);
+        auto found = cache.mEntries.find(paths);
+        if (found != cache.mEntries.end() && found->second.mStamps == stamps)
         {
-            LL_WARNS() << "Problem reading localized UI description file: " << layer_filename << LL_ENDL;
-            return false;
+            layered = found->second.mRoot;
         }
+    }
 
-        std::string nodeName;
-        std::string updateName;
-
-        updateRoot->getAttributeString("name", updateName);
-        root->getAttributeString("name", nodeName);
-
-        if (updateName == nodeName)
+    if (layered.isNull())
+    {
+        if (!parse_layered_xml(layered, paths))
         {
-            LLXMLNode::updateNode(root, updateRoot);
+            return false;
         }
+        std::lock_guard<std::mutex> lock(cache.mMutex);
+        LayeredXMLEntry& entry = cache.mEntries[paths];
+        entry.mRoot = layered;
+        entry.mStamps = std::move(stamps);
     }
 
+    root = layered->deepCopy();
     return true;
 }
 
+// static
+void LLXMLNode::clearLayeredXMLCache()
+{
+    LayeredXMLCache& cache = layered_xml_cache();
+    std::lock_guard<std::mutex> lock(cache.mMutex);
+    cache.mEntries.clear();
+}
+
 // static
 void LLXMLNode::writeHeaderToFile(LLFILE *out_file)
 {
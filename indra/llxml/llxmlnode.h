@@ -144,7 +144,11 @@ class LLXMLNode : public LLThreadSafeRefCount
         LLXMLNodePtr& node,
         LLXMLNodePtr& update_node);
 
-    static bool getLayeredXMLNode(LLXMLNodePtr& root, const std::vector<std::string>& paths);
+    // With use_cache the layered tree is kept in memory, resolved once per
+    // set of layer files (until one changes on disk), and root gets a copy.
+    static bool getLayeredXMLNode(LLXMLNodePtr& root, const std::vector<std::string>& paths,
+                                  bool use_cache = false);
+    static void clearLayeredXMLCache();
 
 
     // Write standard XML file header:
@@ -0,0 +1,169 @@
+/**
+ * @file llxmlnode_test.cpp
+ * @brief Tests for layered XUI loading and its cache
+ *
+ * $LicenseInfo:firstyear=2024&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2024, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#include "linden_common.h"
+#include "llfile.h"
+#include "lluuid.h"
+#include "stringize.h"
+
+#include "../llxmlnode.h"
+
+#include "../test/lltut.h"
+#include <sstream>
+#include <vector>
+
+namespace tut
+{
+    struct xmlnode_data
+    {
+        std::string mDir;
+        std::vector<std::string> mPaths;
+
+        xmlnode_data()
+        {
+            LLUUID random;
+            random.generate();
+            mDir = STRINGIZE(LLFile::tmpdir() << "llxmlnode-test-" << random << "/");
+            LLFile::mkdir(mDir);
+            mPaths.push_back(mDir + "en.xml");
+            mPaths.push_back(mDir + "de.xml");
+
+            writeFile(mPaths[0],
+                      "<?xml version=\"1.0\" encoding=\"utf-8\" standalone=\"yes\" ?>\n"
+                      "<floater name=\"test\" title=\"Test\" width=\"200\">\n"
+                      " <button name=\"zeta\" label=\"Zeta\"/>\n"
+                      " <button name=\"alpha\" label=\"Alpha\"/>\n"
+                      " <text name=\"mid\">Middle</text>\n"
+                      "</floater>\n");
+            writeFile(mPaths[1],
+                      "<?xml version=\"1.0\" encoding=\"utf-8\" standalone=\"yes\" ?>\n"
+                      "<floater name=\"test\" title=\"Probe\">\n"
+                      " <button name=\"alpha\" label=\"Anfang\"/>\n"
+                      "</floater>\n");
+        }
+
+        ~xmlnode_data()
+        {
+            LLXMLNode::clearLayeredXMLCache();
+            for (const std::string& path : mPaths)
+            {
+                LLFile::remove(path);
+            }
+            LLFile::rmdir(mDir);
+        }
+
+        void writeFile(const std::string& path, const std::string& content)
+        {
+            llofstream file(path.c_str());
+            file << content;
+        }
+
+        std::string dump(LLXMLNodePtr& node)
+        {
+            std::ostringstream out;
+            node->writeToOstream(out);
+            return out.str();
+        }
+
+        std::vector<std::string> childNames(LLXMLNodePtr& node)
+        {
+            std::vector<std::string> names;
+            for (LLXMLNodePtr child = node->getFirstChild(); child.notNull(); child = child->getNextSibling())
+            {
+                std::string name;
+                child->getAttributeString("name", name);
+                names.push_back(name);
+            }
+            return names;
+        }
+    };
+    typedef test_group<xmlnode_data> xmlnode_test;
+    typedef xmlnode_test::object xmlnode_object;
+    tut::xmlnode_test txmlnode("LLXMLNode");
+
+    template<> template<>
+    void xmlnode_object::test<1>()
+    {
+        set_test_name("cached layers match parsed layers");
+
+        LLXMLNodePtr parsed;
+        ensure("parsed", LLXMLNode::getLayeredXMLNode(parsed, mPaths));
+        std::string title;
+        parsed->getAttributeString("title", title);
+        ensure_equals("localized title", title, "Probe");
+
+        for (S32 i = 0; i < 2; ++i)
+        {
+            LLXMLNodePtr cached;
+            ensure("cached", LLXMLNode::getLayeredXMLNode(cached, mPaths, true));
+            ensure_equals("same tree", dump(cached), dump(parsed));
+            ensure("document order", childNames(cached) == childNames(parsed));
+            ensure_equals("line number", cached->getFirstChild()->getLineNumber(),
+                          parsed->getFirstChild()->getLineNumber());
+        }
+    }
+
+    template<> template<>
+    void xmlnode_object::test<2>()
+    {
+        set_test_name("callers get their own copy");
+
+        LLXMLNodePtr first;
+        ensure("first", LLXMLNode::getLayeredXMLNode(first, mPaths, true));
+        std::string original = dump(first);
+        first->setAttributeString("title", "Changed");
+        first->createChild("extra", FALSE);
+
+        LLXMLNodePtr second;
+        ensure("second", LLXMLNode::getLayeredXMLNode(second, mPaths, true));
+        ensure("different nodes", first.get() != second.get());
+        ensure_equals("cache untouched", dump(second), original);
+    }
+
+    template<> template<>
+    void xmlnode_object::test<3>()
+    {
+        set_test_name("changed files are read again");
+
+        LLXMLNodePtr before;
+        ensure("before", LLXMLNode::getLayeredXMLNode(before, mPaths, true));
+
+        writeFile(mPaths[1],
+                  "<?xml version=\"1.0\" encoding=\"utf-8\" standalone=\"yes\" ?>\n"
+                  "<floater name=\"test\" title=\"Nochmal geprobt\">\n"
+                  "</floater>\n");
+
+        LLXMLNodePtr after;
+        ensure("after", LLXMLNode::getLayeredXMLNode(after, mPaths, true));
+        std::string title;
+        after->getAttributeString("title", title);
+        ensure_equals("new title", title, "Nochmal geprobt");
+
+        LLFile::remove(mPaths[1]);
+        LLXMLNodePtr missing;
+        ensure("missing layer fails", !LLXMLNode::getLayeredXMLNode(missing, mPaths, true));
+    }
+}
@@ -47,6 +47,7 @@ MediaPluginBase::MediaPluginBase(
     mHostUserData = host_user_data;
     mDeleteMe = false;
     mPixels = 0;
+    mFrameIndex = -1;
     mWidth = 0;
     mHeight = 0;
     mTextureWidth = 0;
@@ -144,6 +145,13 @@ void MediaPluginBase::sendMessage(const LLPluginMessage &message)
  */
 void MediaPluginBase::setDirty(int left, int top, int right, int bottom)
 {
+    if (mPixels && mFrameRing.isAttached())
+    {
+        // Hand the frame over to the viewer and carry on drawing into the next one.
+        mFrameIndex = mFrameRing.endFrame(mFrameIndex, LLRect(left, top, right, bottom), mWidth, mHeight, mDepth);
+        mPixels = mFrameRing.getFrame(mFrameIndex);
+    }
+
     LLPluginMessage message(LLPLUGIN_MESSAGE_CLASS_MEDIA, "updated");
 
     message.setValueS32("left", left);
@@ -154,6 +162,48 @@ void MediaPluginBase::setDirty(int left, int top, int right, int bottom)
     sendMessage(message);
 }
 
+/**
+ * Starts drawing into the texture segment named in a "size_change" message.
+ *
+ * @param[in] info Shared memory segment to draw into
+ *
+ */
+void MediaPluginBase::setTextureSegment(const SharedSegmentInfo &info)
+{
+    if (mFrameRing.attach(info.mAddress, info.mSize))
+    {
+        mFrameIndex = mFrameRing.beginFrame();
+        mPixels = mFrameRing.getFrame(mFrameIndex);
+    }
+    else
+    {
+        mFrameIndex = -1;
+        mPixels = (unsigned char*)info.mAddress;
+    }
+}
+
+/**
+ * Stops drawing into a shared memory segment the viewer is removing, if it's the texture segment.
+ *
+ * @param[in] info Shared memory segment being removed
+ * @return true if this was the texture segment
+ *
+ */
+bool MediaPluginBase::removeTextureSegment(const SharedSegmentInfo &info)
+{
+    unsigned char *begin = (unsigned char*)info.mAddress;
+    if (!mPixels || mPixels < begin || mPixels >= begin + info.mSize)
+    {
+        return false;
+    }
+
+    // This is the currently active pixel buffer.  Make sure we stop drawing to it.
+    mFrameRing.detach();
+    mFrameIndex = -1;
+    mPixels = NULL;
+    return true;
+}
+
 /**
  * Sends "media_status" message to plugin loader shell ("loading", "playing", "paused", etc.)
  *
@@ -31,6 +31,7 @@
 #include "llplugininstance.h"
 #include "llpluginmessage.h"
 #include "llpluginmessageclasses.h"
+#include "llpluginframering.h"
 
 
 class MediaPluginBase
@@ -77,6 +78,11 @@ class MediaPluginBase
     /// Note: The quicktime plugin overrides this to add current time and duration to the message.
     virtual void setDirty(int left, int top, int right, int bottom);
 
+    /// Starts drawing into a texture segment, which may hold a frame ring.
+    void setTextureSegment(const SharedSegmentInfo &info);
+    /// Stops drawing into the segment if it's the texture segment.  Returns true if it was.
+    bool removeTextureSegment(const SharedSegmentInfo &info);
+
    /** Map of shared memory names to shared memory. */
     typedef std::map<std::string, SharedSegmentInfo> SharedSegmentMap;
 
@@ -89,6 +95,10 @@ class MediaPluginBase
     bool mDeleteMe;
    /** Pixel array to display. TODO:DOC are pixels always 24-bit RGB format, aligned on 32-bit boundary? Also: calling this a pixel array may be misleading since 1 pixel > 1 char. */
     unsigned char* mPixels;
+   /** Ring of frames in the texture segment, if the viewer laid one out. mPixels points at the frame being drawn. */
+    LLPluginFrameRing mFrameRing;
+   /** Index of the frame in mFrameRing being drawn. */
+    S32 mFrameIndex;
    /** TODO:DOC what's this for -- does a texture have its own piece of shared memory? updated on size_change_request, cleared on shm_remove */
     std::string mTextureSegmentName;
    /** Width of plugin display in pixels. */
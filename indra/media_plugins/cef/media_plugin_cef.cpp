@@ -602,9 +602,8 @@ void MediaPluginCEF::receiveMessage(const char* message_string)
                 SharedSegmentMap::iterator iter = mSharedSegments.find(name);
                 if (iter != mSharedSegments.end())
                 {
-                    if (mPixels == iter->second.mAddress)
+                    if (removeTextureSegment(iter->second))
                     {
-                        mPixels = NULL;
                         mTextureSegmentName.clear();
                     }
                     mSharedSegments.erase(iter);
@@ -746,6 +745,7 @@ void MediaPluginCEF::receiveMessage(const char* message_string)
                 message.setValueU32("format", GL_BGRA);
                 message.setValueU32("type", GL_UNSIGNED_BYTE);
                 message.setValueBoolean("coords_opengl", true);
+                message.setValueBoolean("frame_ring", true);
                 sendMessage(message);
             }
             else if (message_name == "set_cef_data_path")
@@ -807,7 +807,7 @@ void MediaPluginCEF::receiveMessage(const char* message_string)
                     SharedSegmentMap::iterator iter = mSharedSegments.find(name);
                     if (iter != mSharedSegments.end())
                     {
-                        mPixels = (unsigned char*)iter->second.mAddress;
+                        setTextureSegment(iter->second);
                         mWidth = width;
                         mHeight = height;
 
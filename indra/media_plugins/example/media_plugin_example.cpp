@@ -149,10 +149,8 @@ void mediaPluginExample::receiveMessage(const char* message_string)
                 SharedSegmentMap::iterator iter = mSharedSegments.find(name);
                 if (iter != mSharedSegments.end())
                 {
-                    if (mPixels == iter->second.mAddress)
+                    if (removeTextureSegment(iter->second))
                     {
-                        // This is the currently active pixel buffer.  Make sure we stop drawing to it.
-                        mPixels = NULL;
                         mTextureSegmentName.clear();
                     }
                     mSharedSegments.erase(iter);
@@ -167,6 +165,13 @@ void mediaPluginExample::receiveMessage(const char* message_string)
                 message.setValue("name", name);
                 sendMessage(message);
             }
+            else if (message_name == "echo")
+            {
+                // Sends the payload straight back, for measuring message round-trips (see llplugin_libtest).
+                LLPluginMessage message("base", "echo_response");
+                message.setValueLLSD("payload", message_in.getValueLLSD("payload"));
+                sendMessage(message);
+            }
             else
             {
                 //              std::cerr << "MediaPluginWebKit::receiveMessage: unknown base message: " << message_name << std::endl;
@@ -186,6 +191,7 @@ void mediaPluginExample::receiveMessage(const char* message_string)
                 message.setValueU32("format", GL_RGBA);
                 message.setValueU32("type", GL_UNSIGNED_BYTE);
                 message.setValueBoolean("coords_opengl", true);
+                message.setValueBoolean("frame_ring", true);
                 sendMessage(message);
             }
             else if (message_name == "size_change")
@@ -202,7 +208,7 @@ void mediaPluginExample::receiveMessage(const char* message_string)
                     SharedSegmentMap::iterator iter = mSharedSegments.find(name);
                     if (iter != mSharedSegments.end())
                     {
-                        mPixels = (unsigned char*)iter->second.mAddress;
+                        setTextureSegment(iter->second);
                         mWidth = width;
                         mHeight = height;
 
@@ -2100,6 +2100,8 @@ bool LLAppViewer::cleanup()
 
     ll_close_fail_log();
 
+    // everything logged from here on is written synchronously
+    LLError::setAsyncLogging(false);
     LLError::LLCallStacks::cleanup();
     LL::GLTFSceneManager::deleteSingleton();
     LLEnvironment::deleteSingleton();
@@ -2168,6 +2170,7 @@ bool LLAppViewer::initThreads()
     gSavedSettings.setLLSD("ThreadPoolSizes", threadCounts);
 
     // Image decoding
+    LLImageJ2C::setLargeImageDecodeThreads(llmin((S32)gSavedSettings.getU32("TextureDecodeLargeImageThreads"), cores));
     LLAppViewer::sImageDecodeThread = new LLImageDecodeThread(enable_threads && true);
     LLAppViewer::sTextureCache = new LLTextureCache(enable_threads && true);
     LLAppViewer::sTextureFetch = new LLTextureFetch(LLAppViewer::getTextureCache(),
@@ -4067,7 +4070,7 @@ U32 LLAppViewer::getObjectCacheVersion()
 {
     // Viewer object cache version, change if object update
     // format changes. JC
-    const U32 INDRA_OBJECT_CACHE_VERSION = 17;
+    const U32 INDRA_OBJECT_CACHE_VERSION = 18;
 
     return INDRA_OBJECT_CACHE_VERSION;
 }
@@ -0,0 +1,539 @@
+/**
+ * @file llchattranscript.cpp
+ * @brief Indexed, memory mapped access to a plain text chat transcript
+ *
+ * $LicenseInfo:firstyear=2024&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2024, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#include "linden_common.h"
+
+#include "llchattranscript.h"
+
+#include "llfile.h"
+#include "llmutex.h"
+
+#include <algorithm>
+
+namespace
+{
+    const U32 INDEX_MAGIC = 0x4c43544c; // "LTCL"
+    const U32 INDEX_VERSION = 2;
+
+    // an index is only trusted while this much of the head of its
+    // transcript, and of the end of the part it covers, is unchanged
+    const U32 HASH_BYTES = 256;
+
+    struct IndexHeader
+    {
+        U32 mMagic;
+        U32 mVersion;
+        U32 mLogSize;
+        U32 mHeadHash;
+        U32 mTailHash;
+        U32 mCount;
+    };
+
+    LLMutex& index_mutex()
+    {
+        // the viewer appends on the main thread while LLLoadHistoryThread
+        // may be reading the same index
+        static LLMutex sMutex;
+        return sMutex;
+    }
+
+    U32 hash_bytes(const U8* data, U32 size)
+    {
+        // FNV-1a
+        U32 hash = 2166136261u;
+        for (U32 i = 0; i < size; ++i)
+        {
+            hash = (hash ^ data[i]) * 16777619u;
+        }
+        return hash;
+    }
+
+    U32 hash_head(const U8* data, U32 size)
+    {
+        return hash_bytes(data, llmin(size, HASH_BYTES));
+    }
+
+    // of the last bytes before size
+    U32 hash_tail(const U8* data, U32 size)
+    {
+        U32 length = llmin(size, HASH_BYTES);
+        return hash_bytes(data + size - length, length);
+    }
+
+    bool read_bytes(LLFILE* fp, U32 offset, U32 length, std::vector<U8>& bytes)
+    {
+        bytes.resize(length);
+        return !fseek(fp, offset, SEEK_SET) && fread(bytes.data(), 1, length, fp) == length;
+    }
+
+    // the head and tail hashes of the first size bytes of fp
+    bool hash_file(LLFILE* fp, U32 size, U32& head_hash, U32& tail_hash)
+    {
+        std::vector<U8> bytes;
+        U32 length = llmin(size, HASH_BYTES);
+        if (!read_bytes(fp, 0, length, bytes))
+        {
+            return false;
+        }
+        head_hash = hash_bytes(bytes.data(), length);
+        if (!read_bytes(fp, size - length, length, bytes))
+        {
+            return false;
+        }
+        tail_hash = hash_bytes(bytes.data(), length);
+        return true;
+    }
+
+    bool has_bom(const U8* data, U32 size)
+    {
+        return size >= 3 && data[0] == 0xEF && data[1] == 0xBB && data[2] == 0xBF;
+    }
+
+    bool read_digits(const U8*& cur, const U8* end, S32 min_digits, S32 max_digits, S32& value)
+    {
+        value = 0;
+        S32 digits = 0;
+        while (cur < end && digits < max_digits && *cur >= '0' && *cur <= '9')
+        {
+            value = value * 10 + (*cur++ - '0');
+            ++digits;
+        }
+        return digits >= min_digits;
+    }
+
+    // Same shape as the dated alternative of the TIMESTAMP regex in lllogchat.cpp,
+    // "[YYYY/MM/DD HH:MM]"; the short "[HH:MM]" stamps carry no date and map to 0.
+    U32 parse_time(const U8* cur, const U8* end)
+    {
+        S32 year, month, day, hour, minute;
+        if (cur == end || *cur++ != '['
+            || !read_digits(cur, end, 4, 4, year) || cur == end || *cur++ != '/'
+            || !read_digits(cur, end, 1, 2, month) || cur == end || *cur++ != '/'
+            || !read_digits(cur, end, 1, 2, day))
+        {
+            return 0;
+        }
+        const U8* digits = cur;
+        while (cur < end && (*cur == ' ' || *cur == '\t'))
+        {
+            ++cur;
+        }
+        if (cur == digits
+            || !read_digits(cur, end, 1, 2, hour) || cur == end || *cur++ != ':'
+            || !read_digits(cur, end, 2, 2, minute) || cur == end || *cur != ']'
+            || month < 1 || month > 12 || day < 1 || day > 31)
+        {
+            return 0;
+        }
+
+        // days since 1970/01/01 in the proleptic Gregorian calendar
+        S32 y = year - (month <= 2);
+        S32 era = y / 400;
+        S32 yoe = y - era * 400;
+        S32 doy = (153 * (month + (month > 2 ? -3 : 9)) + 2) / 5 + day - 1;
+        S32 doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+        S64 days = (S64)era * 146097 + doe - 719468;
+        if (days < 0)
+        {
+            return 0;
+        }
+        return (U32)(days * 86400 + hour * 3600 + minute * 60);
+    }
+
+    // Appends the messages starting in [from, size); from may fall in the
+    // middle of a line if the transcript did not end with a line break.
+    void scan_messages(const U8* data, U32 from, U32 size, std::vector<LLChatTranscript::Message>& messages)
+    {
+        U32 pos = from;
+        if (pos > 0 && pos < size && data[pos - 1] != '\n')
+        {
+            const U8* eol = (const U8*)memchr(data + pos, '\n', size - pos);
+            if (!eol)
+            {
+                return;
+            }
+            pos = (U32)(eol - data) + 1;
+        }
+
+        while (pos < size)
+        {
+            U32 line = pos;
+            if (line == 0 && has_bom(data, size))
+            {
+                line = 3;
+            }
+            const U8* eol = (const U8*)memchr(data + line, '\n', size - line);
+            U32 end = eol ? (U32)(eol - data) : size;
+
+            // continuation lines start with a space, and old transcripts
+            // separate paragraphs of one message with empty lines
+            U32 len = end - line;
+            if (len && data[line] != ' ' && !(len == 1 && data[line] == '\r'))
+            {
+                LLChatTranscript::Message message = { pos, parse_time(data + line, data + end) };
+                messages.push_back(message);
+            }
+            pos = end + 1;
+        }
+    }
+
+    char fold_ascii(char c)
+    {
+        return (c >= 'A' && c <= 'Z') ? c - 'A' + 'a' : c;
+    }
+
+    bool fold_equal(char a, char b)
+    {
+        return fold_ascii(a) == fold_ascii(b);
+    }
+
+    bool before_offset(U32 offset, const LLChatTranscript::Message& message)
+    {
+        return offset < message.mOffset;
+    }
+}
+
+LLChatTranscript::LLChatTranscript()
+    : mData(nullptr),
+      mSize(0)
+{
+}
+
+LLChatTranscript::~LLChatTranscript()
+{
+    close();
+}
+
+bool LLChatTranscript::open(const std::string& log_name)
+{
+    close();
+    if (!mapLog(log_name, mLog, mSize))
+    {
+        return false;
+    }
+    mData = mLog.getData();
+    syncIndex(log_name, mData, mSize, &mMessages);
+    mLogName = log_name;
+    return true;
+}
+
+void LLChatTranscript::close()
+{
+    mLog.close();
+    mData = nullptr;
+    mSize = 0;
+    mMessages.clear();
+    mLogName.clear();
+}
+
+const char* LLChatTranscript::getMessageData(S32 index, U32& length) const
+{
+    U32 start = mMessages[index].mOffset;
+    if (start == 0 && has_bom(mData, mSize))
+    {
+        start = 3;
+    }
+    U32 end = index + 1 < getMessageCount() ? mMessages[index + 1].mOffset : mSize;
+    if (end > start && mData[end - 1] == '\n')
+    {
+        --end;
+        if (end > start && mData[end - 1] == '\r')
+        {
+            --end;
+        }
+    }
+    length = end - start;
+    return (const char*)mData + start;
+}
+
+S32 LLChatTranscript::findMessage(U32 offset) const
+{
+    return findMessageAfter(offset) - 1;
+}
+
+S32 LLChatTranscript::findMessageAfter(U32 offset) const
+{
+    return (S32)(std::upper_bound(mMessages.begin(), mMessages.end(), offset, before_offset) - mMessages.begin());
+}
+
+S32 LLChatTranscript::getPageStart(S32& last, S32 count) const
+{
+    last = last < 0 ? getMessageCount() : llmin(last, getMessageCount());
+    return llmax(last - llmax(count, 0), 0);
+}
+
+S32 LLChatTranscript::search(const std::string& text, std::vector<SearchHit>& hits, bool match_case, S32 max_hits) const
+{
+    if (text.empty() || mMessages.empty())
+    {
+        return 0;
+    }
+
+    const char* begin = (const char*)mData;
+    const char* end = begin + mSize;
+    const char* cur = begin + mMessages.front().mOffset;
+    S32 found = 0;
+    while (found < max_hits)
+    {
+        const char* match = match_case ? std::search(cur, end, text.begin(), text.end())
+                                       : std::search(cur, end, text.begin(), text.end(), fold_equal);
+        if (match == end)
+        {
+            break;
+        }
+
+        SearchHit hit = { findMessage((U32)(match - begin)), (U32)(match - begin) };
+        hits.push_back(hit);
+        ++found;
+
+        // one hit per message is enough
+        if (hit.mMessage + 1 >= getMessageCount())
+        {
+            break;
+        }
+        cur = begin + mMessages[hit.mMessage + 1].mOffset;
+    }
+    return found;
+}
+
+//static
+S32 LLChatTranscript::search(const std::vector<std::string>& log_names, const std::string& text, log_hits_t& hits,
+                             bool match_case, S32 max_hits, S32 max_log_hits)
+{
+    S32 found = 0;
+    std::vector<SearchHit> log_hits;
+    LLChatTranscript transcript;
+    for (const std::string& log_name : log_names)
+    {
+        if (found >= max_hits)
+        {
+            break;
+        }
+        if (!transcript.open(log_name))
+        {
+            continue;
+        }
+
+        log_hits.clear();
+        found += transcript.search(text, log_hits, match_case, llmin(max_hits - found, max_log_hits));
+        for (const SearchHit& hit : log_hits)
+        {
+            hits.push_back(std::make_pair(log_name, hit));
+        }
+    }
+    return found;
+}
+
+//static
+bool LLChatTranscript::appendIndex(const std::string& log_name, U32 old_size)
+{
+    LLMutexLock lock(&index_mutex());
+
+    llstat stat_data;
+    if (LLFile::stat(log_name, &stat_data) || (U64)stat_data.st_size >= U32_MAX || (U32)stat_data.st_size < old_size)
+    {
+        return false;
+    }
+    U32 size = (U32)stat_data.st_size;
+
+    std::string index_name = getIndexFileName(log_name);
+    LLFILE* index_fp = LLFile::fopen(index_name, "r+b");
+    if (!index_fp)
+    {
+        return false;
+    }
+    LLFILE* log_fp = LLFile::fopen(log_name, "rb");
+
+    // only an index that covers exactly what was there before is extended
+    IndexHeader header;
+    U32 head_hash = 0;
+    U32 tail_hash = 0;
+    bool valid = log_fp
+        && fread(&header, sizeof(header), 1, index_fp) == 1
+        && header.mMagic == INDEX_MAGIC
+        && header.mVersion == INDEX_VERSION
+        && header.mLogSize == old_size
+        && hash_file(log_fp, old_size, head_hash, tail_hash)
+        && header.mHeadHash == head_hash
+        && header.mTailHash == tail_hash
+        && !fseek(index_fp, 0, SEEK_END)
+        && (U64)ftell(index_fp) == sizeof(header) + (U64)header.mCount * sizeof(Message);
+
+    // the byte before the new ones tells whether they start a line
+    std::vector<U8> bytes;
+    U32 base = old_size ? old_size - 1 : 0;
+    valid = valid && read_bytes(log_fp, base, size - base, bytes);
+
+    std::vector<Message> added;
+    if (valid)
+    {
+        scan_messages(bytes.data(), old_size - base, size - base, added);
+        for (Message& message : added)
+        {
+            message.mOffset += base;
+        }
+    }
+
+    // the header goes last, as in syncIndex()
+    bool written = valid
+        && hash_file(log_fp, size, head_hash, tail_hash)
+        && !fseek(index_fp, 0, SEEK_END)
+        && fwrite(added.data(), sizeof(Message), added.size(), index_fp) == added.size();
+    if (written)
+    {
+        header.mLogSize = size;
+        header.mHeadHash = head_hash;
+        header.mTailHash = tail_hash;
+        header.mCount += (U32)added.size();
+        written = !fseek(index_fp, 0, SEEK_SET) && fwrite(&header, sizeof(header), 1, index_fp) == 1;
+    }
+    if (log_fp)
+    {
+        fclose(log_fp);
+    }
+    fclose(index_fp);
+    return written;
+}
+
+//static
+void LLChatTranscript::removeIndex(const std::string& log_name)
+{
+    LLMutexLock lock(&index_mutex());
+    LLFile::remove(getIndexFileName(log_name), ENOENT);
+}
+
+//static
+std::string LLChatTranscript::getIndexFileName(const std::string& log_name)
+{
+    return log_name + ".idx";
+}
+
+//static
+bool LLChatTranscript::mapLog(const std::string& log_name, LLMappedFile& log, U32& size)
+{
+    llstat stat_data;
+    if (LLFile::stat(log_name, &stat_data))
+    {
+        return false;
+    }
+    if ((U64)stat_data.st_size >= U32_MAX)
+    {
+        LL_WARNS("ChatHistory") << "Transcript " << log_name << " is too large to index" << LL_ENDL;
+        return false;
+    }
+
+    size = (U32)stat_data.st_size;
+    if (size && !log.open(log_name, size, false))
+    {
+        LL_WARNS("ChatHistory") << "Unable to map transcript " << log_name << LL_ENDL;
+        return false;
+    }
+    return true;
+}
+
+//static
+bool LLChatTranscript::syncIndex(const std::string& log_name, const U8* data, U32 size, std::vector<Message>* messages)
+{
+    LLMutexLock lock(&index_mutex());
+
+    std::string index_name = getIndexFileName(log_name);
+    IndexHeader header;
+    bool valid = false;
+    LLFILE* fp = LLFile::fopen(index_name, "r+b");
+    if (fp)
+    {
+        if (fread(&header, sizeof(header), 1, fp) == 1
+            && header.mMagic == INDEX_MAGIC
+            && header.mVersion == INDEX_VERSION
+            && header.mLogSize <= size
+            && header.mHeadHash == hash_head(data, header.mLogSize)
+            && header.mTailHash == hash_tail(data, header.mLogSize)
+            && !fseek(fp, 0, SEEK_END))
+        {
+            valid = (U64)ftell(fp) == sizeof(header) + (U64)header.mCount * sizeof(Message);
+        }
+        if (valid && messages)
+        {
+            messages->resize(header.mCount);
+            valid = !fseek(fp, sizeof(header), SEEK_SET)
+                && fread(messages->data(), sizeof(Message), header.mCount, fp) == header.mCount;
+        }
+        if (valid && header.mLogSize == size)
+        {
+            fclose(fp);
+            return true;
+        }
+    }
+
+    if (!valid)
+    {
+        if (fp)
+        {
+            fclose(fp);
+        }
+        LL_DEBUGS("ChatHistory") << "Rebuilding transcript index " << index_name << LL_ENDL;
+        fp = LLFile::fopen(index_name, "w+b");
+        header.mMagic = INDEX_MAGIC;
+        header.mVersion = INDEX_VERSION;
+        header.mLogSize = 0;
+        header.mCount = 0;
+        if (messages)
+        {
+            messages->clear();
+        }
+    }
+
+    std::vector<Message> added;
+    scan_messages(data, header.mLogSize, size, added);
+    if (messages)
+    {
+        messages->insert(messages->end(), added.begin(), added.end());
+    }
+
+    // the header goes last so an interrupted write leaves an index whose
+    // size does not match its header, which gets rebuilt
+    bool written = fp
+        && !fseek(fp, sizeof(header) + header.mCount * sizeof(Message), SEEK_SET)
+        && fwrite(added.data(), sizeof(Message), added.size(), fp) == added.size();
+    if (written)
+    {
+        header.mLogSize = size;
+        header.mHeadHash = hash_head(data, size);
+        header.mTailHash = hash_tail(data, size);
+        header.mCount += (U32)added.size();
+        written = !fseek(fp, 0, SEEK_SET) && fwrite(&header, sizeof(header), 1, fp) == 1;
+    }
+    if (fp)
+    {
+        fclose(fp);
+    }
+    if (!written)
+    {
+        // the messages are still good for this session
+        LL_WARNS("ChatHistory") << "Unable to write transcript index " << index_name << LL_ENDL;
+    }
+    return written;
+}
@@ -0,0 +1,123 @@
+/**
+ * @file llchattranscript.h
+ * @brief Indexed, memory mapped access to a plain text chat transcript
+ *
+ * $LicenseInfo:firstyear=2024&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2024, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#ifndef LL_LLCHATTRANSCRIPT_H
+#define LL_LLCHATTRANSCRIPT_H
+
+#include "llmappedfile.h"
+
+#include <string>
+#include <vector>
+
+/**
+ * Random access to the messages of a transcript written by LLLogChat.
+ *
+ * A message is a line that is neither empty nor starts with a space,
+ * together with the continuation lines following it.  The byte offset
+ * and timestamp of every message are kept in a sidecar index file next
+ * to the transcript (see getIndexFileName()).  Transcripts only ever
+ * grow, so an index that still matches the head and the tail of what it
+ * covers is brought up to date by scanning just the bytes appended since.
+ */
+class LLChatTranscript
+{
+public:
+    struct Message
+    {
+        U32 mOffset;
+        U32 mTime;      // seconds since 1970 of a "[YYYY/MM/DD HH:MM]" stamp, 0 if undated
+    };
+
+    struct SearchHit
+    {
+        S32 mMessage;
+        U32 mOffset;    // of the match
+    };
+    // transcript path and hit
+    typedef std::vector<std::pair<std::string, SearchHit> > log_hits_t;
+
+    LLChatTranscript();
+    ~LLChatTranscript();
+
+    LLChatTranscript(const LLChatTranscript&) = delete;
+    LLChatTranscript& operator=(const LLChatTranscript&) = delete;
+
+    // Maps log_name and loads its index, rebuilding or extending it first
+    // when it lags behind the transcript.
+    bool open(const std::string& log_name);
+    void close();
+
+    bool isOpen() const                     { return !mLogName.empty(); }
+    const std::string& getLogName() const   { return mLogName; }
+    U32 getSize() const                     { return mSize; }
+
+    S32 getMessageCount() const             { return (S32)mMessages.size(); }
+    const Message& getMessage(S32 index) const { return mMessages[index]; }
+
+    // Bytes of a message, head line and continuation lines, without the
+    // final line break.  Valid until close().
+    const char* getMessageData(S32 index, U32& length) const;
+
+    // Index of the message containing offset.
+    S32 findMessage(U32 offset) const;
+
+    // Index of the first message starting past offset, getMessageCount()
+    // if there is none.
+    S32 findMessageAfter(U32 offset) const;
+
+    // First message of the page of up to count messages ending before
+    // message last.  last is clamped to the message count first, and a
+    // negative last stands for the end of the transcript.
+    S32 getPageStart(S32& last, S32 count) const;
+
+    // Adds one hit per message containing text, in transcript order, and
+    // returns how many were added.  Case is folded for ASCII only.
+    S32 search(const std::string& text, std::vector<SearchHit>& hits, bool match_case = false, S32 max_hits = S32_MAX) const;
+
+    // Searches each of log_names in turn, adding at most max_log_hits hits
+    // per transcript and max_hits in all.  Unreadable transcripts are skipped.
+    static S32 search(const std::vector<std::string>& log_names, const std::string& text, log_hits_t& hits,
+                      bool match_case = false, S32 max_hits = S32_MAX, S32 max_log_hits = S32_MAX);
+
+    // Adds what was appended to log_name past old_size to its index, reading
+    // only those bytes.  Does nothing when the index does not end at
+    // old_size; the next open() rebuilds it instead.
+    static bool appendIndex(const std::string& log_name, U32 old_size);
+    static void removeIndex(const std::string& log_name);
+    static std::string getIndexFileName(const std::string& log_name);
+
+private:
+    static bool syncIndex(const std::string& log_name, const U8* data, U32 size, std::vector<Message>* messages);
+    static bool mapLog(const std::string& log_name, LLMappedFile& log, U32& size);
+
+    std::string mLogName;
+    LLMappedFile mLog;
+    const U8* mData;
+    U32 mSize;
+    std::vector<Message> mMessages;
+};
+
+#endif // LL_LLCHATTRANSCRIPT_H
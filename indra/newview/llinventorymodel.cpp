@@ -40,6 +40,7 @@
 #include "lldispatcher.h"
 #include "llinventorypanel.h"
 #include "llinventorybridge.h"
+#include "llinventorycache.h"
 #include "llinventoryfunctions.h"
 #include "llinventorymodelbackgroundfetch.h"
 #include "llinventoryobserver.h"
@@ -58,6 +59,7 @@
 #include "llappviewer.h"
 #include "llviewerregion.h"
 #include "llcallbacklist.h"
+#include "llcond.h"
 #include "llvoavatarself.h"
 #include "llgesturemgr.h"
 #include "llsdserialize.h"
@@ -67,6 +69,8 @@
 #include "llcorehttputil.h"
 #include "hbxxh.h"
 #include "llstartup.h"
+#include "threadpool.h"
+#include "workqueue.h"
 // [RLVa:KB] - Checked: 2011-05-22 (RLVa-1.3.1a)
 #include "rlvhandler.h"
 #include "rlvlocks.h"
@@ -79,12 +83,10 @@
 
 #include <algorithm>
 #include <boost/algorithm/string/join.hpp>
-#include <boost/iostreams/device/array.hpp>
-#include <boost/iostreams/stream.hpp>
 
 // Increment this if the inventory contents change in a non-backwards-compatible way.
 // For viewer 2, the addition of link items makes a pre-viewer-2 cache incorrect.
-const S32 LLInventoryModel::sCurrentInvCacheVersion = 3;
+const S32 LLInventoryModel::sCurrentInvCacheVersion = 4;
 BOOL LLInventoryModel::sFirstTimeInViewer2 = TRUE;
 
 S32 LLInventoryModel::sPendingSystemFolders = 0;
@@ -94,8 +96,10 @@ S32 LLInventoryModel::sPendingSystemFolders = 0;
 ///----------------------------------------------------------------------------
 
 //BOOL decompress_file(const char* src_filename, const char* dst_filename);
-static const char PRODUCTION_CACHE_FORMAT_STRING[] = "%s.inv.llsd";
-static const char GRID_CACHE_FORMAT_STRING[] = "%s.%s.inv.llsd";
+static const char PRODUCTION_CACHE_FORMAT_STRING[] = "%s.inv.bin";
+static const char GRID_CACHE_FORMAT_STRING[] = "%s.%s.inv.bin";
+// Notation LLSD cache written by inventory cache version 3 and earlier
+static const char LEGACY_CACHE_SUFFIX[] = ".inv.llsd.gz";
 static const char * const LOG_INV("Inventory");
 
 struct InventoryIDPtrLess
@@ -2498,20 +2502,14 @@ void LLInventoryModel::cache(
         items,
         INCLUDE_TRASH,
         can_cache);
-    // Use temporary file to avoid potential conflicts with other
-    // instances (even a 'read only' instance unzips into a file)
-    std::string temp_file = gDirUtilp->getTempFilename();
-    saveToFile(temp_file, categories, items);
     std::string gzip_filename = getInvCacheAddres(agent_id);
     gzip_filename.append(".gz");
-    if(gzip_file(temp_file, gzip_filename))
+    if (saveToFile(gzip_filename, categories, items))
     {
-        LL_DEBUGS(LOG_INV) << "Successfully compressed " << temp_file << " to " << gzip_filename << LL_ENDL;
-        LLFile::remove(temp_file);
-    }
-    else
-    {
-        LL_WARNS(LOG_INV) << "Unable to compress " << temp_file << " into " << gzip_filename << LL_ENDL;
+        // Drop the cache left behind by older viewers, it will never be read again
+        std::string legacy_filename = gzip_filename.substr(0, gzip_filename.size() - strlen(".inv.bin.gz"));
+        legacy_filename.append(LEGACY_CACHE_SUFFIX);
+        LLFile::remove(legacy_filename, ENOENT);
     }
 }
 
@@ -2868,41 +2866,11 @@ bool LLInventoryModel::loadSkeleton(
         changed_items_t categories_to_update;
         item_array_t possible_broken_links;
         cat_set_t invalid_categories; // Used to mark categories that weren't successfully loaded.
-        std::string inventory_filename = getInvCacheAddres(owner_id);
         const S32 NO_VERSION = LLViewerInventoryCategory::VERSION_UNKNOWN;
-        std::string gzip_filename(inventory_filename);
+        std::string gzip_filename = getInvCacheAddres(owner_id);
         gzip_filename.append(".gz");
-        LLFILE* fp = LLFile::fopen(gzip_filename, "rb");
-        bool remove_inventory_file = false;
-        if (LLAppViewer::instance()->isSecondInstance())
-        {
-            // Safeguard viewer against trying to unpack file twice
-            // ex: user logs into two accounts simultaneously, so two
-            // viewers are trying to unpack library into same file
-            //
-            // Would be better to do it in gunzip_file, but it doesn't
-            // have access to llfilesystem
-            inventory_filename = gDirUtilp->getTempFilename();
-            remove_inventory_file = true;
-        }
-        if(fp)
-        {
-            fclose(fp);
-            fp = NULL;
-            if(gunzip_file(gzip_filename, inventory_filename))
-            {
-                // we only want to remove the inventory file if it was
-                // gzipped before we loaded, and we successfully
-                // gunziped it.
-                remove_inventory_file = true;
-            }
-            else
-            {
-                LL_INFOS(LOG_INV) << "Unable to gunzip " << gzip_filename << LL_ENDL;
-            }
-        }
         bool is_cache_obsolete = false;
-        if (loadFromFile(inventory_filename, categories, items, categories_to_update, is_cache_obsolete))
+        if (loadFromFile(gzip_filename, categories, items, categories_to_update, is_cache_obsolete))
         {
             // We were able to find a cache of files. So, use what we
             // found to generate a set of categories we should add. We
@@ -3092,11 +3060,6 @@ bool LLInventoryModel::loadSkeleton(
             }
         }
 
-        if(remove_inventory_file)
-        {
-            // clean up the gunzipped file.
-            LLFile::remove(inventory_filename);
-        }
         if(is_cache_obsolete && !LLAppViewer::instance()->isSecondInstance())
         {
             // If out of date, remove the gzipped file too.
@@ -3519,9 +3482,7 @@ bool LLInventoryModel::loadFromFile(const std::string& filename,
     }
     LL_INFOS(LOG_INV) << "loading inventory from: (" << filename << ")" << LL_ENDL;
 
-    llifstream file(filename.c_str());
-
-    if (!file.is_open())
+    if (!LLFile::isfile(filename))
     {
         LL_INFOS(LOG_INV) << "unable to load inventory from: " << filename << LL_ENDL;
         return false;
@@ -3529,84 +3490,158 @@ bool LLInventoryModel::loadFromFile(const std::string& filename,
 
     is_cache_obsolete = true; // Obsolete until proven current
 
-    //U64 lines_count = 0U;
-    std::string line;
-    LLPointer<LLSDParser> parser = new LLSDNotationParser();
-    while (std::getline(file, line))
+    // The whole file is inflated in memory, no temporary file is needed so
+    // a second instance can safely read the same cache.
+    LLInventoryCache::Reader reader;
+    if (!reader.open(filename))
     {
-        LLSD s_item;
-        boost::iostreams::stream<boost::iostreams::array_source> iss(line.data(), line.size());
-        if (parser->parse(iss, s_item, line.length()) == LLSDParser::PARSE_FAILURE)
-        {
-            LL_WARNS(LOG_INV)<< "Parsing inventory cache failed" << LL_ENDL;
-            break;
-        }
+        LL_WARNS(LOG_INV) << "Parsing inventory cache failed" << LL_ENDL;
+        return false;
+    }
+    if (reader.getVersion() != sCurrentInvCacheVersion)
+    {
+        LL_WARNS(LOG_INV) << "Inventory cache is out of date" << LL_ENDL;
+        return false;
+    }
+    is_cache_obsolete = false;
 
-        if (s_item.has("inv_cache_version"))
-        {
-            S32 version = s_item["inv_cache_version"].asInteger();
-            if (version == sCurrentInvCacheVersion)
-            {
-                // Cache is up to date
-                is_cache_obsolete = false;
-                continue;
-            }
-            else
-            {
-                LL_WARNS(LOG_INV)<< "Inventory cache is out of date" << LL_ENDL;
-                break;
-            }
-        }
-        else if (s_item.has("cat_id"))
-        {
-            if (is_cache_obsolete)
-                break;
+    // Chunks are independent, decode them on the General thread pool
+    // into per-chunk results so that the merge below keeps file order.
+    struct ChunkResult
+    {
+        cat_array_t mCategories;
+        item_array_t mItems;
+        uuid_vec_t mCatsToUpdate;
+    };
+    const std::vector<LLInventoryCache::Chunk>& chunks = reader.getChunks();
+    std::vector<ChunkResult> results(chunks.size());
 
-            LLPointer<LLViewerInventoryCategory> inv_cat = new LLViewerInventoryCategory(LLUUID::null);
-            if(inv_cat->importLLSD(s_item))
+    auto decode_chunk = [&chunks, &results](size_t index)
+    {
+        LL_PROFILE_ZONE_NAMED("inventory decode chunk");
+        const LLInventoryCache::Chunk& chunk = chunks[index];
+        ChunkResult& result = results[index];
+        if (chunk.mType == LLInventoryCache::CHUNK_CATEGORIES)
+        {
+            result.mCategories.reserve(chunk.mCount);
+            for (U32 i = 0; i < chunk.mCount; ++i)
             {
-                categories.push_back(inv_cat);
+                LLUUID owner_id;
+                S32 version = LLViewerInventoryCategory::VERSION_UNKNOWN;
+                LLPointer<LLViewerInventoryCategory> inv_cat = new LLViewerInventoryCategory(LLUUID::null);
+                if (LLInventoryCache::unpackCategory(chunk, i, *inv_cat, owner_id, version))
+                {
+                    inv_cat->setOwnerID(owner_id);
+                    inv_cat->setVersion(version);
+                    result.mCategories.push_back(inv_cat);
+                }
             }
         }
-        else if (s_item.has("item_id"))
+        else
         {
-            if (is_cache_obsolete)
-                break;
-
-            LLPointer<LLViewerInventoryItem> inv_item = new LLViewerInventoryItem;
-            if( inv_item->fromLLSD(s_item) )
+            result.mItems.reserve(chunk.mCount);
+            for (U32 i = 0; i < chunk.mCount; ++i)
             {
-                if(inv_item->getUUID().isNull())
+                LLPointer<LLViewerInventoryItem> inv_item = new LLViewerInventoryItem;
+                if (!LLInventoryCache::unpackItem(chunk, i, *inv_item))
+                {
+                    continue;
+                }
+                if (inv_item->getUUID().isNull())
                 {
-                    LL_DEBUGS(LOG_INV) << "Ignoring inventory with null item id: "
-                        << inv_item->getName() << LL_ENDL;
+                    continue;
+                }
+                if (inv_item->getType() == LLAssetType::AT_UNKNOWN)
+                {
+                    result.mCatsToUpdate.push_back(inv_item->getParentUUID());
                 }
                 else
                 {
-                    if (inv_item->getType() == LLAssetType::AT_UNKNOWN)
-                    {
-                        cats_to_update.insert(inv_item->getParentUUID());
-                    }
-                    else
+                    result.mItems.push_back(inv_item);
+                }
+            }
+        }
+    };
+
+    // Chunks are handed out under a lock that also counts the ones being
+    // decoded.  A worker the General pool only gets to after this thread
+    // is done finds none left and touches nothing on this stack, so we
+    // only ever wait for chunks a worker actually started.
+    struct DecodeProgress
+    {
+        size_t mNext = 0;
+        size_t mInFlight = 0;
+    };
+    struct DecodeState
+    {
+        LLCond<DecodeProgress> mProgress;
+        size_t mCount = 0;
+        std::function<void(size_t)> mDecode;
+    };
+    auto state = std::make_shared<DecodeState>();
+    state->mCount = chunks.size();
+    state->mDecode = decode_chunk;
+
+    auto decode_chunks = [](DecodeState& state)
+    {
+        while (true)
+        {
+            size_t index = 0;
+            state.mProgress.update_one([&index, &state](DecodeProgress& progress)
+                {
+                    index = progress.mNext;
+                    if (index < state.mCount)
                     {
-                        items.push_back(inv_item);
+                        ++progress.mNext;
+                        ++progress.mInFlight;
                     }
-                }
+                });
+            if (index >= state.mCount)
+            {
+                return;
+            }
+            state.mDecode(index);
+            state.mProgress.update_all([](DecodeProgress& progress) { --progress.mInFlight; });
+        }
+    };
+
+    // Workers pull chunks until none are left; this thread pitches in as
+    // well so a busy or missing pool only costs us parallelism.
+    LL::WorkQueue::ptr_t general_queue = LL::WorkQueue::getInstance("General");
+    if (general_queue && chunks.size() > 1)
+    {
+        const size_t workers = llmin(LL::ThreadPool::getWidth("General", 3), chunks.size() - 1);
+        for (size_t i = 0; i < workers; ++i)
+        {
+            if (!general_queue->post([state, decode_chunks]() { decode_chunks(*state); }))
+            {
+                break;
             }
         }
+    }
+    decode_chunks(*state);
+    // Results and the reader buffer live on this stack
+    state->mProgress.wait([](const DecodeProgress& progress) { return progress.mInFlight == 0; });
 
-//      TODO(brad) - figure out how to reenable this without breaking everything else
-//      static constexpr U64 BATCH_SIZE = 512U;
-//      if ((++lines_count % BATCH_SIZE) == 0)
-//      {
-//          // SL-19968 - make sure message system code gets a chance to run every so often
-//          pump_idle_startup_network();
-//      }
+    size_t cat_count = 0, item_count = 0;
+    for (const ChunkResult& result : results)
+    {
+        cat_count += result.mCategories.size();
+        item_count += result.mItems.size();
+    }
+    categories.reserve(categories.size() + cat_count);
+    items.reserve(items.size() + item_count);
+    for (ChunkResult& result : results)
+    {
+        categories.insert(categories.end(), result.mCategories.begin(), result.mCategories.end());
+        items.insert(items.end(), result.mItems.begin(), result.mItems.end());
+        cats_to_update.insert(result.mCatsToUpdate.begin(), result.mCatsToUpdate.end());
     }
 
-    file.close();
+    LL_INFOS(LOG_INV) << "Inventory cache decoded " << cat_count << " categories, " << item_count
+                      << " items from " << chunks.size() << " chunks." << LL_ENDL;
 
-    return !is_cache_obsolete;
+    return true;
 }
 
 // static
@@ -3624,24 +3659,15 @@ bool LLInventoryModel::saveToFile(const std::string& filename,
 
     try
     {
-        llofstream fileXML(filename.c_str());
-        if (!fileXML.is_open())
+        // Records are compressed and written a chunk at a time rather
+        // than staging the whole inventory in a temporary file.
+        LLInventoryCache::Writer writer;
+        if (!writer.open(filename, sCurrentInvCacheVersion))
         {
             LL_WARNS(LOG_INV) << "Failed to open file. Unable to save inventory to: " << filename << LL_ENDL;
             return false;
         }
 
-        LLSD cache_ver;
-        cache_ver["inv_cache_version"] = sCurrentInvCacheVersion;
-
-        if (fileXML.fail())
-        {
-            LL_WARNS(LOG_INV) << "Failed to write cache version to file. Unable to save inventory to: " << filename << LL_ENDL;
-            return false;
-        }
-
-        fileXML << LLSDOStreamer<LLSDNotationFormatter>(cache_ver) << std::endl;
-
         S32 count = categories.size();
         S32 cat_count = 0;
         S32 i;
@@ -3650,31 +3676,22 @@ bool LLInventoryModel::saveToFile(const std::string& filename,
             LLViewerInventoryCategory* cat = categories[i];
             if (cat->getVersion() != LLViewerInventoryCategory::VERSION_UNKNOWN)
             {
-                fileXML << LLSDOStreamer<LLSDNotationFormatter>(cat->exportLLSD()) << std::endl;
+                writer.addCategory(*cat, cat->getOwnerID(), cat->getVersion());
                 cat_count++;
             }
-
-            if (fileXML.fail())
-            {
-                LL_WARNS(LOG_INV) << "Failed to write a folder to file. Unable to save inventory to: " << filename << LL_ENDL;
-                return false;
-            }
         }
 
         S32 it_count = items.size();
         for (i = 0; i < it_count; ++i)
         {
-            fileXML << LLSDOStreamer<LLSDNotationFormatter>(items[i]->asLLSD()) << std::endl;
-
-            if (fileXML.fail())
-            {
-                LL_WARNS(LOG_INV) << "Failed to write an item to file. Unable to save inventory to: " << filename << LL_ENDL;
-                return false;
-            }
+            writer.addItem(*items[i]);
         }
-        fileXML.flush();
 
-        fileXML.close();
+        if (!writer.close())
+        {
+            LL_WARNS(LOG_INV) << "Failed to write inventory cache. Unable to save inventory to: " << filename << LL_ENDL;
+            return false;
+        }
 
         LL_INFOS(LOG_INV) << "Inventory saved: " << cat_count << " categories, " << it_count << " items." << LL_ENDL;
     }
@@ -29,6 +29,7 @@
 #include "llagent.h"
 #include "llagentui.h"
 #include "llavatarnamecache.h"
+#include "llchattranscript.h"
 #include "lllogchat.h"
 #include "llregex.h"
 #include "lltrans.h"
@@ -131,6 +132,71 @@ const char* remove_utf8_bom(const char* buf)
     return start;
 }
 
+std::string get_transcript_line(const char* begin, const char* end)
+{
+    if (end > begin && *(end - 1) == '\r')
+    {
+        --end;
+    }
+    return std::string(begin, end);
+}
+
+// Appends messages [first, last) of a transcript to messages.  Only the head
+// line of a message goes through the parser, continuation lines are folded
+// into its text the way they were written.
+void load_transcript_messages(const LLChatTranscript& transcript, S32 first, S32 last, std::list<LLSD>& messages, const LLSD& load_params)
+{
+    for (S32 i = first; i < last; ++i)
+    {
+        U32 length = 0;
+        const char* data = transcript.getMessageData(i, length);
+        const char* end = data + length;
+        const char* eol = std::find(data, end, '\n');
+
+        std::string line = get_transcript_line(data, eol);
+        LLSD item;
+        if (!LLChatLogParser::parse(line, item, load_params))
+        {
+            item[LL_IM_TEXT] = line;
+        }
+
+        if (eol != end)
+        {
+            std::string im_text = item[LL_IM_TEXT].asString();
+            while (eol != end)
+            {
+                data = eol + 1;
+                eol = std::find(data, end, '\n');
+                line = get_transcript_line(data, eol);
+
+                //updated 1.23 plain text log format requires a space added before subsequent lines in a multilined message
+                if (!line.empty() && ' ' == line[0])
+                {
+                    im_text += '\n' + line.substr(MULTI_LINE_PREFIX.length());
+                }
+                else
+                {
+                    //to support old format's multilined messages with new lines used to divide paragraphs
+                    im_text += '\n';
+                }
+            }
+            item[LL_IM_TEXT] = im_text;
+        }
+        messages.push_back(item);
+    }
+}
+
+// First message of the last LOG_RECALL_SIZE bytes of a transcript, the part
+// of it shown when a conversation is opened
+S32 get_recall_start(const LLChatTranscript& transcript)
+{
+    if (transcript.getSize() < (U32)LOG_RECALL_SIZE - 1)
+    {
+        return 0;
+    }
+    return transcript.findMessageAfter(transcript.getSize() - (LOG_RECALL_SIZE - 1));
+}
+
 class LLLogChatTimeScanner final : public LLSingleton<LLLogChatTimeScanner>
 {
     LLSINGLETON(LLLogChatTimeScanner);
@@ -284,6 +350,8 @@ void LLLogChat::renameLogFile(const std::string& old_filename, const std::string
     if (!LLFile::isfile(new_name) && LLFile::isfile(old_name))
     {
         LLFile::rename(old_name, new_name);
+        LLChatTranscript::removeIndex(old_name);
+        LLChatTranscript::removeIndex(new_name);
     }
 }
 
@@ -348,7 +416,17 @@ void LLLogChat::saveHistory(const std::string& filename,
         return;
     }
 
-    llofstream file(LLLogChat::makeLogFileName(filename).c_str(), std::ios_base::app);
+    std::string log_file_name = LLLogChat::makeLogFileName(filename);
+
+    // where the new line starts, for the index
+    llstat stat_data;
+    U32 old_size = 0;
+    if (!LLFile::stat(log_file_name, &stat_data))
+    {
+        old_size = (U32)llmin((U64)stat_data.st_size, (U64)U32_MAX);
+    }
+
+    llofstream file(log_file_name.c_str(), std::ios_base::app);
     if (!file.is_open())
     {
         LL_WARNS() << "Couldn't open chat history log! - " + filename << LL_ENDL;
@@ -377,6 +455,10 @@ void LLLogChat::saveHistory(const std::string& filename,
 
     file.close();
 
+    // Only the new line is read. A missing or stale index is rebuilt the
+    // next time the history is loaded, not while chatting.
+    LLChatTranscript::appendIndex(log_file_name, old_size);
+
     LLLogChat::getInstance()->triggerHistorySignal();
 }
 
@@ -429,9 +511,9 @@ void LLLogChat::loadChatHistory(const std::string& file_name, std::list<LLSD>& m
     }
 
     // If we got here, we managed to stat the file.
-    // Open the file to read
-    LLFILE* fptr = LLFile::fopen(log_file_name, "r");       /*Flawfinder: ignore*/
-    if (!fptr)
+    // Map the file and its index to read
+    LLChatTranscript transcript;
+    if (!transcript.open(log_file_name))
     {   // Ok, this is strange but not really tragic in the big picture of things
         LL_WARNS("ChatHistory") << "Unable to read file " << log_file_name << " after stat was successful" << LL_ENDL;
         return;
@@ -439,56 +521,9 @@ void LLLogChat::loadChatHistory(const std::string& file_name, std::list<LLSD>& m
 
     S32 save_num_messages = messages.size();
 
-    char buffer[LOG_RECALL_SIZE];       /*Flawfinder: ignore*/
-    char *bptr;
-    S32 len;
-    bool firstline = TRUE;
-
-    if (load_all_history || fseek(fptr, (LOG_RECALL_SIZE - 1) * -1  , SEEK_END))
-    {   //We need to load the whole historyFile or it's smaller than recall size, so get it all.
-        firstline = FALSE;
-        if (fseek(fptr, 0, SEEK_SET))
-        {
-            fclose(fptr);
-            return;
-        }
-    }
-    while (fgets(buffer, LOG_RECALL_SIZE, fptr)  && !feof(fptr))
-    {
-        len = strlen(buffer) - 1;       /*Flawfinder: ignore*/
-        // backfill any end of line characters with nulls
-        for (bptr = (buffer + len); (*bptr == '\n' || *bptr == '\r') && bptr>buffer; bptr--)    *bptr='\0';
-
-        if (firstline)
-        {
-            firstline = FALSE;
-            continue;
-        }
-
-        std::string line(remove_utf8_bom(buffer));
-
-        //updated 1.23 plain text log format requires a space added before subsequent lines in a multilined message
-        if (' ' == line[0])
-        {
-            line.erase(0, MULTI_LINE_PREFIX.length());
-            append_to_last_message(messages, '\n' + line);
-        }
-        else if (0 == len && ('\n' == line[0] || '\r' == line[0]))
-        {
-            //to support old format's multilined messages with new lines used to divide paragraphs
-            append_to_last_message(messages, line);
-        }
-        else
-        {
-            LLSD item;
-            if (!LLChatLogParser::parse(line, item, load_params))
-            {
-                item[LL_IM_TEXT] = line;
-            }
-            messages.push_back(item);
-        }
-    }
-    fclose(fptr);
+    //We need to load the whole historyFile or just the end of it
+    S32 first = load_all_history ? 0 : get_recall_start(transcript);
+    load_transcript_messages(transcript, first, transcript.getMessageCount(), messages, load_params);
 
     LL_DEBUGS("ChatHistory") << "Read " << (messages.size() - save_num_messages)
         << " messages of chat history from " << log_file_name
@@ -756,6 +791,7 @@ bool LLLogChat::moveTranscripts(const std::string originDirectory,
 
             //Rename the file to its backup name so it is not overwritten
             LLFile::rename(newFullPath, backupFileName);
+            LLChatTranscript::removeIndex(newFullPath);
         }
 
         S32 retry_count = 0;
@@ -774,6 +810,7 @@ bool LLLogChat::moveTranscripts(const std::string originDirectory,
             else
             {
                 listOfFilesMoved.push_back(newFullPath);
+                LLChatTranscript::removeIndex(fullpath);
 
                 if (retry_count)
                 {
@@ -830,6 +867,7 @@ void LLLogChat::deleteTranscripts()
             }
             else
             {
+                LLChatTranscript::removeIndex(fullpath);
                 if (retry_count)
                 {
                     LL_WARNS("LLLogChat::deleteTranscripts") << "Successfully removed " << fullpath << LL_ENDL;
@@ -1165,91 +1203,38 @@ void LLLoadHistoryThread::loadHistory(const std::string& file_name, std::list<LL
     }
 
     bool load_all_history = load_params.has("load_all_history") ? load_params["load_all_history"].asBoolean() : false;
-    LLFILE* fptr = LLFile::fopen(LLLogChat::makeLogFileName(file_name), "r");/*Flawfinder: ignore*/
+    std::string log_file_name = LLLogChat::makeLogFileName(file_name);
 
-    if (!fptr)
+    if (!LLFile::isfile(log_file_name))
     {
         bool is_group = load_params.has("is_group") ? load_params["is_group"].asBoolean() : false;
         if (is_group)
         {
             std::string old_name(file_name);
             old_name.erase(old_name.size() - GROUP_CHAT_SUFFIX.size());
-            fptr = LLFile::fopen(LLLogChat::makeLogFileName(old_name), "r");
-            if (fptr)
-            {
-                fclose(fptr);
-                LLFile::copy(LLLogChat::makeLogFileName(old_name), LLLogChat::makeLogFileName(file_name));
-            }
-            fptr = LLFile::fopen(LLLogChat::makeLogFileName(file_name), "r");
-        }
-        if (!fptr)
-        {
-            fptr = LLFile::fopen(LLLogChat::oldLogFileName(file_name), "r");/*Flawfinder: ignore*/
-            if (!fptr)
+            if (LLFile::isfile(LLLogChat::makeLogFileName(old_name)))
             {
-                mNewLoad = false;
-                (*mLoadEndSignal)(messages, file_name);
-                return;                     //No previous conversation with this name.
+                LLFile::copy(LLLogChat::makeLogFileName(old_name), log_file_name);
             }
         }
-    }
-
-    char buffer[LOG_RECALL_SIZE];       /*Flawfinder: ignore*/
-
-    char *bptr;
-    S32 len;
-    bool firstline = TRUE;
-
-    if (load_all_history || fseek(fptr, (LOG_RECALL_SIZE - 1) * -1  , SEEK_END))
-    {   //We need to load the whole historyFile or it's smaller than recall size, so get it all.
-        firstline = FALSE;
-        if (fseek(fptr, 0, SEEK_SET))
+        if (!LLFile::isfile(log_file_name))
         {
-            fclose(fptr);
-            mNewLoad = false;
-            (*mLoadEndSignal)(messages, file_name);
-            return;
+            log_file_name = LLLogChat::oldLogFileName(file_name);
         }
     }
 
-
-    while (fgets(buffer, LOG_RECALL_SIZE, fptr)  && !feof(fptr))
+    LLChatTranscript transcript;
+    if (!transcript.open(log_file_name))
     {
-        len = strlen(buffer) - 1;       /*Flawfinder: ignore*/
-
-        for (bptr = (buffer + len); (*bptr == '\n' || *bptr == '\r') && bptr>buffer; bptr--)    *bptr='\0';
-
-
-        if (firstline)
-        {
-            firstline = FALSE;
-            continue;
-        }
-        std::string line(remove_utf8_bom(buffer));
-
-        //updated 1.23 plaint text log format requires a space added before subsequent lines in a multilined message
-        if (' ' == line[0])
-        {
-            line.erase(0, MULTI_LINE_PREFIX.length());
-            append_to_last_message(*messages, '\n' + line);
-        }
-        else if (0 == len && ('\n' == line[0] || '\r' == line[0]))
-        {
-            //to support old format's multilined messages with new lines used to divide paragraphs
-            append_to_last_message(*messages, line);
-        }
-        else
-        {
-            LLSD item;
-            if (!LLChatLogParser::parse(line, item, load_params))
-            {
-                item[LL_IM_TEXT] = line;
-            }
-            messages->push_back(item);
-        }
+        mNewLoad = false;
+        (*mLoadEndSignal)(messages, file_name);
+        return;                     //No previous conversation with this name.
     }
 
-    fclose(fptr);
+    //We need to load the whole historyFile or just the end of it
+    S32 first = load_all_history ? 0 : get_recall_start(transcript);
+    load_transcript_messages(transcript, first, transcript.getMessageCount(), *messages, load_params);
+
     mNewLoad = false;
     (*mLoadEndSignal)(messages, file_name);
 }
@@ -46,6 +46,7 @@
 #include "llsdserialize.h"
 #include "llthread.h"
 #include "llfilesystem.h"
+#include "threadpool.h"
 #include "llviewercontrol.h"
 #include "llviewerinventory.h"
 #include "llviewermenufile.h"
@@ -77,8 +78,6 @@
 #include "llviewernetwork.h"
 
 #include <boost/smart_ptr/make_shared.hpp>
-#include <boost/iostreams/device/array.hpp>
-#include <boost/iostreams/stream.hpp>
 
 #ifndef LL_WINDOWS
 #include "netdb.h"
@@ -110,6 +109,7 @@
 //   main     Main rendering thread, very sensitive to locking and other stalls
 //   repo     Overseeing worker thread associated with the LLMeshRepoThread class
 //   decom    Worker thread for mesh decomposition requests
+//   decodeN  "MeshDecode" ThreadPool workers unpacking LOD and skin info blocks
 //   core     HTTP worker thread:  does the work but doesn't intrude here
 //   uploadN  0-N temporary mesh upload threads (0-1 in practice)
 //
@@ -149,9 +149,12 @@
 //                             ...
 //                             onCompleted() invoked for GET
 //                               data copied
-//                               lodReceived() invoked
-//                                 unpack data into LLVolume
-//                                 append LoadedMesh to mLoadedQ
+//                               postLODDecode() invoked
+//                                 data copied, posted to decode pool
+//                             ...
+//                             (decodeN) lodReceived() invoked
+//                               unpack data into LLVolume
+//                               push LoadedMesh to mLoadedQ
 //                             ...
 //         notifyLoadedMeshes() invoked again
 //           scan mLoadedQ
@@ -222,8 +225,8 @@
 //     sLODPending                     mMeshMutex [4]  rw.main.mMeshMutex
 //     sLODProcessing                  Repo::mMutex    rw.any.Repo::mMutex
 //     sCacheBytesRead                 none            rw.repo.none, ro.main.none [1]
-//     sCacheBytesWritten              "
 //     sCacheReads                     "
+//     sCacheBytesWritten              atomic          rw.repo.none, rw.decodeN.none, ro.main.none
 //     sCacheWrites                    "
 //     mLoadingMeshes                  mMeshMutex [4]  rw.main.none, rw.any.mMeshMutex
 //     mSkinMap                        none            rw.main.none
@@ -247,16 +250,16 @@
 //     sActiveLODRequests       mMutex        rw.any.mMutex, ro.repo.none [1]
 //     sMaxConcurrentRequests   mMutex        wo.main.none, ro.repo.none, ro.main.mMutex
 //     mMeshHeader              mHeaderMutex  rw.repo.mHeaderMutex, ro.main.mHeaderMutex, ro.main.none [0]
-//     mSkinReqQ                mMutex        rw.repo.mMutex, ro.repo.none [5]
-//     mSkinUnavailableQ        mMutex        rw.repo.mMutex, ro.repo.none [5]
-//     mSkinInfoQ               mMutex        rw.repo.mMutex, rw.main.mMutex [5] (was:  [0])
+//     mSkinReqQ                mMutex        rw.repo.mMutex, wo.any.mMutex, ro.repo.none [5]
+//     mSkinUnavailableQ        mMutex        rw.repo.mMutex, wo.any.mMutex, ro.repo.none [5]
+//     mSkinInfoQ               none          wo.any.none, rw.main.none (LLLockFreeQueue)
 //     mDecompositionRequests   mMutex        rw.repo.mMutex, ro.repo.none [5]
 //     mPhysicsShapeRequests    mMutex        rw.repo.mMutex, ro.repo.none [5]
 //     mDecompositionQ          mMutex        rw.repo.mMutex, rw.main.mMutex [5] (was:  [0])
 //     mHeaderReqQ              mMutex        ro.repo.none [5], rw.repo.mMutex, rw.any.mMutex
 //     mLODReqQ                 mMutex        ro.repo.none [5], rw.repo.mMutex, rw.any.mMutex
-//     mUnavailableQ            mMutex        rw.repo.none [0], ro.main.none [5], rw.main.mMutex
-//     mLoadedQ                 mMutex        rw.repo.mMutex, ro.main.none [5], rw.main.mMutex
+//     mUnavailableQ            mMutex        rw.repo.none [0], ro.main.none [5], rw.main.mMutex, wo.any.mMutex
+//     mLoadedQ                 none          wo.any.none, rw.main.none (LLLockFreeQueue)
 //     mPendingLOD              mMutex        rw.repo.mMutex, rw.any.mMutex
 //     mGetMeshCapability       mMutex        rw.main.mMutex, ro.repo.mMutex (was:  [0])
 //     mGetMesh2Capability      mMutex        rw.main.mMutex, ro.repo.mMutex (was:  [0])
@@ -387,12 +390,12 @@ U32 LLMeshRepository::sLODProcessing = 0;
 U32 LLMeshRepository::sLODPending = 0;
 
 U32 LLMeshRepository::sCacheBytesRead = 0;
-U32 LLMeshRepository::sCacheBytesWritten = 0;
+std::atomic<U32> LLMeshRepository::sCacheBytesWritten(0);
 U32 LLMeshRepository::sCacheBytesHeaders = 0;
 U32 LLMeshRepository::sCacheBytesSkins = 0;
 U32 LLMeshRepository::sCacheBytesDecomps = 0;
 U32 LLMeshRepository::sCacheReads = 0;
-U32 LLMeshRepository::sCacheWrites = 0;
+std::atomic<U32> LLMeshRepository::sCacheWrites(0);
 U32 LLMeshRepository::sMaxLockHoldoffs = 0;
 
 LLDeadmanTimer LLMeshRepository::sQuiescentTimer(15.0, false);  // true -> gather cpu metrics
@@ -557,6 +560,9 @@ S32 LLMeshRepoThread::sRequestLowWater = REQUEST2_LOW_WATER_MIN;
 S32 LLMeshRepoThread::sRequestHighWater = REQUEST2_HIGH_WATER_MIN;
 S32 LLMeshRepoThread::sRequestWaterLevel = 0;
 
+LLTrace::SampleStatHandle<> LLMeshRepoThread::sDecodeQueueDepth("mesh_decode_queue_depth", "LOD and skin info blocks waiting to be unpacked");
+LLTrace::SampleStatHandle<F32Milliseconds> LLMeshRepoThread::sDecodeLatency("mesh_decode_latency", "Time from a mesh block arriving to it being unpacked");
+
 // Base handler class for all mesh users of llcorehttp.
 // This is roughly equivalent to a Responder class in
 // traditional LL code.  The base is going to perform
@@ -822,7 +828,8 @@ LLMeshRepoThread::LLMeshRepoThread()
   mHttpPolicyClass(LLCore::HttpRequest::DEFAULT_POLICY_ID),
   mHttpLegacyPolicyClass(LLCore::HttpRequest::DEFAULT_POLICY_ID),
   mHttpLargePolicyClass(LLCore::HttpRequest::DEFAULT_POLICY_ID),
-  mLegacyGetMeshVersion(0)
+  mLegacyGetMeshVersion(0),
+  mDecodesPending(0)
 {
     LLAppCoreHttp & app_core_http(LLAppViewer::instance()->getAppCoreHttp());
 
@@ -841,6 +848,9 @@ LLMeshRepoThread::LLMeshRepoThread()
     mHttpPolicyClass = app_core_http.getPolicy(LLAppCoreHttp::AP_MESH2);
     mHttpLegacyPolicyClass = app_core_http.getPolicy(LLAppCoreHttp::AP_MESH1);
     mHttpLargePolicyClass = app_core_http.getPolicy(LLAppCoreHttp::AP_LARGE_MESH);
+
+    mDecodePool.reset(new LL::ThreadPool("MeshDecode", 4));
+    mDecodePool->start();
 }
 
 
@@ -851,11 +861,13 @@ LLMeshRepoThread::~LLMeshRepoThread()
                        << ", Max Lock Holdoffs:  " << LLMeshRepository::sMaxLockHoldoffs
                        << LL_ENDL;
 
+    // workers touch the queues and mutexes below, stop them first
+    mDecodePool->close();
+    mDecodePool.reset();
+
     mHttpRequestSet.clear();
     mHttpHeaders.reset();
 
-    delete_and_clear(mSkinInfoQ);
-
     mDecompositionQ.clear();
     mPhysicsQ.clear();
 
@@ -931,7 +943,7 @@ void LLMeshRepoThread::run()
                     // failed to load before, wait a bit
                     incomplete.push_front(req);
                 }
-                else if (!fetchMeshLOD(req.mMeshParams, req.mLOD, req.canRetry()))
+                else if (!fetchMeshLOD(req.mMeshParams, req.mLOD, req.canRetry(), req.mUseCache))
                 {
                     if (req.canRetry())
                     {
@@ -1020,7 +1032,7 @@ void LLMeshRepoThread::run()
                 {
                     incomplete.emplace_back(req);
                 }
-                else if (!fetchMeshSkinInfo(req.mId, req.canRetry()))
+                else if (!fetchMeshSkinInfo(req.mId, req.canRetry(), req.mUseCache))
                 {
                     if (req.canRetry())
                     {
@@ -1317,7 +1329,7 @@ LLCore::HttpHandle LLMeshRepoThread::getByteRange(const std::string & url, int l
     return handle;
 }
 
-bool LLMeshRepoThread::loadInfoFromFilesystem(const LLUUID& mesh_id, MeshHeaderInfo& info, boost::function<bool(const LLUUID&, U8*, S32)> fn)
+bool LLMeshRepoThread::loadInfoFromFilesystem(const LLUUID& mesh_id, MeshHeaderInfo& info, boost::function<EMeshProcessingResult(const LLUUID&, U8*, S32)> fn)
 {
     //check cache for mesh skin info
     LLFileSystem file(mesh_id, LLAssetType::AT_MESH);
@@ -1352,7 +1364,7 @@ bool LLMeshRepoThread::loadInfoFromFilesystem(const LLUUID& mesh_id, MeshHeaderI
     return false;
 }
 
-bool LLMeshRepoThread::fetchMeshSkinInfo(const LLUUID& mesh_id, bool can_retry)
+bool LLMeshRepoThread::fetchMeshSkinInfo(const LLUUID& mesh_id, bool can_retry, bool use_cache)
 {
     MeshHeaderInfo info;
     {
@@ -1383,7 +1395,8 @@ bool LLMeshRepoThread::fetchMeshSkinInfo(const LLUUID& mesh_id, bool can_retry)
     if (info.mVersion <= MAX_MESH_VERSION && info.mOffset >= 0 && info.mSize > 0)
     {
         //check cache for mesh skin info
-        if (loadInfoFromFilesystem(mesh_id, info, boost::bind(&LLMeshRepoThread::skinInfoReceived, this, _1, _2, _3)))
+        if (use_cache
+            && loadInfoFromFilesystem(mesh_id, info, boost::bind(&LLMeshRepoThread::postSkinInfoDecode, this, _1, _2, _3, info.mOffset, true)))
             return true;
 
         //reading from cache failed for whatever reason, fetch from sim
@@ -1656,7 +1669,7 @@ bool LLMeshRepoThread::fetchMeshHeader(const LLVolumeParams& mesh_params, bool c
 }
 
 //return false if failed to get mesh lod.
-bool LLMeshRepoThread::fetchMeshLOD(const LLVolumeParams& mesh_params, S32 lod, bool can_retry)
+bool LLMeshRepoThread::fetchMeshLOD(const LLVolumeParams& mesh_params, S32 lod, bool can_retry, bool use_cache)
 {
     const LLUUID& mesh_id = mesh_params.getSculptID();
     MeshHeaderInfo info;
@@ -1687,7 +1700,8 @@ bool LLMeshRepoThread::fetchMeshLOD(const LLVolumeParams& mesh_params, S32 lod,
 
     if(info.mVersion <= MAX_MESH_VERSION && info.mOffset >= 0 && info.mSize > 0)
     {
-        if (loadInfoFromFilesystem(mesh_id, info, boost::bind(&LLMeshRepoThread::lodReceived, this, mesh_params, lod, _2, _3 )))
+        if (use_cache
+            && loadInfoFromFilesystem(mesh_id, info, boost::bind(&LLMeshRepoThread::postLODDecode, this, mesh_params, lod, _2, _3, info.mOffset, true)))
             return true;
 
         //reading from cache failed for whatever reason, fetch from sim
@@ -1751,9 +1765,14 @@ EMeshProcessingResult LLMeshRepoThread::headerReceived(const LLVolumeParams& mes
 
         data_size = dsize;
 
-        boost::iostreams::stream<boost::iostreams::array_source> stream(result_ptr, data_size);
-
-        if (!LLSDSerialize::fromBinary(header_data, stream, data_size))
+        size_t bytes_read = 0;
+        S32 parse_count;
+        {
+            // header_data is only used to fill in header below
+            llsd::DocumentArena arena;
+            parse_count = LLSDSerialize::fromBinary(header_data, (const U8*)result_ptr, data_size, -1, &bytes_read);
+        }
+        if (parse_count <= 0)
         {
             LL_WARNS(LOG_MESH) << "Mesh header parse error.  Not a valid mesh asset!  ID:  " << mesh_id
                                << LL_ENDL;
@@ -1776,7 +1795,7 @@ EMeshProcessingResult LLMeshRepoThread::headerReceived(const LLVolumeParams& mes
         // make sure there is at least one lod, function returns -1 and marks as 404 otherwise
         else if (LLMeshRepository::getActualMeshLOD(header, 0) >= 0)
         {
-            header_size += stream.tellg();
+            header_size += bytes_read;
         }
     }
     else
@@ -1813,29 +1832,175 @@ EMeshProcessingResult LLMeshRepoThread::headerReceived(const LLVolumeParams& mes
     return MESH_OK;
 }
 
-EMeshProcessingResult LLMeshRepoThread::lodReceived(const LLVolumeParams& mesh_params, S32 lod, U8* data, S32 data_size)
+EMeshProcessingResult LLMeshRepoThread::postLODDecode(const LLVolumeParams& mesh_params, S32 lod, U8* data, S32 data_size, S32 offset, bool from_cache)
 {
     if (data == NULL || data_size == 0)
     {
         return MESH_NO_DATA;
     }
 
-    LLPointer<LLVolume> volume = new LLVolume(mesh_params, LLVolumeLODGroup::getVolumeScaleFromDetail(lod));
-    if (volume->unpackVolumeFaces(data, data_size))
+    // the caller's buffer only lives for the duration of this call
+    std::vector<U8> buffer;
+    try
     {
-        if (volume->getNumFaces() > 0)
+        buffer.assign(data, data + data_size);
+    }
+    catch (std::bad_alloc&)
+    {
+        LL_WARNS(LOG_MESH) << "Out of memory for mesh ID " << mesh_params.getSculptID() << " of size: " << data_size << LL_ENDL;
+        return MESH_OUT_OF_MEMORY;
+    }
+
+    ++mDecodesPending;
+    bool posted = mDecodePool->getQueue().post(
+        [this, mesh_params, lod, buffer = std::move(buffer), offset, from_cache, received_at = LLTimer::getTotalSeconds()]
+        () mutable
         {
-            LoadedMesh mesh(volume, mesh_params, lod);
+            const LLUUID& mesh_id = mesh_params.getSculptID();
+            EMeshProcessingResult result = lodReceived(mesh_params, lod, buffer.data(), (S32)buffer.size(), received_at);
+            if (result == MESH_OK)
+            {
+                if (!from_cache)
+                {
+                    // good fetch from sim, write to cache
+                    // <FS:Ansariel> Fix asset caching
+                    //LLFileSystem file(mesh_id, LLAssetType::AT_MESH, LLFileSystem::WRITE);
+                    LLFileSystem file(mesh_id, LLAssetType::AT_MESH, LLFileSystem::READ_WRITE);
+
+                    S32 size = (S32)buffer.size();
+                    if (file.getSize() >= offset + size)
+                    {
+                        file.seek(offset);
+                        file.write(buffer.data(), size);
+                        LLMeshRepository::sCacheBytesWritten += size;
+                        ++LLMeshRepository::sCacheWrites;
+                    }
+                }
+            }
+            else if (from_cache)
             {
+                // stale or damaged cache entry, fetch from sim instead
+                LODRequest req(mesh_params, lod);
+                req.mUseCache = false;
                 LLMutexLock lock(mMutex);
-                mLoadedQ.push_back(mesh);
-                // LLPointer is not thread safe, since we added this pointer into
-                // threaded list, make sure counter gets decreased inside mutex lock
-                // and won't affect mLoadedQ processing
-                volume = NULL;
-                // might be good idea to turn mesh into pointer to avoid making a copy
-                mesh.mVolume = NULL;
+                mLODReqQ.push(req);
+                ++LLMeshRepository::sLODProcessing;
             }
+            else
+            {
+                LL_WARNS(LOG_MESH) << "Error during mesh LOD processing.  ID:  " << mesh_id
+                                   << ", Reason: " << result
+                                   << " LOD: " << lod
+                                   << " Data size: " << buffer.size()
+                                   << " Not retrying."
+                                   << LL_ENDL;
+                LLMutexLock lock(mMutex);
+                mUnavailableQ.emplace_back(mesh_params, lod);
+            }
+            --mDecodesPending;
+        });
+    if (!posted)
+    {
+        --mDecodesPending;
+        LL_DEBUGS(LOG_MESH) << "Tried to decode mesh LOD on shutdown" << LL_ENDL;
+        return MESH_UNKNOWN;
+    }
+
+    return MESH_OK;
+}
+
+EMeshProcessingResult LLMeshRepoThread::postSkinInfoDecode(const LLUUID& mesh_id, U8* data, S32 data_size, S32 offset, bool from_cache)
+{
+    if (data == NULL || data_size == 0)
+    {
+        return MESH_NO_DATA;
+    }
+
+    std::vector<U8> buffer;
+    try
+    {
+        buffer.assign(data, data + data_size);
+    }
+    catch (std::bad_alloc&)
+    {
+        LL_WARNS(LOG_MESH) << "Out of memory for mesh ID " << mesh_id << " of size: " << data_size << LL_ENDL;
+        return MESH_OUT_OF_MEMORY;
+    }
+
+    ++mDecodesPending;
+    bool posted = mDecodePool->getQueue().post(
+        [this, mesh_id, buffer = std::move(buffer), offset, from_cache, received_at = LLTimer::getTotalSeconds()]
+        () mutable
+        {
+            EMeshProcessingResult result = skinInfoReceived(mesh_id, buffer.data(), (S32)buffer.size(), received_at);
+            if (result == MESH_OK)
+            {
+                if (!from_cache)
+                {
+                    // good fetch from sim, write to cache
+                    // <FS:Ansariel> Fix asset caching
+                    //LLFileSystem file(mesh_id, LLAssetType::AT_MESH, LLFileSystem::WRITE);
+                    LLFileSystem file(mesh_id, LLAssetType::AT_MESH, LLFileSystem::READ_WRITE);
+
+                    S32 size = (S32)buffer.size();
+                    if (file.getSize() >= offset + size)
+                    {
+                        LLMeshRepository::sCacheBytesWritten += size;
+                        ++LLMeshRepository::sCacheWrites;
+                        file.seek(offset);
+                        file.write(buffer.data(), size);
+                    }
+                }
+            }
+            else if (from_cache)
+            {
+                UUIDBasedRequest req(mesh_id);
+                req.mUseCache = false;
+                LLMutexLock lock(mMutex);
+                mSkinReqQ.push(req);
+            }
+            else
+            {
+                LL_WARNS(LOG_MESH) << "Error during mesh skin info processing.  ID:  " << mesh_id
+                                   << ", Reason: " << result
+                                   << ".  Not retrying."
+                                   << LL_ENDL;
+                LLMutexLock lock(mMutex);
+                mSkinUnavailableQ.emplace_back(mesh_id);
+            }
+            --mDecodesPending;
+        });
+    if (!posted)
+    {
+        --mDecodesPending;
+        LL_DEBUGS(LOG_MESH) << "Tried to decode mesh skin info on shutdown" << LL_ENDL;
+        return MESH_UNKNOWN;
+    }
+
+    return MESH_OK;
+}
+
+// Threads:  decode pool
+EMeshProcessingResult LLMeshRepoThread::lodReceived(const LLVolumeParams& mesh_params, S32 lod, U8* data, S32 data_size, F64 received_at)
+{
+    LL_PROFILE_ZONE_SCOPED;
+
+    if (data == NULL || data_size == 0)
+    {
+        return MESH_NO_DATA;
+    }
+
+    LLPointer<LLVolume> volume = new LLVolume(mesh_params, LLVolumeLODGroup::getVolumeScaleFromDetail(lod));
+    if (volume->unpackVolumeFaces(data, data_size))
+    {
+        if (volume->getNumFaces() > 0)
+        {
+            LoadedMesh mesh(volume, mesh_params, lod, F32Seconds(LLTimer::getTotalSeconds() - received_at));
+            // LLPointer is not thread safe, drop our reference before the
+            // mesh is published so the main thread is the only one left
+            // touching the count
+            volume = NULL;
+            mLoadedQ.push(std::move(mesh));
             return MESH_OK;
         }
     }
@@ -1843,8 +2008,11 @@ EMeshProcessingResult LLMeshRepoThread::lodReceived(const LLVolumeParams& mesh_p
     return MESH_UNKNOWN;
 }
 
-EMeshProcessingResult LLMeshRepoThread::skinInfoReceived(const LLUUID& mesh_id, U8* data, S32 data_size)
+// Threads:  decode pool
+EMeshProcessingResult LLMeshRepoThread::skinInfoReceived(const LLUUID& mesh_id, U8* data, S32 data_size, F64 received_at)
 {
+    LL_PROFILE_ZONE_SCOPED;
+
     if (data == NULL || data_size == 0)
     {
         return MESH_NO_DATA;
@@ -1869,7 +2037,7 @@ EMeshProcessingResult LLMeshRepoThread::skinInfoReceived(const LLUUID& mesh_id,
     }
 
     {
-        LLMeshSkinInfo* skin_info = nullptr;
+        LLPointer<LLMeshSkinInfo> skin_info;
         try
         {
             skin_info = new LLMeshSkinInfo(mesh_id, skin);
@@ -1881,10 +2049,7 @@ EMeshProcessingResult LLMeshRepoThread::skinInfoReceived(const LLUUID& mesh_id,
         }
 
         // LL_DEBUGS(LOG_MESH) << "info pelvis offset" << info.mPelvisOffset << LL_ENDL;
-        {
-            LLMutexLock lock(mMutex);
-            mSkinInfoQ.emplace_back(skin_info);
-        }
+        mSkinInfoQ.push(LoadedSkinInfo{ std::move(skin_info), F32Seconds(LLTimer::getTotalSeconds() - received_at) });
     }
 
     return MESH_OK;
@@ -2762,27 +2927,23 @@ void LLMeshRepoThread::notifyLoadedMeshes()
 
     std::deque<LoadedMesh> loaded_queue;
     std::deque<LODRequest> unavil_queue;
-    std::vector<LLMeshSkinInfo*> skin_info_q;
+    std::vector<LoadedSkinInfo> skin_info_q;
     std::deque<UUIDBasedRequest> skin_info_unavail_q;
     std::deque<std::unique_ptr<LLModel::Decomposition>> decomp_q;
     std::deque<std::unique_ptr<LLModel::Decomposition>> physics_q;
+    sample(sDecodeQueueDepth, mDecodesPending.load());
+
+    // decoded results arrive without taking mMutex
+    mLoadedQ.popAll(loaded_queue);
+    mSkinInfoQ.popAll(skin_info_q);
+
     {
         LLMutexLock mtx_lock(mMutex);
-        if (!mLoadedQ.empty())
-        {
-            loaded_queue.swap(mLoadedQ);
-        }
-
         if (!mUnavailableQ.empty())
         {
             unavil_queue.swap(mUnavailableQ);
         }
 
-        if (!mSkinInfoQ.empty())
-        {
-            skin_info_q.swap(mSkinInfoQ);
-        }
-
         if (!mSkinUnavailableQ.empty())
         {
             skin_info_unavail_q.swap(mSkinUnavailableQ);
@@ -2807,6 +2968,7 @@ void LLMeshRepoThread::notifyLoadedMeshes()
         // Process the elements free of the lock
         for (const auto& mesh : loaded_queue)
         {
+            sample(sDecodeLatency, mesh.mDecodeLatency);
             if (mesh.mVolume && mesh.mVolume->getNumVolumeFaces() > 0)
             {
                 gMeshRepo.notifyMeshLoaded(mesh.mMeshParams, mesh.mVolume);
@@ -2837,7 +2999,8 @@ void LLMeshRepoThread::notifyLoadedMeshes()
         // Process the elements free of the lock
         for (auto& skin_info : skin_info_q)
         {
-            gMeshRepo.notifySkinInfoReceived(skin_info);
+            sample(sDecodeLatency, skin_info.mDecodeLatency);
+            gMeshRepo.notifySkinInfoReceived(skin_info.mSkinInfo);
         }
     }
 
@@ -3235,26 +3398,9 @@ void LLMeshLODHandler::processData(LLCore::BufferArray * /* body */, S32 /* body
     if ((!MESH_LOD_PROCESS_FAILED)
         && ((data != NULL) == (data_size > 0))) // if we have data but no size or have size but no data, something is wrong
     {
-        EMeshProcessingResult result = gMeshRepo.mThread->lodReceived(mMeshParams, mLOD, data, data_size);
-        if (result == MESH_OK)
-        {
-            // good fetch from sim, write to cache
-            // <FS:Ansariel> Fix asset caching
-            //LLFileSystem file(mMeshParams.getSculptID(), LLAssetType::AT_MESH, LLFileSystem::WRITE);
-            LLFileSystem file(mMeshParams.getSculptID(), LLAssetType::AT_MESH, LLFileSystem::READ_WRITE);
-
-            S32 offset = mOffset;
-            S32 size = mRequestedBytes;
-
-            if (file.getSize() >= offset+size)
-            {
-                file.seek(offset);
-                file.write(data, size);
-                LLMeshRepository::sCacheBytesWritten += size;
-                ++LLMeshRepository::sCacheWrites;
-            }
-        }
-        else
+        // unpacked on the decode pool, which also writes a good block to cache
+        EMeshProcessingResult result = gMeshRepo.mThread->postLODDecode(mMeshParams, mLOD, data, data_size, mOffset, false);
+        if (result != MESH_OK)
         {
             LL_WARNS(LOG_MESH) << "Error during mesh LOD processing.  ID:  " << mMeshParams.getSculptID()
                                << ", Reason: " << result
@@ -3301,23 +3447,9 @@ void LLMeshSkinInfoHandler::processData(LLCore::BufferArray * /* body */, S32 /*
 {
     if ((!MESH_SKIN_INFO_PROCESS_FAILED)
         && ((data != NULL) == (data_size > 0)) // if we have data but no size or have size but no data, something is wrong
-        && gMeshRepo.mThread->skinInfoReceived(mMeshID, data, data_size) == MESH_OK)
+        && gMeshRepo.mThread->postSkinInfoDecode(mMeshID, data, data_size, mOffset, false) == MESH_OK)
     {
-        // good fetch from sim, write to cache
-        // <FS:Ansariel> Fix asset caching
-        //LLFileSystem file(mMeshID, LLAssetType::AT_MESH, LLFileSystem::WRITE);
-        LLFileSystem file(mMeshID, LLAssetType::AT_MESH, LLFileSystem::READ_WRITE);
-
-        S32 offset = mOffset;
-        S32 size = mRequestedBytes;
-
-        if (file.getSize() >= offset+size)
-        {
-            LLMeshRepository::sCacheBytesWritten += size;
-            ++LLMeshRepository::sCacheWrites;
-            file.seek(offset);
-            file.write(data, size);
-        }
+        // unpacked on the decode pool, which also writes a good block to cache
     }
     else
     {
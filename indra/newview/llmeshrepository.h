@@ -27,6 +27,7 @@
 #ifndef LL_MESH_REPOSITORY_H
 #define LL_MESH_REPOSITORY_H
 
+#include <atomic>
 #include <unordered_map>
 #include "llassettype.h"
 #include "llmodel.h"
@@ -40,6 +41,9 @@
 #include "httpheaders.h"
 #include "httphandler.h"
 #include "llthread.h"
+#include "lllockfreequeue.h"
+#include "lltrace.h"
+#include "threadpool_fwd.h"
 
 #include "boost/unordered/unordered_map.hpp"
 #include "boost/unordered/unordered_flat_map.hpp"
@@ -266,6 +270,9 @@ class LLMeshRepoThread final : public LLThread
     static S32 sRequestHighWater;
     static S32 sRequestWaterLevel;          // Stats-use only, may read outside of thread
 
+    static LLTrace::SampleStatHandle<> sDecodeQueueDepth;
+    static LLTrace::SampleStatHandle<F32Milliseconds> sDecodeLatency;
+
     LLMutex*    mMutex;
     LLMutex*    mHeaderMutex;
     LLCondition* mSignal;
@@ -296,9 +303,10 @@ class LLMeshRepoThread final : public LLThread
         LLVolumeParams  mMeshParams;
         S32 mLOD;
         F32 mScore;
+        bool mUseCache; // false once the cached copy failed to decode
 
         LODRequest(const LLVolumeParams&  mesh_params, S32 lod)
-            : RequestStats(), mMeshParams(mesh_params), mLOD(lod), mScore(0.f)
+            : RequestStats(), mMeshParams(mesh_params), mLOD(lod), mScore(0.f), mUseCache(true)
         {
         }
     };
@@ -315,9 +323,10 @@ class LLMeshRepoThread final : public LLThread
     {
     public:
         LLUUID mId;
+        bool mUseCache; // false once the cached copy failed to decode
 
         UUIDBasedRequest(const LLUUID& id)
-            : RequestStats(), mId(id)
+            : RequestStats(), mId(id), mUseCache(true)
         {
         }
 
@@ -333,14 +342,21 @@ class LLMeshRepoThread final : public LLThread
         LLPointer<LLVolume> mVolume;
         LLVolumeParams mMeshParams;
         S32 mLOD;
+        F32Seconds mDecodeLatency;
 
-        LoadedMesh(LLVolume* volume, const LLVolumeParams&  mesh_params, S32 lod)
-            : mVolume(volume), mMeshParams(mesh_params), mLOD(lod)
+        LoadedMesh(LLVolume* volume, const LLVolumeParams&  mesh_params, S32 lod, F32Seconds latency)
+            : mVolume(volume), mMeshParams(mesh_params), mLOD(lod), mDecodeLatency(latency)
         {
         }
 
     };
 
+    struct LoadedSkinInfo
+    {
+        LLPointer<LLMeshSkinInfo> mSkinInfo;
+        F32Seconds mDecodeLatency;
+    };
+
     struct MeshHeaderInfo
     {
         MeshHeaderInfo()
@@ -374,14 +390,14 @@ class LLMeshRepoThread final : public LLThread
     // Fetched and failed request queues
     /////////
 
-    //queue of successfully loaded meshes
-    std::deque<LoadedMesh> mLoadedQ;
+    //queue of successfully loaded meshes, filled by the decode pool
+    LLLockFreeQueue<LoadedMesh> mLoadedQ;
 
     //queue of unavailable LODs (either asset doesn't exist or asset doesn't have desired LOD)
     std::deque<LODRequest> mUnavailableQ;
 
-    // list of completed skin info requests
-    std::vector<LLMeshSkinInfo*> mSkinInfoQ;
+    // list of completed skin info requests, filled by the decode pool
+    LLLockFreeQueue<LoadedSkinInfo> mSkinInfoQ;
 
     // list of skin info requests that have failed or are unavailaibe
     std::deque<UUIDBasedRequest> mSkinUnavailableQ;
@@ -416,6 +432,11 @@ class LLMeshRepoThread final : public LLThread
     int mLegacyGetMeshVersion;
     std::string mGetMeshCapability;
 
+    // LOD and skin info blocks are unpacked here so that many can decode
+    // at once without holding up HTTP completion on the repo thread
+    std::unique_ptr<LL::ThreadPool> mDecodePool;
+    std::atomic<S32> mDecodesPending;
+
     LLMeshRepoThread();
     ~LLMeshRepoThread();
 
@@ -425,17 +446,24 @@ class LLMeshRepoThread final : public LLThread
     void loadMeshLOD(const LLVolumeParams& mesh_params, S32 lod);
 
     bool fetchMeshHeader(const LLVolumeParams& mesh_params, bool can_retry = true);
-    bool fetchMeshLOD(const LLVolumeParams& mesh_params, S32 lod, bool can_retry = true);
+    bool fetchMeshLOD(const LLVolumeParams& mesh_params, S32 lod, bool can_retry = true, bool use_cache = true);
     EMeshProcessingResult headerReceived(const LLVolumeParams& mesh_params, U8* data, S32 data_size);
-    EMeshProcessingResult lodReceived(const LLVolumeParams& mesh_params, S32 lod, U8* data, S32 data_size);
-    EMeshProcessingResult skinInfoReceived(const LLUUID& mesh_id, U8* data, S32 data_size);
+    EMeshProcessingResult lodReceived(const LLVolumeParams& mesh_params, S32 lod, U8* data, S32 data_size, F64 received_at);
+    EMeshProcessingResult skinInfoReceived(const LLUUID& mesh_id, U8* data, S32 data_size, F64 received_at);
     EMeshProcessingResult decompositionReceived(const LLUUID& mesh_id, U8* data, S32 data_size);
     EMeshProcessingResult physicsShapeReceived(const LLUUID& mesh_id, U8* data, S32 data_size);
     bool hasPhysicsShapeInHeader(const LLUUID& mesh_id);
     bool hasSkinInfoInHeader(const LLUUID& mesh_id);
     bool hasHeader(const LLUUID& mesh_id);
 
-    bool loadInfoFromFilesystem(const LLUUID& mesh_id, MeshHeaderInfo& info, boost::function<bool(const LLUUID&, U8*, S32)> fn);
+    // Copy a LOD or skin info block and unpack it on the decode pool.
+    // Blocks read from the cache are refetched if they fail to decode,
+    // blocks fetched over HTTP are written to the cache at offset once
+    // they decode.  Threads:  any
+    EMeshProcessingResult postLODDecode(const LLVolumeParams& mesh_params, S32 lod, U8* data, S32 data_size, S32 offset, bool from_cache);
+    EMeshProcessingResult postSkinInfoDecode(const LLUUID& mesh_id, U8* data, S32 data_size, S32 offset, bool from_cache);
+
+    bool loadInfoFromFilesystem(const LLUUID& mesh_id, MeshHeaderInfo& info, boost::function<EMeshProcessingResult(const LLUUID&, U8*, S32)> fn);
 
     void notifyLoadedMeshes(); // Only call from main thread.
     S32 getActualMeshLOD(const LLVolumeParams& mesh_params, S32 lod);
@@ -446,7 +474,7 @@ class LLMeshRepoThread final : public LLThread
 
     //send request for skin info, returns true if header info exists
     //  (should hold onto mesh_id and try again later if header info does not exist)
-    bool fetchMeshSkinInfo(const LLUUID& mesh_id, bool can_retry = true);
+    bool fetchMeshSkinInfo(const LLUUID& mesh_id, bool can_retry = true, bool use_cache = true);
 
     //send request for decomposition, returns true if header info exists
     //  (should hold onto mesh_id and try again later if header info does not exist)
@@ -644,12 +672,12 @@ class LLMeshRepository
     static U32 sLODPending;
     static U32 sLODProcessing;
     static U32 sCacheBytesRead;
-    static U32 sCacheBytesWritten;
+    static std::atomic<U32> sCacheBytesWritten;
     static U32 sCacheBytesHeaders;
     static U32 sCacheBytesSkins;
     static U32 sCacheBytesDecomps;
     static U32 sCacheReads;
-    static U32 sCacheWrites;
+    static std::atomic<U32> sCacheWrites;
     static U32 sMaxLockHoldoffs;                // Maximum sequential locking failures
 
     static LLDeadmanTimer sQuiescentTimer;      // Time-to-complete-mesh-downloads after significant events
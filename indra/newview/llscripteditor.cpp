@@ -46,6 +46,9 @@ LLScriptEditor::Params::Params()
 LLScriptEditor::LLScriptEditor(const Params& p)
 :   LLTextEditor(p)
 ,   mShowLineNumbers(p.show_line_numbers)
+,   mChangedStart(S32_MAX)
+,   mChangedEnd(0)
+,   mChangedLength(0)
 //    mUseDefaultFontSize(p.default_font_size)
 {
     if (mShowLineNumbers)
@@ -185,11 +188,15 @@ void LLScriptEditor::loadKeywords()
     {
         insert_it = mSegments.insert(insert_it, *list_it);
     }
+
+    mChangedStart = S32_MAX;
+    mChangedEnd = 0;
+    mChangedLength = getLength();
 }
 
 void LLScriptEditor::updateSegments()
 {
-    if (mReflowIndex < S32_MAX && mKeywords.isLoaded() && mParseOnTheFly)
+    if (mReflowIndex < S32_MAX && mKeywords.isLoaded() && mParseOnTheFly && mChangedStart < S32_MAX)
     {
         LL_PROFILE_ZONE_SCOPED;
 
@@ -197,9 +204,19 @@ void LLScriptEditor::updateSegments()
 
         // HACK:  No non-ascii keywords for now
         segment_vec_t segment_list;
-        mKeywords.findSegments(&segment_list, getWText(), *this, style);
-
-        clearSegments();
+        S32 start = mChangedStart;
+        S32 end = mChangedEnd;
+        mKeywords.findSegments(&segment_list, getWText(), *this, style, start, end);
+        mChangedStart = S32_MAX;
+        mChangedEnd = 0;
+
+        // Only the lines from start to end were colored again, the segments
+        // around them were shifted along with the text and are still right.
+        // insertSegment() replaces whatever the new ones overlap.
+        if (start == 0 && end > getLength())
+        {
+            mSegments.clear();
+        }
         for (segment_vec_t::iterator list_it = segment_list.begin(); list_it != segment_list.end(); ++list_it)
         {
             insertSegment(*list_it);
@@ -209,12 +226,31 @@ void LLScriptEditor::updateSegments()
     LLTextBase::updateSegments();
 }
 
+// virtual
+void LLScriptEditor::onValueChange(S32 start, S32 end)
+{
+    // The text from start to end replaced what was from start to end - delta,
+    // grow the changed range to cover it.
+    S32 length = getLength();
+    S32 delta = length - mChangedLength;
+    mChangedLength = length;
+    mChangedEnd = (mChangedEnd > start) ? llmax(mChangedEnd + delta, end) : end;
+    mChangedStart = llmin(mChangedStart, start);
+
+    LLTextEditor::onValueChange(start, end);
+}
+
 void LLScriptEditor::clearSegments()
 {
     if (!mSegments.empty())
     {
         mSegments.clear();
     }
+
+    // nothing left to shift, color everything on the next pass
+    mKeywords.clearSegmentState();
+    mChangedStart = 0;
+    mChangedEnd = getLength();
 }
 
 // Most of this is shamelessly copied from LLTextBase
@@ -64,12 +64,17 @@ class LLScriptEditor : public LLTextEditor
 private:
     void    drawLineNumbers();
     /* virtual */ void  updateSegments() override;
+    /* virtual */ void  onValueChange(S32 start, S32 end) override;
     /* virtual */ void  drawSelectionBackground() override;
     void    loadKeywords(const std::string& filename_keywords,
                          const std::string& filename_colors);
 
     LLKeywords  mKeywords;
     bool        mShowLineNumbers;
+    // text changed since the last keyword pass, S32_MAX start when none
+    S32         mChangedStart;
+    S32         mChangedEnd;
+    S32         mChangedLength;     // text length as of the last change seen
 //    bool mUseDefaultFontSize;
     boost::signals2::connection mFontNameConnection;
     boost::signals2::connection mFontSizeConnection;
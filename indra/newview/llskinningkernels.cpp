@@ -0,0 +1,168 @@
+/**
+* @file llskinningkernels.cpp
+* @brief  Skinning kernels for rigged volumes, kept apart from the avatar
+*         code so they can be tested on their own
+*
+* $LicenseInfo:firstyear=2024&license=viewerlgpl$
+* Second Life Viewer Source Code
+* Copyright (C) 2024, Linden Research, Inc.
+*
+* This library is free software; you can redistribute it and/or
+* modify it under the terms of the GNU Lesser General Public
+* License as published by the Free Software Foundation;
+* version 2.1 of the License only.
+*
+* This library is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+* Lesser General Public License for more details.
+*
+* You should have received a copy of the GNU Lesser General Public
+* License along with this library; if not, write to the Free Software
+* Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*
+* Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+* $/LicenseInfo$
+*/
+
+#include "llviewerprecompiledheaders.h"
+
+#include "llskinningutil.h"
+
+#include <immintrin.h>
+
+void LLSkinningUtil::bindSkinningMatrixPalette(LLMatrix4a* mat, S32 count, const LLMatrix4a& bind_shape_matrix)
+{
+    for (S32 j = 0; j < count; ++j)
+    {
+        // mat[j] applied after the bind shape matrix, treating both as
+        // affine the way the per vertex transforms used to
+        const LLMatrix4a joint_mat = mat[j];
+        joint_mat.rotate(bind_shape_matrix.getRow<0>(), mat[j].getRow<0>());
+        joint_mat.rotate(bind_shape_matrix.getRow<1>(), mat[j].getRow<1>());
+        joint_mat.rotate(bind_shape_matrix.getRow<2>(), mat[j].getRow<2>());
+        joint_mat.affineTransform(bind_shape_matrix.getRow<3>(), mat[j].getRow<3>());
+    }
+}
+
+namespace
+{
+    // Joint indices and normalized weights of a vertex, as in
+    // getPerVertexSkinMatrixUnchecked()
+    inline void get_joint_weights(const LLVector4a& weights, const LLIVector4a& max_joint, S32* idx, LLVector4a& weight)
+    {
+        LLIVector4a joint;
+        joint.setFloatTrunc(weights);
+
+        weight.setSub(weights, joint);
+
+        joint.min16(max_joint);
+        joint.max16(_mm_setzero_si128());
+        joint.store128a(idx);
+
+        LLVector4a scale;
+        scale.setMoveHighLow(weight);
+        scale.add(weight);
+        scale.addFirst(scale.getVectorAt<1>());
+        scale.splat<0>(scale);
+
+        weight.div(scale);
+    }
+
+    // Adds joint K's share of the vertex to res: the vertex transformed by
+    // the joint matrix, scaled by the joint weight
+    template <int K>
+    inline __m128 skin_joint(__m128 res, const LLMatrix4a* mat, const S32* idx, __m128 x, __m128 y, __m128 z, __m128 weight)
+    {
+        const LLMatrix4a& m = mat[idx[K]];
+        __m128 p = _mm_add_ps(m.getRow<3>(), _mm_mul_ps(x, m.getRow<0>()));
+        p = _mm_add_ps(p, _mm_mul_ps(y, m.getRow<1>()));
+        p = _mm_add_ps(p, _mm_mul_ps(z, m.getRow<2>()));
+        return _mm_add_ps(res, _mm_mul_ps(p, _mm_shuffle_ps(weight, weight, _MM_SHUFFLE(K, K, K, K))));
+    }
+
+#if defined(__AVX2__)
+    // Same for two vertices, the first in the low and the second in the
+    // high 128 bit lane
+    template <int K>
+    inline __m256 skin_joint2(__m256 res, const LLMatrix4a* mat, const S32* idx0, const S32* idx1, __m256 x, __m256 y, __m256 z, __m256 weight)
+    {
+        const LLMatrix4a& m0 = mat[idx0[K]];
+        const LLMatrix4a& m1 = mat[idx1[K]];
+        __m256 p = _mm256_add_ps(_mm256_set_m128(m1.getRow<3>(), m0.getRow<3>()),
+                                 _mm256_mul_ps(x, _mm256_set_m128(m1.getRow<0>(), m0.getRow<0>())));
+        p = _mm256_add_ps(p, _mm256_mul_ps(y, _mm256_set_m128(m1.getRow<1>(), m0.getRow<1>())));
+        p = _mm256_add_ps(p, _mm256_mul_ps(z, _mm256_set_m128(m1.getRow<2>(), m0.getRow<2>())));
+        return _mm256_add_ps(res, _mm256_mul_ps(p, _mm256_permute_ps(weight, _MM_SHUFFLE(K, K, K, K))));
+    }
+#endif
+}
+
+void LLSkinningUtil::skinPositions(const LLMatrix4a* mat, S32 count, const LLVector4a* weights,
+                                   const LLVector4a* src, LLVector4a* dst, U32 num_vertices,
+                                   LLVector4a& min, LLVector4a& max)
+{
+    LL_PROFILE_ZONE_SCOPED_CATEGORY_AVATAR;
+
+    // weights index the palette of the mesh, not the whole skeleton
+    const LLIVector4a max_joint((S16)(llmax(count, 1) - 1));
+    __m128 box_min = _mm_set1_ps(F32_MAX);
+    __m128 box_max = _mm_set1_ps(-F32_MAX);
+
+    U32 i = 0;
+#if defined(__AVX2__)
+    __m256 box_min2 = _mm256_set1_ps(F32_MAX);
+    __m256 box_max2 = _mm256_set1_ps(-F32_MAX);
+    for (; i + 1 < num_vertices; i += 2)
+    {
+        alignas(16) S32 idx0[4];
+        alignas(16) S32 idx1[4];
+        LLVector4a weight0, weight1;
+        get_joint_weights(weights[i], max_joint, idx0, weight0);
+        get_joint_weights(weights[i + 1], max_joint, idx1, weight1);
+
+        __m256 v = _mm256_set_m128(src[i + 1], src[i]);
+        __m256 x = _mm256_permute_ps(v, _MM_SHUFFLE(0, 0, 0, 0));
+        __m256 y = _mm256_permute_ps(v, _MM_SHUFFLE(1, 1, 1, 1));
+        __m256 z = _mm256_permute_ps(v, _MM_SHUFFLE(2, 2, 2, 2));
+        __m256 weight = _mm256_set_m128(weight1, weight0);
+
+        __m256 res = _mm256_setzero_ps();
+        res = skin_joint2<0>(res, mat, idx0, idx1, x, y, z, weight);
+        res = skin_joint2<1>(res, mat, idx0, idx1, x, y, z, weight);
+        res = skin_joint2<2>(res, mat, idx0, idx1, x, y, z, weight);
+        res = skin_joint2<3>(res, mat, idx0, idx1, x, y, z, weight);
+
+        _mm256_storeu2_m128((F32*)&dst[i + 1], (F32*)&dst[i], res);
+        box_min2 = _mm256_min_ps(box_min2, res);
+        box_max2 = _mm256_max_ps(box_max2, res);
+    }
+    box_min = _mm_min_ps(_mm256_castps256_ps128(box_min2), _mm256_extractf128_ps(box_min2, 1));
+    box_max = _mm_max_ps(_mm256_castps256_ps128(box_max2), _mm256_extractf128_ps(box_max2, 1));
+#endif
+
+    for (; i < num_vertices; ++i)
+    {
+        alignas(16) S32 idx[4];
+        LLVector4a weight;
+        get_joint_weights(weights[i], max_joint, idx, weight);
+
+        __m128 v = src[i];
+        __m128 x = _mm_shuffle_ps(v, v, _MM_SHUFFLE(0, 0, 0, 0));
+        __m128 y = _mm_shuffle_ps(v, v, _MM_SHUFFLE(1, 1, 1, 1));
+        __m128 z = _mm_shuffle_ps(v, v, _MM_SHUFFLE(2, 2, 2, 2));
+
+        __m128 res = _mm_setzero_ps();
+        res = skin_joint<0>(res, mat, idx, x, y, z, weight);
+        res = skin_joint<1>(res, mat, idx, x, y, z, weight);
+        res = skin_joint<2>(res, mat, idx, x, y, z, weight);
+        res = skin_joint<3>(res, mat, idx, x, y, z, weight);
+
+        dst[i] = res;
+        box_min = _mm_min_ps(box_min, res);
+        box_max = _mm_max_ps(box_max, res);
+    }
+
+    min = box_min;
+    max = box_max;
+}
@@ -52,6 +52,15 @@ namespace LLSkinningUtil
 
     void initJointNums(LLMeshSkinInfo* skin, LLVOAvatar *avatar);
     void initSkinningMatrixPalette(LLMatrix4a* mat, S32 count, const LLMeshSkinInfo* skin, LLVOAvatar *avatar);
+    // Folds the bind shape matrix into the palette, skinPositions() then
+    // needs a single transform per vertex
+    void bindSkinningMatrixPalette(LLMatrix4a* mat, S32 count, const LLMatrix4a& bind_shape_matrix);
+    // Skins num_vertices positions with a bound palette of count matrices,
+    // several vertices at a time where AVX2 is available, and returns the
+    // bounds of the result.  Reentrant, faces can be skinned in parallel.
+    void skinPositions(const LLMatrix4a* mat, S32 count, const LLVector4a* weights,
+                       const LLVector4a* src, LLVector4a* dst, U32 num_vertices,
+                       LLVector4a& min, LLVector4a& max);
     void checkSkinWeights(LLVector4a* weights, U32 num_vertices, const LLMeshSkinInfo* skin);
     void getPerVertexSkinMatrix(F32* weights, const LLMatrix4a* mat, bool handle_bad_scale, LLMatrix4a& final_mat);
 
@@ -1041,7 +1041,8 @@ void LLSpatialPartition::shift(const LLVector4a &offset)
 class LLOctreeCull : public LLViewerOctreeCull
 {
 public:
-    LLOctreeCull(LLCamera* camera) : LLViewerOctreeCull(camera) {}
+    LLOctreeCull(LLCamera* camera, LLCullResult* result = NULL)
+        : LLViewerOctreeCull(camera), mResult(result) {}
 
     virtual bool earlyFail(LLViewerOctreeGroup* base_group)
     {
@@ -1057,7 +1058,14 @@ class LLOctreeCull : public LLViewerOctreeCull
             LLPipeline::sUseOcclusion &&            //ignore occlusion if disabled
             group->isOcclusionState(LLSpatialGroup::OCCLUDED))
         {
-            gPipeline.markOccluder(group);
+            if (mResult)
+            {
+                gPipeline.markOccluder(group, *mResult);
+            }
+            else
+            {
+                gPipeline.markOccluder(group);
+            }
             return true;
         }
 
@@ -1074,6 +1082,20 @@ class LLOctreeCull : public LLViewerOctreeCull
         return res;
     }
 
+    virtual bool frustumCheckChildren(const OctreeNode* branch, S32* results)
+    {
+        AABBInFrustumNoFarClipChildBounds(branch, results);
+        for (U32 i = 0; i < branch->getChildCount(); i++)
+        {
+            if (results[i] != 0)
+            {
+                const LLViewerOctreeGroup* group = (const LLViewerOctreeGroup*) branch->getChild(i)->getListener(0);
+                results[i] = llmin(results[i], AABBSphereIntersectGroupExtents(group));
+            }
+        }
+        return true;
+    }
+
     virtual S32 frustumCheckObjects(const LLViewerOctreeGroup* group)
     {
         S32 res = AABBInFrustumNoFarClipObjectBounds(group);
@@ -1092,21 +1114,37 @@ class LLOctreeCull : public LLViewerOctreeCull
         {
             group->doOcclusion(mCamera);
         }*/
-        gPipeline.markNotCulled(group, *mCamera);
+        if (mResult)
+        {
+            gPipeline.markNotCulled(group, *mCamera, *mResult);
+        }
+        else
+        {
+            gPipeline.markNotCulled(group, *mCamera);
+        }
     }
+
+protected:
+    LLCullResult* mResult; //where visible groups go when culling off the main thread, NULL for the pipeline's result
 };
 
 class LLOctreeCullNoFarClip : public LLOctreeCull
 {
 public:
-    LLOctreeCullNoFarClip(LLCamera* camera)
-        : LLOctreeCull(camera) { }
+    LLOctreeCullNoFarClip(LLCamera* camera, LLCullResult* result = NULL)
+        : LLOctreeCull(camera, result) { }
 
     virtual S32 frustumCheck(const LLViewerOctreeGroup* group)
     {
         return AABBInFrustumNoFarClipGroupBounds(group);
     }
 
+    virtual bool frustumCheckChildren(const OctreeNode* branch, S32* results)
+    {
+        AABBInFrustumNoFarClipChildBounds(branch, results);
+        return true;
+    }
+
     virtual S32 frustumCheckObjects(const LLViewerOctreeGroup* group)
     {
         S32 res = AABBInFrustumNoFarClipObjectBounds(group);
@@ -1117,14 +1155,20 @@ class LLOctreeCullNoFarClip : public LLOctreeCull
 class LLOctreeCullShadow : public LLOctreeCull
 {
 public:
-    LLOctreeCullShadow(LLCamera* camera)
-        : LLOctreeCull(camera) { }
+    LLOctreeCullShadow(LLCamera* camera, LLCullResult* result = NULL)
+        : LLOctreeCull(camera, result) { }
 
     virtual S32 frustumCheck(const LLViewerOctreeGroup* group)
     {
         return AABBInFrustumGroupBounds(group);
     }
 
+    virtual bool frustumCheckChildren(const OctreeNode* branch, S32* results)
+    {
+        AABBInFrustumChildBounds(branch, results);
+        return true;
+    }
+
     virtual S32 frustumCheckObjects(const LLViewerOctreeGroup* group)
     {
         return AABBInFrustumObjectBounds(group);
@@ -1431,9 +1475,8 @@ S32 LLSpatialPartition::cull(LLCamera &camera, std::vector<LLDrawable *>* result
 
 extern BOOL gCubeSnapshot;
 
-S32 LLSpatialPartition::cull(LLCamera &camera, bool do_occlusion)
+void LLSpatialPartition::rebound()
 {
-    LL_PROFILE_ZONE_SCOPED_CATEGORY_SPATIAL;
 #if LL_OCTREE_PARANOIA_CHECK
     ((LLSpatialGroup*)mOctree->getListener(0))->checkStates();
 #endif
@@ -1443,6 +1486,12 @@ S32 LLSpatialPartition::cull(LLCamera &camera, bool do_occlusion)
 #if LL_OCTREE_PARANOIA_CHECK
     ((LLSpatialGroup*)mOctree->getListener(0))->validate();
 #endif
+}
+
+S32 LLSpatialPartition::cull(LLCamera &camera, bool do_occlusion)
+{
+    LL_PROFILE_ZONE_SCOPED_CATEGORY_SPATIAL;
+    rebound();
 
     if (LLPipeline::sShadowRender)
     {
@@ -1463,6 +1512,27 @@ S32 LLSpatialPartition::cull(LLCamera &camera, bool do_occlusion)
     return 0;
 }
 
+void LLSpatialPartition::cull(LLCamera &camera, LLCullResult& result)
+{
+    LL_PROFILE_ZONE_SCOPED_CATEGORY_SPATIAL;
+
+    if (LLPipeline::sShadowRender)
+    {
+        LLOctreeCullShadow culler(&camera, &result);
+        culler.traverse(mOctree);
+    }
+    else if (mInfiniteFarClip || (!LLPipeline::sUseFarClip && !gCubeSnapshot))
+    {
+        LLOctreeCullNoFarClip culler(&camera, &result);
+        culler.traverse(mOctree);
+    }
+    else
+    {
+        LLOctreeCull culler(&camera, &result);
+        culler.traverse(mOctree);
+    }
+}
+
 void pushVerts(LLDrawInfo* params)
 {
     LLRenderPass::applyModelMatrix(*params);
@@ -55,6 +55,7 @@ class LLSpatialBridge;
 class LLSpatialGroup;
 class LLViewerRegion;
 class LLReflectionMap;
+class LLCullResult;
 
 void pushVerts(LLFace* face);
 
@@ -402,6 +403,12 @@ class LLSpatialPartition: public LLViewerOctreePartition, public LLGeometryManag
     /*virtual*/ S32 cull(LLCamera &camera, bool do_occlusion=false); // Cull on arbitrary frustum
     S32 cull(LLCamera &camera, std::vector<LLDrawable *>* results, BOOL for_select); // Cull on arbitrary frustum
 
+    // Cull into result instead of the pipeline's cull result, call rebound() first.
+    // Safe to run on a worker thread alongside other partitions as long as no
+    // occlusion query gets read back (see LLPipeline::canCullInParallel()).
+    void cull(LLCamera &camera, LLCullResult& result);
+    void rebound(); // update the bounds of the octree
+
     BOOL isVisible(const LLVector3& v);
     bool isHUDPartition() ;
 
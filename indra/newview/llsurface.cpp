@@ -54,6 +54,7 @@
 #include "llglheaders.h"
 #include "lldrawpoolterrain.h"
 #include "lldrawable.h"
+#include "workqueue.h"
 
 extern LLPipeline gPipeline;
 extern bool gShiftFrame;
@@ -62,6 +63,7 @@ LLColor4U MAX_WATER_COLOR(0, 48, 96, 240);
 
 
 S32 LLSurface::sTextureSize = 256;
+U32 LLSurface::sNextGeneration = 0;
 
 // ---------------- LLSurface:: Public Members ---------------
 
@@ -78,6 +80,8 @@ LLSurface::LLSurface(U32 type, LLViewerRegion *regionp) :
     mGridsPerPatchEdge(0),
     mMetersPerGrid(1.0f),
     mMetersPerEdge(1.0f),
+    mLayerDataSerial(0),
+    mGeneration(0),
     mRegionp(regionp)
 {
     // Surface data
@@ -167,6 +171,8 @@ void LLSurface::create(const S32 grids_per_edge,
     mGridsPerPatchEdge = grids_per_patch_edge;
     mPatchesPerEdge = (mGridsPerEdge - 1) / mGridsPerPatchEdge;
     mNumberOfPatches = mPatchesPerEdge * mPatchesPerEdge;
+    mPatchDataSerials.assign(mNumberOfPatches, 0);
+    mGeneration = ++sNextGeneration;
     mMetersPerGrid = width / ((F32)(mGridsPerEdge - 1));
     mMetersPerEdge = mMetersPerGrid * (mGridsPerEdge - 1);
     sTextureSize = width;
@@ -750,21 +756,47 @@ bool LLSurface::idleUpdate(F32 max_update_time)
 template bool LLSurface::idleUpdate</*PBR=*/false>(F32 max_update_time);
 template bool LLSurface::idleUpdate</*PBR=*/true>(F32 max_update_time);
 
-void LLSurface::decompressDCTPatch(LLBitPack &bitpack, LLGroupHeader *gopp, BOOL b_large_patch)
+// Zeros added past the end of a layer data packet, enough for the header
+// and the coefficients of a patch (one bit each when zero), so that the
+// decoding of a truncated packet stops before leaving the copy.
+const S32 LAYER_DATA_PADDING = 16 + LARGE_PATCH_SIZE*LARGE_PATCH_SIZE/8;
+
+// Heights of the patches of one layer data packet, decoded off the main
+// thread
+struct LLSurface::DecodedPatches
 {
+    S32 mPatchSize = 0;
+    std::vector<S32> mPatches;      // index in mPatchList of each patch
+    std::vector<F32> mHeights;      // mPatchSize*mPatchSize per patch, row by row
+};
 
-    LLPatchHeader  ph;
-    S32 j, i;
-    S32 patch[LARGE_PATCH_SIZE*LARGE_PATCH_SIZE];
-    LLSurfacePatch *patchp;
+// static
+LLSurface::DecodedPatches LLSurface::decodePatches(U8 *data, S32 size, BOOL b_large_patch, S32 patches_per_edge)
+{
+    LL_PROFILE_ZONE_SCOPED;
+
+    DecodedPatches decoded;
 
-    init_patch_decompressor(gopp->patch_size);
-    gopp->stride = mGridsPerEdge;
-    set_group_of_patch_header(gopp);
+    LLBitPack bitpack(data, size);
+    LLGroupHeader goph;
+    unpack_patch_group_header(bitpack, &goph);
 
+    // decode to packed rows, they are copied to the surface later
+    goph.stride = goph.patch_size;
+    LLPatchDecoder decoder;
+    if (!decoder.setGroupHeader(goph))
+    {
+        LL_WARNS() << "Received invalid terrain packet - patch size " << (S32)goph.patch_size << LL_ENDL;
+        return decoded;
+    }
+    decoded.mPatchSize = goph.patch_size;
+    const S32 patch_area = decoded.mPatchSize*decoded.mPatchSize;
+
+    LLPatchHeader  ph;
+    S32 j, i;
     while (1)
     {
-        decode_patch_header(bitpack, &ph, b_large_patch);
+        unpack_patch_header(bitpack, &ph, b_large_patch);
         if (ph.quant_wbits == END_OF_PATCHES)
         {
             break;
@@ -781,10 +813,10 @@ void LLSurface::decompressDCTPatch(LLBitPack &bitpack, LLGroupHeader *gopp, BOOL
             j = ph.patchids & 0x1F; //y
         }
 
-        if ((i >= mPatchesPerEdge) || (j >= mPatchesPerEdge))
+        if ((i >= patches_per_edge) || (j >= patches_per_edge))
         {
             LL_WARNS() << "Received invalid terrain packet - patch header patch ID incorrect!"
-                << " patches per edge " << mPatchesPerEdge
+                << " patches per edge " << patches_per_edge
                 << " i " << i
                 << " j " << j
                 << " dc_offset " << ph.dc_offset
@@ -792,14 +824,56 @@ void LLSurface::decompressDCTPatch(LLBitPack &bitpack, LLGroupHeader *gopp, BOOL
                 << " quant_wbits " << (S32)ph.quant_wbits
                 << " patchids " << (S32)ph.patchids
                 << LL_ENDL;
-            return;
+            break;
         }
 
-        patchp = &mPatchList[j*mPatchesPerEdge + i];
+        decoded.mHeights.resize(decoded.mHeights.size() + patch_area);
+        decoder.decodePatch(bitpack, ph, &decoded.mHeights[decoded.mHeights.size() - patch_area]);
+        if (bitpack.mBufferSize > (U32)size)
+        {
+            LL_WARNS() << "Received invalid terrain packet - patch data past the end of the packet" << LL_ENDL;
+            decoded.mHeights.resize(decoded.mHeights.size() - patch_area);
+            break;
+        }
+        decoded.mPatches.push_back(j*patches_per_edge + i);
+    }
 
+    return decoded;
+}
 
-        decode_patch(bitpack, patch);
-        decompress_patch(patchp->getDataZ(), patch, &ph);
+void LLSurface::applyDecodedPatches(U32 serial, const DecodedPatches &decoded)
+{
+    LL_PROFILE_ZONE_SCOPED;
+
+    if (decoded.mPatches.empty())
+    {
+        return;
+    }
+    if (decoded.mPatchSize != mGridsPerPatchEdge)
+    {
+        LL_WARNS() << "Received invalid terrain packet - patch size " << decoded.mPatchSize
+            << " grids per patch edge " << mGridsPerPatchEdge << LL_ENDL;
+        return;
+    }
+
+    const S32 size = decoded.mPatchSize;
+    for (S32 k = 0; k < (S32)decoded.mPatches.size(); k++)
+    {
+        S32 index = decoded.mPatches[k];
+        if (mPatchDataSerials[index] > serial)
+        {
+            // a packet received later got decoded first
+            continue;
+        }
+        mPatchDataSerials[index] = serial;
+
+        LLSurfacePatch *patchp = &mPatchList[index];
+        F32 *dest = patchp->getDataZ();
+        const F32 *src = &decoded.mHeights[k*size*size];
+        for (S32 j = 0; j < size; j++)
+        {
+            memcpy(dest + j*mGridsPerEdge, src + j*size, size*sizeof(F32));
+        }
 
         // Update edges for neighbors.  Need to guarantee that this gets done before we generate vertical stats.
         patchp->updateNorthEdge();
@@ -824,6 +898,48 @@ void LLSurface::decompressDCTPatch(LLBitPack &bitpack, LLGroupHeader *gopp, BOOL
     }
 }
 
+void LLSurface::decompressDCTPatches(const U8 *data, S32 size, BOOL b_large_patch)
+{
+    LL_PROFILE_ZONE_SCOPED;
+
+    U32 serial = ++mLayerDataSerial;
+    S32 patches_per_edge = mPatchesPerEdge;
+    std::vector<U8> packet(size + LAYER_DATA_PADDING, 0);
+    memcpy(packet.data(), data, size);
+
+    auto decode = [packet, size, b_large_patch, patches_per_edge]() mutable
+    {
+        return decodePatches(packet.data(), size, b_large_patch, patches_per_edge);
+    };
+
+    LL::WorkQueue::ptr_t main_queue = LL::WorkQueue::getInstance("mainloop");
+    LL::WorkQueue::ptr_t general_queue = LL::WorkQueue::getInstance("General");
+    if (!mRegionp || !main_queue || !general_queue)
+    {
+        applyDecodedPatches(serial, decode());
+        return;
+    }
+
+    U64 handle = mRegionp->getHandle();
+    U32 generation = mGeneration;
+    auto apply = [handle, generation, serial](DecodedPatches decoded)
+    {
+        // The region may have been disconnected meanwhile, or disconnected and
+        // connected again (teleport out and back), in which case its serials
+        // started over and the packet belongs to the old surface.
+        LLViewerRegion *regionp = LLWorld::instanceExists() ? LLWorld::instance().getRegionFromHandle(handle) : NULL;
+        if (regionp && regionp->getLand().mGeneration == generation)
+        {
+            regionp->getLand().applyDecodedPatches(serial, decoded);
+        }
+    };
+    // postTo() moves from its arguments even when it fails, hand it copies
+    if (!main_queue->postTo(general_queue, decltype(decode)(decode), decltype(apply)(apply)))
+    {
+        apply(decode());
+    }
+}
+
 
 // Retrurns TRUE if "position" is within the bounds of surface.
 // "position" is region-local
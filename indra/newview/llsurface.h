@@ -84,7 +84,11 @@ class LLSurface
     void disconnectNeighbor(LLSurface *neighborp);
     void disconnectAllNeighbors();
 
-    virtual void decompressDCTPatch(LLBitPack &bitpack, LLGroupHeader *gopp, BOOL b_large_patch);
+    // Decodes the terrain patches of a layer data packet on the "General"
+    // thread pool, then copies them into the surface on the main thread.
+    // A patch is never overwritten by a packet received before the one that
+    // last set it.
+    void decompressDCTPatches(const U8 *data, S32 size, BOOL b_large_patch);
     virtual void updatePatchVisibilities(LLAgent &agent);
 
     inline F32 getZ(const U32 k) const              { return mSurfaceZ[k]; }
@@ -186,6 +190,10 @@ class LLSurface
 
     LLSurfacePatch *getPatch(const S32 x, const S32 y) const;
 
+    struct DecodedPatches;
+    static DecodedPatches decodePatches(U8 *data, S32 size, BOOL b_large_patch, S32 patches_per_edge);
+    void applyDecodedPatches(U32 serial, const DecodedPatches &decoded);
+
 protected:
     LLVector3d  mOriginGlobal;      // In absolute frame
     LLSurfacePatch *mPatchList;     // Array of all patches
@@ -220,9 +228,14 @@ class LLSurface
 
     S32         mSurfacePatchUpdateCount;                   // Number of frames since last update.
 
+    U32         mLayerDataSerial;           // Serial number of the last layer data packet received
+    std::vector<U32> mPatchDataSerials;     // Serial number of the packet each patch was last set from
+    U32         mGeneration;                // Tells this surface from an earlier one of a region with the same handle
+
 private:
     LLViewerRegion *mRegionp; // Patch whose coordinate system this surface is using.
     static S32  sTextureSize;               // Size of the surface texture
+    static U32  sNextGeneration;
 };
 
 extern template bool LLSurface::idleUpdate</*PBR=*/false>(F32 max_update_time);
@@ -33,6 +33,7 @@
 #include "llimage.h"
 #include "llimagej2c.h" // for version control
 #include "lllfsthread.h"
+#include "llslabcache.h"
 #include "llviewercontrol.h"
 
 // Included to allow LLTextureCache::purgeTextures() to pause watchdog timeout
@@ -46,6 +47,9 @@
 //  First TEXTURE_CACHE_ENTRY_SIZE bytes of each texture in texture.entries in same order
 // cache/textures/[0-F]/UUID.texture
 //  Actual texture body files
+// or, with TextureCacheSlabStorage:
+// cache/texture_NN.slab
+//  Fast cache entry and whole texture of each UUID (see LLSlabCache)
 
 //note: there is no good to define 1024 for TEXTURE_CACHE_ENTRY_SIZE while FIRST_PACKET_SIZE is 600 on sim side.
 const S32 TEXTURE_CACHE_ENTRY_SIZE = FIRST_PACKET_SIZE;//1024;
@@ -380,6 +384,18 @@ bool LLTextureCacheRemoteWorker::doRead()
         done = true;
     }
 
+    // Slab storage: everything comes out of the one record
+    if (!done && (mState == CACHE) && mCache->mSlabCache)
+    {
+        S32 image_size = 0;
+        mDataSize = mCache->mSlabCache->readBody(mID, mOffset, mDataSize, mReadData, image_size);
+        if (mDataSize > 0)
+        {
+            mImageSize = image_size;
+        }
+        done = true;
+    }
+
     // Second state / stage : identify the cache or not...
     if (!done && (mState == CACHE))
     {
@@ -561,6 +577,25 @@ bool LLTextureCacheRemoteWorker::doWrite()
 
     // No LOCAL state for write(): because it doesn't make much sense to cache a local file...
 
+    // Slab storage: the fast cache entry and the data go in a single record
+    if (!done && (mState == CACHE) && mCache->mSlabCache)
+    {
+        // Keep what is cached unless we have more of the texture
+        if (mCache->mSlabCache->getBodySize(mID) < mDataSize)
+        {
+            U8 fast_cache_entry[TEXTURE_FAST_CACHE_ENTRY_SIZE];
+            S32 entry_size = LLTextureCache::packFastCacheEntry(mRawImage, mRawDiscardLevel, fast_cache_entry);
+            if (!entry_size
+                || !mCache->mSlabCache->write(mID, mImageSize, fast_cache_entry, entry_size, mWriteData, mDataSize))
+            {
+                LL_WARNS() << "LLTextureCacheWorker: " << mID
+                    << " Unable to write to the slab cache, size: " << mDataSize << LL_ENDL;
+                mDataSize = -1; // failed
+            }
+        }
+        done = true;
+    }
+
     // Second state / stage : set an entry in the headers entry (texture.entries) file
     if (!done && (mState == CACHE))
     {
@@ -858,6 +893,10 @@ size_t LLTextureCache::update(F32 max_time_ms)
     {
         timer.reset() ;
         writeUpdatedEntries() ;
+        if (mSlabCache)
+        {
+            mSlabCache->flush();
+        }
     }
 
     return res;
@@ -884,12 +923,27 @@ std::string LLTextureCache::getTextureFileName(const LLUUID& id)
 //debug
 BOOL LLTextureCache::isInCache(const LLUUID& id)
 {
+    if (mSlabCache)
+    {
+        return mSlabCache->has(id);
+    }
+
     LLMutexLock lock(&mHeaderMutex);
     id_map_t::const_iterator iter = mHeaderIDMap.find(id);
 
     return (iter != mHeaderIDMap.end()) ;
 }
 
+S64Bytes LLTextureCache::getUsage()
+{
+    return S64Bytes(mSlabCache ? mSlabCache->getUsage() : mTexturesSizeTotal);
+}
+
+U32 LLTextureCache::getEntries()
+{
+    return mSlabCache ? mSlabCache->getEntries() : mHeaderEntriesInfo.mEntries;
+}
+
 //debug
 BOOL LLTextureCache::isInLocal(const LLUUID& id)
 {
@@ -949,6 +1003,7 @@ const char* old_textures_dirname = "textures";
 //change the location of the texture cache to prevent from being deleted by old version viewers.
 const char* textures_dirname = "texturecache";
 const char* fast_cache_filename = "FastCache.cache";
+const char* slab_prefix = "texture_";
 
 void LLTextureCache::setDirNames(ELLPath location)
 {
@@ -979,7 +1034,15 @@ void LLTextureCache::purgeCache(ELLPath location, bool remove_dir)
             file_name = gDirUtilp->getExpandedFilename(location, cache_filename);
             LLAPRFile::remove(file_name, mHeaderAPRFilePoolp);
 
-            purgeAllTextures(true);
+            if (mSlabCache)
+            {
+                // purgeAllTextures() would only empty the open slab
+                gDirUtilp->deleteDirAndContents(mTexturesDirName);
+            }
+            else
+            {
+                purgeAllTextures(true);
+            }
         }
         mTexturesDirName = texture_dir ;
     }
@@ -1000,19 +1063,10 @@ S64 LLTextureCache::initCache(ELLPath location, S64 max_size, BOOL texture_cache
 {
     llassert_always(getPending() == 0) ; //should not start accessing the texture cache before initialized.
 
-    S64 entries_size = (max_size * 36) / 100; //0.36 * max_size
-    S64 max_entries = entries_size / (S64)(TEXTURE_CACHE_ENTRY_SIZE + TEXTURE_FAST_CACHE_ENTRY_SIZE);
-    sCacheMaxEntries = (U32)(llmin((S64)sCacheMaxEntries, max_entries));
-    entries_size = (S64)sCacheMaxEntries * (S64)(TEXTURE_CACHE_ENTRY_SIZE + TEXTURE_FAST_CACHE_ENTRY_SIZE);
-    max_size -= entries_size;
-    if (sCacheMaxTexturesSize > 0)
-        sCacheMaxTexturesSize = llmin(sCacheMaxTexturesSize, max_size);
-    else
-        sCacheMaxTexturesSize = max_size;
-    max_size -= sCacheMaxTexturesSize;
-
-    LL_INFOS("TextureCache") << "Headers: " << sCacheMaxEntries
-            << " Textures size: " << sCacheMaxTexturesSize / (1024 * 1024) << " MB" << LL_ENDL;
+    const bool use_slab = gSavedSettings.getBOOL("TextureCacheSlabStorage");
+    const U32 max_entries = sCacheMaxEntries;
+    const S64 max_textures_size = sCacheMaxTexturesSize;
+    S64 unused_size = splitCacheBudget(max_size, use_slab);
 
     setDirNames(location);
 
@@ -1024,12 +1078,28 @@ S64 LLTextureCache::initCache(ELLPath location, S64 max_size, BOOL texture_cache
 
         if(mReadOnly)
         {
-            return max_size ;
+            return unused_size ;
         }
     }
 
+    if (use_slab)
+    {
+        if (initSlabCache())
+        {
+            return unused_size; // unused cache space
+        }
+        // the legacy files need their share of the budget back
+        sCacheMaxEntries = max_entries;
+        sCacheMaxTexturesSize = max_textures_size;
+        unused_size = splitCacheBudget(max_size, false);
+    }
     if (!mReadOnly)
     {
+        if (LLFile::isdir(mTexturesDirName))
+        {
+            // in case we are switching back from slab storage
+            LLSlabCache::removeFiles(mTexturesDirName, slab_prefix);
+        }
         LLFile::mkdir(mTexturesDirName);
 
         const char* subdirs = "0123456789abcdef";
@@ -1045,7 +1115,83 @@ S64 LLTextureCache::initCache(ELLPath location, S64 max_size, BOOL texture_cache
     llassert_always(getPending() == 0) ; //should not start accessing the texture cache before initialized.
     openFastCache(true);
 
-    return max_size; // unused cache space
+    return unused_size; // unused cache space
+}
+
+// Called in the main thread, from initCache()
+// Splits max_size between the header entries and the texture bodies and
+// returns what is left over.  The slab storage keeps the fast cache entry
+// of each texture inside its record and its index in memory, so it gets
+// the whole budget.
+S64 LLTextureCache::splitCacheBudget(S64 max_size, bool slab_storage)
+{
+    if (slab_storage)
+    {
+        S64 max_entries = max_size / (S64)TEXTURE_FAST_CACHE_ENTRY_SIZE;
+        sCacheMaxEntries = (U32)(llmin((S64)sCacheMaxEntries, max_entries));
+    }
+    else
+    {
+        S64 entries_size = (max_size * 36) / 100; //0.36 * max_size
+        S64 max_entries = entries_size / (S64)(TEXTURE_CACHE_ENTRY_SIZE + TEXTURE_FAST_CACHE_ENTRY_SIZE);
+        sCacheMaxEntries = (U32)(llmin((S64)sCacheMaxEntries, max_entries));
+        entries_size = (S64)sCacheMaxEntries * (S64)(TEXTURE_CACHE_ENTRY_SIZE + TEXTURE_FAST_CACHE_ENTRY_SIZE);
+        max_size -= entries_size;
+    }
+    if (sCacheMaxTexturesSize > 0)
+        sCacheMaxTexturesSize = llmin(sCacheMaxTexturesSize, max_size);
+    else
+        sCacheMaxTexturesSize = max_size;
+    max_size -= sCacheMaxTexturesSize;
+
+    LL_INFOS("TextureCache") << "Headers: " << sCacheMaxEntries
+            << " Textures size: " << sCacheMaxTexturesSize / (1024 * 1024) << " MB" << LL_ENDL;
+    return max_size;
+}
+
+// Called in the main thread, from initCache()
+bool LLTextureCache::initSlabCache()
+{
+    const size_t SLAB_SIZE = 64 * 1024 * 1024;
+    const size_t MIN_SLAB_SIZE = 1024 * 1024;
+    const U32 MIN_SLABS = 4;
+
+    if (!mReadOnly)
+    {
+        if (LLFile::isfile(mHeaderEntriesFileName))
+        {
+            // switching from the per texture files, which we do not convert
+            LL_INFOS("TextureCache") << "Removing the legacy texture cache" << LL_ENDL;
+            purgeAllTextures(true);
+            LLFile::remove(mHeaderEntriesFileName);
+        }
+        LLFile::mkdir(mTexturesDirName);
+    }
+
+    // The slab count is part of the file names and the index entries, so
+    // larger caches get larger slabs
+    S64 budget = sCacheMaxTexturesSize;
+    size_t slab_size = SLAB_SIZE;
+    while (budget / (S64)slab_size > (S64)LLSlabCache::MAX_SLABS && slab_size < LLSlabCache::MAX_SLAB_SIZE)
+    {
+        slab_size *= 2;
+    }
+    while (budget / (S64)slab_size < (S64)MIN_SLABS && slab_size > MIN_SLAB_SIZE)
+    {
+        slab_size /= 2;
+    }
+    U32 slab_count = (U32)llclamp(budget / (S64)slab_size, (S64)MIN_SLABS, (S64)LLSlabCache::MAX_SLABS);
+
+    mSlabCache = std::make_unique<LLSlabCache>();
+    if (!mSlabCache->open(mTexturesDirName, slab_prefix, slab_count, slab_size, sCacheMaxEntries, mReadOnly))
+    {
+        LL_WARNS("TextureCache") << "Unable to open the slab cache, using the legacy cache" << LL_ENDL;
+        mSlabCache.reset();
+        return false;
+    }
+
+    LL_INFOS("TextureCache") << "Slab storage: " << slab_count << " x " << slab_size / (1024 * 1024) << " MB" << LL_ENDL;
+    return true;
 }
 
 //----------------------------------------------------------------------------
@@ -1585,6 +1731,12 @@ void LLTextureCache::clearCorruptedCache()
 
 void LLTextureCache::purgeAllTextures(bool purge_directories)
 {
+    if (mSlabCache)
+    {
+        // Readers use the slab without a lock, so it is emptied in place
+        // and stays mapped; the legacy files below are not in use.
+        mSlabCache->clear();
+    }
     if (!mReadOnly)
     {
         const char* subdirs = "0123456789abcdef";
@@ -1609,10 +1761,13 @@ void LLTextureCache::purgeAllTextures(bool purge_directories)
             PeekMessage(&msg, 0, 0, 0, PM_NOREMOVE | PM_NOYIELD);
 #endif
         }
-        gDirUtilp->deleteFilesInDir(mTexturesDirName, mask); // headers, fast cache
-        if (purge_directories)
+        if (!mSlabCache)
         {
-            LLFile::rmdir(mTexturesDirName);
+            gDirUtilp->deleteFilesInDir(mTexturesDirName, mask); // headers, fast cache
+            if (purge_directories)
+            {
+                LLFile::rmdir(mTexturesDirName);
+            }
         }
     }
     mHeaderIDMap.clear();
@@ -1623,7 +1778,12 @@ void LLTextureCache::purgeAllTextures(bool purge_directories)
 
     // Info with 0 entries
     setEntriesHeader();
-    writeEntriesHeader();
+    if (!mSlabCache)
+    {
+        // a texture.entries file next to the slabs would make the next
+        // start drop them as a legacy cache
+        writeEntriesHeader();
+    }
 
     LL_INFOS() << "The entire texture cache is cleared." << LL_ENDL ;
 }
@@ -2005,6 +2165,29 @@ LLTextureCache::handle_t LLTextureCache::writeToCache(const LLUUID& id,
 //called in the main thread
 LLPointer<LLImageRaw> LLTextureCache::readFromFastCache(const LLUUID& id, S32& discardlevel)
 {
+    if (mSlabCache)
+    {
+        U8 entry[TEXTURE_FAST_CACHE_ENTRY_SIZE];
+        S32 entry_size = mSlabCache->readHead(id, entry, TEXTURE_FAST_CACHE_ENTRY_SIZE);
+        if (entry_size < TEXTURE_FAST_CACHE_ENTRY_OVERHEAD)
+        {
+            return NULL; //not in the cache
+        }
+
+        S32 head[4];
+        memcpy(head, entry, TEXTURE_FAST_CACHE_ENTRY_OVERHEAD);
+        S32 image_size = head[0] * head[1] * head[2];
+        if (image_size <= 0
+            || image_size > llmin(entry_size, TEXTURE_FAST_CACHE_ENTRY_SIZE) - TEXTURE_FAST_CACHE_ENTRY_OVERHEAD
+            || head[3] < 0) //invalid
+        {
+            return NULL;
+        }
+        discardlevel = head[3];
+
+        return new LLImageRaw((const U8*)entry + TEXTURE_FAST_CACHE_ENTRY_OVERHEAD, head[0], head[1], head[2]);
+    }
+
     U32 offset;
     {
         LLMutexLock lock(&mHeaderMutex);
@@ -2063,11 +2246,40 @@ LLPointer<LLImageRaw> LLTextureCache::readFromFastCache(const LLUUID& id, S32& d
 bool LLTextureCache::writeToFastCache(LLUUID image_id, S32 id, LLPointer<LLImageRaw> raw, S32 discardlevel)
 {
     LL_PROFILE_ZONE_SCOPED_CATEGORY_TEXTURE;
+    if (!packFastCacheEntry(raw, discardlevel, mFastCachePadBuffer))
+    {
+        return false;
+    }
+    S32 offset = id * TEXTURE_FAST_CACHE_ENTRY_SIZE;
+
+    {
+        LLMutexLock lock(&mFastCacheMutex);
+
+        openFastCache();
+
+        mFastCachep->seek(APR_SET, offset);
+
+        //no need to do this assertion check. When it fails, let it fail quietly.
+        //this failure could happen because other viewer removes the fast cache file when clearing cache.
+        //--> llassert_always(mFastCachep->write(mFastCachePadBuffer, TEXTURE_FAST_CACHE_ENTRY_SIZE) == TEXTURE_FAST_CACHE_ENTRY_SIZE);
+        mFastCachep->write(mFastCachePadBuffer, TEXTURE_FAST_CACHE_ENTRY_SIZE);
+
+        closeFastCache(true);
+    }
+
+    return true;
+}
+
+//static
+// Fills buffer (TEXTURE_FAST_CACHE_ENTRY_SIZE bytes) with a version of raw small
+// enough for the fast cache and returns the number of bytes used, 0 on failure
+S32 LLTextureCache::packFastCacheEntry(LLPointer<LLImageRaw> raw, S32 discardlevel, U8* buffer)
+{
     //rescale image if needed
     if (raw.isNull() || raw->isBufferInvalid() || !raw->getData())
     {
         LL_ERRS() << "Attempted to write NULL raw image to fastcache" << LL_ENDL;
-        return false;
+        return 0;
     }
 
     S32 w, h, c;
@@ -2095,7 +2307,7 @@ bool LLTextureCache::writeToFastCache(LLUUID image_id, S32 id, LLPointer<LLImage
             if (raw->isBufferInvalid())
             {
                 LL_WARNS() << "Invalid image duplicate buffer" << LL_ENDL;
-                return false;
+                return 0;
             }
 
             raw->scale(w, h);
@@ -2105,35 +2317,23 @@ bool LLTextureCache::writeToFastCache(LLUUID image_id, S32 id, LLPointer<LLImage
     }
 
     //copy data
-    memcpy(mFastCachePadBuffer, &w, sizeof(S32));
-    memcpy(mFastCachePadBuffer + sizeof(S32), &h, sizeof(S32));
-    memcpy(mFastCachePadBuffer + sizeof(S32) * 2, &c, sizeof(S32));
-    memcpy(mFastCachePadBuffer + sizeof(S32) * 3, &discardlevel, sizeof(S32));
+    memcpy(buffer, &w, sizeof(S32));
+    memcpy(buffer + sizeof(S32), &h, sizeof(S32));
+    memcpy(buffer + sizeof(S32) * 2, &c, sizeof(S32));
+    memcpy(buffer + sizeof(S32) * 3, &discardlevel, sizeof(S32));
 
     S32 copy_size = w * h * c;
     if(copy_size > 0) //valid
     {
         copy_size = llmin(copy_size, TEXTURE_FAST_CACHE_ENTRY_SIZE - TEXTURE_FAST_CACHE_ENTRY_OVERHEAD);
-        memcpy(mFastCachePadBuffer + TEXTURE_FAST_CACHE_ENTRY_OVERHEAD, raw->getData(), copy_size);
+        memcpy(buffer + TEXTURE_FAST_CACHE_ENTRY_OVERHEAD, raw->getData(), copy_size);
     }
-    S32 offset = id * TEXTURE_FAST_CACHE_ENTRY_SIZE;
-
+    else
     {
-        LLMutexLock lock(&mFastCacheMutex);
-
-        openFastCache();
-
-        mFastCachep->seek(APR_SET, offset);
-
-        //no need to do this assertion check. When it fails, let it fail quietly.
-        //this failure could happen because other viewer removes the fast cache file when clearing cache.
-        //--> llassert_always(mFastCachep->write(mFastCachePadBuffer, TEXTURE_FAST_CACHE_ENTRY_SIZE) == TEXTURE_FAST_CACHE_ENTRY_SIZE);
-        mFastCachep->write(mFastCachePadBuffer, TEXTURE_FAST_CACHE_ENTRY_SIZE);
-
-        closeFastCache(true);
+        copy_size = 0;
     }
 
-    return true;
+    return TEXTURE_FAST_CACHE_ENTRY_OVERHEAD + copy_size;
 }
 
 void LLTextureCache::openFastCache(bool first_time)
@@ -2277,7 +2477,11 @@ bool LLTextureCache::removeFromCache(const LLUUID& id)
 {
     //LL_WARNS() << "Removing texture from cache: " << id << LL_ENDL;
     bool ret = false ;
-    if (!mReadOnly)
+    if (mSlabCache)
+    {
+        ret = !mReadOnly && mSlabCache->remove(id);
+    }
+    else if (!mReadOnly)
     {
         lockHeaders() ;
 
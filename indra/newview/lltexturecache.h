@@ -39,6 +39,7 @@
 class LLImageFormatted;
 class LLTextureCacheWorker;
 class LLImageRaw;
+class LLSlabCache;
 
 class LLTextureCache final : public LLWorkerThread
 {
@@ -144,9 +145,9 @@ class LLTextureCache final : public LLWorkerThread
     // debug
     S32 getNumReads() { return mReaders.size(); }
     S32 getNumWrites() { return mWriters.size(); }
-    S64Bytes getUsage() { return S64Bytes(mTexturesSizeTotal); }
+    S64Bytes getUsage();
     S64Bytes getMaxUsage() { return S64Bytes(sCacheMaxTexturesSize); }
-    U32 getEntries() { return mHeaderEntriesInfo.mEntries; }
+    U32 getEntries();
     U32 getMaxEntries() { return sCacheMaxEntries; };
     BOOL isInCache(const LLUUID& id) ;
     BOOL isInLocal(const LLUUID& id) ; //not thread safe at the moment
@@ -191,6 +192,10 @@ class LLTextureCache final : public LLWorkerThread
     void openFastCache(bool first_time = false);
     void closeFastCache(bool forced = false);
     bool writeToFastCache(LLUUID image_id, S32 cache_id, LLPointer<LLImageRaw> raw, S32 discardlevel);
+    static S32 packFastCacheEntry(LLPointer<LLImageRaw> raw, S32 discardlevel, U8* buffer);
+
+    bool initSlabCache();
+    static S64 splitCacheBudget(S64 max_size, bool slab_storage);
 
 private:
     // Internal
@@ -246,6 +251,11 @@ class LLTextureCache final : public LLWorkerThread
     typedef std::vector<std::pair<S32, Entry> > idx_entry_vector_t;
     idx_entry_vector_t mPurgeEntryList;
 
+    // Replaces all of the above when TextureCacheSlabStorage is set: the
+    // fast cache entry is the head and the texture data the body of each
+    // record.
+    std::unique_ptr<LLSlabCache> mSlabCache;
+
     // Statics
     static F32 sHeaderCacheVersion;
     static U32 sHeaderCacheAddressSize;
@@ -210,6 +210,7 @@ class LLViewerInventoryCategory  : public LLInventoryCategory
     virtual void packMessage(LLMessageSystem* msg) const;
 
     const LLUUID& getOwnerID() const { return mOwnerID; }
+    void setOwnerID(const LLUUID& owner_id) { mOwnerID = owner_id; }
 
     // Version handling
     enum { VERSION_UNKNOWN = -1, VERSION_INITIAL = 1 };
@@ -2890,12 +2890,9 @@ void LLViewerMediaImpl::update()
     U8* data;
     S32 data_width;
     S32 data_height;
-    S32 x_pos;
-    S32 y_pos;
-    S32 width;
-    S32 height;
+    std::vector<LLRect> rects;
 
-    if (preMediaTexUpdate(media_tex, data, data_width, data_height, x_pos, y_pos, width, height))
+    if (preMediaTexUpdate(media_tex, data, data_width, data_height, rects))
     {
         // Push update to worker thread
         auto main_queue = LLImageGLThread::sEnabledMedia ? mMainQueue.lock() : nullptr;
@@ -2911,7 +2908,7 @@ void LLViewerMediaImpl::update()
 #if LL_IMAGEGL_THREAD_CHECK
                     media_tex->getGLTexture()->mActiveThread = LLThread::currentID();
 #endif
-                    doMediaTexUpdate(media_tex, data, data_width, data_height, x_pos, y_pos, width, height, true);
+                    doMediaTexUpdate(media_tex, data, data_width, data_height, rects, true);
                 },
                 [=]() // callback to main thread
                 {
@@ -2925,12 +2922,12 @@ void LLViewerMediaImpl::update()
         }
         else
         {
-            doMediaTexUpdate(media_tex, data, data_width, data_height, x_pos, y_pos, width, height, false); // otherwise, update on main thread
+            doMediaTexUpdate(media_tex, data, data_width, data_height, rects, false); // otherwise, update on main thread
         }
     }
 }
 
-bool LLViewerMediaImpl::preMediaTexUpdate(LLViewerMediaTexture*& media_tex, U8*& data, S32& data_width, S32& data_height, S32& x_pos, S32& y_pos, S32& width, S32& height)
+bool LLViewerMediaImpl::preMediaTexUpdate(LLViewerMediaTexture*& media_tex, U8*& data, S32& data_width, S32& data_height, std::vector<LLRect>& rects)
 {
     LL_PROFILE_ZONE_SCOPED_CATEGORY_MEDIA;
 
@@ -2942,36 +2939,43 @@ bool LLViewerMediaImpl::preMediaTexUpdate(LLViewerMediaTexture*& media_tex, U8*&
 
         if (media_tex && mMediaSource)
         {
-            LLRect dirty_rect;
-            S32 media_width = mMediaSource->getTextureWidth();
-            S32 media_height = mMediaSource->getTextureHeight();
             //S32 media_depth = mMediaSource->getTextureDepth();
 
             // Since we're updating this texture, we know it's playing.  Tell the texture to do its replacement magic so it gets rendered.
             media_tex->setPlaying(TRUE);
 
-            if (mMediaSource->getDirty(&dirty_rect))
+            // Only ever take the newest complete frame, and only what changed in it since the last one we took.
+            std::vector<LLRect> dirty_rects;
+            data = mMediaSource->lockFrame(dirty_rects);
+            if (data != NULL)
             {
-                // Constrain the dirty rect to be inside the texture
-                x_pos = llmax(dirty_rect.mLeft, 0);
-                y_pos = llmax(dirty_rect.mBottom, 0);
-                width = llmin(dirty_rect.mRight, media_width) - x_pos;
-                height = llmin(dirty_rect.mTop, media_height) - y_pos;
+                data_width = mMediaSource->getWidth();
+                data_height = mMediaSource->getHeight();
 
-                if (width > 0 && height > 0)
+                rects.clear();
+                for (const LLRect& dirty_rect : dirty_rects)
                 {
-                    data = mMediaSource->getBitsData();
-                    data_width = mMediaSource->getWidth();
-                    data_height = mMediaSource->getHeight();
+                    // Constrain the dirty rect to be inside the media, which is all that gets uploaded
+                    S32 x_pos = llmax(dirty_rect.mLeft, 0);
+                    S32 y_pos = llmax(dirty_rect.mBottom, 0);
+                    S32 width = llmin(dirty_rect.mRight, data_width) - x_pos;
+                    S32 height = llmin(dirty_rect.mTop, data_height) - y_pos;
 
-                    if (data != NULL)
+                    if (width > 0 && height > 0)
                     {
-                        // data is ready to be copied to GL
-                        retval = true;
+                        rects.push_back(LLRect(x_pos, y_pos + height, x_pos + width, y_pos));
                     }
                 }
 
-                mMediaSource->resetDirty();
+                if (!rects.empty())
+                {
+                    // data is ready to be copied to GL, the frame stays locked until it has been
+                    retval = true;
+                }
+                else
+                {
+                    mMediaSource->unlockFrame();
+                }
             }
         }
     }
@@ -2980,25 +2984,94 @@ bool LLViewerMediaImpl::preMediaTexUpdate(LLViewerMediaTexture*& media_tex, U8*&
 }
 
 //////////////////////////////////////////////////////////////////////////////////////////
-void LLViewerMediaImpl::doMediaTexUpdate(LLViewerMediaTexture* media_tex, U8* data, S32 data_width, S32 data_height, S32 x_pos, S32 y_pos, S32 width, S32 height, bool sync)
+// Swaps the red and blue channels of the 32 bit pixels in a rect of a frame data_width pixels wide into the same
+// place in dst, four pixels at a time.
+static void swizzle_bgra_rect(U8* dst, const U8* src, S32 data_width, const LLRect& rect)
+{
+    const __m128i green_alpha = _mm_set1_epi32(0xFF00FF00);
+    const __m128i low_byte = _mm_set1_epi32(0x000000FF);
+    const __m128i third_byte = _mm_set1_epi32(0x00FF0000);
+
+    S32 width = rect.getWidth();
+    for (S32 y = rect.mBottom; y < rect.mTop; ++y)
+    {
+        const U8* in = src + ((size_t)y * data_width + rect.mLeft) * 4;
+        U8* out = dst + ((size_t)y * data_width + rect.mLeft) * 4;
+
+        S32 x = 0;
+        for (; x + 4 <= width; x += 4)
+        {
+            __m128i pixels = _mm_loadu_si128((const __m128i*)(in + x * 4));
+            __m128i swapped = _mm_or_si128(_mm_and_si128(pixels, green_alpha),
+                _mm_or_si128(_mm_and_si128(_mm_srli_epi32(pixels, 16), low_byte),
+                             _mm_and_si128(_mm_slli_epi32(pixels, 16), third_byte)));
+            _mm_storeu_si128((__m128i*)(out + x * 4), swapped);
+        }
+        for (; x < width; ++x)
+        {
+            out[x * 4 + 0] = in[x * 4 + 2];
+            out[x * 4 + 1] = in[x * 4 + 1];
+            out[x * 4 + 2] = in[x * 4 + 0];
+            out[x * 4 + 3] = in[x * 4 + 3];
+        }
+    }
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////
+void LLViewerMediaImpl::doMediaTexUpdate(LLViewerMediaTexture* media_tex, U8* data, S32 data_width, S32 data_height, const std::vector<LLRect>& rects, bool sync)
 {
     LL_PROFILE_ZONE_SCOPED_CATEGORY_MEDIA;
     LLMutexLock lock(&mLock); // don't allow media source tear-down during update
 
-    // wrap "data" in an LLImageRaw but do NOT make a copy
-    LLPointer<LLImageRaw> raw = new LLImageRaw(data, media_tex->getWidth(), media_tex->getHeight(), media_tex->getComponents(), true);
+    // On the update thread every frame goes into a fresh texture (see the note below), so all of it is uploaded.
+    // On the main thread a frame that changed everywhere does too, anything less is copied into the one we have.
+    const LLRect& first = rects.front();
+    bool whole_frame = rects.size() == 1 && first.mLeft == 0 && first.mBottom == 0
+        && first.mRight >= data_width && first.mTop >= data_height;
+
+    LLGLuint tex_name = media_tex->getTexName();
+    bool fresh_texture = sync || whole_frame || !tex_name;
+    std::vector<LLRect> whole_rect;
+    if (fresh_texture)
+    {
+        // the locked frame is always complete, whatever changed in it
+        whole_rect.push_back(LLRect(0, data_height, data_width, 0));
+    }
+    const std::vector<LLRect>& upload_rects = fresh_texture ? whole_rect : rects;
+
+    if (mConvertBGRA)
+    {
+        // Swizzle here on the update thread rather than leave the driver to do it on upload
+        mConvertedPixels.resize((size_t)data_width * data_height * 4);
+        for (const LLRect& rect : upload_rects)
+        {
+            swizzle_bgra_rect(mConvertedPixels.data(), data, data_width, rect);
+        }
+        data = mConvertedPixels.data();
+    }
+
+    LLPointer<LLImageRaw> raw;
+    if (fresh_texture)
+    {
+        // wrap "data" in an LLImageRaw but do NOT make a copy
+        raw = new LLImageRaw(data, media_tex->getWidth(), media_tex->getHeight(), media_tex->getComponents(), true);
 
-    // *NOTE: Recreating the GL texture each media update may seem wasteful
-    // (note the texture creation in preMediaTexUpdate), however, it apparently
-    // prevents GL calls from blocking, due to poor bookkeeping of state of
-    // updated textures by the OpenGL implementation. (Windows 10/Nvidia)
-    // -Cosmic,2023-04-04
-    // Allocate GL texture based on LLImageRaw but do NOT copy to GL
-    LLGLuint tex_name = 0;
-    media_tex->createGLTexture(0, raw, 0, TRUE, LLGLTexture::OTHER, true, &tex_name);
+        // *NOTE: Recreating the GL texture each media update may seem wasteful
+        // (note the texture creation in preMediaTexUpdate), however, it apparently
+        // prevents GL calls from blocking, due to poor bookkeeping of state of
+        // updated textures by the OpenGL implementation. (Windows 10/Nvidia)
+        // -Cosmic,2023-04-04
+        // So the update thread never writes into the live texture, only the main thread updates it in place.
+        // Allocate GL texture based on LLImageRaw but do NOT copy to GL
+        tex_name = 0;
+        media_tex->createGLTexture(0, raw, 0, TRUE, LLGLTexture::OTHER, true, &tex_name);
+    }
 
-    // copy just the subimage covered by the image raw to GL
-    media_tex->setSubImage(data, data_width, data_height, x_pos, y_pos, width, height, tex_name);
+    // copy just the subimages that changed, or the whole frame for a fresh texture, to GL
+    for (const LLRect& rect : upload_rects)
+    {
+        media_tex->setSubImage(data, data_width, data_height, rect.mLeft, rect.mBottom, rect.getWidth(), rect.getHeight(), tex_name);
+    }
 
     if (sync)
     {
@@ -3009,9 +3082,18 @@ void LLViewerMediaImpl::doMediaTexUpdate(LLViewerMediaTexture* media_tex, U8* da
         media_tex->getGLTexture()->syncTexName(tex_name);
     }
 
-    // release the data pointer before freeing raw so LLImageRaw destructor doesn't
-    // free memory at data pointer
-    raw->releaseData();
+    if (raw)
+    {
+        // release the data pointer before freeing raw so LLImageRaw destructor doesn't
+        // free memory at data pointer
+        raw->releaseData();
+    }
+
+    // The plugin can draw into this frame again
+    if (mMediaSource)
+    {
+        mMediaSource->unlockFrame();
+    }
 }
 
 //////////////////////////////////////////////////////////////////////////////////////////
@@ -3061,8 +3143,13 @@ LLViewerMediaTexture* LLViewerMediaImpl::updateMediaImage()
         raw->clear(int(mBackgroundColor.mV[VX] * 255.0f), int(mBackgroundColor.mV[VY] * 255.0f), int(mBackgroundColor.mV[VZ] * 255.0f), 0xff);
 
         // ask media source for correct GL image format constants
+        static LLCachedControl<bool> media_convert_bgra(gSavedSettings, "MediaConvertBGRA", false);
+        LLGLenum primary_format = mMediaSource->getTextureFormatPrimary();
+        mConvertBGRA = media_convert_bgra && primary_format == GL_BGRA && texture_depth == 4
+            && (LLGLenum)mMediaSource->getTextureFormatType() == GL_UNSIGNED_BYTE && !mMediaSource->getTextureFormatSwapBytes();
+        mConvertedPixels.clear();
         media_tex->setExplicitFormat(mMediaSource->getTextureFormatInternal(),
-            mMediaSource->getTextureFormatPrimary(),
+            mConvertBGRA ? GL_RGBA : primary_format,
             mMediaSource->getTextureFormatType(),
             mMediaSource->getTextureFormatSwapBytes());
 
@@ -266,8 +266,8 @@ class LLViewerMediaImpl
     void scaleTextureCoords(const LLVector2& texture_coords, S32 *x, S32 *y);
 
     void update();
-    bool preMediaTexUpdate(LLViewerMediaTexture*& media_tex, U8*& data, S32& data_width, S32& data_height, S32& x_pos, S32& y_pos, S32& width, S32& height);
-    void doMediaTexUpdate(LLViewerMediaTexture* media_tex, U8* data, S32 data_width, S32 data_height, S32 x_pos, S32 y_pos, S32 width, S32 height, bool sync);
+    bool preMediaTexUpdate(LLViewerMediaTexture*& media_tex, U8*& data, S32& data_width, S32& data_height, std::vector<LLRect>& rects);
+    void doMediaTexUpdate(LLViewerMediaTexture* media_tex, U8* data, S32 data_width, S32 data_height, const std::vector<LLRect>& rects, bool sync);
     void updateImagesMediaStreams();
     LLUUID getMediaTextureID() const;
 
@@ -465,6 +465,8 @@ class LLViewerMediaImpl
     S32 mTextureUsedHeight;
     bool mSuspendUpdates;
     bool mTextureUpdatePending = false;
+    bool mConvertBGRA = false;          // swizzle BGRA frames to RGBA before upload (MediaConvertBGRA)
+    std::vector<U8> mConvertedPixels;   // frame the swizzled pixels go into, only touched while updating
     bool mVisible;
     ECursorType mLastSetCursor;
     EMediaNavState mMediaNavState;
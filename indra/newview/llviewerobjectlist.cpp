@@ -1000,6 +1000,23 @@ void LLViewerObjectList::update(LLAgent &agent)
 
     std::vector<LLViewerObject*>::iterator idle_end = idle_list.begin()+idle_count;
 
+    {
+        // Evaluate the keyframe animations of the avatars across the worker
+        // threads, their idleUpdate() below then only applies the poses
+        static std::vector<LLMotion*> prepared_motions;
+        prepared_motions.clear();
+        for (std::vector<LLViewerObject*>::iterator iter = idle_list.begin();
+            iter != idle_end; iter++)
+        {
+            objectp = *iter;
+            if (objectp->isAvatar())
+            {
+                ((LLVOAvatar*)objectp)->prepareMotionUpdate(prepared_motions);
+            }
+        }
+        LLMotionController::preparePoses(prepared_motions);
+    }
+
     static const LLCachedControl<bool> freezeTime(gSavedSettings, "FreezeTime");
     if (freezeTime)
     {
@@ -1345,6 +1345,10 @@ void LLViewerOctreeCull::traverse(const OctreeNode* n)
 {
     LLViewerOctreeGroup* group = (LLViewerOctreeGroup*) n->getListener(0);
 
+    //frustum check of this node done along with its siblings, if any
+    S32 checked = mChildRes;
+    mChildRes = -1;
+
     if (earlyFail(group))
     {
         return;
@@ -1353,21 +1357,60 @@ void LLViewerOctreeCull::traverse(const OctreeNode* n)
     if (mRes == 2 ||
         (mRes && group->hasState(LLViewerOctreeGroup::SKIP_FRUSTUM_CHECK)))
     {   //fully in, just add everything
-        OctreeTraveler::traverse(n);
+        descend(n);
     }
     else
     {
-        mRes = frustumCheck(group);
+        mRes = checked < 0 ? frustumCheck(group) : checked;
 
         if (mRes)
         { //at least partially in, run on down
-            OctreeTraveler::traverse(n);
+            descend(n);
         }
 
         mRes = 0;
     }
 }
 
+void LLViewerOctreeCull::descend(const OctreeNode* n)
+{
+    S32 results[8];
+    U32 count = n->getChildCount();
+
+    //only partially visible nodes need their children checked
+    if (mRes != 1 || count < 2 || !frustumCheckChildren(n, results))
+    {
+        OctreeTraveler::traverse(n);
+        return;
+    }
+
+    n->accept(this);
+    for (U32 i = 0; i < count; i++)
+    {
+        mChildRes = results[i];
+        traverse(n->getChild(i));
+    }
+}
+
+//virtual
+bool LLViewerOctreeCull::frustumCheckChildren(const OctreeNode* branch, S32* results)
+{
+    return false;
+}
+
+//gathers the bounds of the children of branch for the batched frustum tests
+static U32 gather_child_bounds(const OctreeNode* branch, LLVector4a* centers, LLVector4a* radii)
+{
+    U32 count = branch->getChildCount();
+    for (U32 i = 0; i < count; i++)
+    {
+        const LLViewerOctreeGroup* group = (const LLViewerOctreeGroup*) branch->getChild(i)->getListener(0);
+        centers[i] = group->getBounds()[0];
+        radii[i] = group->getBounds()[1];
+    }
+    return count;
+}
+
 //------------------------------------------
 //agent space group culling
 S32 LLViewerOctreeCull::AABBInFrustumNoFarClipGroupBounds(const LLViewerOctreeGroup* group)
@@ -1384,6 +1427,22 @@ S32 LLViewerOctreeCull::AABBInFrustumGroupBounds(const LLViewerOctreeGroup* grou
 {
     return mCamera->AABBInFrustum(group->mBounds[0], group->mBounds[1]);
 }
+
+void LLViewerOctreeCull::AABBInFrustumNoFarClipChildBounds(const OctreeNode* branch, S32* results)
+{
+    LLVector4a centers[8];
+    LLVector4a radii[8];
+    U32 count = gather_child_bounds(branch, centers, radii);
+    mCamera->AABBInFrustumNoFarClip(centers, radii, results, count);
+}
+
+void LLViewerOctreeCull::AABBInFrustumChildBounds(const OctreeNode* branch, S32* results)
+{
+    LLVector4a centers[8];
+    LLVector4a radii[8];
+    U32 count = gather_child_bounds(branch, centers, radii);
+    mCamera->AABBInFrustum(centers, radii, results, count);
+}
 //------------------------------------------
 
 //------------------------------------------
@@ -370,18 +370,25 @@ class LLViewerOctreeCull : public OctreeTraveler
 {
 public:
     LLViewerOctreeCull(LLCamera* camera)
-        : mCamera(camera), mRes(0) { }
+        : mCamera(camera), mRes(0), mChildRes(-1) { }
 
     virtual void traverse(const OctreeNode* n);
 
 protected:
     virtual bool earlyFail(LLViewerOctreeGroup* group);
 
+    //visits n and traverses its children
+    void descend(const OctreeNode* n);
+
     //agent space group cull
     S32 AABBInFrustumNoFarClipGroupBounds(const LLViewerOctreeGroup* group);
     S32 AABBSphereIntersectGroupExtents(const LLViewerOctreeGroup* group);
     S32 AABBInFrustumGroupBounds(const LLViewerOctreeGroup* group);
 
+    //agent space group cull of all children of branch at once
+    void AABBInFrustumNoFarClipChildBounds(const OctreeNode* branch, S32* results);
+    void AABBInFrustumChildBounds(const OctreeNode* branch, S32* results);
+
     //agent space object set cull
     S32 AABBInFrustumNoFarClipObjectBounds(const LLViewerOctreeGroup* group);
     S32 AABBSphereIntersectObjectExtents(const LLViewerOctreeGroup* group);
@@ -400,6 +407,10 @@ class LLViewerOctreeCull : public OctreeTraveler
     virtual S32 frustumCheck(const LLViewerOctreeGroup* group) = 0;
     virtual S32 frustumCheckObjects(const LLViewerOctreeGroup* group) = 0;
 
+    //fills results with frustumCheck() of each child of branch, returns
+    //false if the culler has no batched version of frustumCheck()
+    virtual bool frustumCheckChildren(const OctreeNode* branch, S32* results);
+
     bool checkProjectionArea(const LLVector4a& center, const LLVector4a& size, const LLVector3& shift, F32 pixel_threshold, F32 near_radius);
     virtual bool checkObjects(const OctreeNode* branch, const LLViewerOctreeGroup* group);
     virtual void preprocess(LLViewerOctreeGroup* group);
@@ -409,6 +420,7 @@ class LLViewerOctreeCull : public OctreeTraveler
 protected:
     LLCamera *mCamera;
     S32 mRes;
+    S32 mChildRes; //frustumCheck() result for the next traverse(), -1 if not checked yet
 };
 
 //scan the octree, output the info of each node for debug use.
@@ -0,0 +1,80 @@
+/**
+ * @file llviewerpartkernels.cpp
+ * @brief Particle integration kernels, kept apart from the particle
+ *        simulation so they can be tested on their own
+ *
+ * $LicenseInfo:firstyear=2024&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2024, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#include "llviewerprecompiledheaders.h"
+
+#include "llviewerpartkernels.h"
+
+#include "llvector4a.h"
+
+void LLViewerPartKernels::stepBallistic(LLVector3& pos, LLVector3& vel, const LLVector3& acc, F32 dt)
+{
+    pos += dt*vel;
+    pos += 0.5f*dt*dt*acc;
+    vel += acc*dt;
+}
+
+void LLViewerPartKernels::integrateBallistic(F32* columns, U32 stride)
+{
+    F32* dts = columns + KIN_DT * stride;
+    F32* ages = columns + KIN_AGE * stride;
+    LLVector4a half;
+    half.splat(0.5f);
+    for (U32 i = 0; i < stride; i += 4)
+    {
+        LLVector4a dt, half_dt2, age;
+        dt.load4a(dts + i);
+        half_dt2.setMul(half, dt);
+        half_dt2.mul(dt);
+
+        age.load4a(ages + i);
+        age.add(dt);
+        age.store4a(ages + i);
+
+        for (U32 axis = 0; axis < 3; ++axis)
+        {
+            F32* pos = columns + (KIN_POS_X + axis) * stride + i;
+            F32* vel = columns + (KIN_VEL_X + axis) * stride + i;
+            const F32* acc = columns + (KIN_ACC_X + axis) * stride + i;
+
+            LLVector4a p, v, a, t;
+            p.load4a(pos);
+            v.load4a(vel);
+            a.load4a(acc);
+
+            t.setMul(dt, v);
+            p.add(t);
+            t.setMul(half_dt2, a);
+            p.add(t);
+            t.setMul(a, dt);
+            v.add(t);
+
+            p.store4a(pos);
+            v.store4a(vel);
+        }
+    }
+}
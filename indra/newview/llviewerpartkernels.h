@@ -0,0 +1,55 @@
+/**
+ * @file llviewerpartkernels.h
+ * @brief Particle integration kernels, kept apart from the particle
+ *        simulation so they can be tested on their own
+ *
+ * $LicenseInfo:firstyear=2024&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2024, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#ifndef LL_LLVIEWERPARTKERNELS_H
+#define LL_LLVIEWERPARTKERNELS_H
+
+#include "v3math.h"
+
+namespace LLViewerPartKernels
+{
+    // Columns of the ballistic particle table, each stride floats long
+    enum
+    {
+        KIN_POS_X, KIN_POS_Y, KIN_POS_Z,
+        KIN_VEL_X, KIN_VEL_Y, KIN_VEL_Z,
+        KIN_ACC_X, KIN_ACC_Y, KIN_ACC_Z,
+        KIN_DT,
+        KIN_AGE,
+        KIN_COLUMNS
+    };
+
+    // p += dt v + dt^2 a / 2, v += dt a for one particle
+    void stepBallistic(LLVector3& pos, LLVector3& vel, const LLVector3& acc, F32 dt);
+
+    // The same for every particle of the table, four at a time and in the
+    // same order of operations, also adding each time step to its age.
+    // columns is 16 byte aligned and stride a multiple of 4.
+    void integrateBallistic(F32* columns, U32 stride);
+}
+
+#endif // LL_LLVIEWERPARTKERNELS_H
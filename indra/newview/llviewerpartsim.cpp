@@ -42,6 +42,8 @@
 #include "llspatialpartition.h"
 #include "llvoavatarself.h"
 #include "llvovolume.h"
+#include "llparallelfor.h"
+#include "llviewerpartkernels.h"
 
 const F32 PART_SIM_BOX_SIDE = 16.f;
 
@@ -65,13 +67,77 @@ const F32 LLViewerPartSim::PART_ADAPT_RATE_MULT_RECIP = 1.0f/PART_ADAPT_RATE_MUL
 
 U32 LLViewerPart::sNextPartID = 1;
 
-F32 calc_desired_size(LLViewerCamera* camera, LLVector3 pos, LLVector2 scale)
+using namespace LLViewerPartKernels;
+
+namespace
+{
+    // particles are carved out of blocks of this many
+    const U32 PART_POOL_BLOCK_SIZE = 256;
+    const size_t PART_SLOT_SIZE = (sizeof(LLViewerPart) + 15) & ~(size_t)15;
+
+    // Freed particles, linked through their first bytes.  Blocks are never
+    // returned; they top out at what the particle limit allows.
+    void* sFreeParts = NULL;
+
+    // Particles that ride on nothing but their own velocity and acceleration
+    // go through the SSE integrator, everything else is stepped one by one.
+    const U32 PART_STEERED_MASK = LLPartData::LL_PART_FOLLOW_SRC_MASK
+                                  | LLPartData::LL_PART_WIND_MASK
+                                  | LLPartData::LL_PART_TARGET_POS_MASK
+                                  | LLPartData::LL_PART_TARGET_LINEAR_MASK
+                                  | LLPartData::LL_PART_BOUNCE_MASK;
+
+    // Groups are updated on the General pool once there are this many
+    // particles to go around
+    const S32 MIN_PARALLEL_PARTICLES = 2048;
+}
+
+F32 calc_desired_size(const LLVector3& camera_origin, const LLVector3& pos, const LLVector2& scale)
 {
-    F32 desired_size = (pos - camera->getOrigin()).magVec();
+    F32 desired_size = (pos - camera_origin).magVec();
     desired_size /= 4;
     return llclamp(desired_size, scale.magVec()*0.5f, PART_SIM_BOX_SIDE*2);
 }
 
+F32 calc_desired_size(LLViewerCamera* camera, LLVector3 pos, LLVector2 scale)
+{
+    return calc_desired_size(camera->getOrigin(), pos, scale);
+}
+
+//static
+void* LLViewerPart::operator new(size_t size)
+{
+    llassert(size == sizeof(LLViewerPart));
+    if (!sFreeParts)
+    {
+        char* block = (char*)ll_aligned_malloc_16(PART_SLOT_SIZE * PART_POOL_BLOCK_SIZE);
+        if (!block)
+        {
+            LLError::LLUserWarningMsg::showOutOfMemory();
+            LL_ERRS() << "Out of memory allocating particles" << LL_ENDL;
+        }
+        for (U32 i = 0; i < PART_POOL_BLOCK_SIZE; ++i)
+        {
+            void* slot = block + PART_SLOT_SIZE * i;
+            *(void**)slot = sFreeParts;
+            sFreeParts = slot;
+        }
+    }
+    void* part = sFreeParts;
+    sFreeParts = *(void**)part;
+    return part;
+}
+
+//static
+void LLViewerPart::operator delete(void* ptr)
+{
+    if (ptr)
+    {
+        *(void**)ptr = sFreeParts;
+        sFreeParts = ptr;
+    }
+}
+
 LLViewerPart::LLViewerPart() :
     mPartID(0),
     mLastUpdateTime(0.f),
@@ -273,152 +339,261 @@ BOOL LLViewerPartGroup::addPart(LLViewerPart* part, F32 desired_size)
 }
 
 
-void LLViewerPartGroup::updateParticles(const F32 lastdt)
+void LLViewerPartGroup::stepPart(LLViewerPart* part, const F32 dt)
 {
-    F32 dt;
+    LLViewerRegion *regionp = getRegion();
 
-    LLVector3 gravity(0.f, 0.f, GRAVITY);
+    const F32 cur_time = part->mLastUpdateTime + dt;
+    const F32 frac = cur_time / part->mMaxAge;
 
-    LLViewerPartSim::checkParticleCount(mParticles.size());
+    // "Drift" the object based on the source object
+    if (part->mFlags & LLPartData::LL_PART_FOLLOW_SRC_MASK)
+    {
+        part->mPosAgent = part->mPartSourcep->mPosAgent;
+        part->mPosAgent += part->mPosOffset;
+    }
 
-    LLViewerCamera* camera = LLViewerCamera::getInstance();
-    LLViewerRegion *regionp = getRegion();
-    S32 end = (S32) mParticles.size();
-    for (S32 i = 0 ; i < (S32)mParticles.size();)
+    // Do a custom callback if we have one...
+    if (part->mVPCallback)
+    {
+        (*part->mVPCallback)(*part, dt);
+    }
+
+    if (part->mFlags & LLPartData::LL_PART_WIND_MASK)
     {
-        LLVector3 a(0.f, 0.f, 0.f);
-        LLViewerPart* part = mParticles[i] ;
+        part->mVelocity *= 1.f - 0.1f*dt;
+        part->mVelocity += 0.1f*dt*regionp->mWind.getVelocity(regionp->getPosRegionFromAgent(part->mPosAgent));
+    }
 
-        dt = lastdt + mSkippedTime - part->mSkipOffset;
-        part->mSkipOffset = 0.f;
+    // Now do interpolation towards a target
+    if (part->mFlags & LLPartData::LL_PART_TARGET_POS_MASK)
+    {
+        F32 remaining = part->mMaxAge - part->mLastUpdateTime;
+        F32 step = dt / remaining;
 
-        // Update current time
-        const F32 cur_time = part->mLastUpdateTime + dt;
-        const F32 frac = cur_time / part->mMaxAge;
+        step = llclamp(step, 0.f, 0.1f);
+        step *= 5.f;
+        // we want a velocity that will result in reaching the target in the
+        // Interpolate towards the target.
+        LLVector3 delta_pos = part->mPartSourcep->mTargetPosAgent - part->mPosAgent;
 
-        // "Drift" the object based on the source object
-        if (part->mFlags & LLPartData::LL_PART_FOLLOW_SRC_MASK)
-        {
-            part->mPosAgent = part->mPartSourcep->mPosAgent;
-            part->mPosAgent += part->mPosOffset;
-        }
+        delta_pos /= remaining;
+
+        part->mVelocity *= (1.f - step);
+        part->mVelocity += step*delta_pos;
+    }
 
-        // Do a custom callback if we have one...
-        if (part->mVPCallback)
-        {
-            (*part->mVPCallback)(*part, dt);
-        }
 
-        if (part->mFlags & LLPartData::LL_PART_WIND_MASK)
+    if (part->mFlags & LLPartData::LL_PART_TARGET_LINEAR_MASK)
+    {
+        LLVector3 delta_pos = part->mPartSourcep->mTargetPosAgent - part->mPartSourcep->mPosAgent;
+        part->mPosAgent = part->mPartSourcep->mPosAgent;
+        part->mPosAgent += frac*delta_pos;
+        part->mVelocity = delta_pos;
+    }
+    else
+    {
+        // Do velocity interpolation
+        stepBallistic(part->mPosAgent, part->mVelocity, part->mAccel, dt);
+    }
+
+    // Do a bounce test
+    if (part->mFlags & LLPartData::LL_PART_BOUNCE_MASK)
+    {
+        // Need to do point vs. plane check...
+        // For now, just check relative to object height...
+        F32 dz = part->mPosAgent.mV[VZ] - part->mPartSourcep->mPosAgent.mV[VZ];
+        if (dz < 0)
         {
-            part->mVelocity *= 1.f - 0.1f*dt;
-            part->mVelocity += 0.1f*dt*regionp->mWind.getVelocity(regionp->getPosRegionFromAgent(part->mPosAgent));
+            part->mPosAgent.mV[VZ] += -2.f*dz;
+            part->mVelocity.mV[VZ] *= -0.75f;
         }
+    }
 
-        // Now do interpolation towards a target
-        if (part->mFlags & LLPartData::LL_PART_TARGET_POS_MASK)
-        {
-            F32 remaining = part->mMaxAge - part->mLastUpdateTime;
-            F32 step = dt / remaining;
 
-            step = llclamp(step, 0.f, 0.1f);
-            step *= 5.f;
-            // we want a velocity that will result in reaching the target in the
-            // Interpolate towards the target.
-            LLVector3 delta_pos = part->mPartSourcep->mTargetPosAgent - part->mPosAgent;
+    // Reset the offset from the source position
+    if (part->mFlags & LLPartData::LL_PART_FOLLOW_SRC_MASK)
+    {
+        part->mPosOffset = part->mPosAgent;
+        part->mPosOffset -= part->mPartSourcep->mPosAgent;
+    }
+}
 
-            delta_pos /= remaining;
+void LLViewerPartGroup::fadePart(LLViewerPart& part, const F32 cur_time)
+{
+    const F32 frac = cur_time / part.mMaxAge;
 
-            part->mVelocity *= (1.f - step);
-            part->mVelocity += step*delta_pos;
-        }
+    // Do color interpolation, start*(1-frac) + end*frac on all four channels
+    if (part.mFlags & LLPartData::LL_PART_INTERP_COLOR_MASK)
+    {
+        LLVector4a color, end_color;
+        color.loadua(part.mStartColor.mV);
+        color.mul(1.f - frac);
+        end_color.loadua(part.mEndColor.mV);
+        end_color.mul(frac);
+        color.add(end_color);
+        _mm_storeu_ps(part.mColor.mV, color);
+    }
+
+    // Do scale interpolation
+    if (part.mFlags & LLPartData::LL_PART_INTERP_SCALE_MASK)
+    {
+        part.mScale.setVec(part.mStartScale);
+        part.mScale *= 1.f - frac;
+        part.mScale += frac*part.mEndScale;
+    }
 
+    // Do glow interpolation
+    part.mGlow.mV[3] = (U8) ll_round(ll_lerp(part.mStartGlow, part.mEndGlow, frac)*255.f);
 
-        if (part->mFlags & LLPartData::LL_PART_TARGET_LINEAR_MASK)
+    // Set the last update time to now.
+    part.mLastUpdateTime = cur_time;
+}
+
+LLViewerPartGroup::EPartFate LLViewerPartGroup::getFate(const LLViewerPart& part, const LLVector3& camera_origin)
+{
+    // Kill dead particles (either flagged dead, or too old)
+    if ((part.mLastUpdateTime > part.mMaxAge) || (LLViewerPart::LL_PART_DEAD_MASK == part.mFlags))
+    {
+        return PART_DEAD;
+    }
+
+    F32 desired_size = calc_desired_size(camera_origin, part.mPosAgent, part.mScale);
+    return posInGroup(part.mPosAgent, desired_size) ? PART_KEEP : PART_MOVE;
+}
+
+void LLViewerPartGroup::updateParticles(const F32 lastdt, const LLVector3& camera_origin)
+{
+    LL_PROFILE_ZONE_SCOPED_CATEGORY_PIPELINE;
+
+    const S32 count = (S32)mParticles.size();
+    mFates.assign(count, PART_KEEP);
+    mDeferredParts.clear();
+    mKinematicParts.clear();
+
+    for (S32 i = 0; i < count; ++i)
+    {
+        LLViewerPart* part = mParticles[i];
+
+        F32 dt = lastdt + mSkippedTime - part->mSkipOffset;
+        part->mSkipOffset = 0.f;
+
+        if (part->mVPCallback)
         {
-            LLVector3 delta_pos = part->mPartSourcep->mTargetPosAgent - part->mPartSourcep->mPosAgent;
-            part->mPosAgent = part->mPartSourcep->mPosAgent;
-            part->mPosAgent += frac*delta_pos;
-            part->mVelocity = delta_pos;
+            // callbacks may look anywhere, they run in finishUpdate()
+            mDeferredParts.push_back(std::make_pair(i, dt));
+            continue;
+        }
+
+        if (part->mFlags & PART_STEERED_MASK)
+        {
+            stepPart(part, dt);
+            fadePart(*part, part->mLastUpdateTime + dt);
         }
         else
         {
-            // Do velocity interpolation
-            part->mPosAgent += dt*part->mVelocity;
-            part->mPosAgent += 0.5f*dt*dt*part->mAccel;
-            part->mVelocity += part->mAccel*dt;
+            // aged, moved and faded along with the other ballistic ones
+            mKinematicParts.push_back(std::make_pair(i, dt));
         }
+    }
 
-        // Do a bounce test
-        if (part->mFlags & LLPartData::LL_PART_BOUNCE_MASK)
+    if (!mKinematicParts.empty())
+    {
+        // gather the ballistic particles into columns padded to whole
+        // vectors, integrate them and scatter the results back
+        const U32 kin_count = (U32)mKinematicParts.size();
+        const U32 stride = (kin_count + 3) & ~3;
+        mKinematics.resize(stride * KIN_COLUMNS);
+        F32* columns = mKinematics.mArray;
+        memset(columns, 0, sizeof(F32) * stride * KIN_COLUMNS);
+
+        for (U32 k = 0; k < kin_count; ++k)
         {
-            // Need to do point vs. plane check...
-            // For now, just check relative to object height...
-            F32 dz = part->mPosAgent.mV[VZ] - part->mPartSourcep->mPosAgent.mV[VZ];
-            if (dz < 0)
+            const LLViewerPart* part = mParticles[mKinematicParts[k].first];
+            for (U32 axis = 0; axis < 3; ++axis)
             {
-                part->mPosAgent.mV[VZ] += -2.f*dz;
-                part->mVelocity.mV[VZ] *= -0.75f;
+                columns[(KIN_POS_X + axis) * stride + k] = part->mPosAgent.mV[axis];
+                columns[(KIN_VEL_X + axis) * stride + k] = part->mVelocity.mV[axis];
+                columns[(KIN_ACC_X + axis) * stride + k] = part->mAccel.mV[axis];
             }
+            columns[KIN_DT * stride + k] = mKinematicParts[k].second;
+            columns[KIN_AGE * stride + k] = part->mLastUpdateTime;
         }
 
+        integrateBallistic(columns, stride);
 
-        // Reset the offset from the source position
-        if (part->mFlags & LLPartData::LL_PART_FOLLOW_SRC_MASK)
-        {
-            part->mPosOffset = part->mPosAgent;
-            part->mPosOffset -= part->mPartSourcep->mPosAgent;
-        }
-
-        // Do color interpolation
-        if (part->mFlags & LLPartData::LL_PART_INTERP_COLOR_MASK)
+        for (U32 k = 0; k < kin_count; ++k)
         {
-            part->mColor.setVec(part->mStartColor);
-            // note: LLColor4's v%k means multiply-alpha-only,
-            //       LLColor4's v*k means multiply-rgb-only
-            part->mColor *= 1.f - frac; // rgb*k
-            part->mColor %= 1.f - frac; // alpha*k
-            part->mColor += frac%(frac*part->mEndColor); // rgb,alpha
+            LLViewerPart* part = mParticles[mKinematicParts[k].first];
+            for (U32 axis = 0; axis < 3; ++axis)
+            {
+                part->mPosAgent.mV[axis] = columns[(KIN_POS_X + axis) * stride + k];
+                part->mVelocity.mV[axis] = columns[(KIN_VEL_X + axis) * stride + k];
+            }
+            fadePart(*part, columns[KIN_AGE * stride + k]);
         }
+    }
 
-        // Do scale interpolation
-        if (part->mFlags & LLPartData::LL_PART_INTERP_SCALE_MASK)
+    for (S32 i = 0; i < count; ++i)
+    {
+        if (!mParticles[i]->mVPCallback)
         {
-            part->mScale.setVec(part->mStartScale);
-            part->mScale *= 1.f - frac;
-            part->mScale += frac*part->mEndScale;
+            mFates[i] = getFate(*mParticles[i], camera_origin);
         }
+    }
+}
 
-        // Do glow interpolation
-        part->mGlow.mV[3] = (U8) ll_round(ll_lerp(part->mStartGlow, part->mEndGlow, frac)*255.f);
-
-        // Set the last update time to now.
-        part->mLastUpdateTime = cur_time;
-
+void LLViewerPartGroup::finishUpdate(const LLVector3& camera_origin)
+{
+    LLViewerPartSim::checkParticleCount(mParticles.size());
 
-        // Kill dead particles (either flagged dead, or too old)
-        if ((part->mLastUpdateTime > part->mMaxAge) || (LLViewerPart::LL_PART_DEAD_MASK == part->mFlags))
+    for (const std::pair<S32, F32>& deferred : mDeferredParts)
+    {
+        LLViewerPart* part = mParticles[deferred.first];
+        const F32 cur_time = part->mLastUpdateTime + deferred.second;
+        stepPart(part, deferred.second);
+        fadePart(*part, cur_time);
+        mFates[deferred.first] = getFate(*part, camera_origin);
+    }
+    mDeferredParts.clear();
+
+    // Compact in place.  Particles handed to this group by groups that
+    // finished earlier sit past the ones that were updated and are kept.
+    const S32 updated = (S32)mFates.size();
+    const S32 count = (S32)mParticles.size();
+    S32 kept = 0;
+    S32 removed = 0;
+    std::vector<LLViewerPart*> moved;
+    for (S32 i = 0; i < count; ++i)
+    {
+        LLViewerPart* part = mParticles[i];
+        const EPartFate fate = i < updated ? (EPartFate)mFates[i] : PART_KEEP;
+        if (fate == PART_KEEP)
         {
-            vector_replace_with_last(mParticles, mParticles.begin() + i);
-            delete part ;
+            mParticles[kept++] = part;
         }
         else
         {
-            F32 desired_size = calc_desired_size(camera, part->mPosAgent, part->mScale);
-            if (!posInGroup(part->mPosAgent, desired_size))
+            if (fate == PART_DEAD)
             {
-                // Transfer particles between groups
-                LLViewerPartSim::getInstance()->put(part) ;
-                vector_replace_with_last(mParticles, mParticles.begin() + i);
+                delete part;
             }
             else
             {
-                i++ ;
+                moved.push_back(part);
             }
+            ++removed;
         }
     }
+    mParticles.resize(kept);
+    mFates.clear();
+
+    // Transfer particles between groups
+    for (LLViewerPart* part : moved)
+    {
+        LLViewerPartSim::getInstance()->put(part);
+    }
 
-    S32 removed = end - (S32)mParticles.size();
     if (removed > 0)
     {
         // we removed one or more particles, so flag this group for update
@@ -741,6 +916,12 @@ void LLViewerPartSim::updateSimulation()
         num_updates++;
     }
 
+    // Pick the groups due for an update.  Each one is stepped on its own,
+    // so with enough particles they are spread over the General pool, then
+    // finished here where particles may change groups and callbacks run.
+    std::vector<LLViewerPartGroup*> updated_groups;
+    std::vector<F32> updated_dts;
+    S32 updated_parts = 0;
     count = (S32) mViewerPartGroups.size();
     for (i = 0; i < count; i++)
     {
@@ -762,15 +943,9 @@ void LLViewerPartSim::updateSimulation()
             {
                 gPipeline.markRebuild(vobj->mDrawable, LLDrawable::REBUILD_ALL);
             }
-            mViewerPartGroups[i]->updateParticles(dt * visirate);
-            mViewerPartGroups[i]->mSkippedTime=0.0f;
-            if (!mViewerPartGroups[i]->getCount())
-            {
-                delete mViewerPartGroups[i];
-                vector_replace_with_last(mViewerPartGroups, mViewerPartGroups.begin() + i);
-                i--;
-                count--;
-            }
+            updated_groups.push_back(mViewerPartGroups[i]);
+            updated_dts.push_back(dt * visirate);
+            updated_parts += mViewerPartGroups[i]->getCount();
         }
         else
         {
@@ -778,6 +953,44 @@ void LLViewerPartSim::updateSimulation()
         }
 
     }
+
+    const LLVector3 camera_origin = LLViewerCamera::getInstance()->getOrigin();
+    auto update_groups = [&](size_t begin, size_t end)
+    {
+        for (size_t g = begin; g < end; ++g)
+        {
+            updated_groups[g]->updateParticles(updated_dts[g], camera_origin);
+        }
+    };
+
+    if (updated_groups.size() > 1 && updated_parts >= MIN_PARALLEL_PARTICLES)
+    {
+        LL::parallel_for(updated_groups.size(), 1, update_groups);
+    }
+    else
+    {
+        update_groups(0, updated_groups.size());
+    }
+
+    // particles handed over while finishing start out fresh in their new group
+    for (LLViewerPartGroup* group : updated_groups)
+    {
+        group->mSkippedTime = 0.0f;
+    }
+
+    for (LLViewerPartGroup* group : updated_groups)
+    {
+        group->finishUpdate(camera_origin);
+
+        // an empty group lost its object, drop it before anything is put in it
+        if (!group->getCount())
+        {
+            group_list_t::iterator iter = std::find(mViewerPartGroups.begin(), mViewerPartGroups.end(), group);
+            delete group;
+            vector_replace_with_last(mViewerPartGroups, iter);
+        }
+    }
+
     if (LLDrawable::getCurrentFrame()%16==0)
     {
         if (sParticleCount > sMaxParticleCount * 0.875f
@@ -27,6 +27,7 @@
 #ifndef LL_LLVIEWERPARTSIM_H
 #define LL_LLVIEWERPARTSIM_H
 
+#include "llalignedarray.h"
 #include "llframetimer.h"
 #include "llpointer.h"
 #include "llpartdata.h"
@@ -56,6 +57,11 @@ class LLViewerPart final : public LLPartData
 
     void init(LLPointer<LLViewerPartSource> sourcep, LLViewerTexture *imagep, LLVPCallback cb);
 
+    // Particles come and go by the thousand, so they are carved out of
+    // pooled blocks and freed ones are kept on a list for the next.  Main
+    // thread only.
+    static void* operator new(size_t size);
+    static void operator delete(void* ptr);
 
     U32                 mPartID;                    // Particle ID used primarily for moving between groups
     F32                 mLastUpdateTime;            // Last time the particle was updated
@@ -97,7 +103,13 @@ class LLViewerPartGroup
 
     BOOL addPart(LLViewerPart* part, const F32 desired_size = -1.f);
 
-    void updateParticles(const F32 lastdt);
+    // Steps every particle but the ones driven by a callback.  Touches
+    // nothing outside the group, so groups may be updated in parallel.
+    void updateParticles(const F32 lastdt, const LLVector3& camera_origin);
+
+    // Steps the particles updateParticles() left, drops dead particles and
+    // hands the ones that left the group to other groups.  Main thread only.
+    void finishUpdate(const LLVector3& camera_origin);
 
     BOOL posInGroup(const LLVector3 &pos, const F32 desired_size = -1.f);
 
@@ -124,6 +136,17 @@ class LLViewerPartGroup
     bool mHud;
 
 protected:
+    enum EPartFate
+    {
+        PART_KEEP,
+        PART_DEAD,
+        PART_MOVE
+    };
+
+    void stepPart(LLViewerPart* part, const F32 dt);
+    void fadePart(LLViewerPart& part, const F32 cur_time);
+    EPartFate getFate(const LLViewerPart& part, const LLVector3& camera_origin);
+
     LLVector3 mCenterAgent;
     F32 mBoxRadius;
     F32 mBoxSide;
@@ -131,6 +154,16 @@ class LLViewerPartGroup
     LLVector3 mMaxObjPos;
 
     LLViewerRegion *mRegionp;
+
+    // per update, between updateParticles() and finishUpdate()
+    std::vector<U8> mFates;                             // EPartFate of each particle updated
+    std::vector<std::pair<S32, F32> > mDeferredParts;   // index and time step of callback driven particles
+
+    // positions, velocities, accelerations, time steps and ages of the
+    // ballistic particles, one column each, for the SSE integrator (see
+    // LLViewerPartKernels)
+    LLAlignedArray<F32, 64> mKinematics;
+    std::vector<std::pair<S32, F32> > mKinematicParts;
 };
 
 class LLViewerPartSim final : public LLSingleton<LLViewerPartSim>
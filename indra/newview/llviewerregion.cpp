@@ -648,6 +648,7 @@ LLViewerRegion::LLViewerRegion(const U64 &handle,
     mLegacyHttpUrl(""),
     mViewerAssetUrl(""),
     mCacheLoaded(FALSE),
+    mCacheLoadPending(FALSE),
     mCacheDirty(FALSE),
     mReleaseNotesRequested(FALSE),
     mCapabilitiesState(CAPABILITIES_STATE_INIT),
@@ -809,24 +810,58 @@ void LLViewerRegion::loadObjectCache()
 {
     if (mCacheLoaded)
     {
+        // a repeated handshake, answer it unless the cache is still loading
+        if (!mCacheLoadPending)
+        {
+            sendRegionHandshakeReply();
+        }
         return;
     }
 
     // Presume success.  If it fails, we don't want to try again.
     mCacheLoaded = TRUE;
 
-    if(LLVOCache::instanceExists())
+    if(!LLVOCache::instanceExists())
     {
-        LLVOCache & vocache = LLVOCache::instance();
-        // Without this a "corrupted" vocache persists until a cache clear or other rewrite. Mark as dirty hereif read fails to force a rewrite.
-        mCacheDirty = !vocache.readFromCache(mHandle, mImpl->mCacheID, mImpl->mCacheMap);
-        vocache.readGenericExtrasFromCache(mHandle, mImpl->mCacheID, mImpl->mGLTFOverridesLLSD, mImpl->mCacheMap);
+        sendRegionHandshakeReply();
+        return;
+    }
 
-        if (mImpl->mCacheMap.empty())
+    mCacheLoadPending = TRUE;
+    U64 handle = mHandle;
+    LLUUID cache_id = mImpl->mCacheID;
+    LLVOCache::instance().readFromCache(mHandle, mImpl->mCacheID,
+        [handle, cache_id](LLVOCacheEntry::vocache_entry_map_t& cache_entry_map, bool success)
         {
-            mCacheDirty = TRUE;
-        }
-    }
+            // the region may be gone, or replaced by a new connection
+            LLViewerRegion* regionp = LLWorld::instanceExists() ? LLWorld::instance().getRegionFromHandle(handle) : NULL;
+            if (!regionp || !regionp->mCacheLoadPending || regionp->mImpl->mCacheID != cache_id)
+            {
+                return;
+            }
+            regionp->mCacheLoadPending = FALSE;
+
+            LLVOCacheEntry::vocache_entry_map_t& cache_map = regionp->mImpl->mCacheMap;
+            if (cache_map.empty())
+            {
+                cache_map.swap(cache_entry_map);
+            }
+            else
+            {
+                cache_map.insert(cache_entry_map.begin(), cache_entry_map.end());
+            }
+
+            // Without this a "corrupted" vocache persists until a cache clear or other rewrite. Mark as dirty hereif read fails to force a rewrite.
+            regionp->mCacheDirty = !success;
+            LLVOCache::instance().readGenericExtrasFromCache(handle, cache_id, regionp->mImpl->mGLTFOverridesLLSD, cache_map);
+
+            if (cache_map.empty())
+            {
+                regionp->mCacheDirty = TRUE;
+            }
+
+            regionp->sendRegionHandshakeReply();
+        });
 }
 
 
@@ -3334,13 +3369,16 @@ void LLViewerRegion::unpackRegionHandshake()
 
 
     // Now that we have the name, we can load the cache file
-    // off disk.
+    // off disk.  This sends the handshake reply once it is loaded.
     loadObjectCache();
+}
 
+void LLViewerRegion::sendRegionHandshakeReply()
+{
     // After loading cache, signal that simulator can start
     // sending data.
     // TODO: Send all upstream viewer->sim handshake info here.
-    LLHost host = msg->getSender();
+    LLMessageSystem* msg = gMessageSystem;
     msg->newMessageFast(_PREHASH_RegionHandshakeReply);
     msg->nextBlockFast(_PREHASH_AgentData);
     msg->addUUIDFast(_PREHASH_AgentID, gAgent.getID());
@@ -3359,7 +3397,7 @@ void LLViewerRegion::unpackRegionHandshake()
         flags |= 0x00000002; //set the bit 1 to be 1 to tell sim the cache file is empty, no need to send cache probes.
     }
     msg->addU32Fast(_PREHASH_Flags, flags );
-    msg->sendReliable(host);
+    msg->sendReliable(getHost());
 
     mRegionTimer.reset(); //reset region timer.
 }
@@ -111,7 +111,9 @@ class LLViewerRegion final : public LLCapabilityProvider // implements this inte
                    const F32 region_width_meters);
     ~LLViewerRegion();
 
-    // Call this after you have the region name and handle.
+    // Call this after you have the region name and handle.  The cache is
+    // read in the background, the region handshake is answered once it is
+    // loaded.
     void loadObjectCache();
     void saveObjectCache();
 
@@ -392,6 +394,7 @@ class LLViewerRegion final : public LLCapabilityProvider // implements this inte
     void clearVOCacheFromMemory();
 
     void unpackRegionHandshake();
+    void sendRegionHandshakeReply();
 
     void calculateCenterGlobal();
     void calculateCameraDistance();
@@ -624,6 +627,7 @@ class LLViewerRegion final : public LLCapabilityProvider // implements this inte
     // Regions can have order 10,000 objects, so assume
     // a structure of size 2^14 = 16,000
     BOOL                                    mCacheLoaded;
+    BOOL                                    mCacheLoadPending;  // read in progress, the handshake reply waits for it
     BOOL                                    mCacheDirty;
     BOOL    mAlive;                 // can become false if circuit disconnects
     BOOL    mSimulatorFeaturesReceived;
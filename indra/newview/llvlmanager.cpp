@@ -99,11 +99,11 @@ void LLVLManager::unpackData(const S32 num_packets)
         decode_patch_group_header(bit_pack, &goph);
         if (LAND_LAYER_CODE == datap->mType)
         {
-            datap->mRegionp->getLand().decompressDCTPatch(bit_pack, &goph, FALSE);
+            datap->mRegionp->getLand().decompressDCTPatches(datap->mData, datap->mSize, FALSE);
         }
         else if (AURORA_LAND_LAYER_CODE == datap->mType)
         {
-            datap->mRegionp->getLand().decompressDCTPatch(bit_pack, &goph, TRUE);
+            datap->mRegionp->getLand().decompressDCTPatches(datap->mData, datap->mSize, TRUE);
         }
         else if (WIND_LAYER_CODE == datap->mType || AURORA_WIND_LAYER_CODE == datap->mType)
 
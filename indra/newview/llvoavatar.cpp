@@ -2819,7 +2819,7 @@ void LLVOAvatar::idleUpdateVoiceVisualizer(bool voice_enabled, const LLVector3 &
                     if( mAahMorph ) mAahMorph->setWeight(mAahMorph->getMinWeight());
 
                     mLipSyncActive = false;
-                    LLCharacter::updateVisualParams();
+                    LLAvatarAppearance::updateVisualParams();
                     dirtyMesh();
                 }
             }
@@ -3045,12 +3045,14 @@ void LLVOAvatar::idleUpdateAppearanceAnimation()
             }
 
             // apply all params
+            openMorphBatch();
             for (param = getFirstVisualParam();
                  param;
                  param = getNextVisualParam())
             {
                 param->apply(avatar_sex);
             }
+            closeMorphBatch();
 
             mLastAppearanceBlendTime = appearance_anim_time;
         }
@@ -3107,7 +3109,7 @@ void LLVOAvatar::idleUpdateLipSync(bool voice_enabled)
         }
 
         mLipSyncActive = true;
-        LLCharacter::updateVisualParams();
+        LLAvatarAppearance::updateVisualParams();
         dirtyMesh();
     }
 }
@@ -4787,6 +4789,29 @@ bool LLVOAvatar::computeNeedsUpdate()
     return needs_update;
 }
 
+// prepareMotionUpdate()
+//
+// Collects the motions whose pose can be evaluated on the worker threads
+// before updateCharacter() runs this frame, for the avatars likely to get
+// a full motion update there.  The others would only waste the work, the
+// motions fall back to evaluating their pose in their own update.
+//------------------------------------------------------------------------
+void LLVOAvatar::prepareMotionUpdate(std::vector<LLMotion*>& motions)
+{
+    if (!mIsBuilt || isDead() || !isVisible())
+    {
+        return;
+    }
+
+    // same test as computeNeedsUpdate(), with last frame's update period
+    if (!isSelf() && (LLDrawable::getCurrentFrame() + mID.mData[0]) % mUpdatePeriod != 0)
+    {
+        return;
+    }
+
+    mMotionController.prepareMotions(motions);
+}
+
 // updateCharacter()
 //
 // This is called for all avatars, so there are 4 possible situations:
@@ -7321,7 +7346,7 @@ void LLVOAvatar::updateVisualParams()
         }
     }
 
-    LLCharacter::updateVisualParams();
+    LLAvatarAppearance::updateVisualParams();
 
     if (mLastSkeletonSerialNum != mSkeletonSerialNum)
     {
@@ -283,6 +283,7 @@ class LLVOAvatar :
     virtual void    updateDebugText();
     virtual bool    computeNeedsUpdate();
     virtual bool    updateCharacter(LLAgent &agent);
+    void            prepareMotionUpdate(std::vector<LLMotion*>& motions);
     void            updateFootstepSounds();
     void            computeUpdatePeriod();
     void            updateOrientation(LLAgent &agent, F32 speed, F32 delta_time);
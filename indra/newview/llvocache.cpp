@@ -34,6 +34,9 @@
 #include "llagentcamera.h"
 #include "llsdserialize.h"
 #include "llworld.h" // For LLWorld::getInstance()
+#include "llmappedfile.h"
+#include "llmutex.h"
+#include "workqueue.h"
 //static variables
 U32 LLVOCacheEntry::sMinFrameRange = 0;
 F32 LLVOCacheEntry::sNearRadius = 1.0f;
@@ -192,7 +195,7 @@ LLVOCacheEntry::LLVOCacheEntry()
     mDP.assignBuffer(mBuffer, 0);
 }
 
-LLVOCacheEntry::LLVOCacheEntry(LLAPRFile* apr_file)
+LLVOCacheEntry::LLVOCacheEntry(const U8* data_buffer, S32 buffer_size)
 :   LLViewerOctreeEntryData(LLViewerOctreeEntry::LLVOCACHEENTRY),
     mBuffer(NULL),
     mUpdateFlags(-1),
@@ -203,12 +206,10 @@ LLVOCacheEntry::LLVOCacheEntry(LLAPRFile* apr_file)
     mBSphereRadius(-1.0f)
 {
     S32 size = -1;
-    BOOL success;
-    static U8 data_buffer[ENTRY_HEADER_SIZE];
+    BOOL success = buffer_size >= ENTRY_HEADER_SIZE;
 
     mDP.assignBuffer(mBuffer, 0);
 
-    success = check_read(apr_file, (void *)data_buffer, ENTRY_HEADER_SIZE);
     if (success)
     {
         memcpy(&mLocalID, data_buffer, sizeof(U32));
@@ -221,30 +222,24 @@ LLVOCacheEntry::LLVOCacheEntry(LLAPRFile* apr_file)
         // Corruption in the cache entries
         if ((size > MAX_ENTRY_BODY_SIZE) || (size < 1))
         {
-            // We've got a bogus size, skip reading it.
-            // We won't bother seeking, because the rest of this file
-            // is likely bogus, and will be tossed anyway.
+            // We've got a bogus size, the rest of this file is likely bogus
+            // too, and will be tossed anyway.
             LL_WARNS() << "Bogus cache entry, size " << size << ", aborting!" << LL_ENDL;
             success = FALSE;
         }
-    }
-    if(success && size > 0)
-    {
-        mBuffer = new U8[size];
-        success = check_read(apr_file, mBuffer, size);
-
-        if(success)
-        {
-            mDP.assignBuffer(mBuffer, size);
-        }
-        else
+        else if (size > buffer_size - ENTRY_HEADER_SIZE)
         {
             // Improve logging around vocache
             LL_WARNS() << "Error loading cache entry for " << mLocalID << ", size " << size << " aborting!" << LL_ENDL;
-            delete[] mBuffer ;
-            mBuffer = NULL ;
+            success = FALSE;
         }
     }
+    if(success)
+    {
+        mBuffer = new U8[size];
+        memcpy(mBuffer, data_buffer + ENTRY_HEADER_SIZE, size);
+        mDP.assignBuffer(mBuffer, size);
+    }
 
     if(!success)
     {
@@ -1136,6 +1131,226 @@ const U32 INVALID_TIME = 0 ;
 const char* object_cache_dirname = "objectcache";
 const char* header_filename = "object.cache";
 
+// Region object files start with this header, followed by mDataSize bytes
+// of entries as stored by LLVOCacheEntry::writeToBuffer().  Files are
+// written whole to a temporary file then renamed, so one that is shorter
+// than its header says is corrupt.
+struct ObjectCacheFileHeader
+{
+    U8  mRegionID[UUID_BYTES];
+    S32 mNumEntries;
+    U32 mDataSize;
+};
+
+// Parses the image of a region object file into cache_entry_map, up to the
+// first corrupt entry.  Safe to call from any thread.
+static bool parse_object_cache(const U8* data, size_t size, const LLUUID& id,
+                               LLVOCacheEntry::vocache_entry_map_t& cache_entry_map, S32& num_entries)
+{
+    ObjectCacheFileHeader header;
+    if (size < sizeof(header))
+    {
+        return false;
+    }
+    memcpy(&header, data, sizeof(header));
+    num_entries = header.mNumEntries;
+
+    if (memcmp(header.mRegionID, id.mData, UUID_BYTES) != 0)
+    {
+        LL_INFOS() << "Cache ID doesn't match for this region, discarding"<< LL_ENDL;
+        return false;
+    }
+    if (header.mDataSize > size - sizeof(header))
+    {
+        LL_WARNS() << "Truncated object cache file, " << size << " bytes" << LL_ENDL;
+        return false;
+    }
+
+    const U8* cur = data + sizeof(header);
+    const U8* end = cur + header.mDataSize;
+    for (S32 i = 0; i < num_entries && cur < end; i++)
+    {
+        LLPointer<LLVOCacheEntry> entry = new LLVOCacheEntry(cur, (S32)(end - cur));
+        if (!entry->getLocalID())
+        {
+            return false;
+        }
+        cur += ENTRY_HEADER_SIZE + entry->getDP()->getBufferSize();
+        cache_entry_map[entry->getLocalID()] = entry;
+    }
+    return true;
+}
+
+//-------------------------------------------------------------------
+//LLVOCache::Writer
+//-------------------------------------------------------------------
+// Writes region object files and their header entries for LLVOCache on
+// the "General" thread pool.  All the writes queued by the time a job
+// runs go out together, and a queued file stays readable through
+// getPending() until it is on disk.
+class LLVOCache::Writer : public std::enable_shared_from_this<LLVOCache::Writer>
+{
+public:
+    typedef std::shared_ptr<const std::vector<U8> > data_ptr_t;
+
+    Writer(const std::string& header_filename) :
+        mHeaderFileName(header_filename),
+        mSerial(0),
+        mFlushPosted(false)
+    {
+    }
+
+    // Queues the header entry and, unless data is null, the region file
+    void queue(const HeaderEntryInfo& entry, const std::string& filename, const data_ptr_t& data)
+    {
+        {
+            LLMutexLock lock(&mQueueMutex);
+            PendingWrite& pending = mPending[entry.mHandle];
+            pending.mEntry = entry;
+            pending.mSerial = ++mSerial;
+            if (data)
+            {
+                pending.mFileName = filename;
+                pending.mData = data;
+            }
+            if (mFlushPosted)
+            {
+                return;
+            }
+            mFlushPosted = true;
+        }
+
+        LL::WorkQueue::ptr_t general_queue = LL::WorkQueue::getInstance("General");
+        std::shared_ptr<Writer> self = shared_from_this();
+        if (!general_queue || !general_queue->post([self]() { self->flush(); }))
+        {
+            // no worker (tests, shutdown), write it now
+            flush();
+        }
+    }
+
+    // Newest data queued for handle, null if none
+    data_ptr_t getPending(U64 handle)
+    {
+        LLMutexLock lock(&mQueueMutex);
+        pending_map_t::iterator iter = mPending.find(handle);
+        return iter != mPending.end() ? iter->second.mData : data_ptr_t();
+    }
+
+    // Drops what is queued for handle, or everything, and waits for the
+    // write in progress if any.  The caller then owns the files.
+    void cancel(U64 handle)
+    {
+        {
+            LLMutexLock lock(&mQueueMutex);
+            mPending.erase(handle);
+        }
+        LLMutexLock file_lock(&mFileMutex);
+    }
+
+    void cancelAll()
+    {
+        {
+            LLMutexLock lock(&mQueueMutex);
+            mPending.clear();
+        }
+        LLMutexLock file_lock(&mFileMutex);
+    }
+
+    // Held while writing, for the main thread to write the header file
+    LLMutex* getFileMutex() { return &mFileMutex; }
+
+    // Writes everything queued on the calling thread
+    void flush()
+    {
+        LL_PROFILE_ZONE_SCOPED;
+        LLMutexLock file_lock(&mFileMutex);
+
+        pending_map_t batch;
+        {
+            LLMutexLock lock(&mQueueMutex);
+            batch = mPending;
+            mFlushPosted = false;
+        }
+        if (batch.empty())
+        {
+            return;
+        }
+
+        LLFILE* header_file = LLFile::fopen(mHeaderFileName, "r+b");
+        for (pending_map_t::value_type& item : batch)
+        {
+            PendingWrite& pending = item.second;
+            if (pending.mData && !writeFile(pending.mFileName, *pending.mData))
+            {
+                // a stale file would do, a corrupt one just costs a rewrite
+                LL_WARNS() << "Failed to write cache to disk " << pending.mFileName << LL_ENDL;
+                LLFile::remove(pending.mFileName, ENOENT);
+            }
+            if (!header_file
+                || fseek(header_file, (long)(pending.mEntry.mIndex * sizeof(HeaderEntryInfo) + sizeof(HeaderMetaInfo)), SEEK_SET) != 0
+                || fwrite(&pending.mEntry, sizeof(HeaderEntryInfo), 1, header_file) != 1)
+            {
+                LL_WARNS() << "Failed to update cache header index " << pending.mEntry.mIndex << " handle = " << item.first << LL_ENDL;
+            }
+        }
+        if (header_file)
+        {
+            LLFile::close(header_file);
+        }
+
+        LLMutexLock lock(&mQueueMutex);
+        for (pending_map_t::value_type& item : batch)
+        {
+            // unless queued again meanwhile
+            pending_map_t::iterator iter = mPending.find(item.first);
+            if (iter != mPending.end() && iter->second.mSerial == item.second.mSerial)
+            {
+                mPending.erase(iter);
+            }
+        }
+    }
+
+private:
+    struct PendingWrite
+    {
+        HeaderEntryInfo mEntry;
+        std::string mFileName;
+        data_ptr_t mData;
+        U32 mSerial;
+    };
+    typedef std::map<U64, PendingWrite> pending_map_t;
+
+    static bool writeFile(const std::string& filename, const std::vector<U8>& data)
+    {
+        std::string tmp_filename = filename + ".tmp";
+        LLFILE* file = LLFile::fopen(tmp_filename, "wb");
+        if (!file)
+        {
+            return false;
+        }
+        bool success = fwrite(data.data(), 1, data.size(), file) == data.size();
+        success = LLFile::close(file) == 0 && success;
+        if (success)
+        {
+            LLFile::remove(filename, ENOENT);
+            success = LLFile::rename(tmp_filename, filename) == 0;
+        }
+        if (!success)
+        {
+            LLFile::remove(tmp_filename, ENOENT);
+        }
+        return success;
+    }
+
+    const std::string mHeaderFileName;
+    LLMutex mQueueMutex;
+    LLMutex mFileMutex;
+    pending_map_t mPending;
+    U32 mSerial;
+    bool mFlushPosted;
+};
+
 
 LLVOCache::LLVOCache(bool read_only) :
     mInitialized(false),
@@ -1188,6 +1403,7 @@ void LLVOCache::initCache(ELLPath location, U32 size, U32 cache_version)
     }
     mCacheSize = llclamp(size, MIN_ENTRIES_TO_PURGE, MAX_NUM_OBJECT_ENTRIES);
     mMetaInfo.mVersion = cache_version;
+    mWriter = std::make_shared<Writer>(mHeaderFileName);
 
 #if defined(ADDRESS_SIZE)
     U32 expected_address = ADDRESS_SIZE;
@@ -1257,6 +1473,11 @@ void LLVOCache::removeCache()
         return ;
     }
 
+    if (mWriter)
+    {
+        mWriter->cancelAll();
+    }
+
     std::string mask = "*";
     LL_INFOS() << "Removing object cache at " << mObjectCacheDirName << LL_ENDL;
     gDirUtilp->deleteFilesInDir(mObjectCacheDirName, mask);
@@ -1354,6 +1575,11 @@ void LLVOCache::removeFromCache(HeaderEntryInfo* entry)
         return ;
     }
 
+    if (mWriter)
+    {
+        mWriter->cancel(entry->mHandle);
+    }
+
     std::string filename;
     getObjectCacheFilename(entry->mHandle, filename);
     LL_WARNS("GLTF", "VOCache") << "Removing object cache for handle " << entry->mHandle << "Filename: " << filename << LL_ENDL;
@@ -1466,6 +1692,9 @@ void LLVOCache::writeCacheHeader()
         return;
     }
 
+    // the indices change, anything queued with the old ones goes out first
+    flushWrites();
+
     bool success = true ;
     {
         LLAPRFile apr_file(mHeaderFileName, APR_FOPEN_CREATE|APR_FOPEN_WRITE|APR_FOPEN_BINARY|APR_FOPEN_TRUNCATE, mLocalAPRFilePoolp);
@@ -1506,20 +1735,23 @@ void LLVOCache::writeCacheHeader()
 
 BOOL LLVOCache::updateEntry(const HeaderEntryInfo* entry)
 {
+    LLMutexLock lock(mWriter ? mWriter->getFileMutex() : NULL);
     LLAPRFile apr_file(mHeaderFileName, APR_WRITE|APR_BINARY, mLocalAPRFilePoolp);
     apr_file.seek(APR_SET, entry->mIndex * sizeof(HeaderEntryInfo) + sizeof(HeaderMetaInfo)) ;
 
     return check_write(&apr_file, (void*)entry, sizeof(HeaderEntryInfo)) ;
 }
 
-// we now return bool to trigger dirty cache
+// The callback gets false to trigger dirty cache,
 // this in turn forces a rewrite after a partial read due to corruption.
-bool LLVOCache::readFromCache(U64 handle, const LLUUID& id, LLVOCacheEntry::vocache_entry_map_t& cache_entry_map)
+void LLVOCache::readFromCache(U64 handle, const LLUUID& id, read_callback_t callback)
 {
+    LLVOCacheEntry::vocache_entry_map_t cache_entry_map;
     if(!mEnabled)
     {
         LL_WARNS() << "Not reading cache for handle " << handle << "): Cache is currently disabled." << LL_ENDL;
-        return true; // no problem we're just read only
+        callback(cache_entry_map, true); // no problem we're just read only
+        return;
     }
     llassert_always(mInitialized);
 
@@ -1527,59 +1759,65 @@ bool LLVOCache::readFromCache(U64 handle, const LLUUID& id, LLVOCacheEntry::voca
     if(iter == mHandleEntryMap.end()) //no cache
     {
         LL_WARNS() << "No handle map entry for " << handle << LL_ENDL;
-        return false; // arguably no a problem, but we'll mark this as dirty anyway.
+        callback(cache_entry_map, false); // arguably no a problem, but we'll mark this as dirty anyway.
+        return;
     }
 
-    bool success = true ;
-    S32 num_entries = 0 ; // lifted out of inner loop.
-    std::string filename; // lifted out of loop
+    struct ReadResult
     {
-        LLUUID cache_id;
-        getObjectCacheFilename(handle, filename);
-        LLAPRFile apr_file(filename, APR_READ|APR_BINARY, mLocalAPRFilePoolp);
+        LLVOCacheEntry::vocache_entry_map_t mEntries;
+        S32 mNumEntries = 0;
+        bool mSuccess = false;
+    };
 
-        success = check_read(&apr_file, cache_id.mData, UUID_BYTES);
+    std::string filename;
+    getObjectCacheFilename(handle, filename);
+    // a write still queued is newer than the file
+    Writer::data_ptr_t pending = mWriter->getPending(handle);
 
-        if(success)
+    auto read = [filename, id, pending]()
+    {
+        LL_PROFILE_ZONE_NAMED("vocache read");
+        ReadResult result;
+        if (pending)
         {
-            if(cache_id != id)
-            {
-                LL_INFOS() << "Cache ID doesn't match for this region, discarding"<< LL_ENDL;
-                success = false ;
-            }
-
-            if(success)
+            result.mSuccess = parse_object_cache(pending->data(), pending->size(), id, result.mEntries, result.mNumEntries);
+        }
+        else
+        {
+            llstat stat_data;
+            LLMappedFile file;
+            if (LLFile::stat(filename, &stat_data) == 0 && stat_data.st_size > 0
+                && file.open(filename, (size_t)stat_data.st_size, false))
             {
-                success = check_read(&apr_file, &num_entries, sizeof(S32)) ;
-
-                if(success)
-                {
-                    for (S32 i = 0; i < num_entries && apr_file.eof() != APR_EOF; i++)
-                    {
-                        LLPointer<LLVOCacheEntry> entry = new LLVOCacheEntry(&apr_file);
-                        if (!entry->getLocalID())
-                        {
-                            LL_WARNS() << "Aborting cache file load for " << filename << ", cache file corruption!" << LL_ENDL;
-                            success = false ;
-                            break ;
-                        }
-                        cache_entry_map[entry->getLocalID()] = entry;
-                    }
-                }
+                result.mSuccess = parse_object_cache(file.getData(), file.getSize(), id, result.mEntries, result.mNumEntries);
             }
         }
-    }
+        if (!result.mSuccess && !result.mEntries.empty())
+        {
+            LL_WARNS() << "Aborting cache file load for " << filename << ", cache file corruption!" << LL_ENDL;
+        }
+        return result;
+    };
 
-    if(!success)
+    auto done = [handle, filename, callback](ReadResult result)
     {
-        if(cache_entry_map.empty())
+        if(!result.mSuccess && result.mEntries.empty() && LLVOCache::instanceExists())
         {
-            removeEntry(iter->second) ;
+            LLVOCache::instance().removeEntry(handle);
         }
-    }
 
-    LL_DEBUGS("GLTF", "VOCache") << "Read " << cache_entry_map.size() << " entries from object cache " << filename << ", expected " << num_entries << ", success=" << (success?"True":"False") << LL_ENDL;
-    return success;
+        LL_DEBUGS("GLTF", "VOCache") << "Read " << result.mEntries.size() << " entries from object cache " << filename << ", expected " << result.mNumEntries << ", success=" << (result.mSuccess?"True":"False") << LL_ENDL;
+        callback(result.mEntries, result.mSuccess);
+    };
+
+    LL::WorkQueue::ptr_t main_queue = LL::WorkQueue::getInstance("mainloop");
+    LL::WorkQueue::ptr_t general_queue = LL::WorkQueue::getInstance("General");
+    // postTo() moves from its arguments even when it fails, hand it copies
+    if (!main_queue || !general_queue || !main_queue->postTo(general_queue, decltype(read)(read), decltype(done)(done)))
+    {
+        done(read());
+    }
 }
 
 // We now pass in the cache entry map, so that we can remove entries from extras that are no longer in the primary cache.
@@ -1773,91 +2011,68 @@ void LLVOCache::writeToCache(U64 handle, const LLUUID& id, const LLVOCacheEntry:
         mHeaderEntryQueue.insert(entry) ;
     }
 
-    //update cache header
-    if(!updateEntry(entry))
-    {
-        LL_WARNS() << "Failed to update cache header index " << entry->mIndex << ". " << filename << " handle = " << handle << LL_ENDL;
-        return ; //update failed.
-    }
-
     if(!dirty_cache)
     {
+        // only the access time changed
         LL_WARNS() << "Skipping write to cache for " << filename << " (handle:" << handle << "): cache not dirty" << LL_ENDL;
+        mWriter->queue(*entry, filename, Writer::data_ptr_t());
         return ; //nothing changed, no need to update.
     }
 
-    //write to cache file
-    bool success = true ;
+    // Serialize here, the entries belong to the main thread, the writer
+    // does the file work.
+    S32 data_size = 0;
+    S32 num_entries = 0;
+    for (LLVOCacheEntry::vocache_entry_map_t::const_iterator iter = cache_entry_map.begin(); iter != cache_entry_map.end(); ++iter)
     {
-        std::string filename;
-        getObjectCacheFilename(handle, filename);
-        LLAPRFile apr_file(filename, APR_FOPEN_CREATE|APR_FOPEN_WRITE|APR_FOPEN_BINARY|APR_FOPEN_TRUNCATE, mLocalAPRFilePoolp);
+        if (!removal_enabled || iter->second->isValid())
+        {
+            LLDataPackerBinaryBuffer* dp = iter->second->getDP();
+            data_size += ENTRY_HEADER_SIZE + (dp ? dp->getBufferSize() : 0);
+            num_entries++;
+        }
+    }
 
-        success = check_write(&apr_file, (void*)id.mData, UUID_BYTES);
+    std::shared_ptr<std::vector<U8> > data = std::make_shared<std::vector<U8> >(sizeof(ObjectCacheFileHeader) + data_size);
+    ObjectCacheFileHeader header;
+    memcpy(header.mRegionID, id.mData, UUID_BYTES);
+    header.mNumEntries = num_entries;
+    header.mDataSize = data_size;
+    memcpy(data->data(), &header, sizeof(header));
 
-        if(success)
+    bool success = true ;
+    U8* data_buffer = data->data() + sizeof(header);
+    for (LLVOCacheEntry::vocache_entry_map_t::const_iterator iter = cache_entry_map.begin(); iter != cache_entry_map.end(); ++iter)
+    {
+        if (!removal_enabled || iter->second->isValid())
         {
-            S32 num_entries = cache_entry_map.size(); // if removal is enabled num_entries might be wrong
-            success = check_write(&apr_file, &num_entries, sizeof(S32));
-            if (success)
+            S32 size = iter->second->writeToBuffer(data_buffer);
+            if (size <= ENTRY_HEADER_SIZE) // body is minimum of 1
             {
-                const S32 buffer_size = 32768; //should be large enough for couple MAX_ENTRY_BODY_SIZE
-                U8 data_buffer[buffer_size]; // generaly entries are fairly small, so collect them and drop onto disk in one go
-                S32 size_in_buffer = 0;
-
-                // This can have a lot of entries, so might be better to dump them into buffer first and write in one go.
-                for (LLVOCacheEntry::vocache_entry_map_t::const_iterator iter = cache_entry_map.begin(); success && iter != cache_entry_map.end(); ++iter)
-                {
-                    if (!removal_enabled || iter->second->isValid())
-                    {
-                        S32 size = iter->second->writeToBuffer(data_buffer + size_in_buffer);
-
-                        if (size > ENTRY_HEADER_SIZE) // body is minimum of 1
-                        {
-                            size_in_buffer += size;
-                        }
-                        else
-                        {
-                            LL_WARNS() << "Failed to write cache entry to buffer for " << filename << ", entry number " << iter->second->getLocalID() << LL_ENDL;
-                            success = false;
-                            break;
-                        }
-
-                        // Make sure we have space in buffer for next element
-                        if (buffer_size - size_in_buffer < MAX_ENTRY_BODY_SIZE + ENTRY_HEADER_SIZE)
-                        {
-                            success = check_write(&apr_file, (void*)data_buffer, size_in_buffer);
-                            size_in_buffer = 0;
-                            if (!success)
-                            {
-                                LL_WARNS() << "Failed to write cache to disk " << filename << LL_ENDL;
-                                break;
-                            }
-                        }
-                    }
-                }
-
-                if (success && size_in_buffer > 0)
-                {
-                    // final write
-                    success = check_write(&apr_file, (void*)data_buffer, size_in_buffer);
-                    if(!success)
-                    {
-                        LL_WARNS() << "Failed to write cache entry to disk " << filename << LL_ENDL;
-                    }
-                    size_in_buffer = 0;
-                }
-                LL_DEBUGS("VOCache") << "Wrote " << num_entries << " entries to the primary VOCache file " << filename << ". success = " << (success ? "True":"False") << LL_ENDL;
+                LL_WARNS() << "Failed to write cache entry to buffer for " << filename << ", entry number " << iter->second->getLocalID() << LL_ENDL;
+                success = false;
+                break;
             }
+            data_buffer += size;
         }
     }
 
     if(!success)
     {
         removeEntry(entry) ;
+        return ;
     }
 
-    return ;
+    mWriter->queue(*entry, filename, data);
+    LL_DEBUGS("VOCache") << "Queued " << num_entries << " entries for the primary VOCache file " << filename << LL_ENDL;
+}
+
+void LLVOCache::flushWrites()
+{
+    if (mWriter)
+    {
+        mWriter->flush();
+    }
 }
 
 void LLVOCache::removeGenericExtrasForHandle(U64 handle)
@@ -34,6 +34,8 @@
 #include "llapr.h"
 #include "llgltfmaterial.h"
 
+#include <functional>
+#include <memory>
 #include <unordered_map>
 
 //---------------------------------------------------------------------------
@@ -102,7 +104,9 @@ class LLVOCacheEntry final
     ~LLVOCacheEntry();
 public:
     LLVOCacheEntry(U32 local_id, U32 crc, LLDataPackerBinaryBuffer &dp);
-    LLVOCacheEntry(LLAPRFile* apr_file);
+    // Reads an entry stored by writeToBuffer(), getLocalID() is 0 if the
+    // data is corrupt.
+    LLVOCacheEntry(const U8* data_buffer, S32 buffer_size);
     LLVOCacheEntry();
 
     void updateEntry(U32 crc, LLDataPackerBinaryBuffer &dp);
@@ -246,7 +250,9 @@ class LLVOCachePartition final : public LLViewerOctreePartition
 };
 
 //
-//Note: LLVOCache is not thread-safe
+//Note: LLVOCache is not thread-safe, it is only used from the main thread.
+//Region object files are parsed on the "General" thread pool and written
+//by a background writer.
 //
 class LLVOCache final : public LLParamSingleton<LLVOCache>
 {
@@ -285,15 +291,29 @@ class LLVOCache final : public LLParamSingleton<LLVOCache>
     typedef std::set<HeaderEntryInfo*, header_entry_less> header_entry_queue_t;
     typedef std::map<U64, HeaderEntryInfo*> handle_entry_map_t;
 
+    class Writer;
+
 public:
+    // Called on the main thread with the entries read and false if the
+    // file was missing or corrupt, so that it gets rewritten.
+    typedef std::function<void(LLVOCacheEntry::vocache_entry_map_t& cache_entry_map, bool success)> read_callback_t;
+
     // We need this init to be separate from constructor, since we might construct cache, purge it, then init.
     void initCache(ELLPath location, U32 size, U32 cache_version);
     void removeCache(ELLPath location, bool started = false) ;
 
-    bool readFromCache(U64 handle, const LLUUID& id, LLVOCacheEntry::vocache_entry_map_t& cache_entry_map) ;
+    // Reads the region's object file on a worker thread and hands the entries
+    // to callback.  The callback may run before this returns when there is
+    // nothing to read or no worker.
+    void readFromCache(U64 handle, const LLUUID& id, read_callback_t callback);
     void readGenericExtrasFromCache(U64 handle, const LLUUID& id, LLVOCacheEntry::vocache_gltf_overrides_map_t& cache_extras_entry_map, const LLVOCacheEntry::vocache_entry_map_t& cache_entry_map);
 
+    // Serializes the entries and queues them for the background writer.
+    // Writes queued for the same region before the writer gets to them are
+    // collapsed into the last one.
     void writeToCache(U64 handle, const LLUUID& id, const LLVOCacheEntry::vocache_entry_map_t& cache_entry_map, BOOL dirty_cache, bool removal_enabled);
+    // Writes everything queued before returning
+    void flushWrites();
     void writeGenericExtrasToCache(U64 handle, const LLUUID& id, const LLVOCacheEntry::vocache_gltf_overrides_map_t& cache_extras_entry_map, BOOL dirty_cache, bool removal_enabled);
     void removeEntry(U64 handle) ;
     void removeGenericExtrasForHandle(U64 handle);
@@ -327,6 +347,8 @@ class LLVOCache final : public LLParamSingleton<LLVOCache>
     LLVolatileAPRPool*   mLocalAPRFilePoolp ;
     header_entry_queue_t mHeaderEntryQueue;
     handle_entry_map_t   mHandleEntryMap;
+    // shared with the write jobs, which may outlive the cache at shutdown
+    std::shared_ptr<Writer> mWriter;
 };
 
 #endif
@@ -39,6 +39,7 @@
 #include "llfloatertools.h"
 #include "llmaterialid.h"
 #include "llmaterialtable.h"
+#include "llparallelfor.h"
 #include "llprimitive.h"
 #include "llvolume.h"
 #include "llvolumeoctree.h"
@@ -4990,11 +4991,13 @@ void LLRiggedVolume::update(
     LLMatrix4a mat[kMaxJoints];
     U32 maxJoints = LLSkinningUtil::getMeshJointCount(skin);
     LLSkinningUtil::initSkinningMatrixPalette(mat, maxJoints, skin, avatar);
-    const LLMatrix4a bind_shape_matrix = skin->mBindShapeMatrix;
+    LLSkinningUtil::bindSkinningMatrixPalette(mat, maxJoints, skin->mBindShapeMatrix);
 
     S32 rigged_vert_count = 0;
     S32 rigged_face_count = 0;
     LLVector4a box_min, box_max;
+    box_min.clear();
+    box_max.clear();
     S32 face_begin;
     S32 face_end;
     if (face_index == DO_NOT_UPDATE_FACES)
@@ -5012,72 +5015,83 @@ void LLRiggedVolume::update(
         face_begin = face_index;
         face_end = face_begin + 1;
     }
+
+    std::vector<S32> skinned_faces;
     for (S32 i = face_begin; i < face_end; ++i)
     {
         const LLVolumeFace& vol_face = volume->getVolumeFace(i);
-
         LLVolumeFace& dst_face = mVolumeFaces[i];
 
-        LLVector4a* weight = vol_face.mWeights;
-
-        if ( weight )
+        if (vol_face.mWeights)
         {
-            LLSkinningUtil::checkSkinWeights(weight, dst_face.mNumVertices, skin);
+            LLSkinningUtil::checkSkinWeights(vol_face.mWeights, dst_face.mNumVertices, skin);
 
-            LLVector4a* pos = dst_face.mPositions;
-
-            if (pos && dst_face.mExtents)
+            if (dst_face.mPositions && dst_face.mExtents && dst_face.mNumVertices > 0)
             {
+                skinned_faces.push_back(i);
                 rigged_vert_count += dst_face.mNumVertices;
                 rigged_face_count++;
+            }
+        }
+    }
 
-                {
-                    for (U32 j = 0; j < dst_face.mNumVertices; ++j)
-                    {
-                        LLMatrix4a final_mat;
-                        LLSkinningUtil::getPerVertexSkinMatrixUnchecked(weight[j], mat, final_mat);
-
-                        LLVector4a& v = vol_face.mPositions[j];
-                        LLVector4a t;
-                        LLVector4a dst;
-                        bind_shape_matrix.affineTransform(v, t);
-                        final_mat.affineTransform(t, dst);
-                        pos[j] = dst;
-                    }
-                }
-
-                //update bounding box
-                // VFExtents change
-                LLVector4a& min = dst_face.mExtents[0];
-                LLVector4a& max = dst_face.mExtents[1];
+    auto skin_faces = [&](size_t begin, size_t end)
+    {
+        for (size_t f = begin; f < end; ++f)
+        {
+            S32 i = skinned_faces[f];
+            const LLVolumeFace& vol_face = volume->getVolumeFace(i);
+            LLVolumeFace& dst_face = mVolumeFaces[i];
 
-                min = pos[0];
-                max = pos[1];
-                if (i==0)
-                {
-                    box_min = min;
-                    box_max = max;
-                }
+            //update bounding box
+            // VFExtents change
+            LLSkinningUtil::skinPositions(mat, maxJoints, vol_face.mWeights, vol_face.mPositions,
+                                          dst_face.mPositions, dst_face.mNumVertices,
+                                          dst_face.mExtents[0], dst_face.mExtents[1]);
 
-                for (U32 j = 1; j < dst_face.mNumVertices; ++j)
-                {
-                    min.setMin(min, pos[j]);
-                    max.setMax(max, pos[j]);
-                }
+            dst_face.mCenter->setAdd(dst_face.mExtents[0], dst_face.mExtents[1]);
+            dst_face.mCenter->mul(0.5f);
+        }
+    };
 
-                box_min.setMin(min,box_min);
-                box_max.setMax(max,box_max);
+    // Faces are independent, spread them over the General pool when there
+    // is enough to skin to pay for the hand off
+    const S32 MIN_PARALLEL_VERTICES = 16384;
+    if (skinned_faces.size() > 1 && rigged_vert_count >= MIN_PARALLEL_VERTICES)
+    {
+        LL::parallel_for(skinned_faces.size(), 1, skin_faces);
+    }
+    else
+    {
+        skin_faces(0, skinned_faces.size());
+    }
 
-                dst_face.mCenter->setAdd(dst_face.mExtents[0], dst_face.mExtents[1]);
-                dst_face.mCenter->mul(0.5f);
+    for (size_t f = 0; f < skinned_faces.size(); ++f)
+    {
+        const LLVolumeFace& dst_face = mVolumeFaces[skinned_faces[f]];
+        if (f == 0)
+        {
+            box_min = dst_face.mExtents[0];
+            box_max = dst_face.mExtents[1];
+        }
+        box_min.setMin(dst_face.mExtents[0], box_min);
+        box_max.setMax(dst_face.mExtents[1], box_max);
+    }
 
-            }
+    for (S32 i = face_begin; i < face_end; ++i)
+    {
+        if (!volume->getVolumeFace(i).mWeights)
+        {
+            continue;
+        }
 
-            if (rebuild_face_octrees)
-            {
-                dst_face.destroyOctree();
-                dst_face.createOctree();
-            }
+        // A moved face invalidates its octree.  Picking rebuilds it on
+        // demand in lineSegmentIntersect(), so only build it here when asked.
+        LLVolumeFace& dst_face = mVolumeFaces[i];
+        dst_face.destroyOctree();
+        if (rebuild_face_octrees)
+        {
+            dst_face.createOctree();
         }
     }
     mExtraDebugText = llformat("rigged %d/%d - box (%f %f %f) (%f %f %f)",
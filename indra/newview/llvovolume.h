@@ -73,7 +73,7 @@ class LLRiggedVolume final : public LLVolume
         LLVOAvatar* avatar,
         const LLVolume* src_volume,
         FaceIndex face_index = UPDATE_ALL_FACES,
-        bool rebuild_face_octrees = true);
+        bool rebuild_face_octrees = false);
 
     std::string mExtraDebugText;
 };
@@ -407,11 +407,12 @@ class LLVOVolume final : public LLViewerObject
 
 
     // Rigged volume update (for raycasting)
-    // By default, this updates the bounding boxes of all the faces and builds an octree for precise per-triangle raycasting
+    // By default, this updates the bounding boxes of all the faces. Their octrees for precise per-triangle
+    // raycasting get rebuilt on the next raycast that needs them, unless rebuild_face_octrees asks for it now.
     void updateRiggedVolume(
         bool force_treat_as_rigged,
         LLRiggedVolume::FaceIndex face_index = LLRiggedVolume::UPDATE_ALL_FACES,
-        bool rebuild_face_octrees = true);
+        bool rebuild_face_octrees = false);
     LLRiggedVolume* getRiggedVolume();
 
     //returns true if volume should be treated as a rigged volume
@@ -81,8 +81,6 @@ void LLWind::decompress(LLBitPack &bitpack, LLGroupHeader *group_headerp)
     LLPatchHeader  patch_header;
     S32 buffer[ARRAY_SIZE];
 
-    init_patch_decompressor(group_headerp->patch_size);
-
     // Don't use the packed group_header stride because the strides used on
     // simulator and viewer are not equal.
     group_headerp->stride = group_headerp->patch_size;
@@ -126,6 +126,7 @@
 #include "SMAA/AreaTex.h"
 #include "SMAA/SearchTex.h"
 #include "llimagepng.h"
+#include "llparallelfor.h"
 
 extern BOOL gSnapshot;
 bool gShiftFrame = false;
@@ -2454,6 +2455,9 @@ void LLPipeline::updateCull(LLCamera& camera, LLCullResult& result)
 
     sCull->clear();
 
+    bool parallel = canCullInParallel();
+    mCullPartitions.clear();
+
     for (LLWorld::region_list_t::const_iterator iter = LLWorld::getInstance()->getRegionList().begin();
             iter != LLWorld::getInstance()->getRegionList().end(); ++iter)
     {
@@ -2466,12 +2470,21 @@ void LLPipeline::updateCull(LLCamera& camera, LLCullResult& result)
             {
                 if (hasRenderType(part->mDrawableType))
                 {
-                    part->cull(camera);
+                    if (parallel)
+                    {
+                        part->rebound();
+                        mCullPartitions.push_back(part);
+                    }
+                    else
+                    {
+                        part->cull(camera);
+                    }
                 }
             }
         }
 
-        //scan the VO Cache tree
+        //scan the VO Cache tree, always on this thread as it localizes the camera
+        //and reads back occlusion queries
         LLVOCachePartition* vo_part = region->getVOCachePartition();
         if(vo_part)
         {
@@ -2479,6 +2492,11 @@ void LLPipeline::updateCull(LLCamera& camera, LLCullResult& result)
         }
     }
 
+    if (!mCullPartitions.empty())
+    {
+        cullPartitions(camera);
+    }
+
     if (hasRenderType(LLPipeline::RENDER_TYPE_SKY) &&
         gSky.mVOSkyp.notNull() &&
         gSky.mVOSkyp->mDrawable.notNull())
@@ -2499,6 +2517,71 @@ void LLPipeline::updateCull(LLCamera& camera, LLCullResult& result)
     }
 }
 
+//static
+bool LLPipeline::canCullInParallel()
+{
+    static LLCachedControl<bool> parallel_cull(gSavedSettings, "RenderParallelCull", true);
+
+    // reading back occlusion queries in LLOcclusionCullingGroup::checkOcclusion needs the GL context,
+    // reflection renders skip them
+    return parallel_cull && (sUseOcclusion < 2 || sReflectionRender);
+}
+
+void LLPipeline::cullPartitions(LLCamera& camera)
+{
+    LL_PROFILE_ZONE_SCOPED_CATEGORY_PIPELINE;
+
+    while (mPartitionCull.size() < mCullPartitions.size())
+    {
+        mPartitionCull.emplace_back(new LLCullResult());
+    }
+
+    // each partition culls into its own result, no two workers touch the same octree
+    LL::parallel_for(mCullPartitions.size(), 1, [this, &camera](size_t begin, size_t end)
+        {
+            for (size_t i = begin; i < end; ++i)
+            {
+                mPartitionCull[i]->clear();
+                mCullPartitions[i]->cull(camera, *mPartitionCull[i]);
+            }
+        });
+
+    // merge in partition order so the result matches culling them one by one, then do
+    // what markNotCulled leaves to this thread
+    bool update_distance = LLViewerCamera::sCurCameraID == LLViewerCamera::CAMERA_WORLD && !gCubeSnapshot;
+    for (size_t i = 0; i < mCullPartitions.size(); ++i)
+    {
+        LLCullResult& part_result = *mPartitionCull[i];
+
+        for (LLCullResult::sg_iterator iter = part_result.beginDrawableGroups(); iter != part_result.endDrawableGroups(); ++iter)
+        {
+            sCull->pushDrawableGroup(*iter);
+        }
+        for (LLCullResult::sg_iterator iter = part_result.beginVisibleGroups(); iter != part_result.endVisibleGroups(); ++iter)
+        {
+            sCull->pushVisibleGroup(*iter);
+        }
+        for (LLCullResult::sg_iterator iter = part_result.beginOcclusionGroups(); iter != part_result.endOcclusionGroups(); ++iter)
+        {
+            sCull->pushOcclusionGroup(*iter);
+        }
+
+        if (update_distance)
+        {
+            for (LLCullResult::sg_iterator iter = part_result.beginDrawableGroups(); iter != part_result.endDrawableGroups(); ++iter)
+            {
+                (*iter)->updateDistance(camera);
+            }
+            for (LLCullResult::sg_iterator iter = part_result.beginVisibleGroups(); iter != part_result.endVisibleGroups(); ++iter)
+            {
+                (*iter)->updateDistance(camera);
+            }
+        }
+
+        mNumVisibleNodes += part_result.getDrawableGroupsSize() + part_result.getVisibleGroupsSize();
+    }
+}
+
 void LLPipeline::markNotCulled(LLSpatialGroup* group, LLCamera& camera)
 {
     if (group->isEmpty())
@@ -2506,22 +2589,33 @@ void LLPipeline::markNotCulled(LLSpatialGroup* group, LLCamera& camera)
         return;
     }
 
-    group->setVisible();
-
     if (LLViewerCamera::sCurCameraID == LLViewerCamera::CAMERA_WORLD && !gCubeSnapshot)
     {
         group->updateDistance(camera);
     }
 
+    markNotCulled(group, camera, *sCull);
+    mNumVisibleNodes++;
+}
+
+void LLPipeline::markNotCulled(LLSpatialGroup* group, LLCamera& camera, LLCullResult& result)
+{
+    if (group->isEmpty())
+    {
+        return;
+    }
+
+    group->setVisible();
+
     assertInitialized();
 
     if (!group->getSpatialPartition()->mRenderByGroup)
     { //render by drawable
-        sCull->pushDrawableGroup(group);
+        result.pushDrawableGroup(group);
     }
     else
     {   //render by group
-        sCull->pushVisibleGroup(group);
+        result.pushVisibleGroup(group);
     }
 
     if (group->needsUpdate() ||
@@ -2529,12 +2623,16 @@ void LLPipeline::markNotCulled(LLSpatialGroup* group, LLCamera& camera)
     {
         // include this group in occlusion groups, not because it is an occluder, but because we want to run
         // an occlusion query to find out if it's an occluder
-        markOccluder(group);
+        markOccluder(group, result);
     }
-    mNumVisibleNodes++;
 }
 
 void LLPipeline::markOccluder(LLSpatialGroup* group)
+{
+    markOccluder(group, *sCull);
+}
+
+void LLPipeline::markOccluder(LLSpatialGroup* group, LLCullResult& result)
 {
     if (sUseOcclusion > 1 && group && !group->isOcclusionState(LLSpatialGroup::ACTIVE_OCCLUSION))
     {
@@ -2542,7 +2640,7 @@ void LLPipeline::markOccluder(LLSpatialGroup* group)
 
         if (!parent || !parent->isOcclusionState(LLSpatialGroup::OCCLUDED))
         { //only mark top most occluders as active occlusion
-            sCull->pushOcclusionGroup(group);
+            result.pushOcclusionGroup(group);
             group->setOcclusionState(LLSpatialGroup::ACTIVE_OCCLUSION);
 
             if (parent &&
@@ -2550,7 +2648,7 @@ void LLPipeline::markOccluder(LLSpatialGroup* group)
                 parent->getElementCount() == 0 &&
                 parent->needsUpdate())
             {
-                sCull->pushOcclusionGroup(group);
+                result.pushOcclusionGroup(group);
                 parent->setOcclusionState(LLSpatialGroup::ACTIVE_OCCLUSION);
             }
         }
@@ -170,9 +170,13 @@ class LLPipeline
     // Object related methods
     void        markVisible(LLDrawable *drawablep, LLCamera& camera);
     void        markOccluder(LLSpatialGroup* group);
+    void        markOccluder(LLSpatialGroup* group, LLCullResult& result);
 
     void        doOcclusion(LLCamera& camera);
     void        markNotCulled(LLSpatialGroup* group, LLCamera &camera);
+    // Worker side of markNotCulled, pushes into result and leaves distance updates and stats to updateCull
+    void        markNotCulled(LLSpatialGroup* group, LLCamera &camera, LLCullResult& result);
+    void        cullPartitions(LLCamera& camera); // culls mCullPartitions on the General pool into sCull
     void        markMoved(LLDrawable *drawablep, bool damped_motion = false);
     void        markShift(LLDrawable *drawablep);
     void        markTextured(LLDrawable *drawablep);
@@ -370,6 +374,9 @@ class LLPipeline
 
     static bool isWaterClip();
 
+    // true if culling touches no GL state and can traverse partitions on worker threads
+    static bool canCullInParallel();
+
     void setRenderTypeMask(U32 type, ...);
     // This is equivalent to 'setRenderTypeMask'
     //void orRenderTypeMask(U32 type, ...);
@@ -837,6 +844,9 @@ class LLPipeline
 
     LLDrawable::drawable_vector_t   mPartitionQ; //drawables that need to update their spatial partition radius
 
+    std::vector<LLSpatialPartition*> mCullPartitions; //partitions culled by updateCull in parallel
+    std::vector<std::unique_ptr<LLCullResult> > mPartitionCull; //their results, merged in mCullPartitions order
+
     bool mGroupQ1Locked;
 
     bool mResetVertexBuffers; //if true, clear vertex buffers on next update
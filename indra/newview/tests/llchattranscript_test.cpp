@@ -0,0 +1,237 @@
+/**
+ * @file llchattranscript_test.cpp
+ * @brief Tests for LLChatTranscript
+ *
+ * $LicenseInfo:firstyear=2024&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2024, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#include "linden_common.h"
+
+#include "../llchattranscript.h"
+#include "lldir.h"
+#include "llfile.h"
+#include "llformat.h"
+#include "llrand.h"
+
+#include "../test/lltut.h"
+
+namespace
+{
+    void append(const std::string& name, const std::string& text)
+    {
+        LLFILE* fp = LLFile::fopen(name, "ab");
+        fwrite(text.data(), 1, text.size(), fp);
+        fclose(fp);
+    }
+
+    std::string message_text(const LLChatTranscript& transcript, S32 index)
+    {
+        U32 length = 0;
+        const char* data = transcript.getMessageData(index, length);
+        return std::string(data, length);
+    }
+}
+
+namespace tut
+{
+    struct chattranscript_data
+    {
+        chattranscript_data()
+        {
+            mLogName = gDirUtilp->add(gDirUtilp->getTempDir(), llformat("llchattranscript_test_%d.txt", ll_rand(1 << 30)));
+            cleanup();
+        }
+
+        ~chattranscript_data()
+        {
+            cleanup();
+        }
+
+        void cleanup()
+        {
+            LLFile::remove(mLogName, ENOENT);
+            LLChatTranscript::removeIndex(mLogName);
+        }
+
+        std::string mLogName;
+    };
+
+    typedef test_group<chattranscript_data> chattranscript_test;
+    typedef chattranscript_test::object chattranscript_object;
+    tut::chattranscript_test tct("LLChatTranscript");
+
+    template<> template<>
+    void chattranscript_object::test<1>()
+    {
+        set_test_name("messages, continuation lines and timestamps");
+
+        append(mLogName,
+               "\xEF\xBB\xBF[2024/03/01 12:30]  Ann Resident: hello\n"
+               "[2024/03/01 12:31]  Bob Resident: two\n"
+               " lines\n"
+               "\n"
+               "[12:32]  Second Life: short stamp\r\n"
+               "no stamp at all\n");
+
+        LLChatTranscript transcript;
+        ensure("open", transcript.open(mLogName));
+        ensure_equals("count", transcript.getMessageCount(), 4);
+        ensure_equals("bom skipped", message_text(transcript, 0), "[2024/03/01 12:30]  Ann Resident: hello");
+        ensure_equals("continuation", message_text(transcript, 1), "[2024/03/01 12:31]  Bob Resident: two\n lines\n");
+        ensure_equals("crlf", message_text(transcript, 2), "[12:32]  Second Life: short stamp");
+        ensure_equals("last", message_text(transcript, 3), "no stamp at all");
+
+        // 2024/03/01 is 19783 days after 1970/01/01
+        ensure_equals("dated", transcript.getMessage(0).mTime, 19783U * 86400 + 12 * 3600 + 30 * 60);
+        ensure_equals("undated", transcript.getMessage(2).mTime, 0U);
+        ensure_equals("no stamp", transcript.getMessage(3).mTime, 0U);
+
+        ensure_equals("inside second", transcript.findMessage(transcript.getMessage(1).mOffset + 40), 1);
+        ensure_equals("after second", transcript.findMessageAfter(transcript.getMessage(1).mOffset), 2);
+    }
+
+    template<> template<>
+    void chattranscript_object::test<2>()
+    {
+        set_test_name("index follows appends and notices rewrites");
+
+        // appending needs an index to extend
+        append(mLogName, "[2024/03/01 12:30]  Ann Resident: one\n");
+        ensure("nothing to append to", !LLChatTranscript::appendIndex(mLogName, 0));
+
+        LLChatTranscript transcript;
+        ensure("build", transcript.open(mLogName));
+        U32 size = transcript.getSize();
+        transcript.close();
+
+        append(mLogName, "[2024/03/01 12:31]  Ann Resident: partial");
+        ensure("first append", LLChatTranscript::appendIndex(mLogName, size));
+        ensure("stale size", !LLChatTranscript::appendIndex(mLogName, size));
+
+        // the last line was indexed before it was finished
+        ensure("reopen to append", transcript.open(mLogName));
+        size = transcript.getSize();
+        transcript.close();
+        append(mLogName, " line\n continued\n[2024/03/01 12:32]  Ann Resident: three\n");
+        ensure("second append", LLChatTranscript::appendIndex(mLogName, size));
+
+        ensure("open", transcript.open(mLogName));
+        ensure_equals("count", transcript.getMessageCount(), 3);
+        ensure_equals("finished line", message_text(transcript, 1), "[2024/03/01 12:31]  Ann Resident: partial line\n continued");
+
+        std::vector<LLChatTranscript::Message> appended;
+        for (S32 i = 0; i < transcript.getMessageCount(); ++i)
+        {
+            appended.push_back(transcript.getMessage(i));
+        }
+        transcript.close();
+
+        LLChatTranscript::removeIndex(mLogName);
+        ensure("rebuild", transcript.open(mLogName));
+        ensure_equals("rebuilt count", transcript.getMessageCount(), (S32)appended.size());
+        for (S32 i = 0; i < transcript.getMessageCount(); ++i)
+        {
+            ensure_equals("offset", transcript.getMessage(i).mOffset, appended[i].mOffset);
+            ensure_equals("time", transcript.getMessage(i).mTime, appended[i].mTime);
+        }
+        transcript.close();
+
+        // a different transcript under the same name must not reuse the index
+        LLFile::remove(mLogName);
+        append(mLogName, "Something else entirely\n");
+        ensure("reopen", transcript.open(mLogName));
+        ensure_equals("replaced count", transcript.getMessageCount(), 1);
+        ensure_equals("replaced text", message_text(transcript, 0), "Something else entirely");
+    }
+
+    template<> template<>
+    void chattranscript_object::test<3>()
+    {
+        set_test_name("index notices a rewritten tail");
+
+        const std::string head = "[2024/03/01 12:30]  Ann Resident: " + std::string(300, 'a') + "\n";
+        append(mLogName, head + "[2024/03/01 12:31]  Ann Resident: one\n");
+        LLChatTranscript transcript;
+        ensure("build", transcript.open(mLogName));
+        ensure_equals("count", transcript.getMessageCount(), 2);
+        transcript.close();
+
+        // same head and same length, different messages after it
+        LLFile::remove(mLogName);
+        append(mLogName, head + "[2024/03/01 12:31]  Ann\n[12:32]  Bob:\n");
+        ensure("reopen", transcript.open(mLogName));
+        ensure_equals("rebuilt count", transcript.getMessageCount(), 3);
+        ensure_equals("rebuilt text", message_text(transcript, 2), "[12:32]  Bob:");
+    }
+
+    template<> template<>
+    void chattranscript_object::test<4>()
+    {
+        set_test_name("paging and search");
+
+        append(mLogName,
+               "[2024/03/01 12:30]  Ann Resident: hello there\n"
+               "[2024/03/01 12:31]  Bob Resident: Hello, hello\n"
+               " and HELLO again\n"
+               "[2024/03/01 12:32]  Ann Resident: bye\n"
+               "[2024/03/01 12:33]  Bob Resident: hello\n");
+
+        LLChatTranscript transcript;
+        ensure("open", transcript.open(mLogName));
+
+        S32 last = -1;
+        ensure_equals("last page", transcript.getPageStart(last, 3), 1);
+        ensure_equals("last page end", last, 4);
+        last = 1;
+        ensure_equals("first page", transcript.getPageStart(last, 3), 0);
+        ensure_equals("first page end", last, 1);
+        last = 10;
+        ensure_equals("clamped", transcript.getPageStart(last, 2), 2);
+        ensure_equals("clamped end", last, 4);
+
+        std::vector<LLChatTranscript::SearchHit> hits;
+        ensure_equals("folded", transcript.search("HELLO", hits), 3);
+        ensure_equals("first hit", hits[0].mMessage, 0);
+        ensure_equals("one per message", hits[1].mMessage, 1);
+        ensure_equals("last hit", hits[2].mMessage, 3);
+        ensure_equals("hit offset", hits[1].mOffset, transcript.getMessage(1).mOffset + 34);
+
+        hits.clear();
+        ensure_equals("match case", transcript.search("HELLO", hits, true), 1);
+        ensure_equals("continuation hit", hits[0].mMessage, 1);
+
+        hits.clear();
+        ensure_equals("max hits", transcript.search("hello", hits, false, 2), 2);
+        hits.clear();
+        ensure_equals("missing", transcript.search("nobody", hits), 0);
+        transcript.close();
+
+        std::vector<std::string> log_names;
+        log_names.push_back(mLogName + ".missing");
+        log_names.push_back(mLogName);
+        log_names.push_back(mLogName);
+        LLChatTranscript::log_hits_t log_hits;
+        ensure_equals("per log", LLChatTranscript::search(log_names, "hello", log_hits, false, 3, 2), 3);
+        ensure_equals("log name", log_hits[0].first, mLogName);
+        ensure_equals("second log", log_hits[2].second.mMessage, 0);
+    }
+}
@@ -0,0 +1,170 @@
+/**
+ * @file llskinningkernels_test.cpp
+ * @brief Compares the skinning kernels with the per vertex path they replaced
+ *
+ * $LicenseInfo:firstyear=2024&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2024, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#include "linden_common.h"
+
+#include "../llskinningutil.h"
+#include "llalignedarray.h"
+#include "llrand.h"
+
+#include "../test/lltut.h"
+
+namespace
+{
+    const S32 JOINT_COUNT = 60;
+    const F32 TOLERANCE = 1e-4f;
+
+    F32 random_range(F32 low, F32 high)
+    {
+        return low + ll_frand(high - low);
+    }
+
+    // Something like a joint matrix times an inverse bind matrix: a bit of
+    // rotation and scale, and a translation
+    LLMatrix4a random_matrix()
+    {
+        LLMatrix4a mat;
+        for (S32 row = 0; row < 3; ++row)
+        {
+            mat.mMatrix[row].set(random_range(-1.f, 1.f), random_range(-1.f, 1.f), random_range(-1.f, 1.f), 0.f);
+        }
+        mat.mMatrix[3].set(random_range(-2.f, 2.f), random_range(-2.f, 2.f), random_range(-2.f, 2.f), 1.f);
+        return mat;
+    }
+
+    // Joint index in the integer part, weight in the fraction, as unpacked
+    // from a mesh
+    LLVector4a random_weights()
+    {
+        F32 w[4];
+        for (S32 k = 0; k < 4; ++k)
+        {
+            w[k] = (F32)ll_rand(JOINT_COUNT) + random_range(0.05f, 0.95f);
+        }
+        return LLVector4a(w[0], w[1], w[2], w[3]);
+    }
+
+    bool close_enough(const LLVector4a& a, const LLVector4a& b)
+    {
+        for (S32 k = 0; k < 3; ++k)
+        {
+            if (fabsf(a[k] - b[k]) > TOLERANCE * (1.f + fabsf(a[k])))
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    // Skins num_vertices random vertices both ways and compares the results
+    void compare_paths(U32 num_vertices)
+    {
+        LLMatrix4a palette[JOINT_COUNT];
+        for (S32 j = 0; j < JOINT_COUNT; ++j)
+        {
+            palette[j] = random_matrix();
+        }
+        const LLMatrix4a bind_shape_matrix = random_matrix();
+
+        LLAlignedArray<LLVector4a, 64> weights;
+        LLAlignedArray<LLVector4a, 64> src;
+        weights.resize(num_vertices);
+        src.resize(num_vertices);
+        for (U32 i = 0; i < num_vertices; ++i)
+        {
+            weights[i] = random_weights();
+            src[i].set(random_range(-0.5f, 0.5f), random_range(-0.5f, 0.5f), random_range(-0.5f, 0.5f), 1.f);
+        }
+
+        // The path LLRiggedVolume::update() used to take: a blended matrix
+        // per vertex, after the bind shape matrix
+        LLAlignedArray<LLVector4a, 64> expected;
+        expected.resize(num_vertices);
+        for (U32 i = 0; i < num_vertices; ++i)
+        {
+            LLMatrix4a final_mat;
+            LLSkinningUtil::getPerVertexSkinMatrixUnchecked(weights[i], palette, final_mat);
+            LLVector4a t;
+            bind_shape_matrix.affineTransform(src[i], t);
+            final_mat.affineTransform(t, expected[i]);
+        }
+
+        LLMatrix4a bound[JOINT_COUNT];
+        for (S32 j = 0; j < JOINT_COUNT; ++j)
+        {
+            bound[j] = palette[j];
+        }
+        LLSkinningUtil::bindSkinningMatrixPalette(bound, JOINT_COUNT, bind_shape_matrix);
+
+        LLAlignedArray<LLVector4a, 64> skinned;
+        skinned.resize(num_vertices);
+        LLVector4a min, max;
+        LLSkinningUtil::skinPositions(bound, JOINT_COUNT, weights.mArray, src.mArray, skinned.mArray, num_vertices, min, max);
+
+        LLVector4a box_min = skinned[0];
+        LLVector4a box_max = skinned[0];
+        for (U32 i = 0; i < num_vertices; ++i)
+        {
+            tut::ensure(llformat("vertex %u of %u", i, num_vertices), close_enough(expected[i], skinned[i]));
+            box_min.setMin(box_min, skinned[i]);
+            box_max.setMax(box_max, skinned[i]);
+        }
+        for (S32 k = 0; k < 3; ++k)
+        {
+            tut::ensure_equals(llformat("min %d of %u", k, num_vertices), min[k], box_min[k]);
+            tut::ensure_equals(llformat("max %d of %u", k, num_vertices), max[k], box_max[k]);
+        }
+    }
+}
+
+namespace tut
+{
+    struct skinningkernels_data
+    {
+    };
+    typedef test_group<skinningkernels_data> skinningkernels_test;
+    typedef skinningkernels_test::object skinningkernels_object;
+    tut::skinningkernels_test tsk("LLSkinningKernels");
+
+    template<> template<>
+    void skinningkernels_object::test<1>()
+    {
+        set_test_name("skinPositions matches the per vertex skin matrix path");
+
+        compare_paths(20000);
+    }
+
+    template<> template<>
+    void skinningkernels_object::test<2>()
+    {
+        set_test_name("odd and tiny vertex counts");
+
+        // the AVX2 path does vertices in pairs, make sure the tail is right
+        compare_paths(1);
+        compare_paths(3);
+        compare_paths(1001);
+    }
+}
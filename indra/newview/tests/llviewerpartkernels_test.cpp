@@ -0,0 +1,159 @@
+/**
+ * @file llviewerpartkernels_test.cpp
+ * @brief Tests for the particle integration kernels
+ *
+ * $LicenseInfo:firstyear=2024&license=viewerlgpl$
+ * Second Life Viewer Source Code
+ * Copyright (C) 2024, Linden Research, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation;
+ * version 2.1 of the License only.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * Linden Research, Inc., 945 Battery Street, San Francisco, CA  94111  USA
+ * $/LicenseInfo$
+ */
+
+#include "linden_common.h"
+
+#include "../llviewerpartkernels.h"
+#include "llalignedarray.h"
+#include "llformat.h"
+#include "llrand.h"
+
+#include "../test/lltut.h"
+
+using namespace LLViewerPartKernels;
+
+namespace
+{
+    const F32 TOLERANCE = 1e-4f;
+
+    F32 random_range(F32 low, F32 high)
+    {
+        return low + ll_frand(high - low);
+    }
+
+    LLVector3 random_vector(F32 range)
+    {
+        return LLVector3(random_range(-range, range), random_range(-range, range), random_range(-range, range));
+    }
+
+    struct Particle
+    {
+        LLVector3 mPos;
+        LLVector3 mVel;
+        LLVector3 mAcc;
+        F32 mAge;
+        F32 mDt;
+    };
+
+    // Runs count random particles through both kernels for a few frames
+    // and checks that they stay together
+    void check_integration(U32 count)
+    {
+        std::vector<Particle> parts(count);
+        for (Particle& part : parts)
+        {
+            part.mPos = random_vector(256.f);
+            part.mVel = random_vector(10.f);
+            part.mAcc = random_vector(5.f);
+            part.mAge = random_range(0.f, 2.f);
+            // particles of one group may have skipped different amounts of time
+            part.mDt = random_range(0.005f, 0.1f);
+        }
+
+        const U32 stride = (count + 3) & ~3;
+        LLAlignedArray<F32, 64> table;
+        table.resize(stride * KIN_COLUMNS);
+        F32* columns = table.mArray;
+        memset(columns, 0, sizeof(F32) * stride * KIN_COLUMNS);
+        for (U32 k = 0; k < count; ++k)
+        {
+            for (U32 axis = 0; axis < 3; ++axis)
+            {
+                columns[(KIN_POS_X + axis) * stride + k] = parts[k].mPos.mV[axis];
+                columns[(KIN_VEL_X + axis) * stride + k] = parts[k].mVel.mV[axis];
+                columns[(KIN_ACC_X + axis) * stride + k] = parts[k].mAcc.mV[axis];
+            }
+            columns[KIN_DT * stride + k] = parts[k].mDt;
+            columns[KIN_AGE * stride + k] = parts[k].mAge;
+        }
+
+        for (S32 frame = 0; frame < 10; ++frame)
+        {
+            integrateBallistic(columns, stride);
+            for (Particle& part : parts)
+            {
+                stepBallistic(part.mPos, part.mVel, part.mAcc, part.mDt);
+                part.mAge += part.mDt;
+            }
+        }
+
+        for (U32 k = 0; k < count; ++k)
+        {
+            const Particle& part = parts[k];
+            for (U32 axis = 0; axis < 3; ++axis)
+            {
+                F32 pos = columns[(KIN_POS_X + axis) * stride + k];
+                F32 vel = columns[(KIN_VEL_X + axis) * stride + k];
+                tut::ensure(llformat("position %u.%u of %u: %f vs %f", k, axis, count, pos, part.mPos.mV[axis]),
+                            fabsf(pos - part.mPos.mV[axis]) <= TOLERANCE * llmax(1.f, fabsf(part.mPos.mV[axis])));
+                tut::ensure(llformat("velocity %u.%u of %u: %f vs %f", k, axis, count, vel, part.mVel.mV[axis]),
+                            fabsf(vel - part.mVel.mV[axis]) <= TOLERANCE * llmax(1.f, fabsf(part.mVel.mV[axis])));
+                tut::ensure_equals(llformat("acceleration %u.%u of %u", k, axis, count),
+                                   columns[(KIN_ACC_X + axis) * stride + k], part.mAcc.mV[axis]);
+            }
+            F32 age = columns[KIN_AGE * stride + k];
+            tut::ensure(llformat("age %u of %u: %f vs %f", k, count, age, part.mAge), fabsf(age - part.mAge) <= TOLERANCE);
+        }
+
+        // the padding past the last particle stays at rest
+        for (U32 k = count; k < stride; ++k)
+        {
+            for (U32 column = 0; column < KIN_COLUMNS; ++column)
+            {
+                tut::ensure_equals(llformat("padding %u.%u of %u", k, column, count), columns[column * stride + k], 0.f);
+            }
+        }
+    }
+}
+
+namespace tut
+{
+    struct viewerpartkernels_data
+    {
+    };
+    typedef test_group<viewerpartkernels_data> viewerpartkernels_test;
+    typedef viewerpartkernels_test::object viewerpartkernels_object;
+    tut::viewerpartkernels_test tvpk("LLViewerPartKernels");
+
+    template<> template<>
+    void viewerpartkernels_object::test<1>()
+    {
+        set_test_name("SSE integration matches the per particle step");
+
+        check_integration(64);
+    }
+
+    template<> template<>
+    void viewerpartkernels_object::test<2>()
+    {
+        set_test_name("counts that leave a partial vector");
+
+        for (U32 count : { 1U, 2U, 3U, 5U, 7U, 13U, 1021U })
+        {
+            check_integration(count);
+        }
+    }
+}
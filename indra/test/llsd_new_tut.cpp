@@ -30,6 +30,7 @@
 #include "linden_common.h"
 #include "lltut.h"
 
+#include "llformat.h"
 #include "llsdtraits.h"
 #include "llstring.h"
 
@@ -811,6 +812,68 @@ namespace tut
         ensure("type is a string", v.isString());
     }
 
+    template<> template<>
+    void SDTestObject::test<15>()
+        // document arena
+    {
+        SDCleanupCheck check;
+
+        {
+            SDAllocationCheck check("arena nodes share one block", 1);
+            llsd::DocumentArena arena;
+            LLSD m;
+            for (S32 i = 0; i < 100; ++i)
+            {
+                m["values"].append(i);
+                m["names"].append(llformat("name %d", i));
+            }
+            ensure_equals("arena map size", m["values"].size(), 100);
+            ensure_equals("arena value", m["names"][42].asString(), std::string("name 42"));
+        }
+
+        {
+            SDAllocationCheck check("blocks are not freed while in use", 1);
+            U32 outstanding = llsd::outstandingCount();
+            LLSD survivor;
+            {
+                llsd::DocumentArena arena;
+                LLSD m;
+                m["kept"] = "outlives the arena";
+                m["dropped"] = 1.5;
+                survivor = m["kept"];
+            }
+            ensure_equals("outstanding arena block", llsd::outstandingCount(), outstanding + 1);
+            ensure_equals("survivor value", survivor.asString(), std::string("outlives the arena"));
+        }
+
+        {
+            // one block, one heap map for the copy-on-write, one heap
+            // integer for the new entry
+            SDAllocationCheck check("copy on write leaves the arena", 3);
+            LLSD doc;
+            {
+                llsd::DocumentArena arena;
+                doc["a"] = 1;
+                doc["b"] = 2;
+            }
+            LLSD copy = doc;
+            copy["c"] = 3;
+            ensure("original untouched", !doc.has("c"));
+            ensure_equals("shared entry", copy["a"].asInteger(), 1);
+        }
+
+        {
+            SDAllocationCheck check("nested arenas", 2);
+            llsd::DocumentArena outer;
+            LLSD a = "outer";
+            {
+                llsd::DocumentArena inner;
+                LLSD b = "inner";
+            }
+            LLSD c = "outer again";
+        }
+    }
+
     /* TO DO:
         conversion of undefined to UUID, Date, URI and Binary
         conversion of undefined to map and array
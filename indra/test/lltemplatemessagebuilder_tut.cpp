@@ -973,5 +973,139 @@ namespace tut
         ensure_equals("Ensure unchanged buffer ", strlen(outBuffer), 0);
         delete reader;
     }
+
+    template<> template<>
+    void LLTemplateMessageBuilderTestObject::test<46>()
+        // repeated blocks with mixed variables, read out of order and forwarded
+    {
+        LLMessageTemplate messageTemplate = defaultTemplate();
+        messageTemplate.addBlock(defaultBlock(MVT_U32, 4, MBT_SINGLE));
+        LLMessageBlock* block = new LLMessageBlock(const_cast<char*>(_PREHASH_Test1), MBT_VARIABLE);
+        block->addVariable(const_cast<char*>(_PREHASH_Test0), MVT_U32, 4);
+        block->addVariable(const_cast<char*>(_PREHASH_Test1), MVT_VARIABLE, 1);
+        block->addVariable(const_cast<char*>(_PREHASH_Test2), MVT_LLVector3, 12);
+        messageTemplate.addBlock(block);
+
+        const S32 count = 3;
+        LLTemplateMessageBuilder* builder = defaultBuilder(messageTemplate);
+        builder->addU32(_PREHASH_Test0, 0xdeadbeef);
+        for (S32 i = 0; i < count; ++i)
+        {
+            builder->nextBlock(_PREHASH_Test1);
+            builder->addU32(_PREHASH_Test0, i * 1000);
+            builder->addString(_PREHASH_Test1, std::string(i * 5, 'a' + i));
+            builder->addVector3(_PREHASH_Test2, LLVector3((F32)i, 2.f * i, 3.f * i));
+        }
+        LLTemplateMessageReader* reader = setReader(messageTemplate, builder);
+
+        for (S32 pass = 0; pass < 2; ++pass)
+        {
+            U32 single;
+            reader->getU32(_PREHASH_Test0, _PREHASH_Test0, single);
+            ensure_equals("Ensure single block", single, 0xdeadbeef);
+            ensure_equals("Ensure block count", reader->getNumberOfBlocks(_PREHASH_Test1), count);
+            ensure_equals("Ensure missing block size",
+                          reader->getSize(_PREHASH_Test2, _PREHASH_Test0), LL_BLOCK_NOT_IN_MESSAGE);
+            ensure_equals("Ensure missing variable size",
+                          reader->getSize(_PREHASH_Test0, _PREHASH_Test1), LL_VARIABLE_NOT_IN_BLOCK);
+
+            for (S32 i = count - 1; i >= 0; --i)
+            {
+                LLVector3 vec;
+                U32 value;
+                std::string str;
+                reader->getVector3(_PREHASH_Test1, _PREHASH_Test2, vec, i);
+                reader->getU32(_PREHASH_Test1, _PREHASH_Test0, value, i);
+                reader->getString(_PREHASH_Test1, _PREHASH_Test1, str, i);
+                ensure_equals("Ensure vector", vec, LLVector3((F32)i, 2.f * i, 3.f * i));
+                ensure_equals("Ensure U32", value, (U32)(i * 1000));
+                ensure_equals("Ensure string", str, std::string(i * 5, 'a' + i));
+            }
+
+            if (!pass)
+            {
+                // forward it and check the copy reads the same
+                builder = new LLTemplateMessageBuilder(nameMap);
+                builder->newMessage(_PREHASH_TestMessage);
+                reader->copyToBuilder(*builder);
+                delete reader;
+                reader = setReader(messageTemplate, builder);
+            }
+        }
+        delete reader;
+    }
+
+    template<> template<>
+    void LLTemplateMessageBuilderTestObject::test<47>()
+        // decode throughput
+    {
+        if (LLStringUtil::getenv("LL_BENCHMARK").empty())
+        {
+            skip("set LL_BENCHMARK to run");
+        }
+
+        // Roughly the shape of an ObjectUpdate: a header block and a run of
+        // object blocks with ids, vectors and a variable length field.
+        LLMessageTemplate messageTemplate = defaultTemplate();
+        messageTemplate.addBlock(defaultBlock(MVT_U64, 8, MBT_SINGLE));
+        LLMessageBlock* block = new LLMessageBlock(const_cast<char*>(_PREHASH_Test1), MBT_VARIABLE);
+        block->addVariable(const_cast<char*>(_PREHASH_Test0), MVT_LLUUID, 16);
+        block->addVariable(const_cast<char*>(_PREHASH_Test1), MVT_VARIABLE, 2);
+        block->addVariable(const_cast<char*>(_PREHASH_Test2), MVT_LLVector3, 12);
+        messageTemplate.addBlock(block);
+
+        // record a set of packets, then replay them through one reader
+        std::vector<std::vector<U8> > packets;
+        for (S32 p = 0; p < 64; ++p)
+        {
+            LLTemplateMessageBuilder* builder = defaultBuilder(messageTemplate);
+            builder->addU64(_PREHASH_Test0, p + 1);
+            for (S32 i = 0, count = 1 + p % 10; i < count; ++i)
+            {
+                builder->nextBlock(_PREHASH_Test1);
+                builder->addUUID(_PREHASH_Test0, LLUUID::generateNewID());
+                std::vector<U8> data(20 + (p * 7 + i) % 40, (U8)i);
+                builder->addBinaryData(_PREHASH_Test1, &data[0], (S32)data.size());
+                builder->addVector3(_PREHASH_Test2, LLVector3((F32)p, (F32)i, 1.f));
+            }
+            std::vector<U8> packet(MAX_BUFFER_SIZE);
+            memset(&packet[0], 0, LL_PACKET_ID_SIZE);
+            packet.resize(builder->buildMessage(&packet[0], MAX_BUFFER_SIZE, 0));
+            delete builder;
+            packets.push_back(packet);
+        }
+
+        numberMap[1] = &messageTemplate;
+        LLTemplateMessageReader reader(numberMap);
+        const S32 ITERATIONS = 20000;
+        U8 data[64];
+        U64 sum = 0;
+        LLTimer timer;
+        for (S32 n = 0; n < ITERATIONS; ++n)
+        {
+            const std::vector<U8>& packet = packets[n % packets.size()];
+            reader.clearMessage();
+            reader.validateMessage(&packet[0], (S32)packet.size(), LLHost(), false, true);
+            reader.decodeData(&packet[0], LLHost(), true);
+            U64 header;
+            reader.getU64(_PREHASH_Test0, _PREHASH_Test0, header);
+            sum += header;
+            for (S32 i = 0, count = reader.getNumberOfBlocks(_PREHASH_Test1); i < count; ++i)
+            {
+                LLUUID id;
+                LLVector3 pos;
+                reader.getUUID(_PREHASH_Test1, _PREHASH_Test0, id, i);
+                S32 size = reader.getSize(_PREHASH_Test1, i, _PREHASH_Test1);
+                reader.getBinaryData(_PREHASH_Test1, _PREHASH_Test1, data, size, i, sizeof(data));
+                reader.getVector3(_PREHASH_Test1, _PREHASH_Test2, pos, i);
+                sum += size + (U64)pos.mV[VY];
+            }
+        }
+        F64 secs = timer.getElapsedTimeF64();
+
+        ensure("Ensure decoded", sum > 0);
+        LL_INFOS() << "template message decode: " << ITERATIONS / llmax(secs, 1e-6)
+                   << " msgs/s" << LL_ENDL;
+    }
 }
 